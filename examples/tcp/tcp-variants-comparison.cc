@@ -50,6 +50,7 @@
 #include "ns3/flow-monitor-helper.h"
 #include "ns3/ipv4-global-routing-helper.h"
 #include "ns3/traffic-control-module.h"
+#include "ns3/tcp-fluid-fast-forward.h"
 
 using namespace ns3;
 
@@ -204,6 +205,35 @@ TraceNextRx (std::string &next_rx_seq_file_name)
   Config::ConnectWithoutContext ("/NodeList/2/$ns3::TcpL4Protocol/SocketList/1/RxBuffer/NextRxSequence", MakeCallback (&NextRxTracer));
 }
 
+static void
+AddFluidFlow (Ptr<TcpFluidFastForward> fastForward, Ptr<Application> app, uint32_t bottleneck)
+{
+  Ptr<Socket> socket = DynamicCast<BulkSendApplication> (app)->GetSocket ();
+  fastForward->AddFlow (DynamicCast<TcpSocketBase> (socket), bottleneck);
+}
+
+static void
+StopOnFastForward (Time stopTime)
+{
+  NS_UNUSED (stopTime);
+  // The fluid model computed the rest of the flows: the other statistics,
+  // e.g., those of the flow monitor, end here
+  Simulator::Stop ();
+}
+
+static void
+SwapCongestionControl (Ptr<Application> app, TypeId congestionTypeId)
+{
+  Ptr<Socket> socket = DynamicCast<BulkSendApplication> (app)->GetSocket ();
+  if (socket == 0)
+    {
+      return;
+    }
+  ObjectFactory factory;
+  factory.SetTypeId (congestionTypeId);
+  DynamicCast<TcpSocketBase> (socket)->SetCongestionControlAlgorithm (factory.Create<TcpCongestionOps> ());
+}
+
 int main (int argc, char *argv[])
 {
   std::string transport_prot = "TcpWestwood";
@@ -222,6 +252,9 @@ int main (int argc, char *argv[])
   bool flow_monitor = false;
   bool pcap = false;
   bool sack = true;
+  bool fluid_fast_forward = false;
+  std::string swap_prot = "";
+  double swap_time = 0.0;
   std::string queue_disc_type = "ns3::PfifoFastQueueDisc";
 
 
@@ -246,6 +279,9 @@ int main (int argc, char *argv[])
   cmd.AddValue ("pcap_tracing", "Enable or disable PCAP tracing", pcap);
   cmd.AddValue ("queue_disc_type", "Queue disc type for gateway (e.g. ns3::CoDelQueueDisc)", queue_disc_type);
   cmd.AddValue ("sack", "Enable or disable SACK option", sack);
+  cmd.AddValue ("fluid_fast_forward", "Finish the simulation with a fluid model once the flows are stable", fluid_fast_forward);
+  cmd.AddValue ("swap_prot", "Congestion control the running flows swap to, e.g. TcpCubic", swap_prot);
+  cmd.AddValue ("swap_time", "Time of the congestion control swap in seconds", swap_time);
   cmd.Parse (argc, argv);
 
   transport_prot = std::string ("ns3::") + transport_prot;
@@ -383,6 +419,11 @@ int main (int argc, char *argv[])
   Address sinkLocalAddress (InetSocketAddress (Ipv4Address::GetAny (), port));
   PacketSinkHelper sinkHelper ("ns3::TcpSocketFactory", sinkLocalAddress);
 
+  // Each flow crosses its own bottleneck
+  Ptr<TcpFluidFastForward> fastForward = CreateObject<TcpFluidFastForward> ();
+  fastForward->SetAttribute ("StopTime", TimeValue (Seconds (stop_time - 3)));
+  fastForward->TraceConnectWithoutContext ("FastForward", MakeCallback (&StopOnFastForward));
+
   for (uint16_t i = 0; i < sources.GetN (); i++)
     {
       AddressValue remoteAddress (InetSocketAddress (sink_interfaces.GetAddress (i, 0), port));
@@ -395,6 +436,24 @@ int main (int argc, char *argv[])
       ApplicationContainer sourceApp = ftp.Install (sources.Get (i));
       sourceApp.Start (Seconds (start_time * i));
       sourceApp.Stop (Seconds (stop_time - 3));
+      if (fluid_fast_forward)
+        {
+          uint32_t bottleneck = fastForward->AddBottleneck (std::min (access_b, bottle_b), size, error_p);
+          Simulator::Schedule (Seconds (start_time * i) + NanoSeconds (1), &AddFluidFlow,
+                               fastForward, sourceApp.Get (0), bottleneck);
+          fastForward->AddChangeTime (Seconds (start_time * i));
+        }
+      if (!swap_prot.empty ())
+        {
+          TypeId swapTid;
+          NS_ABORT_MSG_UNLESS (TypeId::LookupByNameFailSafe ("ns3::" + swap_prot, &swapTid),
+                               "TypeId ns3::" << swap_prot << " not found");
+          Simulator::Schedule (Seconds (swap_time), &SwapCongestionControl, sourceApp.Get (0), swapTid);
+          if (fluid_fast_forward)
+            {
+              fastForward->AddChangeTime (Seconds (swap_time));
+            }
+        }
 
       sinkHelper.SetAttribute ("Protocol", TypeIdValue (TcpSocketFactory::GetTypeId ()));
       ApplicationContainer sinkApp = sinkHelper.Install (sinks.Get (i));
@@ -434,9 +493,19 @@ int main (int argc, char *argv[])
       flowHelper.InstallAll ();
     }
 
+  if (fluid_fast_forward)
+    {
+      fastForward->Start ();
+    }
+
   Simulator::Stop (Seconds (stop_time));
   Simulator::Run ();
 
+  if (fluid_fast_forward)
+    {
+      fastForward->Print (std::cout);
+    }
+
   if (flow_monitor)
     {
       flowHelper.SerializeToXmlFile (prefix_file_name + ".flowmonitor", true, true);
@@ -295,6 +295,10 @@ int main (int argc, char *argv[])
   }
   if (pcap) {
     NS_LOG_INFO ("Enabling pcap files.");
+    // Batch pcap records in memory and write them from a background thread.
+    Config::SetDefault ("ns3::PcapFileWrapper::WriteBufferSize",
+                        UintegerValue (1 << 20));
+    Config::SetDefault ("ns3::PcapFileWrapper::AsyncFlush", BooleanValue (true));
     std::stringstream pcapName;
     pcapName << outDir << "/" << details;
     p2p.EnablePcapAll (pcapName.str (), true);
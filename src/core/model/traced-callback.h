@@ -21,7 +21,7 @@
 #ifndef TRACED_CALLBACK_H
 #define TRACED_CALLBACK_H
 
-#include <list>
+#include <vector>
 #include "callback.h"
 
 /**
@@ -220,10 +220,22 @@ public:
   typedef void (* Uint32Callback)(const uint32_t value);
   /**@}*/
 
-  
+  /**
+   * Check for an empty chain, for instance before computing the
+   * arguments of an invocation.
+   *
+   * \returns \c true if no Callback is connected.
+   */
+  bool IsEmpty (void) const
+  {
+    return m_callbackList.empty ();
+  }
+
 private:
   /**
-   * Container type for holding the chain of Callbacks.
+   * Container type for holding the chain of Callbacks.  The Callbacks are
+   * held contiguously, so that the chain is invoked without following
+   * list nodes, and an empty chain is checked with a single comparison.
    *
    * \tparam T1 \deduced Type of the first argument to the functor.
    * \tparam T2 \deduced Type of the second argument to the functor.
@@ -234,7 +246,7 @@ private:
    * \tparam T7 \deduced Type of the seventh argument to the functor.
    * \tparam T8 \deduced Type of the eighth argument to the functor.
    */
-  typedef std::list<Callback<void,T1,T2,T3,T4,T5,T6,T7,T8> > CallbackList;
+  typedef std::vector<Callback<void,T1,T2,T3,T4,T5,T6,T7,T8> > CallbackList;
   /** The chain of Callbacks. */
   CallbackList m_callbackList;
 };
@@ -321,10 +333,10 @@ template<typename T1, typename T2,
 void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (void) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  // Indexed, as a callback may connect another one, which is then invoked
+  for (std::size_t i = 0; i < m_callbackList.size (); i++)
     {
-      (*i)();
+      m_callbackList[i]();
     }
 }
 template<typename T1, typename T2, 
@@ -334,10 +346,10 @@ template<typename T1, typename T2,
 void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  // Indexed, as a callback may connect another one, which is then invoked
+  for (std::size_t i = 0; i < m_callbackList.size (); i++)
     {
-      (*i)(a1);
+      m_callbackList[i](a1);
     }
 }
 template<typename T1, typename T2, 
@@ -347,10 +359,10 @@ template<typename T1, typename T2,
 void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  // Indexed, as a callback may connect another one, which is then invoked
+  for (std::size_t i = 0; i < m_callbackList.size (); i++)
     {
-      (*i)(a1, a2);
+      m_callbackList[i](a1, a2);
     }
 }
 template<typename T1, typename T2, 
@@ -360,10 +372,10 @@ template<typename T1, typename T2,
 void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2, T3 a3) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  // Indexed, as a callback may connect another one, which is then invoked
+  for (std::size_t i = 0; i < m_callbackList.size (); i++)
     {
-      (*i)(a1, a2, a3);
+      m_callbackList[i](a1, a2, a3);
     }
 }
 template<typename T1, typename T2, 
@@ -373,10 +385,10 @@ template<typename T1, typename T2,
 void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2, T3 a3, T4 a4) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  // Indexed, as a callback may connect another one, which is then invoked
+  for (std::size_t i = 0; i < m_callbackList.size (); i++)
     {
-      (*i)(a1, a2, a3, a4);
+      m_callbackList[i](a1, a2, a3, a4);
     }
 }
 template<typename T1, typename T2, 
@@ -386,10 +398,10 @@ template<typename T1, typename T2,
 void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  // Indexed, as a callback may connect another one, which is then invoked
+  for (std::size_t i = 0; i < m_callbackList.size (); i++)
     {
-      (*i)(a1, a2, a3, a4, a5);
+      m_callbackList[i](a1, a2, a3, a4, a5);
     }
 }
 template<typename T1, typename T2, 
@@ -399,10 +411,10 @@ template<typename T1, typename T2,
 void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5, T6 a6) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  // Indexed, as a callback may connect another one, which is then invoked
+  for (std::size_t i = 0; i < m_callbackList.size (); i++)
     {
-      (*i)(a1, a2, a3, a4, a5, a6);
+      m_callbackList[i](a1, a2, a3, a4, a5, a6);
     }
 }
 template<typename T1, typename T2, 
@@ -412,10 +424,10 @@ template<typename T1, typename T2,
 void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5, T6 a6, T7 a7) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  // Indexed, as a callback may connect another one, which is then invoked
+  for (std::size_t i = 0; i < m_callbackList.size (); i++)
     {
-      (*i)(a1, a2, a3, a4, a5, a6, a7);
+      m_callbackList[i](a1, a2, a3, a4, a5, a6, a7);
     }
 }
 template<typename T1, typename T2, 
@@ -425,10 +437,10 @@ template<typename T1, typename T2,
 void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5, T6 a6, T7 a7, T8 a8) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  // Indexed, as a callback may connect another one, which is then invoked
+  for (std::size_t i = 0; i < m_callbackList.size (); i++)
     {
-      (*i)(a1, a2, a3, a4, a5, a6, a7, a8);
+      m_callbackList[i](a1, a2, a3, a4, a5, a6, a7, a8);
     }
 }
 
@@ -0,0 +1,127 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TRACED_VALUE_BATCHER_H
+#define TRACED_VALUE_BATCHER_H
+
+#include <utility>
+#include <vector>
+#include "callback.h"
+#include "nstime.h"
+#include "ptr.h"
+#include "simple-ref-count.h"
+#include "simulator.h"
+
+/**
+ * \file
+ * \ingroup tracing
+ * ns3::TracedValueBatcher declaration and template implementation.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup tracing
+ *
+ * \brief Deliver the changes of a TracedValue to a sink in batches
+ *
+ * The batcher is connected to a TracedValue in place of the sink.  It
+ * records the time and the new value of each change, and delivers them to
+ * the sink as a vector of samples once BatchSize of them are recorded, so
+ * that a sink writing to a file or a database does its work once per
+ * batch instead of once per change:
+ *
+ * \code
+ *   void CwndSink (const TracedValueBatcher<uint32_t>::Samples &samples);
+ *
+ *   Ptr<TracedValueBatcher<uint32_t> > batcher =
+ *     Create<TracedValueBatcher<uint32_t> > (MakeCallback (&CwndSink), 4096);
+ *   socket->TraceConnectWithoutContext ("CongestionWindow",
+ *     MakeCallback (&TracedValueBatcher<uint32_t>::Record, batcher));
+ * \endcode
+ *
+ * The samples left are delivered by Flush (), which is called when the
+ * simulator is destroyed, the batcher being kept alive until then.
+ *
+ * \tparam T \explicit The type of the underlying value being traced.
+ */
+template <typename T>
+class TracedValueBatcher : public SimpleRefCount<TracedValueBatcher<T> >
+{
+public:
+  /** A batch of samples: the times of the changes and the new values. */
+  typedef std::vector<std::pair<Time, T> > Samples;
+
+  /**
+   * Constructor.
+   * \param [in] sink The Callback receiving the batches of samples.
+   * \param [in] batchSize The number of samples per batch.
+   */
+  TracedValueBatcher (Callback<void, const Samples &> sink, uint32_t batchSize = 1024)
+    : m_sink (sink),
+      m_batchSize (batchSize > 0 ? batchSize : 1),
+      m_flushScheduled (false)
+  {
+    m_samples.reserve (m_batchSize);
+  }
+
+  /**
+   * Record a change of the value, the sink of the TracedValue.
+   * \param [in] oldValue The value before the change.
+   * \param [in] newValue The value after the change.
+   */
+  void Record (T oldValue, T newValue)
+  {
+    if (!m_flushScheduled)
+      {
+        m_flushScheduled = true;
+        Simulator::ScheduleDestroy (&TracedValueBatcher<T>::FlushAtDestroy,
+                                    Ptr<TracedValueBatcher<T> > (this));
+      }
+    m_samples.push_back (std::make_pair (Simulator::Now (), newValue));
+    if (m_samples.size () >= m_batchSize)
+      {
+        Flush ();
+      }
+  }
+
+  /** Deliver the samples recorded to the sink, if any. */
+  void Flush (void)
+  {
+    if (!m_samples.empty ())
+      {
+        m_sink (m_samples);
+        m_samples.clear ();
+      }
+  }
+
+private:
+  /** Deliver the samples left when the simulator is destroyed. */
+  void FlushAtDestroy (void)
+  {
+    m_flushScheduled = false;
+    Flush ();
+  }
+
+  Callback<void, const Samples &> m_sink;  //!< The sink of the batches
+  uint32_t m_batchSize;                    //!< The number of samples per batch
+  Samples m_samples;                       //!< The samples recorded
+  bool m_flushScheduled;                   //!< Whether Flush is scheduled at destroy
+};
+
+} // namespace ns3
+
+#endif /* TRACED_VALUE_BATCHER_H */
@@ -18,6 +18,9 @@
 
 #include "ns3/test.h"
 #include "ns3/traced-callback.h"
+#include "ns3/traced-value.h"
+#include "ns3/traced-value-batcher.h"
+#include "ns3/simulator.h"
 #include "ns3/unused.h"
 
 using namespace ns3;
@@ -67,6 +70,7 @@ BasicTracedCallbackTestCase::DoRun (void)
   // these methods do is to set corresponding member variables m_one and m_two.
   //
   TracedCallback<uint8_t, double> trace;
+  NS_TEST_ASSERT_MSG_EQ (trace.IsEmpty (), true, "New traced callback not empty");
 
   //
   // Connect both callbacks to their respective test methods.  If we hit the 
@@ -100,6 +104,7 @@ BasicTracedCallbackTestCase::DoRun (void)
   trace (1, 2);
   NS_TEST_ASSERT_MSG_EQ (m_one, false, "Callback CbOne unexpectedly called");
   NS_TEST_ASSERT_MSG_EQ (m_two, false, "Callback CbTwo unexpectedly called");
+  NS_TEST_ASSERT_MSG_EQ (trace.IsEmpty (), true, "Traced callback not empty after disconnections");
 
   //
   // If we connect them back up, then both callbacks should be called.
@@ -113,6 +118,138 @@ BasicTracedCallbackTestCase::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ (m_two, true, "Callback CbTwo not called");
 }
 
+class ChainTracedCallbackTestCase : public TestCase
+{
+public:
+  ChainTracedCallbackTestCase ();
+  virtual ~ChainTracedCallbackTestCase () {}
+
+private:
+  virtual void DoRun (void);
+
+  void Cb (uint32_t id);
+  void CbTwo (uint32_t id);
+  void CbConnecting (uint32_t id);
+
+  std::vector<uint32_t> m_calls;
+  TracedCallback<uint32_t> m_trace;
+};
+
+ChainTracedCallbackTestCase::ChainTracedCallbackTestCase ()
+  : TestCase ("Check the order of the chain of a TracedCallback, when connecting during an invocation")
+{
+}
+
+void
+ChainTracedCallbackTestCase::Cb (uint32_t id)
+{
+  m_calls.push_back (id);
+}
+
+void
+ChainTracedCallbackTestCase::CbTwo (uint32_t id)
+{
+  m_calls.push_back (10 + id);
+}
+
+void
+ChainTracedCallbackTestCase::CbConnecting (uint32_t id)
+{
+  m_calls.push_back (100 + id);
+  // Enough callbacks to move the chain
+  for (uint32_t i = 0; i < 16; i++)
+    {
+      m_trace.ConnectWithoutContext (MakeCallback (&ChainTracedCallbackTestCase::Cb, this));
+    }
+}
+
+void
+ChainTracedCallbackTestCase::DoRun (void)
+{
+  m_trace.ConnectWithoutContext (MakeCallback (&ChainTracedCallbackTestCase::Cb, this));
+  m_trace.ConnectWithoutContext (MakeCallback (&ChainTracedCallbackTestCase::CbTwo, this));
+  m_trace.ConnectWithoutContext (MakeCallback (&ChainTracedCallbackTestCase::CbConnecting, this));
+  m_trace (1);
+  // The callbacks are invoked in order, and those connected during the
+  // invocation are invoked too
+  NS_TEST_ASSERT_MSG_EQ (m_calls.size (), 19, "Wrong number of callbacks invoked");
+  NS_TEST_ASSERT_MSG_EQ (m_calls[0], 1, "Wrong first callback");
+  NS_TEST_ASSERT_MSG_EQ (m_calls[1], 11, "Wrong second callback");
+  NS_TEST_ASSERT_MSG_EQ (m_calls[2], 101, "Wrong third callback");
+  NS_TEST_ASSERT_MSG_EQ (m_calls[18], 1, "Wrong last callback");
+  m_calls.clear ();
+  m_trace.DisconnectWithoutContext (MakeCallback (&ChainTracedCallbackTestCase::Cb, this));
+  m_trace.DisconnectWithoutContext (MakeCallback (&ChainTracedCallbackTestCase::CbConnecting, this));
+  m_trace (2);
+  NS_TEST_ASSERT_MSG_EQ (m_calls.size (), 1, "Wrong number of callbacks left");
+  NS_TEST_ASSERT_MSG_EQ (m_calls[0], 12, "Wrong callback left");
+}
+
+class TracedValueBatcherTestCase : public TestCase
+{
+public:
+  TracedValueBatcherTestCase ();
+  virtual ~TracedValueBatcherTestCase () {}
+
+private:
+  virtual void DoRun (void);
+
+  void Sink (const TracedValueBatcher<uint32_t>::Samples &samples);
+  void Set (uint32_t value);
+
+  std::vector<TracedValueBatcher<uint32_t>::Samples> m_batches;
+  TracedValue<uint32_t> m_value;
+};
+
+TracedValueBatcherTestCase::TracedValueBatcherTestCase ()
+  : TestCase ("Check the batches of samples of a TracedValueBatcher")
+{
+}
+
+void
+TracedValueBatcherTestCase::Sink (const TracedValueBatcher<uint32_t>::Samples &samples)
+{
+  m_batches.push_back (samples);
+}
+
+void
+TracedValueBatcherTestCase::Set (uint32_t value)
+{
+  m_value = value;
+}
+
+void
+TracedValueBatcherTestCase::DoRun (void)
+{
+  // Without a sink, the value is only assigned
+  m_value = 5;
+  NS_TEST_ASSERT_MSG_EQ (m_value.Get (), 5, "Value not assigned");
+
+  Ptr<TracedValueBatcher<uint32_t> > batcher =
+    Create<TracedValueBatcher<uint32_t> > (MakeCallback (&TracedValueBatcherTestCase::Sink, this), 4);
+  m_value.ConnectWithoutContext (MakeCallback (&TracedValueBatcher<uint32_t>::Record, batcher));
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      Simulator::Schedule (MilliSeconds (i), &TracedValueBatcherTestCase::Set, this, 10 + i);
+      // Not a change of the value
+      Simulator::Schedule (MilliSeconds (i) + MicroSeconds (1), &TracedValueBatcherTestCase::Set, this, 10 + i);
+    }
+  batcher = 0;
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (m_batches.size (), 2, "Wrong number of batches before the simulator is destroyed");
+  Simulator::Destroy ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_batches.size (), 3, "Wrong number of batches");
+  NS_TEST_ASSERT_MSG_EQ (m_batches[0].size (), 4, "Wrong size of the first batch");
+  NS_TEST_ASSERT_MSG_EQ (m_batches[2].size (), 2, "Wrong size of the last batch");
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      const std::pair<Time, uint32_t> &sample = m_batches[i / 4][i % 4];
+      NS_TEST_ASSERT_MSG_EQ (sample.first, MilliSeconds (i), "Wrong time of sample " << i);
+      NS_TEST_ASSERT_MSG_EQ (sample.second, 10 + i, "Wrong value of sample " << i);
+    }
+}
+
 class TracedCallbackTestSuite : public TestSuite
 {
 public:
@@ -123,6 +260,8 @@ TracedCallbackTestSuite::TracedCallbackTestSuite ()
   : TestSuite ("traced-callback", UNIT)
 {
   AddTestCase (new BasicTracedCallbackTestCase, TestCase::QUICK);
+  AddTestCase (new ChainTracedCallbackTestCase, TestCase::QUICK);
+  AddTestCase (new TracedValueBatcherTestCase, TestCase::QUICK);
 }
 
 static TracedCallbackTestSuite tracedCallbackTestSuite;
@@ -1033,6 +1033,54 @@ CsmaNetDevice::SendFrom (Ptr<Packet> packet, const Address& src, const Address&
   return true;
 }
 
+uint32_t
+CsmaNetDevice::SendBatch (const std::vector<Ptr<QueueDiscItem> > &items)
+{
+  NS_LOG_FUNCTION (this << items.size ());
+
+  NS_ASSERT (IsLinkUp ());
+
+  if (IsSendEnabled () == false)
+    {
+      for (uint32_t i = 0; i < items.size (); i++)
+        {
+          m_macTxDropTrace (items[i]->GetPacket ());
+        }
+      return items.size ();
+    }
+
+  Ptr<NetDeviceQueue> txq = m_queueInterface ? m_queueInterface->GetTxQueue (0) : 0;
+  uint32_t sent = 0;
+  for (; sent < items.size (); sent++)
+    {
+      if (txq && txq->IsStopped ())
+        {
+          break;
+        }
+      Ptr<Packet> packet = items[sent]->GetPacket ();
+      Mac48Address destination = Mac48Address::ConvertFrom (items[sent]->GetAddress ());
+      AddHeader (packet, m_address, destination, items[sent]->GetProtocol ());
+      m_macTxTrace (packet);
+      if (m_queue->Enqueue (packet) == false)
+        {
+          m_macTxDropTrace (packet);
+        }
+    }
+
+  //
+  // Start a single transmission for the whole burst if the device is idle;
+  // the rest of the burst is sent from TransmitCompleteEvent.
+  //
+  if (m_txMachineState == READY && m_queue->IsEmpty () == false)
+    {
+      m_currentPkt = m_queue->Dequeue ();
+      m_promiscSnifferTrace (m_currentPkt);
+      m_snifferTrace (m_currentPkt);
+      TransmitStart ();
+    }
+  return sent;
+}
+
 Ptr<Node>
 CsmaNetDevice::GetNode (void) const
 {
@@ -285,6 +285,13 @@ public:
   virtual bool SendFrom (Ptr<Packet> packet, const Address& source, const Address& dest, 
                          uint16_t protocolNumber);
 
+  /**
+   * Start sending a burst of packets down the channel.
+   * \param items the packets to send, in order
+   * \return the number of items consumed
+   */
+  virtual uint32_t SendBatch (const std::vector<Ptr<QueueDiscItem> > &items);
+
   /**
    * Get the node to which this device is attached.
    *
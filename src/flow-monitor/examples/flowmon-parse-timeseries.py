@@ -0,0 +1,59 @@
+"""
+Read the time series of the flow statistics written by a FlowMonitor to its
+StatsFile, in CSV or binary format, and print a summary of each flow.
+
+The records are returned as dictionaries of the fields below, and may be
+fed to any plotting or analysis tool.
+"""
+from __future__ import division
+import csv
+import struct
+import sys
+
+## The fields of a record, in file order
+FIELDS = ('time', 'flowId', 'txPackets', 'txBytes', 'rxPackets', 'rxBytes',
+          'lostPackets', 'rxThroughput', 'meanDelay', 'meanJitter')
+
+## The magic number of the binary format
+BINARY_MAGIC = b'NS3FMTS\x01'
+
+## The layout of a binary record
+BINARY_RECORD = struct.Struct('<dIIQIQIddd')
+
+
+def read_records(filename):
+    """Return the list of the records of a CSV or binary time series."""
+    with open(filename, 'rb') as f:
+        magic = f.read(len(BINARY_MAGIC))
+        if magic == BINARY_MAGIC:
+            data = f.read()
+            return [dict(zip(FIELDS, BINARY_RECORD.unpack_from(data, offset)))
+                    for offset in range(0, len(data) - BINARY_RECORD.size + 1, BINARY_RECORD.size)]
+    records = []
+    with open(filename) as f:
+        for row in csv.DictReader(f):
+            records.append(dict((field, float(row[field]) if field in ('time', 'rxThroughput', 'meanDelay', 'meanJitter')
+                                 else int(row[field])) for field in FIELDS))
+    return records
+
+
+def main(argv):
+    if len(argv) != 2:
+        sys.stderr.write("usage: %s STATS-FILE\n" % argv[0])
+        return 1
+    flows = {}
+    for record in read_records(argv[1]):
+        flows.setdefault(record['flowId'], []).append(record)
+    for flowId in sorted(flows):
+        records = flows[flowId]
+        peak = max(records, key=lambda r: r['rxThroughput'])
+        print("FlowID: %i, %i intervals" % (flowId, len(records)))
+        print("\tTX packets: %i" % sum(r['txPackets'] for r in records))
+        print("\tRX packets: %i" % sum(r['rxPackets'] for r in records))
+        print("\tLost packets: %i" % sum(r['lostPackets'] for r in records))
+        print("\tPeak RX throughput: %.3f kbit/s at %.3f s" % (peak['rxThroughput'] * 1e-3, peak['time']))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
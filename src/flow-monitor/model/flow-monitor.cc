@@ -21,7 +21,13 @@
 #include "flow-monitor.h"
 #include "ns3/simulator.h"
 #include "ns3/log.h"
+#include "ns3/abort.h"
 #include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/enum.h"
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <sstream>
 
@@ -33,6 +39,47 @@ NS_LOG_COMPONENT_DEFINE ("FlowMonitor");
 
 NS_OBJECT_ENSURE_REGISTERED (FlowMonitor);
 
+/**
+ * \param flowId the flow
+ * \param packetId the packet of the flow
+ * \return the key of the tracked packet
+ */
+static inline uint64_t
+TrackedPacketKey (FlowId flowId, FlowPacketId packetId)
+{
+  return (static_cast<uint64_t> (flowId) << 32) | packetId;
+}
+
+/**
+ * Write an integer in little-endian byte order
+ * \param os the stream
+ * \param value the value
+ * \param size the number of bytes
+ */
+static void
+WriteLittleEndian (std::ostream &os, uint64_t value, uint32_t size)
+{
+  char bytes[8];
+  for (uint32_t i = 0; i < size; i++)
+    {
+      bytes[i] = static_cast<char> (value >> (8 * i));
+    }
+  os.write (bytes, size);
+}
+
+/**
+ * Write a double in little-endian byte order
+ * \param os the stream
+ * \param value the value
+ */
+static void
+WriteLittleEndian (std::ostream &os, double value)
+{
+  uint64_t bits;
+  std::memcpy (&bits, &value, sizeof (bits));
+  WriteLittleEndian (os, bits, 8);
+}
+
 TypeId 
 FlowMonitor::GetTypeId (void)
 {
@@ -69,6 +116,38 @@ FlowMonitor::GetTypeId (void)
                    TimeValue (Seconds (0.5)),
                    MakeTimeAccessor (&FlowMonitor::m_flowInterruptionsMinTime),
                    MakeTimeChecker ())
+    .AddAttribute ("MaxTrackedPackets", ("The maximum number of packets tracked in flight, 0 for no limit.  "
+                                         "When it is reached, the packets not seen for the longest time "
+                                         "are no longer tracked: they are still counted when received, "
+                                         "without a delay."),
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&FlowMonitor::m_maxTrackedPackets),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("StatsInterval", ("The interval of the time series of the flow statistics "
+                                     "written to StatsFile, 0 for none."),
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&FlowMonitor::m_statsInterval),
+                   MakeTimeChecker ())
+    .AddAttribute ("StatsFile", ("The file of the time series of the flow statistics."),
+                   StringValue ("flowmon-stats.csv"),
+                   MakeStringAccessor (&FlowMonitor::m_statsFileName),
+                   MakeStringChecker ())
+    .AddAttribute ("StatsFormat", ("The format of the time series of the flow statistics."),
+                   EnumValue (FlowMonitor::CSV),
+                   MakeEnumAccessor (&FlowMonitor::m_statsFormat),
+                   MakeEnumChecker (FlowMonitor::CSV, "Csv",
+                                    FlowMonitor::BINARY, "Binary"))
+    .AddAttribute ("SamplingMode", ("The sampling of the packets whose delay and jitter are measured.  "
+                                    "The other packets are counted, but not tracked."),
+                   EnumValue (FlowMonitor::SAMPLING_NONE),
+                   MakeEnumAccessor (&FlowMonitor::m_samplingMode),
+                   MakeEnumChecker (FlowMonitor::SAMPLING_NONE, "None",
+                                    FlowMonitor::SAMPLING_PACKETS, "Packets",
+                                    FlowMonitor::SAMPLING_FLOWS, "Flows"))
+    .AddAttribute ("SamplingRate", ("One packet, or flow, sampled out of SamplingRate."),
+                   UintegerValue (100),
+                   MakeUintegerAccessor (&FlowMonitor::m_samplingRate),
+                   MakeUintegerChecker<uint32_t> (1))
   ;
   return tid;
 }
@@ -80,7 +159,11 @@ FlowMonitor::GetInstanceTypeId (void) const
 }
 
 FlowMonitor::FlowMonitor ()
-  : m_enabled (false)
+  : m_enabled (false),
+    m_statsFormat (CSV),
+    m_maxTrackedPackets (0),
+    m_samplingMode (SAMPLING_NONE),
+    m_samplingRate (100)
 {
   // m_histogramBinWidth=DEFAULT_BIN_WIDTH;
 }
@@ -99,12 +182,24 @@ FlowMonitor::DoDispose (void)
       m_flowProbes[i]->Dispose ();
       m_flowProbes[i] = 0;
     }
+  Simulator::Cancel (m_statsEvent);
+  if (m_statsFile.is_open ())
+    {
+      m_statsFile.close ();
+    }
   Object::DoDispose ();
 }
 
 inline FlowMonitor::FlowStats&
 FlowMonitor::GetStatsForFlow (FlowId flowId)
 {
+  // The flow ids are allocated in sequence by the classifiers, so that
+  // the statistics, whose addresses in the map are stable, are indexed by
+  // their flow id
+  if (flowId < m_flowStatsIndex.size () && m_flowStatsIndex[flowId] != 0)
+    {
+      return *m_flowStatsIndex[flowId];
+    }
   FlowStatsContainerI iter;
   iter = m_flowStats.find (flowId);
   if (iter == m_flowStats.end ())
@@ -117,17 +212,36 @@ FlowMonitor::GetStatsForFlow (FlowId flowId)
       ref.rxBytes = 0;
       ref.txPackets = 0;
       ref.rxPackets = 0;
+      ref.sampledRxPackets = 0;
       ref.lostPackets = 0;
       ref.timesForwarded = 0;
       ref.delayHistogram.SetDefaultBinWidth (m_delayBinWidth);
       ref.jitterHistogram.SetDefaultBinWidth (m_jitterBinWidth);
       ref.packetSizeHistogram.SetDefaultBinWidth (m_packetSizeBinWidth);
       ref.flowInterruptionsHistogram.SetDefaultBinWidth (m_flowInterruptionsBinWidth);
-      return ref;
+      iter = m_flowStats.find (flowId);
     }
-  else
+  if (flowId >= m_flowStatsIndex.size ())
     {
-      return iter->second;
+      m_flowStatsIndex.resize (std::max<size_t> (flowId + 1, 2 * m_flowStatsIndex.size ()), 0);
+    }
+  m_flowStatsIndex[flowId] = &iter->second;
+  return iter->second;
+}
+
+bool
+FlowMonitor::IsSampled (FlowId flowId, FlowPacketId packetId) const
+{
+  switch (m_samplingMode)
+    {
+    case SAMPLING_PACKETS:
+      return packetId % m_samplingRate == 0;
+    case SAMPLING_FLOWS:
+      // Fibonacci hashing, so that the flows sampled are spread over the
+      // flow ids
+      return ((flowId * UINT64_C (0x9e3779b97f4a7c15)) >> 32) % m_samplingRate == 0;
+    default:
+      return true;
     }
 }
 
@@ -140,12 +254,19 @@ FlowMonitor::ReportFirstTx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t pack
       return;
     }
   Time now = Simulator::Now ();
-  TrackedPacket &tracked = m_trackedPackets[std::make_pair (flowId, packetId)];
-  tracked.firstSeenTime = now;
-  tracked.lastSeenTime = tracked.firstSeenTime;
-  tracked.timesForwarded = 0;
-  NS_LOG_DEBUG ("ReportFirstTx: adding tracked packet (flowId=" << flowId << ", packetId=" << packetId
-                                                                << ").");
+  if (IsSampled (flowId, packetId))
+    {
+      if (m_maxTrackedPackets > 0 && m_trackedPackets.size () >= m_maxTrackedPackets)
+        {
+          EvictTrackedPackets ();
+        }
+      TrackedPacket &tracked = m_trackedPackets[TrackedPacketKey (flowId, packetId)];
+      tracked.firstSeenTime = now;
+      tracked.lastSeenTime = tracked.firstSeenTime;
+      tracked.timesForwarded = 0;
+      NS_LOG_DEBUG ("ReportFirstTx: adding tracked packet (flowId=" << flowId << ", packetId=" << packetId
+                                                                    << ").");
+    }
 
   probe->AddPacketStats (flowId, packetSize, Seconds (0));
 
@@ -167,12 +288,26 @@ FlowMonitor::ReportForwarding (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t p
     {
       return;
     }
-  std::pair<FlowId, FlowPacketId> key (flowId, packetId);
-  TrackedPacketMap::iterator tracked = m_trackedPackets.find (key);
+  if (!IsSampled (flowId, packetId))
+    {
+      probe->AddPacketStats (flowId, packetSize, Seconds (0));
+      GetStatsForFlow (flowId).timesForwarded++;
+      return;
+    }
+  TrackedPacketMap::iterator tracked = m_trackedPackets.find (TrackedPacketKey (flowId, packetId));
   if (tracked == m_trackedPackets.end ())
     {
-      NS_LOG_WARN ("Received packet forward report (flowId=" << flowId << ", packetId=" << packetId
-                                                             << ") but not known to be transmitted.");
+      EvictedPacketMap::iterator evicted = m_evictedPackets.find (TrackedPacketKey (flowId, packetId));
+      if (evicted == m_evictedPackets.end ())
+        {
+          NS_LOG_WARN ("Received packet forward report (flowId=" << flowId << ", packetId=" << packetId
+                                                                 << ") but not known to be transmitted.");
+          return;
+        }
+      // No longer tracked: counted without a delay
+      evicted->second = Simulator::Now ();
+      probe->AddPacketStats (flowId, packetSize, Seconds (0));
+      GetStatsForFlow (flowId).timesForwarded++;
       return;
     }
 
@@ -191,36 +326,56 @@ FlowMonitor::ReportLastRx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packe
     {
       return;
     }
-  TrackedPacketMap::iterator tracked = m_trackedPackets.find (std::make_pair (flowId, packetId));
-  if (tracked == m_trackedPackets.end ())
+  bool sampled = IsSampled (flowId, packetId);
+  TrackedPacketMap::iterator tracked;
+  if (sampled)
     {
-      NS_LOG_WARN ("Received packet last-tx report (flowId=" << flowId << ", packetId=" << packetId
-                                                             << ") but not known to be transmitted.");
-      return;
+      tracked = m_trackedPackets.find (TrackedPacketKey (flowId, packetId));
+      if (tracked == m_trackedPackets.end ())
+        {
+          EvictedPacketMap::iterator evicted = m_evictedPackets.find (TrackedPacketKey (flowId, packetId));
+          if (evicted == m_evictedPackets.end ())
+            {
+              NS_LOG_WARN ("Received packet last-tx report (flowId=" << flowId << ", packetId=" << packetId
+                                                                     << ") but not known to be transmitted.");
+              return;
+            }
+          // No longer tracked: received all the same, but without a delay
+          m_evictedPackets.erase (evicted);
+          sampled = false;
+        }
     }
 
   Time now = Simulator::Now ();
-  Time delay = (now - tracked->second.firstSeenTime);
-  probe->AddPacketStats (flowId, packetSize, delay);
-
   FlowStats &stats = GetStatsForFlow (flowId);
-  stats.delaySum += delay;
-  stats.delayHistogram.AddValue (delay.GetSeconds ());
-  if (stats.rxPackets > 0 )
+  if (sampled)
     {
-      Time jitter = stats.lastDelay - delay;
-      if (jitter > Seconds (0))
-        {
-          stats.jitterSum += jitter;
-          stats.jitterHistogram.AddValue (jitter.GetSeconds ());
-        }
-      else 
+      Time delay = (now - tracked->second.firstSeenTime);
+      probe->AddPacketStats (flowId, packetSize, delay);
+
+      stats.delaySum += delay;
+      stats.delayHistogram.AddValue (delay.GetSeconds ());
+      if (stats.sampledRxPackets > 0 )
         {
-          stats.jitterSum -= jitter;
-          stats.jitterHistogram.AddValue (-jitter.GetSeconds ());
+          Time jitter = stats.lastDelay - delay;
+          if (jitter > Seconds (0))
+            {
+              stats.jitterSum += jitter;
+              stats.jitterHistogram.AddValue (jitter.GetSeconds ());
+            }
+          else
+            {
+              stats.jitterSum -= jitter;
+              stats.jitterHistogram.AddValue (-jitter.GetSeconds ());
+            }
         }
+      stats.lastDelay = delay;
+      stats.sampledRxPackets++;
+    }
+  else
+    {
+      probe->AddPacketStats (flowId, packetSize, Seconds (0));
     }
-  stats.lastDelay = delay;
 
   stats.rxBytes += packetSize;
   stats.packetSizeHistogram.AddValue ((double) packetSize);
@@ -239,12 +394,15 @@ FlowMonitor::ReportLastRx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packe
         }
     }
   stats.timeLastRxPacket = now;
-  stats.timesForwarded += tracked->second.timesForwarded;
+  if (sampled)
+    {
+      stats.timesForwarded += tracked->second.timesForwarded;
 
-  NS_LOG_DEBUG ("ReportLastTx: removing tracked packet (flowId="
-                << flowId << ", packetId=" << packetId << ").");
+      NS_LOG_DEBUG ("ReportLastTx: removing tracked packet (flowId="
+                    << flowId << ", packetId=" << packetId << ").");
 
-  m_trackedPackets.erase (tracked); // we don't need to track this packet anymore
+      m_trackedPackets.erase (tracked); // we don't need to track this packet anymore
+    }
 }
 
 void
@@ -269,7 +427,11 @@ FlowMonitor::ReportDrop (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packetI
   stats.bytesDropped[reasonCode] += packetSize;
   NS_LOG_DEBUG ("++stats.packetsDropped[" << reasonCode<< "]; // becomes: " << stats.packetsDropped[reasonCode]);
 
-  TrackedPacketMap::iterator tracked = m_trackedPackets.find (std::make_pair (flowId, packetId));
+  if (!IsSampled (flowId, packetId))
+    {
+      return;
+    }
+  TrackedPacketMap::iterator tracked = m_trackedPackets.find (TrackedPacketKey (flowId, packetId));
   if (tracked != m_trackedPackets.end ())
     {
       // we don't need to track this packet anymore
@@ -278,6 +440,10 @@ FlowMonitor::ReportDrop (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packetI
                     << flowId << ", packetId=" << packetId << ").");
       m_trackedPackets.erase (tracked);
     }
+  else
+    {
+      m_evictedPackets.erase (TrackedPacketKey (flowId, packetId));
+    }
 }
 
 const FlowMonitor::FlowStatsContainer&
@@ -298,7 +464,7 @@ FlowMonitor::CheckForLostPackets (Time maxDelay)
       if (now - iter->second.lastSeenTime >= maxDelay)
         {
           // packet is considered lost, add it to the loss statistics
-          FlowStatsContainerI flow = m_flowStats.find (iter->first.first);
+          FlowStatsContainerI flow = m_flowStats.find (iter->first >> 32);
           NS_ASSERT (flow != m_flowStats.end ());
           flow->second.lostPackets++;
 
@@ -310,6 +476,21 @@ FlowMonitor::CheckForLostPackets (Time maxDelay)
           iter++;
         }
     }
+  for (EvictedPacketMap::iterator iter = m_evictedPackets.begin ();
+       iter != m_evictedPackets.end (); )
+    {
+      if (now - iter->second >= maxDelay)
+        {
+          FlowStatsContainerI flow = m_flowStats.find (iter->first >> 32);
+          NS_ASSERT (flow != m_flowStats.end ());
+          flow->second.lostPackets++;
+          m_evictedPackets.erase (iter++);
+        }
+      else
+        {
+          iter++;
+        }
+    }
 }
 
 void
@@ -318,6 +499,101 @@ FlowMonitor::CheckForLostPackets ()
   CheckForLostPackets (m_maxPerHopDelay);
 }
 
+void
+FlowMonitor::EvictTrackedPackets ()
+{
+  // Evict an eighth of the packets at once, so that the scan is amortized
+  // over the following insertions; ties are broken by key so that the
+  // packets evicted do not depend on the order of the hash map.  Those
+  // that CheckForLostPackets would already consider lost are counted as
+  // lost; the others are only remembered, so that they are counted
+  // without a delay if received, and as lost by CheckForLostPackets if not
+  Time now = Simulator::Now ();
+  std::vector<std::pair<Time, uint64_t> > ages;
+  ages.reserve (m_trackedPackets.size ());
+  for (TrackedPacketMap::const_iterator iter = m_trackedPackets.begin ();
+       iter != m_trackedPackets.end (); iter++)
+    {
+      ages.push_back (std::make_pair (iter->second.lastSeenTime, iter->first));
+    }
+  uint32_t nEvicted = std::max<uint32_t> (1, ages.size () / 8);
+  std::nth_element (ages.begin (), ages.begin () + (nEvicted - 1), ages.end ());
+  NS_LOG_DEBUG ("Evicting " << nEvicted << " of " << ages.size () << " tracked packets");
+  for (uint32_t i = 0; i < nEvicted; i++)
+    {
+      if (now - ages[i].first >= m_maxPerHopDelay)
+        {
+          FlowStatsContainerI flow = m_flowStats.find (ages[i].second >> 32);
+          NS_ASSERT (flow != m_flowStats.end ());
+          flow->second.lostPackets++;
+        }
+      else
+        {
+          m_evictedPackets[ages[i].second] = ages[i].first;
+        }
+      m_trackedPackets.erase (ages[i].second);
+    }
+}
+
+void
+FlowMonitor::WriteIntervalStats ()
+{
+  Time now = Simulator::Now ();
+  double interval = (now - m_statsIntervalStart).GetSeconds ();
+  for (FlowStatsContainerCI flowI = m_flowStats.begin (); flowI != m_flowStats.end (); flowI++)
+    {
+      const FlowStats &stats = flowI->second;
+      IntervalStats &last = m_lastIntervalStats[flowI->first];
+      uint32_t txPackets = stats.txPackets - last.txPackets;
+      uint64_t txBytes = stats.txBytes - last.txBytes;
+      uint32_t rxPackets = stats.rxPackets - last.rxPackets;
+      uint32_t sampledRxPackets = stats.sampledRxPackets - last.sampledRxPackets;
+      uint64_t rxBytes = stats.rxBytes - last.rxBytes;
+      uint32_t lostPackets = stats.lostPackets - last.lostPackets;
+      double throughput = interval > 0 ? rxBytes * 8 / interval : 0;
+      double meanDelay = sampledRxPackets > 0 ? (stats.delaySum - last.delaySum).GetSeconds () / sampledRxPackets : 0;
+      double meanJitter = sampledRxPackets > 0 ? (stats.jitterSum - last.jitterSum).GetSeconds () / sampledRxPackets : 0;
+      if (m_statsFormat == CSV)
+        {
+          m_statsFile << now.GetSeconds () << ',' << flowI->first << ','
+                      << txPackets << ',' << txBytes << ','
+                      << rxPackets << ',' << rxBytes << ','
+                      << lostPackets << ',' << throughput << ','
+                      << meanDelay << ',' << meanJitter << '\n';
+        }
+      else
+        {
+          WriteLittleEndian (m_statsFile, now.GetSeconds ());
+          WriteLittleEndian (m_statsFile, flowI->first, 4);
+          WriteLittleEndian (m_statsFile, txPackets, 4);
+          WriteLittleEndian (m_statsFile, txBytes, 8);
+          WriteLittleEndian (m_statsFile, rxPackets, 4);
+          WriteLittleEndian (m_statsFile, rxBytes, 8);
+          WriteLittleEndian (m_statsFile, lostPackets, 4);
+          WriteLittleEndian (m_statsFile, throughput);
+          WriteLittleEndian (m_statsFile, meanDelay);
+          WriteLittleEndian (m_statsFile, meanJitter);
+        }
+      last.txPackets = stats.txPackets;
+      last.txBytes = stats.txBytes;
+      last.rxPackets = stats.rxPackets;
+      last.sampledRxPackets = stats.sampledRxPackets;
+      last.rxBytes = stats.rxBytes;
+      last.lostPackets = stats.lostPackets;
+      last.delaySum = stats.delaySum;
+      last.jitterSum = stats.jitterSum;
+    }
+  m_statsFile.flush ();
+  m_statsIntervalStart = now;
+}
+
+void
+FlowMonitor::PeriodicWriteIntervalStats ()
+{
+  WriteIntervalStats ();
+  m_statsEvent = Simulator::Schedule (m_statsInterval, &FlowMonitor::PeriodicWriteIntervalStats, this);
+}
+
 void
 FlowMonitor::PeriodicCheckForLostPackets ()
 {
@@ -377,6 +653,26 @@ FlowMonitor::StartRightNow ()
       return;
     }
   m_enabled = true;
+  if (m_statsInterval.IsStrictlyPositive ())
+    {
+      if (!m_statsFile.is_open ())
+        {
+          m_statsFile.open (m_statsFileName.c_str (), std::ios::out | std::ios::binary);
+          NS_ABORT_MSG_UNLESS (m_statsFile.is_open (), "Cannot open " << m_statsFileName);
+          if (m_statsFormat == CSV)
+            {
+              m_statsFile.precision (9);
+              m_statsFile << "time,flowId,txPackets,txBytes,rxPackets,rxBytes,"
+                          << "lostPackets,rxThroughput,meanDelay,meanJitter\n";
+            }
+          else
+            {
+              m_statsFile.write ("NS3FMTS\1", 8);
+            }
+        }
+      m_statsIntervalStart = Simulator::Now ();
+      m_statsEvent = Simulator::Schedule (m_statsInterval, &FlowMonitor::PeriodicWriteIntervalStats, this);
+    }
 }
 
 
@@ -389,6 +685,12 @@ FlowMonitor::StopRightNow ()
     }
   m_enabled = false;
   CheckForLostPackets ();
+  if (m_statsEvent.IsRunning ())
+    {
+      // the last, partial, interval
+      m_statsEvent.Cancel ();
+      WriteIntervalStats ();
+    }
 }
 
 void
@@ -424,8 +726,12 @@ FlowMonitor::SerializeToXmlStream (std::ostream &os, uint16_t indent, bool enabl
       ATTRIB (txPackets)
       ATTRIB (rxPackets)
       ATTRIB (lostPackets)
-      ATTRIB (timesForwarded)
-      << ">\n";
+      ATTRIB (timesForwarded);
+      if (m_samplingMode != SAMPLING_NONE)
+        {
+          os ATTRIB (sampledRxPackets);
+        }
+      os << ">\n";
 #undef ATTRIB
 
       indent += 2;
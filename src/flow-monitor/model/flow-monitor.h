@@ -23,6 +23,8 @@
 
 #include <vector>
 #include <map>
+#include <fstream>
+#include <unordered_map>
 
 #include "ns3/ptr.h"
 #include "ns3/object.h"
@@ -46,6 +48,20 @@ namespace ns3 {
  * The FlowMonitor class is responsible for coordinating efforts
  * regarding probes, and collects end-to-end flow statistics.
  *
+ * Besides the final report, the statistics of the flows over each
+ * interval of StatsInterval can be streamed to the StatsFile, as a time
+ * series in CSV or binary format (see WriteIntervalStats).  The number of
+ * packets tracked in flight can be bounded by MaxTrackedPackets: the
+ * packets no longer tracked are still counted when received, like the
+ * packets outside the sample below.
+ *
+ * To make the monitor cheaper in large simulations, the delays and
+ * jitters can be measured on a sample of the packets only (SamplingMode
+ * and SamplingRate): the packets outside the sample are counted, but not
+ * tracked in flight.  The packets and bytes sent, received and dropped
+ * stay exact; the delay and jitter sums and histograms are those of the
+ * sampled packets, counted by sampledRxPackets, and the packets lost
+ * without a drop report are only detected among the sampled packets.
  */
 class FlowMonitor : public Object
 {
@@ -75,7 +91,7 @@ public:
 
     /// Contains the sum of all end-to-end delays for all received
     /// packets of the flow.
-    Time     delaySum; // delayCount == rxPackets
+    Time     delaySum; // delayCount == sampledRxPackets
 
     /// Contains the sum of all end-to-end delay jitter (delay
     /// variation) values for all received packets of the flow.  Here
@@ -84,7 +100,7 @@ public:
     /// i.e. \f$Jitter\left\{P_N\right\} = \left|Delay\left\{P_N\right\} - Delay\left\{P_{N-1}\right\}\right|\f$.
     /// This definition is in accordance with the Type-P-One-way-ipdv
     /// as defined in IETF \RFC{3393}.
-    Time     jitterSum; // jitterCount == rxPackets - 1
+    Time     jitterSum; // jitterCount == sampledRxPackets - 1
 
     /// Contains the last measured delay of a packet
     /// It is stored to measure the packet's Jitter
@@ -98,6 +114,9 @@ public:
     uint32_t txPackets;
     /// Total number of received packets for the flow
     uint32_t rxPackets;
+    /// Number of received packets whose delay was measured, equal to
+    /// rxPackets unless the packets are sampled
+    uint32_t sampledRxPackets;
 
     /// Total number of packets that are assumed to be lost,
     /// i.e. those that were transmitted but have not been reportedly
@@ -146,6 +165,21 @@ public:
   virtual TypeId GetInstanceTypeId () const;
   FlowMonitor ();
 
+  /// Formats of the time series of the flow statistics
+  enum StatsFormat
+  {
+    CSV,    //!< Text, one comma-separated line per flow and interval
+    BINARY  //!< Fixed-size little-endian records
+  };
+
+  /// Sampling of the packets whose delay and jitter are measured
+  enum SamplingMode
+  {
+    SAMPLING_NONE,     //!< All the packets
+    SAMPLING_PACKETS,  //!< One packet out of SamplingRate in each flow
+    SAMPLING_FLOWS     //!< All the packets of one flow out of SamplingRate, chosen by hash
+  };
+
   /// Add a FlowClassifier to be used by the flow monitor.
   /// \param classifier the FlowClassifier
   void AddFlowClassifier (Ptr<FlowClassifier> classifier);
@@ -274,10 +308,15 @@ private:
 
   /// FlowId --> FlowStats
   FlowStatsContainer m_flowStats;
+  /// FlowId --> FlowStats in m_flowStats, or null
+  std::vector<FlowStats *> m_flowStatsIndex;
 
-  /// (FlowId,PacketId) --> TrackedPacket
-  typedef std::map< std::pair<FlowId, FlowPacketId>, TrackedPacket> TrackedPacketMap;
+  /// (FlowId,PacketId) --> TrackedPacket, keyed by FlowId << 32 | PacketId
+  typedef std::unordered_map<uint64_t, TrackedPacket> TrackedPacketMap;
   TrackedPacketMap m_trackedPackets; //!< Tracked packets
+  /// (FlowId,PacketId) --> time last seen, of the packets evicted from m_trackedPackets
+  typedef std::unordered_map<uint64_t, Time> EvictedPacketMap;
+  EvictedPacketMap m_evictedPackets; //!< Packets no longer tracked, not yet received nor lost
   Time m_maxPerHopDelay; //!< Minimum per-hop delay
   FlowProbeContainer m_flowProbes; //!< all the FlowProbes
 
@@ -293,6 +332,35 @@ private:
   double m_flowInterruptionsBinWidth; //!< Flow interruptions bin width (for histograms)
   Time m_flowInterruptionsMinTime; //!< Flow interruptions minimum time
 
+  /// Totals of a flow at the end of the last interval exported
+  struct IntervalStats
+  {
+    uint64_t txBytes;      //!< Transmitted bytes
+    uint64_t rxBytes;      //!< Received bytes
+    uint32_t txPackets;    //!< Transmitted packets
+    uint32_t rxPackets;    //!< Received packets
+    uint32_t sampledRxPackets; //!< Received packets whose delay was measured
+    uint32_t lostPackets;  //!< Lost packets
+    Time delaySum;         //!< Sum of the delays
+    Time jitterSum;        //!< Sum of the jitters
+  };
+
+  Time m_statsInterval;                //!< Interval of the time series, zero for none
+  std::string m_statsFileName;         //!< File of the time series
+  StatsFormat m_statsFormat;           //!< Format of the time series
+  std::ofstream m_statsFile;           //!< Stream of the time series
+  EventId m_statsEvent;                //!< Next export of the time series
+  Time m_statsIntervalStart;           //!< Start of the current interval
+  std::map<FlowId, IntervalStats> m_lastIntervalStats; //!< Totals of the flows at the start of the interval
+  uint32_t m_maxTrackedPackets;        //!< Maximum number of tracked packets, zero for no limit
+  SamplingMode m_samplingMode;         //!< Sampling of the delays
+  uint32_t m_samplingRate;             //!< One packet or flow sampled out of m_samplingRate
+
+  /// \param flowId the flow
+  /// \param packetId the packet of the flow
+  /// \return whether the delay of the packet is measured
+  bool IsSampled (FlowId flowId, FlowPacketId packetId) const;
+
   /// Get the stats for a given flow
   /// \param flowId the Flow identification
   /// \returns the stats of the flow
@@ -300,6 +368,18 @@ private:
 
   /// Periodic function to check for lost packets and prune statistics
   void PeriodicCheckForLostPackets ();
+
+  /// Stop tracking the packets not seen for the longest time, to make
+  /// room for new ones when MaxTrackedPackets packets are tracked; those
+  /// not seen for MaxPerHopDelay are counted as lost, the others are
+  /// kept in m_evictedPackets until they are received or lost
+  void EvictTrackedPackets ();
+
+  /// Write the statistics of the flows over the interval ending now
+  void WriteIntervalStats ();
+
+  /// Periodic function exporting the statistics of the flows
+  void PeriodicWriteIntervalStats ();
 };
 
 
@@ -21,6 +21,8 @@
 #include "ns3/flow-probe.h"
 #include "ns3/flow-monitor.h"
 
+#include <algorithm>
+
 namespace ns3 {
 
 /* static */
@@ -53,10 +55,26 @@ FlowProbe::DoDispose (void)
   Object::DoDispose ();
 }
 
+FlowProbe::FlowStats&
+FlowProbe::GetStatsForFlow (FlowId flowId)
+{
+  if (flowId < m_statsIndex.size () && m_statsIndex[flowId] != 0)
+    {
+      return *m_statsIndex[flowId];
+    }
+  if (flowId >= m_statsIndex.size ())
+    {
+      m_statsIndex.resize (std::max<size_t> (flowId + 1, 2 * m_statsIndex.size ()), 0);
+    }
+  FlowStats &flow = m_stats[flowId];
+  m_statsIndex[flowId] = &flow;
+  return flow;
+}
+
 void
 FlowProbe::AddPacketStats (FlowId flowId, uint32_t packetSize, Time delayFromFirstProbe)
 {
-  FlowStats &flow = m_stats[flowId];
+  FlowStats &flow = GetStatsForFlow (flowId);
   flow.delayFromFirstProbeSum += delayFromFirstProbe;
   flow.bytes += packetSize;
   ++flow.packets;
@@ -65,7 +83,7 @@ FlowProbe::AddPacketStats (FlowId flowId, uint32_t packetSize, Time delayFromFir
 void
 FlowProbe::AddPacketDropStats (FlowId flowId, uint32_t packetSize, uint32_t reasonCode)
 {
-  FlowStats &flow = m_stats[flowId];
+  FlowStats &flow = GetStatsForFlow (flowId);
 
   if (flow.packetsDropped.size () < reasonCode + 1)
     {
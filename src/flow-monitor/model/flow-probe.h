@@ -106,6 +106,14 @@ protected:
   Ptr<FlowMonitor> m_flowMonitor; //!< the FlowMonitor instance
   Stats m_stats; //!< The flow stats
 
+private:
+  /// Get the stats of a flow, indexed by flow id
+  /// \param flowId the flow Identifier
+  /// \returns the stats of the flow
+  FlowStats& GetStatsForFlow (FlowId flowId);
+
+  std::vector<FlowStats *> m_statsIndex; //!< FlowId --> FlowStats in m_stats, or null
+
 };
 
 
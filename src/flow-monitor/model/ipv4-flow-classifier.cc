@@ -156,27 +156,22 @@ Ipv4FlowClassifier::Classify (const Ipv4Header &ipHeader, Ptr<const Packet> ipPa
     {
       FlowId newFlowId = GetNewFlowId ();
       insert.first->second = newFlowId;
-      m_flowPktIdMap[newFlowId] = 0;
-      m_flowDscpMap[newFlowId];
+      if (newFlowId >= m_flowPktIds.size ())
+        {
+          m_flowPktIds.resize (newFlowId + 1, 0);
+        }
+      m_flowPktIds[newFlowId] = 0;
     }
   else
     {
-      m_flowPktIdMap[insert.first->second] ++;
+      m_flowPktIds[insert.first->second] ++;
     }
 
   // increment the counter of packets with the same DSCP value
-  Ipv4Header::DscpType dscp = ipHeader.GetDscp ();
-  std::pair<std::map<Ipv4Header::DscpType, uint32_t>::iterator, bool> dscpInserter
-    = m_flowDscpMap[insert.first->second].insert (std::pair<Ipv4Header::DscpType, uint32_t> (dscp, 1));
-
-  // if the insertion did not succeed, we need to increment the counter
-  if (!dscpInserter.second)
-    {
-      m_flowDscpMap[insert.first->second][dscp] ++;
-    }
+  ++m_flowDscpMap[insert.first->second][ipHeader.GetDscp ()];
 
   *out_flowId = insert.first->second;
-  *out_packetId = m_flowPktIdMap[*out_flowId];
+  *out_packetId = m_flowPktIds[*out_flowId];
 
   return true;
 }
@@ -24,6 +24,7 @@
 
 #include <stdint.h>
 #include <map>
+#include <vector>
 
 #include "ns3/ipv6-header.h"
 #include "ns3/flow-classifier.h"
@@ -95,8 +96,8 @@ private:
 
   /// Map to Flows Identifiers to FlowIds
   std::map<FiveTuple, FlowId> m_flowMap;
-  /// Map to FlowIds to FlowPacketId
-  std::map<FlowId, FlowPacketId> m_flowPktIdMap;
+  /// FlowId --> last FlowPacketId of the flow
+  std::vector<FlowPacketId> m_flowPktIds;
   /// Map FlowIds to (DSCP value, packet count) pairs
   std::map<FlowId, std::map<Ipv6Header::DscpType, uint32_t> > m_flowDscpMap;
 
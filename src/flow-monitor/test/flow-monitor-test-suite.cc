@@ -0,0 +1,396 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/nstime.h"
+#include "ns3/node-container.h"
+#include "ns3/packet.h"
+#include "ns3/socket.h"
+#include "ns3/udp-socket-factory.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/neighbor-cache-helper.h"
+#include "ns3/flow-monitor-helper.h"
+#include "ns3/flow-monitor.h"
+
+#include <fstream>
+#include <sstream>
+
+using namespace ns3;
+
+/**
+ * \ingroup flow-monitor-test
+ * \ingroup tests
+ *
+ * \brief Send UDP packets between two nodes, through a FlowMonitor
+ */
+class FlowMonitorTestCase : public TestCase
+{
+public:
+  /**
+   * \brief Constructor.
+   * \param name The name of the test case.
+   */
+  FlowMonitorTestCase (std::string name);
+
+protected:
+  /**
+   * \brief Send packets, one every millisecond from 1 s, and run the
+   * simulation until 10 s, with the monitor stopped at 9.95 s.
+   * \param flowmon The helper of the monitor.
+   * \param delay The delay of the channel.
+   * \param nPackets The number of packets.
+   * \return The statistics of the flow.
+   */
+  FlowMonitor::FlowStats Run (FlowMonitorHelper &flowmon, Time delay, uint32_t nPackets);
+
+  /**
+   * \brief Send packets as Run does, on several flows to consecutive
+   * ports, one packet of each flow every millisecond.
+   * \param flowmon The helper of the monitor.
+   * \param delay The delay of the channel.
+   * \param nPackets The number of packets of each flow.
+   * \param nFlows The number of flows.
+   * \return The statistics of the flows.
+   */
+  FlowMonitor::FlowStatsContainer RunFlows (FlowMonitorHelper &flowmon, Time delay,
+                                            uint32_t nPackets, uint32_t nFlows);
+
+private:
+  /**
+   * \brief Send a packet on each flow.
+   * \param socket The sending socket.
+   * \param to Destination address.
+   * \param nFlows The number of flows.
+   * \param n The number of packets left to send.
+   */
+  void SendPkt (Ptr<Socket> socket, Ipv4Address to, uint32_t nFlows, uint32_t n);
+};
+
+FlowMonitorTestCase::FlowMonitorTestCase (std::string name)
+  : TestCase (name)
+{
+}
+
+void
+FlowMonitorTestCase::SendPkt (Ptr<Socket> socket, Ipv4Address to, uint32_t nFlows, uint32_t n)
+{
+  for (uint32_t f = 0; f < nFlows; f++)
+    {
+      socket->SendTo (Create<Packet> (100), 0, InetSocketAddress (to, 1234 + f));
+    }
+  if (n > 1)
+    {
+      Simulator::Schedule (MilliSeconds (1), &FlowMonitorTestCase::SendPkt, this, socket, to, nFlows, n - 1);
+    }
+}
+
+FlowMonitor::FlowStats
+FlowMonitorTestCase::Run (FlowMonitorHelper &flowmon, Time delay, uint32_t nPackets)
+{
+  FlowMonitor::FlowStatsContainer stats = RunFlows (flowmon, delay, nPackets, 1);
+  NS_ASSERT (stats.size () == 1);
+  return stats.begin ()->second;
+}
+
+FlowMonitor::FlowStatsContainer
+FlowMonitorTestCase::RunFlows (FlowMonitorHelper &flowmon, Time delay, uint32_t nPackets, uint32_t nFlows)
+{
+  NodeContainer nodes;
+  nodes.Create (2);
+  InternetStackHelper internet;
+  internet.SetIpv6StackInstall (false);
+  internet.Install (nodes);
+  SimpleNetDeviceHelper link;
+  link.SetChannelAttribute ("Delay", TimeValue (delay));
+  Ipv4AddressHelper address ("10.1.1.0", "255.255.255.0");
+  Ipv4InterfaceContainer interfaces = address.Assign (link.Install (nodes));
+  // No address resolution, which would hold the first packets back
+  NeighborCacheHelper::PopulateNeighborCache ();
+
+  Ptr<FlowMonitor> monitor = flowmon.Install (nodes);
+  for (uint32_t f = 0; f < nFlows; f++)
+    {
+      Ptr<Socket> rxSocket = Socket::CreateSocket (nodes.Get (1), UdpSocketFactory::GetTypeId ());
+      rxSocket->Bind (InetSocketAddress (Ipv4Address::GetAny (), 1234 + f));
+    }
+  Ptr<Socket> txSocket = Socket::CreateSocket (nodes.Get (0), UdpSocketFactory::GetTypeId ());
+  Simulator::Schedule (Seconds (1), &FlowMonitorTestCase::SendPkt, this, txSocket,
+                       interfaces.GetAddress (1), nFlows, nPackets);
+  Simulator::Schedule (Seconds (9.95), &FlowMonitor::StopRightNow, monitor);
+  Simulator::Stop (Seconds (10));
+  Simulator::Run ();
+  FlowMonitor::FlowStatsContainer stats = monitor->GetFlowStats ();
+  Simulator::Destroy ();
+  return stats;
+}
+
+/**
+ * \ingroup flow-monitor-test
+ * \ingroup tests
+ *
+ * \brief Check that the intervals of the time series of the statistics
+ * add up to the totals of the flow
+ */
+class FlowMonitorIntervalStatsTestCase : public FlowMonitorTestCase
+{
+public:
+  FlowMonitorIntervalStatsTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+FlowMonitorIntervalStatsTestCase::FlowMonitorIntervalStatsTestCase ()
+  : FlowMonitorTestCase ("The intervals of the statistics must add up to the totals")
+{
+}
+
+void
+FlowMonitorIntervalStatsTestCase::DoRun (void)
+{
+  std::string fileName = CreateTempDirFilename ("flowmon-stats.csv");
+  FlowMonitorHelper flowmon;
+  flowmon.SetMonitorAttribute ("StatsInterval", TimeValue (Seconds (0.5)));
+  flowmon.SetMonitorAttribute ("StatsFile", StringValue (fileName));
+  FlowMonitor::FlowStats stats = Run (flowmon, MilliSeconds (2), 3000);
+  NS_TEST_ASSERT_MSG_EQ (stats.txPackets, 3000, "Wrong number of packets sent");
+  NS_TEST_ASSERT_MSG_EQ (stats.rxPackets, 3000, "Wrong number of packets received");
+
+  std::ifstream file (fileName.c_str ());
+  std::string line;
+  std::getline (file, line);
+  NS_TEST_ASSERT_MSG_EQ (line, "time,flowId,txPackets,txBytes,rxPackets,rxBytes,"
+                         "lostPackets,rxThroughput,meanDelay,meanJitter", "Wrong header");
+  uint32_t rows = 0;
+  uint64_t txPackets = 0, txBytes = 0, rxPackets = 0, rxBytes = 0;
+  double lastTime = 0;
+  while (std::getline (file, line))
+    {
+      std::istringstream row (line);
+      double time, throughput, meanDelay;
+      uint32_t flowId, txp, rxp, lost;
+      uint64_t txb, rxb;
+      char c;
+      row >> time >> c >> flowId >> c >> txp >> c >> txb >> c >> rxp >> c >> rxb >> c
+          >> lost >> c >> throughput >> c >> meanDelay;
+      NS_TEST_ASSERT_MSG_EQ (row.fail (), false, "Malformed row " << line);
+      NS_TEST_ASSERT_MSG_GT (time, lastTime, "Rows out of order");
+      NS_TEST_ASSERT_MSG_EQ (flowId, 1, "Wrong flow");
+      if (rxp > 0)
+        {
+          NS_TEST_ASSERT_MSG_EQ_TOL (meanDelay, 0.002, 1e-9, "Wrong mean delay");
+        }
+      lastTime = time;
+      txPackets += txp;
+      txBytes += txb;
+      rxPackets += rxp;
+      rxBytes += rxb;
+      rows++;
+    }
+  // Every half second from the first packet at 1 s, and the partial
+  // interval up to the stop at 9.95 s
+  NS_TEST_ASSERT_MSG_EQ (rows, 19, "Wrong number of intervals");
+  NS_TEST_ASSERT_MSG_EQ_TOL (lastTime, 9.95, 1e-9, "Wrong end of the last interval");
+  NS_TEST_ASSERT_MSG_EQ (txPackets, stats.txPackets, "Intervals do not add up to the packets sent");
+  NS_TEST_ASSERT_MSG_EQ (txBytes, stats.txBytes, "Intervals do not add up to the bytes sent");
+  NS_TEST_ASSERT_MSG_EQ (rxPackets, stats.rxPackets, "Intervals do not add up to the packets received");
+  NS_TEST_ASSERT_MSG_EQ (rxBytes, stats.rxBytes, "Intervals do not add up to the bytes received");
+}
+
+/**
+ * \ingroup flow-monitor-test
+ * \ingroup tests
+ *
+ * \brief Check that the packets no longer tracked beyond
+ * MaxTrackedPackets are counted as received, without a delay, and that
+ * the packets sent before the monitor started are not
+ */
+class FlowMonitorMaxTrackedPacketsTestCase : public FlowMonitorTestCase
+{
+public:
+  FlowMonitorMaxTrackedPacketsTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+FlowMonitorMaxTrackedPacketsTestCase::FlowMonitorMaxTrackedPacketsTestCase ()
+  : FlowMonitorTestCase ("The packets tracked beyond the limit must be counted as received")
+{
+}
+
+void
+FlowMonitorMaxTrackedPacketsTestCase::DoRun (void)
+{
+  // 200 packets in flight at once, tracked 40 at most
+  FlowMonitorHelper flowmon;
+  flowmon.SetMonitorAttribute ("MaxTrackedPackets", UintegerValue (40));
+  FlowMonitor::FlowStats stats = Run (flowmon, MilliSeconds (200), 1000);
+  NS_TEST_ASSERT_MSG_EQ (stats.txPackets, 1000, "Wrong number of packets sent");
+  NS_TEST_ASSERT_MSG_EQ (stats.rxPackets, 1000, "Wrong number of packets received");
+  NS_TEST_ASSERT_MSG_EQ (stats.rxBytes, stats.txBytes, "Wrong number of bytes received");
+  NS_TEST_ASSERT_MSG_EQ (stats.lostPackets, 0, "Packets evicted counted as lost");
+  NS_TEST_ASSERT_MSG_EQ (stats.sampledRxPackets, 40, "Only the last packets sent must be tracked until received");
+  NS_TEST_ASSERT_MSG_EQ (stats.delaySum, MilliSeconds (200) * stats.sampledRxPackets,
+                         "Delays of the packets no longer tracked measured");
+
+  // Without a limit, all of them are tracked
+  FlowMonitorHelper unbounded;
+  stats = Run (unbounded, MilliSeconds (200), 1000);
+  NS_TEST_ASSERT_MSG_EQ (stats.rxPackets, 1000, "Wrong number of packets received");
+  NS_TEST_ASSERT_MSG_EQ (stats.lostPackets, 0, "No packet must be lost");
+  NS_TEST_ASSERT_MSG_EQ (stats.sampledRxPackets, 1000, "Wrong number of packets tracked");
+
+  // The 100 packets sent before the monitor started are not counted when
+  // received, whether or not the tracked packets are bounded
+  for (uint32_t maxTracked = 0; maxTracked <= 40; maxTracked += 40)
+    {
+      FlowMonitorHelper late;
+      late.SetMonitorAttribute ("StartTime", TimeValue (Seconds (1.1)));
+      late.SetMonitorAttribute ("MaxTrackedPackets", UintegerValue (maxTracked));
+      stats = Run (late, MilliSeconds (200), 1000);
+      NS_TEST_ASSERT_MSG_EQ (stats.txPackets, 900, "Wrong number of packets sent");
+      NS_TEST_ASSERT_MSG_EQ (stats.rxPackets, 900, "Packets sent before the start counted as received");
+      NS_TEST_ASSERT_MSG_EQ (stats.lostPackets, 0, "No packet must be lost");
+    }
+}
+
+/**
+ * \ingroup flow-monitor-test
+ * \ingroup tests
+ *
+ * \brief Check that the packets are counted exactly, and their delays
+ * measured on the sample only, when the packets are sampled
+ */
+class FlowMonitorSamplingTestCase : public FlowMonitorTestCase
+{
+public:
+  FlowMonitorSamplingTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+FlowMonitorSamplingTestCase::FlowMonitorSamplingTestCase ()
+  : FlowMonitorTestCase ("The packets sampled must only be those whose delay is measured")
+{
+}
+
+void
+FlowMonitorSamplingTestCase::DoRun (void)
+{
+  FlowMonitorHelper flowmon;
+  flowmon.SetMonitorAttribute ("SamplingMode", StringValue ("Packets"));
+  flowmon.SetMonitorAttribute ("SamplingRate", UintegerValue (10));
+  FlowMonitor::FlowStats stats = Run (flowmon, MilliSeconds (2), 3000);
+  NS_TEST_ASSERT_MSG_EQ (stats.txPackets, 3000, "Wrong number of packets sent");
+  NS_TEST_ASSERT_MSG_EQ (stats.rxPackets, 3000, "Wrong number of packets received");
+  NS_TEST_ASSERT_MSG_EQ (stats.rxBytes, stats.txBytes, "Wrong number of bytes received");
+  NS_TEST_ASSERT_MSG_EQ (stats.lostPackets, 0, "No packet must be lost");
+  NS_TEST_ASSERT_MSG_EQ (stats.sampledRxPackets, 300, "Wrong number of packets sampled");
+  NS_TEST_ASSERT_MSG_GT (stats.delayHistogram.GetNBins (), 0, "No delay measured");
+  NS_TEST_ASSERT_MSG_EQ (stats.delaySum, MilliSeconds (2) * 300, "Delays of the packets not sampled measured");
+
+  // Without sampling, all the delays are measured
+  FlowMonitorHelper unsampled;
+  stats = Run (unsampled, MilliSeconds (2), 3000);
+  NS_TEST_ASSERT_MSG_EQ (stats.sampledRxPackets, 3000, "Wrong number of packets sampled");
+  NS_TEST_ASSERT_MSG_EQ (stats.delaySum, MilliSeconds (2) * 3000, "Wrong sum of the delays");
+}
+
+/**
+ * \ingroup flow-monitor-test
+ * \ingroup tests
+ *
+ * \brief Check that, when the flows are sampled, the delays are measured
+ * on about one flow out of SamplingRate, and the packets of all the flows
+ * counted exactly
+ */
+class FlowMonitorFlowSamplingTestCase : public FlowMonitorTestCase
+{
+public:
+  FlowMonitorFlowSamplingTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+FlowMonitorFlowSamplingTestCase::FlowMonitorFlowSamplingTestCase ()
+  : FlowMonitorTestCase ("The flows sampled must be about one out of SamplingRate")
+{
+}
+
+void
+FlowMonitorFlowSamplingTestCase::DoRun (void)
+{
+  FlowMonitorHelper flowmon;
+  flowmon.SetMonitorAttribute ("SamplingMode", StringValue ("Flows"));
+  flowmon.SetMonitorAttribute ("SamplingRate", UintegerValue (8));
+  FlowMonitor::FlowStatsContainer stats = RunFlows (flowmon, MilliSeconds (2), 50, 256);
+  NS_TEST_ASSERT_MSG_EQ (stats.size (), 256, "Wrong number of flows");
+  uint32_t sampledFlows = 0;
+  for (FlowMonitor::FlowStatsContainerCI i = stats.begin (); i != stats.end (); i++)
+    {
+      const FlowMonitor::FlowStats &flow = i->second;
+      NS_TEST_ASSERT_MSG_EQ (flow.txPackets, 50, "Wrong number of packets sent in flow " << i->first);
+      NS_TEST_ASSERT_MSG_EQ (flow.rxPackets, 50, "Wrong number of packets received in flow " << i->first);
+      NS_TEST_ASSERT_MSG_EQ (flow.rxBytes, flow.txBytes, "Wrong number of bytes received in flow " << i->first);
+      NS_TEST_ASSERT_MSG_EQ (flow.lostPackets, 0, "No packet must be lost in flow " << i->first);
+      // All the packets of a flow are sampled, or none
+      if (flow.sampledRxPackets > 0)
+        {
+          sampledFlows++;
+          NS_TEST_ASSERT_MSG_EQ (flow.sampledRxPackets, 50, "Flow " << i->first << " partly sampled");
+          NS_TEST_ASSERT_MSG_EQ (flow.delaySum, MilliSeconds (2) * 50, "Wrong sum of the delays in flow " << i->first);
+        }
+      else
+        {
+          NS_TEST_ASSERT_MSG_EQ (flow.delaySum, Seconds (0), "Delays measured in flow " << i->first);
+        }
+    }
+  // 32 flows expected, the sample of a hash
+  NS_TEST_ASSERT_MSG_GT (sampledFlows, 24, "Too few flows sampled");
+  NS_TEST_ASSERT_MSG_LT (sampledFlows, 40, "Too many flows sampled");
+}
+
+/**
+ * \ingroup flow-monitor-test
+ * \ingroup tests
+ *
+ * \brief FlowMonitor TestSuite
+ */
+class FlowMonitorTestSuite : public TestSuite
+{
+public:
+  FlowMonitorTestSuite ();
+};
+
+FlowMonitorTestSuite::FlowMonitorTestSuite ()
+  : TestSuite ("flow-monitor", UNIT)
+{
+  AddTestCase (new FlowMonitorIntervalStatsTestCase, TestCase::QUICK);
+  AddTestCase (new FlowMonitorMaxTrackedPacketsTestCase, TestCase::QUICK);
+  AddTestCase (new FlowMonitorSamplingTestCase, TestCase::QUICK);
+  AddTestCase (new FlowMonitorFlowSamplingTestCase, TestCase::QUICK);
+}
+
+static FlowMonitorTestSuite g_flowMonitorTestSuite; //!< Static variable for test initialization
@@ -0,0 +1,131 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "neighbor-cache-helper.h"
+#include "ns3/log.h"
+#include "ns3/node.h"
+#include "ns3/channel-list.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/ipv4-interface.h"
+#include "ns3/arp-cache.h"
+#include "ns3/ipv6-l3-protocol.h"
+#include "ns3/ipv6-interface.h"
+#include "ns3/ndisc-cache.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("NeighborCacheHelper");
+
+void
+NeighborCacheHelper::PopulateNeighborCache (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  for (ChannelList::Iterator i = ChannelList::Begin (); i != ChannelList::End (); i++)
+    {
+      PopulateNeighborCache (*i);
+    }
+}
+
+void
+NeighborCacheHelper::PopulateNeighborCache (Ptr<Channel> channel)
+{
+  NS_LOG_FUNCTION (channel);
+  for (uint32_t i = 0; i < channel->GetNDevices (); i++)
+    {
+      PopulateDevice (channel->GetDevice (i));
+    }
+}
+
+void
+NeighborCacheHelper::PopulateNeighborCache (const NetDeviceContainer &devices)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  for (NetDeviceContainer::Iterator i = devices.Begin (); i != devices.End (); i++)
+    {
+      PopulateDevice (*i);
+    }
+}
+
+void
+NeighborCacheHelper::PopulateDevice (Ptr<NetDevice> device)
+{
+  NS_LOG_FUNCTION (device);
+  Ptr<Channel> channel = device->GetChannel ();
+  if (channel == 0)
+    {
+      return;
+    }
+  Ptr<Ipv4L3Protocol> ipv4 = device->GetNode ()->GetObject<Ipv4L3Protocol> ();
+  Ptr<ArpCache> arpCache;
+  if (ipv4 != 0 && ipv4->GetInterfaceForDevice (device) >= 0)
+    {
+      arpCache = ipv4->GetInterface (ipv4->GetInterfaceForDevice (device))->GetArpCache ();
+    }
+  Ptr<Ipv6L3Protocol> ipv6 = device->GetNode ()->GetObject<Ipv6L3Protocol> ();
+  Ptr<NdiscCache> ndiscCache;
+  if (ipv6 != 0 && ipv6->GetInterfaceForDevice (device) >= 0)
+    {
+      ndiscCache = ipv6->GetInterface (ipv6->GetInterfaceForDevice (device))->GetNdiscCache ();
+    }
+
+  for (uint32_t i = 0; i < channel->GetNDevices (); i++)
+    {
+      Ptr<NetDevice> neighbor = channel->GetDevice (i);
+      if (neighbor == device)
+        {
+          continue;
+        }
+      Ptr<Node> node = neighbor->GetNode ();
+      Ptr<Ipv4L3Protocol> neighborIpv4 = node->GetObject<Ipv4L3Protocol> ();
+      if (arpCache != 0 && neighborIpv4 != 0 && neighborIpv4->GetInterfaceForDevice (neighbor) >= 0)
+        {
+          Ptr<Ipv4Interface> interface = neighborIpv4->GetInterface (neighborIpv4->GetInterfaceForDevice (neighbor));
+          for (uint32_t j = 0; j < interface->GetNAddresses (); j++)
+            {
+              Ipv4Address address = interface->GetAddress (j).GetLocal ();
+              NS_LOG_LOGIC ("Node " << device->GetNode ()->GetId () << ": " << address <<
+                            " at " << neighbor->GetAddress ());
+              ArpCache::Entry *entry = arpCache->Lookup (address);
+              if (entry == 0)
+                {
+                  entry = arpCache->Add (address);
+                }
+              entry->SetMacAddress (neighbor->GetAddress ());
+              entry->MarkPermanent ();
+            }
+        }
+      Ptr<Ipv6L3Protocol> neighborIpv6 = node->GetObject<Ipv6L3Protocol> ();
+      if (ndiscCache != 0 && neighborIpv6 != 0 && neighborIpv6->GetInterfaceForDevice (neighbor) >= 0)
+        {
+          Ptr<Ipv6Interface> interface = neighborIpv6->GetInterface (neighborIpv6->GetInterfaceForDevice (neighbor));
+          for (uint32_t j = 0; j < interface->GetNAddresses (); j++)
+            {
+              Ipv6Address address = interface->GetAddress (j).GetAddress ();
+              NS_LOG_LOGIC ("Node " << device->GetNode ()->GetId () << ": " << address <<
+                            " at " << neighbor->GetAddress ());
+              NdiscCache::Entry *entry = ndiscCache->Lookup (address);
+              if (entry == 0)
+                {
+                  entry = ndiscCache->Add (address);
+                }
+              entry->SetMacAddress (neighbor->GetAddress ());
+              entry->MarkPermanent ();
+            }
+        }
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,76 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef NEIGHBOR_CACHE_HELPER_H
+#define NEIGHBOR_CACHE_HELPER_H
+
+#include "ns3/ptr.h"
+#include "ns3/channel.h"
+#include "ns3/net-device-container.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup internet
+ *
+ * \brief Helper filling the ARP and NDISC caches of the nodes with
+ * permanent entries for their neighbors
+ *
+ * Each interface of a net device needing address resolution gets a
+ * permanent entry, in its ARP cache for IPv4 and in its NDISC cache for
+ * IPv6, for every address of the interfaces of the other net devices on
+ * the same channel.  The packets to these neighbors are then sent without
+ * any ARP request or neighbor solicitation, from the first one on.
+ *
+ * The caches are filled from the addresses assigned when the helper is
+ * called: it is meant to be called once the addresses are assigned (and,
+ * for the IPv6 link-local addresses, once the interfaces are up), before
+ * the simulation starts.  Net devices not needing address resolution,
+ * such as the point-to-point ones, have no cache and are left alone.
+ */
+class NeighborCacheHelper
+{
+public:
+  /**
+   * \brief Fill the caches of the net devices of all the channels
+   */
+  static void PopulateNeighborCache (void);
+
+  /**
+   * \brief Fill the caches of the net devices attached to a channel
+   * \param channel the channel
+   */
+  static void PopulateNeighborCache (Ptr<Channel> channel);
+
+  /**
+   * \brief Fill the caches of net devices with their neighbors on their
+   * channels
+   * \param devices the net devices
+   */
+  static void PopulateNeighborCache (const NetDeviceContainer &devices);
+
+private:
+  /**
+   * \brief Fill the caches of a net device with its neighbors on its
+   * channel
+   * \param device the net device
+   */
+  static void PopulateDevice (Ptr<NetDevice> device);
+};
+
+} // namespace ns3
+
+#endif /* NEIGHBOR_CACHE_HELPER_H */
@@ -199,7 +199,7 @@ ArpCache::HandleWaitReplyTimeout (void)
   bool restartWaitReplyTimer = false;
   for (CacheI i = m_arpCache.begin (); i != m_arpCache.end (); i++) 
     {
-      entry = (*i).second;
+      entry = i->entry;
       if (entry != 0 && entry->IsWaitReply ())
         {
           if (entry->GetRetries () < m_maxRetries)
@@ -246,9 +246,9 @@ ArpCache::Flush (void)
   NS_LOG_FUNCTION (this);
   for (CacheI i = m_arpCache.begin (); i != m_arpCache.end (); i++) 
     {
-      delete (*i).second;
+      delete i->entry;
     }
-  m_arpCache.erase (m_arpCache.begin (), m_arpCache.end ());
+  m_arpCache.Clear ();
   if (m_waitReplyTimer.IsRunning ())
     {
       NS_LOG_LOGIC ("Stopping WaitReplyTimer at " << Simulator::Now ().GetSeconds () << " due to ArpCache flush");
@@ -264,7 +264,7 @@ ArpCache::PrintArpCache (Ptr<OutputStreamWrapper> stream)
 
   for (CacheI i = m_arpCache.begin (); i != m_arpCache.end (); i++)
     {
-      *os << i->first << " dev ";
+      *os << i->address << " dev ";
       std::string found = Names::FindName (m_device);
       if (Names::FindName (m_device) != "")
         {
@@ -275,17 +275,17 @@ ArpCache::PrintArpCache (Ptr<OutputStreamWrapper> stream)
           *os << static_cast<int> (m_device->GetIfIndex ());
         }
 
-      *os << " lladdr " << i->second->GetMacAddress ();
+      *os << " lladdr " << i->entry->GetMacAddress ();
 
-      if (i->second->IsAlive ())
+      if (i->entry->IsAlive ())
         {
           *os << " REACHABLE\n";
         }
-      else if (i->second->IsWaitReply ())
+      else if (i->entry->IsWaitReply ())
         {
           *os << " DELAY\n";
         }
-      else if (i->second->IsPermanent ())
+      else if (i->entry->IsPermanent ())
 	{
 	  *os << " PERMANENT\n";
 	}
@@ -304,7 +304,7 @@ ArpCache::LookupInverse (Address to)
   std::list<ArpCache::Entry *> entryList;
   for (CacheI i = m_arpCache.begin (); i != m_arpCache.end (); i++)
     {
-      ArpCache::Entry *entry = (*i).second;
+      ArpCache::Entry *entry = i->entry;
       if (entry->GetMacAddress () == to)
         {
           entryList.push_back (entry);
@@ -318,22 +318,17 @@ ArpCache::Entry *
 ArpCache::Lookup (Ipv4Address to)
 {
   NS_LOG_FUNCTION (this << to);
-  CacheI it = m_arpCache.find (to);
-  if (it != m_arpCache.end ())
-    {
-      return it->second;
-    }
-  return 0;
+  return m_arpCache.Find (to);
 }
 
 ArpCache::Entry *
 ArpCache::Add (Ipv4Address to)
 {
   NS_LOG_FUNCTION (this << to);
-  NS_ASSERT (m_arpCache.find (to) == m_arpCache.end ());
+  NS_ASSERT (m_arpCache.Find (to) == 0);
 
   ArpCache::Entry *entry = new ArpCache::Entry (this);
-  m_arpCache[to] = entry;
+  m_arpCache.Insert (to, entry);
   entry->SetIpv4Address (to);
   return entry;
 }
@@ -343,16 +338,26 @@ ArpCache::Remove (ArpCache::Entry *entry)
 {
   NS_LOG_FUNCTION (this << entry);
   
-  for (CacheI i = m_arpCache.begin (); i != m_arpCache.end (); i++)
+  Ipv4Address address = entry->GetIpv4Address ();
+  if (m_arpCache.Find (address) != entry)
     {
-      if ((*i).second == entry)
+      // the address of the entry was changed after it was added
+      for (CacheI i = m_arpCache.begin (); i != m_arpCache.end (); i++)
         {
-          m_arpCache.erase (i);
-          entry->ClearPendingPacket (); //clear the pending packets for entry's ipaddress
-          delete entry;
-          return;
+          if (i->entry == entry)
+            {
+              address = i->address;
+              break;
+            }
         }
     }
+  if (m_arpCache.Find (address) == entry)
+    {
+      m_arpCache.Erase (address);
+      entry->ClearPendingPacket (); //clear the pending packets for entry's ipaddress
+      delete entry;
+      return;
+    }
   NS_LOG_WARN ("Entry not found in this ARP Cache");
 }
 
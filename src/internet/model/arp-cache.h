@@ -32,8 +32,8 @@
 #include "ns3/ptr.h"
 #include "ns3/object.h"
 #include "ns3/traced-callback.h"
-#include "ns3/sgi-hashmap.h"
 #include "ns3/output-stream-wrapper.h"
+#include "neighbor-cache-table.h"
 
 namespace ns3 {
 
@@ -319,11 +319,11 @@ private:
   /**
    * \brief ARP Cache container
    */
-  typedef sgi::hash_map<Ipv4Address, ArpCache::Entry *, Ipv4AddressHash> Cache;
+  typedef NeighborCacheTable<Ipv4Address, ArpCache::Entry, Ipv4AddressHash> Cache;
   /**
    * \brief ARP Cache container iterator
    */
-  typedef sgi::hash_map<Ipv4Address, ArpCache::Entry *, Ipv4AddressHash>::iterator CacheI;
+  typedef Cache::Iterator CacheI;
 
   virtual void DoDispose (void);
 
@@ -18,6 +18,7 @@
 
 #include <algorithm>
 #include <iostream>
+#include <vector>
 #include "ns3/log.h"
 #include "ns3/assert.h"
 #include "candidate-queue.h"
@@ -57,16 +58,18 @@ operator<< (std::ostream& os, const CandidateQueue& q)
   for (CIter_t iter = list.begin (); iter != list.end (); iter++)
     {
       os << "<" 
-      << (*iter)->GetVertexId () << ", "
-      << (*iter)->GetDistanceFromRoot () << ", "
-      << (*iter)->GetVertexType () << ">" << std::endl;
+      << iter->second->GetVertexId () << ", "
+      << iter->second->GetDistanceFromRoot () << ", "
+      << iter->second->GetVertexType () << ">" << std::endl;
     }
   os << "*** CandidateQueue End ***";
   return os;
 }
 
 CandidateQueue::CandidateQueue()
-  : m_candidates ()
+  : m_candidates (),
+    m_index (),
+    m_sequence (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -89,16 +92,53 @@ CandidateQueue::Clear (void)
     }
 }
 
+bool
+CandidateQueue::Key::operator< (const Key &other) const
+{
+  if (distance != other.distance)
+    {
+      return distance < other.distance;
+    }
+  if (type != other.type)
+    {
+      return type < other.type;
+    }
+  return sequence < other.sequence;
+}
+
+CandidateQueue::Key
+CandidateQueue::MakeKey (const SPFVertex *v)
+{
+  Key key;
+  key.distance = v->GetDistanceFromRoot ();
+  key.type = v->GetVertexType () == SPFVertex::VertexNetwork ? 0 : 1;
+  key.sequence = m_sequence++;
+  return key;
+}
+
+void
+CandidateQueue::Unindex (const SPFVertex *v)
+{
+  std::pair<CandidateIndex_t::iterator, CandidateIndex_t::iterator> range =
+    m_index.equal_range (v->GetVertexId ());
+  for (CandidateIndex_t::iterator i = range.first; i != range.second; i++)
+    {
+      if (i->second->second == v)
+        {
+          m_index.erase (i);
+          return;
+        }
+    }
+  NS_ASSERT_MSG (false, "Vertex " << v->GetVertexId () << " not in the candidate queue");
+}
+
 void
 CandidateQueue::Push (SPFVertex *vNew)
 {
   NS_LOG_FUNCTION (this << vNew);
 
-  CandidateList_t::iterator i = std::upper_bound (
-      m_candidates.begin (), m_candidates.end (), vNew,
-      &CandidateQueue::CompareSPFVertex
-      );
-  m_candidates.insert (i, vNew);
+  CandidateList_t::iterator i = m_candidates.insert (std::make_pair (MakeKey (vNew), vNew)).first;
+  m_index.insert (std::make_pair (vNew->GetVertexId (), i));
 }
 
 SPFVertex *
@@ -110,8 +150,9 @@ CandidateQueue::Pop (void)
       return 0;
     }
 
-  SPFVertex *v = m_candidates.front ();
-  m_candidates.pop_front ();
+  SPFVertex *v = m_candidates.begin ()->second;
+  Unindex (v);
+  m_candidates.erase (m_candidates.begin ());
   return v;
 }
 
@@ -124,7 +165,7 @@ CandidateQueue::Top (void) const
       return 0;
     }
 
-  return m_candidates.front ();
+  return m_candidates.begin ()->second;
 }
 
 bool
@@ -145,18 +186,22 @@ SPFVertex *
 CandidateQueue::Find (const Ipv4Address addr) const
 {
   NS_LOG_FUNCTION (this);
-  CandidateList_t::const_iterator i = m_candidates.begin ();
-
-  for (; i != m_candidates.end (); i++)
+  // The first vertex of this ID in the queue order
+  std::pair<CandidateIndex_t::const_iterator, CandidateIndex_t::const_iterator> range =
+    m_index.equal_range (addr);
+  CandidateIndex_t::const_iterator first = range.first;
+  for (CandidateIndex_t::const_iterator i = range.first; i != range.second; i++)
     {
-      SPFVertex *v = *i;
-      if (v->GetVertexId () == addr)
+      if (i->second->first < first->second->first)
         {
-          return v;
+          first = i;
         }
     }
-
-  return 0;
+  if (first == range.second)
+    {
+      return 0;
+    }
+  return first->second->second;
 }
 
 void
@@ -164,11 +209,45 @@ CandidateQueue::Reorder (void)
 {
   NS_LOG_FUNCTION (this);
 
-  m_candidates.sort (&CandidateQueue::CompareSPFVertex);
+  // Sort the vertices stably, as a list, then key them in the new order
+  std::vector<SPFVertex *> vertices;
+  vertices.reserve (m_candidates.size ());
+  for (CandidateList_t::const_iterator i = m_candidates.begin (); i != m_candidates.end (); i++)
+    {
+      vertices.push_back (i->second);
+    }
+  std::stable_sort (vertices.begin (), vertices.end (), &CandidateQueue::CompareSPFVertex);
+  m_candidates.clear ();
+  m_index.clear ();
+  for (std::vector<SPFVertex *>::const_iterator i = vertices.begin (); i != vertices.end (); i++)
+    {
+      Push (*i);
+    }
   NS_LOG_LOGIC ("After reordering the CandidateQueue");
   NS_LOG_LOGIC (*this);
 }
 
+void
+CandidateQueue::Reorder (SPFVertex *v)
+{
+  NS_LOG_FUNCTION (this << v);
+
+  std::pair<CandidateIndex_t::iterator, CandidateIndex_t::iterator> range =
+    m_index.equal_range (v->GetVertexId ());
+  for (CandidateIndex_t::iterator i = range.first; i != range.second; i++)
+    {
+      if (i->second->second == v)
+        {
+          m_candidates.erase (i->second);
+          i->second = m_candidates.insert (std::make_pair (MakeKey (v), v)).first;
+          NS_LOG_LOGIC ("After reordering the CandidateQueue");
+          NS_LOG_LOGIC (*this);
+          return;
+        }
+    }
+  NS_ASSERT_MSG (false, "Vertex " << v->GetVertexId () << " not in the candidate queue");
+}
+
 /*
  * In this implementation, SPFVertex follows the ordering where
  * a vertex is ranked first if its GetDistanceFromRoot () is smaller;
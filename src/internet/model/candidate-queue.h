@@ -22,7 +22,7 @@
 #define CANDIDATE_QUEUE_H
 
 #include <stdint.h>
-#include <list>
+#include <map>
 #include "ns3/ipv4-address.h"
 
 namespace ns3 {
@@ -47,6 +47,12 @@ class SPFVertex;
  * for a Find () operation, the dynamic nature of the data and the derived
  * requirement for a Reorder () operation led us to implement this simple 
  * enhanced priority queue.
+ *
+ * The vertices are kept in an ordered map keyed by their distance, their
+ * type and their order of arrival, and indexed by vertex ID, so that Push (),
+ * Pop (), Find () and the Reorder () of a single vertex take a logarithmic
+ * time.  Vertices of equal priority are popped in the order in which they
+ * were pushed or last moved, as from a sorted list.
  */
 class CandidateQueue
 {
@@ -154,6 +160,19 @@ public:
  */
   void Reorder (void);
 
+/**
+ * @brief Moves a Shortest Path First Vertex whose distance decreased to
+ * its new place in the Candidate Queue.
+ *
+ * This gives the same order as Reorder (void), for a vertex whose
+ * m_distanceFromRoot decreased since it was pushed: among the vertices of
+ * its new priority, it is placed last.
+ *
+ * @see SPFVertex
+ * @param v The Shortest Path First Vertex, already in the queue.
+ */
+  void Reorder (SPFVertex *v);
+
 private:
 /**
  * Candidate Queue copy construction is disallowed (not implemented) to 
@@ -184,8 +203,39 @@ private:
  */
   static bool CompareSPFVertex (const SPFVertex* v1, const SPFVertex* v2);
 
-  typedef std::list<SPFVertex*> CandidateList_t; //!< container of SPFVertex pointers
+  /**
+   * \brief The priority of a vertex in the queue
+   */
+  struct Key
+  {
+    uint32_t distance; //!< distance from the root
+    uint32_t type;     //!< 0 for a network vertex, 1 otherwise
+    uint64_t sequence; //!< order of arrival, among equal priorities
+
+    /**
+     * \param other the key to compare with
+     * \return true if this key is popped before the other one
+     */
+    bool operator< (const Key &other) const;
+  };
+
+  /**
+   * \param v a vertex
+   * \return the key of the vertex, as it would be pushed now
+   */
+  Key MakeKey (const SPFVertex *v);
+
+  /**
+   * \brief Remove a vertex from the index by vertex ID
+   * \param v the vertex
+   */
+  void Unindex (const SPFVertex *v);
+
+  typedef std::map<Key, SPFVertex*> CandidateList_t; //!< container of SPFVertex pointers, in priority order
+  typedef std::multimap<Ipv4Address, CandidateList_t::iterator> CandidateIndex_t; //!< vertices by vertex ID
   CandidateList_t m_candidates;  //!< SPFVertex candidates
+  CandidateIndex_t m_index;      //!< SPFVertex candidates by vertex ID
+  uint64_t m_sequence;           //!< order of arrival of the next key
 
   /**
    * \brief Stream insertion operator.
@@ -26,15 +26,24 @@
 #include <vector>
 #include <queue>
 #include <algorithm>
+#include <functional>
 #include <iostream>
 #include "ns3/assert.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
 #include "ns3/node-list.h"
+#include "ns3/node.h"
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/ipv4-list-routing.h"
 #include "ns3/mpi-interface.h"
+#include "ns3/global-value.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/core-config.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-thread.h"
+#endif
 #include "global-router-interface.h"
 #include "global-route-manager-impl.h"
 #include "candidate-queue.h"
@@ -44,6 +53,32 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("GlobalRouteManagerImpl");
 
+/**
+ * \brief The number of threads computing the routes of the routers.
+ *
+ * The routes do not depend on it.  Beyond one thread, the log output of
+ * the threads interleave.
+ */
+static GlobalValue g_globalRoutingThreads ("GlobalRoutingThreads",
+                                           "The number of threads computing the global routes "
+                                           "(one SPF per router at a time)",
+                                           UintegerValue (1),
+                                           MakeUintegerChecker<uint32_t> (1));
+
+/**
+ * \brief Whether to keep the SPF tree of each router, to update it when the
+ * routes are computed again rather than calculating it from scratch.
+ *
+ * The routes do not depend on it.  The trees take memory quadratic in the
+ * number of routers.
+ */
+static GlobalValue g_globalRoutingIncrementalSpf ("GlobalRoutingIncrementalSpf",
+                                                  "Whether to keep the SPF tree of each router, so that "
+                                                  "recomputing the global routes only updates the vertices "
+                                                  "the changes of the topology reach",
+                                                  BooleanValue (false),
+                                                  MakeBooleanChecker ());
+
 /**
  * \brief Stream insertion operator.
  *
@@ -94,7 +129,9 @@ SPFVertex::SPFVertex () :
   m_nextHop ("0.0.0.0"),
   m_parents (),
   m_children (),
-  m_vertexProcessed (false)
+  m_vertexProcessed (false),
+  m_firstParent (0),
+  m_firstLink (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -107,7 +144,9 @@ SPFVertex::SPFVertex (GlobalRoutingLSA* lsa) :
   m_nextHop ("0.0.0.0"),
   m_parents (),
   m_children (),
-  m_vertexProcessed (false)
+  m_vertexProcessed (false),
+  m_firstParent (0),
+  m_firstLink (0)
 {
   NS_LOG_FUNCTION (this << lsa);
 
@@ -274,6 +313,28 @@ SPFVertex::MergeParent (const SPFVertex* v)
   NS_LOG_LOGIC ("After merge, list of parents = " << m_parents);
 }
 
+void
+SPFVertex::SetFirstParent (SPFVertex* parent, uint32_t link)
+{
+  NS_LOG_FUNCTION (this << parent << link);
+  m_firstParent = parent;
+  m_firstLink = link;
+}
+
+SPFVertex*
+SPFVertex::GetFirstParent (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_firstParent;
+}
+
+uint32_t
+SPFVertex::GetFirstLink (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_firstLink;
+}
+
 void 
 SPFVertex::SetRootExitDirection (Ipv4Address nextHop, int32_t id)
 {
@@ -414,6 +475,33 @@ SPFVertex::ClearVertexProcessed (void)
   this->SetVertexProcessed (false);
 }
 
+bool
+SPFVertexOrder::operator() (const SPFVertex* v1, const SPFVertex* v2) const
+{
+  while (v1 != v2)
+    {
+      if (v1->GetDistanceFromRoot () != v2->GetDistanceFromRoot ())
+        {
+          return v1->GetDistanceFromRoot () < v2->GetDistanceFromRoot ();
+        }
+      if (v1->GetVertexType () != v2->GetVertexType ())
+        {
+          return v1->GetVertexType () == SPFVertex::VertexNetwork;
+        }
+      if (v1->GetFirstParent () == v2->GetFirstParent ())
+        {
+          return v1->GetFirstLink () < v2->GetFirstLink ();
+        }
+//
+// Reached at the same distance through different parents: the parent that
+// joined the tree first pushed its child first.
+//
+      v1 = v1->GetFirstParent ();
+      v2 = v2->GetFirstParent ();
+    }
+  return false;
+}
+
 // ---------------------------------------------------------------------------
 //
 // GlobalRouteManagerLSDB Implementation
@@ -423,6 +511,8 @@ SPFVertex::ClearVertexProcessed (void)
 GlobalRouteManagerLSDB::GlobalRouteManagerLSDB ()
   :
     m_database (),
+    m_linkData (),
+    m_linkDataValid (false),
     m_extdatabase ()
 {
   NS_LOG_FUNCTION (this);
@@ -458,6 +548,25 @@ GlobalRouteManagerLSDB::Initialize ()
       GlobalRoutingLSA* temp = i->second;
       temp->SetStatus (GlobalRoutingLSA::LSA_SPF_NOT_EXPLORED);
     }
+  if (m_linkDataValid)
+    {
+      return;
+    }
+  m_linkData.clear ();
+  for (i = m_database.begin (); i != m_database.end (); i++)
+    {
+      GlobalRoutingLSA* temp = i->second;
+      for (uint32_t j = 0; j < temp->GetNLinkRecords (); j++)
+        {
+          GlobalRoutingLinkRecord *lr = temp->GetLinkRecord (j);
+          if (lr->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork)
+            {
+              // The first LSA of the database wins, as in a walk of it
+              m_linkData.insert (std::make_pair (lr->GetLinkData (), i));
+            }
+        }
+    }
+  m_linkDataValid = true;
 }
 
 void
@@ -471,6 +580,7 @@ GlobalRouteManagerLSDB::Insert (Ipv4Address addr, GlobalRoutingLSA* lsa)
   else
     {
       m_database.insert (LSDBPair_t (addr, lsa));
+      m_linkDataValid = false;
     }
 }
 
@@ -495,13 +605,10 @@ GlobalRouteManagerLSDB::GetLSA (Ipv4Address addr) const
 //
 // Look up an LSA by its address.
 //
-  LSDBMap_t::const_iterator i;
-  for (i= m_database.begin (); i!= m_database.end (); i++)
+  LSDBMap_t::const_iterator i = m_database.find (addr);
+  if (i != m_database.end ())
     {
-      if (i->first == addr)
-        {
-          return i->second;
-        }
+      return i->second;
     }
   return 0;
 }
@@ -513,6 +620,15 @@ GlobalRouteManagerLSDB::GetLSAByLinkData (Ipv4Address addr) const
 //
 // Look up an LSA by its address.
 //
+  if (m_linkDataValid)
+    {
+      LinkDataMap_t::const_iterator j = m_linkData.find (addr);
+      if (j != m_linkData.end ())
+        {
+          return j->second->second;
+        }
+      return 0;
+    }
   LSDBMap_t::const_iterator i;
   for (i= m_database.begin (); i!= m_database.end (); i++)
     {
@@ -531,6 +647,99 @@ GlobalRouteManagerLSDB::GetLSAByLinkData (Ipv4Address addr) const
   return 0;
 }
 
+std::vector<Ipv4Address>
+GlobalRouteManagerLSDB::GetLinkStateIds (void) const
+{
+  NS_LOG_FUNCTION (this);
+  std::vector<Ipv4Address> ids;
+  ids.reserve (m_database.size ());
+  for (LSDBMap_t::const_iterator i = m_database.begin (); i != m_database.end (); i++)
+    {
+      ids.push_back (i->first);
+    }
+  return ids;
+}
+
+/**
+ * \brief Compare the contents of two LSAs
+ *
+ * \param a first LSA
+ * \param b second LSA
+ * \returns true if the LSAs advertise the same links
+ */
+static bool
+SameLSA (const GlobalRoutingLSA *a, const GlobalRoutingLSA *b)
+{
+  if (a->GetLSType () != b->GetLSType ()
+      || a->GetLinkStateId () != b->GetLinkStateId ()
+      || a->GetAdvertisingRouter () != b->GetAdvertisingRouter ()
+      || a->GetNetworkLSANetworkMask () != b->GetNetworkLSANetworkMask ()
+      || a->GetNode () != b->GetNode ()
+      || a->GetNLinkRecords () != b->GetNLinkRecords ()
+      || a->GetNAttachedRouters () != b->GetNAttachedRouters ())
+    {
+      return false;
+    }
+  for (uint32_t i = 0; i < a->GetNLinkRecords (); i++)
+    {
+      GlobalRoutingLinkRecord *la = a->GetLinkRecord (i);
+      GlobalRoutingLinkRecord *lb = b->GetLinkRecord (i);
+      if (la->GetLinkType () != lb->GetLinkType ()
+          || la->GetLinkId () != lb->GetLinkId ()
+          || la->GetLinkData () != lb->GetLinkData ()
+          || la->GetMetric () != lb->GetMetric ())
+        {
+          return false;
+        }
+    }
+  for (uint32_t i = 0; i < a->GetNAttachedRouters (); i++)
+    {
+      if (a->GetAttachedRouter (i) != b->GetAttachedRouter (i))
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+std::set<Ipv4Address>
+GlobalRouteManagerLSDB::ReuseUnchanged (GlobalRouteManagerLSDB &previous)
+{
+  NS_LOG_FUNCTION (this << &previous);
+  std::set<Ipv4Address> changed;
+  LSDBMap_t::iterator i = m_database.begin ();
+  LSDBMap_t::iterator j = previous.m_database.begin ();
+  while (i != m_database.end () || j != previous.m_database.end ())
+    {
+      if (j == previous.m_database.end ()
+          || (i != m_database.end () && i->first < j->first))
+        {
+          changed.insert (i->first);
+          i++;
+        }
+      else if (i == m_database.end () || j->first < i->first)
+        {
+          changed.insert (j->first);
+          j++;
+        }
+      else
+        {
+          if (SameLSA (i->second, j->second))
+            {
+              // The index of the link data points to the entries, not to the LSAs
+              std::swap (i->second, j->second);
+            }
+          else
+            {
+              changed.insert (i->first);
+            }
+          i++;
+          j++;
+        }
+    }
+  return changed;
+}
+
 // ---------------------------------------------------------------------------
 //
 // GlobalRouteManagerImpl Implementation
@@ -539,7 +748,13 @@ GlobalRouteManagerLSDB::GetLSAByLinkData (Ipv4Address addr) const
 
 GlobalRouteManagerImpl::GlobalRouteManagerImpl () 
   :
-    m_spfroot (0)
+    m_spfroot (0),
+    m_previousLsdb (0),
+    m_tree (0),
+    m_batch (0),
+    m_batchFirst (0),
+    m_batchStep (1),
+    m_changes (0)
 {
   NS_LOG_FUNCTION (this);
   m_lsdb = new GlobalRouteManagerLSDB ();
@@ -548,6 +763,7 @@ GlobalRouteManagerImpl::GlobalRouteManagerImpl ()
 GlobalRouteManagerImpl::~GlobalRouteManagerImpl ()
 {
   NS_LOG_FUNCTION (this);
+  DeleteTrees ();
   if (m_lsdb)
     {
       delete m_lsdb;
@@ -558,6 +774,7 @@ void
 GlobalRouteManagerImpl::DebugUseLsdb (GlobalRouteManagerLSDB* lsdb)
 {
   NS_LOG_FUNCTION (this << lsdb);
+  DeleteTrees ();
   if (m_lsdb)
     {
       delete m_lsdb;
@@ -565,6 +782,49 @@ GlobalRouteManagerImpl::DebugUseLsdb (GlobalRouteManagerLSDB* lsdb)
   m_lsdb = lsdb;
 }
 
+void
+GlobalRouteManagerImpl::DeleteTrees (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (SPFTrees_t::iterator i = m_trees.begin (); i != m_trees.end (); i++)
+    {
+      ClearTree (i->second);
+      delete i->second;
+    }
+  m_trees.clear ();
+  m_graph.clear ();
+  if (m_previousLsdb)
+    {
+      delete m_previousLsdb;
+      m_previousLsdb = 0;
+    }
+}
+
+void
+GlobalRouteManagerImpl::ClearTree (SPFTree* tree)
+{
+  NS_LOG_FUNCTION (tree);
+//
+// Deleting the root deletes all of its descendants.
+//
+  delete tree->root;
+  tree->root = 0;
+  tree->vertices.clear ();
+  tree->order.clear ();
+}
+
+SPFVertex*
+GlobalRouteManagerImpl::FindVertex (const SPFTree* tree, Ipv4Address id)
+{
+  std::map<Ipv4Address, std::pair<SPFVertex*, SPFOrder_t::iterator> >::const_iterator i =
+    tree->vertices.find (id);
+  if (i == tree->vertices.end ())
+    {
+      return 0;
+    }
+  return i->second.first;
+}
+
 void
 GlobalRouteManagerImpl::DeleteGlobalRoutes ()
 {
@@ -595,7 +855,15 @@ GlobalRouteManagerImpl::DeleteGlobalRoutes ()
   if (m_lsdb)
     {
       NS_LOG_LOGIC ("Deleting LSDB, creating new one");
-      delete m_lsdb;
+      if (!m_trees.empty () && m_previousLsdb == 0)
+        {
+          // The SPF trees point to its LSAs until InitializeRoutes () updates them
+          m_previousLsdb = m_lsdb;
+        }
+      else
+        {
+          delete m_lsdb;
+        }
       m_lsdb = new GlobalRouteManagerLSDB ();
     }
 }
@@ -700,6 +968,7 @@ GlobalRouteManagerImpl::InitializeRoutes ()
 // Walk the list of nodes in the system.
 //
   NS_LOG_INFO ("About to start SPF calculation");
+  SPFRoots_t roots;
   NodeList::Iterator listEnd = NodeList::End ();
   for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
     {
@@ -724,12 +993,191 @@ GlobalRouteManagerImpl::InitializeRoutes ()
 //
       if (rtr && rtr->GetNumLSAs () )
         {
-          SPFCalculate (rtr->GetRouterId ());
+          SPFRoot r;
+          r.id = rtr->GetRouterId ();
+          r.node = node;
+          r.tree = 0;
+          roots.push_back (r);
         }
     }
+  m_lsdb->Initialize ();
+//
+// With incremental SPF, each router keeps its SPF tree.  The trees point to
+// the LSAs of the previous LSDB: the unchanged ones move to the new LSDB,
+// and the trees are updated with the others.
+//
+  BooleanValue incremental;
+  g_globalRoutingIncrementalSpf.GetValue (incremental);
+  SPFChanges changes;
+  changes.graph = 0;
+  SPFGraph_t graph;
+  bool keepTrees = incremental.Get () && BuildSPFGraph (graph);
+  if (keepTrees && m_previousLsdb != 0)
+    {
+      changes.lsas = m_lsdb->ReuseUnchanged (*m_previousLsdb);
+      SPFGraph_t::const_iterator i = m_graph.begin ();
+      SPFGraph_t::const_iterator j = graph.begin ();
+      while (i != m_graph.end () || j != graph.end ())
+        {
+          if (j == graph.end () || (i != m_graph.end () && i->first < j->first))
+            {
+              changes.edges.insert (i->first);
+              i++;
+            }
+          else if (i == m_graph.end () || j->first < i->first)
+            {
+              changes.edges.insert (j->first);
+              j++;
+            }
+          else
+            {
+              if (!(i->second == j->second))
+                {
+                  changes.edges.insert (i->first);
+                }
+              i++;
+              j++;
+            }
+        }
+      for (j = graph.begin (); j != graph.end (); j++)
+        {
+          for (std::vector<SPFEdge>::const_iterator e = j->second.begin (); e != j->second.end (); e++)
+            {
+              SPFEdge r = *e;
+              r.vertex = j->first;
+              changes.reverse[e->vertex].push_back (r);
+            }
+        }
+      changes.graph = &graph;
+      m_changes = &changes;
+      NS_LOG_INFO ("Updating the SPF trees with " << changes.lsas.size () << " LSAs and the edges of "
+                   << changes.edges.size () << " vertices changed");
+    }
+  else
+    {
+      DeleteTrees ();
+    }
+  if (keepTrees)
+    {
+      SPFTrees_t trees;
+      for (SPFRoots_t::iterator r = roots.begin (); r != roots.end (); r++)
+        {
+          SPFTrees_t::iterator t = m_trees.find (r->id);
+          if (t == m_trees.end ())
+            {
+              r->tree = new SPFTree;
+              r->tree->root = 0;
+            }
+          else
+            {
+              r->tree = t->second;
+              m_trees.erase (t);
+            }
+          trees[r->id] = r->tree;
+        }
+      // The routers that are gone
+      for (SPFTrees_t::iterator t = m_trees.begin (); t != m_trees.end (); t++)
+        {
+          ClearTree (t->second);
+          delete t->second;
+        }
+      m_trees.swap (trees);
+    }
+//
+// Each SPF only writes to the forwarding table of its root, so the SPFs of
+// different roots can run in parallel over the (read-only) LSDB.
+//
+  UintegerValue nThreads;
+  g_globalRoutingThreads.GetValue (nThreads);
+  uint32_t threads = std::min<uint32_t> (nThreads.Get (), roots.size ());
+#ifdef HAVE_PTHREAD_H
+  if (threads > 1)
+    {
+      NS_LOG_INFO ("Calculating " << roots.size () << " SPFs in " << threads << " threads");
+      std::vector<GlobalRouteManagerImpl *> workers;
+      std::vector<Ptr<SystemThread> > systemThreads;
+      for (uint32_t t = 0; t < threads; t++)
+        {
+          GlobalRouteManagerImpl *worker = new GlobalRouteManagerImpl ();
+          delete worker->m_lsdb;
+          worker->m_lsdb = m_lsdb;
+          worker->m_batch = &roots;
+          worker->m_batchFirst = t;
+          worker->m_batchStep = threads;
+          worker->m_changes = m_changes;
+          workers.push_back (worker);
+          systemThreads.push_back (Create<SystemThread> (MakeCallback (&GlobalRouteManagerImpl::SPFCalculateBatch, worker)));
+          systemThreads.back ()->Start ();
+        }
+      for (uint32_t t = 0; t < threads; t++)
+        {
+          systemThreads[t]->Join ();
+          workers[t]->m_lsdb = 0;
+          delete workers[t];
+        }
+    }
+  else
+#endif /* HAVE_PTHREAD_H */
+    {
+      m_batch = &roots;
+      m_batchFirst = 0;
+      m_batchStep = 1;
+      SPFCalculateBatch ();
+      m_batch = 0;
+    }
+  m_changes = 0;
+  if (keepTrees)
+    {
+      m_graph.swap (graph);
+    }
+  if (m_previousLsdb)
+    {
+      // Only the LSAs the trees no longer point to are left in it
+      delete m_previousLsdb;
+      m_previousLsdb = 0;
+    }
   NS_LOG_INFO ("Finished SPF calculation");
 }
 
+void
+GlobalRouteManagerImpl::SPFCalculateBatch (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (uint32_t i = m_batchFirst; i < m_batch->size (); i += m_batchStep)
+    {
+      const SPFRoot &r = (*m_batch)[i];
+      if (r.tree != 0 && r.tree->root != 0 && m_changes != 0 && m_changes->lsas.count (r.id) == 0)
+        {
+          SPFUpdate (r.id, r.node, r.tree);
+          continue;
+        }
+      if (r.tree != 0)
+        {
+          ClearTree (r.tree);
+        }
+      m_tree = r.tree;
+      SPFCalculate (r.id, r.node);
+      m_tree = 0;
+    }
+}
+
+GlobalRoutingLSA::SPFStatus
+GlobalRouteManagerImpl::GetLSAStatus (const GlobalRoutingLSA *lsa) const
+{
+  LSAStatusMap_t::const_iterator i = m_lsaStatus.find (lsa);
+  if (i == m_lsaStatus.end ())
+    {
+      return GlobalRoutingLSA::LSA_SPF_NOT_EXPLORED;
+    }
+  return i->second;
+}
+
+void
+GlobalRouteManagerImpl::SetLSAStatus (const GlobalRoutingLSA *lsa, GlobalRoutingLSA::SPFStatus status)
+{
+  m_lsaStatus[lsa] = status;
+}
+
 //
 // This method is derived from quagga ospf_spf_next ().  See RFC2328 Section 
 // 16.1 (2) for further details.
@@ -836,7 +1284,7 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
 // If the link is to a router that is already in the shortest path first tree
 // then we have it covered -- ignore it.
 //
-      if (w_lsa->GetStatus () == GlobalRoutingLSA::LSA_SPF_IN_SPFTREE) 
+      if (GetLSAStatus (w_lsa) == GlobalRoutingLSA::LSA_SPF_IN_SPFTREE) 
         {
           NS_LOG_LOGIC ("Skipping ->  LSA "<< 
                         w_lsa->GetLinkStateId () << " already in SPF tree");
@@ -861,7 +1309,7 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
       NS_LOG_LOGIC ("Considering w_lsa " << w_lsa->GetLinkStateId ());
 
 // Is there already vertex w in candidate list?
-      if (w_lsa->GetStatus () == GlobalRoutingLSA::LSA_SPF_NOT_EXPLORED)
+      if (GetLSAStatus (w_lsa) == GlobalRoutingLSA::LSA_SPF_NOT_EXPLORED)
         {
 // Calculate nexthop to w
 // We need to figure out how to actually get to the new router represented
@@ -873,7 +1321,8 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
           w = new SPFVertex (w_lsa);
           if (SPFNexthopCalculation (v, w, l, distance))
             {
-              w_lsa->SetStatus (GlobalRoutingLSA::LSA_SPF_CANDIDATE);
+              w->SetFirstParent (v, i);
+              SetLSAStatus (w_lsa, GlobalRoutingLSA::LSA_SPF_CANDIDATE);
 //
 // Push this new vertex onto the priority queue (ordered by distance from the
 // root node).
@@ -888,7 +1337,7 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
             NS_ASSERT_MSG (0, "SPFNexthopCalculation never " 
                            << "return false, but it does now!");
         }
-      else if (w_lsa->GetStatus () == GlobalRoutingLSA::LSA_SPF_CANDIDATE)
+      else if (GetLSAStatus (w_lsa) == GlobalRoutingLSA::LSA_SPF_CANDIDATE)
         {
 //
 // We have already considered the link represented by <w>.  What wse have to
@@ -956,11 +1405,12 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
 //
               if (SPFNexthopCalculation (v, cw, l, distance))
                 {
+                  cw->SetFirstParent (v, i);
 //
 // If we've changed the cost to get to the vertex represented by <w>, we 
 // must reorder the priority queue keyed to that cost.
 //
-                  candidate.Reorder ();
+                  candidate.Reorder (cw);
                 }
             } // new lower cost path found
         } // end W is already on the candidate list
@@ -1320,11 +1770,8 @@ GlobalRouteManagerImpl::CheckForStubNode (Ipv4Address root)
               if (lr->GetLinkId () == myRouterId)
                 {
                   // Next hop is stored in the LinkID field of lr
-                  Ptr<GlobalRouter> router = rlsa->GetNode ()->GetObject<GlobalRouter> ();
-                  NS_ASSERT (router);
-                  Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-                  NS_ASSERT (gr);
-                  gr->AddNetworkRouteTo (Ipv4Address ("0.0.0.0"), Ipv4Mask ("0.0.0.0"), lr->GetLinkData (), 
+                  NS_ASSERT (m_spfrootRouting);
+                  m_spfrootRouting->AddNetworkRouteTo (Ipv4Address ("0.0.0.0"), Ipv4Mask ("0.0.0.0"), lr->GetLinkData (), 
                                          FindOutgoingInterfaceId (transitLink->GetLinkData ()));
                   NS_LOG_LOGIC ("Inserting default route for node " << myRouterId << " to next hop " << 
                                 lr->GetLinkData () << " via interface " << 
@@ -1337,17 +1784,68 @@ GlobalRouteManagerImpl::CheckForStubNode (Ipv4Address root)
   return false;
 }
 
+//
+// The routes are written to the node at the root of the tree.  Routing
+// information is updated using its Ipv4 interface and its GlobalRouter: if
+// the node is acting as an IP version 4 router, it should absolutely have
+// both.
+//
+void
+GlobalRouteManagerImpl::SPFSetRootNode (Ptr<Node> node)
+{
+  NS_LOG_FUNCTION (this << node);
+  m_spfrootNode = node;
+  m_spfrootIpv4 = 0;
+  m_spfrootRouting = 0;
+  if (node != 0)
+    {
+      m_spfrootIpv4 = node->GetObject<Ipv4> ();
+      NS_ASSERT_MSG (m_spfrootIpv4, 
+                     "GlobalRouteManagerImpl::SPFCalculate (): "
+                     "GetObject for <Ipv4> interface failed");
+      Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
+      NS_ASSERT (router);
+      m_spfrootRouting = router->GetRoutingProtocol ();
+      NS_ASSERT (m_spfrootRouting);
+    }
+}
+
 // quagga ospf_spf_calculate
 void
 GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 {
   NS_LOG_FUNCTION (this << root);
-
-  SPFVertex *v;
+//
+// Find the node of the root, if there is one, by its router ID.
+//
+  Ptr<Node> rootNode = 0;
+  NodeList::Iterator listEnd = NodeList::End ();
+  for (NodeList::Iterator i = NodeList::Begin (); i != listEnd && rootNode == 0; i++)
+    {
+      Ptr<GlobalRouter> rtr = (*i)->GetObject<GlobalRouter> ();
+      if (rtr != 0 && rtr->GetRouterId () == root)
+        {
+          rootNode = *i;
+        }
+    }
 //
 // Initialize the Link State Database.
 //
   m_lsdb->Initialize ();
+  SPFCalculate (root, rootNode);
+}
+
+void
+GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root, Ptr<Node> node)
+{
+  NS_LOG_FUNCTION (this << root << node);
+
+  SPFVertex *v;
+  SPFSetRootNode (node);
+//
+// No LSA has been explored yet.
+//
+  m_lsaStatus.clear ();
 //
 // The candidate queue is a priority queue of SPFVertex objects, with the top
 // of the queue being the closest vertex in terms of distance from the root
@@ -1367,7 +1865,7 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 //
   m_spfroot= v;
   v->SetDistanceFromRoot (0);
-  v->GetLSA ()->SetStatus (GlobalRoutingLSA::LSA_SPF_IN_SPFTREE);
+  SetLSAStatus (v->GetLSA (), GlobalRoutingLSA::LSA_SPF_IN_SPFTREE);
   NS_LOG_LOGIC ("Starting SPFCalculate for node " << root);
 
 //
@@ -1377,12 +1875,21 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 // reached.  Instead, short-circuit this computation and just install
 // a default route in the CheckForStubNode() method.
 //
-  if (NodeList::GetNNodes () > 0 && CheckForStubNode (root))
+  if (m_spfrootNode != 0 && CheckForStubNode (root))
     {
       NS_LOG_LOGIC ("SPFCalculate truncated for stub node " << root);
       delete m_spfroot;
+      m_spfroot = 0;
+      m_spfrootNode = 0;
+      m_spfrootIpv4 = 0;
+      m_spfrootRouting = 0;
       return;
     }
+  if (m_tree != 0)
+    {
+      m_tree->root = v;
+      m_tree->vertices[v->GetVertexId ()] = std::make_pair (v, m_tree->order.insert (v).first);
+    }
 
   for (;;)
     {
@@ -1428,7 +1935,7 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 // Update the status field of the vertex to indicate that it is in the SPF
 // tree.
 //
-      v->GetLSA ()->SetStatus (GlobalRoutingLSA::LSA_SPF_IN_SPFTREE);
+      SetLSAStatus (v->GetLSA (), GlobalRoutingLSA::LSA_SPF_IN_SPFTREE);
 //
 // The current vertex has a parent pointer.  By calling this rather oddly 
 // named method (blame quagga) we add the current vertex to the list of 
@@ -1437,6 +1944,11 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 // to now.
 //
       SPFVertexAddParent (v);
+      if (m_tree != 0)
+        {
+          m_tree->vertices[v->GetVertexId ()] =
+            std::make_pair (v, m_tree->order.insert (m_tree->order.end (), v));
+        }
 //
 // Note that when there is a choice of vertices closest to the root, network
 // vertices must be chosen before router vertices in order to necessarily
@@ -1444,12 +1956,11 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 //
 // RFC2328 16.1. (4). 
 //
-// This is the method that actually adds the routes.  It'll walk the list
-// of nodes in the system, looking for the node corresponding to the router
-// ID of the root of the tree -- that is the router we're building the routes
-// for.  It looks for the Ipv4 interface of that node and remembers it.  So
-// we are only actually adding routes to that one node at the root of the SPF 
-// tree.
+// This is the method that actually adds the routes.  It writes to the node
+// corresponding to the router ID of the root of the tree -- that is the
+// router we're building the routes for -- which was looked up when the
+// calculation started.  So we are only actually adding routes to that one
+// node at the root of the SPF tree.
 //
 // We're going to pop of a pointer to every vertex in the tree except the 
 // root in order of distance from the root.  For each of the vertices, we call
@@ -1497,33 +2008,507 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 
 //
 // We're all done setting the routing information for the node at the root of
-// the SPF tree.  Delete all of the vertices and corresponding resources.  Go
-// possibly do it again for the next router.
+// the SPF tree.  Delete all of the vertices and corresponding resources,
+// unless the tree is kept.  Go possibly do it again for the next router.
 //
-  delete m_spfroot;
+  if (m_tree == 0)
+    {
+      delete m_spfroot;
+    }
   m_spfroot = 0;
+  m_spfrootNode = 0;
+  m_spfrootIpv4 = 0;
+  m_spfrootRouting = 0;
 }
 
-void
-GlobalRouteManagerImpl::ProcessASExternals (SPFVertex* v, GlobalRoutingLSA* extlsa)
+bool
+GlobalRouteManagerImpl::SPFEdge::operator== (const SPFEdge &o) const
 {
-  NS_LOG_FUNCTION (this << v << extlsa);
-  NS_LOG_LOGIC ("Processing external for destination " << 
-                extlsa->GetLinkStateId () <<
-                ", for router "  << v->GetVertexId () <<
-                ", advertised by " << extlsa->GetAdvertisingRouter ());
-  if (v->GetVertexType () == SPFVertex::VertexRouter)
+  return vertex == o.vertex && link == o.link && cost == o.cost;
+}
+
+//
+// The edges SPFNext () walks from each vertex: the transit links of a router
+// and the attached routers of a network.
+//
+bool
+GlobalRouteManagerImpl::BuildSPFGraph (SPFGraph_t &graph) const
+{
+  NS_LOG_FUNCTION (this);
+  bool positive = true;
+  std::vector<Ipv4Address> ids = m_lsdb->GetLinkStateIds ();
+  for (std::vector<Ipv4Address>::const_iterator i = ids.begin (); i != ids.end (); i++)
     {
-      GlobalRoutingLSA *rlsa = v->GetLSA ();
-      NS_LOG_LOGIC ("Processing router LSA with id " << rlsa->GetLinkStateId ());
-      if ((rlsa->GetLinkStateId ()) == (extlsa->GetAdvertisingRouter ()))
+      GlobalRoutingLSA *lsa = m_lsdb->GetLSA (*i);
+      std::vector<SPFEdge> &edges = graph[*i];
+      SPFEdge e;
+      if (lsa->GetLSType () == GlobalRoutingLSA::RouterLSA)
         {
-          NS_LOG_LOGIC ("Found advertising router to destination");
-          SPFAddASExternal (extlsa,v);
-        }
-    }
-  for (uint32_t i = 0; i < v->GetNChildren (); i++)
-    {
+          for (uint32_t j = 0; j < lsa->GetNLinkRecords (); j++)
+            {
+              GlobalRoutingLinkRecord *l = lsa->GetLinkRecord (j);
+              if (l->GetLinkType () == GlobalRoutingLinkRecord::StubNetwork)
+                {
+                  continue;
+                }
+              GlobalRoutingLSA *w_lsa = m_lsdb->GetLSA (l->GetLinkId ());
+              if (w_lsa == 0)
+                {
+                  continue;
+                }
+              if (l->GetMetric () == 0)
+                {
+                  positive = false;
+                }
+              e.vertex = w_lsa->GetLinkStateId ();
+              e.link = j;
+              e.cost = l->GetMetric ();
+              edges.push_back (e);
+            }
+        }
+      else if (lsa->GetLSType () == GlobalRoutingLSA::NetworkLSA)
+        {
+          for (uint32_t j = 0; j < lsa->GetNAttachedRouters (); j++)
+            {
+              GlobalRoutingLSA *w_lsa = m_lsdb->GetLSAByLinkData (lsa->GetAttachedRouter (j));
+              if (w_lsa == 0)
+                {
+                  continue;
+                }
+              e.vertex = w_lsa->GetLinkStateId ();
+              e.link = j;
+              e.cost = 0;
+              edges.push_back (e);
+            }
+        }
+    }
+  return positive;
+}
+
+void
+GlobalRouteManagerImpl::SPFUpdate (Ipv4Address root, Ptr<Node> node, SPFTree* tree)
+{
+  NS_LOG_FUNCTION (this << root << node << tree);
+  typedef std::pair<uint64_t, Ipv4Address> Candidate_t;
+  typedef std::priority_queue<Candidate_t, std::vector<Candidate_t>, std::greater<Candidate_t> > CandidateHeap_t;
+
+  //
+  // The new distances of the vertices, and the vertices to calculate again
+  //
+  struct Update
+  {
+    const SPFTree* tree; //!< the tree
+    const GlobalRouteManagerLSDB* lsdb; //!< the new LSDB
+    Ipv4Address root; //!< the root
+    std::map<Ipv4Address, uint32_t> distance; //!< the new distances that may differ from the tree
+    std::set<Ipv4Address> dirty; //!< the vertices to calculate again
+    CandidateHeap_t dirtyQueue; //!< the dirty vertices by distance, then networks first
+
+    uint32_t GetDistance (Ipv4Address id) const
+    {
+      std::map<Ipv4Address, uint32_t>::const_iterator i = distance.find (id);
+      if (i != distance.end ())
+        {
+          return i->second;
+        }
+      SPFVertex *v = FindVertex (tree, id);
+      return v == 0 ? SPF_INFINITY : v->GetDistanceFromRoot ();
+    }
+
+    static const std::vector<SPFEdge>& GetEdges (const SPFGraph_t &graph, Ipv4Address id)
+    {
+      static const std::vector<SPFEdge> none;
+      SPFGraph_t::const_iterator i = graph.find (id);
+      return i == graph.end () ? none : i->second;
+    }
+
+    void Relax (const SPFGraph_t &graph, Ipv4Address id, CandidateHeap_t &candidates)
+    {
+      uint32_t d = GetDistance (id);
+      const std::vector<SPFEdge> &edges = GetEdges (graph, id);
+      for (std::vector<SPFEdge>::const_iterator e = edges.begin (); e != edges.end (); e++)
+        {
+          if (d + e->cost < GetDistance (e->vertex))
+            {
+              distance[e->vertex] = d + e->cost;
+              candidates.push (std::make_pair (d + e->cost, e->vertex));
+            }
+        }
+    }
+
+    void MarkDirty (Ipv4Address id)
+    {
+      if (id == root || !dirty.insert (id).second)
+        {
+          return;
+        }
+      GlobalRoutingLSA *lsa = lsdb->GetLSA (id);
+      uint64_t router = (lsa != 0 && lsa->GetLSType () == GlobalRoutingLSA::NetworkLSA) ? 0 : 1;
+      dirtyQueue.push (std::make_pair ((uint64_t (GetDistance (id)) << 1) | router, id));
+    }
+  };
+
+  //
+  // The order in which SPFNext () walks the edges reaching a vertex
+  //
+  struct EdgeOrder
+  {
+    bool operator() (const std::pair<SPFVertex*, uint32_t> &a, const std::pair<SPFVertex*, uint32_t> &b) const
+    {
+      if (a.first != b.first)
+        {
+          return SPFVertexOrder () (a.first, b.first);
+        }
+      return a.second < b.second;
+    }
+  };
+
+  const SPFGraph_t &graph = *m_changes->graph;
+  const SPFGraph_t &reverse = m_changes->reverse;
+  Update u;
+  u.tree = tree;
+  u.lsdb = m_lsdb;
+  u.root = root;
+  SPFSetRootNode (node);
+  m_spfroot = tree->root;
+  NS_LOG_LOGIC ("Starting SPFUpdate for node " << root);
+//
+// The vertices that lost the edge from one of their parents, or their LSA,
+// are detached from the tree with all of their descendants.
+//
+  std::vector<SPFVertex*> stack;
+  for (std::set<Ipv4Address>::const_iterator i = m_changes->edges.begin (); i != m_changes->edges.end (); i++)
+    {
+      SPFVertex *v = FindVertex (tree, *i);
+      if (v == 0)
+        {
+          continue;
+        }
+      const std::vector<SPFEdge> &edges = Update::GetEdges (graph, *i);
+      for (SPFVertex::ListOfSPFVertex_t::const_iterator c = v->m_children.begin (); c != v->m_children.end (); c++)
+        {
+          uint32_t cost = (*c)->GetDistanceFromRoot () - v->GetDistanceFromRoot ();
+          bool kept = false;
+          for (std::vector<SPFEdge>::const_iterator e = edges.begin (); e != edges.end () && !kept; e++)
+            {
+              kept = e->vertex == (*c)->GetVertexId () && e->cost == cost;
+            }
+          if (!kept)
+            {
+              stack.push_back (*c);
+            }
+        }
+    }
+  for (std::set<Ipv4Address>::const_iterator i = m_changes->lsas.begin (); i != m_changes->lsas.end (); i++)
+    {
+      SPFVertex *v = FindVertex (tree, *i);
+      if (v != 0 && graph.find (*i) == graph.end ())
+        {
+          stack.push_back (v);
+        }
+    }
+  std::set<SPFVertex*> detached;
+  while (!stack.empty ())
+    {
+      SPFVertex *v = stack.back ();
+      stack.pop_back ();
+      if (detached.insert (v).second)
+        {
+          stack.insert (stack.end (), v->m_children.begin (), v->m_children.end ());
+          u.distance[v->GetVertexId ()] = SPF_INFINITY;
+        }
+    }
+//
+// Dijkstra from the edges reaching the detached vertices and the changed
+// edges, to find the new distances.  The distances of the other vertices
+// can only decrease.
+//
+  CandidateHeap_t candidates;
+  for (std::set<SPFVertex*>::const_iterator i = detached.begin (); i != detached.end (); i++)
+    {
+      Ipv4Address id = (*i)->GetVertexId ();
+      const std::vector<SPFEdge> &edges = Update::GetEdges (reverse, id);
+      for (std::vector<SPFEdge>::const_iterator e = edges.begin (); e != edges.end (); e++)
+        {
+          uint32_t d = u.GetDistance (e->vertex);
+          if (d != SPF_INFINITY && d + e->cost < u.GetDistance (id))
+            {
+              u.distance[id] = d + e->cost;
+              candidates.push (std::make_pair (d + e->cost, id));
+            }
+        }
+    }
+  for (std::set<Ipv4Address>::const_iterator i = m_changes->edges.begin (); i != m_changes->edges.end (); i++)
+    {
+      if (u.GetDistance (*i) != SPF_INFINITY)
+        {
+          u.Relax (graph, *i, candidates);
+        }
+    }
+  while (!candidates.empty ())
+    {
+      Candidate_t c = candidates.top ();
+      candidates.pop ();
+      if (c.first == u.GetDistance (c.second))
+        {
+          u.Relax (graph, c.second, candidates);
+        }
+    }
+//
+// The vertices to calculate again: the detached ones, those whose distance
+// or LSA changed, and those the changed edges reach.
+//
+  for (std::set<SPFVertex*>::const_iterator i = detached.begin (); i != detached.end (); i++)
+    {
+      u.MarkDirty ((*i)->GetVertexId ());
+    }
+  for (std::map<Ipv4Address, uint32_t>::const_iterator i = u.distance.begin (); i != u.distance.end (); i++)
+    {
+      SPFVertex *v = FindVertex (tree, i->first);
+      if (v != 0 && v->GetDistanceFromRoot () == i->second)
+        {
+          continue;
+        }
+      u.MarkDirty (i->first);
+      const std::vector<SPFEdge> &edges = Update::GetEdges (graph, i->first);
+      for (std::vector<SPFEdge>::const_iterator e = edges.begin (); e != edges.end (); e++)
+        {
+          u.MarkDirty (e->vertex);
+        }
+      if (v != 0)
+        {
+          for (SPFVertex::ListOfSPFVertex_t::const_iterator c = v->m_children.begin (); c != v->m_children.end (); c++)
+            {
+              u.MarkDirty ((*c)->GetVertexId ());
+            }
+        }
+    }
+  for (std::set<Ipv4Address>::const_iterator i = m_changes->lsas.begin (); i != m_changes->lsas.end (); i++)
+    {
+      if (FindVertex (tree, *i) != 0 || u.GetDistance (*i) != SPF_INFINITY)
+        {
+          u.MarkDirty (*i);
+        }
+    }
+  for (std::set<Ipv4Address>::const_iterator i = m_changes->edges.begin (); i != m_changes->edges.end (); i++)
+    {
+      SPFVertex *v = FindVertex (tree, *i);
+      if (v == 0)
+        {
+          continue;
+        }
+      const std::vector<SPFEdge> &edges = Update::GetEdges (graph, *i);
+      for (std::vector<SPFEdge>::const_iterator e = edges.begin (); e != edges.end (); e++)
+        {
+          u.MarkDirty (e->vertex);
+        }
+      for (SPFVertex::ListOfSPFVertex_t::const_iterator c = v->m_children.begin (); c != v->m_children.end (); c++)
+        {
+          u.MarkDirty ((*c)->GetVertexId ());
+        }
+    }
+//
+// Calculate the dirty vertices again in the order SPFCalculate () pops them,
+// so that their parents are final.  The parents and exits of a vertex are
+// those SPFNext () finds from the edges reaching it at its distance, walked
+// in the order of their tails in the tree.  If they change, or if the place
+// of the vertex in the tree changes, the vertices it reaches are dirty too.
+//
+  std::set<SPFVertex*> moved;
+  std::vector<SPFVertex*> updated;
+  std::vector<SPFVertex*> removed;
+  while (!u.dirtyQueue.empty ())
+    {
+      Ipv4Address id = u.dirtyQueue.top ().second;
+      u.dirtyQueue.pop ();
+      uint32_t distance = u.GetDistance (id);
+      SPFVertex *x = FindVertex (tree, id);
+      if (x != 0)
+        {
+          tree->order.erase (tree->vertices[id].second);
+          for (SPFVertex::ListOfSPFVertex_t::const_iterator p = x->m_parents.begin (); p != x->m_parents.end (); p++)
+            {
+              (*p)->m_children.remove (x);
+            }
+        }
+      if (distance == SPF_INFINITY)
+        {
+          if (x != 0)
+            {
+              removed.push_back (x);
+            }
+          continue;
+        }
+      bool added = x == 0;
+      if (added)
+        {
+          x = new SPFVertex (m_lsdb->GetLSA (id));
+          tree->vertices[id] = std::make_pair (x, tree->order.end ());
+        }
+      SPFVertex::ListOfSPFVertex_t parents;
+      parents.swap (x->m_parents);
+      SPFVertex::ListOfNodeExit_t exits;
+      exits.swap (x->m_ecmpRootExits);
+      SPFVertex *firstParent = x->GetFirstParent ();
+      uint32_t firstLink = x->GetFirstLink ();
+      uint32_t previousDistance = x->GetDistanceFromRoot ();
+      x->SetLSA (m_lsdb->GetLSA (id));
+
+      std::vector<std::pair<SPFVertex*, uint32_t> > in;
+      const std::vector<SPFEdge> &edges = Update::GetEdges (reverse, id);
+      for (std::vector<SPFEdge>::const_iterator e = edges.begin (); e != edges.end (); e++)
+        {
+          uint32_t d = u.GetDistance (e->vertex);
+          if (d != SPF_INFINITY && d + e->cost == distance)
+            {
+              in.push_back (std::make_pair (FindVertex (tree, e->vertex), e->link));
+            }
+        }
+      NS_ASSERT_MSG (!in.empty (), "No edge reaches vertex " << id << " at distance " << distance);
+      std::sort (in.begin (), in.end (), EdgeOrder ());
+      for (uint32_t k = 0; k < in.size (); k++)
+        {
+          SPFVertex *v = in[k].first;
+          GlobalRoutingLinkRecord *l = 0;
+          if (v->GetVertexType () == SPFVertex::VertexRouter)
+            {
+              l = v->GetLSA ()->GetLinkRecord (in[k].second);
+            }
+          if (k == 0)
+            {
+              SPFNexthopCalculation (v, x, l, distance);
+              x->SetFirstParent (v, in[k].second);
+            }
+          else
+            {
+              SPFVertex *w = new SPFVertex (x->GetLSA ());
+              SPFNexthopCalculation (v, w, l, distance);
+              x->MergeRootExitDirections (w);
+              x->MergeParent (w);
+              w->m_parents.clear ();
+              delete w;
+            }
+        }
+
+      bool changed = added || previousDistance != distance
+        || parents != x->m_parents || exits != x->m_ecmpRootExits;
+      if (added || previousDistance != distance || firstParent != x->GetFirstParent ()
+          || firstLink != x->GetFirstLink () || moved.count (x->GetFirstParent ()))
+        {
+          moved.insert (x);
+          changed = true;
+        }
+      if (changed)
+        {
+          const std::vector<SPFEdge> &out = Update::GetEdges (graph, id);
+          for (std::vector<SPFEdge>::const_iterator e = out.begin (); e != out.end (); e++)
+            {
+              u.MarkDirty (e->vertex);
+            }
+          for (SPFVertex::ListOfSPFVertex_t::const_iterator c = x->m_children.begin (); c != x->m_children.end (); c++)
+            {
+              u.MarkDirty ((*c)->GetVertexId ());
+            }
+        }
+      updated.push_back (x);
+    }
+  NS_LOG_LOGIC ("SPFUpdate calculated " << updated.size () << " vertices again and removed " << removed.size ());
+//
+// Put the vertices back in the tree, at their place in the lists of children.
+//
+  for (std::vector<SPFVertex*>::const_iterator i = removed.begin (); i != removed.end (); i++)
+    {
+      tree->vertices.erase ((*i)->GetVertexId ());
+      (*i)->m_children.clear ();
+      (*i)->m_parents.clear ();
+      delete *i;
+    }
+  SPFVertexOrder order;
+  for (std::vector<SPFVertex*>::const_iterator i = updated.begin (); i != updated.end (); i++)
+    {
+      SPFVertex *x = *i;
+      tree->vertices[x->GetVertexId ()].second = tree->order.insert (x).first;
+      for (SPFVertex::ListOfSPFVertex_t::const_iterator p = x->m_parents.begin (); p != x->m_parents.end (); p++)
+        {
+          SPFVertex::ListOfSPFVertex_t &children = (*p)->m_children;
+          SPFVertex::ListOfSPFVertex_t::iterator c = children.begin ();
+          while (c != children.end () && order (*c, x))
+            {
+              c++;
+            }
+          children.insert (c, x);
+        }
+    }
+
+  SPFAddTreeRoutes (tree);
+  m_spfroot = 0;
+  m_spfrootNode = 0;
+  m_spfrootIpv4 = 0;
+  m_spfrootRouting = 0;
+}
+
+void
+GlobalRouteManagerImpl::SPFAddTreeRoutes (SPFTree* tree)
+{
+  NS_LOG_FUNCTION (this << tree);
+//
+// The vertices in the order they joined the tree: the host and transit
+// routes first, then the stub and external routes from the root down.
+//
+  for (SPFOrder_t::const_iterator i = tree->order.begin (); i != tree->order.end (); i++)
+    {
+      SPFVertex *v = *i;
+      v->SetVertexProcessed (false);
+      if (v == m_spfroot)
+        {
+          continue;
+        }
+      if (v->GetVertexType () == SPFVertex::VertexRouter)
+        {
+          SPFIntraAddRouter (v);
+        }
+      else if (v->GetVertexType () == SPFVertex::VertexNetwork)
+        {
+          SPFIntraAddTransit (v);
+        }
+      else
+        {
+          NS_ASSERT_MSG (0, "illegal SPFVertex type");
+        }
+    }
+  SPFProcessStubs (m_spfroot);
+  for (uint32_t i = 0; i < m_lsdb->GetNumExtLSAs (); i++)
+    {
+      for (SPFOrder_t::const_iterator j = tree->order.begin (); j != tree->order.end (); j++)
+        {
+          (*j)->SetVertexProcessed (false);
+        }
+      GlobalRoutingLSA *extlsa = m_lsdb->GetExtLSA (i);
+      NS_LOG_LOGIC ("Processing External LSA with id " << extlsa->GetLinkStateId ());
+      ProcessASExternals (m_spfroot, extlsa);
+    }
+}
+
+void
+GlobalRouteManagerImpl::ProcessASExternals (SPFVertex* v, GlobalRoutingLSA* extlsa)
+{
+  NS_LOG_FUNCTION (this << v << extlsa);
+  NS_LOG_LOGIC ("Processing external for destination " << 
+                extlsa->GetLinkStateId () <<
+                ", for router "  << v->GetVertexId () <<
+                ", advertised by " << extlsa->GetAdvertisingRouter ());
+  if (v->GetVertexType () == SPFVertex::VertexRouter)
+    {
+      GlobalRoutingLSA *rlsa = v->GetLSA ();
+      NS_LOG_LOGIC ("Processing router LSA with id " << rlsa->GetLinkStateId ());
+      if ((rlsa->GetLinkStateId ()) == (extlsa->GetAdvertisingRouter ()))
+        {
+          NS_LOG_LOGIC ("Found advertising router to destination");
+          SPFAddASExternal (extlsa,v);
+        }
+    }
+  for (uint32_t i = 0; i < v->GetNChildren (); i++)
+    {
       if (!v->GetChild (i)->IsVertexProcessed ())
         {
           NS_LOG_LOGIC ("Vertex's child " << i << " not yet processed, processing...");
@@ -1560,58 +2545,27 @@ GlobalRouteManagerImpl::SPFAddASExternal (GlobalRoutingLSA *extlsa, SPFVertex *v
 
   NS_LOG_LOGIC ("Vertex ID = " << routerId);
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
+// The node corresponding to the root vertex is the one we're going to write
 // the routing information to.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  if (m_spfrootRouting == 0)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to QI for that interface.  If there's no GlobalRouter interface, the node
-// in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
-//
-// Routing information is updated using the Ipv4 interface.  We need to QI
-// for that interface.  If the node is acting as an IP version 4 router, it
-// should absolutely have an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "QI for <Ipv4> interface failed");
+      NS_LOG_LOGIC ("No node with the router ID " << routerId);
+      return;
+    }
+  NS_LOG_LOGIC ("Setting routes for node " << m_spfrootNode->GetId ());
 //
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          NS_ASSERT_MSG (v->GetLSA (), 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask = extlsa->GetNetworkLSANetworkMask ();
-          Ipv4Address tempip = extlsa->GetLinkStateId ();
-          tempip = tempip.CombineMask (tempmask);
+  NS_ASSERT_MSG (v->GetLSA (), 
+                 "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                 "Expected valid LSA in SPFVertex* v");
+  Ipv4Mask tempmask = extlsa->GetNetworkLSANetworkMask ();
+  Ipv4Address tempip = extlsa->GetLinkStateId ();
+  tempip = tempip.CombineMask (tempmask);
 
 //
 // Here's why we did all of that work.  We're going to add a host route to the
@@ -1626,39 +2580,29 @@ GlobalRouteManagerImpl::SPFAddASExternal (GlobalRoutingLSA *extlsa, SPFVertex *v
 // Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
 // which the packets should be send for forwarding.
 //
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all next-hop-IPs and out-going-interfaces for reaching
-          // the stub network gateway 'v' from the root node
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-            {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
-              if (outIf >= 0)
-                {
-                  gr->AddASExternalRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add external network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative");
-                }
-            }
-          return;
-        } // if
-    } // for
+  // walk through all next-hop-IPs and out-going-interfaces for reaching
+  // the stub network gateway 'v' from the root node
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+    {
+      SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+      Ipv4Address nextHop = exit.first;
+      int32_t outIf = exit.second;
+      if (outIf >= 0)
+        {
+          m_spfrootRouting->AddASExternalRouteTo (tempip, tempmask, nextHop, outIf);
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << m_spfrootNode->GetId () <<
+                        " add external network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " via interface " << outIf);
+        }
+      else
+        {
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << m_spfrootNode->GetId () <<
+                        " NOT able to add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " since outgoing interface id is negative");
+        }
+    }
 }
 
 
@@ -1721,68 +2665,30 @@ GlobalRouteManagerImpl::SPFIntraAddStub (GlobalRoutingLinkRecord *l, SPFVertex*
 //
 // The root of the Shortest Path First tree is the router to which we are 
 // going to write the actual routing table entries.  The vertex corresponding
-// to this router has a vertex ID which is the router ID of that node.  We're
-// going to use this ID to discover which node it is that we're actually going
-// to update.
+// to this router has a vertex ID which is the router ID of that node; the
+// node was looked up when the calculation started.
 //
   Ipv4Address routerId = m_spfroot->GetVertexId ();
 
   NS_LOG_LOGIC ("Vertex ID = " << routerId);
-//
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
-//
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  if (m_spfrootRouting == 0)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to QI for that interface.  If there's no GlobalRouter interface, the node
-// in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
-//
-// Routing information is updated using the Ipv4 interface.  We need to QI
-// for that interface.  If the node is acting as an IP version 4 router, it
-// should absolutely have an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "QI for <Ipv4> interface failed");
+      NS_LOG_LOGIC ("No node with the router ID " << routerId);
+      return;
+    }
+  NS_LOG_LOGIC ("Setting routes for node " << m_spfrootNode->GetId ());
 //
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          NS_ASSERT_MSG (v->GetLSA (), 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask (l->GetLinkData ().Get ());
-          Ipv4Address tempip = l->GetLinkId ();
-          tempip = tempip.CombineMask (tempmask);
+  NS_ASSERT_MSG (v->GetLSA (), 
+                 "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                 "Expected valid LSA in SPFVertex* v");
+  Ipv4Mask tempmask (l->GetLinkData ().Get ());
+  Ipv4Address tempip = l->GetLinkId ();
+  tempip = tempip.CombineMask (tempmask);
 //
 // Here's why we did all of that work.  We're going to add a host route to the
 // host address found in the m_linkData field of the point-to-point link
@@ -1796,46 +2702,34 @@ GlobalRouteManagerImpl::SPFIntraAddStub (GlobalRoutingLinkRecord *l, SPFVertex*
 // Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
 // which the packets should be send for forwarding.
 //
-
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all next-hop-IPs and out-going-interfaces for reaching
-          // the stub network gateway 'v' from the root node
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-            {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
-              if (outIf >= 0)
-                {
-                  gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative");
-                }
-            }
-          return;
-        } // if
-    } // for
+  // walk through all next-hop-IPs and out-going-interfaces for reaching
+  // the stub network gateway 'v' from the root node
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+    {
+      SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+      Ipv4Address nextHop = exit.first;
+      int32_t outIf = exit.second;
+      if (outIf >= 0)
+        {
+          m_spfrootRouting->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << m_spfrootNode->GetId () <<
+                        " add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " via interface " << outIf);
+        }
+      else
+        {
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << m_spfrootNode->GetId () <<
+                        " NOT able to add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " since outgoing interface id is negative");
+        }
+    }
 }
 
-//
 // Return the interface number corresponding to a given IP address and mask
-// This is a wrapper around GetInterfaceForPrefix(), but we first
-// have to find the right node pointer to pass to that function.
+// This is a wrapper around GetInterfaceForPrefix(), on the node at the
+// root of the SPF tree.
 // If no such interface is found, return -1 (note:  unit test framework
 // for routing assumes -1 to be a legal return value)
 //
@@ -1846,68 +2740,29 @@ GlobalRouteManagerImpl::FindOutgoingInterfaceId (Ipv4Address a, Ipv4Mask amask)
 //
 // We have an IP address <a> and a vertex ID of the root of the SPF tree.
 // The question is what interface index does this address correspond to.
-// The answer is a little complicated since we have to find a pointer to
-// the node corresponding to the vertex ID, find the Ipv4 interface on that
-// node in order to iterate the interfaces and find the one corresponding to
-// the address in question.
-//
-  Ipv4Address routerId = m_spfroot->GetVertexId ();
-//
-// Walk the list of nodes in the system looking for the one corresponding to
-// the node at the root of the SPF tree.  This is the node for which we are
-// building the routing table.
+// The answer is found on the Ipv4 interface of the node corresponding to
+// the vertex ID, looked up when the calculation started.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  if (m_spfrootIpv4 == 0)
     {
-      Ptr<Node> node = *i;
-
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-//
-// If the node doesn't have a GlobalRouter interface it can't be the one
-// we're interested in.
-//
-      if (rtr == 0)
-        {
-          continue;
-        }
-
-      if (rtr->GetRouterId () == routerId)
-        {
-//
-// This is the node we're building the routing table for.  We're going to need
-// the Ipv4 interface to look for the ipv4 interface index.  Since this node
-// is participating in routing IP version 4 packets, it certainly must have 
-// an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::FindOutgoingInterfaceId (): "
-                         "GetObject for <Ipv4> interface failed");
+      NS_LOG_LOGIC ("FindOutgoingInterfaceId():Can't find root node " << m_spfroot->GetVertexId ());
+      return -1;
+    }
 //
 // Look through the interfaces on this node for one that has the IP address
 // we're looking for.  If we find one, return the corresponding interface
 // index, or -1 if not found.
 //
-          int32_t interface = ipv4->GetInterfaceForPrefix (a, amask);
+  int32_t interface = m_spfrootIpv4->GetInterfaceForPrefix (a, amask);
 
 #if 0
-          if (interface < 0)
-            {
-              NS_FATAL_ERROR ("GlobalRouteManagerImpl::FindOutgoingInterfaceId(): "
-                              "Expected an interface associated with address a:" << a);
-            }
-#endif 
-          return interface;
-        }
+  if (interface < 0)
+    {
+      NS_FATAL_ERROR ("GlobalRouteManagerImpl::FindOutgoingInterfaceId(): "
+                      "Expected an interface associated with address a:" << a);
     }
-//
-// Couldn't find it.
-//
-  NS_LOG_LOGIC ("FindOutgoingInterfaceId():Can't find root node " << routerId);
-  return -1;
+#endif 
+  return interface;
 }
 
 //
@@ -1936,68 +2791,30 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
 //
 // The root of the Shortest Path First tree is the router to which we are 
 // going to write the actual routing table entries.  The vertex corresponding
-// to this router has a vertex ID which is the router ID of that node.  We're
-// going to use this ID to discover which node it is that we're actually going
-// to update.
+// to this router has a vertex ID which is the router ID of that node; the
+// node was looked up when the calculation started.
 //
   Ipv4Address routerId = m_spfroot->GetVertexId ();
 
   NS_LOG_LOGIC ("Vertex ID = " << routerId);
-//
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
-//
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  if (m_spfrootRouting == 0)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to GetObject for that interface.  If there's no GlobalRouter interface, 
-// the node in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
-//
-// Routing information is updated using the Ipv4 interface.  We need to 
-// GetObject for that interface.  If the node is acting as an IP version 4 
-// router, it should absolutely have an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "GetObject for <Ipv4> interface failed");
+      NS_LOG_LOGIC ("No node with the router ID " << routerId);
+      return;
+    }
+  NS_LOG_LOGIC ("Setting routes for node " << m_spfrootNode->GetId ());
 //
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          GlobalRoutingLSA *lsa = v->GetLSA ();
-          NS_ASSERT_MSG (lsa, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
+  GlobalRoutingLSA *lsa = v->GetLSA ();
+  NS_ASSERT_MSG (lsa, 
+                 "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                 "Expected valid LSA in SPFVertex* v");
 
-          uint32_t nLinkRecords = lsa->GetNLinkRecords ();
+  uint32_t nLinkRecords = lsa->GetNLinkRecords ();
 //
 // Iterate through the link records on the vertex to which we're going to add
 // routes.  To make sure we're being clear, we're going to add routing table
@@ -2006,18 +2823,18 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
 // the local side of the point-to-point links found on the node described by
 // the vertex <v>.
 //
-          NS_LOG_LOGIC (" Node " << node->GetId () <<
-                        " found " << nLinkRecords << " link records in LSA " << lsa << "with LinkStateId "<< lsa->GetLinkStateId ());
-          for (uint32_t j = 0; j < nLinkRecords; ++j)
-            {
+  NS_LOG_LOGIC (" Node " << m_spfrootNode->GetId () <<
+                " found " << nLinkRecords << " link records in LSA " << lsa << "with LinkStateId "<< lsa->GetLinkStateId ());
+  for (uint32_t j = 0; j < nLinkRecords; ++j)
+    {
 //
 // We are only concerned about point-to-point links
 //
-              GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
-              if (lr->GetLinkType () != GlobalRoutingLinkRecord::PointToPoint)
-                {
-                  continue;
-                }
+      GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
+      if (lr->GetLinkType () != GlobalRoutingLinkRecord::PointToPoint)
+        {
+          continue;
+        }
 //
 // Here's why we did all of that work.  We're going to add a host route to the
 // host address found in the m_linkData field of the point-to-point link
@@ -2031,46 +2848,34 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
 // Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
 // which the packets should be send for forwarding.
 //
-              Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-              if (router == 0)
-                {
-                  continue;
-                }
-              Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-              NS_ASSERT (gr);
-              // walk through all available exit directions due to ECMP,
-              // and add host route for each of the exit direction toward
-              // the vertex 'v'
-              for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-                {
-                  SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-                  Ipv4Address nextHop = exit.first;
-                  int32_t outIf = exit.second;
-                  if (outIf >= 0)
-                    {
-                      gr->AddHostRouteTo (lr->GetLinkData (), nextHop,
-                                          outIf);
-                      NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                    " adding host route to " << lr->GetLinkData () <<
-                                    " using next hop " << nextHop <<
-                                    " and outgoing interface " << outIf);
-                    }
-                  else
-                    {
-                      NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                    " NOT able to add host route to " << lr->GetLinkData () <<
-                                    " using next hop " << nextHop <<
-                                    " since outgoing interface id is negative " << outIf);
-                    }
-                } // for all routes from the root the vertex 'v'
+      // walk through all available exit directions due to ECMP,
+      // and add host route for each of the exit direction toward
+      // the vertex 'v'
+      for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+        {
+          SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+          Ipv4Address nextHop = exit.first;
+          int32_t outIf = exit.second;
+          if (outIf >= 0)
+            {
+              m_spfrootRouting->AddHostRouteTo (lr->GetLinkData (), nextHop,
+                                                outIf);
+              NS_LOG_LOGIC ("(Route " << i << ") Node " << m_spfrootNode->GetId () <<
+                            " adding host route to " << lr->GetLinkData () <<
+                            " using next hop " << nextHop <<
+                            " and outgoing interface " << outIf);
             }
-//
-// Done adding the routes for the selected node.
-//
-          return;
-        }
+          else
+            {
+              NS_LOG_LOGIC ("(Route " << i << ") Node " << m_spfrootNode->GetId () <<
+                            " NOT able to add host route to " << lr->GetLinkData () <<
+                            " using next hop " << nextHop <<
+                            " since outgoing interface id is negative " << outIf);
+            }
+        } // for all routes from the root the vertex 'v'
     }
 }
+
 void
 GlobalRouteManagerImpl::SPFIntraAddTransit (SPFVertex* v)
 {
@@ -2081,103 +2886,56 @@ GlobalRouteManagerImpl::SPFIntraAddTransit (SPFVertex* v)
 //
 // The root of the Shortest Path First tree is the router to which we are 
 // going to write the actual routing table entries.  The vertex corresponding
-// to this router has a vertex ID which is the router ID of that node.  We're
-// going to use this ID to discover which node it is that we're actually going
-// to update.
+// to this router has a vertex ID which is the router ID of that node; the
+// node was looked up when the calculation started.
 //
   Ipv4Address routerId = m_spfroot->GetVertexId ();
 
   NS_LOG_LOGIC ("Vertex ID = " << routerId);
-//
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
-//
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  if (m_spfrootRouting == 0)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to GetObject for that interface.  If there's no GlobalRouter interface, 
-// the node in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("setting routes for node " << node->GetId ());
-//
-// Routing information is updated using the Ipv4 interface.  We need to 
-// GetObject for that interface.  If the node is acting as an IP version 4 
-// router, it should absolutely have an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
-                         "GetObject for <Ipv4> interface failed");
+      NS_LOG_LOGIC ("No node with the router ID " << routerId);
+      return;
+    }
+  NS_LOG_LOGIC ("setting routes for node " << m_spfrootNode->GetId ());
 //
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          GlobalRoutingLSA *lsa = v->GetLSA ();
-          NS_ASSERT_MSG (lsa, 
-                         "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask = lsa->GetNetworkLSANetworkMask ();
-          Ipv4Address tempip = lsa->GetLinkStateId ();
-          tempip = tempip.CombineMask (tempmask);
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all available exit directions due to ECMP,
-          // and add host route for each of the exit direction toward
-          // the vertex 'v'
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-            {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
+  GlobalRoutingLSA *lsa = v->GetLSA ();
+  NS_ASSERT_MSG (lsa, 
+                 "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
+                 "Expected valid LSA in SPFVertex* v");
+  Ipv4Mask tempmask = lsa->GetNetworkLSANetworkMask ();
+  Ipv4Address tempip = lsa->GetLinkStateId ();
+  tempip = tempip.CombineMask (tempmask);
+  // walk through all available exit directions due to ECMP,
+  // and add host route for each of the exit direction toward
+  // the vertex 'v'
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+    {
+      SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+      Ipv4Address nextHop = exit.first;
+      int32_t outIf = exit.second;
 
-              if (outIf >= 0)
-                {
-                  gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative " << outIf);
-                }
-            }
+      if (outIf >= 0)
+        {
+          m_spfrootRouting->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << m_spfrootNode->GetId () <<
+                        " add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " via interface " << outIf);
         }
-    } 
+      else
+        {
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << m_spfrootNode->GetId () <<
+                        " NOT able to add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " since outgoing interface id is negative " << outIf);
+        }
+    }
 }
 
 // Derived from quagga ospf_vertex_add_parents ()
@@ -26,6 +26,8 @@
 #include <list>
 #include <queue>
 #include <map>
+#include <set>
+#include <unordered_map>
 #include <vector>
 #include "ns3/object.h"
 #include "ns3/ptr.h"
@@ -38,6 +40,8 @@ const uint32_t SPF_INFINITY = 0xffffffff; //!< "infinite" distance between nodes
 
 class CandidateQueue;
 class Ipv4GlobalRouting;
+class Ipv4;
+class Node;
 
 /**
  * \ingroup globalrouting
@@ -422,6 +426,31 @@ public:
    */
   void MergeParent (const SPFVertex* v);
 
+  /**
+   * \brief Set the parent through which the SPF calculation first reached
+   * this vertex at its distance from the root
+   *
+   * With the distance and the type of the vertices, it gives the order in
+   * which the vertices join the SPF tree (see SPFVertexOrder).
+   *
+   * \param parent the parent
+   * \param link the index of the link record (or of the attached router,
+   * for a network) of the parent's LSA leading to this vertex
+   */
+  void SetFirstParent (SPFVertex* parent, uint32_t link);
+
+  /**
+   * \brief Get the parent set by SetFirstParent ()
+   * \returns the parent, or 0 for the root
+   */
+  SPFVertex* GetFirstParent (void) const;
+
+  /**
+   * \brief Get the link index set by SetFirstParent ()
+   * \returns the index of the link of the first parent leading to this vertex
+   */
+  uint32_t GetFirstLink (void) const;
+
 /**
  * @brief Get the number of children of "this" SPFVertex.
  *
@@ -538,6 +567,8 @@ private:
   ListOfSPFVertex_t m_parents; //!< parent list
   ListOfSPFVertex_t m_children; //!< Children list
   bool m_vertexProcessed; //!< Flag to note whether vertex has been processed in stage two of SPF computation
+  SPFVertex* m_firstParent; //!< Parent through which the vertex first reached its distance
+  uint32_t m_firstLink; //!< Link of m_firstParent leading to the vertex
 
 /**
  * @brief The SPFVertex copy construction is disallowed.  There's no need for
@@ -562,6 +593,31 @@ private:
    * \returns the reference to the output stream
    */
   friend std::ostream& operator<< (std::ostream& os, const SPFVertex::ListOfSPFVertex_t& vs);
+
+  friend class GlobalRouteManagerImpl; //!< edits the SPF trees it keeps
+};
+
+/**
+ * \ingroup globalrouting
+ *
+ * @brief Order in which the vertices join the SPF tree
+ *
+ * The candidate queue pops the vertices by distance from the root, the
+ * networks before the routers, then in the order the calculation reached
+ * them at that distance: by first parent, in the order the parents
+ * joined the tree, then by link of that parent.  This compares two
+ * vertices of a tree in that order, without replaying the calculation.
+ *
+ * It holds as long as no router link has a metric of zero.
+ */
+struct SPFVertexOrder
+{
+  /**
+   * @param v1 first vertex
+   * @param v2 second vertex
+   * @returns true if v1 joins the tree before v2
+   */
+  bool operator() (const SPFVertex* v1, const SPFVertex* v2) const;
 };
 
 /**
@@ -641,6 +697,25 @@ public:
  */
   GlobalRoutingLSA* GetLSAByLinkData (Ipv4Address addr) const;
 
+/**
+ * @brief Get the link state IDs of the router and network LSAs
+ * @returns the IDs, in increasing order
+ */
+  std::vector<Ipv4Address> GetLinkStateIds (void) const;
+
+/**
+ * @brief Keep the LSAs of an older database that did not change
+ *
+ * Each router or network LSA of this database equal to the LSA of the
+ * same link state ID in the older database is swapped with the older
+ * one, so that what points to the LSAs of the older database can keep
+ * pointing to them once it is deleted.
+ *
+ * @param previous the older database
+ * @returns the link state IDs whose LSA was added, removed or changed
+ */
+  std::set<Ipv4Address> ReuseUnchanged (GlobalRouteManagerLSDB &previous);
+
 /**
  * @brief Set all LSA flags to an initialized state, for SPF computation
  *
@@ -649,6 +724,9 @@ public:
  * prior to each SPF calculation to reset the state of the SPFVertex structures
  * that will reference the LSAs during the calculation.
  *
+ * It also indexes the link records for GetLSAByLinkData (), until the next
+ * Insert ().
+ *
  * @see GlobalRoutingLSA
  * @see SPFVertex
  */
@@ -679,7 +757,11 @@ private:
   typedef std::map<Ipv4Address, GlobalRoutingLSA*> LSDBMap_t; //!< container of IPv4 addresses / Link State Advertisements
   typedef std::pair<Ipv4Address, GlobalRoutingLSA*> LSDBPair_t; //!< pair of IPv4 addresses / Link State Advertisements
 
+  typedef std::map<Ipv4Address, LSDBMap_t::const_iterator> LinkDataMap_t; //!< container of link data / database entries
+
   LSDBMap_t m_database; //!< database of IPv4 addresses / Link State Advertisements
+  LinkDataMap_t m_linkData; //!< first database entry with a transit link record of each link data
+  bool m_linkDataValid; //!< whether m_linkData indexes the current database
   std::vector<GlobalRoutingLSA*> m_extdatabase; //!< database of External Link State Advertisements
 
 /**
@@ -732,6 +814,14 @@ public:
 /**
  * @brief Compute routes using a Dijkstra SPF computation and populate
  * per-node forwarding tables
+ *
+ * The SPF of each router writes to the forwarding table of this router
+ * only, and reads the LSDB; the SPFs of the routers are shared among the
+ * number of threads given by the global value GlobalRoutingThreads.
+ *
+ * If the global value GlobalRoutingIncrementalSpf is true, the SPF tree
+ * of each router is kept until the next call, which updates it with the
+ * changes of the LSDB instead of calculating it again.
  */
   virtual void InitializeRoutes ();
 
@@ -766,8 +856,163 @@ private:
  */
   GlobalRouteManagerImpl& operator= (GlobalRouteManagerImpl& srmi);
 
+  /// Vertices in the order they joined an SPF tree
+  typedef std::set<SPFVertex*, SPFVertexOrder> SPFOrder_t;
+
+  /**
+   * \brief An SPF tree kept from one calculation of the routes to the next
+   */
+  struct SPFTree
+  {
+    SPFVertex* root; //!< the root, or 0 for a stub router
+    std::map<Ipv4Address, std::pair<SPFVertex*, SPFOrder_t::iterator> > vertices; //!< the vertices by ID, with their position in order
+    SPFOrder_t order; //!< the vertices in the order they joined the tree
+  };
+
+  /**
+   * \brief A router whose routes are computed
+   */
+  struct SPFRoot
+  {
+    Ipv4Address id; //!< the router ID
+    Ptr<Node> node; //!< the node of the router
+    SPFTree* tree; //!< the tree of the router to keep, or 0
+  };
+
+  /**
+   * \brief An edge of the graph of the LSDB the SPF calculation walks
+   */
+  struct SPFEdge
+  {
+    Ipv4Address vertex; //!< the vertex at the other end of the edge
+    uint32_t link; //!< the index of the link record (or attached router) of the edge in the LSA of its tail
+    uint32_t cost; //!< the cost of the edge
+    /**
+     * \param o other edge
+     * \returns true if the edges are the same
+     */
+    bool operator== (const SPFEdge &o) const;
+  };
+
+  /// Edges leaving each vertex, in the order of its LSA
+  typedef std::map<Ipv4Address, std::vector<SPFEdge> > SPFGraph_t;
+
+  /**
+   * \brief The changes of the LSDB since the SPF trees were calculated
+   */
+  struct SPFChanges
+  {
+    std::set<Ipv4Address> lsas; //!< vertices whose LSA was added, removed or changed
+    std::set<Ipv4Address> edges; //!< vertices whose edges were added, removed or changed
+    const SPFGraph_t* graph; //!< edges of the LSDB
+    SPFGraph_t reverse; //!< edges of the LSDB, by head instead of tail
+  };
+
+  /// Routers whose routes are computed
+  typedef std::vector<SPFRoot> SPFRoots_t;
+  /// SPF trees kept, by router ID
+  typedef std::map<Ipv4Address, SPFTree*> SPFTrees_t;
+  /// Status of the LSAs in the running SPF calculation
+  typedef std::unordered_map<const GlobalRoutingLSA*, GlobalRoutingLSA::SPFStatus> LSAStatusMap_t;
+
   SPFVertex* m_spfroot; //!< the root node
   GlobalRouteManagerLSDB* m_lsdb; //!< the Link State DataBase (LSDB) of the Global Route Manager
+  GlobalRouteManagerLSDB* m_previousLsdb; //!< the LSDB the kept SPF trees point to, until they are updated
+  SPFTrees_t m_trees; //!< the SPF trees kept
+  SPFGraph_t m_graph; //!< the edges of the LSDB the kept SPF trees were calculated on
+  SPFTree* m_tree; //!< the tree the running SPF calculation keeps, or 0
+  Ptr<Node> m_spfrootNode; //!< the node of the root, to which the routes are written
+  Ptr<Ipv4> m_spfrootIpv4; //!< the Ipv4 of the node of the root
+  Ptr<Ipv4GlobalRouting> m_spfrootRouting; //!< the global routing protocol of the node of the root
+  LSAStatusMap_t m_lsaStatus; //!< LSAs not yet explored are absent
+  const SPFRoots_t *m_batch; //!< the routers of SPFCalculateBatch ()
+  uint32_t m_batchFirst; //!< the first router of SPFCalculateBatch ()
+  uint32_t m_batchStep; //!< the stride between the routers of SPFCalculateBatch ()
+  const SPFChanges* m_changes; //!< the changes the trees of SPFCalculateBatch () are updated with, or 0
+
+  /**
+   * \brief Get the status of an LSA in the running SPF calculation
+   *
+   * The status is kept here rather than in the LSA, so that the
+   * calculations of several roots can share the LSDB.
+   *
+   * \param lsa the LSA
+   * \returns the status of the LSA
+   */
+  GlobalRoutingLSA::SPFStatus GetLSAStatus (const GlobalRoutingLSA *lsa) const;
+
+  /**
+   * \brief Set the status of an LSA in the running SPF calculation
+   *
+   * \param lsa the LSA
+   * \param status the new status
+   */
+  void SetLSAStatus (const GlobalRoutingLSA *lsa, GlobalRoutingLSA::SPFStatus status);
+
+  /**
+   * \brief Calculate the SPF tree of the routers m_batchFirst,
+   * m_batchFirst + m_batchStep, and so on, of m_batch.
+   *
+   * This is the body of the threads of InitializeRoutes (), each running on
+   * its own GlobalRouteManagerImpl sharing the LSDB.
+   */
+  void SPFCalculateBatch (void);
+
+  /**
+   * \brief Delete the SPF trees kept
+   */
+  void DeleteTrees (void);
+
+  /**
+   * \brief Delete the vertices of an SPF tree
+   * \param tree the tree
+   */
+  static void ClearTree (SPFTree* tree);
+
+  /**
+   * \brief Look up a vertex of an SPF tree
+   * \param tree the tree
+   * \param id the vertex ID
+   * \returns the vertex, or 0 if it is not in the tree
+   */
+  static SPFVertex* FindVertex (const SPFTree* tree, Ipv4Address id);
+
+  /**
+   * \brief Get the edges of the LSDB that the SPF calculation walks
+   *
+   * \param graph the edges found
+   * \returns false if a router link has a metric of zero
+   */
+  bool BuildSPFGraph (SPFGraph_t &graph) const;
+
+  /**
+   * \brief Set the node to which the routes are written
+   * \param node the node of the root, or 0 if it has none
+   */
+  void SPFSetRootNode (Ptr<Node> node);
+
+  /**
+   * \brief Update the SPF tree of a router with m_changes, and write its
+   * routes again
+   *
+   * Only the vertices whose distance, parents or exits may have changed
+   * are calculated again: the subtrees that lost an edge or whose LSA
+   * changed, and the vertices a new or cheaper edge leads to.
+   *
+   * \param root the root node
+   * \param node the node of the root
+   * \param tree the tree of the root, calculated on the previous LSDB
+   */
+  void SPFUpdate (Ipv4Address root, Ptr<Node> node, SPFTree* tree);
+
+  /**
+   * \brief Write the routes of the SPF tree of a router
+   *
+   * Writes them in the order SPFCalculate () does.
+   *
+   * \param tree the tree of the root
+   */
+  void SPFAddTreeRoutes (SPFTree* tree);
 
   /**
    * \brief Test if a node is a stub, from an OSPF sense.
@@ -789,6 +1034,17 @@ private:
    */
   void SPFCalculate (Ipv4Address root);
 
+  /**
+   * \brief Calculate the shortest path first (SPF) tree
+   *
+   * The LSDB must have been initialized.  The routes are written to the
+   * given node only.
+   *
+   * \param root the root node
+   * \param node the node of the root, or 0 if it has none
+   */
+  void SPFCalculate (Ipv4Address root, Ptr<Node> node);
+
   /**
    * \brief Process Stub nodes
    *
@@ -935,8 +1191,8 @@ private:
   /**
    * \brief Return the interface number corresponding to a given IP address and mask
    *
-   * This is a wrapper around GetInterfaceForPrefix(), but we first
-   * have to find the right node pointer to pass to that function.
+   * This is a wrapper around GetInterfaceForPrefix(), on the node at the
+   * root of the SPF tree.
    * If no such interface is found, return -1 (note:  unit test framework
    * for routing assumes -1 to be a legal return value)
    *
@@ -37,36 +37,39 @@ Ipv4EndPointDemux::Ipv4EndPointDemux ()
 Ipv4EndPointDemux::~Ipv4EndPointDemux ()
 {
   NS_LOG_FUNCTION (this);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  for (std::map<uint16_t, EndPoints>::iterator port = m_ports.begin (); port != m_ports.end (); port++)
     {
-      Ipv4EndPoint *endPoint = *i;
-      delete endPoint;
+      for (EndPointsI i = port->second.begin (); i != port->second.end (); i++)
+        {
+          Ipv4EndPoint *endPoint = *i;
+          endPoint->m_demux = 0;
+          delete endPoint;
+        }
     }
-  m_endPoints.clear ();
+  m_ports.clear ();
+  m_connected.clear ();
+  m_listening.clear ();
 }
 
 bool
 Ipv4EndPointDemux::LookupPortLocal (uint16_t port)
 {
   NS_LOG_FUNCTION (this << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
-    {
-      if ((*i)->GetLocalPort  () == port) 
-        {
-          return true;
-        }
-    }
-  return false;
+  return m_ports.find (port) != m_ports.end ();
 }
 
 bool
 Ipv4EndPointDemux::LookupLocal (Ptr<NetDevice> boundNetDevice, Ipv4Address addr, uint16_t port)
 {
   NS_LOG_FUNCTION (this << addr << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  std::map<uint16_t, EndPoints>::iterator it = m_ports.find (port);
+  if (it == m_ports.end ())
+    {
+      return false;
+    }
+  for (EndPointsI i = it->second.begin (); i != it->second.end (); i++) 
     {
-      if ((*i)->GetLocalPort () == port &&
-          (*i)->GetLocalAddress () == addr &&
+      if ((*i)->GetLocalAddress () == addr &&
           (*i)->GetBoundNetDevice () == boundNetDevice)
         {
           return true;
@@ -86,8 +89,7 @@ Ipv4EndPointDemux::Allocate (void)
       return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (Ipv4Address::GetAny (), port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+  Insert (endPoint);
   return endPoint;
 }
 
@@ -102,8 +104,7 @@ Ipv4EndPointDemux::Allocate (Ipv4Address address)
       return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+  Insert (endPoint);
   return endPoint;
 }
 
@@ -125,8 +126,7 @@ Ipv4EndPointDemux::Allocate (Ptr<NetDevice> boundNetDevice, Ipv4Address address,
       return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+  Insert (endPoint);
   return endPoint;
 }
 
@@ -136,24 +136,26 @@ Ipv4EndPointDemux::Allocate (Ptr<NetDevice> boundNetDevice,
                              Ipv4Address peerAddress, uint16_t peerPort)
 {
   NS_LOG_FUNCTION (this << localAddress << localPort << peerAddress << peerPort << boundNetDevice);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  EndPoints *candidates = IsConnected (peerAddress, peerPort) ?
+    FindConnected (localPort, peerAddress, peerPort) : FindListening (localPort);
+  if (candidates != 0)
     {
-      if ((*i)->GetLocalPort () == localPort &&
-          (*i)->GetLocalAddress () == localAddress &&
-          (*i)->GetPeerPort () == peerPort &&
-          (*i)->GetPeerAddress () == peerAddress &&
-          ((*i)->GetBoundNetDevice () == boundNetDevice || (*i)->GetBoundNetDevice () == 0))
+      for (EndPointsI i = candidates->begin (); i != candidates->end (); i++)
         {
-          NS_LOG_WARN ("Duplicated endpoint.");
-          return 0;
+          if ((*i)->GetLocalPort () == localPort &&
+              (*i)->GetLocalAddress () == localAddress &&
+              (*i)->GetPeerPort () == peerPort &&
+              (*i)->GetPeerAddress () == peerAddress &&
+              ((*i)->GetBoundNetDevice () == boundNetDevice || (*i)->GetBoundNetDevice () == 0))
+            {
+              NS_LOG_WARN ("Duplicated endpoint.");
+              return 0;
+            }
         }
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (localAddress, localPort);
   endPoint->SetPeer (peerAddress, peerPort);
-  m_endPoints.push_back (endPoint);
-
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-
+  Insert (endPoint);
   return endPoint;
 }
 
@@ -161,15 +163,20 @@ void
 Ipv4EndPointDemux::DeAllocate (Ipv4EndPoint *endPoint)
 {
   NS_LOG_FUNCTION (this << endPoint);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  if (endPoint->m_demux != this)
     {
-      if (*i == endPoint)
-        {
-          delete endPoint;
-          m_endPoints.erase (i);
-          break;
-        }
+      return;
     }
+  Unindex (endPoint);
+  std::map<uint16_t, EndPoints>::iterator port = m_ports.find (endPoint->GetLocalPort ());
+  NS_ASSERT (port != m_ports.end ());
+  port->second.erase (endPoint->m_demuxPosition);
+  if (port->second.empty ())
+    {
+      m_ports.erase (port);
+    }
+  endPoint->m_demux = 0;
+  delete endPoint;
 }
 
 /*
@@ -181,10 +188,9 @@ Ipv4EndPointDemux::GetAllEndPoints (void)
   NS_LOG_FUNCTION (this);
   EndPoints ret;
 
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  for (std::map<uint16_t, EndPoints>::iterator port = m_ports.begin (); port != m_ports.end (); port++)
     {
-      Ipv4EndPoint* endP = *i;
-      ret.push_back (endP);
+      ret.insert (ret.end (), port->second.begin (), port->second.end ());
     }
   return ret;
 }
@@ -208,119 +214,125 @@ Ipv4EndPointDemux::Lookup (Ipv4Address daddr, uint16_t dport,
   EndPoints retval4; // Exact match on all 4
 
   NS_LOG_DEBUG ("Looking up endpoint for destination address " << daddr << ":" << dport);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
-    {
-      Ipv4EndPoint* endP = *i;
-
-      NS_LOG_DEBUG ("Looking at endpoint dport=" << endP->GetLocalPort ()
-                                                 << " daddr=" << endP->GetLocalAddress ()
-                                                 << " sport=" << endP->GetPeerPort ()
-                                                 << " saddr=" << endP->GetPeerAddress ());
 
-      if (!endP->IsRxEnabled ())
-        {
-          NS_LOG_LOGIC ("Skipping endpoint " << &endP
-                        << " because endpoint can not receive packets");
-          continue;
-        }
+  // Only the endpoints connected to the packet source and the ones with a
+  // wildcard peer on the destination port can match
+  EndPoints *candidates[2];
+  candidates[0] = IsConnected (saddr, sport) ? FindConnected (dport, saddr, sport) : 0;
+  candidates[1] = FindListening (dport);
 
-      if (endP->GetLocalPort () != dport) 
+  for (uint32_t c = 0; c < 2; c++)
+    {
+      if (candidates[c] == 0)
         {
-          NS_LOG_LOGIC ("Skipping endpoint " << &endP
-                                             << " because endpoint dport "
-                                             << endP->GetLocalPort ()
-                                             << " does not match packet dport " << dport);
           continue;
         }
-      if (endP->GetBoundNetDevice ())
+      for (EndPointsI i = candidates[c]->begin (); i != candidates[c]->end (); i++) 
         {
-          if (endP->GetBoundNetDevice () != incomingInterface->GetDevice ())
+          Ipv4EndPoint* endP = *i;
+
+          NS_LOG_DEBUG ("Looking at endpoint dport=" << endP->GetLocalPort ()
+                                                     << " daddr=" << endP->GetLocalAddress ()
+                                                     << " sport=" << endP->GetPeerPort ()
+                                                     << " saddr=" << endP->GetPeerAddress ());
+
+          if (!endP->IsRxEnabled ())
             {
               NS_LOG_LOGIC ("Skipping endpoint " << &endP
-                                                 << " because endpoint is bound to specific device and"
-                                                 << endP->GetBoundNetDevice ()
-                                                 << " does not match packet device " << incomingInterface->GetDevice ());
+                            << " because endpoint can not receive packets");
               continue;
             }
-        }
 
-      bool localAddressMatchesExact = false;
-      bool localAddressIsAny = false;
-      bool localAddressIsSubnetAny = false;
+          if (endP->GetBoundNetDevice ())
+            {
+              if (endP->GetBoundNetDevice () != incomingInterface->GetDevice ())
+                {
+                  NS_LOG_LOGIC ("Skipping endpoint " << &endP
+                                                     << " because endpoint is bound to specific device and"
+                                                     << endP->GetBoundNetDevice ()
+                                                     << " does not match packet device " << incomingInterface->GetDevice ());
+                  continue;
+                }
+            }
 
-      // We have 3 cases:
-      // 1) Exact local / destination address match
-      // 2) Local endpoint bound to Any -> matches anything
-      // 3) Local endpoint bound to x.y.z.0 -> matches Subnet-directed broadcast packet (e.g., x.y.z.255 in a /24 net) and direct destination match.
+          bool localAddressMatchesExact = false;
+          bool localAddressIsAny = false;
+          bool localAddressIsSubnetAny = false;
 
-      if (endP->GetLocalAddress () == daddr)
-        {
-          // Case 1:
-          localAddressMatchesExact = true;
-        }
-      else if (endP->GetLocalAddress () == Ipv4Address::GetAny ())
-        {
-          // Case 2:
-          localAddressIsAny = true;
-        }
-      else
-        {
-          // Case 3:
-          for (uint32_t i = 0; i < incomingInterface->GetNAddresses (); i++)
-            {
-              Ipv4InterfaceAddress addr = incomingInterface->GetAddress (i);
+          // We have 3 cases:
+          // 1) Exact local / destination address match
+          // 2) Local endpoint bound to Any -> matches anything
+          // 3) Local endpoint bound to x.y.z.0 -> matches Subnet-directed broadcast packet (e.g., x.y.z.255 in a /24 net) and direct destination match.
 
-              Ipv4Address addrNetpart = addr.GetLocal ().CombineMask (addr.GetMask ());
-              if (endP->GetLocalAddress () == addrNetpart)
+          if (endP->GetLocalAddress () == daddr)
+            {
+              // Case 1:
+              localAddressMatchesExact = true;
+            }
+          else if (endP->GetLocalAddress () == Ipv4Address::GetAny ())
+            {
+              // Case 2:
+              localAddressIsAny = true;
+            }
+          else
+            {
+              // Case 3:
+              for (uint32_t i = 0; i < incomingInterface->GetNAddresses (); i++)
                 {
-                  NS_LOG_LOGIC ("Endpoint is SubnetDirectedAny " << endP->GetLocalAddress () << "/" << addr.GetMask ().GetPrefixLength ());
+                  Ipv4InterfaceAddress addr = incomingInterface->GetAddress (i);
 
-                  Ipv4Address daddrNetPart = daddr.CombineMask (addr.GetMask ());
-                  if (addrNetpart == daddrNetPart)
+                  Ipv4Address addrNetpart = addr.GetLocal ().CombineMask (addr.GetMask ());
+                  if (endP->GetLocalAddress () == addrNetpart)
                     {
-                      localAddressIsSubnetAny = true;
+                      NS_LOG_LOGIC ("Endpoint is SubnetDirectedAny " << endP->GetLocalAddress () << "/" << addr.GetMask ().GetPrefixLength ());
+
+                      Ipv4Address daddrNetPart = daddr.CombineMask (addr.GetMask ());
+                      if (addrNetpart == daddrNetPart)
+                        {
+                          localAddressIsSubnetAny = true;
+                        }
                     }
                 }
-            }
 
-          // if no match here, keep looking
-          if (!localAddressIsSubnetAny)
-            continue;
-        }
+              // if no match here, keep looking
+              if (!localAddressIsSubnetAny)
+                continue;
+            }
 
-      bool remotePortMatchesExact = endP->GetPeerPort () == sport;
-      bool remotePortMatchesWildCard = endP->GetPeerPort () == 0;
-      bool remoteAddressMatchesExact = endP->GetPeerAddress () == saddr;
-      bool remoteAddressMatchesWildCard = endP->GetPeerAddress () == Ipv4Address::GetAny ();
+          bool remotePortMatchesExact = endP->GetPeerPort () == sport;
+          bool remotePortMatchesWildCard = endP->GetPeerPort () == 0;
+          bool remoteAddressMatchesExact = endP->GetPeerAddress () == saddr;
+          bool remoteAddressMatchesWildCard = endP->GetPeerAddress () == Ipv4Address::GetAny ();
 
-      // If remote does not match either with exact or wildcard,
-      // skip this one
-      if (!(remotePortMatchesExact || remotePortMatchesWildCard))
-        continue;
-      if (!(remoteAddressMatchesExact || remoteAddressMatchesWildCard))
-        continue;
+          // If remote does not match either with exact or wildcard,
+          // skip this one
+          if (!(remotePortMatchesExact || remotePortMatchesWildCard))
+            continue;
+          if (!(remoteAddressMatchesExact || remoteAddressMatchesWildCard))
+            continue;
 
-      bool localAddressMatchesWildCard = localAddressIsAny || localAddressIsSubnetAny;
+          bool localAddressMatchesWildCard = localAddressIsAny || localAddressIsSubnetAny;
 
-      if (localAddressMatchesExact && remoteAddressMatchesExact && remotePortMatchesExact)
-        { // All 4 match - this is the case of an open TCP connection, for example.
-          NS_LOG_LOGIC ("Found an endpoint for case 4, adding " << endP->GetLocalAddress () << ":" << endP->GetLocalPort ());
-          retval4.push_back (endP);
-        }
-      if (localAddressMatchesWildCard && remoteAddressMatchesExact && remotePortMatchesExact)
-        { // All but local address - no idea what this case could be.
-          NS_LOG_LOGIC ("Found an endpoint for case 3, adding " << endP->GetLocalAddress () << ":" << endP->GetLocalPort ());
-          retval3.push_back (endP);
-        }
-      if (localAddressMatchesExact && remoteAddressMatchesWildCard && remotePortMatchesWildCard)
-        { // Only local port and local address matches exactly - Not yet opened connection
-          NS_LOG_LOGIC ("Found an endpoint for case 2, adding " << endP->GetLocalAddress () << ":" << endP->GetLocalPort ());
-          retval2.push_back (endP);
-        }
-      if (localAddressMatchesWildCard && remoteAddressMatchesWildCard && remotePortMatchesWildCard)
-        { // Only local port matches exactly - Endpoint open to "any" connection
-          NS_LOG_LOGIC ("Found an endpoint for case 1, adding " << endP->GetLocalAddress () << ":" << endP->GetLocalPort ());
-          retval1.push_back (endP);
+          if (localAddressMatchesExact && remoteAddressMatchesExact && remotePortMatchesExact)
+            { // All 4 match - this is the case of an open TCP connection, for example.
+              NS_LOG_LOGIC ("Found an endpoint for case 4, adding " << endP->GetLocalAddress () << ":" << endP->GetLocalPort ());
+              retval4.push_back (endP);
+            }
+          if (localAddressMatchesWildCard && remoteAddressMatchesExact && remotePortMatchesExact)
+            { // All but local address - no idea what this case could be.
+              NS_LOG_LOGIC ("Found an endpoint for case 3, adding " << endP->GetLocalAddress () << ":" << endP->GetLocalPort ());
+              retval3.push_back (endP);
+            }
+          if (localAddressMatchesExact && remoteAddressMatchesWildCard && remotePortMatchesWildCard)
+            { // Only local port and local address matches exactly - Not yet opened connection
+              NS_LOG_LOGIC ("Found an endpoint for case 2, adding " << endP->GetLocalAddress () << ":" << endP->GetLocalPort ());
+              retval2.push_back (endP);
+            }
+          if (localAddressMatchesWildCard && remoteAddressMatchesWildCard && remotePortMatchesWildCard)
+            { // Only local port matches exactly - Endpoint open to "any" connection
+              NS_LOG_LOGIC ("Found an endpoint for case 1, adding " << endP->GetLocalAddress () << ":" << endP->GetLocalPort ());
+              retval1.push_back (endP);
+            }
         }
     }
 
@@ -347,12 +359,13 @@ Ipv4EndPointDemux::SimpleLookup (Ipv4Address daddr,
   // function.
   uint32_t genericity = 3;
   Ipv4EndPoint *generic = 0;
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  std::map<uint16_t, EndPoints>::iterator port = m_ports.find (dport);
+  if (port == m_ports.end ())
+    {
+      return 0;
+    }
+  for (EndPointsI i = port->second.begin (); i != port->second.end (); i++) 
     {
-      if ((*i)->GetLocalPort () != dport) 
-        {
-          continue;
-        }
       if ((*i)->GetLocalAddress () == daddr &&
           (*i)->GetPeerPort () == sport &&
           (*i)->GetPeerAddress () == saddr) 
@@ -377,6 +390,7 @@ Ipv4EndPointDemux::SimpleLookup (Ipv4Address daddr,
     }
   return generic;
 }
+
 uint16_t
 Ipv4EndPointDemux::AllocateEphemeralPort (void)
 {
@@ -400,5 +414,87 @@ Ipv4EndPointDemux::AllocateEphemeralPort (void)
   return port;
 }
 
+void
+Ipv4EndPointDemux::Insert (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  EndPoints &port = m_ports[endPoint->GetLocalPort ()];
+  endPoint->m_demuxPosition = port.insert (port.end (), endPoint);
+  endPoint->m_demux = this;
+  Index (endPoint);
+  NS_LOG_DEBUG ("Now have >>" << port.size () << "<< endpoints on port " << endPoint->GetLocalPort ());
+}
+
+void
+Ipv4EndPointDemux::Index (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  if (IsConnected (endPoint->GetPeerAddress (), endPoint->GetPeerPort ()))
+    {
+      m_connected[GetConnectionKey (endPoint->GetLocalPort (), endPoint->GetPeerAddress (),
+                                    endPoint->GetPeerPort ())].push_back (endPoint);
+    }
+  else
+    {
+      m_listening[endPoint->GetLocalPort ()].push_back (endPoint);
+    }
+}
+
+void
+Ipv4EndPointDemux::Unindex (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  if (IsConnected (endPoint->GetPeerAddress (), endPoint->GetPeerPort ()))
+    {
+      std::unordered_map<uint64_t, EndPoints>::iterator it =
+        m_connected.find (GetConnectionKey (endPoint->GetLocalPort (), endPoint->GetPeerAddress (),
+                                            endPoint->GetPeerPort ()));
+      NS_ASSERT (it != m_connected.end ());
+      it->second.remove (endPoint);
+      if (it->second.empty ())
+        {
+          m_connected.erase (it);
+        }
+    }
+  else
+    {
+      std::unordered_map<uint16_t, EndPoints>::iterator it = m_listening.find (endPoint->GetLocalPort ());
+      NS_ASSERT (it != m_listening.end ());
+      it->second.remove (endPoint);
+      if (it->second.empty ())
+        {
+          m_listening.erase (it);
+        }
+    }
+}
+
+bool
+Ipv4EndPointDemux::IsConnected (Ipv4Address peerAddress, uint16_t peerPort)
+{
+  return peerPort != 0 && peerAddress != Ipv4Address::GetAny ();
+}
+
+uint64_t
+Ipv4EndPointDemux::GetConnectionKey (uint16_t localPort, Ipv4Address peerAddress, uint16_t peerPort)
+{
+  return (static_cast<uint64_t> (localPort) << 48) | (static_cast<uint64_t> (peerPort) << 32)
+         | peerAddress.Get ();
+}
+
+Ipv4EndPointDemux::EndPoints *
+Ipv4EndPointDemux::FindConnected (uint16_t localPort, Ipv4Address peerAddress, uint16_t peerPort)
+{
+  std::unordered_map<uint64_t, EndPoints>::iterator it =
+    m_connected.find (GetConnectionKey (localPort, peerAddress, peerPort));
+  return it == m_connected.end () ? 0 : &it->second;
+}
+
+Ipv4EndPointDemux::EndPoints *
+Ipv4EndPointDemux::FindListening (uint16_t localPort)
+{
+  std::unordered_map<uint16_t, EndPoints>::iterator it = m_listening.find (localPort);
+  return it == m_listening.end () ? 0 : &it->second;
+}
+
 } // namespace ns3
 
@@ -23,6 +23,8 @@
 
 #include <stdint.h>
 #include <list>
+#include <map>
+#include <unordered_map>
 #include "ns3/ipv4-address.h"
 #include "ipv4-interface.h"
 
@@ -37,9 +39,17 @@ class Ipv4EndPoint;
  *
  * This class serves as a lookup table to match partial or full information
  * about a four-tuple to an ns3::Ipv4EndPoint.  It internally contains a list
- * of endpoints, and has APIs to add and find endpoints in this demux.  This
- * code is shared in common to TCP and UDP protocols in ns3.  This demux
- * sits between ns3's layer four and the socket layer
+ * of endpoints per local port, and has APIs to add and find endpoints in
+ * this demux.  This code is shared in common to TCP and UDP protocols in
+ * ns3.  This demux sits between ns3's layer four and the socket layer
+ *
+ * Endpoints whose peer address and port are both set (e.g., established
+ * TCP connections) are also indexed in a hash table keyed by local port,
+ * peer address and peer port, while the other ones (e.g., listening
+ * sockets) are indexed by local port only.  A lookup therefore only
+ * examines the endpoints connected to the packet source and the ones
+ * listening on the packet destination port, regardless of the total
+ * number of endpoints.
  */
 
 class Ipv4EndPointDemux {
@@ -166,6 +176,7 @@ public:
   void DeAllocate (Ipv4EndPoint *endPoint);
 
 private:
+  friend class Ipv4EndPoint;
 
   /**
    * \brief Allocate an ephemeral port.
@@ -173,6 +184,57 @@ private:
    */
   uint16_t AllocateEphemeralPort (void);
 
+  /**
+   * \brief Add a newly created end point to the demux.
+   * \param endPoint the end point
+   */
+  void Insert (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Index an end point according to its peer.
+   * \param endPoint the end point
+   */
+  void Index (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Remove an end point from the index of its peer.
+   * \param endPoint the end point
+   */
+  void Unindex (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Check whether a peer is fully specified.
+   * \param peerAddress peer address
+   * \param peerPort peer port
+   * \return true if neither the peer address nor the peer port are wildcards
+   */
+  static bool IsConnected (Ipv4Address peerAddress, uint16_t peerPort);
+
+  /**
+   * \brief Get the key of the connected end points.
+   * \param localPort local port
+   * \param peerAddress peer address
+   * \param peerPort peer port
+   * \return the key
+   */
+  static uint64_t GetConnectionKey (uint16_t localPort, Ipv4Address peerAddress, uint16_t peerPort);
+
+  /**
+   * \brief Find the end points connected to a peer.
+   * \param localPort local port
+   * \param peerAddress peer address
+   * \param peerPort peer port
+   * \return the end points (0 if none)
+   */
+  EndPoints *FindConnected (uint16_t localPort, Ipv4Address peerAddress, uint16_t peerPort);
+
+  /**
+   * \brief Find the end points of a local port with a wildcard peer.
+   * \param localPort local port
+   * \return the end points (0 if none)
+   */
+  EndPoints *FindListening (uint16_t localPort);
+
   /**
    * \brief The ephemeral port.
    */
@@ -189,9 +251,19 @@ private:
   uint16_t m_portFirst;
 
   /**
-   * \brief A list of IPv4 end points.
+   * \brief The IPv4 end points of each local port, in allocation order.
+   */
+  std::map<uint16_t, EndPoints> m_ports;
+
+  /**
+   * \brief The IPv4 end points with a fully specified peer.
+   */
+  std::unordered_map<uint64_t, EndPoints> m_connected;
+
+  /**
+   * \brief The other IPv4 end points, by local port.
    */
-  EndPoints m_endPoints;
+  std::unordered_map<uint16_t, EndPoints> m_listening;
 };
 
 } // namespace ns3
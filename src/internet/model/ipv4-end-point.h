@@ -22,6 +22,7 @@
 #define IPV4_END_POINT_H
 
 #include <stdint.h>
+#include <list>
 #include "ns3/ipv4-address.h"
 #include "ns3/callback.h"
 #include "ns3/net-device.h"
@@ -32,6 +33,7 @@ namespace ns3 {
 
 class Header;
 class Packet;
+class Ipv4EndPointDemux;
 
 /**
  * \ingroup ipv4
@@ -227,6 +229,21 @@ private:
    * \brief true if the endpoint can receive packets.
    */
   bool m_rxEnabled;
+
+  friend class Ipv4EndPointDemux;
+
+  /**
+   * \brief The demux indexing this end point (if any).
+   *
+   * The demux is notified when the peer changes, as it indexes
+   * connected end points by their peer.
+   */
+  Ipv4EndPointDemux *m_demux;
+
+  /**
+   * \brief Position of this end point in the demux list of its local port.
+   */
+  std::list<Ipv4EndPoint *>::iterator m_demuxPosition;
 };
 
 } // namespace ns3
@@ -0,0 +1,138 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include "ns3/log.h"
+#include "ipv4-fib.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("Ipv4Fib");
+
+Ipv4Fib::Ipv4Fib ()
+  : m_nodes (1, Node ())
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+Ipv4Fib::Build (const std::vector<Prefix> &prefixes)
+{
+  NS_LOG_FUNCTION (this << prefixes.size ());
+  Node root = {{0, 0}, 0, 0};
+  m_nodes.assign (1, root);
+  m_routes.clear ();
+  m_irregular.clear ();
+  m_irregularPrefixes.clear ();
+
+  // Insert the prefixes, counting the routes of each node
+  std::vector<uint32_t> nodeOf (prefixes.size ());
+  std::vector<uint32_t> count (1, 0);
+  for (uint32_t i = 0; i < prefixes.size (); i++)
+    {
+      uint32_t mask = prefixes[i].second.Get ();
+      if ((~mask & (~mask + 1)) != 0)
+        {
+          NS_LOG_LOGIC ("Route " << i << " has a non-contiguous mask");
+          m_irregular.push_back (i);
+          m_irregularPrefixes.push_back (prefixes[i]);
+          continue;
+        }
+      uint32_t network = prefixes[i].first.Get ();
+      uint32_t length = prefixes[i].second.GetPrefixLength ();
+      uint32_t node = 0;
+      for (uint32_t depth = 0; depth < length; depth++)
+        {
+          uint32_t bit = (network >> (31 - depth)) & 1;
+          if (m_nodes[node].child[bit] == 0)
+            {
+              m_nodes[node].child[bit] = m_nodes.size ();
+              m_nodes.push_back (root);
+              count.push_back (0);
+            }
+          node = m_nodes[node].child[bit];
+        }
+      nodeOf[i] = node;
+      count[node]++;
+    }
+
+  // Lay the routes out node by node, each node keeping the list order
+  uint32_t offset = 0;
+  for (uint32_t node = 0; node < m_nodes.size (); node++)
+    {
+      m_nodes[node].begin = offset;
+      m_nodes[node].end = offset;
+      offset += count[node];
+    }
+  m_routes.resize (offset);
+  for (uint32_t i = 0, j = 0; i < prefixes.size (); i++)
+    {
+      if (j < m_irregular.size () && m_irregular[j] == i)
+        {
+          j++;
+          continue;
+        }
+      m_routes[m_nodes[nodeOf[i]].end++] = i;
+    }
+}
+
+void
+Ipv4Fib::Lookup (Ipv4Address dest, std::vector<uint32_t> &routes) const
+{
+  NS_LOG_FUNCTION (this << dest);
+  routes.clear ();
+  uint32_t address = dest.Get ();
+  uint32_t ranges = 0;
+  uint32_t node = 0;
+  for (uint32_t depth = 0; ; depth++)
+    {
+      const Node &n = m_nodes[node];
+      if (n.begin != n.end)
+        {
+          routes.insert (routes.end (), m_routes.begin () + n.begin, m_routes.begin () + n.end);
+          ranges++;
+        }
+      if (depth == 32)
+        {
+          break;
+        }
+      node = n.child[(address >> (31 - depth)) & 1];
+      if (node == 0)
+        {
+          break;
+        }
+    }
+  for (uint32_t i = 0; i < m_irregular.size (); i++)
+    {
+      if (m_irregularPrefixes[i].second.IsMatch (dest, m_irregularPrefixes[i].first))
+        {
+          routes.push_back (m_irregular[i]);
+          ranges++;
+        }
+    }
+  if (ranges > 1)
+    {
+      std::sort (routes.begin (), routes.end ());
+    }
+}
+
+uint32_t
+Ipv4Fib::GetNNodes (void) const
+{
+  return m_nodes.size ();
+}
+
+} // namespace ns3
@@ -0,0 +1,86 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef IPV4_FIB_H
+#define IPV4_FIB_H
+
+#include <stdint.h>
+#include <vector>
+#include "ns3/ipv4-address.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup ipv4Routing
+ *
+ * \brief Forwarding table compiled from a list of route prefixes
+ *
+ * The prefixes are held in a binary trie, indexed by the bits of their
+ * network address: the routes of a prefix of length L are held by the
+ * node of depth L on the path of the network.  A lookup walks the path
+ * of the destination, at most 33 nodes, whatever the number of routes.
+ * Prefixes whose mask is not contiguous are kept aside and matched one by
+ * one.
+ *
+ * The table does not select a route: it returns all the routes matching
+ * a destination, in the order of the list it was built from.  The routing
+ * protocols then apply their selection rules (longest prefix, metric,
+ * ECMP) to those routes only, as they would to the whole list.
+ */
+class Ipv4Fib
+{
+public:
+  /// A route prefix: network address and mask
+  typedef std::pair<Ipv4Address, Ipv4Mask> Prefix;
+
+  Ipv4Fib ();
+
+  /**
+   * \brief Build the table
+   * \param prefixes the prefixes of the routes, the route i having the prefix i
+   */
+  void Build (const std::vector<Prefix> &prefixes);
+
+  /**
+   * \brief Find the routes whose prefix matches a destination
+   * \param dest the destination
+   * \param routes the indexes of the matching routes, in increasing order
+   */
+  void Lookup (Ipv4Address dest, std::vector<uint32_t> &routes) const;
+
+  /**
+   * \return the number of trie nodes
+   */
+  uint32_t GetNNodes (void) const;
+
+private:
+  /// A trie node
+  struct Node
+  {
+    uint32_t child[2]; //!< Children for the bits 0 and 1, or 0 if none
+    uint32_t begin;    //!< First route of the prefix of the node
+    uint32_t end;      //!< End of the routes of the prefix of the node
+  };
+
+  std::vector<Node> m_nodes;        //!< Trie nodes, the root first
+  std::vector<uint32_t> m_routes;   //!< Routes of the nodes, in node order
+  std::vector<uint32_t> m_irregular; //!< Routes with a non-contiguous mask
+  std::vector<Prefix> m_irregularPrefixes; //!< Prefixes of those routes
+};
+
+} // namespace ns3
+
+#endif /* IPV4_FIB_H */
@@ -59,7 +59,8 @@ Ipv4GlobalRouting::GetTypeId (void)
 
 Ipv4GlobalRouting::Ipv4GlobalRouting () 
   : m_randomEcmpRouting (false),
-    m_respondToInterfaceEvents (false)
+    m_respondToInterfaceEvents (false),
+    m_fibValid (false)
 {
   NS_LOG_FUNCTION (this);
 
@@ -80,6 +81,8 @@ Ipv4GlobalRouting::AddHostRouteTo (Ipv4Address dest,
   Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
   *route = Ipv4RoutingTableEntry::CreateHostRouteTo (dest, nextHop, interface);
   m_hostRoutes.push_back (route);
+  m_fibValid = false;
+  NotifyRoutesChanged ();
 }
 
 void 
@@ -90,6 +93,8 @@ Ipv4GlobalRouting::AddHostRouteTo (Ipv4Address dest,
   Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
   *route = Ipv4RoutingTableEntry::CreateHostRouteTo (dest, interface);
   m_hostRoutes.push_back (route);
+  m_fibValid = false;
+  NotifyRoutesChanged ();
 }
 
 void 
@@ -105,6 +110,8 @@ Ipv4GlobalRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         nextHop,
                                                         interface);
   m_networkRoutes.push_back (route);
+  m_fibValid = false;
+  NotifyRoutesChanged ();
 }
 
 void 
@@ -118,6 +125,8 @@ Ipv4GlobalRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         networkMask,
                                                         interface);
   m_networkRoutes.push_back (route);
+  m_fibValid = false;
+  NotifyRoutesChanged ();
 }
 
 void 
@@ -133,9 +142,46 @@ Ipv4GlobalRouting::AddASExternalRouteTo (Ipv4Address network,
                                                         nextHop,
                                                         interface);
   m_ASexternalRoutes.push_back (route);
+  m_fibValid = false;
+  NotifyRoutesChanged ();
 }
 
 
+void
+Ipv4GlobalRouting::BuildFib (const std::list<Ipv4RoutingTableEntry *> &routes,
+                             Ipv4Fib &fib, FibRoutes &fibRoutes)
+{
+  std::vector<Ipv4Fib::Prefix> prefixes;
+  prefixes.reserve (routes.size ());
+  fibRoutes.assign (routes.begin (), routes.end ());
+  for (FibRoutes::const_iterator i = fibRoutes.begin (); i != fibRoutes.end (); i++)
+    {
+      if ((*i)->IsHost ())
+        {
+          prefixes.push_back (std::make_pair ((*i)->GetDest (), Ipv4Mask::GetOnes ()));
+        }
+      else
+        {
+          prefixes.push_back (std::make_pair ((*i)->GetDestNetwork (), (*i)->GetDestNetworkMask ()));
+        }
+    }
+  fib.Build (prefixes);
+}
+
+void
+Ipv4GlobalRouting::BuildFibs (void)
+{
+  if (m_fibValid)
+    {
+      return;
+    }
+  NS_LOG_FUNCTION (this);
+  BuildFib (m_hostRoutes, m_hostFib, m_hostFibRoutes);
+  BuildFib (m_networkRoutes, m_networkFib, m_networkFibRoutes);
+  BuildFib (m_ASexternalRoutes, m_ASexternalFib, m_ASexternalFibRoutes);
+  m_fibValid = true;
+}
+
 Ptr<Ipv4Route>
 Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif)
 {
@@ -146,72 +192,69 @@ Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif)
   typedef std::vector<Ipv4RoutingTableEntry*> RouteVec_t;
   RouteVec_t allRoutes;
 
+  // The forwarding tables return the routes matching the destination, in
+  // the order of their list: the rules below select among them as they
+  // would among all the routes.
+  BuildFibs ();
   NS_LOG_LOGIC ("Number of m_hostRoutes = " << m_hostRoutes.size ());
-  for (HostRoutesCI i = m_hostRoutes.begin (); 
-       i != m_hostRoutes.end (); 
-       i++) 
+  m_hostFib.Lookup (dest, m_matches);
+  for (std::vector<uint32_t>::const_iterator m = m_matches.begin ();
+       m != m_matches.end ();
+       m++)
     {
-      NS_ASSERT ((*i)->IsHost ());
-      if ((*i)->GetDest ().IsEqual (dest)) 
+      Ipv4RoutingTableEntry *i = m_hostFibRoutes[*m];
+      NS_ASSERT (i->IsHost ());
+      if (oif != 0)
         {
-          if (oif != 0)
+          if (oif != m_ipv4->GetNetDevice (i->GetInterface ()))
             {
-              if (oif != m_ipv4->GetNetDevice ((*i)->GetInterface ()))
-                {
-                  NS_LOG_LOGIC ("Not on requested interface, skipping");
-                  continue;
-                }
+              NS_LOG_LOGIC ("Not on requested interface, skipping");
+              continue;
             }
-          allRoutes.push_back (*i);
-          NS_LOG_LOGIC (allRoutes.size () << "Found global host route" << *i); 
         }
+      allRoutes.push_back (i);
+      NS_LOG_LOGIC (allRoutes.size () << "Found global host route" << i);
     }
   if (allRoutes.size () == 0) // if no host route is found
     {
       NS_LOG_LOGIC ("Number of m_networkRoutes" << m_networkRoutes.size ());
-      for (NetworkRoutesI j = m_networkRoutes.begin (); 
-           j != m_networkRoutes.end (); 
-           j++) 
+      m_networkFib.Lookup (dest, m_matches);
+      for (std::vector<uint32_t>::const_iterator m = m_matches.begin ();
+           m != m_matches.end ();
+           m++)
         {
-          Ipv4Mask mask = (*j)->GetDestNetworkMask ();
-          Ipv4Address entry = (*j)->GetDestNetwork ();
-          if (mask.IsMatch (dest, entry)) 
+          Ipv4RoutingTableEntry *j = m_networkFibRoutes[*m];
+          if (oif != 0)
             {
-              if (oif != 0)
+              if (oif != m_ipv4->GetNetDevice (j->GetInterface ()))
                 {
-                  if (oif != m_ipv4->GetNetDevice ((*j)->GetInterface ()))
-                    {
-                      NS_LOG_LOGIC ("Not on requested interface, skipping");
-                      continue;
-                    }
+                  NS_LOG_LOGIC ("Not on requested interface, skipping");
+                  continue;
                 }
-              allRoutes.push_back (*j);
-              NS_LOG_LOGIC (allRoutes.size () << "Found global network route" << *j);
             }
+          allRoutes.push_back (j);
+          NS_LOG_LOGIC (allRoutes.size () << "Found global network route" << j);
         }
     }
   if (allRoutes.size () == 0)  // consider external if no host/network found
     {
-      for (ASExternalRoutesI k = m_ASexternalRoutes.begin ();
-           k != m_ASexternalRoutes.end ();
-           k++)
+      m_ASexternalFib.Lookup (dest, m_matches);
+      for (std::vector<uint32_t>::const_iterator m = m_matches.begin ();
+           m != m_matches.end ();
+           m++)
         {
-          Ipv4Mask mask = (*k)->GetDestNetworkMask ();
-          Ipv4Address entry = (*k)->GetDestNetwork ();
-          if (mask.IsMatch (dest, entry))
+          Ipv4RoutingTableEntry *k = m_ASexternalFibRoutes[*m];
+          NS_LOG_LOGIC ("Found external route" << k);
+          if (oif != 0)
             {
-              NS_LOG_LOGIC ("Found external route" << *k);
-              if (oif != 0)
+              if (oif != m_ipv4->GetNetDevice (k->GetInterface ()))
                 {
-                  if (oif != m_ipv4->GetNetDevice ((*k)->GetInterface ()))
-                    {
-                      NS_LOG_LOGIC ("Not on requested interface, skipping");
-                      continue;
-                    }
+                  NS_LOG_LOGIC ("Not on requested interface, skipping");
+                  continue;
                 }
-              allRoutes.push_back (*k);
-              break;
             }
+          allRoutes.push_back (k);
+          break;
         }
     }
   if (allRoutes.size () > 0 ) // if route(s) is found
@@ -321,6 +364,8 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
               NS_LOG_LOGIC ("Removing route " << index << "; size = " << m_hostRoutes.size ());
               delete *i;
               m_hostRoutes.erase (i);
+              m_fibValid = false;
+              NotifyRoutesChanged ();
               NS_LOG_LOGIC ("Done removing host route " << index << "; host route remaining size = " << m_hostRoutes.size ());
               return;
             }
@@ -338,6 +383,8 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
           NS_LOG_LOGIC ("Removing route " << index << "; size = " << m_networkRoutes.size ());
           delete *j;
           m_networkRoutes.erase (j);
+          m_fibValid = false;
+          NotifyRoutesChanged ();
           NS_LOG_LOGIC ("Done removing network route " << index << "; network route remaining size = " << m_networkRoutes.size ());
           return;
         }
@@ -354,6 +401,8 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
           NS_LOG_LOGIC ("Removing route " << index << "; size = " << m_ASexternalRoutes.size ());
           delete *k;
           m_ASexternalRoutes.erase (k);
+          m_fibValid = false;
+          NotifyRoutesChanged ();
           NS_LOG_LOGIC ("Done removing network route " << index << "; network route remaining size = " << m_networkRoutes.size ());
           return;
         }
@@ -392,10 +441,21 @@ Ipv4GlobalRouting::DoDispose (void)
     {
       delete (*l);
     }
+  m_fibValid = false;
+  m_hostFibRoutes.clear ();
+  m_networkFibRoutes.clear ();
+  m_ASexternalFibRoutes.clear ();
 
   Ipv4RoutingProtocol::DoDispose ();
 }
 
+bool
+Ipv4GlobalRouting::IsRouteCacheable (void) const
+{
+  // A random choice among equal-cost routes is made for every packet
+  return !m_randomEcmpRouting;
+}
+
 // Formatted like output of "route -n" command
 void
 Ipv4GlobalRouting::PrintRoutingTable (Ptr<OutputStreamWrapper> stream, Time::Unit unit) const
@@ -21,6 +21,7 @@
 #define IPV4_GLOBAL_ROUTING_H
 
 #include <list>
+#include <vector>
 #include <stdint.h>
 #include "ns3/ipv4-address.h"
 #include "ns3/ipv4-header.h"
@@ -28,6 +29,7 @@
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/random-variable-stream.h"
+#include "ns3/ipv4-fib.h"
 
 namespace ns3 {
 
@@ -64,6 +66,8 @@ class Node;
  * routes into the Ipv4StaticRouting may need to be kept distinct.
  *
  * This class deals with Ipv4 unicast routes only.
+ * The lookups go through forwarding tables (Ipv4Fib) compiled from the
+ * route lists on the first lookup after a change of the routes.
  *
  * \see Ipv4RoutingProtocol
  * \see GlobalRouteManager
@@ -99,6 +103,7 @@ public:
   virtual void NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress address);
   virtual void SetIpv4 (Ptr<Ipv4> ipv4);
   virtual void PrintRoutingTable (Ptr<OutputStreamWrapper> stream, Time::Unit unit = Time::S) const;
+  virtual bool IsRouteCacheable (void) const;
 
   /**
    * \brief Add a host route to the global routing table.
@@ -268,10 +273,36 @@ private:
    */
   Ptr<Ipv4Route> LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif = 0);
 
+  /// Routes of a forwarding table, in the order of their list
+  typedef std::vector<Ipv4RoutingTableEntry *> FibRoutes;
+
+  /**
+   * \brief Build a forwarding table from a list of routes
+   * \param routes the list of routes
+   * \param fib the forwarding table
+   * \param fibRoutes the routes of the forwarding table
+   */
+  static void BuildFib (const std::list<Ipv4RoutingTableEntry *> &routes,
+                        Ipv4Fib &fib, FibRoutes &fibRoutes);
+
+  /**
+   * \brief Build the forwarding tables, if the routes changed since
+   */
+  void BuildFibs (void);
+
   HostRoutes m_hostRoutes;             //!< Routes to hosts
   NetworkRoutes m_networkRoutes;       //!< Routes to networks
   ASExternalRoutes m_ASexternalRoutes; //!< External routes imported
 
+  bool m_fibValid;                     //!< Whether the forwarding tables are up to date
+  Ipv4Fib m_hostFib;                   //!< Forwarding table of the routes to hosts
+  Ipv4Fib m_networkFib;                //!< Forwarding table of the routes to networks
+  Ipv4Fib m_ASexternalFib;             //!< Forwarding table of the external routes
+  FibRoutes m_hostFibRoutes;           //!< Routes of m_hostFib
+  FibRoutes m_networkFibRoutes;        //!< Routes of m_networkFib
+  FibRoutes m_ASexternalFibRoutes;     //!< Routes of m_ASexternalFib
+  std::vector<uint32_t> m_matches;     //!< Routes matching the last lookup
+
   Ptr<Ipv4> m_ipv4; //!< associated IPv4 instance
 };
 
@@ -33,6 +33,7 @@
 #include "ns3/boolean.h"
 #include "ns3/ipv4-routing-table-entry.h"
 #include "ns3/traffic-control-layer.h"
+#include "ns3/gso-tag.h"
 
 #include "loopback-net-device.h"
 #include "arp-l3-protocol.h"
@@ -41,6 +42,7 @@
 #include "icmpv4-l4-protocol.h"
 #include "ipv4-interface.h"
 #include "ipv4-raw-socket-impl.h"
+#include "tcp-l4-protocol.h"
 
 namespace ns3 {
 
@@ -69,6 +71,13 @@ Ipv4L3Protocol::GetTypeId (void)
                    TimeValue (Seconds (30)),
                    MakeTimeAccessor (&Ipv4L3Protocol::m_fragmentExpirationTimeout),
                    MakeTimeChecker ())
+    .AddAttribute ("RouteCache",
+                   "Cache the route of the forwarded packets by destination "
+                   "and input interface, when the routing protocol allows it, "
+                   "until its routes or the interfaces change.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&Ipv4L3Protocol::m_routeCacheEnabled),
+                   MakeBooleanChecker ())
     .AddTraceSource ("Tx",
                      "Send ipv4 packet to outgoing interface.",
                      MakeTraceSourceAccessor (&Ipv4L3Protocol::m_txTrace),
@@ -108,8 +117,11 @@ Ipv4L3Protocol::GetTypeId (void)
 }
 
 Ipv4L3Protocol::Ipv4L3Protocol()
+  : m_routeCacheEnabled (false),
+    m_routeCacheIif (0)
 {
   NS_LOG_FUNCTION (this);
+  GsoTag::SetSegmenter (PROT_NUMBER, MakeCallback (&Ipv4L3Protocol::SegmentGso));
 }
 
 Ipv4L3Protocol::~Ipv4L3Protocol ()
@@ -270,7 +282,9 @@ Ipv4L3Protocol::SetRoutingProtocol (Ptr<Ipv4RoutingProtocol> routingProtocol)
 {
   NS_LOG_FUNCTION (this << routingProtocol);
   m_routingProtocol = routingProtocol;
+  m_routingProtocol->SetRoutesChangedCallback (MakeCallback (&Ipv4L3Protocol::FlushRouteCache, this));
   m_routingProtocol->SetIpv4 (this);
+  FlushRouteCache ();
 }
 
 
@@ -297,6 +311,7 @@ Ipv4L3Protocol::DoDispose (void)
     }
   m_interfaces.clear ();
   m_reverseInterfacesContainer.clear ();
+  m_routeCache.clear ();
 
   m_sockets.clear ();
   m_node = 0;
@@ -399,6 +414,7 @@ Ipv4L3Protocol::AddIpv4Interface (Ptr<Ipv4Interface>interface)
   uint32_t index = m_interfaces.size ();
   m_interfaces.push_back (interface);
   m_reverseInterfacesContainer[interface->GetDevice ()] = index;
+  FlushRouteCache ();
   return index;
 }
 
@@ -631,8 +647,24 @@ Ipv4L3Protocol::Receive ( Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t p
     }
 
   NS_ASSERT_MSG (m_routingProtocol != 0, "Need a routing protocol object to process packets");
-  if (!m_routingProtocol->RouteInput (packet, ipHeader, device,
-                                      MakeCallback (&Ipv4L3Protocol::IpForward, this),
+  Ipv4RoutingProtocol::UnicastForwardCallback ucb = MakeCallback (&Ipv4L3Protocol::IpForward, this);
+  if (m_routeCacheEnabled)
+    {
+      uint64_t key = (static_cast<uint64_t> (ipHeader.GetDestination ().Get ()) << 32) | interface;
+      RouteCache_t::const_iterator it = m_routeCache.find (key);
+      if (it != m_routeCache.end ())
+        {
+          NS_LOG_LOGIC ("Forwarding along the cached route");
+          IpForward (it->second, packet, ipHeader);
+          return;
+        }
+      if (m_routingProtocol->IsRouteCacheable ())
+        {
+          m_routeCacheIif = interface;
+          ucb = MakeCallback (&Ipv4L3Protocol::IpForwardCached, this);
+        }
+    }
+  if (!m_routingProtocol->RouteInput (packet, ipHeader, device, ucb,
                                       MakeCallback (&Ipv4L3Protocol::IpMulticastForward, this),
                                       MakeCallback (&Ipv4L3Protocol::LocalDeliver, this),
                                       MakeCallback (&Ipv4L3Protocol::RouteInputError, this)
@@ -925,12 +957,30 @@ Ipv4L3Protocol::SendRealOut (Ptr<Ipv4Route> route,
   Ptr<Ipv4Interface> outInterface = GetInterface (interface);
   NS_LOG_LOGIC ("Send via NetDevice ifIndex " << outDev->GetIfIndex () << " ipv4InterfaceIndex " << interface);
 
+  GsoTag gso;
+  bool isGso = packet->PeekPacketTag (gso);
+  if (isGso && (gso.HasLosses () || !outDev->SupportsGso ()))
+    {
+      // The device cannot transmit the super-segment as a whole: segment it
+      NS_ASSERT (ipHeader.GetProtocol () == TcpL4Protocol::PROT_NUMBER);
+      NS_LOG_LOGIC ("Segmenting super-segment of " << gso.GetNSegments () << " segments");
+      std::list<Ptr<Packet> > segments = TcpL4Protocol::SegmentGso (packet, ipHeader.GetSource (),
+                                                                    ipHeader.GetDestination ());
+      for (std::list<Ptr<Packet> >::iterator it = segments.begin (); it != segments.end (); ++it)
+        {
+          Ipv4Header header = ipHeader;
+          header.SetPayloadSize ((*it)->GetSize ());
+          SendRealOut (route, *it, header);
+        }
+      return;
+    }
+
   if (!route->GetGateway ().IsEqual (Ipv4Address ("0.0.0.0")))
     {
       if (outInterface->IsUp ())
         {
           NS_LOG_LOGIC ("Send to gateway " << route->GetGateway ());
-          if ( packet->GetSize () + ipHeader.GetSerializedSize () > outInterface->GetDevice ()->GetMtu () )
+          if (!isGso && packet->GetSize () + ipHeader.GetSerializedSize () > outInterface->GetDevice ()->GetMtu ())
             {
               std::list<Ipv4PayloadHeaderPair> listFragments;
               DoFragmentation (packet, ipHeader, outInterface->GetDevice ()->GetMtu (), listFragments);
@@ -957,7 +1007,7 @@ Ipv4L3Protocol::SendRealOut (Ptr<Ipv4Route> route,
       if (outInterface->IsUp ())
         {
           NS_LOG_LOGIC ("Send to destination " << ipHeader.GetDestination ());
-          if ( packet->GetSize () + ipHeader.GetSerializedSize () > outInterface->GetDevice ()->GetMtu () )
+          if (!isGso && packet->GetSize () + ipHeader.GetSerializedSize () > outInterface->GetDevice ()->GetMtu ())
             {
               std::list<Ipv4PayloadHeaderPair> listFragments;
               DoFragmentation (packet, ipHeader, outInterface->GetDevice ()->GetMtu (), listFragments);
@@ -982,6 +1032,30 @@ Ipv4L3Protocol::SendRealOut (Ptr<Ipv4Route> route,
     }
 }
 
+std::list<Ptr<Packet> >
+Ipv4L3Protocol::SegmentGso (Ptr<const Packet> packet)
+{
+  NS_LOG_FUNCTION (packet);
+  Ptr<Packet> p = packet->Copy ();
+  Ipv4Header ipHeader;
+  p->RemoveHeader (ipHeader);
+  NS_ASSERT (ipHeader.GetProtocol () == TcpL4Protocol::PROT_NUMBER);
+
+  std::list<Ptr<Packet> > segments = TcpL4Protocol::SegmentGso (p, ipHeader.GetSource (),
+                                                                ipHeader.GetDestination ());
+  for (std::list<Ptr<Packet> >::iterator it = segments.begin (); it != segments.end (); ++it)
+    {
+      Ipv4Header header = ipHeader;
+      header.SetPayloadSize ((*it)->GetSize ());
+      if (Node::ChecksumEnabled ())
+        {
+          header.EnableChecksum ();
+        }
+      (*it)->AddHeader (header);
+    }
+  return segments;
+}
+
 // This function analogous to Linux ip_mr_forward()
 void
 Ipv4L3Protocol::IpMulticastForward (Ptr<Ipv4MulticastRoute> mrtentry, Ptr<const Packet> p, const Ipv4Header &header)
@@ -1057,11 +1131,31 @@ Ipv4L3Protocol::IpForward (Ptr<Ipv4Route> rtentry, Ptr<const Packet> p, const Ip
   SendRealOut (rtentry, packet, ipHeader);
 }
 
+void
+Ipv4L3Protocol::IpForwardCached (Ptr<Ipv4Route> rtentry, Ptr<const Packet> p, const Ipv4Header &header)
+{
+  NS_LOG_FUNCTION (this << rtentry << p << header);
+  uint64_t key = (static_cast<uint64_t> (header.GetDestination ().Get ()) << 32) | m_routeCacheIif;
+  m_routeCache[key] = rtentry;
+  IpForward (rtentry, p, header);
+}
+
+void
+Ipv4L3Protocol::FlushRouteCache (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_routeCache.empty ())
+    {
+      m_routeCache.clear ();
+    }
+}
+
 void
 Ipv4L3Protocol::LocalDeliver (Ptr<const Packet> packet, Ipv4Header const&ip, uint32_t iif)
 {
   NS_LOG_FUNCTION (this << packet << &ip << iif);
   Ptr<Packet> p = packet->Copy (); // need to pass a non-const packet up
+  p->SetFlowHash (0); // the packet may be sent again, as part of another flow
   Ipv4Header ipHeader = ip;
 
   if ( !ipHeader.IsLastFragment () || ipHeader.GetFragmentOffset () != 0 )
@@ -1126,6 +1220,7 @@ Ipv4L3Protocol::AddAddress (uint32_t i, Ipv4InterfaceAddress address)
   NS_LOG_FUNCTION (this << i << address);
   Ptr<Ipv4Interface> interface = GetInterface (i);
   bool retVal = interface->AddAddress (address);
+  FlushRouteCache ();
   if (m_routingProtocol != 0)
     {
       m_routingProtocol->NotifyAddAddress (i, address);
@@ -1157,6 +1252,7 @@ Ipv4L3Protocol::RemoveAddress (uint32_t i, uint32_t addressIndex)
   Ipv4InterfaceAddress address = interface->RemoveAddress (addressIndex);
   if (address != Ipv4InterfaceAddress ())
     {
+      FlushRouteCache ();
       if (m_routingProtocol != 0)
         {
           m_routingProtocol->NotifyRemoveAddress (i, address);
@@ -1180,6 +1276,7 @@ Ipv4L3Protocol::RemoveAddress (uint32_t i, Ipv4Address address)
   Ipv4InterfaceAddress ifAddr = interface->RemoveAddress (address);
   if (ifAddr != Ipv4InterfaceAddress ())
     {
+      FlushRouteCache ();
       if (m_routingProtocol != 0)
         {
           m_routingProtocol->NotifyRemoveAddress (i, ifAddr);
@@ -1314,6 +1411,7 @@ Ipv4L3Protocol::SetUp (uint32_t i)
   if (interface->GetDevice ()->GetMtu () >= 68)
     {
       interface->SetUp ();
+      FlushRouteCache ();
 
       if (m_routingProtocol != 0)
         {
@@ -1332,6 +1430,7 @@ Ipv4L3Protocol::SetDown (uint32_t ifaceIndex)
   NS_LOG_FUNCTION (this << ifaceIndex);
   Ptr<Ipv4Interface> interface = GetInterface (ifaceIndex);
   interface->SetDown ();
+  FlushRouteCache ();
 
   if (m_routingProtocol != 0)
     {
@@ -1354,6 +1453,7 @@ Ipv4L3Protocol::SetForwarding (uint32_t i, bool val)
   NS_LOG_FUNCTION (this << i);
   Ptr<Ipv4Interface> interface = GetInterface (i);
   interface->SetForwarding (val);
+  FlushRouteCache ();
 }
 
 Ptr<NetDevice>
@@ -1372,6 +1472,7 @@ Ipv4L3Protocol::SetIpForward (bool forward)
     {
       (*i)->SetForwarding (forward);
     }
+  FlushRouteCache ();
 }
 
 bool 
@@ -1386,6 +1487,7 @@ Ipv4L3Protocol::SetWeakEsModel (bool model)
 {
   NS_LOG_FUNCTION (this << model);
   m_weakEsModel = model;
+  FlushRouteCache ();
 }
 
 bool 
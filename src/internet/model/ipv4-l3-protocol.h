@@ -23,6 +23,7 @@
 
 #include <list>
 #include <map>
+#include <unordered_map>
 #include <vector>
 #include <stdint.h>
 #include "ns3/ipv4-address.h"
@@ -327,6 +328,17 @@ private:
                Ptr<Packet> packet,
                Ipv4Header const &ipHeader);
 
+  /**
+   * \brief Split a TCP super-segment starting with its IPv4 header
+   *
+   * This is the segmenter registered in GsoTag for IPv4: each segment gets
+   * a copy of the IPv4 header with its own payload size.
+   *
+   * \param packet the super-segment
+   * \return the segments which are not lost, in sequence order
+   */
+  static std::list<Ptr<Packet> > SegmentGso (Ptr<const Packet> packet);
+
   /**
    * \brief Forward a packet.
    * \param rtentry route
@@ -338,6 +350,26 @@ private:
              Ptr<const Packet> p, 
              const Ipv4Header &header);
 
+  /**
+   * \brief Forward a packet, and cache the route given by the routing
+   * protocol for its destination and the input interface m_routeCacheIif.
+   * \param rtentry route
+   * \param p packet to forward
+   * \param header IPv4 header to add to the packet
+   */
+  void
+  IpForwardCached (Ptr<Ipv4Route> rtentry,
+                   Ptr<const Packet> p,
+                   const Ipv4Header &header);
+
+  /**
+   * \brief Drop the cached forwarding routes.
+   *
+   * Called when the routes of the routing protocol, or the interfaces and
+   * their addresses, change.
+   */
+  void FlushRouteCache (void);
+
   /**
    * \brief Forward a multicast packet.
    * \param mrtentry route
@@ -492,6 +524,16 @@ private:
 
   SocketList m_sockets; //!< List of IPv4 raw sockets.
 
+  /**
+   * \brief Container of the forwarding routes, keyed by the destination
+   * address (high 32 bits) and the input interface (low 32 bits).
+   */
+  typedef std::unordered_map<uint64_t, Ptr<Ipv4Route> > RouteCache_t;
+
+  bool m_routeCacheEnabled;   //!< Whether the forwarding routes are cached
+  RouteCache_t m_routeCache;  //!< Cached forwarding routes
+  uint32_t m_routeCacheIif;   //!< Input interface of the packet being routed, for IpForwardCached
+
   /**
    * \brief A Set of Fragment belonging to the same packet (src, dst, identification and proto)
    */
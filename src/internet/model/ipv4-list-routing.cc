@@ -69,6 +69,21 @@ Ipv4ListRouting::DoDispose (void)
   m_ipv4 = 0;
 }
 
+bool
+Ipv4ListRouting::IsRouteCacheable (void) const
+{
+  NS_LOG_FUNCTION (this);
+  for (Ipv4RoutingProtocolList::const_iterator i = m_routingProtocols.begin ();
+       i != m_routingProtocols.end (); i++)
+    {
+      if (!(*i).second->IsRouteCacheable ())
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
 void
 Ipv4ListRouting::PrintRoutingTable (Ptr<OutputStreamWrapper> stream, Time::Unit unit) const
 {
@@ -259,6 +274,8 @@ Ipv4ListRouting::AddRoutingProtocol (Ptr<Ipv4RoutingProtocol> routingProtocol, i
     {
       routingProtocol->SetIpv4 (m_ipv4);
     }
+  routingProtocol->SetRoutesChangedCallback (MakeCallback (&Ipv4ListRouting::NotifyRoutesChanged, this));
+  NotifyRoutesChanged ();
 }
 
 uint32_t 
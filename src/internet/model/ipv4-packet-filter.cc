@@ -24,8 +24,7 @@
 #include "ns3/log.h"
 #include "ns3/enum.h"
 #include "ns3/uinteger.h"
-#include "ns3/tcp-header.h"
-#include "ns3/udp-header.h"
+#include "ns3/hash.h"
 #include "ipv4-queue-disc-item.h"
 #include "ipv4-packet-filter.h"
 
@@ -96,56 +95,40 @@ int32_t
 FqCoDelIpv4PacketFilter::DoClassify (Ptr<QueueDiscItem> item) const
 {
   NS_LOG_FUNCTION (this << item);
-  Ptr<Ipv4QueueDiscItem> ipv4Item = DynamicCast<Ipv4QueueDiscItem> (item);
 
-  NS_ASSERT (ipv4Item != 0);
+  // the flow hash is computed from the 5-tuple only once per packet
+  uint32_t flowHash = item->GetFlowHash ();
 
-  Ipv4Header hdr = ipv4Item->GetHeader ();
-  Ipv4Address src = hdr.GetSource ();
-  Ipv4Address dest = hdr.GetDestination ();
-  uint8_t prot = hdr.GetProtocol ();
-  uint16_t fragOffset = hdr.GetFragmentOffset ();
+  NS_ASSERT (flowHash != 0);
 
-  TcpHeader tcpHdr;
-  UdpHeader udpHdr;
-  uint16_t srcPort = 0;
-  uint16_t destPort = 0;
-
-  Ptr<Packet> pkt = ipv4Item->GetPacket ();
-
-  if (prot == 6 && fragOffset == 0) // TCP
-    {
-      pkt->PeekHeader (tcpHdr);
-      srcPort = tcpHdr.GetSourcePort ();
-      destPort = tcpHdr.GetDestinationPort ();
-    }
-  else if (prot == 17 && fragOffset == 0) // UDP
+  if (m_perturbation == 0)
     {
-      pkt->PeekHeader (udpHdr);
-      srcPort = udpHdr.GetSourcePort ();
-      destPort = udpHdr.GetDestinationPort ();
+      return flowHash;
     }
 
-  /* serialize the 5-tuple and the perturbation in buf */
-  uint8_t buf[17];
-  src.Serialize (buf);
-  dest.Serialize (buf + 4);
-  buf[8] = prot;
-  buf[9] = (srcPort >> 8) & 0xff;
-  buf[10] = srcPort & 0xff;
-  buf[11] = (destPort >> 8) & 0xff;
-  buf[12] = destPort & 0xff;
-  buf[13] = (m_perturbation >> 24) & 0xff;
-  buf[14] = (m_perturbation >> 16) & 0xff;
-  buf[15] = (m_perturbation >> 8) & 0xff;
-  buf[16] = m_perturbation & 0xff;
+  /* serialize the flow hash and the perturbation in buf */
+  uint8_t buf[8];
+  buf[0] = (flowHash >> 24) & 0xff;
+  buf[1] = (flowHash >> 16) & 0xff;
+  buf[2] = (flowHash >> 8) & 0xff;
+  buf[3] = flowHash & 0xff;
+  buf[4] = (m_perturbation >> 24) & 0xff;
+  buf[5] = (m_perturbation >> 16) & 0xff;
+  buf[6] = (m_perturbation >> 8) & 0xff;
+  buf[7] = m_perturbation & 0xff;
 
   /* Linux calculates the jhash2 (jenkins hash), we calculate the murmur3 */
-  uint32_t hash = Hash32 ((char*) buf, 17);
+  uint32_t hash = Hash32 ((char*) buf, 8);
 
   NS_LOG_DEBUG ("Found Ipv4 packet; hash value " << hash);
 
   return hash;
 }
 
+bool
+FqCoDelIpv4PacketFilter::IsFlowBased (void) const
+{
+  return true;
+}
+
 } // namespace ns3
@@ -70,6 +70,8 @@ public:
   FqCoDelIpv4PacketFilter ();
   virtual ~FqCoDelIpv4PacketFilter ();
 
+  virtual bool IsFlowBased (void) const;
+
 private:
   virtual int32_t DoClassify (Ptr<QueueDiscItem> item) const;
 
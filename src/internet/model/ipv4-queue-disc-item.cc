@@ -17,6 +17,10 @@
  */
 
 #include "ns3/log.h"
+#include "ns3/hash.h"
+#include "ns3/gso-tag.h"
+#include "ns3/tcp-header.h"
+#include "ns3/udp-header.h"
 #include "ipv4-queue-disc-item.h"
 
 namespace ns3 {
@@ -66,6 +70,56 @@ void Ipv4QueueDiscItem::AddHeader (void)
   m_headerAdded = true;
 }
 
+uint32_t
+Ipv4QueueDiscItem::GetFlowHash (void) const
+{
+  NS_LOG_FUNCTION (this);
+  Ptr<Packet> pkt = GetPacket ();
+  uint32_t hash = pkt->GetFlowHash ();
+  if (hash != 0 || m_headerAdded)
+    {
+      return hash;
+    }
+
+  uint8_t prot = m_header.GetProtocol ();
+  uint16_t srcPort = 0;
+  uint16_t destPort = 0;
+
+  if (prot == 6 && m_header.GetFragmentOffset () == 0) // TCP
+    {
+      TcpHeader tcpHdr;
+      pkt->PeekHeader (tcpHdr);
+      srcPort = tcpHdr.GetSourcePort ();
+      destPort = tcpHdr.GetDestinationPort ();
+    }
+  else if (prot == 17 && m_header.GetFragmentOffset () == 0) // UDP
+    {
+      UdpHeader udpHdr;
+      pkt->PeekHeader (udpHdr);
+      srcPort = udpHdr.GetSourcePort ();
+      destPort = udpHdr.GetDestinationPort ();
+    }
+
+  /* serialize the 5-tuple in buf */
+  uint8_t buf[13];
+  m_header.GetSource ().Serialize (buf);
+  m_header.GetDestination ().Serialize (buf + 4);
+  buf[8] = prot;
+  buf[9] = (srcPort >> 8) & 0xff;
+  buf[10] = srcPort & 0xff;
+  buf[11] = (destPort >> 8) & 0xff;
+  buf[12] = destPort & 0xff;
+
+  // 0 means that the packet has no flow hash
+  hash = Hash32 ((char*) buf, 13);
+  hash = (hash == 0 ? 1 : hash);
+  pkt->SetFlowHash (hash);
+
+  NS_LOG_DEBUG ("Flow hash of the five tuple " << hash);
+
+  return hash;
+}
+
 void
 Ipv4QueueDiscItem::Print (std::ostream& os) const
 {
@@ -92,6 +146,39 @@ Ipv4QueueDiscItem::Mark (void)
   return false;
 }
 
+std::list<Ptr<QueueDiscItem> >
+Ipv4QueueDiscItem::SegmentGso (void) const
+{
+  NS_LOG_FUNCTION (this);
+  std::list<Ptr<QueueDiscItem> > items;
+  GsoTag::Segmenter segmenter = GsoTag::GetSegmenter (GetProtocol ());
+  if (segmenter.IsNull ())
+    {
+      return items;
+    }
+
+  Ptr<Packet> p = GetPacket ()->Copy ();
+  if (!m_headerAdded)
+    {
+      p->AddHeader (m_header);
+    }
+  std::list<Ptr<Packet> > segments = segmenter (p);
+  for (std::list<Ptr<Packet> >::iterator it = segments.begin (); it != segments.end (); ++it)
+    {
+      // The segmenter gives each segment its own header
+      Ipv4Header header;
+      (*it)->RemoveHeader (header);
+      Ptr<Ipv4QueueDiscItem> item = Create<Ipv4QueueDiscItem> (*it, GetAddress (), GetProtocol (), header);
+      item->SetTxQueueIndex (GetTxQueueIndex ());
+      if (m_headerAdded)
+        {
+          item->AddHeader ();
+        }
+      items.push_back (item);
+    }
+  return items;
+}
+
 
 bool
 Ipv4QueueDiscItem::GetUint8Value (QueueItem::Uint8Values field, uint8_t& value) const
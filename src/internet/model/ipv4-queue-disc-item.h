@@ -61,6 +61,14 @@ public:
    */
   virtual void AddHeader (void);
 
+  /**
+   * \brief Get the flow hash of the packet, computing it from the 5-tuple
+   *        and storing it in the packet if the packet has none yet.
+   * \return the flow hash, or 0 if the header has already been added to
+   *         the packet and the packet has no flow hash.
+   */
+  virtual uint32_t GetFlowHash (void) const;
+
   /**
    * \brief Print the item contents.
    * \param os output stream in which the data should be printed.
@@ -82,6 +90,13 @@ public:
    */
   virtual bool Mark (void);
 
+  /**
+   * \brief Split the super-segment included in this item, with the
+   *        segmenter registered for IPv4 in GsoTag
+   * \return the items of the segments which are not lost, in order
+   */
+  virtual std::list<Ptr<QueueDiscItem> > SegmentGso (void) const;
+
 private:
   /**
    * \brief Default constructor
@@ -36,4 +36,25 @@ TypeId Ipv4RoutingProtocol::GetTypeId (void)
   return tid;
 }
 
+bool
+Ipv4RoutingProtocol::IsRouteCacheable (void) const
+{
+  return false;
+}
+
+void
+Ipv4RoutingProtocol::SetRoutesChangedCallback (Callback<void> cb)
+{
+  m_routesChanged = cb;
+}
+
+void
+Ipv4RoutingProtocol::NotifyRoutesChanged (void)
+{
+  if (!m_routesChanged.IsNull ())
+    {
+      m_routesChanged ();
+    }
+}
+
 } // namespace ns3
@@ -171,6 +171,38 @@ public:
    */
   virtual void PrintRoutingTable (Ptr<OutputStreamWrapper> stream, Time::Unit unit = Time::S) const = 0;
 
+  /**
+   * \brief Whether the forwarding decisions of RouteInput may be cached
+   *
+   * A protocol returning true forwards the unicast packets to a destination,
+   * received on an interface, through the same route until it notifies a
+   * change of its routes (see SetRoutesChangedCallback), or until the
+   * interfaces or addresses of the node change.  The IPv4 stack may then
+   * forward those packets without calling RouteInput.
+   *
+   * \return false, unless overridden
+   */
+  virtual bool IsRouteCacheable (void) const;
+
+  /**
+   * \brief Set the callback invoked when the routes of the protocol change
+   *
+   * \param cb the callback, typically flushing the routes cached by the
+   * IPv4 stack or the routing protocol above this one
+   */
+  void SetRoutesChangedCallback (Callback<void> cb);
+
+protected:
+  /**
+   * \brief Notify that the routes of the protocol changed
+   *
+   * Protocols returning true from IsRouteCacheable must call it whenever
+   * their routes change.
+   */
+  void NotifyRoutesChanged (void);
+
+private:
+  Callback<void> m_routesChanged; //!< Callback invoked when the routes change
 };
 
 } // namespace ns3
@@ -54,7 +54,8 @@ Ipv4StaticRouting::GetTypeId (void)
 }
 
 Ipv4StaticRouting::Ipv4StaticRouting () 
-  : m_ipv4 (0)
+  : m_fibValid (false),
+    m_ipv4 (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -73,6 +74,8 @@ Ipv4StaticRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         nextHop,
                                                         interface);
   m_networkRoutes.push_back (make_pair (route,metric));
+  m_fibValid = false;
+  NotifyRoutesChanged ();
 }
 
 void 
@@ -87,6 +90,8 @@ Ipv4StaticRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         networkMask,
                                                         interface);
   m_networkRoutes.push_back (make_pair (route,metric));
+  m_fibValid = false;
+  NotifyRoutesChanged ();
 }
 
 void 
@@ -144,6 +149,8 @@ Ipv4StaticRouting::SetDefaultMulticastRoute (uint32_t outputInterface)
                                                         networkMask,
                                                         outputInterface);
   m_networkRoutes.push_back (make_pair (route,0));
+  m_fibValid = false;
+  NotifyRoutesChanged ();
 }
 
 uint32_t 
@@ -219,6 +226,26 @@ Ipv4StaticRouting::RemoveMulticastRoute (uint32_t index)
     }
 }
 
+void
+Ipv4StaticRouting::BuildFib (void)
+{
+  if (m_fibValid)
+    {
+      return;
+    }
+  NS_LOG_FUNCTION (this);
+  std::vector<Ipv4Fib::Prefix> prefixes;
+  prefixes.reserve (m_networkRoutes.size ());
+  m_fibRoutes.assign (m_networkRoutes.begin (), m_networkRoutes.end ());
+  for (uint32_t i = 0; i < m_fibRoutes.size (); i++)
+    {
+      prefixes.push_back (std::make_pair (m_fibRoutes[i].first->GetDestNetwork (),
+                                          m_fibRoutes[i].first->GetDestNetworkMask ()));
+    }
+  m_fib.Build (prefixes);
+  m_fibValid = true;
+}
+
 Ptr<Ipv4Route>
 Ipv4StaticRouting::LookupStatic (Ipv4Address dest, Ptr<NetDevice> oif)
 {
@@ -240,12 +267,17 @@ Ipv4StaticRouting::LookupStatic (Ipv4Address dest, Ptr<NetDevice> oif)
     }
 
 
-  for (NetworkRoutesI i = m_networkRoutes.begin (); 
-       i != m_networkRoutes.end (); 
-       i++) 
+  // The forwarding table returns the routes matching the destination, in
+  // the order of the list: the rules below select among them as they would
+  // among all the routes.
+  BuildFib ();
+  m_fib.Lookup (dest, m_matches);
+  for (std::vector<uint32_t>::const_iterator i = m_matches.begin ();
+       i != m_matches.end ();
+       i++)
     {
-      Ipv4RoutingTableEntry *j=i->first;
-      uint32_t metric =i->second;
+      Ipv4RoutingTableEntry *j = m_fibRoutes[*i].first;
+      uint32_t metric = m_fibRoutes[*i].second;
       Ipv4Mask mask = (j)->GetDestNetworkMask ();
       uint16_t masklen = mask.GetPrefixLength ();
       Ipv4Address entry = (j)->GetDestNetwork ();
@@ -449,6 +481,8 @@ Ipv4StaticRouting::RemoveRoute (uint32_t index)
         {
           delete j->first;
           m_networkRoutes.erase (j);
+          m_fibValid = false;
+          NotifyRoutesChanged ();
           return;
         }
       tmp++;
@@ -575,6 +609,8 @@ Ipv4StaticRouting::DoDispose (void)
     {
       delete (j->first);
     }
+  m_fibValid = false;
+  m_fibRoutes.clear ();
   for (MulticastRoutesI i = m_multicastRoutes.begin (); 
        i != m_multicastRoutes.end (); 
        i = m_multicastRoutes.erase (i)) 
@@ -615,6 +651,8 @@ Ipv4StaticRouting::NotifyInterfaceDown (uint32_t i)
         {
           delete it->first;
           it = m_networkRoutes.erase (it);
+          m_fibValid = false;
+          NotifyRoutesChanged ();
         }
       else
         {
@@ -662,6 +700,8 @@ Ipv4StaticRouting::NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress
         {
           delete it->first;
           it = m_networkRoutes.erase (it);
+          m_fibValid = false;
+          NotifyRoutesChanged ();
         }
       else
         {
@@ -688,6 +728,13 @@ Ipv4StaticRouting::SetIpv4 (Ptr<Ipv4> ipv4)
         }
     }
 }
+
+bool
+Ipv4StaticRouting::IsRouteCacheable (void) const
+{
+  return true;
+}
+
 // Formatted like output of "route -n" command
 void
 Ipv4StaticRouting::PrintRoutingTable (Ptr<OutputStreamWrapper> stream, Time::Unit unit) const
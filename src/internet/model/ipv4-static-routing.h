@@ -24,6 +24,7 @@
 
 #include <list>
 #include <utility>
+#include <vector>
 #include <stdint.h>
 #include "ns3/ipv4-address.h"
 #include "ns3/ipv4-header.h"
@@ -31,6 +32,7 @@
 #include "ns3/ptr.h"
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-routing-protocol.h"
+#include "ns3/ipv4-fib.h"
 
 namespace ns3 {
 
@@ -58,6 +60,10 @@ class Node;
  * Ipv4RoutingProtocol that defines the interface methods that a routing 
  * protocol must support.
  *
+ * The unicast lookups go through a forwarding table (Ipv4Fib) compiled
+ * from the network routes on the first lookup after a change of the
+ * routes.
+ *
  * \see Ipv4RoutingProtocol
  * \see Ipv4ListRouting
  * \see Ipv4ListRouting::AddRoutingProtocol
@@ -86,6 +92,7 @@ public:
   virtual void NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress address);
   virtual void SetIpv4 (Ptr<Ipv4> ipv4);
   virtual void PrintRoutingTable (Ptr<OutputStreamWrapper> stream, Time::Unit unit = Time::S) const;
+  virtual bool IsRouteCacheable (void) const;
 
 /**
  * \brief Add a network route to the static routing table.
@@ -413,11 +420,36 @@ private:
   Ptr<Ipv4MulticastRoute> LookupStatic (Ipv4Address origin, Ipv4Address group,
                                         uint32_t interface);
 
+  /**
+   * \brief Build the forwarding table, if the routes changed since
+   */
+  void BuildFib (void);
+
   /**
    * \brief the forwarding table for network.
    */
   NetworkRoutes m_networkRoutes;
 
+  /**
+   * \brief Whether the forwarding table is up to date.
+   */
+  bool m_fibValid;
+
+  /**
+   * \brief the compiled forwarding table for network.
+   */
+  Ipv4Fib m_fib;
+
+  /**
+   * \brief the routes of the compiled forwarding table, in list order.
+   */
+  std::vector<std::pair <Ipv4RoutingTableEntry *, uint32_t> > m_fibRoutes;
+
+  /**
+   * \brief the routes matching the last lookup.
+   */
+  std::vector<uint32_t> m_matches;
+
   /**
    * \brief the forwarding table for multicast.
    */
@@ -37,34 +37,37 @@ Ipv6EndPointDemux::Ipv6EndPointDemux ()
 Ipv6EndPointDemux::~Ipv6EndPointDemux ()
 {
   NS_LOG_FUNCTION_NOARGS ();
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  for (std::map<uint16_t, EndPoints>::iterator port = m_ports.begin (); port != m_ports.end (); port++)
     {
-      Ipv6EndPoint *endPoint = *i;
-      delete endPoint;
+      for (EndPointsI i = port->second.begin (); i != port->second.end (); i++)
+        {
+          Ipv6EndPoint *endPoint = *i;
+          endPoint->m_demux = 0;
+          delete endPoint;
+        }
     }
-  m_endPoints.clear ();
+  m_ports.clear ();
+  m_connected.clear ();
+  m_listening.clear ();
 }
 
 bool Ipv6EndPointDemux::LookupPortLocal (uint16_t port)
 {
   NS_LOG_FUNCTION (this << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
-    {
-      if ((*i)->GetLocalPort  () == port)
-        {
-          return true;
-        }
-    }
-  return false;
+  return m_ports.find (port) != m_ports.end ();
 }
 
 bool Ipv6EndPointDemux::LookupLocal (Ptr<NetDevice> boundNetDevice, Ipv6Address addr, uint16_t port)
 {
   NS_LOG_FUNCTION (this << addr << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  std::map<uint16_t, EndPoints>::iterator it = m_ports.find (port);
+  if (it == m_ports.end ())
+    {
+      return false;
+    }
+  for (EndPointsI i = it->second.begin (); i != it->second.end (); i++)
     {
-      if ((*i)->GetLocalPort () == port &&
-          (*i)->GetLocalAddress () == addr &&
+      if ((*i)->GetLocalAddress () == addr &&
           (*i)->GetBoundNetDevice () == boundNetDevice)
         {
           return true;
@@ -83,8 +86,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate ()
       return 0;
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (Ipv6Address::GetAny (), port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+  Insert (endPoint);
   return endPoint;
 }
 
@@ -98,8 +100,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address address)
       return 0;
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+  Insert (endPoint);
   return endPoint;
 }
 
@@ -119,8 +120,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ptr<NetDevice> boundNetDevice, Ipv6Ad
       return 0;
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+  Insert (endPoint);
   return endPoint;
 }
 
@@ -129,39 +129,46 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ptr<NetDevice> boundNetDevice,
                                            Ipv6Address peerAddress, uint16_t peerPort)
 {
   NS_LOG_FUNCTION (this << boundNetDevice << localAddress << localPort << peerAddress << peerPort);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  EndPoints *candidates = IsConnected (peerAddress, peerPort) ?
+    FindConnected (localPort, peerAddress, peerPort) : FindListening (localPort);
+  if (candidates != 0)
     {
-      if ((*i)->GetLocalPort () == localPort &&
-          (*i)->GetLocalAddress () == localAddress &&
-          (*i)->GetPeerPort () == peerPort &&
-          (*i)->GetPeerAddress () == peerAddress &&
-          ((*i)->GetBoundNetDevice () == boundNetDevice || (*i)->GetBoundNetDevice () == 0))
+      for (EndPointsI i = candidates->begin (); i != candidates->end (); i++)
         {
-          NS_LOG_WARN ("Duplicated endpoint.");
-          return 0;
+          if ((*i)->GetLocalPort () == localPort &&
+              (*i)->GetLocalAddress () == localAddress &&
+              (*i)->GetPeerPort () == peerPort &&
+              (*i)->GetPeerAddress () == peerAddress &&
+              ((*i)->GetBoundNetDevice () == boundNetDevice || (*i)->GetBoundNetDevice () == 0))
+            {
+              NS_LOG_WARN ("Duplicated endpoint.");
+              return 0;
+            }
         }
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (localAddress, localPort);
   endPoint->SetPeer (peerAddress, peerPort);
-  m_endPoints.push_back (endPoint);
-
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-
+  Insert (endPoint);
   return endPoint;
 }
 
 void Ipv6EndPointDemux::DeAllocate (Ipv6EndPoint *endPoint)
 {
   NS_LOG_FUNCTION (this);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  if (endPoint->m_demux != this)
     {
-      if (*i == endPoint)
-        {
-          delete endPoint;
-          m_endPoints.erase (i);
-          break;
-        }
+      return;
+    }
+  Unindex (endPoint);
+  std::map<uint16_t, EndPoints>::iterator port = m_ports.find (endPoint->GetLocalPort ());
+  NS_ASSERT (port != m_ports.end ());
+  port->second.erase (endPoint->m_demuxPosition);
+  if (port->second.empty ())
+    {
+      m_ports.erase (port);
     }
+  endPoint->m_demux = 0;
+  delete endPoint;
 }
 
 /*
@@ -181,99 +188,104 @@ Ipv6EndPointDemux::EndPoints Ipv6EndPointDemux::Lookup (Ipv6Address daddr, uint1
   EndPoints retval4; /* Exact match on all 4 */
 
   NS_LOG_DEBUG ("Looking up endpoint for destination address " << daddr);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
-    {
-      Ipv6EndPoint* endP = *i;
 
-      NS_LOG_DEBUG ("Looking at endpoint dport=" << endP->GetLocalPort ()
-                                                 << " daddr=" << endP->GetLocalAddress ()
-                                                 << " sport=" << endP->GetPeerPort ()
-                                                 << " saddr=" << endP->GetPeerAddress ());
+  /* Only the end points connected to the packet source and the ones with
+     a wildcard peer on the destination port can match */
+  EndPoints *candidates[2];
+  candidates[0] = IsConnected (saddr, sport) ? FindConnected (dport, saddr, sport) : 0;
+  candidates[1] = FindListening (dport);
 
-      if (!endP->IsRxEnabled ())
+  for (uint32_t c = 0; c < 2; c++)
+    {
+      if (candidates[c] == 0)
         {
-          NS_LOG_LOGIC ("Skipping endpoint " << &endP
-                        << " because endpoint can not receive packets");
           continue;
         }
-
-      if (endP->GetLocalPort () != dport)
+      for (EndPointsI i = candidates[c]->begin (); i != candidates[c]->end (); i++)
         {
-          NS_LOG_LOGIC ("Skipping endpoint " << &endP
-                                             << " because endpoint dport "
-                                             << endP->GetLocalPort ()
-                                             << " does not match packet dport " << dport);
-          continue;
-        }
+          Ipv6EndPoint* endP = *i;
 
-      if (endP->GetBoundNetDevice ())
-        {
-          if (!incomingInterface)
+          NS_LOG_DEBUG ("Looking at endpoint dport=" << endP->GetLocalPort ()
+                                                     << " daddr=" << endP->GetLocalAddress ()
+                                                     << " sport=" << endP->GetPeerPort ()
+                                                     << " saddr=" << endP->GetPeerAddress ());
+
+          if (!endP->IsRxEnabled ())
             {
+              NS_LOG_LOGIC ("Skipping endpoint " << &endP
+                            << " because endpoint can not receive packets");
               continue;
             }
-          if (endP->GetBoundNetDevice () != incomingInterface->GetDevice ())
+
+          if (endP->GetBoundNetDevice ())
             {
-              NS_LOG_LOGIC ("Skipping endpoint " << &endP
-                                                 << " because endpoint is bound to specific device and"
-                                                 << endP->GetBoundNetDevice ()
-                                                 << " does not match packet device " << incomingInterface->GetDevice ());
-              continue;
+              if (!incomingInterface)
+                {
+                  continue;
+                }
+              if (endP->GetBoundNetDevice () != incomingInterface->GetDevice ())
+                {
+                  NS_LOG_LOGIC ("Skipping endpoint " << &endP
+                                                     << " because endpoint is bound to specific device and"
+                                                     << endP->GetBoundNetDevice ()
+                                                     << " does not match packet device " << incomingInterface->GetDevice ());
+                  continue;
+                }
             }
-        }
 
-      /*    Ipv6Address incomingInterfaceAddr = incomingInterface->GetAddress (); */
-      NS_LOG_DEBUG ("dest addr " << daddr);
+          /*    Ipv6Address incomingInterfaceAddr = incomingInterface->GetAddress (); */
+          NS_LOG_DEBUG ("dest addr " << daddr);
 
-      bool localAddressMatchesWildCard = endP->GetLocalAddress () == Ipv6Address::GetAny ();
-      bool localAddressMatchesExact = endP->GetLocalAddress () == daddr;
-      bool localAddressMatchesAllRouters = endP->GetLocalAddress () == Ipv6Address::GetAllRoutersMulticast ();
+          bool localAddressMatchesWildCard = endP->GetLocalAddress () == Ipv6Address::GetAny ();
+          bool localAddressMatchesExact = endP->GetLocalAddress () == daddr;
+          bool localAddressMatchesAllRouters = endP->GetLocalAddress () == Ipv6Address::GetAllRoutersMulticast ();
 
-      /* if no match here, keep looking */
-      if (!(localAddressMatchesExact || localAddressMatchesWildCard))
-        {
-          continue;
-        }
-      bool remotePeerMatchesExact = endP->GetPeerPort () == sport;
-      bool remotePeerMatchesWildCard = endP->GetPeerPort () == 0;
-      bool remoteAddressMatchesExact = endP->GetPeerAddress () == saddr;
-      bool remoteAddressMatchesWildCard = endP->GetPeerAddress () == Ipv6Address::GetAny ();
-
-      /* If remote does not match either with exact or wildcard,i
-         skip this one */
-      if (!(remotePeerMatchesExact || remotePeerMatchesWildCard))
-        {
-          continue;
-        }
-      if (!(remoteAddressMatchesExact || remoteAddressMatchesWildCard))
-        {
-          continue;
-        }
+          /* if no match here, keep looking */
+          if (!(localAddressMatchesExact || localAddressMatchesWildCard))
+            {
+              continue;
+            }
+          bool remotePeerMatchesExact = endP->GetPeerPort () == sport;
+          bool remotePeerMatchesWildCard = endP->GetPeerPort () == 0;
+          bool remoteAddressMatchesExact = endP->GetPeerAddress () == saddr;
+          bool remoteAddressMatchesWildCard = endP->GetPeerAddress () == Ipv6Address::GetAny ();
+
+          /* If remote does not match either with exact or wildcard,i
+             skip this one */
+          if (!(remotePeerMatchesExact || remotePeerMatchesWildCard))
+            {
+              continue;
+            }
+          if (!(remoteAddressMatchesExact || remoteAddressMatchesWildCard))
+            {
+              continue;
+            }
 
-      /* Now figure out which return list to add this one to */
-      if (localAddressMatchesWildCard
-          && remotePeerMatchesWildCard
-          && remoteAddressMatchesWildCard)
-        { /* Only local port matches exactly */
-          retval1.push_back (endP);
-        }
-      if ((localAddressMatchesExact || (localAddressMatchesAllRouters))
-          && remotePeerMatchesWildCard
-          && remoteAddressMatchesWildCard)
-        { /* Only local port and local address matches exactly */
-          retval2.push_back (endP);
-        }
-      if (localAddressMatchesWildCard
-          && remotePeerMatchesExact
-          && remoteAddressMatchesExact)
-        { /* All but local address */
-          retval3.push_back (endP);
-        }
-      if (localAddressMatchesExact
-          && remotePeerMatchesExact
-          && remoteAddressMatchesExact)
-        { /* All 4 match */
-          retval4.push_back (endP);
+          /* Now figure out which return list to add this one to */
+          if (localAddressMatchesWildCard
+              && remotePeerMatchesWildCard
+              && remoteAddressMatchesWildCard)
+            { /* Only local port matches exactly */
+              retval1.push_back (endP);
+            }
+          if ((localAddressMatchesExact || (localAddressMatchesAllRouters))
+              && remotePeerMatchesWildCard
+              && remoteAddressMatchesWildCard)
+            { /* Only local port and local address matches exactly */
+              retval2.push_back (endP);
+            }
+          if (localAddressMatchesWildCard
+              && remotePeerMatchesExact
+              && remoteAddressMatchesExact)
+            { /* All but local address */
+              retval3.push_back (endP);
+            }
+          if (localAddressMatchesExact
+              && remotePeerMatchesExact
+              && remoteAddressMatchesExact)
+            { /* All 4 match */
+              retval4.push_back (endP);
+            }
         }
     }
 
@@ -293,15 +305,15 @@ Ipv6EndPoint* Ipv6EndPointDemux::SimpleLookup (Ipv6Address dst, uint16_t dport,
   uint32_t genericity = 3;
   Ipv6EndPoint *generic = 0;
 
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  std::map<uint16_t, EndPoints>::iterator port = m_ports.find (dport);
+  if (port == m_ports.end ())
+    {
+      return 0;
+    }
+  for (EndPointsI i = port->second.begin (); i != port->second.end (); i++)
     {
       uint32_t tmp = 0;
 
-      if ((*i)->GetLocalPort () != dport)
-        {
-          continue;
-        }
-
       if ((*i)->GetLocalAddress () == dst && (*i)->GetPeerPort () == sport
           && (*i)->GetPeerAddress () == src)
         {
@@ -352,7 +364,103 @@ uint16_t Ipv6EndPointDemux::AllocateEphemeralPort ()
 
 Ipv6EndPointDemux::EndPoints Ipv6EndPointDemux::GetEndPoints () const
 {
-  return m_endPoints;
+  EndPoints ret;
+  for (std::map<uint16_t, EndPoints>::const_iterator port = m_ports.begin (); port != m_ports.end (); port++)
+    {
+      ret.insert (ret.end (), port->second.begin (), port->second.end ());
+    }
+  return ret;
+}
+
+void Ipv6EndPointDemux::Insert (Ipv6EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  EndPoints &port = m_ports[endPoint->GetLocalPort ()];
+  endPoint->m_demuxPosition = port.insert (port.end (), endPoint);
+  endPoint->m_demux = this;
+  Index (endPoint);
+  NS_LOG_DEBUG ("Now have >>" << port.size () << "<< endpoints on port " << endPoint->GetLocalPort ());
+}
+
+void Ipv6EndPointDemux::Index (Ipv6EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  if (IsConnected (endPoint->GetPeerAddress (), endPoint->GetPeerPort ()))
+    {
+      m_connected[GetConnectionKey (endPoint->GetLocalPort (), endPoint->GetPeerAddress (),
+                                    endPoint->GetPeerPort ())].push_back (endPoint);
+    }
+  else
+    {
+      m_listening[endPoint->GetLocalPort ()].push_back (endPoint);
+    }
+}
+
+void Ipv6EndPointDemux::Unindex (Ipv6EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  if (IsConnected (endPoint->GetPeerAddress (), endPoint->GetPeerPort ()))
+    {
+      std::unordered_map<ConnectionKey, EndPoints, ConnectionKeyHash>::iterator it =
+        m_connected.find (GetConnectionKey (endPoint->GetLocalPort (), endPoint->GetPeerAddress (),
+                                            endPoint->GetPeerPort ()));
+      NS_ASSERT (it != m_connected.end ());
+      it->second.remove (endPoint);
+      if (it->second.empty ())
+        {
+          m_connected.erase (it);
+        }
+    }
+  else
+    {
+      std::unordered_map<uint16_t, EndPoints>::iterator it = m_listening.find (endPoint->GetLocalPort ());
+      NS_ASSERT (it != m_listening.end ());
+      it->second.remove (endPoint);
+      if (it->second.empty ())
+        {
+          m_listening.erase (it);
+        }
+    }
+}
+
+bool Ipv6EndPointDemux::IsConnected (Ipv6Address peerAddress, uint16_t peerPort)
+{
+  return peerPort != 0 && peerAddress != Ipv6Address::GetAny ();
+}
+
+Ipv6EndPointDemux::ConnectionKey
+Ipv6EndPointDemux::GetConnectionKey (uint16_t localPort, Ipv6Address peerAddress, uint16_t peerPort)
+{
+  ConnectionKey key;
+  key.peerAddress = peerAddress;
+  key.localPort = localPort;
+  key.peerPort = peerPort;
+  return key;
+}
+
+Ipv6EndPointDemux::EndPoints *
+Ipv6EndPointDemux::FindConnected (uint16_t localPort, Ipv6Address peerAddress, uint16_t peerPort)
+{
+  std::unordered_map<ConnectionKey, EndPoints, ConnectionKeyHash>::iterator it =
+    m_connected.find (GetConnectionKey (localPort, peerAddress, peerPort));
+  return it == m_connected.end () ? 0 : &it->second;
+}
+
+Ipv6EndPointDemux::EndPoints *
+Ipv6EndPointDemux::FindListening (uint16_t localPort)
+{
+  std::unordered_map<uint16_t, EndPoints>::iterator it = m_listening.find (localPort);
+  return it == m_listening.end () ? 0 : &it->second;
+}
+
+bool Ipv6EndPointDemux::ConnectionKey::operator== (const ConnectionKey &other) const
+{
+  return localPort == other.localPort && peerPort == other.peerPort && peerAddress == other.peerAddress;
+}
+
+size_t Ipv6EndPointDemux::ConnectionKeyHash::operator() (const ConnectionKey &key) const
+{
+  return Ipv6AddressHash () (key.peerAddress) ^ ((static_cast<size_t> (key.localPort) << 16) | key.peerPort);
 }
 
 } /* namespace ns3 */
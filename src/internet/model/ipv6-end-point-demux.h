@@ -23,6 +23,8 @@
 
 #include <stdint.h>
 #include <list>
+#include <map>
+#include <unordered_map>
 #include "ns3/ipv6-address.h"
 #include "ipv6-interface.h"
 
@@ -34,6 +36,10 @@ class Ipv6EndPoint;
  * \ingroup ipv6
  *
  * \brief Demultiplexer for end points.
+ *
+ * As in ns3::Ipv4EndPointDemux, end points with a fully specified peer
+ * are indexed by local port, peer address and peer port, and the other
+ * ones by local port only.
  */
 class Ipv6EndPointDemux
 {
@@ -153,12 +159,95 @@ public:
   EndPoints GetEndPoints () const;
 
 private:
+  friend class Ipv6EndPoint;
+
+  /**
+   * \brief Key of the connected end points.
+   */
+  struct ConnectionKey
+  {
+    Ipv6Address peerAddress; //!< peer address
+    uint16_t localPort;      //!< local port
+    uint16_t peerPort;       //!< peer port
+
+    /**
+     * \brief Comparison operator.
+     * \param other the other key
+     * \return true if the keys are equal
+     */
+    bool operator== (const ConnectionKey &other) const;
+  };
+
+  /**
+   * \brief Hash function of the keys of the connected end points.
+   */
+  struct ConnectionKeyHash
+  {
+    /**
+     * \brief Hash a key.
+     * \param key the key
+     * \return the hash
+     */
+    size_t operator() (const ConnectionKey &key) const;
+  };
+
   /**
    * \brief Allocate a ephemeral port.
    * \return a port
    */
   uint16_t AllocateEphemeralPort ();
 
+  /**
+   * \brief Add a newly created end point to the demux.
+   * \param endPoint the end point
+   */
+  void Insert (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Index an end point according to its peer.
+   * \param endPoint the end point
+   */
+  void Index (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Remove an end point from the index of its peer.
+   * \param endPoint the end point
+   */
+  void Unindex (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Check whether a peer is fully specified.
+   * \param peerAddress peer address
+   * \param peerPort peer port
+   * \return true if neither the peer address nor the peer port are wildcards
+   */
+  static bool IsConnected (Ipv6Address peerAddress, uint16_t peerPort);
+
+  /**
+   * \brief Get the key of the connected end points.
+   * \param localPort local port
+   * \param peerAddress peer address
+   * \param peerPort peer port
+   * \return the key
+   */
+  static ConnectionKey GetConnectionKey (uint16_t localPort, Ipv6Address peerAddress, uint16_t peerPort);
+
+  /**
+   * \brief Find the end points connected to a peer.
+   * \param localPort local port
+   * \param peerAddress peer address
+   * \param peerPort peer port
+   * \return the end points (0 if none)
+   */
+  EndPoints *FindConnected (uint16_t localPort, Ipv6Address peerAddress, uint16_t peerPort);
+
+  /**
+   * \brief Find the end points of a local port with a wildcard peer.
+   * \param localPort local port
+   * \return the end points (0 if none)
+   */
+  EndPoints *FindListening (uint16_t localPort);
+
   /**
    * \brief The ephemeral port.
    */
@@ -175,9 +264,19 @@ private:
   uint16_t m_portLast;
 
   /**
-   * \brief A list of IPv6 end points.
+   * \brief The IPv6 end points of each local port, in allocation order.
+   */
+  std::map<uint16_t, EndPoints> m_ports;
+
+  /**
+   * \brief The IPv6 end points with a fully specified peer.
+   */
+  std::unordered_map<ConnectionKey, EndPoints, ConnectionKeyHash> m_connected;
+
+  /**
+   * \brief The other IPv6 end points, by local port.
    */
-  EndPoints m_endPoints;
+  std::unordered_map<uint16_t, EndPoints> m_listening;
 };
 
 } /* namespace ns3 */
@@ -22,6 +22,7 @@
 #define IPV6_END_POINT_H
 
 #include <stdint.h>
+#include <list>
 
 #include "ns3/ipv6-address.h"
 #include "ns3/callback.h"
@@ -34,6 +35,7 @@ namespace ns3
 
 class Header;
 class Packet;
+class Ipv6EndPointDemux;
 
 /**
  * \ingroup ipv6
@@ -236,6 +238,21 @@ private:
    * \brief true if the endpoint can receive packets.
    */
   bool m_rxEnabled;
+
+  friend class Ipv6EndPointDemux;
+
+  /**
+   * \brief The demux indexing this end point (if any).
+   *
+   * The demux is notified when the peer changes, as it indexes
+   * connected end points by their peer.
+   */
+  Ipv6EndPointDemux *m_demux;
+
+  /**
+   * \brief Position of this end point in the demux list of its local port.
+   */
+  std::list<Ipv6EndPoint *>::iterator m_demuxPosition;
 };
 
 } /* namespace ns3 */
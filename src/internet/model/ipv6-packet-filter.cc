@@ -24,8 +24,7 @@
 #include "ns3/log.h"
 #include "ns3/enum.h"
 #include "ns3/uinteger.h"
-#include "ns3/tcp-header.h"
-#include "ns3/udp-header.h"
+#include "ns3/hash.h"
 #include "ipv6-queue-disc-item.h"
 #include "ipv6-packet-filter.h"
 
@@ -93,58 +92,43 @@ FqCoDelIpv6PacketFilter::~FqCoDelIpv6PacketFilter ()
 }
 
 int32_t
-FqCoDelIpv6PacketFilter::DoClassify (Ptr< QueueDiscItem > item) const
+FqCoDelIpv6PacketFilter::DoClassify (Ptr<QueueDiscItem> item) const
 {
   NS_LOG_FUNCTION (this << item);
-  Ptr<Ipv6QueueDiscItem> ipv6Item = DynamicCast<Ipv6QueueDiscItem> (item);
 
-  NS_ASSERT (ipv6Item != 0);
+  // the flow hash is computed from the 5-tuple only once per packet
+  uint32_t flowHash = item->GetFlowHash ();
 
-  Ipv6Header hdr = ipv6Item->GetHeader ();
-  Ipv6Address src = hdr.GetSourceAddress ();
-  Ipv6Address dest = hdr.GetDestinationAddress ();
-  uint8_t prot = hdr.GetNextHeader ();
+  NS_ASSERT (flowHash != 0);
 
-  TcpHeader tcpHdr;
-  UdpHeader udpHdr;
-  uint16_t srcPort = 0;
-  uint16_t destPort = 0;
-
-  Ptr<Packet> pkt = ipv6Item->GetPacket ();
-
-  if (prot == 6) // TCP
-    {
-      pkt->PeekHeader (tcpHdr);
-      srcPort = tcpHdr.GetSourcePort ();
-      destPort = tcpHdr.GetDestinationPort ();
-    }
-  else if (prot == 17) // UDP
+  if (m_perturbation == 0)
     {
-      pkt->PeekHeader (udpHdr);
-      srcPort = udpHdr.GetSourcePort ();
-      destPort = udpHdr.GetDestinationPort ();
+      return flowHash;
     }
 
-  /* serialize the 5-tuple and the perturbation in buf */
-  uint8_t buf[41];
-  src.Serialize (buf);
-  dest.Serialize (buf + 16);
-  buf[32] = prot;
-  buf[33] = (srcPort >> 8) & 0xff;
-  buf[34] = srcPort & 0xff;
-  buf[35] = (destPort >> 8) & 0xff;
-  buf[36] = destPort & 0xff;
-  buf[37] = (m_perturbation >> 24) & 0xff;
-  buf[38] = (m_perturbation >> 16) & 0xff;
-  buf[39] = (m_perturbation >> 8) & 0xff;
-  buf[40] = m_perturbation & 0xff;
+  /* serialize the flow hash and the perturbation in buf */
+  uint8_t buf[8];
+  buf[0] = (flowHash >> 24) & 0xff;
+  buf[1] = (flowHash >> 16) & 0xff;
+  buf[2] = (flowHash >> 8) & 0xff;
+  buf[3] = flowHash & 0xff;
+  buf[4] = (m_perturbation >> 24) & 0xff;
+  buf[5] = (m_perturbation >> 16) & 0xff;
+  buf[6] = (m_perturbation >> 8) & 0xff;
+  buf[7] = m_perturbation & 0xff;
 
   /* Linux calculates the jhash2 (jenkins hash), we calculate the murmur3 */
-  uint32_t hash = Hash32 ((char*) buf, 41);
+  uint32_t hash = Hash32 ((char*) buf, 8);
 
-  NS_LOG_DEBUG ("Found Ipv6 packet; hash of the five tuple " << hash);
+  NS_LOG_DEBUG ("Found Ipv6 packet; hash value " << hash);
 
   return hash;
 }
 
+bool
+FqCoDelIpv6PacketFilter::IsFlowBased (void) const
+{
+  return true;
+}
+
 } // namespace ns3
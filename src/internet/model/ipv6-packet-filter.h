@@ -70,6 +70,8 @@ public:
   FqCoDelIpv6PacketFilter ();
   virtual ~FqCoDelIpv6PacketFilter ();
 
+  virtual bool IsFlowBased (void) const;
+
 private:
   virtual int32_t DoClassify (Ptr<QueueDiscItem> item) const;
 
@@ -17,6 +17,9 @@
  */
 
 #include "ns3/log.h"
+#include "ns3/hash.h"
+#include "ns3/tcp-header.h"
+#include "ns3/udp-header.h"
 #include "ipv6-queue-disc-item.h"
 
 namespace ns3 {
@@ -66,6 +69,56 @@ void Ipv6QueueDiscItem::AddHeader (void)
   m_headerAdded = true;
 }
 
+uint32_t
+Ipv6QueueDiscItem::GetFlowHash (void) const
+{
+  NS_LOG_FUNCTION (this);
+  Ptr<Packet> pkt = GetPacket ();
+  uint32_t hash = pkt->GetFlowHash ();
+  if (hash != 0 || m_headerAdded)
+    {
+      return hash;
+    }
+
+  uint8_t prot = m_header.GetNextHeader ();
+  uint16_t srcPort = 0;
+  uint16_t destPort = 0;
+
+  if (prot == 6) // TCP
+    {
+      TcpHeader tcpHdr;
+      pkt->PeekHeader (tcpHdr);
+      srcPort = tcpHdr.GetSourcePort ();
+      destPort = tcpHdr.GetDestinationPort ();
+    }
+  else if (prot == 17) // UDP
+    {
+      UdpHeader udpHdr;
+      pkt->PeekHeader (udpHdr);
+      srcPort = udpHdr.GetSourcePort ();
+      destPort = udpHdr.GetDestinationPort ();
+    }
+
+  /* serialize the 5-tuple in buf */
+  uint8_t buf[37];
+  m_header.GetSourceAddress ().Serialize (buf);
+  m_header.GetDestinationAddress ().Serialize (buf + 16);
+  buf[32] = prot;
+  buf[33] = (srcPort >> 8) & 0xff;
+  buf[34] = srcPort & 0xff;
+  buf[35] = (destPort >> 8) & 0xff;
+  buf[36] = destPort & 0xff;
+
+  // 0 means that the packet has no flow hash
+  hash = Hash32 ((char*) buf, 37);
+  hash = (hash == 0 ? 1 : hash);
+  pkt->SetFlowHash (hash);
+
+  NS_LOG_DEBUG ("Flow hash of the five tuple " << hash);
+
+  return hash;
+}
+
 void
 Ipv6QueueDiscItem::Print (std::ostream& os) const
 {
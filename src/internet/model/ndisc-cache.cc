@@ -94,9 +94,9 @@ NdiscCache::Entry* NdiscCache::Lookup (Ipv6Address dst)
 {
   NS_LOG_FUNCTION (this << dst);
 
-  if (m_ndCache.find (dst) != m_ndCache.end ())
+  NdiscCache::Entry* entry = m_ndCache.Find (dst);
+  if (entry != 0)
     {
-      NdiscCache::Entry* entry = m_ndCache[dst];
       NS_LOG_LOGIC ("Found an entry:" << dst << " to " << entry->GetMacAddress ());
       return entry;
     }
@@ -111,10 +111,10 @@ std::list<NdiscCache::Entry*> NdiscCache::LookupInverse (Address dst)
   std::list<NdiscCache::Entry *> entryList;
   for (CacheI i = m_ndCache.begin (); i != m_ndCache.end (); i++)
     {
-      NdiscCache::Entry *entry = (*i).second;
+      NdiscCache::Entry *entry = i->entry;
       if (entry->GetMacAddress () == dst)
         {
-          NS_LOG_LOGIC ("Found an entry:" << (*i).first << " to " << (*i).second);
+          NS_LOG_LOGIC ("Found an entry:" << i->address << " to " << i->entry);
           entryList.push_back (entry);
         }
     }
@@ -125,11 +125,11 @@ std::list<NdiscCache::Entry*> NdiscCache::LookupInverse (Address dst)
 NdiscCache::Entry* NdiscCache::Add (Ipv6Address to)
 {
   NS_LOG_FUNCTION (this << to);
-  NS_ASSERT (m_ndCache.find (to) == m_ndCache.end ());
+  NS_ASSERT (m_ndCache.Find (to) == 0);
 
   NdiscCache::Entry* entry = new NdiscCache::Entry (this);
   entry->SetIpv6Address (to);
-  m_ndCache[to] = entry;
+  m_ndCache.Insert (to, entry);
   return entry;
 }
 
@@ -137,16 +137,25 @@ void NdiscCache::Remove (NdiscCache::Entry* entry)
 {
   NS_LOG_FUNCTION_NOARGS ();
 
-  for (CacheI i = m_ndCache.begin (); i != m_ndCache.end (); i++)
+  Ipv6Address address = entry->GetIpv6Address ();
+  if (m_ndCache.Find (address) != entry)
     {
-      if ((*i).second == entry)
+      // the address of the entry was changed after it was added
+      for (CacheI i = m_ndCache.begin (); i != m_ndCache.end (); i++)
         {
-          m_ndCache.erase (i);
-          entry->ClearWaitingPacket ();
-          delete entry;
-          return;
+          if (i->entry == entry)
+            {
+              address = i->address;
+              break;
+            }
         }
     }
+  if (m_ndCache.Find (address) == entry)
+    {
+      m_ndCache.Erase (address);
+      entry->ClearWaitingPacket ();
+      delete entry;
+    }
 }
 
 void NdiscCache::Flush ()
@@ -155,10 +164,10 @@ void NdiscCache::Flush ()
 
   for (CacheI i = m_ndCache.begin (); i != m_ndCache.end (); i++)
     {
-      delete (*i).second; /* delete the pointer NdiscCache::Entry */
+      delete i->entry; /* delete the pointer NdiscCache::Entry */
     }
 
-  m_ndCache.erase (m_ndCache.begin (), m_ndCache.end ());
+  m_ndCache.Clear ();
 }
 
 void NdiscCache::SetUnresQlen (uint32_t unresQlen)
@@ -180,7 +189,7 @@ void NdiscCache::PrintNdiscCache (Ptr<OutputStreamWrapper> stream)
 
   for (CacheI i = m_ndCache.begin (); i != m_ndCache.end (); i++)
     {
-      *os << i->first << " dev ";
+      *os << i->address << " dev ";
       std::string found = Names::FindName (m_device);
       if (Names::FindName (m_device) != "")
         {
@@ -191,29 +200,29 @@ void NdiscCache::PrintNdiscCache (Ptr<OutputStreamWrapper> stream)
           *os << static_cast<int> (m_device->GetIfIndex ());
         }
 
-      *os << " lladdr " << i->second->GetMacAddress ();
+      *os << " lladdr " << i->entry->GetMacAddress ();
 
-      if (i->second->IsReachable ())
+      if (i->entry->IsReachable ())
         {
           *os << " REACHABLE\n";
         }
-      else if (i->second->IsDelay ())
+      else if (i->entry->IsDelay ())
         {
           *os << " DELAY\n";
         }
-      else if (i->second->IsIncomplete ())
+      else if (i->entry->IsIncomplete ())
         {
           *os << " INCOMPLETE\n";
         }
-      else if (i->second->IsProbe ())
+      else if (i->entry->IsProbe ())
         {
           *os << " PROBE\n";
         }
-      else if (i->second->IsStale ())
+      else if (i->entry->IsStale ())
         {
           *os << " STALE\n";
         }
-      else if (i->second->IsPermanent ())
+      else if (i->entry->IsPermanent ())
 	{
 	  *os << " PERMANENT\n";
 	}
@@ -408,6 +417,12 @@ void NdiscCache::Entry::SetIpv6Address (Ipv6Address ipv6Address)
   m_ipv6Address = ipv6Address;
 }
 
+Ipv6Address NdiscCache::Entry::GetIpv6Address (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_ipv6Address;
+}
+
 Time NdiscCache::Entry::GetLastReachabilityConfirmation () const
 {
   NS_LOG_FUNCTION_NOARGS ();
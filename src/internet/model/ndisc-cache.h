@@ -30,8 +30,8 @@
 #include "ns3/ipv6-address.h"
 #include "ns3/ptr.h"
 #include "ns3/timer.h"
-#include "ns3/sgi-hashmap.h"
 #include "ns3/output-stream-wrapper.h"
+#include "neighbor-cache-table.h"
 
 namespace ns3
 {
@@ -342,6 +342,12 @@ public:
      */
     void SetIpv6Address (Ipv6Address ipv6Address);
 
+    /**
+     * \brief Get the IPv6 address.
+     * \return the IPv6 address
+     */
+    Ipv6Address GetIpv6Address (void) const;
+
 private:
     /**
      * \brief The IPv6 address.
@@ -406,11 +412,11 @@ private:
   /**
    * \brief Neighbor Discovery Cache container
    */
-  typedef sgi::hash_map<Ipv6Address, NdiscCache::Entry *, Ipv6AddressHash> Cache;
+  typedef NeighborCacheTable<Ipv6Address, NdiscCache::Entry, Ipv6AddressHash> Cache;
   /**
    * \brief Neighbor Discovery Cache container iterator
    */
-  typedef sgi::hash_map<Ipv6Address, NdiscCache::Entry *, Ipv6AddressHash>::iterator CacheI;
+  typedef Cache::Iterator CacheI;
 
   /**
    * \brief Copy constructor.
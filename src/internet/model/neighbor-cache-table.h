@@ -0,0 +1,283 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef NEIGHBOR_CACHE_TABLE_H
+#define NEIGHBOR_CACHE_TABLE_H
+
+#include <stdint.h>
+#include <vector>
+#include "ns3/assert.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup internet
+ *
+ * \brief Open-addressing hash table of the entries of a neighbor cache
+ * (ARP or NDISC), keyed by their layer 3 address
+ *
+ * The addresses and the pointers to the entries are held inline in a
+ * single array of slots, probed linearly from the hash of the address:
+ * a lookup reads a few adjacent slots instead of following the nodes of a
+ * chained hash map.  The entries themselves are owned by the cache and
+ * never move, so that the pointers handed out by the cache, and the
+ * timers of the entries bound to them, stay valid.
+ *
+ * The table is at most half full.  Removals shift the following slots of
+ * the probe sequence back, leaving no tombstones; they invalidate the
+ * iterators.
+ *
+ * \tparam A the address type
+ * \tparam E the entry type
+ * \tparam H the hash function of the addresses
+ */
+template <typename A, typename E, typename H>
+class NeighborCacheTable
+{
+public:
+  /// A slot of the table
+  struct Slot
+  {
+    A address;  //!< The address of the entry
+    E *entry;   //!< The entry, or null if the slot is free
+  };
+
+  /// Iterator over the used slots of the table, in slot order
+  class Iterator
+  {
+public:
+    /**
+     * \param slot the slot
+     * \param end the end of the slots
+     */
+    Iterator (Slot *slot, Slot *end)
+      : m_slot (slot),
+        m_end (end)
+    {
+      Skip ();
+    }
+    /// \return the slot
+    Slot & operator* (void) const
+    {
+      return *m_slot;
+    }
+    /// \return the slot
+    Slot * operator-> (void) const
+    {
+      return m_slot;
+    }
+    /// \return the iterator, moved to the next used slot
+    Iterator & operator++ (void)
+    {
+      m_slot++;
+      Skip ();
+      return *this;
+    }
+    /// \return the iterator before it moved to the next used slot
+    Iterator operator++ (int)
+    {
+      Iterator it = *this;
+      ++(*this);
+      return it;
+    }
+    /**
+     * \param o another iterator
+     * \return whether the iterators are at the same slot
+     */
+    bool operator== (const Iterator &o) const
+    {
+      return m_slot == o.m_slot;
+    }
+    /**
+     * \param o another iterator
+     * \return whether the iterators are at different slots
+     */
+    bool operator!= (const Iterator &o) const
+    {
+      return m_slot != o.m_slot;
+    }
+
+private:
+    /// Move to the first used slot from the current one
+    void Skip (void)
+    {
+      while (m_slot != m_end && m_slot->entry == 0)
+        {
+          m_slot++;
+        }
+    }
+    Slot *m_slot;  //!< The current slot
+    Slot *m_end;   //!< The end of the slots
+  };
+
+  NeighborCacheTable ()
+    : m_mask (0),
+      m_size (0)
+  {
+  }
+
+  /// \return an iterator at the first used slot
+  Iterator begin (void)
+  {
+    return Iterator (m_slots.empty () ? 0 : &m_slots[0], End ());
+  }
+
+  /// \return an iterator past the last slot
+  Iterator end (void)
+  {
+    return Iterator (End (), End ());
+  }
+
+  /// \return the number of entries
+  uint32_t size (void) const
+  {
+    return m_size;
+  }
+
+  /**
+   * \param address an address
+   * \return the entry of the address, or null if none
+   */
+  E * Find (const A &address) const
+  {
+    if (m_size == 0)
+      {
+        return 0;
+      }
+    for (uint32_t i = Home (address); ; i = (i + 1) & m_mask)
+      {
+        const Slot &slot = m_slots[i];
+        if (slot.entry == 0)
+          {
+            return 0;
+          }
+        if (slot.address == address)
+          {
+            return slot.entry;
+          }
+      }
+  }
+
+  /**
+   * \brief Add the entry of an address not in the table
+   * \param address the address
+   * \param entry the entry
+   */
+  void Insert (const A &address, E *entry)
+  {
+    NS_ASSERT (entry != 0 && Find (address) == 0);
+    if (2 * (m_size + 1) > m_slots.size ())
+      {
+        Grow ();
+      }
+    uint32_t i = Home (address);
+    while (m_slots[i].entry != 0)
+      {
+        i = (i + 1) & m_mask;
+      }
+    m_slots[i].address = address;
+    m_slots[i].entry = entry;
+    m_size++;
+  }
+
+  /**
+   * \brief Remove the entry of an address
+   * \param address the address
+   * \return the entry removed, or null if none
+   */
+  E * Erase (const A &address)
+  {
+    if (m_size == 0)
+      {
+        return 0;
+      }
+    uint32_t i = Home (address);
+    while (m_slots[i].entry != 0 && !(m_slots[i].address == address))
+      {
+        i = (i + 1) & m_mask;
+      }
+    E *entry = m_slots[i].entry;
+    if (entry == 0)
+      {
+        return 0;
+      }
+    // Shift back the following slots which the hole would cut off from
+    // their home slot
+    for (uint32_t j = (i + 1) & m_mask; m_slots[j].entry != 0; j = (j + 1) & m_mask)
+      {
+        uint32_t home = Home (m_slots[j].address);
+        if (((j - home) & m_mask) >= ((j - i) & m_mask))
+          {
+            m_slots[i] = m_slots[j];
+            i = j;
+          }
+      }
+    m_slots[i].entry = 0;
+    m_size--;
+    return entry;
+  }
+
+  /// Remove all the entries, without deleting them
+  void Clear (void)
+  {
+    m_slots.clear ();
+    m_size = 0;
+  }
+
+private:
+  /// \return the end of the slots
+  Slot * End (void)
+  {
+    return m_slots.empty () ? 0 : &m_slots[0] + m_slots.size ();
+  }
+
+  /**
+   * \param address an address
+   * \return the first slot probed for the address
+   */
+  uint32_t Home (const A &address) const
+  {
+    // Fibonacci hashing spreads the consecutive addresses of a subnet
+    uint64_t hash = static_cast<uint64_t> (H () (address)) * 0x9e3779b97f4a7c15ULL;
+    return static_cast<uint32_t> (hash >> 32) & m_mask;
+  }
+
+  /// Double the number of slots, and put the entries back in place
+  void Grow (void)
+  {
+    std::vector<Slot> slots;
+    slots.swap (m_slots);
+    Slot free = { A (), 0 };
+    m_slots.resize (slots.empty () ? 8 : 2 * slots.size (), free);
+    m_mask = m_slots.size () - 1;
+    m_size = 0;
+    for (typename std::vector<Slot>::const_iterator it = slots.begin (); it != slots.end (); it++)
+      {
+        if (it->entry != 0)
+          {
+            Insert (it->address, it->entry);
+          }
+      }
+  }
+
+  std::vector<Slot> m_slots;  //!< The slots, a power of two of them
+  uint32_t m_mask;            //!< The number of slots minus one
+  uint32_t m_size;            //!< The number of entries
+};
+
+} // namespace ns3
+
+#endif /* NEIGHBOR_CACHE_TABLE_H */
@@ -91,6 +91,7 @@ TcpBbr::TcpBbr (const TcpBbr &sock)
     m_fullBandwidth (sock.m_fullBandwidth),
     m_fullBandwidthCount (sock.m_fullBandwidthCount),
     m_rtProp (Time::Max ()),
+    m_rtPropSeconds (0),
     m_sendQuantum (sock.m_sendQuantum),
     m_cycleStamp (sock.m_cycleStamp),
     m_cycleIndex (sock.m_cycleIndex),
@@ -171,7 +172,7 @@ void
 TcpBbr::SetPacingRate (Ptr<TcpSocketState> tcb, double gain)
 {
   NS_LOG_FUNCTION (this << tcb << gain);
-  DataRate rate (gain * m_maxBwFilter.GetBest ().GetBitRate ());
+  DataRate rate (gain * m_maxBwFilter.GetBest ());
   rate = std::min (rate, tcb->m_maxPacingRate);
   if (m_isPipeFilled || rate > tcb->m_currentPacingRate)
     {
@@ -188,7 +189,7 @@ TcpBbr::InFlight (Ptr<TcpSocketState> tcb, double gain)
       return tcb->m_initialCWnd * tcb->m_segmentSize;
     }
   double quanta = 3 * m_sendQuantum;
-  double estimatedBdp = m_maxBwFilter.GetBest () * m_rtProp / 8.0;
+  double estimatedBdp = m_rtPropSeconds * m_maxBwFilter.GetBest () / 8.0;
   return gain * estimatedBdp + quanta;
 }
 
@@ -240,9 +241,9 @@ TcpBbr::CheckFullPipe (const struct RateSample * rs)
     }
 
   /* Check if Bottleneck bandwidth is still growing*/
-  if (m_maxBwFilter.GetBest ().GetBitRate () >= m_fullBandwidth.GetBitRate () * 1.25)
+  if (m_maxBwFilter.GetBest () >= m_fullBandwidth.GetBitRate () * 1.25)
     {
-      m_fullBandwidth = m_maxBwFilter.GetBest ();
+      m_fullBandwidth = DataRate (m_maxBwFilter.GetBest ());
       m_fullBandwidthCount = 0;
       return;
     }
@@ -295,9 +296,10 @@ TcpBbr::UpdateRTprop (Ptr<TcpSocketState> tcb)
 {
   NS_LOG_FUNCTION (this << tcb);
   m_rtPropExpired = Simulator::Now () > (m_rtPropStamp + m_rtPropFilterLen);
-  if (tcb->m_lastRtt >= Seconds (0) && (tcb->m_lastRtt <= m_rtProp || m_rtPropExpired))
+  if (!tcb->m_lastRtt.Get ().IsNegative () && (tcb->m_lastRtt <= m_rtProp || m_rtPropExpired))
     {
       m_rtProp = tcb->m_lastRtt;
+      m_rtPropSeconds = m_rtProp.GetSeconds ();
       m_rtPropStamp = Simulator::Now ();
     }
 }
@@ -352,13 +354,13 @@ TcpBbr::HandleProbeRTT (Ptr<TcpSocketState> tcb)
   NS_LOG_FUNCTION (this << tcb);
   tcb->m_appLimited = (tcb->m_delivered + tcb->m_bytesInFlight.Get ()) ? : 1;
 
-  if (m_probeRttDoneStamp == Seconds (0) && tcb->m_bytesInFlight <= m_minPipeCwnd)
+  if (m_probeRttDoneStamp.IsZero () && tcb->m_bytesInFlight <= m_minPipeCwnd)
     {
       m_probeRttDoneStamp = Simulator::Now () + m_probeRttDuration;
       m_probeRttRoundDone = false;
       m_nextRoundDelivered = tcb->m_delivered;
     }
-  else if (m_probeRttDoneStamp != Seconds (0))
+  else if (!m_probeRttDoneStamp.IsZero ())
     {
       if (m_roundStart)
         {
@@ -495,16 +497,17 @@ void
 TcpBbr::UpdateBtlBw (Ptr<TcpSocketState> tcb, const struct RateSample * rs)
 {
   NS_LOG_FUNCTION (this << tcb << rs);
-  if (rs->m_deliveryRate == 0)
+  uint64_t deliveryRate = rs->m_deliveryRate.GetBitRate ();
+  if (deliveryRate == 0)
     {
       return;
     }
 
   UpdateRound (tcb, rs);
 
-  if (rs->m_deliveryRate >= m_maxBwFilter.GetBest () || !rs->m_isAppLimited)
+  if (deliveryRate >= m_maxBwFilter.GetBest () || !rs->m_isAppLimited)
     {
-      m_maxBwFilter.Update (rs->m_deliveryRate, m_roundCount);
+      m_maxBwFilter.Update (deliveryRate, m_roundCount);
     }
 }
 
@@ -588,6 +591,17 @@ TcpBbr::HasCongControl () const
   return true;
 }
 
+uint32_t
+TcpBbr::GetHooks () const
+{
+  if (GetInstanceTypeId () != TcpBbr::GetTypeId ())
+    {
+      return TcpCongestionOps::GetHooks ();
+    }
+  // IncreaseWindow and PktsAcked are left to CongControl
+  return HOOK_CONGESTION_STATE_SET | HOOK_CWND_EVENT;
+}
+
 void
 TcpBbr::CongControl (Ptr<TcpSocketState> tcb, const struct RateSample *rs)
 {
@@ -605,14 +619,15 @@ TcpBbr::CongestionStateSet (Ptr<TcpSocketState> tcb,
     {
       NS_LOG_DEBUG ("CongestionStateSet triggered to CA_OPEN :: " << newState);
       m_rtProp = tcb->m_lastRtt.Get () != Time::Max () ? tcb->m_lastRtt.Get () : Time::Max ();
+      m_rtPropSeconds = m_rtProp.GetSeconds ();
       m_rtPropStamp = Simulator::Now ();
       m_priorCwnd = tcb->m_initialCWnd * tcb->m_segmentSize;
       m_targetCWnd = tcb->m_initialCWnd * tcb->m_segmentSize;
       m_minPipeCwnd = 4 * tcb->m_segmentSize;
       m_sendQuantum = 1 * tcb->m_segmentSize;
       m_maxBwFilter = MaxBandwidthFilter_t (m_bandwidthWindowLength,
-                                            DataRate (tcb->m_initialCWnd * tcb->m_segmentSize * 8 / m_rtProp.GetSeconds ())
-                                            , 0);
+                                            static_cast<uint64_t> (tcb->m_initialCWnd * tcb->m_segmentSize * 8 / m_rtPropSeconds),
+                                            0);
       InitRoundCounting ();
       InitFullPipe ();
       EnterStartup ();
@@ -72,8 +72,13 @@ public:
     BBR_PROBE_RTT,      /* cut inflight to min to probe min_rtt */
   } BbrMode_t;
 
-  typedef WindowedFilter<DataRate,
-                         MaxFilter<DataRate>,
+  /**
+   * The bandwidth filter runs in the integer domain, on bit rates in bps:
+   * it gives the same estimates as a filter of DataRate samples, without
+   * the DataRate conversions on each ACK.
+   */
+  typedef WindowedFilter<uint64_t,
+                         MaxFilter<uint64_t>,
                          uint32_t,
                          uint32_t>
   MaxBandwidthFilter_t;
@@ -90,6 +95,7 @@ public:
 
   virtual std::string GetName () const;
   virtual bool HasCongControl () const;
+  virtual uint32_t GetHooks () const;
   virtual void CongControl (Ptr<TcpSocketState> tcb, const struct RateSample *rs);
   virtual void CongestionStateSet (Ptr<TcpSocketState> tcb,
                                    const TcpSocketState::TcpCongState_t newState);
@@ -345,6 +351,7 @@ private:
   DataRate    m_fullBandwidth               {0};                 //!< Value of full bandwidth recorded
   uint32_t    m_fullBandwidthCount          {0};                 //!< Count of full bandwidth recorded consistently
   Time        m_rtProp                      {Time::Max ()};      //!< Estimated two-way round-trip propagation delay of the path, estimated from the windowed minimum recent round-trip delay sample.
+  double      m_rtPropSeconds               {0};                 //!< m_rtProp in seconds, kept along with it for the BDP computed on each ACK
   uint32_t    m_sendQuantum                 {0};                 //!< The maximum size of a data aggregate scheduled and transmitted together
   Time        m_cycleStamp                  {Seconds (0)};       //!< Last time gain cycle updated
   uint32_t    m_cycleIndex                  {0};                 //!< Current index of gain cycle
@@ -209,6 +209,16 @@ TcpNewReno::GetSsThresh (Ptr<const TcpSocketState> state,
   return std::max (2 * state->m_segmentSize, bytesInFlight / 2);
 }
 
+uint32_t
+TcpNewReno::GetHooks () const
+{
+  if (GetInstanceTypeId () != TcpNewReno::GetTypeId ())
+    {
+      return TcpCongestionOps::GetHooks ();
+    }
+  return HOOK_INCREASE_WINDOW;
+}
+
 Ptr<TcpCongestionOps>
 TcpNewReno::Fork ()
 {
@@ -167,6 +167,35 @@ public:
     return false;
   }
 
+  /**
+   * \brief Optional hooks of a congestion control algorithm
+   *
+   * The socket does not call the hooks that the algorithm does not implement.
+   */
+  enum Hook_t
+  {
+    HOOK_INCREASE_WINDOW      = 1 << 0, //!< IncreaseWindow
+    HOOK_PKTS_ACKED           = 1 << 1, //!< PktsAcked
+    HOOK_CONGESTION_STATE_SET = 1 << 2, //!< CongestionStateSet
+    HOOK_CWND_EVENT           = 1 << 3, //!< CwndEvent
+    HOOK_ALL                  = 0xf     //!< All the hooks
+  };
+
+  /**
+   * \brief Get the optional hooks implemented by the algorithm
+   *
+   * The socket reads them when the algorithm is installed.  The default
+   * is all the hooks.  An algorithm returning fewer hooks must return the
+   * default for its subclasses, that may implement more: that is, when
+   * GetInstanceTypeId () is not its own TypeId.
+   *
+   * \return the implemented hooks, as a combination of Hook_t
+   */
+  virtual uint32_t GetHooks () const
+  {
+    return HOOK_ALL;
+  }
+
   /**
    * \brief Called when packets are delivered to update cwnd and pacing rate
    *
@@ -229,6 +258,7 @@ public:
   virtual void IncreaseWindow (Ptr<TcpSocketState> tcb, uint32_t segmentsAcked);
   virtual uint32_t GetSsThresh (Ptr<const TcpSocketState> tcb,
                                 uint32_t bytesInFlight);
+  virtual uint32_t GetHooks () const;
 
   virtual Ptr<TcpCongestionOps> Fork ();
 
@@ -269,6 +269,16 @@ namespace ns3 {
       }
     }
 
+    uint32_t
+    TcpCubic::GetHooks () const
+    {
+      if (GetInstanceTypeId () != TcpCubic::GetTypeId ())
+      {
+        return TcpCongestionOps::GetHooks ();
+      }
+      return HOOK_INCREASE_WINDOW | HOOK_PKTS_ACKED;
+    }
+
 /**
  * Return the index of the last set bit. In the original Linux implementation
  * this method is provided in the Linux Kernel. This method is copied from the
@@ -85,6 +85,8 @@ namespace ns3 {
       virtual void PktsAcked (Ptr<TcpSocketState> tcb, uint32_t packetsAcked,
                               const Time& rtt);
 
+      virtual uint32_t GetHooks () const;
+
 
     protected:
       virtual void CongestionAvoidance (Ptr<TcpSocketState> tcb, uint32_t segmentsAcked);
@@ -0,0 +1,399 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "tcp-fluid-fast-forward.h"
+#include "tcp-socket-base.h"
+#include "tcp-congestion-ops.h"
+#include "tcp-bbr.h"
+#include "tcp-cubic.h"
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/boolean.h"
+#include "ns3/trace-source-accessor.h"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TcpFluidFastForward");
+
+NS_OBJECT_ENSURE_REGISTERED (TcpFluidFastForward);
+
+TypeId
+TcpFluidFastForward::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TcpFluidFastForward")
+    .SetParent<Object> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<TcpFluidFastForward> ()
+    .AddAttribute ("SampleInterval",
+                   "The interval between two samples of the delivery rates",
+                   TimeValue (Seconds (1)),
+                   MakeTimeAccessor (&TcpFluidFastForward::m_sampleInterval),
+                   MakeTimeChecker (MilliSeconds (1)))
+    .AddAttribute ("StableSamples",
+                   "The number of stable intervals before the switch to the fluid model",
+                   UintegerValue (5),
+                   MakeUintegerAccessor (&TcpFluidFastForward::m_stableSamples),
+                   MakeUintegerChecker<uint32_t> (2))
+    .AddAttribute ("Tolerance",
+                   "The maximum relative variation of the delivery rate of a stable flow",
+                   DoubleValue (0.1),
+                   MakeDoubleAccessor (&TcpFluidFastForward::m_tolerance),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("MaxError",
+                   "The maximum relative error of the fluid model versus the "
+                   "packet-level simulation for the switch to happen",
+                   DoubleValue (0.05),
+                   MakeDoubleAccessor (&TcpFluidFastForward::m_maxError),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("LinkHeaderSize",
+                   "The size of the link layer header of the bottlenecks (2 for "
+                   "the PPP header of point-to-point links)",
+                   UintegerValue (2),
+                   MakeUintegerAccessor (&TcpFluidFastForward::m_linkHeaderSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("StopTime",
+                   "The end of the simulated period, reached by the fluid model.  The "
+                   "simulator is not stopped at the switch to the fluid model unless "
+                   "the caller does it from the FastForward trace, and the statistics "
+                   "measured outside this object then end at the switch",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&TcpFluidFastForward::m_stopTime),
+                   MakeTimeChecker ())
+    .AddTraceSource ("FastForward",
+                     "The simulation switched to the fluid model: the packet-level "
+                     "simulation is no longer accounted for, and may be stopped",
+                     MakeTraceSourceAccessor (&TcpFluidFastForward::m_fastForwardTrace),
+                     "ns3::TcpFluidFastForward::FastForwardTracedCallback")
+  ;
+  return tid;
+}
+
+TcpFluidFastForward::TcpFluidFastForward ()
+  : m_lastChange (Seconds (0)),
+    m_switchTime (Seconds (0)),
+    m_fastForwarded (false)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TcpFluidFastForward::~TcpFluidFastForward ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+TcpFluidFastForward::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_sampleEvent.Cancel ();
+  m_flows.clear ();
+  Object::DoDispose ();
+}
+
+uint32_t
+TcpFluidFastForward::AddBottleneck (DataRate rate, uint32_t bufferSize, double lossRate)
+{
+  NS_LOG_FUNCTION (this << rate << bufferSize << lossRate);
+  Bottleneck bottleneck;
+  bottleneck.m_rate = rate;
+  bottleneck.m_bufferSize = bufferSize;
+  bottleneck.m_lossRate = lossRate;
+  m_bottlenecks.push_back (bottleneck);
+  return m_bottlenecks.size () - 1;
+}
+
+uint32_t
+TcpFluidFastForward::AddFlow (Ptr<TcpSocketBase> socket, uint32_t bottleneck)
+{
+  NS_LOG_FUNCTION (this << socket << bottleneck);
+  NS_ABORT_MSG_IF (bottleneck >= m_bottlenecks.size (), "No bottleneck " << bottleneck);
+
+  Flow flow;
+  flow.m_socket = socket;
+  flow.m_bottleneck = bottleneck;
+  UintegerValue segmentSize;
+  socket->GetAttribute ("SegmentSize", segmentSize);
+  flow.m_segmentSize = segmentSize.Get ();
+  BooleanValue timestamp;
+  socket->GetAttribute ("Timestamp", timestamp);
+  // IPv4 and TCP headers, with the padded timestamp option
+  flow.m_headerSize = 20 + 20 + (timestamp.Get () ? 12 : 0);
+  flow.m_acked = 0;
+  flow.m_cWnd = flow.m_segmentSize;
+  flow.m_lastRtt = Seconds (0);
+  flow.m_minRtt = Time::Max ();
+  flow.m_fluidBytes = 0;
+  flow.m_error = 0;
+  m_flows.push_back (flow);
+
+  std::ostringstream oss;
+  oss << m_flows.size () - 1;
+  socket->TraceConnect ("HighestRxAck", oss.str (),
+                        MakeCallback (&TcpFluidFastForward::HighestRxAck, this));
+  socket->TraceConnect ("RTT", oss.str (),
+                        MakeCallback (&TcpFluidFastForward::Rtt, this));
+  socket->TraceConnect ("CongestionWindow", oss.str (),
+                        MakeCallback (&TcpFluidFastForward::CongestionWindow, this));
+  return m_flows.size () - 1;
+}
+
+void
+TcpFluidFastForward::AddChangeTime (Time time)
+{
+  NS_LOG_FUNCTION (this << time);
+  m_lastChange = Max (m_lastChange, time);
+}
+
+void
+TcpFluidFastForward::Start (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ABORT_MSG_IF (m_stopTime <= Simulator::Now (), "The stop time must be in the future");
+  m_sampleEvent = Simulator::Schedule (m_sampleInterval, &TcpFluidFastForward::Sample, this);
+}
+
+bool
+TcpFluidFastForward::IsFastForwarded (void) const
+{
+  return m_fastForwarded;
+}
+
+Time
+TcpFluidFastForward::GetSwitchTime (void) const
+{
+  return m_switchTime;
+}
+
+uint64_t
+TcpFluidFastForward::GetPacketBytes (uint32_t flow) const
+{
+  NS_ASSERT (flow < m_flows.size ());
+  return m_flows[flow].m_acked;
+}
+
+uint64_t
+TcpFluidFastForward::GetFluidBytes (uint32_t flow) const
+{
+  NS_ASSERT (flow < m_flows.size ());
+  return m_flows[flow].m_fluidBytes;
+}
+
+uint64_t
+TcpFluidFastForward::GetErrorBound (uint32_t flow) const
+{
+  NS_ASSERT (flow < m_flows.size ());
+  return static_cast<uint64_t> (std::ceil (m_flows[flow].m_error * m_flows[flow].m_fluidBytes));
+}
+
+void
+TcpFluidFastForward::Print (std::ostream &os) const
+{
+  if (m_fastForwarded)
+    {
+      os << "Switched to the fluid model at " << m_switchTime.GetSeconds () << " s" << std::endl;
+    }
+  else
+    {
+      os << "No switch to the fluid model" << std::endl;
+    }
+  for (uint32_t i = 0; i < m_flows.size (); i++)
+    {
+      os << "Flow " << i << ": " << GetPacketBytes (i) + GetFluidBytes (i) << " bytes ("
+         << GetPacketBytes (i) << " packet-level, " << GetFluidBytes (i) << " +/- "
+         << GetErrorBound (i) << " fluid)" << std::endl;
+    }
+}
+
+void
+TcpFluidFastForward::HighestRxAck (std::string context, SequenceNumber32 oldValue, SequenceNumber32 newValue)
+{
+  // The first acknowledgment moves the value from its initial 0, and the
+  // fluid model accounts for the bytes acknowledged after the switch
+  if (!m_fastForwarded && oldValue != SequenceNumber32 (0) && newValue > oldValue)
+    {
+      m_flows[std::stoul (context)].m_acked += newValue - oldValue;
+    }
+}
+
+void
+TcpFluidFastForward::Rtt (std::string context, Time oldValue, Time newValue)
+{
+  NS_UNUSED (oldValue);
+  Flow &flow = m_flows[std::stoul (context)];
+  if (newValue.IsStrictlyPositive ())
+    {
+      flow.m_lastRtt = newValue;
+      flow.m_minRtt = Min (flow.m_minRtt, newValue);
+    }
+}
+
+void
+TcpFluidFastForward::CongestionWindow (std::string context, uint32_t oldValue, uint32_t newValue)
+{
+  NS_UNUSED (oldValue);
+  m_flows[std::stoul (context)].m_cWnd = newValue;
+}
+
+bool
+TcpFluidFastForward::IsStable (void) const
+{
+  for (std::vector<Flow>::const_iterator it = m_flows.begin (); it != m_flows.end (); ++it)
+    {
+      if (it->m_history.size () < m_stableSamples + 1 || it->m_minRtt == Time::Max ())
+        {
+          return false;
+        }
+      // the rate of the first snapshot covers the interval before the window
+      double mean = 0;
+      for (uint32_t i = 1; i < it->m_history.size (); i++)
+        {
+          mean += it->m_history[i].m_rate.GetBitRate ();
+        }
+      mean /= m_stableSamples;
+      if (mean == 0)
+        {
+          return false;
+        }
+      for (uint32_t i = 1; i < it->m_history.size (); i++)
+        {
+          if (std::fabs (it->m_history[i].m_rate.GetBitRate () - mean) > m_tolerance * mean)
+            {
+              return false;
+            }
+        }
+    }
+  return true;
+}
+
+Ptr<TcpFluidModel>
+TcpFluidFastForward::CreateModel (uint32_t index) const
+{
+  Ptr<TcpFluidModel> model = CreateObject<TcpFluidModel> ();
+  for (uint32_t b = 0; b < m_bottlenecks.size (); b++)
+    {
+      // the standing queue is estimated from the queuing delay of the flows
+      double queue = 0;
+      for (std::vector<Flow>::const_iterator it = m_flows.begin (); it != m_flows.end (); ++it)
+        {
+          const Snapshot &snapshot = it->m_history[index];
+          if (it->m_bottleneck == b && snapshot.m_lastRtt > snapshot.m_minRtt)
+            {
+              queue = std::max (queue, (snapshot.m_lastRtt - snapshot.m_minRtt).GetSeconds ()
+                                * m_bottlenecks[b].m_rate.GetBitRate () / 8);
+            }
+        }
+      model->AddBottleneck (m_bottlenecks[b].m_rate, m_bottlenecks[b].m_bufferSize,
+                            m_bottlenecks[b].m_lossRate, static_cast<uint32_t> (queue));
+    }
+  for (std::vector<Flow>::const_iterator it = m_flows.begin (); it != m_flows.end (); ++it)
+    {
+      const Snapshot &snapshot = it->m_history[index];
+      model->AddFlow (it->m_bottleneck, GetFlowType (it->m_socket), snapshot.m_minRtt, it->m_segmentSize,
+                      snapshot.m_rate, snapshot.m_cWnd, it->m_headerSize + m_linkHeaderSize);
+    }
+  return model;
+}
+
+TcpFluidModel::FlowType_t
+TcpFluidFastForward::GetFlowType (Ptr<TcpSocketBase> socket)
+{
+  // read when the model is created, as the algorithm may have been swapped
+  Ptr<TcpCongestionOps> congestionControl = socket->GetCongestionControlAlgorithm ();
+  if (DynamicCast<TcpBbr> (congestionControl) != nullptr)
+    {
+      return TcpFluidModel::BBR;
+    }
+  else if (DynamicCast<TcpCubic> (congestionControl) != nullptr)
+    {
+      return TcpFluidModel::CUBIC;
+    }
+  return TcpFluidModel::RENO;
+}
+
+void
+TcpFluidFastForward::Sample (void)
+{
+  NS_LOG_FUNCTION (this);
+  Time now = Simulator::Now ();
+  for (std::vector<Flow>::iterator it = m_flows.begin (); it != m_flows.end (); ++it)
+    {
+      Snapshot snapshot;
+      snapshot.m_acked = it->m_acked;
+      snapshot.m_rate = DataRate (0);
+      if (!it->m_history.empty ())
+        {
+          snapshot.m_rate = DataRate (static_cast<uint64_t> ((it->m_acked - it->m_history.back ().m_acked) * 8
+                                                             / m_sampleInterval.GetSeconds ()));
+        }
+      snapshot.m_cWnd = it->m_cWnd;
+      snapshot.m_lastRtt = it->m_lastRtt;
+      snapshot.m_minRtt = it->m_minRtt;
+      it->m_history.push_back (snapshot);
+      if (it->m_history.size () > m_stableSamples + 1)
+        {
+          it->m_history.pop_front ();
+        }
+    }
+
+  if (now + m_sampleInterval >= m_stopTime)
+    {
+      return;
+    }
+  if (now < m_lastChange || m_flows.empty () || !IsStable ())
+    {
+      m_sampleEvent = Simulator::Schedule (m_sampleInterval, &TcpFluidFastForward::Sample, this);
+      return;
+    }
+
+  // Validate the fluid model over the stable intervals
+  Ptr<TcpFluidModel> model = CreateModel (0);
+  model->Advance (m_sampleInterval * m_stableSamples);
+  double maxError = 0;
+  for (uint32_t i = 0; i < m_flows.size (); i++)
+    {
+      double measured = m_flows[i].m_history.back ().m_acked - m_flows[i].m_history.front ().m_acked;
+      m_flows[i].m_error = std::fabs (model->GetDelivered (i) - measured) / measured;
+      NS_LOG_LOGIC ("Flow " << i << ": " << measured << " bytes measured, "
+                    << model->GetDelivered (i) << " bytes predicted");
+      maxError = std::max (maxError, m_flows[i].m_error);
+    }
+  NS_LOG_LOGIC ("Fluid model error over the stable intervals: " << maxError);
+  if (maxError > m_maxError)
+    {
+      m_sampleEvent = Simulator::Schedule (m_sampleInterval, &TcpFluidFastForward::Sample, this);
+      return;
+    }
+
+  // Switch to the fluid model until the end of the simulated period
+  model = CreateModel (m_stableSamples);
+  model->Advance (m_stopTime - now);
+  for (uint32_t i = 0; i < m_flows.size (); i++)
+    {
+      m_flows[i].m_fluidBytes = model->GetDelivered (i);
+    }
+  m_switchTime = now;
+  m_fastForwarded = true;
+  NS_LOG_INFO ("Switching to the fluid model at " << now.GetSeconds () << " s");
+  m_fastForwardTrace (m_stopTime);
+}
+
+} // namespace ns3
@@ -0,0 +1,254 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TCP_FLUID_FAST_FORWARD_H
+#define TCP_FLUID_FAST_FORWARD_H
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/data-rate.h"
+#include "ns3/event-id.h"
+#include "ns3/sequence-number.h"
+#include "ns3/traced-callback.h"
+#include "tcp-fluid-model.h"
+#include <vector>
+#include <deque>
+#include <ostream>
+
+namespace ns3 {
+
+class TcpSocketBase;
+
+/**
+ * \ingroup tcp
+ *
+ * \brief Finish a packet-level simulation of long-lived TCP flows with a fluid model
+ *
+ * The delivery rate of each flow, measured from its acknowledgments, is
+ * sampled every SampleInterval.  Once the rates of all the flows stayed
+ * within Tolerance of their mean for StableSamples intervals, the flows
+ * are considered in steady state, and the fluid model (see TcpFluidModel)
+ * is validated against the packet-level simulation: it is started from the
+ * state of the flows at the beginning of those intervals and its
+ * prediction of the bytes delivered to each flow is compared with the
+ * measured ones.  If the relative error of every flow is within MaxError,
+ * the fluid model, started from the current state of the flows, computes
+ * the bytes delivered until StopTime, and the FastForward trace is fired.
+ *
+ * The simulator is not stopped by the switch: the caller decides, e.g., by
+ * calling Simulator::Stop from the FastForward trace, which is what saves
+ * the simulation time.  The switch is final either way: the packets the
+ * flows exchange after it are ignored.  Only the results of this object
+ * cover the whole period until StopTime: all the other statistics of the
+ * simulation, e.g., those of the FlowMonitor or of the applications, end
+ * at GetSwitchTime if the simulator is stopped there.  Events known to
+ * change the steady state, e.g., the arrival of a flow, must be declared
+ * with AddChangeTime so that the switch only happens after them.
+ *
+ * The result of each flow is the bytes acknowledged before the switch plus
+ * the bytes computed by the fluid model, whose error bound is the relative
+ * validation error of the flow applied to the bytes of the fluid model.
+ */
+class TcpFluidFastForward : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  TcpFluidFastForward ();
+  virtual ~TcpFluidFastForward ();
+
+  /**
+   * \brief Add a bottleneck crossed by the flows
+   * \param rate the capacity of the bottleneck
+   * \param bufferSize the size of its buffer, in bytes
+   * \param lossRate the probability that a segment is randomly lost
+   * \return the index of the bottleneck
+   */
+  uint32_t AddBottleneck (DataRate rate, uint32_t bufferSize, double lossRate = 0);
+
+  /**
+   * \brief Add a flow, identified by its sending socket
+   *
+   * The congestion control of the flow in the fluid model is BBR for TcpBbr
+   * sockets, Cubic for TcpCubic sockets and NewReno otherwise.
+   *
+   * \param socket the sending socket of the flow
+   * \param bottleneck the index of the bottleneck crossed by the flow
+   * \return the index of the flow
+   */
+  uint32_t AddFlow (Ptr<TcpSocketBase> socket, uint32_t bottleneck);
+
+  /**
+   * \brief Declare a time at which the steady state changes
+   * \param time the time of the change
+   */
+  void AddChangeTime (Time time);
+
+  /**
+   * \brief Start sampling the flows
+   */
+  void Start (void);
+
+  /**
+   * \return true if the simulation has been switched to the fluid model
+   */
+  bool IsFastForwarded (void) const;
+
+  /**
+   * \return the time of the switch to the fluid model, at which the
+   * statistics measured outside this object end if the caller stops the
+   * simulator from the FastForward trace
+   */
+  Time GetSwitchTime (void) const;
+
+  /**
+   * \param flow the index of a flow
+   * \return the bytes acknowledged in the packet-level simulation
+   */
+  uint64_t GetPacketBytes (uint32_t flow) const;
+
+  /**
+   * \param flow the index of a flow
+   * \return the bytes delivered by the fluid model
+   */
+  uint64_t GetFluidBytes (uint32_t flow) const;
+
+  /**
+   * \param flow the index of a flow
+   * \return the error bound of the bytes delivered by the fluid model
+   */
+  uint64_t GetErrorBound (uint32_t flow) const;
+
+  /**
+   * \brief Print the bytes delivered to the flows
+   * \param os the output stream
+   */
+  void Print (std::ostream &os) const;
+
+  /**
+   * TracedCallback signature for the switch to the fluid model.
+   *
+   * \param [in] time the time up to which the fluid model ran
+   */
+  typedef void (* FastForwardTracedCallback)(Time time);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /// The state of a flow at a sampling time
+  struct Snapshot
+  {
+    uint64_t m_acked;   //!< Bytes acknowledged
+    DataRate m_rate;    //!< Delivery rate in the previous interval
+    uint32_t m_cWnd;    //!< Congestion window
+    Time m_lastRtt;     //!< Last RTT sample
+    Time m_minRtt;      //!< Minimum RTT sample
+  };
+
+  /// A flow
+  struct Flow
+  {
+    Ptr<TcpSocketBase> m_socket;        //!< Sending socket
+    uint32_t m_bottleneck;              //!< Index of the bottleneck
+    uint32_t m_segmentSize;             //!< Segment size
+    uint32_t m_headerSize;              //!< IP and TCP header size
+    uint64_t m_acked;                   //!< Bytes acknowledged
+    uint32_t m_cWnd;                    //!< Congestion window
+    Time m_lastRtt;                     //!< Last RTT sample
+    Time m_minRtt;                      //!< Minimum RTT sample
+    std::deque<Snapshot> m_history;     //!< Snapshots of the last samples
+    uint64_t m_fluidBytes;              //!< Bytes delivered by the fluid model
+    double m_error;                     //!< Relative validation error
+  };
+
+  /// A bottleneck
+  struct Bottleneck
+  {
+    DataRate m_rate;       //!< Capacity
+    uint32_t m_bufferSize; //!< Buffer size (bytes)
+    double m_lossRate;     //!< Random segment loss probability
+  };
+
+  /**
+   * \brief Sample the flows and switch to the fluid model if possible
+   */
+  void Sample (void);
+
+  /**
+   * \return true if the delivery rates of all the flows are stable
+   */
+  bool IsStable (void) const;
+
+  /**
+   * \brief Create a fluid model from a snapshot of the flows
+   * \param index the index of the snapshot in the history of the flows
+   * \return the fluid model
+   */
+  Ptr<TcpFluidModel> CreateModel (uint32_t index) const;
+
+  /**
+   * \param socket a sending socket
+   * \return the fluid model type of the congestion control of the socket
+   */
+  static TcpFluidModel::FlowType_t GetFlowType (Ptr<TcpSocketBase> socket);
+
+  /**
+   * \brief Trace sink of the highest acknowledged sequence number
+   * \param context the index of the flow
+   * \param oldValue the previous value
+   * \param newValue the new value
+   */
+  void HighestRxAck (std::string context, SequenceNumber32 oldValue, SequenceNumber32 newValue);
+
+  /**
+   * \brief Trace sink of the RTT samples
+   * \param context the index of the flow
+   * \param oldValue the previous value
+   * \param newValue the new value
+   */
+  void Rtt (std::string context, Time oldValue, Time newValue);
+
+  /**
+   * \brief Trace sink of the congestion window
+   * \param context the index of the flow
+   * \param oldValue the previous value
+   * \param newValue the new value
+   */
+  void CongestionWindow (std::string context, uint32_t oldValue, uint32_t newValue);
+
+  std::vector<Flow> m_flows;             //!< Flows
+  std::vector<Bottleneck> m_bottlenecks; //!< Bottlenecks
+  Time m_sampleInterval;                 //!< Interval between samples
+  uint32_t m_stableSamples;              //!< Stable intervals before the switch
+  double m_tolerance;                    //!< Relative rate variation of stable flows
+  double m_maxError;                     //!< Maximum relative validation error
+  uint32_t m_linkHeaderSize;             //!< Link layer header size of the bottlenecks
+  Time m_stopTime;                       //!< End of the simulated period
+  Time m_lastChange;                     //!< Time of the last change of steady state
+  Time m_switchTime;                     //!< Time of the switch to the fluid model
+  bool m_fastForwarded;                  //!< Whether the switch happened
+  EventId m_sampleEvent;                 //!< Next sample
+  TracedCallback<Time> m_fastForwardTrace; //!< Trace of the switch to the fluid model
+};
+
+} // namespace ns3
+
+#endif /* TCP_FLUID_FAST_FORWARD_H */
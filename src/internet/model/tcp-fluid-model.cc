@@ -0,0 +1,296 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "tcp-fluid-model.h"
+#include "tcp-bbr.h"
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TcpFluidModel");
+
+NS_OBJECT_ENSURE_REGISTERED (TcpFluidModel);
+
+/// Number of rounds of the BBR bandwidth filter
+static const uint32_t BBR_BW_WINDOW = 10;
+/// Cubic scaling constant (segments/s^3)
+static const double CUBIC_C = 0.4;
+/// Cubic multiplicative decrease factor
+static const double CUBIC_BETA = 0.7;
+
+TypeId
+TcpFluidModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TcpFluidModel")
+    .SetParent<Object> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<TcpFluidModel> ()
+    .AddAttribute ("TimeStep",
+                   "The integration time step of the model",
+                   TimeValue (MilliSeconds (1)),
+                   MakeTimeAccessor (&TcpFluidModel::m_timeStep),
+                   MakeTimeChecker (NanoSeconds (1)))
+  ;
+  return tid;
+}
+
+TcpFluidModel::TcpFluidModel ()
+  : m_timeStep (MilliSeconds (1)),
+    m_now (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TcpFluidModel::~TcpFluidModel ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+uint32_t
+TcpFluidModel::AddBottleneck (DataRate rate, uint32_t bufferSize, double lossRate,
+                              uint32_t queueSize)
+{
+  NS_LOG_FUNCTION (this << rate << bufferSize << lossRate << queueSize);
+  NS_ABORT_MSG_IF (rate.GetBitRate () == 0, "The capacity of a bottleneck must be positive");
+
+  Bottleneck bottleneck;
+  bottleneck.m_capacity = rate.GetBitRate () / 8.0;
+  bottleneck.m_buffer = bufferSize;
+  bottleneck.m_lossRate = lossRate;
+  bottleneck.m_queue = std::min<double> (queueSize, bufferSize);
+  m_bottlenecks.push_back (bottleneck);
+  return m_bottlenecks.size () - 1;
+}
+
+uint32_t
+TcpFluidModel::AddFlow (uint32_t bottleneck, FlowType_t type, Time baseRtt,
+                        uint32_t segmentSize, DataRate rate, uint32_t cWnd,
+                        uint32_t headerSize)
+{
+  NS_LOG_FUNCTION (this << bottleneck << type << baseRtt << segmentSize << rate << cWnd << headerSize);
+  NS_ABORT_MSG_IF (bottleneck >= m_bottlenecks.size (), "No bottleneck " << bottleneck);
+  NS_ABORT_MSG_IF (!baseRtt.IsStrictlyPositive (), "The base RTT must be positive");
+  NS_ABORT_MSG_IF (segmentSize == 0, "The segment size must be positive");
+
+  Flow flow;
+  flow.m_bottleneck = bottleneck;
+  flow.m_type = type;
+  flow.m_baseRtt = baseRtt.GetSeconds ();
+  flow.m_segmentSize = segmentSize;
+  flow.m_overhead = static_cast<double> (segmentSize + headerSize) / segmentSize;
+  flow.m_cWnd = std::max<double> (cWnd, 2 * segmentSize);
+  flow.m_btlBw = rate.GetBitRate () / 8.0;
+  if (flow.m_btlBw == 0)
+    {
+      flow.m_btlBw = flow.m_cWnd / flow.m_baseRtt;
+    }
+  flow.m_bwSamples.push_back (flow.m_btlBw);
+  flow.m_cycleIndex = 0;
+  flow.m_wMax = flow.m_cWnd;
+  flow.m_epochStart = m_now;
+  flow.m_roundStart = m_now;
+  flow.m_roundDelivered = 0;
+  flow.m_lossCredit = 0;
+  flow.m_roundLoss = false;
+  flow.m_rate = 0;
+  flow.m_delivered = 0;
+  m_flows.push_back (flow);
+  UpdateRate (m_flows.back ());
+  return m_flows.size () - 1;
+}
+
+void
+TcpFluidModel::Advance (Time duration)
+{
+  NS_LOG_FUNCTION (this << duration);
+  double dt = m_timeStep.GetSeconds ();
+  double end = m_now + duration.GetSeconds ();
+  while (m_now + dt <= end)
+    {
+      Step (dt);
+    }
+  if (end > m_now)
+    {
+      Step (end - m_now);
+    }
+}
+
+uint64_t
+TcpFluidModel::GetDelivered (uint32_t flow) const
+{
+  NS_ASSERT (flow < m_flows.size ());
+  return static_cast<uint64_t> (m_flows[flow].m_delivered);
+}
+
+DataRate
+TcpFluidModel::GetRate (uint32_t flow) const
+{
+  NS_ASSERT (flow < m_flows.size ());
+  return DataRate (static_cast<uint64_t> (m_flows[flow].m_rate * 8));
+}
+
+uint32_t
+TcpFluidModel::GetQueueSize (uint32_t bottleneck) const
+{
+  NS_ASSERT (bottleneck < m_bottlenecks.size ());
+  return static_cast<uint32_t> (m_bottlenecks[bottleneck].m_queue);
+}
+
+Time
+TcpFluidModel::GetElapsed (void) const
+{
+  return Seconds (m_now);
+}
+
+double
+TcpFluidModel::GetRtt (const Flow &flow) const
+{
+  const Bottleneck &bottleneck = m_bottlenecks[flow.m_bottleneck];
+  return flow.m_baseRtt + bottleneck.m_queue / bottleneck.m_capacity;
+}
+
+void
+TcpFluidModel::UpdateRate (Flow &flow) const
+{
+  double rtt = GetRtt (flow);
+  if (flow.m_type == BBR)
+    {
+      double pacingRate = TcpBbr::PACING_GAIN_CYCLE[flow.m_cycleIndex] * flow.m_btlBw;
+      double inFlightCap = 2 * flow.m_btlBw * flow.m_baseRtt + 4 * flow.m_segmentSize;
+      flow.m_rate = std::min (pacingRate, inFlightCap / rtt);
+    }
+  else
+    {
+      flow.m_rate = flow.m_cWnd / rtt;
+    }
+}
+
+void
+TcpFluidModel::Step (double dt)
+{
+  std::vector<double> arrival (m_bottlenecks.size (), 0);
+  for (std::vector<Flow>::iterator it = m_flows.begin (); it != m_flows.end (); ++it)
+    {
+      UpdateRate (*it);
+      arrival[it->m_bottleneck] += it->m_rate * it->m_overhead;
+    }
+
+  for (std::vector<Flow>::iterator it = m_flows.begin (); it != m_flows.end (); ++it)
+    {
+      const Bottleneck &bottleneck = m_bottlenecks[it->m_bottleneck];
+      double a = arrival[it->m_bottleneck];
+      double share = it->m_rate;
+      if (a > 0 && (a > bottleneck.m_capacity || bottleneck.m_queue > 0))
+        {
+          // the wire bytes are shared; the overhead of the flow cancels out
+          share = bottleneck.m_capacity * it->m_rate / a;
+        }
+
+      double delivered = share * dt * (1 - bottleneck.m_lossRate);
+      it->m_lossCredit += bottleneck.m_lossRate * it->m_rate * dt / it->m_segmentSize;
+      if (it->m_lossCredit >= 1)
+        {
+          it->m_lossCredit -= std::floor (it->m_lossCredit);
+          it->m_roundLoss = true;
+        }
+      it->m_delivered += delivered;
+      it->m_roundDelivered += delivered;
+    }
+
+  for (uint32_t b = 0; b < m_bottlenecks.size (); b++)
+    {
+      Bottleneck &bottleneck = m_bottlenecks[b];
+      bottleneck.m_queue += (arrival[b] - bottleneck.m_capacity) * dt;
+      if (bottleneck.m_queue < 0)
+        {
+          bottleneck.m_queue = 0;
+        }
+      else if (bottleneck.m_queue > bottleneck.m_buffer)
+        {
+          // drop-tail: all the flows sending to a full buffer lose data
+          bottleneck.m_queue = bottleneck.m_buffer;
+          for (std::vector<Flow>::iterator it = m_flows.begin (); it != m_flows.end (); ++it)
+            {
+              if (it->m_bottleneck == b && it->m_rate > 0)
+                {
+                  it->m_roundLoss = true;
+                }
+            }
+        }
+    }
+
+  m_now += dt;
+
+  for (std::vector<Flow>::iterator it = m_flows.begin (); it != m_flows.end (); ++it)
+    {
+      double duration = m_now - it->m_roundStart;
+      if (duration >= GetRtt (*it))
+        {
+          EndRound (*it, duration);
+          it->m_roundStart = m_now;
+        }
+    }
+}
+
+void
+TcpFluidModel::EndRound (Flow &flow, double duration)
+{
+  switch (flow.m_type)
+    {
+    case BBR:
+      flow.m_bwSamples.push_back (flow.m_roundDelivered / duration);
+      if (flow.m_bwSamples.size () > BBR_BW_WINDOW)
+        {
+          flow.m_bwSamples.pop_front ();
+        }
+      flow.m_btlBw = *std::max_element (flow.m_bwSamples.begin (), flow.m_bwSamples.end ());
+      flow.m_cycleIndex = (flow.m_cycleIndex + 1) % TcpBbr::GAIN_CYCLE_LENGTH;
+      break;
+    case RENO:
+      if (flow.m_roundLoss)
+        {
+          flow.m_cWnd = std::max (flow.m_cWnd / 2, 2 * flow.m_segmentSize);
+        }
+      else
+        {
+          flow.m_cWnd += flow.m_segmentSize;
+        }
+      break;
+    case CUBIC:
+      if (flow.m_roundLoss)
+        {
+          flow.m_wMax = flow.m_cWnd;
+          flow.m_cWnd = std::max (flow.m_cWnd * CUBIC_BETA, 2 * flow.m_segmentSize);
+          flow.m_epochStart = m_now;
+        }
+      else
+        {
+          double wMax = flow.m_wMax / flow.m_segmentSize;
+          double k = std::cbrt (wMax * (1 - CUBIC_BETA) / CUBIC_C);
+          double t = m_now + GetRtt (flow) - flow.m_epochStart;
+          double target = (CUBIC_C * std::pow (t - k, 3) + wMax) * flow.m_segmentSize;
+          flow.m_cWnd = std::max (flow.m_cWnd, std::min (target, 1.5 * flow.m_cWnd));
+        }
+      break;
+    }
+  flow.m_roundDelivered = 0;
+  flow.m_roundLoss = false;
+}
+
+} // namespace ns3
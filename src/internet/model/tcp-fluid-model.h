@@ -0,0 +1,203 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TCP_FLUID_MODEL_H
+#define TCP_FLUID_MODEL_H
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/data-rate.h"
+#include <vector>
+#include <deque>
+
+namespace ns3 {
+
+/**
+ * \ingroup tcp
+ *
+ * \brief Fluid model of long-lived TCP flows sharing drop-tail bottlenecks
+ *
+ * Each bottleneck is a FIFO queue of a given capacity, buffer size and
+ * random loss rate.  The flows are fluids whose sending rate is updated
+ * once per round trip, from the bytes the bottleneck delivered to them in
+ * that round:
+ *
+ * - BBR flows pace at the current gain of the ProbeBW cycle times the
+ *   maximum delivery rate of the last 10 rounds, and keep at most two
+ *   bandwidth-delay products in flight; ProbeRTT is not modeled;
+ * - NewReno flows add one segment per round and halve their window when
+ *   they lose data in a round;
+ * - Cubic flows follow the cubic window growth function and reduce their
+ *   window by 30% when they lose data in a round.
+ *
+ * When the arrival rate exceeds the capacity, or a queue is standing, the
+ * capacity is shared in proportion to the arrival rates; what does not fit
+ * in the buffer is lost.  Random losses are accounted for as their
+ * expected number.
+ *
+ * The model is integrated with a fixed time step (attribute TimeStep), and
+ * keeps its own clock: it is not driven by the simulator.
+ */
+class TcpFluidModel : public Object
+{
+public:
+  /**
+   * \brief Congestion control of a flow
+   */
+  typedef enum
+  {
+    BBR,    //!< BBR (ProbeBW state)
+    RENO,   //!< NewReno
+    CUBIC   //!< Cubic
+  } FlowType_t;
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  TcpFluidModel ();
+  virtual ~TcpFluidModel ();
+
+  /**
+   * \brief Add a bottleneck
+   * \param rate the capacity of the bottleneck
+   * \param bufferSize the size of its buffer, in bytes
+   * \param lossRate the probability that a segment is randomly lost
+   * \param queueSize the bytes initially queued
+   * \return the index of the bottleneck
+   */
+  uint32_t AddBottleneck (DataRate rate, uint32_t bufferSize, double lossRate = 0,
+                          uint32_t queueSize = 0);
+
+  /**
+   * \brief Add a flow
+   *
+   * The rate of BBR flows is the initial estimate of the bottleneck
+   * bandwidth (or, if null, the congestion window per base RTT); the other
+   * flows start from the given congestion window.  The rates, windows and
+   * delivered bytes of a flow count the payload of its segments, whereas
+   * the bottlenecks also carry their headers.
+   *
+   * \param bottleneck the index of the bottleneck crossed by the flow
+   * \param type the congestion control of the flow
+   * \param baseRtt the round trip time of the flow when queues are empty
+   * \param segmentSize the segment size of the flow
+   * \param rate the initial delivery rate of the flow
+   * \param cWnd the initial congestion window of the flow, in bytes
+   * \param headerSize the size of the headers of each segment
+   * \return the index of the flow
+   */
+  uint32_t AddFlow (uint32_t bottleneck, FlowType_t type, Time baseRtt,
+                    uint32_t segmentSize, DataRate rate, uint32_t cWnd,
+                    uint32_t headerSize = 0);
+
+  /**
+   * \brief Advance the model
+   * \param duration the time to advance the model by
+   */
+  void Advance (Time duration);
+
+  /**
+   * \param flow the index of a flow
+   * \return the bytes delivered to the flow since it was added
+   */
+  uint64_t GetDelivered (uint32_t flow) const;
+
+  /**
+   * \param flow the index of a flow
+   * \return the current sending rate of the flow
+   */
+  DataRate GetRate (uint32_t flow) const;
+
+  /**
+   * \param bottleneck the index of a bottleneck
+   * \return the bytes currently queued at the bottleneck
+   */
+  uint32_t GetQueueSize (uint32_t bottleneck) const;
+
+  /**
+   * \return the time elapsed in the model
+   */
+  Time GetElapsed (void) const;
+
+private:
+  /// A bottleneck
+  struct Bottleneck
+  {
+    double m_capacity;   //!< Capacity (bytes/s)
+    double m_buffer;     //!< Buffer size (bytes)
+    double m_lossRate;   //!< Random segment loss probability
+    double m_queue;      //!< Queued bytes
+  };
+
+  /// A flow
+  struct Flow
+  {
+    uint32_t m_bottleneck;        //!< Index of the bottleneck
+    FlowType_t m_type;            //!< Congestion control
+    double m_baseRtt;             //!< RTT with empty queues (s)
+    double m_segmentSize;         //!< Segment size (bytes)
+    double m_overhead;            //!< Bytes on the wire per byte of payload
+    double m_cWnd;                //!< Congestion window (bytes)
+    double m_btlBw;               //!< BBR bandwidth estimate (bytes/s)
+    std::deque<double> m_bwSamples; //!< BBR delivery rate of the last rounds (bytes/s)
+    uint32_t m_cycleIndex;        //!< BBR ProbeBW gain cycle phase
+    double m_wMax;                //!< Cubic window before the last reduction (bytes)
+    double m_epochStart;          //!< Cubic start of the current epoch (s)
+    double m_roundStart;          //!< Start of the current round (s)
+    double m_roundDelivered;      //!< Bytes delivered in the current round
+    double m_lossCredit;          //!< Expected random losses not yet applied
+    bool m_roundLoss;             //!< Whether data was lost in the current round
+    double m_rate;                //!< Current sending rate (bytes/s)
+    double m_delivered;           //!< Bytes delivered since the flow was added
+  };
+
+  /**
+   * \brief Advance the model by one time step
+   * \param dt the time step (s)
+   */
+  void Step (double dt);
+
+  /**
+   * \brief Update the sending rate of a flow
+   * \param flow the flow
+   */
+  void UpdateRate (Flow &flow) const;
+
+  /**
+   * \brief Update the state of a flow at the end of a round
+   * \param flow the flow
+   * \param duration the duration of the round (s)
+   */
+  void EndRound (Flow &flow, double duration);
+
+  /**
+   * \param flow a flow
+   * \return the current round trip time of the flow (s)
+   */
+  double GetRtt (const Flow &flow) const;
+
+  std::vector<Bottleneck> m_bottlenecks; //!< Bottlenecks
+  std::vector<Flow> m_flows;             //!< Flows
+  Time m_timeStep;                       //!< Integration time step
+  double m_now;                          //!< Time elapsed in the model (s)
+};
+
+} // namespace ns3
+
+#endif /* TCP_FLUID_MODEL_H */
@@ -228,36 +228,46 @@ TcpHeader::CalculateHeaderChecksum (uint16_t size) const
   /* Zero                   3 bytes                                        */
   /* Next header            1 byte                                         */
 
-  uint32_t maxHdrSz = (2 * Address::MAX_SIZE) + 8;
-  Buffer buf = Buffer (maxHdrSz);
-  buf.AddAtStart (maxHdrSz);
-  Buffer::Iterator it = buf.Begin ();
+  // The pseudo-header is summed in place, as serializing it in a Buffer
+  // allocates memory for every outgoing segment when checksums are enabled
+  uint8_t buf[(2 * Address::MAX_SIZE) + 8];
   uint32_t hdrSize = 0;
 
-  WriteTo (it, m_source);
-  WriteTo (it, m_destination);
+  hdrSize += m_source.CopyTo (buf + hdrSize);
+  hdrSize += m_destination.CopyTo (buf + hdrSize);
   if (Ipv4Address::IsMatchingType (m_source))
     {
-      it.WriteU8 (0); /* protocol */
-      it.WriteU8 (m_protocol); /* protocol */
-      it.WriteU8 (size >> 8); /* length */
-      it.WriteU8 (size & 0xff); /* length */
+      buf[hdrSize + 0] = 0; /* protocol */
+      buf[hdrSize + 1] = m_protocol; /* protocol */
+      buf[hdrSize + 2] = size >> 8; /* length */
+      buf[hdrSize + 3] = size & 0xff; /* length */
       hdrSize = 12;
     }
   else
     {
-      it.WriteU16 (0);
-      it.WriteU8 (size >> 8); /* length */
-      it.WriteU8 (size & 0xff); /* length */
-      it.WriteU16 (0);
-      it.WriteU8 (0);
-      it.WriteU8 (m_protocol); /* protocol */
+      buf[hdrSize + 0] = 0;
+      buf[hdrSize + 1] = 0;
+      buf[hdrSize + 2] = size >> 8; /* length */
+      buf[hdrSize + 3] = size & 0xff; /* length */
+      buf[hdrSize + 4] = 0;
+      buf[hdrSize + 5] = 0;
+      buf[hdrSize + 6] = 0;
+      buf[hdrSize + 7] = m_protocol; /* protocol */
       hdrSize = 40;
     }
 
-  it = buf.Begin ();
+  /* same word order as Buffer::Iterator::CalculateIpChecksum */
+  uint32_t sum = 0;
+  for (uint32_t j = 0; j < hdrSize; j += 2)
+    {
+      sum += buf[j] | (buf[j + 1] << 8);
+    }
+  while (sum >> 16)
+    {
+      sum = (sum & 0xffff) + (sum >> 16);
+    }
   /* we don't CompleteChecksum ( ~ ) now */
-  return ~(it.CalculateIpChecksum (hdrSize));
+  return sum;
 }
 
 bool
@@ -29,6 +29,7 @@
 #include "ns3/simulator.h"
 #include "ns3/ipv4-route.h"
 #include "ns3/ipv6-route.h"
+#include "ns3/gso-tag.h"
 
 #include "tcp-l4-protocol.h"
 #include "tcp-header.h"
@@ -42,6 +43,7 @@
 #include "tcp-socket-factory-impl.h"
 #include "tcp-socket-base.h"
 #include "tcp-congestion-ops.h"
+#include "tcp-timer-wheel.h"
 #include "rtt-estimator.h"
 
 #include <vector>
@@ -86,12 +88,19 @@ TcpL4Protocol::GetTypeId (void)
                    ObjectVectorValue (),
                    MakeObjectVectorAccessor (&TcpL4Protocol::m_sockets),
                    MakeObjectVectorChecker<TcpSocketBase> ())
+    .AddAttribute ("TimerWheel",
+                   "Hold the timers of the sockets in a timer wheel, instead "
+                   "of simulator events.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&TcpL4Protocol::m_timerWheelEnabled),
+                   MakeBooleanChecker ())
   ;
   return tid;
 }
 
 TcpL4Protocol::TcpL4Protocol ()
-  : m_endPoints (new Ipv4EndPointDemux ()), m_endPoints6 (new Ipv6EndPointDemux ())
+  : m_endPoints (new Ipv4EndPointDemux ()), m_endPoints6 (new Ipv6EndPointDemux ()),
+    m_timerWheelEnabled (false)
 {
   NS_LOG_FUNCTION_NOARGS ();
   NS_LOG_LOGIC ("Made a TcpL4Protocol " << this);
@@ -170,12 +179,28 @@ TcpL4Protocol::DoDispose (void)
       m_endPoints6 = 0;
     }
 
+  if (m_timerWheel != 0)
+    {
+      m_timerWheel->Dispose ();
+      m_timerWheel = 0;
+    }
+
   m_node = 0;
   m_downTarget.Nullify ();
   m_downTarget6.Nullify ();
   IpL4Protocol::DoDispose ();
 }
 
+Ptr<TcpTimerWheel>
+TcpL4Protocol::GetTimerWheel (void)
+{
+  if (m_timerWheelEnabled && m_timerWheel == 0)
+    {
+      m_timerWheel = CreateObject<TcpTimerWheel> ();
+    }
+  return m_timerWheel;
+}
+
 Ptr<Socket>
 TcpL4Protocol::CreateSocket (TypeId congestionTypeId)
 {
@@ -434,6 +459,21 @@ TcpL4Protocol::Receive (Ptr<Packet> packet,
 {
   NS_LOG_FUNCTION (this << packet << incomingIpHeader << incomingInterface);
 
+  GsoTag gso;
+  if (packet->PeekPacketTag (gso) && gso.HasLosses ())
+    {
+      // Some segments of the super-segment have been lost on the link:
+      // deliver the others one by one, as they would have been received
+      std::list<Ptr<Packet> > segments = SegmentGso (packet,
+                                                     incomingIpHeader.GetSource (),
+                                                     incomingIpHeader.GetDestination ());
+      for (std::list<Ptr<Packet> >::iterator it = segments.begin (); it != segments.end (); ++it)
+        {
+          Receive (*it, incomingIpHeader, incomingInterface);
+        }
+      return IpL4Protocol::RX_OK;
+    }
+
   TcpHeader incomingTcpHeader;
   IpL4Protocol::RxStatus checksumControl;
 
@@ -548,6 +588,49 @@ TcpL4Protocol::Receive (Ptr<Packet> packet,
   return IpL4Protocol::RX_OK;
 }
 
+std::list<Ptr<Packet> >
+TcpL4Protocol::SegmentGso (Ptr<const Packet> packet,
+                           const Address &saddr, const Address &daddr)
+{
+  GsoTag gso;
+  bool found = packet->PeekPacketTag (gso);
+  NS_ASSERT_MSG (found, "The packet is not a super-segment");
+  NS_UNUSED (found);
+
+  TcpHeader tcpHeader;
+  packet->PeekHeader (tcpHeader);
+  uint32_t headerSize = tcpHeader.GetSerializedSize ();
+  NS_ASSERT (packet->GetSize () == headerSize + gso.GetPayloadSize ());
+
+  std::list<Ptr<Packet> > segments;
+  uint32_t offset = 0;
+  for (uint32_t i = 0; i < gso.GetNSegments (); i++)
+    {
+      uint32_t size = gso.GetSegmentPayloadSize (i);
+      if (!gso.IsLost (i))
+        {
+          Ptr<Packet> segment = packet->CreateFragment (headerSize + offset, size);
+          segment->RemovePacketTag (gso);
+
+          TcpHeader header = tcpHeader;
+          header.SetSequenceNumber (tcpHeader.GetSequenceNumber () + offset);
+          if (i + 1 < gso.GetNSegments ())
+            {
+              header.SetFlags (tcpHeader.GetFlags () & ~TcpHeader::FIN);
+            }
+          if (Node::ChecksumEnabled ())
+            {
+              header.EnableChecksums ();
+              header.InitializeChecksum (saddr, daddr, PROT_NUMBER);
+            }
+          segment->AddHeader (header);
+          segments.push_back (segment);
+        }
+      offset += size;
+    }
+  return segments;
+}
+
 void
 TcpL4Protocol::SendPacketV4 (Ptr<Packet> packet, const TcpHeader &outgoing,
                              const Ipv4Address &saddr, const Ipv4Address &daddr,
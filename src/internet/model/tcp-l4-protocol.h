@@ -22,6 +22,7 @@
 #define TCP_L4_PROTOCOL_H
 
 #include <stdint.h>
+#include <list>
 
 #include "ns3/ipv4-address.h"
 #include "ns3/ipv6-address.h"
@@ -38,6 +39,7 @@ class Ipv4EndPointDemux;
 class Ipv6EndPointDemux;
 class Ipv4Interface;
 class TcpSocketBase;
+class TcpTimerWheel;
 class Ipv4EndPoint;
 class Ipv6EndPoint;
 class NetDevice;
@@ -115,6 +117,15 @@ public:
    */
   Ptr<Socket> CreateSocket (TypeId congestionTypeId);
 
+  /**
+   * \brief Get the timer wheel of the sockets
+   *
+   * The wheel is created on the first call, if the TimerWheel attribute is set.
+   *
+   * \return the timer wheel, or 0 if the sockets use simulator events
+   */
+  Ptr<TcpTimerWheel> GetTimerWheel (void);
+
   /**
    * \brief Allocate an IPv4 Endpoint
    * \return the Endpoint
@@ -205,6 +216,22 @@ public:
                    const Address &saddr, const Address &daddr,
                    Ptr<NetDevice> oif = 0) const;
 
+  /**
+   * \brief Split a TCP super-segment into its segments
+   *
+   * The packet starts with the TCP header and carries a GsoTag.  Each
+   * segment gets a copy of the header with its own sequence number (the FIN
+   * flag is kept only on the last one), and the segments marked as lost in
+   * the tag are discarded.  The returned segments carry no GsoTag.
+   *
+   * \param packet the super-segment
+   * \param saddr the source address, for the checksum
+   * \param daddr the destination address, for the checksum
+   * \return the segments which are not lost, in sequence order
+   */
+  static std::list<Ptr<Packet> > SegmentGso (Ptr<const Packet> packet,
+                                             const Address &saddr, const Address &daddr);
+
   /**
    * \brief Make a socket fully operational
    *
@@ -306,6 +333,8 @@ private:
   Ipv6EndPointDemux *m_endPoints6; //!< A list of IPv6 end points.
   TypeId m_rttTypeId;              //!< The RTT Estimator TypeId
   TypeId m_congestionTypeId;       //!< The socket TypeId
+  bool m_timerWheelEnabled;        //!< Whether the socket timers use a timer wheel
+  Ptr<TcpTimerWheel> m_timerWheel; //!< The timer wheel of the sockets, if enabled
   std::vector<Ptr<TcpSocketBase> > m_sockets;      //!< list of sockets
   IpL4Protocol::DownTargetCallback m_downTarget;   //!< Callback to send packets over IPv4
   IpL4Protocol::DownTargetCallback6 m_downTarget6; //!< Callback to send packets over IPv6
@@ -105,6 +105,13 @@ TcpRxBuffer::IncNextRxSequence ()
   m_nextRxSeq++;
 }
 
+SequenceNumber32
+TcpRxBuffer::HeadSequence (void) const
+{
+  NS_ASSERT (m_inOrder.size () || m_data.size ());
+  return m_inOrder.size () ? m_inOrder.front ().first : m_data.begin ()->first;
+}
+
 // Return the lowest sequence number that this TcpRxBuffer cannot accept
 SequenceNumber32
 TcpRxBuffer::MaxRxSequence (void) const
@@ -113,9 +120,9 @@ TcpRxBuffer::MaxRxSequence (void) const
     { // No data allowed beyond FIN
       return m_finSeq;
     }
-  else if (m_data.size () && m_nextRxSeq > m_data.begin ()->first)
+  else if (m_inOrder.size ())
     { // No data allowed beyond Rx window allowed
-      return m_data.begin ()->first + SequenceNumber32 (m_maxBuffer);
+      return m_inOrder.front ().first + SequenceNumber32 (m_maxBuffer);
     }
   return m_nextRxSeq + SequenceNumber32 (m_maxBuffer);
 }
@@ -149,14 +156,20 @@ TcpRxBuffer::Add (Ptr<Packet> p, TcpHeader const& tcph)
 
   // Trim packet to fit Rx window specification
   if (headSeq < m_nextRxSeq) headSeq = m_nextRxSeq;
-  if (m_data.size ())
+  if (m_inOrder.size () || m_data.size ())
     {
-      SequenceNumber32 maxSeq = m_data.begin ()->first + SequenceNumber32 (m_maxBuffer);
+      SequenceNumber32 maxSeq = HeadSequence () + SequenceNumber32 (m_maxBuffer);
       if (maxSeq < tailSeq) tailSeq = maxSeq;
       if (tailSeq < headSeq) headSeq = tailSeq;
     }
-  // Remove overlapped bytes from packet
-  BufIterator i = m_data.begin ();
+  // Remove overlapped bytes from packet. The in-sequence data is before
+  // m_nextRxSeq, and the out-of-order segments do not overlap each other:
+  // only the segment starting before headSeq and the ones after it matter
+  BufIterator i = m_data.upper_bound (headSeq);
+  if (i != m_data.begin ())
+    {
+      --i;
+    }
   while (i != m_data.end () && i->first <= tailSeq)
     {
       SequenceNumber32 lastByteSeq = i->first + SequenceNumber32 (i->second->GetSize ());
@@ -194,10 +207,10 @@ TcpRxBuffer::Add (Ptr<Packet> p, TcpHeader const& tcph)
     }
   // Insert packet into buffer
   NS_ASSERT (m_data.find (headSeq) == m_data.end ()); // Shouldn't be there yet
-  m_data [ headSeq ] = p;
 
   if (headSeq > m_nextRxSeq)
     {
+      m_data [ headSeq ] = p;
       // Generate a new SACK block
       UpdateSackList (headSeq, tailSeq);
     }
@@ -205,18 +218,19 @@ TcpRxBuffer::Add (Ptr<Packet> p, TcpHeader const& tcph)
   NS_LOG_LOGIC ("Buffered packet of seqno=" << headSeq << " len=" << p->GetSize ());
   // Update variables
   m_size += p->GetSize ();      // Occupancy
-  for (i = m_data.begin (); i != m_data.end (); ++i)
+  if (headSeq == m_nextRxSeq)
     {
-      if (i->first < m_nextRxSeq)
+      // The packet fills the head of the window, and it may join some of
+      // the out-of-order segments to the in-sequence data
+      m_inOrder.push_back (Segment (headSeq, p));
+      m_nextRxSeq = tailSeq;
+      m_availBytes += p->GetSize ();
+      for (i = m_data.begin (); i != m_data.end () && i->first == m_nextRxSeq; i = m_data.erase (i))
         {
-          continue;
+          m_inOrder.push_back (*i);
+          m_nextRxSeq = i->first + SequenceNumber32 (i->second->GetSize ());
+          m_availBytes += i->second->GetSize ();
         }
-      else if (i->first > m_nextRxSeq)
-        {
-          break;
-        };
-      m_nextRxSeq = i->first + SequenceNumber32 (i->second->GetSize ());
-      m_availBytes += i->second->GetSize ();
       ClearSackList (m_nextRxSeq);
     }
   NS_LOG_LOGIC ("Updated buffer occupancy=" << m_size << " nextRxSeq=" << m_nextRxSeq);
@@ -368,32 +382,51 @@ TcpRxBuffer::Extract (uint32_t maxSize)
   uint32_t extractSize = std::min (maxSize, m_availBytes);
   NS_LOG_LOGIC ("Requested to extract " << extractSize << " bytes from TcpRxBuffer of size=" << m_size);
   if (extractSize == 0) return nullptr;  // No contiguous block to return
-  NS_ASSERT (m_data.size ()); // At least we have something to extract
-  Ptr<Packet> outPkt = Create<Packet> (); // The packet that contains all the data to return
-  BufIterator i;
+  NS_ASSERT (m_inOrder.size ()); // At least we have something to extract
+  Ptr<Packet> outPkt = nullptr; // The packet that contains all the data to return
   while (extractSize)
     { // Check the buffered data for delivery
-      i = m_data.begin ();
-      NS_ASSERT (i->first <= m_nextRxSeq); // in-sequence data expected
+      Segment &head = m_inOrder.front ();
+      NS_ASSERT (head.first < m_nextRxSeq); // in-sequence data expected
       // Check if we send the whole pkt or just a partial
-      uint32_t pktSize = i->second->GetSize ();
+      uint32_t pktSize = head.second->GetSize ();
+      Ptr<Packet> part;
       if (pktSize <= extractSize)
         { // Whole packet is extracted
-          outPkt->AddAtEnd (i->second);
-          m_data.erase (i);
+          part = head.second;
+          m_inOrder.pop_front ();
           m_size -= pktSize;
           m_availBytes -= pktSize;
           extractSize -= pktSize;
         }
       else
         { // Partial is extracted and done
-          outPkt->AddAtEnd (i->second->CreateFragment (0, extractSize));
-          m_data[i->first + SequenceNumber32 (extractSize)] = i->second->CreateFragment (extractSize, pktSize - extractSize);
-          m_data.erase (i);
+          part = head.second->CreateFragment (0, extractSize);
+          if (head.second->GetReferenceCount () > 1)
+            { // Someone else holds the buffered packet, leave it untouched
+              head.second = head.second->CreateFragment (extractSize, pktSize - extractSize);
+            }
+          else
+            {
+              head.second->RemoveAtStart (extractSize);
+            }
+          head.first += extractSize;
           m_size -= extractSize;
           m_availBytes -= extractSize;
           extractSize = 0;
         }
+
+      if (outPkt == nullptr)
+        {
+          // Hand the first packet over instead of copying it, without the
+          // tags of the received segment, unless someone else holds it
+          outPkt = part->GetReferenceCount () > 1 ? part->Copy () : part;
+          outPkt->RemoveAllPacketTags ();
+        }
+      else
+        {
+          outPkt->AddAtEnd (part);
+        }
     }
   if (outPkt->GetSize () == 0)
     {
@@ -401,7 +434,7 @@ TcpRxBuffer::Extract (uint32_t maxSize)
       return nullptr;
     }
   NS_LOG_LOGIC ("Extracted " << outPkt->GetSize ( ) << " bytes, bufsize=" << m_size
-                             << ", num pkts in buffer=" << m_data.size ());
+                             << ", num pkts in buffer=" << m_inOrder.size () + m_data.size ());
   return outPkt;
 }
 
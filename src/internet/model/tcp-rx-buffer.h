@@ -22,6 +22,7 @@
 #define TCP_RX_BUFFER_H
 
 #include <map>
+#include <deque>
 #include "ns3/traced-value.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/sequence-number.h"
@@ -53,6 +54,14 @@ class Packet;
  * To store data, use Add; for retrieving a certain amount of ordered data, use
  * the method Extract.
  *
+ * Internally, the data is split in two containers. The in-sequence data,
+ * waiting to be read by the application, is a FIFO of segments: appending a
+ * segment that fills the head of the window, or reading from it, is O(1).
+ * Only the out-of-order segments, i.e. the blocks after the holes, are kept
+ * in a map sorted by sequence number; an incoming segment is checked for
+ * overlaps against its neighbours only. Extract hands over the buffered
+ * segments instead of copying them when they are read whole.
+ *
  * SACK list
  * ---------
  *
@@ -215,17 +224,30 @@ private:
    */
   void ClearSackList (const SequenceNumber32 &seq);
 
+  /**
+   * \brief Get the sequence number of the first byte stored in the buffer
+   *
+   * The buffer must not be empty.
+   *
+   * \return the first unread in-sequence byte, or the first out-of-order
+   * byte if there is no data to read
+   */
+  SequenceNumber32 HeadSequence (void) const;
+
   TcpOptionSack::SackList m_sackList; //!< Sack list (updated constantly)
 
   /// container for data stored in the buffer
   typedef std::map<SequenceNumber32, Ptr<Packet> >::iterator BufIterator;
+  /// a segment and the sequence number of its first byte
+  typedef std::pair<SequenceNumber32, Ptr<Packet> > Segment;
   TracedValue<SequenceNumber32> m_nextRxSeq; //!< Seqnum of the first missing byte in data (RCV.NXT)
   SequenceNumber32 m_finSeq;                 //!< Seqnum of the FIN packet
   bool m_gotFin;                             //!< Did I received FIN packet?
   uint32_t m_size;                           //!< Number of total data bytes in the buffer, not necessarily contiguous
   uint32_t m_maxBuffer;                      //!< Upper bound of the number of data bytes in buffer (RCV.WND)
   uint32_t m_availBytes;                     //!< Number of bytes available to read, i.e. contiguous block at head
-  std::map<SequenceNumber32, Ptr<Packet> > m_data; //!< Corresponding data (may be null)
+  std::deque<Segment> m_inOrder;             //!< In-sequence data, not read yet
+  std::map<SequenceNumber32, Ptr<Packet> > m_data; //!< Out-of-order data
 };
 
 } //namepsace ns3
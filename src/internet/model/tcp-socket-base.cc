@@ -51,6 +51,7 @@
 #include "ns3/trace-source-accessor.h"
 #include "ns3/data-rate.h"
 #include "ns3/object.h"
+#include "ns3/gso-tag.h"
 #include "tcp-socket-base.h"
 #include "tcp-l4-protocol.h"
 #include "ipv4-end-point.h"
@@ -68,6 +69,10 @@ NS_LOG_COMPONENT_DEFINE ("TcpSocketBase");
 
 NS_OBJECT_ENSURE_REGISTERED (TcpSocketBase);
 
+/// Largest payload of a super-segment: its IPv4 datagram, with the largest
+/// TCP header, must not exceed 65535 bytes
+static const uint32_t MAX_GSO_PAYLOAD = 65535 - 20 - 60;
+
 std::unordered_set<TcpSocketBase*> TcpSocketBase::sockets;
 
 TypeId
@@ -143,6 +148,13 @@ TcpSocketBase::GetTypeId (void)
                    BooleanValue (true),
                    MakeBooleanAccessor (&TcpSocketBase::m_limitedTx),
                    MakeBooleanChecker ())
+    .AddAttribute ("GsoMaxSegments",
+                   "Maximum number of full segments sent as a single super-segment "
+                   "through devices supporting generic segmentation offload "
+                   "(IPv4 only; 1 disables it)",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&TcpSocketBase::m_gsoMaxSegments),
+                   MakeUintegerChecker<uint32_t> (1, GsoTag::MAX_SEGMENTS))
     .AddAttribute ("UnfairMitigationEnable",
                    "Whether to enable unfairness mitigation",
                    BooleanValue (false),
@@ -350,7 +362,12 @@ TcpSocketBase::TcpSocketBase (void)
   m_txBuffer->SetTcpSocketState (m_tcb);
 
   m_tcb->m_currentPacingRate = m_tcb->m_maxPacingRate;
-  m_pacingTimer.SetFunction (&TcpSocketBase::NotifyPacingPerformed, this);
+  m_retxEvent.SetFunction (MakeCallback (&TcpSocketBase::ReTxTimeout, this));
+  m_lastAckEvent.SetFunction (MakeCallback (&TcpSocketBase::LastAckTimeout, this));
+  m_delAckEvent.SetFunction (MakeCallback (&TcpSocketBase::DelAckTimeout, this));
+  m_persistEvent.SetFunction (MakeCallback (&TcpSocketBase::PersistTimeout, this));
+  m_timewaitEvent.SetFunction (MakeCallback (&TcpSocketBase::CloseAndNotify, this));
+  m_pacingTimer.SetFunction (MakeCallback (&TcpSocketBase::NotifyPacingPerformed, this));
 
   bool ok;
 
@@ -386,6 +403,11 @@ TcpSocketBase::TcpSocketBase (void)
 TcpSocketBase::TcpSocketBase (const TcpSocketBase& sock)
   : TcpSocket (sock),
     //copy object::m_tid and socket::callbacks
+    m_retxEvent (sock.m_retxEvent),
+    m_lastAckEvent (sock.m_lastAckEvent),
+    m_delAckEvent (sock.m_delAckEvent),
+    m_persistEvent (sock.m_persistEvent),
+    m_timewaitEvent (sock.m_timewaitEvent),
     m_dupAckCount (sock.m_dupAckCount),
     m_delAckCount (0),
     m_delAckMaxCount (sock.m_delAckMaxCount),
@@ -426,10 +448,11 @@ TcpSocketBase::TcpSocketBase (const TcpSocketBase& sock)
     m_recover (sock.m_recover),
     m_retxThresh (sock.m_retxThresh),
     m_limitedTx (sock.m_limitedTx),
+    m_gsoMaxSegments (sock.m_gsoMaxSegments),
     m_isFirstPartialAck (sock.m_isFirstPartialAck),
     m_txTrace (sock.m_txTrace),
     m_rxTrace (sock.m_rxTrace),
-    m_pacingTimer (Timer::REMOVE_ON_DESTROY),
+    m_pacingTimer (sock.m_pacingTimer),
     m_scaleParams (sock.m_scaleParams),
     m_fairShareType (sock.m_fairShareType),
     m_ackPacingType (sock.m_ackPacingType),
@@ -470,11 +493,18 @@ TcpSocketBase::TcpSocketBase (const TcpSocketBase& sock)
   m_txBuffer->SetTcpSocketState (m_tcb);
 
   m_tcb->m_currentPacingRate = m_tcb->m_maxPacingRate;
-  m_pacingTimer.SetFunction (&TcpSocketBase::NotifyPacingPerformed, this);
+  m_retxEvent.SetFunction (MakeCallback (&TcpSocketBase::ReTxTimeout, this));
+  m_lastAckEvent.SetFunction (MakeCallback (&TcpSocketBase::LastAckTimeout, this));
+  m_delAckEvent.SetFunction (MakeCallback (&TcpSocketBase::DelAckTimeout, this));
+  m_persistEvent.SetFunction (MakeCallback (&TcpSocketBase::PersistTimeout, this));
+  m_timewaitEvent.SetFunction (MakeCallback (&TcpSocketBase::CloseAndNotify, this));
+  m_pacingTimer.SetFunction (MakeCallback (&TcpSocketBase::NotifyPacingPerformed, this));
 
   if (sock.m_congestionControl)
     {
       m_congestionControl = sock.m_congestionControl->Fork ();
+      m_ccHooks = m_congestionControl->GetHooks ();
+      m_ccHasCongControl = m_congestionControl->HasCongControl ();
     }
 
   bool ok;
@@ -559,6 +589,17 @@ void
 TcpSocketBase::SetTcp (Ptr<TcpL4Protocol> tcp)
 {
   m_tcp = tcp;
+  Ptr<TcpTimerWheel> wheel;
+  if (tcp != 0)
+    {
+      wheel = tcp->GetTimerWheel ();
+    }
+  m_retxEvent.SetWheel (wheel);
+  m_lastAckEvent.SetWheel (wheel);
+  m_delAckEvent.SetWheel (wheel);
+  m_persistEvent.SetWheel (wheel);
+  m_timewaitEvent.SetWheel (wheel);
+  m_pacingTimer.SetWheel (wheel);
 }
 
 /* Set an RTT estimator with this socket */
@@ -1371,13 +1412,13 @@ TcpSocketBase::DoForwardUp (Ptr<Packet> packet, const Address &fromAddress,
     { // Zero window: Enter persist state to send 1 byte to probe
       NS_LOG_LOGIC (this << " Enter zerowindow persist state");
       NS_LOG_LOGIC (this << " Cancelled ReTxTimeout event which was set to expire at " <<
-                    (Simulator::Now () + Simulator::GetDelayLeft (m_retxEvent)).GetSeconds ());
+                    (Simulator::Now () + m_retxEvent.GetDelayLeft ()).GetSeconds ());
       m_retxEvent.Cancel ();
       NS_LOG_LOGIC ("Schedule persist timeout at time " <<
                     Simulator::Now ().GetSeconds () << " to expire at time " <<
                     (Simulator::Now () + m_persistTimeout).GetSeconds ());
-      m_persistEvent = Simulator::Schedule (m_persistTimeout, &TcpSocketBase::PersistTimeout, this);
-      NS_ASSERT (m_persistTimeout == Simulator::GetDelayLeft (m_persistEvent));
+      m_persistEvent.Schedule (m_persistTimeout);
+      NS_ASSERT (m_persistTimeout == m_persistEvent.GetDelayLeft ());
     }
 
   // TCP state machine code in different process functions
@@ -1585,7 +1626,7 @@ TcpSocketBase::EnterRecovery ()
   // (4.1) RecoveryPoint = HighData
   m_recover = m_tcb->m_highTxMark;
 
-  m_congestionControl->CongestionStateSet (m_tcb, TcpSocketState::CA_RECOVERY);
+  CcCongestionStateSet (TcpSocketState::CA_RECOVERY);
   m_tcb->m_congState = TcpSocketState::CA_RECOVERY;
 
   // (4.2) ssthresh = cwnd = (FlightSize / 2)
@@ -1594,7 +1635,7 @@ TcpSocketBase::EnterRecovery ()
   uint32_t bytesInFlight = m_sackEnabled ? BytesInFlight () : BytesInFlight () + m_tcb->m_segmentSize;
   m_tcb->m_ssThresh = m_congestionControl->GetSsThresh (m_tcb, bytesInFlight);
 
-  if (!m_congestionControl->HasCongControl ())
+  if (!m_ccHasCongControl)
     {
       m_tcb->m_cWnd = m_tcb->m_ssThresh;
       m_cWndInfl = m_tcb->m_ssThresh + m_dupAckCount * m_tcb->m_segmentSize;
@@ -1636,7 +1677,7 @@ TcpSocketBase::DupAck ()
       ++m_dupAckCount;
     }
 
-  if (!m_congestionControl->HasCongControl () && !m_sackEnabled && m_tcb->m_congState == TcpSocketState::CA_RECOVERY)
+  if (!m_ccHasCongControl && !m_sackEnabled && m_tcb->m_congState == TcpSocketState::CA_RECOVERY)
     {
       // If we are in recovery and we receive a dupack, one segment
       // has left the network. This is equivalent to a SACK of one block.
@@ -1651,7 +1692,7 @@ TcpSocketBase::DupAck ()
       NS_ASSERT_MSG (m_dupAckCount == 1, "From OPEN->DISORDER but with " <<
                      m_dupAckCount << " dup ACKs");
 
-      m_congestionControl->CongestionStateSet (m_tcb, TcpSocketState::CA_DISORDER);
+      CcCongestionStateSet (TcpSocketState::CA_DISORDER);
       m_tcb->m_congState = TcpSocketState::CA_DISORDER;
 
       NS_LOG_DEBUG ("CA_OPEN -> CA_DISORDER");
@@ -1686,7 +1727,7 @@ TcpSocketBase::DupAck ()
           // Not clear in RFC. We don't do this here, since we still have
           // to retransmit the segment.
 
-          if (!m_congestionControl->HasCongControl () && !m_sackEnabled && m_limitedTx)
+          if (!m_ccHasCongControl && !m_sackEnabled && m_limitedTx)
             {
               m_txBuffer->AddRenoSack ();
 
@@ -1731,7 +1772,7 @@ TcpSocketBase::ReceivedAck (Ptr<Packet> packet, const TcpHeader& tcpHeader)
   // are inside the function ProcessAck
   ProcessAck (ackNumber, scoreboardUpdated, oldHeadSequence);
 
-  if (m_congestionControl->HasCongControl ())
+  if (m_ccHasCongControl)
     {
       m_congestionControl->CongControl (m_tcb, rs);
       m_cWndInfl = m_tcb->m_cWnd;
@@ -1816,7 +1857,7 @@ TcpSocketBase::ProcessAck (const SequenceNumber32 &ackNumber, bool scoreboardUpd
   else if (ackNumber == oldHeadSequence)
     {
       // DupAck. Artificially call PktsAcked: after all, one segment has been ACKed.
-      m_congestionControl->PktsAcked (m_tcb, 1, m_tcb->m_lastRtt);
+      CcPktsAcked (1);
     }
   else if (ackNumber > oldHeadSequence)
     {
@@ -1880,7 +1921,7 @@ TcpSocketBase::ProcessAck (const SequenceNumber32 &ackNumber, bool scoreboardUpd
           // This partial ACK acknowledge the fact that one segment has been
           // previously lost and now successfully received. All others have
           // been processed when they come under the form of dupACKs
-          m_congestionControl->PktsAcked (m_tcb, 1, m_tcb->m_lastRtt);
+          CcPktsAcked (1);
           NewAck (ackNumber, m_isFirstPartialAck);
 
           if (m_isFirstPartialAck)
@@ -1907,10 +1948,10 @@ TcpSocketBase::ProcessAck (const SequenceNumber32 &ackNumber, bool scoreboardUpd
       // of RecoveryPoint.
       else if (ackNumber < m_recover && m_tcb->m_congState == TcpSocketState::CA_LOSS)
         {
-          m_congestionControl->PktsAcked (m_tcb, segsAcked, m_tcb->m_lastRtt);
-          if (!m_congestionControl->HasCongControl ())
+          CcPktsAcked (segsAcked);
+          if (!m_ccHasCongControl)
             {
-              m_congestionControl->IncreaseWindow (m_tcb, segsAcked);
+              CcIncreaseWindow (segsAcked);
               NS_LOG_DEBUG (" Cong Control Called, cWnd=" << m_tcb->m_cWnd <<
                             " ssTh=" << m_tcb->m_ssThresh);
               if (!m_sackEnabled)
@@ -1926,20 +1967,20 @@ TcpSocketBase::ProcessAck (const SequenceNumber32 &ackNumber, bool scoreboardUpd
         {
           if (m_tcb->m_congState == TcpSocketState::CA_OPEN)
             {
-              m_congestionControl->PktsAcked (m_tcb, segsAcked, m_tcb->m_lastRtt);
+              CcPktsAcked (segsAcked);
             }
           else if (m_tcb->m_congState == TcpSocketState::CA_DISORDER)
             {
               if (segsAcked >= oldDupAckCount)
                 {
-                  m_congestionControl->PktsAcked (m_tcb, segsAcked - oldDupAckCount, m_tcb->m_lastRtt);
+                  CcPktsAcked (segsAcked - oldDupAckCount);
                 }
 
               if (!isDupack)
                 {
                   // The network reorder packets. Linux changes the counting lost
                   // packet algorithm from FACK to NewReno. We simply go back in Open.
-                  m_congestionControl->CongestionStateSet (m_tcb, TcpSocketState::CA_OPEN);
+                  CcCongestionStateSet (TcpSocketState::CA_OPEN);
                   m_tcb->m_congState = TcpSocketState::CA_OPEN;
                   NS_LOG_DEBUG (segsAcked << " segments acked in CA_DISORDER, ack of " <<
                                 ackNumber << " exiting CA_DISORDER -> CA_OPEN");
@@ -1967,9 +2008,9 @@ TcpSocketBase::ProcessAck (const SequenceNumber32 &ackNumber, bool scoreboardUpd
               // (which are the ones we have not passed to PktsAcked and that
               // can increase cWnd)
               segsAcked = static_cast<uint32_t>(ackNumber - m_recover) / m_tcb->m_segmentSize;
-              m_congestionControl->PktsAcked (m_tcb, segsAcked, m_tcb->m_lastRtt);
-              m_congestionControl->CwndEvent (m_tcb, TcpSocketState::CA_EVENT_COMPLETE_CWR);
-              m_congestionControl->CongestionStateSet (m_tcb, TcpSocketState::CA_OPEN);
+              CcPktsAcked (segsAcked);
+              CcCwndEvent (TcpSocketState::CA_EVENT_COMPLETE_CWR);
+              CcCongestionStateSet (TcpSocketState::CA_OPEN);
               m_tcb->m_congState = TcpSocketState::CA_OPEN;
               exitedFastRecovery = true;
               m_dupAckCount = 0; // From recovery to open, reset dupack
@@ -1986,9 +2027,9 @@ TcpSocketBase::ProcessAck (const SequenceNumber32 &ackNumber, bool scoreboardUpd
               // can increase cWnd)
               segsAcked = (ackNumber - m_recover) / m_tcb->m_segmentSize;
 
-              m_congestionControl->PktsAcked (m_tcb, segsAcked, m_tcb->m_lastRtt);
+              CcPktsAcked (segsAcked);
 
-              m_congestionControl->CongestionStateSet (m_tcb, TcpSocketState::CA_OPEN);
+              CcCongestionStateSet (TcpSocketState::CA_OPEN);
               m_tcb->m_congState = TcpSocketState::CA_OPEN;
               NS_LOG_DEBUG (segsAcked << " segments acked in CA_LOSS, ack of" <<
                             ackNumber << ", exiting CA_LOSS -> CA_OPEN");
@@ -1997,7 +2038,7 @@ TcpSocketBase::ProcessAck (const SequenceNumber32 &ackNumber, bool scoreboardUpd
           if (exitedFastRecovery)
             {
               NewAck (ackNumber, true);
-              if (!m_congestionControl->HasCongControl ())
+              if (!m_ccHasCongControl)
                 {
                   // Follow NewReno procedures to exit FR if SACK is disabled
                   // (RFC2582 sec.3 bullet #5 paragraph 2, option 2)
@@ -2011,9 +2052,9 @@ TcpSocketBase::ProcessAck (const SequenceNumber32 &ackNumber, bool scoreboardUpd
             }
           else
             {
-              if (!m_congestionControl->HasCongControl ())
+              if (!m_ccHasCongControl)
                 {
-                  m_congestionControl->IncreaseWindow (m_tcb, segsAcked);
+                  CcIncreaseWindow (segsAcked);
                   m_cWndInfl = m_tcb->m_cWnd;
                 }
               NS_LOG_LOGIC ("Congestion control called: " <<
@@ -2069,7 +2110,7 @@ TcpSocketBase::ProcessSynSent (Ptr<Packet> packet, const TcpHeader& tcpHeader)
   if (tcpflags == 0)
     { // Bare data, accept it and move to ESTABLISHED state. This is not a normal behaviour. Remove this?
       NS_LOG_DEBUG ("SYN_SENT -> ESTABLISHED");
-      m_congestionControl->CongestionStateSet (m_tcb, TcpSocketState::CA_OPEN);
+      CcCongestionStateSet (TcpSocketState::CA_OPEN);
       m_state = ESTABLISHED;
       m_connected = true;
       m_retxEvent.Cancel ();
@@ -2092,7 +2133,7 @@ TcpSocketBase::ProcessSynSent (Ptr<Packet> packet, const TcpHeader& tcpHeader)
            && m_tcb->m_nextTxSequence + SequenceNumber32 (1) == tcpHeader.GetAckNumber ())
     { // Handshake completed
       NS_LOG_DEBUG ("SYN_SENT -> ESTABLISHED");
-      m_congestionControl->CongestionStateSet (m_tcb, TcpSocketState::CA_OPEN);
+      CcCongestionStateSet (TcpSocketState::CA_OPEN);
       m_state = ESTABLISHED;
       m_connected = true;
       m_retxEvent.Cancel ();
@@ -2136,7 +2177,7 @@ TcpSocketBase::ProcessSynRcvd (Ptr<Packet> packet, const TcpHeader& tcpHeader,
       // possibly due to ACK lost in 3WHS. If in-sequence ACK is received, the
       // handshake is completed nicely.
       NS_LOG_DEBUG ("SYN_RCVD -> ESTABLISHED");
-      m_congestionControl->CongestionStateSet (m_tcb, TcpSocketState::CA_OPEN);
+      CcCongestionStateSet (TcpSocketState::CA_OPEN);
       m_state = ESTABLISHED;
       m_connected = true;
       m_retxEvent.Cancel ();
@@ -2424,7 +2465,7 @@ TcpSocketBase::DoPeerClose (void)
     {
       NS_LOG_LOGIC ("TcpSocketBase " << this << " scheduling LATO1");
       Time lastRto = m_rtt->GetEstimate () + Max (m_clockGranularity, m_rtt->GetVariation () * 4);
-      m_lastAckEvent = Simulator::Schedule (lastRto, &TcpSocketBase::LastAckTimeout, this);
+      m_lastAckEvent.Schedule (lastRto);
     }
 }
 
@@ -2440,7 +2481,7 @@ TcpSocketBase::Destroy (void)
       m_tcp->RemoveSocket (this);
     }
   NS_LOG_LOGIC (this << " Cancelled ReTxTimeout event which was set to expire at " <<
-                (Simulator::Now () + Simulator::GetDelayLeft (m_retxEvent)).GetSeconds ());
+                (Simulator::Now () + m_retxEvent.GetDelayLeft ()).GetSeconds ());
   CancelAllTimers ();
 }
 
@@ -2456,7 +2497,7 @@ TcpSocketBase::Destroy6 (void)
       m_tcp->RemoveSocket (this);
     }
   NS_LOG_LOGIC (this << " Cancelled ReTxTimeout event which was set to expire at " <<
-                (Simulator::Now () + Simulator::GetDelayLeft (m_retxEvent)).GetSeconds ());
+                (Simulator::Now () + m_retxEvent.GetDelayLeft ()).GetSeconds ());
   CancelAllTimers ();
 }
 
@@ -2590,7 +2631,7 @@ TcpSocketBase::SendEmptyPacket (uint8_t flags)
       NS_LOG_LOGIC ("Schedule retransmission timeout at time "
                     << Simulator::Now ().GetSeconds () << " to expire at time "
                     << (Simulator::Now () + m_rto.Get ()).GetSeconds ());
-      m_retxEvent = Simulator::Schedule (m_rto, &TcpSocketBase::SendEmptyPacket, this, flags);
+      m_retxEvent.Schedule (m_rto, MakeCallback (&TcpSocketBase::SendEmptyPacket, this).Bind (flags));
     }
 }
 
@@ -2800,15 +2841,37 @@ TcpSocketBase::SendDataPacket (SequenceNumber32 seq, uint32_t maxSize, bool with
       isRetransmission = true;
     }
 
-  Ptr<Packet> p = m_txBuffer->CopyFromSequence (maxSize, seq);
-  uint32_t sz = p->GetSize (); // Size of packet
-  uint8_t flags = withAck ? TcpHeader::ACK : 0;
-  uint32_t remainingData = m_txBuffer->SizeFromSequence (seq + SequenceNumber32 (sz));
-
   NS_LOG_DEBUG ("CC: " << m_congestionControl->GetName());
   NS_LOG_DEBUG ("m_sendingBbr: " << std::string (m_sendingBbr ? "Yes" : "No"));
   BbrTag tag (Simulator::Now (), m_sendingBbr);
-  p->AddByteTag(tag);
+
+  Ptr<Packet> p;
+  if (maxSize > m_tcb->m_segmentSize)
+    {
+      // Super-segment: the buffer keeps track of the segments one by one, so
+      // that they can be SACKed and retransmitted individually. Each segment
+      // carries its own BbrTag, for the receiver to record it on its own.
+      p = Create<Packet> ();
+      while (p->GetSize () < maxSize)
+        {
+          Ptr<Packet> segment = m_txBuffer->CopyFromSequence (std::min (maxSize - p->GetSize (), m_tcb->m_segmentSize),
+                                                              seq + SequenceNumber32 (p->GetSize ()));
+          if (segment->GetSize () == 0)
+            {
+              break;
+            }
+          segment->AddByteTag (tag);
+          p->AddAtEnd (segment);
+        }
+    }
+  else
+    {
+      p = m_txBuffer->CopyFromSequence (maxSize, seq);
+      p->AddByteTag (tag);
+    }
+  uint32_t sz = p->GetSize (); // Size of packet
+  uint8_t flags = withAck ? TcpHeader::ACK : 0;
+  uint32_t remainingData = m_txBuffer->SizeFromSequence (seq + SequenceNumber32 (sz));
 
   if (m_tcb->m_pacing)
     {
@@ -2871,7 +2934,12 @@ TcpSocketBase::SendDataPacket (SequenceNumber32 seq, uint32_t maxSize, bool with
       NS_LOG_LOGIC (this << " SendDataPacket Schedule ReTxTimeout at time " <<
                     Simulator::Now ().GetSeconds () << " to expire at time " <<
                     (Simulator::Now () + m_rto.Get ()).GetSeconds () );
-      m_retxEvent = Simulator::Schedule (m_rto, &TcpSocketBase::ReTxTimeout, this);
+      m_retxEvent.Schedule (m_rto);
+    }
+
+  if (sz > m_tcb->m_segmentSize)
+    {
+      p->AddPacketTag (GsoTag (m_tcb->m_segmentSize, sz));
     }
 
   m_txTrace (p, header, this);
@@ -2893,7 +2961,18 @@ TcpSocketBase::SendDataPacket (SequenceNumber32 seq, uint32_t maxSize, bool with
                     ". Header " << header);
     }
 
-  UpdateRttHistory (seq, sz, isRetransmission);
+  if (sz > m_tcb->m_segmentSize)
+    {
+      for (uint32_t offset = 0; offset < sz; offset += m_tcb->m_segmentSize)
+        {
+          UpdateRttHistory (seq + SequenceNumber32 (offset),
+                            std::min (sz - offset, m_tcb->m_segmentSize), isRetransmission);
+        }
+    }
+  else
+    {
+      UpdateRttHistory (seq, sz, isRetransmission);
+    }
 
   // Notify the application of the data being sent unless this is a retransmit
   if (seq + sz > m_tcb->m_highTxMark)
@@ -2904,7 +2983,18 @@ TcpSocketBase::SendDataPacket (SequenceNumber32 seq, uint32_t maxSize, bool with
 
   // Update highTxMark
   m_tcb->m_highTxMark = std::max (seq + sz, m_tcb->m_highTxMark.Get ());
-  m_txBuffer->UpdatePacketSent (seq, sz);
+  if (sz > m_tcb->m_segmentSize)
+    {
+      for (uint32_t offset = 0; offset < sz; offset += m_tcb->m_segmentSize)
+        {
+          m_txBuffer->UpdatePacketSent (seq + SequenceNumber32 (offset),
+                                        std::min (sz - offset, m_tcb->m_segmentSize));
+        }
+    }
+  else
+    {
+      m_txBuffer->UpdatePacketSent (seq, sz);
+    }
   return sz;
 }
 
@@ -3018,6 +3108,22 @@ TcpSocketBase::SendPendingData (bool withAck)
 
           uint32_t s = std::min (availableWindow, m_tcb->m_segmentSize);
 
+          // Generic segmentation offload: new data goes out in super-segments
+          // of full segments, as long as their IPv4 datagram fits 64 KB
+          if (m_gsoMaxSegments > 1 && m_endPoint != nullptr && next == m_tcb->m_highTxMark
+              && availableWindow >= 2 * m_tcb->m_segmentSize)
+            {
+              uint32_t maxSegments = std::min (m_gsoMaxSegments, MAX_GSO_PAYLOAD / m_tcb->m_segmentSize);
+              if (m_tcb->m_pacing)
+                {
+                  // As Linux does, a paced flow sends at most 1 ms worth of
+                  // data at the current pacing rate at once
+                  uint64_t bytesPerMs = m_tcb->m_currentPacingRate.GetBitRate () / 8000;
+                  maxSegments = std::min<uint64_t> (maxSegments, std::max<uint64_t> (2, bytesPerMs / m_tcb->m_segmentSize));
+                }
+              s = std::min (availableWindow / m_tcb->m_segmentSize, maxSegments) * m_tcb->m_segmentSize;
+            }
+
           // (C.2) If any of the data octets sent in (C.1) are below HighData,
           //       HighRxt MUST be set to the highest sequence number of the
           //       retransmitted segment unless NextSeg () rule (4) was
@@ -3033,7 +3139,7 @@ TcpSocketBase::SendPendingData (bool withAck)
             }
           if (m_tcb->m_bytesInFlight.Get () == 0)
             {
-              m_congestionControl->CwndEvent (m_tcb, TcpSocketState::CA_EVENT_TX_START);
+              CcCwndEvent (TcpSocketState::CA_EVENT_TX_START);
             }
           uint32_t sz = SendDataPacket (m_tcb->m_nextTxSequence, s, withAck);
           m_tcb->m_nextTxSequence += sz;
@@ -3173,6 +3279,10 @@ TcpSocketBase::ReceivedData (Ptr<Packet> p, const TcpHeader& tcpHeader)
 
   Unfair (p, tcpHeader.GetSequenceNumber ());
 
+  // A super-segment counts as the segments it carries for delayed ACKs
+  GsoTag gso;
+  uint32_t nSegments = p->RemovePacketTag (gso) ? gso.GetNSegments () : 1;
+
   // Put into Rx buffer
   SequenceNumber32 expectedSeq = m_rxBuffer->NextRxSequence ();
   if (!m_rxBuffer->Add (p, tcpHeader))
@@ -3203,24 +3313,24 @@ TcpSocketBase::ReceivedData (Ptr<Packet> p, const TcpHeader& tcpHeader)
   // Now send a new ACK packet acknowledging all received and delivered data
   if (m_rxBuffer->Size () > m_rxBuffer->Available () || m_rxBuffer->NextRxSequence () > expectedSeq + p->GetSize ())
     { // A gap exists in the buffer, or we filled a gap: Always ACK
-      m_congestionControl->CwndEvent (m_tcb, TcpSocketState::CA_EVENT_NON_DELAYED_ACK);
+      CcCwndEvent (TcpSocketState::CA_EVENT_NON_DELAYED_ACK);
       SendEmptyPacket (TcpHeader::ACK);
     }
   else
     { // In-sequence packet: ACK if delayed ack count allows
-      if (++m_delAckCount >= m_delAckMaxCount)
+      m_delAckCount += nSegments;
+      if (m_delAckCount >= m_delAckMaxCount)
         {
           m_delAckEvent.Cancel ();
           m_delAckCount = 0;
-          m_congestionControl->CwndEvent (m_tcb, TcpSocketState::CA_EVENT_NON_DELAYED_ACK);
+          CcCwndEvent (TcpSocketState::CA_EVENT_NON_DELAYED_ACK);
           SendEmptyPacket (TcpHeader::ACK);
         }
       else if (m_delAckEvent.IsExpired ())
         {
-          m_delAckEvent = Simulator::Schedule (m_delAckTimeout,
-                                               &TcpSocketBase::DelAckTimeout, this);
+          m_delAckEvent.Schedule (m_delAckTimeout);
           NS_LOG_LOGIC (this << " scheduled delayed ACK at " <<
-                        (Simulator::Now () + Simulator::GetDelayLeft (m_delAckEvent)).GetSeconds ());
+                        (Simulator::Now () + m_delAckEvent.GetDelayLeft ()).GetSeconds ());
         }
     }
 }
@@ -3295,7 +3405,7 @@ TcpSocketBase::NewAck (SequenceNumber32 const& ack, bool resetRTO)
   if (m_state != SYN_RCVD && resetRTO)
     { // Set RTO unless the ACK is received in SYN_RCVD state
       NS_LOG_LOGIC (this << " Cancelled ReTxTimeout event which was set to expire at " <<
-                    (Simulator::Now () + Simulator::GetDelayLeft (m_retxEvent)).GetSeconds ());
+                    (Simulator::Now () + m_retxEvent.GetDelayLeft ()).GetSeconds ());
       m_retxEvent.Cancel ();
       // On receiving a "New" ack we restart retransmission timer .. RFC 6298
       // RFC 6298, clause 2.4
@@ -3304,7 +3414,7 @@ TcpSocketBase::NewAck (SequenceNumber32 const& ack, bool resetRTO)
       NS_LOG_LOGIC (this << " Schedule ReTxTimeout at time " <<
                     Simulator::Now ().GetSeconds () << " to expire at time " <<
                     (Simulator::Now () + m_rto.Get ()).GetSeconds ());
-      m_retxEvent = Simulator::Schedule (m_rto, &TcpSocketBase::ReTxTimeout, this);
+      m_retxEvent.Schedule (m_rto);
     }
 
   // Note the highest ACK and tell app to send more
@@ -3322,7 +3432,7 @@ TcpSocketBase::NewAck (SequenceNumber32 const& ack, bool resetRTO)
   if (m_txBuffer->Size () == 0 && m_state != FIN_WAIT_1 && m_state != CLOSING)
     { // No retransmit timer if no data to retransmit
       NS_LOG_LOGIC (this << " Cancelled ReTxTimeout event which was set to expire at " <<
-                    (Simulator::Now () + Simulator::GetDelayLeft (m_retxEvent)).GetSeconds ());
+                    (Simulator::Now () + m_retxEvent.GetDelayLeft ()).GetSeconds ());
       m_retxEvent.Cancel ();
     }
 }
@@ -3432,8 +3542,8 @@ TcpSocketBase::ReTxTimeout ()
     }
 
   // Cwnd set to 1 MSS
-  m_congestionControl->CwndEvent (m_tcb, TcpSocketState::CA_EVENT_LOSS);
-  m_congestionControl->CongestionStateSet (m_tcb, TcpSocketState::CA_LOSS);
+  CcCwndEvent (TcpSocketState::CA_EVENT_LOSS);
+  CcCongestionStateSet (TcpSocketState::CA_LOSS);
   m_tcb->m_congState = TcpSocketState::CA_LOSS;
   m_tcb->m_cWnd = m_tcb->m_segmentSize;
   m_cWndInfl = m_tcb->m_cWnd;
@@ -3459,7 +3569,7 @@ void
 TcpSocketBase::DelAckTimeout (void)
 {
   m_delAckCount = 0;
-  m_congestionControl->CwndEvent (m_tcb, TcpSocketState::CA_EVENT_DELAYED_ACK);
+  CcCwndEvent (TcpSocketState::CA_EVENT_DELAYED_ACK);
   SendEmptyPacket (TcpHeader::ACK);
 }
 
@@ -3521,7 +3631,7 @@ TcpSocketBase::PersistTimeout ()
   NS_LOG_LOGIC ("Schedule persist timeout at time "
                 << Simulator::Now ().GetSeconds () << " to expire at time "
                 << (Simulator::Now () + m_persistTimeout).GetSeconds ());
-  m_persistEvent = Simulator::Schedule (m_persistTimeout, &TcpSocketBase::PersistTimeout, this);
+  m_persistEvent.Schedule (m_persistTimeout);
 }
 
 void
@@ -3580,8 +3690,7 @@ TcpSocketBase::TimeWait ()
     }
   // Move from TIME_WAIT to CLOSED after 2*MSL. Max segment lifetime is 2 min
   // according to RFC793, p.28
-  m_timewaitEvent = Simulator::Schedule (Seconds (2 * m_msl),
-                                         &TcpSocketBase::CloseAndNotify, this);
+  m_timewaitEvent.Schedule (Seconds (2 * m_msl));
 }
 
 /* Below are the attribute get/set functions */
@@ -3851,6 +3960,19 @@ TcpSocketBase::AddOptionSackPermitted (TcpHeader &header)
   NS_LOG_INFO (m_node->GetId () << " Add option SACK-PERMITTED");
 }
 
+template <class T>
+Ptr<T>
+TcpSocketBase::GetTxOption (Ptr<T> &option)
+{
+  // Creating an Object per segment is costly, while the header copies
+  // handed to TcpL4Protocol are serialized and dropped before returning
+  if (option == nullptr || option->GetReferenceCount () > 1)
+    {
+      option = CreateObject<T> ();
+    }
+  return option;
+}
+
 void
 TcpSocketBase::AddOptionSack (TcpHeader& header)
 {
@@ -3868,7 +3990,8 @@ TcpSocketBase::AddOptionSack (TcpHeader& header)
     }
 
   // Append the allowed number of SACK blocks
-  Ptr<TcpOptionSack> option = CreateObject<TcpOptionSack> ();
+  Ptr<TcpOptionSack> option = GetTxOption (m_txSackOption);
+  option->ClearSackList ();
   TcpOptionSack::SackList::iterator i;
   for (i = sackList.begin (); allowedSackBlocks > 0 && i != sackList.end (); ++i)
     {
@@ -3913,7 +4036,7 @@ TcpSocketBase::AddOptionTimestamp (TcpHeader& header)
 {
   NS_LOG_FUNCTION (this << header);
 
-  Ptr<TcpOptionTS> option = CreateObject<TcpOptionTS> ();
+  Ptr<TcpOptionTS> option = GetTxOption (m_txTimestampOption);
 
   option->SetTimestamp (TcpOptionTS::NowToTsValue ());
   option->SetEcho (m_timestampToEcho);
@@ -4061,10 +4184,62 @@ void
 TcpSocketBase::SetCongestionControlAlgorithm (Ptr<TcpCongestionOps> algo)
 {
   NS_LOG_FUNCTION (this << algo);
+  bool swap = m_congestionControl != nullptr;
   m_congestionControl = algo;
-  if (m_congestionControl->GetName() == "TcpBbr")
+  m_ccHooks = algo->GetHooks ();
+  m_ccHasCongControl = algo->HasCongControl ();
+  m_sendingBbr = algo->GetName () == "TcpBbr";
+
+  if (swap && m_state.Get () >= ESTABLISHED)
+    {
+      // Swap on a live connection: the new algorithm starts from the current
+      // window and threshold, and from the pacing rate of a new socket
+      NS_LOG_INFO ("Congestion control swapped to " << algo->GetInstanceTypeId ().GetName () <<
+                   " in state " << TcpSocketState::TcpCongStateName[m_tcb->m_congState]);
+      m_tcb->m_currentPacingRate = m_tcb->m_maxPacingRate;
+      CcCongestionStateSet (m_tcb->m_congState);
+    }
+}
+
+Ptr<TcpCongestionOps>
+TcpSocketBase::GetCongestionControlAlgorithm (void) const
+{
+  return m_congestionControl;
+}
+
+void
+TcpSocketBase::CcIncreaseWindow (uint32_t segmentsAcked)
+{
+  if (m_ccHooks & TcpCongestionOps::HOOK_INCREASE_WINDOW)
+    {
+      m_congestionControl->IncreaseWindow (m_tcb, segmentsAcked);
+    }
+}
+
+void
+TcpSocketBase::CcPktsAcked (uint32_t segmentsAcked)
+{
+  if (m_ccHooks & TcpCongestionOps::HOOK_PKTS_ACKED)
     {
-      m_sendingBbr = true;
+      m_congestionControl->PktsAcked (m_tcb, segmentsAcked, m_tcb->m_lastRtt);
+    }
+}
+
+void
+TcpSocketBase::CcCongestionStateSet (TcpSocketState::TcpCongState_t newState)
+{
+  if (m_ccHooks & TcpCongestionOps::HOOK_CONGESTION_STATE_SET)
+    {
+      m_congestionControl->CongestionStateSet (m_tcb, newState);
+    }
+}
+
+void
+TcpSocketBase::CcCwndEvent (TcpSocketState::TcpCAEvent_t event)
+{
+  if (m_ccHooks & TcpCongestionOps::HOOK_CWND_EVENT)
+    {
+      m_congestionControl->CwndEvent (m_tcb, event);
     }
 }
 
@@ -4120,7 +4295,30 @@ TcpSocketBase::Unfair (Ptr<Packet> p, SequenceNumber32 seq) {
   NS_ASSERT (p->FindFirstMatchingByteTag (tag));
   NS_ASSERT ((Simulator::Now () - tag.sndTime).GetSeconds () > 0);
   m_receivingBbr = tag.isBbr;
-  AddPacketRecord (p, tag);
+  GsoTag gso;
+  if (p->PeekPacketTag (gso))
+    {
+      // A super-segment stands for the segments it carries: record each one
+      // with its own size and send time
+      uint32_t offset = 0;
+      for (uint32_t i = 0; i < gso.GetNSegments (); i++)
+        {
+          uint32_t size = gso.GetSegmentPayloadSize (i);
+          if (!gso.IsLost (i))
+            {
+              Ptr<Packet> segment = p->CreateFragment (offset, size);
+              BbrTag segmentTag;
+              bool found = segment->FindFirstMatchingByteTag (segmentTag);
+              NS_ASSERT (found);
+              AddPacketRecord (segment, found ? segmentTag : tag);
+            }
+          offset += size;
+        }
+    }
+  else
+    {
+      AddPacketRecord (p, tag);
+    }
 
   // Debug logging.
   NS_LOG_DEBUG ("one-way delay: " << Simulator::Now () - tag.sndTime);
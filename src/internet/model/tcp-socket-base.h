@@ -37,8 +37,11 @@
 #include "bbr-tag.h"
 #include "tcp-rx-buffer.h"
 #include "tcp-tx-buffer.h"
+#include "tcp-option-ts.h"
+#include "tcp-option-sack.h"
 #include "rtt-estimator.h"
 #include "tcp-l4-protocol.h"
+#include "tcp-timer-wheel.h"
 
 #include <torch/script.h>
 
@@ -554,10 +557,21 @@ public:
   /**
    * \brief Install a congestion control algorithm on this socket
    *
+   * The algorithm can be swapped on a connected socket: the new algorithm
+   * starts from the current congestion window and slow start threshold, and
+   * is notified of the current congestion state.
+   *
    * \param algo Algorithm to be installed
    */
   void SetCongestionControlAlgorithm (Ptr<TcpCongestionOps> algo);
 
+  /**
+   * \brief Get the congestion control algorithm installed on this socket
+   *
+   * \return the congestion control algorithm
+   */
+  Ptr<TcpCongestionOps> GetCongestionControlAlgorithm (void) const;
+
   // Necessary implementations of null functions from ns3::Socket
   virtual enum SocketErrno GetErrno (void) const;    // returns m_errno
   virtual enum SocketType GetSocketType (void) const; // returns socket type
@@ -1042,6 +1056,30 @@ protected:
    */
   virtual void PersistTimeout (void);
 
+  /**
+   * \brief Call IncreaseWindow of the congestion control, if implemented
+   * \param segmentsAcked count of segments acked
+   */
+  void CcIncreaseWindow (uint32_t segmentsAcked);
+
+  /**
+   * \brief Call PktsAcked of the congestion control, if implemented
+   * \param segmentsAcked count of segments acked
+   */
+  void CcPktsAcked (uint32_t segmentsAcked);
+
+  /**
+   * \brief Call CongestionStateSet of the congestion control, if implemented
+   * \param newState the new congestion state
+   */
+  void CcCongestionStateSet (TcpSocketState::TcpCongState_t newState);
+
+  /**
+   * \brief Call CwndEvent of the congestion control, if implemented
+   * \param event the congestion window event
+   */
+  void CcCwndEvent (TcpSocketState::TcpCAEvent_t event);
+
   /**
    * \brief Retransmit the first segment marked as lost, without considering
    * available window nor pacing.
@@ -1136,6 +1174,18 @@ protected:
    */
   void AddOptionSack (TcpHeader& header);
 
+  /**
+   * \brief Get the option object to fill for an outgoing segment
+   *
+   * The object of the previous segment is reused unless a copy of its
+   * header (e.g., a pending ACK or a trace sink copy) still refers to it.
+   *
+   * \param option the object of the previous segment, replaced if needed
+   * \return the option object to fill
+   */
+  template <class T>
+  Ptr<T> GetTxOption (Ptr<T> &option);
+
   /** \brief Process the timestamp option from other side
    *
    * Get the timestamp and the echo, then save timestamp (which will
@@ -1182,11 +1232,11 @@ protected:
 
 protected:
   // Counters and events
-  EventId           m_retxEvent     {}; //!< Retransmission event
-  EventId           m_lastAckEvent  {}; //!< Last ACK timeout event
-  EventId           m_delAckEvent   {}; //!< Delayed ACK timeout event
-  EventId           m_persistEvent  {}; //!< Persist event: Send 1 byte to probe for a non-zero Rx window
-  EventId           m_timewaitEvent {}; //!< TIME_WAIT expiration event: Move this socket to CLOSED state
+  TcpTimer          m_retxEvent     {}; //!< Retransmission event
+  TcpTimer          m_lastAckEvent  {}; //!< Last ACK timeout event
+  TcpTimer          m_delAckEvent   {}; //!< Delayed ACK timeout event
+  TcpTimer          m_persistEvent  {}; //!< Persist event: Send 1 byte to probe for a non-zero Rx window
+  TcpTimer          m_timewaitEvent {}; //!< TIME_WAIT expiration event: Move this socket to CLOSED state
 
   // ACK management
   uint32_t          m_dupAckCount {0};     //!< Dupack counter
@@ -1254,6 +1304,10 @@ protected:
   bool     m_timestampEnabled {true}; //!< Timestamp option enabled
   uint32_t m_timestampToEcho  {0};    //!< Timestamp to echo
 
+  // Options reused across outgoing segments, see AddOptionTimestamp and AddOptionSack
+  Ptr<TcpOptionTS>   m_txTimestampOption {nullptr}; //!< Last timestamp option sent
+  Ptr<TcpOptionSack> m_txSackOption      {nullptr}; //!< Last SACK option sent
+
   EventId m_sendPendingDataEvent {}; //!< micro-delay event to send pending data
 
   // Fast Retransmit and Recovery
@@ -1261,9 +1315,13 @@ protected:
   uint32_t               m_retxThresh {3};   //!< Fast Retransmit threshold
   bool                   m_limitedTx  {true}; //!< perform limited transmit
 
+  uint32_t m_gsoMaxSegments {1}; //!< Maximum number of segments in a super-segment (1 disables GSO)
+
   // Transmission Control Block
   Ptr<TcpSocketState>    m_tcb {nullptr};               //!< Congestion control informations
   Ptr<TcpCongestionOps>  m_congestionControl {nullptr}; //!< Congestion control
+  uint32_t m_ccHooks {0};           //!< Hooks implemented by the congestion control (TcpCongestionOps::Hook_t)
+  bool m_ccHasCongControl {false};  //!< Whether the congestion control implements CongControl
 
   // Guesses over the other connection end
   bool m_isFirstPartialAck {true}; //!< First partial ACK during RECOVERY
@@ -1276,7 +1334,7 @@ protected:
                  Ptr<const TcpSocketBase> > m_rxTrace; //!< Trace of received packets
 
   // Pacing related variable
-  Timer m_pacingTimer {Timer::REMOVE_ON_DESTROY}; //!< Pacing Event
+  TcpTimer m_pacingTimer {}; //!< Pacing Event
 
   /**
    * \brief Inflated congestion window trace (not used in the real code, deprecated)
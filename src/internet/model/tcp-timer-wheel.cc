@@ -0,0 +1,421 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "tcp-timer-wheel.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TcpTimerWheel");
+
+NS_OBJECT_ENSURE_REGISTERED (TcpTimerWheel);
+
+/**
+ * \param word a non-null word
+ * \return the index of the lowest bit set in the word
+ */
+static inline uint32_t
+LowestBit (uint64_t word)
+{
+#if defined (__GNUC__)
+  return __builtin_ctzll (word);
+#else
+  uint32_t bit = 0;
+  while ((word & 1) == 0)
+    {
+      word >>= 1;
+      bit++;
+    }
+  return bit;
+#endif
+}
+
+TcpTimer::TcpTimer ()
+  : m_tick (0),
+    m_seq (0),
+    m_prev (0),
+    m_next (0),
+    m_head (0)
+{
+}
+
+TcpTimer::TcpTimer (const TcpTimer &o)
+  : m_wheel (o.m_wheel),
+    m_tick (0),
+    m_seq (0),
+    m_prev (0),
+    m_next (0),
+    m_head (0)
+{
+}
+
+TcpTimer::~TcpTimer ()
+{
+  Cancel ();
+}
+
+void
+TcpTimer::SetWheel (Ptr<TcpTimerWheel> wheel)
+{
+  NS_ASSERT_MSG (!IsRunning (), "Cannot move a running timer");
+  m_wheel = wheel;
+}
+
+void
+TcpTimer::SetFunction (Callback<void> function)
+{
+  m_function = function;
+}
+
+void
+TcpTimer::Schedule (Time delay)
+{
+  Cancel ();
+  if (m_wheel != 0)
+    {
+      m_deadline = Simulator::Now () + delay;
+      m_wheel->Insert (this);
+    }
+  else
+    {
+      m_event = Simulator::Schedule (delay, &TcpTimer::Expire, this);
+    }
+}
+
+void
+TcpTimer::Schedule (Time delay, Callback<void> function)
+{
+  Schedule (delay);
+  m_once = function;
+}
+
+void
+TcpTimer::Cancel (void)
+{
+  if (m_head != 0)
+    {
+      m_wheel->Remove (this);
+    }
+  else if (m_wheel == 0)
+    {
+      m_event.Cancel ();
+    }
+  m_once.Nullify ();
+}
+
+bool
+TcpTimer::IsRunning (void) const
+{
+  if (m_wheel != 0)
+    {
+      return m_head != 0;
+    }
+  return m_event.IsRunning ();
+}
+
+bool
+TcpTimer::IsExpired (void) const
+{
+  return !IsRunning ();
+}
+
+Time
+TcpTimer::GetDelayLeft (void) const
+{
+  if (m_head != 0)
+    {
+      return m_deadline - Simulator::Now ();
+    }
+  return Simulator::GetDelayLeft (m_event);
+}
+
+void
+TcpTimer::Expire (void)
+{
+  // the function may destroy the timer
+  Callback<void> function = m_once.IsNull () ? m_function : m_once;
+  m_once.Nullify ();
+  function ();
+}
+
+TypeId
+TcpTimerWheel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TcpTimerWheel")
+    .SetParent<Object> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<TcpTimerWheel> ()
+    .AddAttribute ("Granularity",
+                   "The duration of a tick of the wheel. It does not change the "
+                   "expiry time of the timers, only how they are spread in the slots. "
+                   "It must not be changed while timers are running.",
+                   TimeValue (MilliSeconds (1)),
+                   MakeTimeAccessor (&TcpTimerWheel::m_granularity),
+                   MakeTimeChecker (NanoSeconds (1)))
+  ;
+  return tid;
+}
+
+TcpTimerWheel::TcpTimerWheel ()
+  : m_overflow (0),
+    m_currentTick (0),
+    m_granularity (MilliSeconds (1)),
+    m_eventTime (Time::Max ()),
+    m_expiring (false),
+    m_seq (0),
+    m_nTimers (0)
+{
+  NS_LOG_FUNCTION (this);
+  for (uint32_t level = 0; level < LEVELS; level++)
+    {
+      for (uint32_t slot = 0; slot < SLOTS; slot++)
+        {
+          m_slots[level][slot] = 0;
+        }
+      for (uint32_t word = 0; word < WORDS; word++)
+        {
+          m_bitmap[level][word] = 0;
+        }
+    }
+}
+
+TcpTimerWheel::~TcpTimerWheel ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+TcpTimerWheel::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_event.Cancel ();
+  Object::DoDispose ();
+}
+
+uint32_t
+TcpTimerWheel::GetNTimers (void) const
+{
+  return m_nTimers;
+}
+
+void
+TcpTimerWheel::Insert (TcpTimer *timer)
+{
+  NS_LOG_FUNCTION (this << timer << timer->m_deadline);
+  NS_ASSERT (timer->m_head == 0);
+
+  if (m_nTimers == 0)
+    {
+      // nothing to move down the levels
+      m_currentTick = Simulator::Now ().GetTimeStep () / m_granularity.GetTimeStep ();
+    }
+  timer->m_tick = timer->m_deadline.GetTimeStep () / m_granularity.GetTimeStep ();
+  timer->m_seq = m_seq++;
+  Place (timer);
+  m_nTimers++;
+
+  if (!m_expiring && timer->m_deadline < m_eventTime)
+    {
+      m_event.Cancel ();
+      m_eventTime = timer->m_deadline;
+      m_event = Simulator::Schedule (m_eventTime - Simulator::Now (),
+                                     &TcpTimerWheel::Expire, this);
+    }
+}
+
+void
+TcpTimerWheel::Remove (TcpTimer *timer)
+{
+  NS_LOG_FUNCTION (this << timer);
+  NS_ASSERT (timer->m_head != 0);
+  // The simulator event is left in place: the next expiry is found when it fires
+  Unlink (timer);
+  m_nTimers--;
+}
+
+void
+TcpTimerWheel::Place (TcpTimer *timer)
+{
+  TcpTimer **head = &m_overflow;
+  for (uint32_t level = 0; level < LEVELS; level++)
+    {
+      uint32_t shift = SLOT_BITS * (level + 1);
+      if ((timer->m_tick >> shift) == (m_currentTick >> shift))
+        {
+          uint32_t slot = (timer->m_tick >> (SLOT_BITS * level)) & (SLOTS - 1);
+          head = &m_slots[level][slot];
+          m_bitmap[level][slot / 64] |= uint64_t (1) << (slot % 64);
+          break;
+        }
+    }
+
+  timer->m_prev = 0;
+  timer->m_next = *head;
+  if (*head != 0)
+    {
+      (*head)->m_prev = timer;
+    }
+  *head = timer;
+  timer->m_head = head;
+}
+
+void
+TcpTimerWheel::Unlink (TcpTimer *timer)
+{
+  TcpTimer **head = timer->m_head;
+  if (timer->m_prev != 0)
+    {
+      timer->m_prev->m_next = timer->m_next;
+    }
+  else
+    {
+      *head = timer->m_next;
+    }
+  if (timer->m_next != 0)
+    {
+      timer->m_next->m_prev = timer->m_prev;
+    }
+  timer->m_head = 0;
+
+  if (*head == 0 && head != &m_overflow)
+    {
+      uint32_t index = head - &m_slots[0][0];
+      uint32_t slot = index % SLOTS;
+      m_bitmap[index / SLOTS][slot / 64] &= ~(uint64_t (1) << (slot % 64));
+    }
+}
+
+void
+TcpTimerWheel::Replace (TcpTimer **head)
+{
+  TcpTimer *timer = *head;
+  while (timer != 0)
+    {
+      TcpTimer *next = timer->m_next;
+      Unlink (timer);
+      Place (timer);
+      timer = next;
+    }
+}
+
+void
+TcpTimerWheel::Advance (uint64_t tick)
+{
+  NS_ASSERT (tick >= m_currentTick);
+  uint64_t old = m_currentTick;
+  m_currentTick = tick;
+
+  // No timer is due before the new tick: only the timers of the new current
+  // slots have to move down
+  if ((tick >> (SLOT_BITS * LEVELS)) != (old >> (SLOT_BITS * LEVELS)))
+    {
+      Replace (&m_overflow);
+    }
+  for (uint32_t level = LEVELS - 1; level > 0; level--)
+    {
+      uint32_t shift = SLOT_BITS * level;
+      if ((tick >> shift) != (old >> shift))
+        {
+          Replace (&m_slots[level][(tick >> shift) & (SLOTS - 1)]);
+        }
+    }
+}
+
+uint32_t
+TcpTimerWheel::FindSlot (uint32_t level, uint32_t from) const
+{
+  for (uint32_t word = from / 64; word < WORDS; word++)
+    {
+      uint64_t bits = m_bitmap[level][word];
+      if (word == from / 64)
+        {
+          bits &= ~uint64_t (0) << (from % 64);
+        }
+      if (bits != 0)
+        {
+          return word * 64 + LowestBit (bits);
+        }
+    }
+  return SLOTS;
+}
+
+TcpTimer *
+TcpTimerWheel::FindEarliest (void) const
+{
+  // The timers of a level are all due after the timers of the lower levels,
+  // and the slots of a level are in the order of their ticks
+  TcpTimer *list = m_overflow;
+  for (uint32_t level = 0; level < LEVELS; level++)
+    {
+      uint32_t current = (m_currentTick >> (SLOT_BITS * level)) & (SLOTS - 1);
+      uint32_t slot = FindSlot (level, level == 0 ? current : current + 1);
+      if (slot < SLOTS)
+        {
+          list = m_slots[level][slot];
+          break;
+        }
+    }
+
+  TcpTimer *earliest = list;
+  for (TcpTimer *timer = list; timer != 0; timer = timer->m_next)
+    {
+      if (timer->m_deadline < earliest->m_deadline
+          || (timer->m_deadline == earliest->m_deadline && timer->m_seq < earliest->m_seq))
+        {
+          earliest = timer;
+        }
+    }
+  return earliest;
+}
+
+void
+TcpTimerWheel::Expire (void)
+{
+  NS_LOG_FUNCTION (this);
+  Time now = Simulator::Now ();
+  m_eventTime = Time::Max ();
+  m_expiring = true;
+
+  Advance (now.GetTimeStep () / m_granularity.GetTimeStep ());
+  for (;;)
+    {
+      TcpTimer *timer = FindEarliest ();
+      if (timer == 0 || timer->m_deadline > now)
+        {
+          break;
+        }
+      Remove (timer);
+      timer->Expire ();
+    }
+
+  m_expiring = false;
+  ScheduleEarliest ();
+}
+
+void
+TcpTimerWheel::ScheduleEarliest (void)
+{
+  TcpTimer *earliest = FindEarliest ();
+  if (earliest != 0)
+    {
+      m_eventTime = earliest->m_deadline;
+      m_event = Simulator::Schedule (m_eventTime - Simulator::Now (),
+                                     &TcpTimerWheel::Expire, this);
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,243 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TCP_TIMER_WHEEL_H
+#define TCP_TIMER_WHEEL_H
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/callback.h"
+
+namespace ns3 {
+
+class TcpTimerWheel;
+
+/**
+ * \ingroup tcp
+ *
+ * \brief A TCP timer, held either by the simulator or by a TcpTimerWheel
+ *
+ * Without a wheel, the timer is a simulator event, as an EventId would be.
+ * With a wheel, arming and cancelling the timer does not involve the
+ * simulator: only the wheel keeps a simulator event, for the next expiry
+ * of all its timers.  The timer expires at the same time in both cases.
+ *
+ * Scheduling a running timer cancels it first.  A copy of a timer is
+ * idle, without function, and uses the same wheel.
+ */
+class TcpTimer
+{
+public:
+  TcpTimer ();
+  /**
+   * \brief Copy constructor
+   * \param o the timer whose wheel is used
+   */
+  TcpTimer (const TcpTimer &o);
+  ~TcpTimer ();
+
+  /**
+   * \brief Set the wheel holding the timer
+   *
+   * The timer must not be running.
+   *
+   * \param wheel the wheel, or 0 to use simulator events
+   */
+  void SetWheel (Ptr<TcpTimerWheel> wheel);
+
+  /**
+   * \brief Set the function called when the timer expires
+   * \param function the function
+   */
+  void SetFunction (Callback<void> function);
+
+  /**
+   * \brief Arm the timer to call its function
+   * \param delay the delay before the expiry
+   */
+  void Schedule (Time delay);
+
+  /**
+   * \brief Arm the timer to call a function, once, instead of its function
+   * \param delay the delay before the expiry
+   * \param function the function
+   */
+  void Schedule (Time delay, Callback<void> function);
+
+  /**
+   * \brief Cancel the timer, if running
+   */
+  void Cancel (void);
+
+  /**
+   * \return true if the timer is armed and has not expired yet
+   */
+  bool IsRunning (void) const;
+
+  /**
+   * \return true if the timer is not running
+   */
+  bool IsExpired (void) const;
+
+  /**
+   * \return the time left before the expiry, or zero if the timer is not running
+   */
+  Time GetDelayLeft (void) const;
+
+private:
+  friend class TcpTimerWheel;
+
+  /// Assignment is not supported
+  TcpTimer &operator= (const TcpTimer &o);
+
+  /**
+   * \brief Call the function of the timer
+   */
+  void Expire (void);
+
+  Ptr<TcpTimerWheel> m_wheel;   //!< Wheel holding the timer, if any
+  Callback<void> m_function;    //!< Function called on expiry
+  Callback<void> m_once;        //!< Function called on the next expiry only
+  EventId m_event;              //!< Simulator event, without wheel
+  Time m_deadline;              //!< Expiry time, with a wheel
+  uint64_t m_tick;              //!< Wheel tick of the expiry
+  uint64_t m_seq;               //!< Arming order, to break ties
+  TcpTimer *m_prev;             //!< Previous timer in the wheel slot
+  TcpTimer *m_next;             //!< Next timer in the wheel slot
+  TcpTimer **m_head;            //!< Head of the wheel slot, or 0 if not in the wheel
+};
+
+/**
+ * \ingroup tcp
+ *
+ * \brief Hierarchical timer wheel holding the TCP timers of a node
+ *
+ * The time is divided in ticks of Granularity.  The wheel has 4 levels
+ * of 256 slots: a slot of level L spans 256^L ticks, and the level L holds
+ * the timers due in the current span of level L + 1 that are not due in
+ * the current slot of level L.  Timers due later are kept in an overflow
+ * list.  When the wheel advances, the timers of the new current slot of
+ * each level are moved to the lower levels.
+ *
+ * Arming and cancelling a timer are O(1).  The wheel keeps one simulator
+ * event, at the expiry of the earliest timer: it is only rescheduled when
+ * a timer is armed before it.  When that event fires, the timers due are
+ * expired in the order of their expiry time, and then of their arming.
+ * Cancelling the earliest timer leaves the event in place; the wheel then
+ * just finds the next expiry when it fires.  The event has the context of
+ * the code arming the timer, as the events of the timers would have: the
+ * timers of a wheel must belong to a single node.
+ */
+class TcpTimerWheel : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  TcpTimerWheel ();
+  virtual ~TcpTimerWheel ();
+
+  /**
+   * \return the number of timers running in the wheel
+   */
+  uint32_t GetNTimers (void) const;
+
+  /**
+   * \brief Insert a timer, whose deadline is set
+   * \param timer the timer
+   */
+  void Insert (TcpTimer *timer);
+
+  /**
+   * \brief Remove a timer
+   * \param timer the timer, which must be in the wheel
+   */
+  void Remove (TcpTimer *timer);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  static const uint32_t LEVELS = 4;    //!< Number of levels
+  static const uint32_t SLOT_BITS = 8; //!< Bits of the slot index in a level
+  static const uint32_t SLOTS = 1 << SLOT_BITS; //!< Number of slots in a level
+  static const uint32_t WORDS = SLOTS / 64;     //!< Words of the bitmap of a level
+
+  /**
+   * \brief Link a timer in the slot of its tick
+   * \param timer the timer
+   */
+  void Place (TcpTimer *timer);
+
+  /**
+   * \brief Unlink a timer from its slot
+   * \param timer the timer
+   */
+  void Unlink (TcpTimer *timer);
+
+  /**
+   * \brief Advance the current tick, moving the timers down the levels
+   * \param tick the new current tick, not after the earliest timer
+   */
+  void Advance (uint64_t tick);
+
+  /**
+   * \brief Move the timers of a list to their slot for the current tick
+   * \param head the head of the list
+   */
+  void Replace (TcpTimer **head);
+
+  /**
+   * \param level a level
+   * \param from the first slot to look at
+   * \return the first non-empty slot of the level from a slot, or SLOTS
+   */
+  uint32_t FindSlot (uint32_t level, uint32_t from) const;
+
+  /**
+   * \return the earliest timer, or 0 if the wheel is empty
+   */
+  TcpTimer *FindEarliest (void) const;
+
+  /**
+   * \brief Expire the timers due, and schedule the next expiry
+   */
+  void Expire (void);
+
+  /**
+   * \brief Schedule the simulator event at the earliest expiry
+   */
+  void ScheduleEarliest (void);
+
+  TcpTimer *m_slots[LEVELS][SLOTS];   //!< Slot lists
+  uint64_t m_bitmap[LEVELS][WORDS];   //!< Non-empty slots of each level
+  TcpTimer *m_overflow;               //!< Timers beyond the last level
+  uint64_t m_currentTick;             //!< Current tick
+  Time m_granularity;                 //!< Duration of a tick
+  EventId m_event;                    //!< Simulator event of the next expiry
+  Time m_eventTime;                   //!< Time of the simulator event
+  bool m_expiring;                    //!< Whether timers are being expired
+  uint64_t m_seq;                     //!< Arming counter
+  uint32_t m_nTimers;                 //!< Number of timers in the wheel
+};
+
+} // namespace ns3
+
+#endif /* TCP_TIMER_WHEEL_H */
@@ -98,7 +98,9 @@ TcpTxBuffer::GetTypeId (void)
  * initialized below is insignificant.
  */
 TcpTxBuffer::TcpTxBuffer (uint32_t n)
-  : m_maxBuffer (32768), m_size (0), m_sentSize (0), m_firstByteSeq (n)
+  : m_maxBuffer (32768), m_size (0), m_sentSize (0), m_firstByteSeq (n),
+    m_highestSack (nullptr, SequenceNumber32 (0)),
+    m_nextLostHint (n), m_nextUnsackedHint (n), m_lostMark (n)
 {
 }
 
@@ -170,7 +172,8 @@ TcpTxBuffer::SetHeadSequence (const SequenceNumber32& seq)
 
   // if you change the head with data already sent, something bad will happen
   NS_ASSERT (m_sentList.size () == 0);
-  m_highestSack = std::make_pair (m_sentList.end (), SequenceNumber32 (0));
+  m_highestSack = std::make_pair (nullptr, SequenceNumber32 (0));
+  m_nextLostHint = m_nextUnsackedHint = m_lostMark = seq;
 }
 
 bool
@@ -311,36 +314,32 @@ TcpTxBuffer::GetTransmittedSegment (uint32_t numBytes, const SequenceNumber32 &s
   NS_ASSERT (numBytes <= m_sentSize);
   NS_ASSERT (m_sentList.size () >= 1);
 
-  auto it = m_sentList.begin ();
+  auto it = FindSentItem (seq);
   bool listEdited = false;
   uint32_t s = numBytes;
 
   // Avoid to merge different packet for this retransmission if flags are
   // different.
-  for (; it != m_sentList.end(); ++it)
+  if (it != m_sentList.end () && (*it)->m_startSeq == seq)
     {
-      if ((*it)->m_startSeq == seq)
+      auto next = it;
+      next++;
+      if (next != m_sentList.end ())
         {
-          auto next = it;
-          next++;
-          if (next != m_sentList.end ())
+          // Next is not sacked... there is the possibility to merge
+          if (! (*next)->m_sacked)
             {
-              // Next is not sacked... there is the possibility to merge
-              if (! (*next)->m_sacked)
-                {
-                  s = std::min(s, (*it)->m_packet->GetSize () + (*next)->m_packet->GetSize ());
-                }
-              else
-                {
-                  // Next is sacked... better to retransmit only the first segment
-                  s = std::min(s, (*it)->m_packet->GetSize ());
-                }
+              s = std::min(s, (*it)->m_packet->GetSize () + (*next)->m_packet->GetSize ());
             }
           else
             {
+              // Next is sacked... better to retransmit only the first segment
               s = std::min(s, (*it)->m_packet->GetSize ());
             }
-          break;
+        }
+      else
+        {
+          s = std::min(s, (*it)->m_packet->GetSize ());
         }
     }
 
@@ -363,26 +362,59 @@ TcpTxBuffer::MarkTransmittedSegment (uint32_t numBytes, const SequenceNumber32 &
   return item;
 }
 
-std::pair <TcpTxBuffer::PacketList::const_iterator, SequenceNumber32>
+std::pair <TcpTxItem*, SequenceNumber32>
 TcpTxBuffer::FindHighestSacked () const
 {
   NS_LOG_FUNCTION (this);
 
-  SequenceNumber32 beginOfCurrentPacket = m_firstByteSeq;
-
-  auto ret = std::make_pair (m_sentList.end (), SequenceNumber32 (0));
-
-  for (auto it = m_sentList.begin (); it != m_sentList.end (); ++it)
+  for (auto it = m_sentList.rbegin (); it != m_sentList.rend (); ++it)
     {
-      const TcpTxItem *item = *it;
-      if (item->m_sacked)
+      if ((*it)->m_sacked)
         {
-          ret = std::make_pair (it, beginOfCurrentPacket);
+          return std::make_pair (*it, (*it)->m_startSeq);
         }
-      beginOfCurrentPacket += item->m_packet->GetSize ();
     }
 
-  return ret;
+  return std::make_pair (nullptr, SequenceNumber32 (0));
+}
+
+/**
+ * \brief Compare the starting sequence of a sent item with a sequence number
+ * \param item the item
+ * \param seq the sequence number
+ * \return true if the item starts before seq
+ */
+static bool
+ItemStartsBefore (const TcpTxItem *item, const SequenceNumber32 &seq)
+{
+  return item->m_startSeq < seq;
+}
+
+/**
+ * \brief Compare a sequence number with the starting sequence of a sent item
+ * \param seq the sequence number
+ * \param item the item
+ * \return true if seq is before the start of the item
+ */
+static bool
+SeqBeforeItem (const SequenceNumber32 &seq, const TcpTxItem *item)
+{
+  return seq < item->m_startSeq;
+}
+
+TcpTxBuffer::PacketList::const_iterator
+TcpTxBuffer::FindSentItem (const SequenceNumber32 &seq) const
+{
+  return std::lower_bound (m_sentList.begin (), m_sentList.end (), seq, ItemStartsBefore);
+}
+
+void
+TcpTxBuffer::RewindScoreboard (const SequenceNumber32 &seq)
+{
+  NS_LOG_FUNCTION (this << seq);
+  m_nextLostHint = std::min (m_nextLostHint, seq);
+  m_nextUnsackedHint = std::min (m_nextUnsackedHint, seq);
+  m_lostMark = std::min (m_lostMark, seq);
 }
 
 
@@ -446,11 +478,22 @@ TcpTxBuffer::GetPacketFromList (PacketList &list, const SequenceNumber32 &listSt
   PacketList::iterator it = list.begin ();
   SequenceNumber32 beginOfCurrentPacket = listStartFrom;
 
+  if (&list == &m_sentList && !list.empty ())
+    {
+      // Sent items know their sequence: start from the one holding seq
+      it = std::upper_bound (list.begin (), list.end (), seq, SeqBeforeItem);
+      if (it != list.begin ())
+        {
+          --it;
+        }
+      beginOfCurrentPacket = (*it)->m_startSeq;
+    }
+
   while (it != list.end ())
     {
       currentItem = *it;
       currentPacket = currentItem->m_packet;
-      NS_ASSERT_MSG (list != m_sentList || currentItem->m_startSeq >= m_firstByteSeq,
+      NS_ASSERT_MSG (&list != &m_sentList || currentItem->m_startSeq >= m_firstByteSeq,
                      "start: " << m_firstByteSeq << " currentItem start: " <<
                      currentItem->m_startSeq);
 
@@ -613,19 +656,19 @@ TcpTxBuffer::MergeItems (TcpTxItem *t1, TcpTxItem *t2) const
   // be updated in MarkTransmittedSegment.
   if (! AreEquals (t1->m_retrans, t2->m_retrans))
     {
+      TcpTxBuffer *self = const_cast<TcpTxBuffer*> (this);
       if (t1->m_retrans)
         {
-          TcpTxBuffer *self = const_cast<TcpTxBuffer*> (this);
           self->m_retrans -= t1->m_packet->GetSize ();
           t1->m_retrans = false;
         }
       else
         {
           NS_ASSERT (t2->m_retrans);
-          TcpTxBuffer *self = const_cast<TcpTxBuffer*> (this);
           self->m_retrans -= t2->m_packet->GetSize ();
           t2->m_retrans = false;
         }
+      self->RewindScoreboard (t1->m_startSeq);
     }
 
   if (t1->m_lastSent < t2->m_lastSent)
@@ -760,9 +803,15 @@ TcpTxBuffer::DiscardUpTo (const SequenceNumber32& seq)
 
   if (m_highestSack.second <= m_firstByteSeq)
     {
-      m_highestSack = std::make_pair (m_sentList.end (), SequenceNumber32 (0));
+      m_highestSack = std::make_pair (nullptr, SequenceNumber32 (0));
     }
 
+  // Keep the remembered positions inside the window, where the wrap-around
+  // comparisons of sequence numbers hold
+  m_nextLostHint = std::max (m_nextLostHint, m_firstByteSeq.Get ());
+  m_nextUnsackedHint = std::max (m_nextUnsackedHint, m_firstByteSeq.Get ());
+  m_lostMark = std::max (m_lostMark, m_firstByteSeq.Get ());
+
   NS_LOG_DEBUG ("Discarded up to " << seq << " lost: " << m_lostOut <<
                 " retrans: " << m_retrans << " sacked: " << m_sackedOut);
   NS_LOG_LOGIC ("Buffer status after discarding data " << *this);
@@ -781,18 +830,19 @@ TcpTxBuffer::Update (const TcpOptionSack::SackList &list)
 
   for (auto option_it = list.begin (); option_it != list.end (); ++option_it)
     {
-      PacketList::iterator item_it = m_sentList.begin ();
-      SequenceNumber32 beginOfCurrentPacket = m_firstByteSeq;
-
       if (m_firstByteSeq + m_sentSize < (*option_it).first && !modified)
         {
           NS_LOG_INFO ("Not updating scoreboard, the option block is outside the sent list");
           return false;
         }
 
+      // Items starting before the block cannot be covered by it
+      PacketList::const_iterator item_it = FindSentItem ((*option_it).first);
+
       while (item_it != m_sentList.end ())
         {
           uint32_t pktSize = (*item_it)->m_packet->GetSize ();
+          SequenceNumber32 beginOfCurrentPacket = (*item_it)->m_startSeq;
 
           // Check the boundary of this packet ... only mark as sacked if
           // it is precisely mapped over the option. It means that if the receiver
@@ -822,10 +872,10 @@ TcpTxBuffer::Update (const TcpOptionSack::SackList &list)
                   (*item_it)->m_sacked = true;
                   m_sackedOut += (*item_it)->m_packet->GetSize ();
 
-                  if (m_highestSack.first == m_sentList.end()
+                  if (m_highestSack.first == nullptr
                       || m_highestSack.second <= beginOfCurrentPacket + pktSize)
                     {
-                      m_highestSack = std::make_pair (item_it, beginOfCurrentPacket);
+                      m_highestSack = std::make_pair (*item_it, beginOfCurrentPacket);
                     }
 
                   NS_LOG_INFO ("Received block " << *option_it <<
@@ -844,14 +894,13 @@ TcpTxBuffer::Update (const TcpOptionSack::SackList &list)
               break;
             }
 
-          beginOfCurrentPacket += pktSize;
           ++item_it;
         }
     }
 
   if (modified)
     {
-      NS_ASSERT_MSG (modified && m_highestSack.first != m_sentList.end(), "Buffer status: " << *this);
+      NS_ASSERT_MSG (modified && m_highestSack.first != nullptr, "Buffer status: " << *this);
       UpdateLostCount ();
     }
 
@@ -867,36 +916,39 @@ void
 TcpTxBuffer::UpdateLostCount ()
 {
   NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_highestSack.first != nullptr);
+  NS_LOG_INFO ("Status before the update: " << *this <<
+               ", will start from item " << *m_highestSack.first);
+
   uint32_t sacked = 0;
-  SequenceNumber32 beginOfCurrentPacket = m_highestSack.second;
-  if (m_highestSack.first == m_sentList.end ())
-    {
-      NS_LOG_INFO ("Status before the update: " << *this <<
-                   ", will start from the latest sent item");
-    }
-  else
-    {
-      NS_LOG_INFO ("Status before the update: " << *this <<
-                   ", will start from item " << *(*m_highestSack.first));
-    }
+  SequenceNumber32 lostMark = m_lostMark;
 
-  for (auto it = m_highestSack.first; it != m_sentList.begin(); --it)
+  for (auto it = FindSentItem (m_highestSack.first->m_startSeq); it != m_sentList.begin (); --it)
     {
       TcpTxItem *item = *it;
       if (item->m_sacked)
         {
           sacked++;
+          if (sacked == m_dupAckThresh)
+            {
+              lostMark = std::max (lostMark, item->m_startSeq);
+            }
         }
 
       if (sacked >= m_dupAckThresh)
         {
+          if (item->m_startSeq < m_lostMark)
+            {
+              // Everything below has already been marked
+              break;
+            }
           if (!item->m_sacked && !item->m_lost)
             {
               item->m_lost = true;
               m_lostOut += item->m_packet->GetSize ();
+              m_nextLostHint = std::min (m_nextLostHint, item->m_startSeq);
             }
         }
-      beginOfCurrentPacket -= item->m_packet->GetSize ();
     }
 
   if (sacked >= m_dupAckThresh)
@@ -906,8 +958,10 @@ TcpTxBuffer::UpdateLostCount ()
         {
           item->m_lost = true;
           m_lostOut += item->m_packet->GetSize ();
+          m_nextLostHint = std::min (m_nextLostHint, item->m_startSeq);
         }
     }
+  m_lostMark = lostMark;
   NS_LOG_INFO ("Status after the update: " << *this);
   ConsistencyCheck ();
 }
@@ -917,35 +971,25 @@ TcpTxBuffer::IsLost (const SequenceNumber32 &seq) const
 {
   NS_LOG_FUNCTION (this << seq);
 
-  SequenceNumber32 beginOfCurrentPacket = m_firstByteSeq;
-  PacketList::const_iterator it;
-
   if (seq >= m_highestSack.second)
     {
       return false;
     }
 
-  // In theory, using a map and hints when inserting elements can improve
-  // performance
-  for (it = m_sentList.begin (); it != m_sentList.end (); ++it)
+  // The walk ends at the latest on the highest sacked item
+  for (auto it = FindSentItem (seq); it != m_sentList.end (); ++it)
     {
-      // Search for the right iterator before calling IsLost()
-      if (beginOfCurrentPacket >= seq)
+      if ((*it)->m_lost == true)
         {
-          if ((*it)->m_lost == true)
-            {
-              NS_LOG_INFO ("seq=" << seq << " is lost because of lost flag");
-              return true;
-            }
-
-          if ((*it)->m_sacked == true)
-            {
-              NS_LOG_INFO ("seq=" << seq << " is not lost because of sacked flag");
-              return false;
-            }
+          NS_LOG_INFO ("seq=" << seq << " is lost because of lost flag");
+          return true;
         }
 
-      beginOfCurrentPacket += (*it)->m_packet->GetSize ();
+      if ((*it)->m_sacked == true)
+        {
+          NS_LOG_INFO ("seq=" << seq << " is not lost because of sacked flag");
+          return false;
+        }
     }
 
   return false;
@@ -971,34 +1015,22 @@ TcpTxBuffer::NextSeg (SequenceNumber32 *seq, bool isRecovery) const
    */
   PacketList::const_iterator it;
   TcpTxItem *item;
-  SequenceNumber32 seqPerRule3;
-  bool isSeqPerRule3Valid = false;
-  SequenceNumber32 beginOfCurrentPkt = m_firstByteSeq;
 
-  for (it = m_sentList.begin (); it != m_sentList.end (); ++it)
+  // No item before m_nextLostHint meets the criteria
+  for (it = FindSentItem (m_nextLostHint); it != m_sentList.end (); ++it)
     {
       item = *it;
 
       // Condition 1.a , 1.b , and 1.c
-      if (item->m_retrans == false && item->m_sacked == false)
+      if (item->m_retrans == false && item->m_sacked == false && item->m_lost)
         {
-          if (item->m_lost)
-            {
-              NS_LOG_INFO("IsLost, returning" << beginOfCurrentPkt);
-              *seq = beginOfCurrentPkt;
-              return true;
-            }
-          else if (seqPerRule3.GetValue () == 0 && isRecovery)
-            {
-              NS_LOG_INFO ("Saving for rule 3 the seq " << beginOfCurrentPkt);
-              isSeqPerRule3Valid = true;
-              seqPerRule3 = beginOfCurrentPkt;
-            }
+          NS_LOG_INFO("IsLost, returning" << item->m_startSeq);
+          m_nextLostHint = item->m_startSeq;
+          *seq = item->m_startSeq;
+          return true;
         }
-
-      // Nothing found, iterate
-      beginOfCurrentPkt += item->m_packet->GetSize ();
     }
+  m_nextLostHint = m_firstByteSeq + m_sentSize;
 
   /* (2) If no sequence number 'S2' per rule (1) exists but there
    *     exists available unsent data and the receiver's advertised
@@ -1023,11 +1055,21 @@ TcpTxBuffer::NextSeg (SequenceNumber32 *seq, bool isRecovery) const
    *     (specifically excluding step (1.c)), then one segment of up to
    *     SMSS octets starting with S3 SHOULD be returned.
    */
-  if (isSeqPerRule3Valid)
+  if (isRecovery)
     {
-      NS_LOG_INFO ("Rule3 valid. " << seqPerRule3);
-      *seq = seqPerRule3;
-      return true;
+      // Since rule (1) failed, none of the items found here is lost
+      for (it = FindSentItem (m_nextUnsackedHint); it != m_sentList.end (); ++it)
+        {
+          item = *it;
+          if (item->m_retrans == false && item->m_sacked == false)
+            {
+              NS_LOG_INFO ("Rule3 valid. " << item->m_startSeq);
+              m_nextUnsackedHint = item->m_startSeq;
+              *seq = item->m_startSeq;
+              return true;
+            }
+        }
+      m_nextUnsackedHint = m_firstByteSeq + m_sentSize;
     }
 
   /* (4) If the conditions for (1), (2), and (3) fail, but there exists
@@ -1182,7 +1224,7 @@ TcpTxBuffer::IsLostRFC (const SequenceNumber32 &seq, const PacketList::const_ite
 
       beginOfCurrentPacket += current->GetSize ();
     }
-  if (it == m_highestSack.first)
+  if (m_highestSack.first == nullptr)
     {
       NS_LOG_INFO ("seq=" << seq << " is not lost because there are no sacked segment ahead " << m_highestSack.second);
     }
@@ -1200,7 +1242,8 @@ TcpTxBuffer::ResetRenoSack ()
       (*it)->m_sacked = false;
     }
 
-  m_highestSack = std::make_pair (m_sentList.end (), SequenceNumber32 (0));
+  m_highestSack = std::make_pair (nullptr, SequenceNumber32 (0));
+  RewindScoreboard (m_firstByteSeq);
 }
 
 void
@@ -1222,7 +1265,8 @@ TcpTxBuffer::ResetSentList ()
   m_lostOut = 0;
   m_retrans = 0;
   m_sackedOut = 0;
-  m_highestSack = std::make_pair (m_sentList.end (), SequenceNumber32 (0));
+  m_highestSack = std::make_pair (nullptr, SequenceNumber32 (0));
+  RewindScoreboard (m_firstByteSeq);
 }
 
 void
@@ -1239,6 +1283,7 @@ TcpTxBuffer::ResetLastSegmentSent ()
         {
           m_retrans -= item->m_packet->GetSize ();
         }
+      RewindScoreboard (item->m_startSeq);
       m_appList.insert (m_appList.begin (), item);
     }
   ConsistencyCheck ();
@@ -1254,7 +1299,7 @@ TcpTxBuffer::SetSentListLost (bool resetSack)
     {
       m_sackedOut = 0;
       m_lostOut = m_sentSize;
-      m_highestSack = std::make_pair (m_sentList.end (), SequenceNumber32 (0));
+      m_highestSack = std::make_pair (nullptr, SequenceNumber32 (0));
     }
   else
     {
@@ -1286,6 +1331,10 @@ TcpTxBuffer::SetSentListLost (bool resetSack)
       (*it)->m_retrans = false;
     }
 
+  // Every item is now either lost or sacked
+  RewindScoreboard (m_firstByteSeq);
+  m_lostMark = m_firstByteSeq + m_sentSize;
+
   NS_LOG_INFO ("Set sent list lost, status: " << *this);
   NS_ASSERT_MSG (m_sentSize >= m_sackedOut + m_lostOut, *this);
   ConsistencyCheck ();
@@ -1318,6 +1367,7 @@ TcpTxBuffer::DeleteRetransmittedFlagFromHead ()
     {
       m_sentList.front ()->m_retrans = false;
       m_retrans -= m_sentList.front ()->m_packet->GetSize ();
+      RewindScoreboard (m_firstByteSeq);
     }
   ConsistencyCheck ();
 }
@@ -1347,6 +1397,7 @@ TcpTxBuffer::MarkHeadAsLost ()
           m_sentList.front()->m_lost = true;
           m_lostOut += m_sentList.front ()->m_packet->GetSize ();
         }
+      RewindScoreboard (m_firstByteSeq);
     }
   ConsistencyCheck ();
 }
@@ -1373,7 +1424,7 @@ TcpTxBuffer::AddRenoSack (void)
     {
       (*it)->m_sacked = true;
       m_sackedOut += (*it)->m_packet->GetSize ();
-      m_highestSack = std::make_pair (it, (*it)->m_startSeq);
+      m_highestSack = std::make_pair (*it, (*it)->m_startSeq);
       NS_LOG_INFO ("Added a Reno SACK, status: " << *this);
     }
   else
@@ -1502,7 +1553,7 @@ TcpTxBuffer::GenerateRateSample ()
       m_tcb->m_appLimited = 0;
     }
 
-  if (m_rs.m_priorTime == Seconds (0))
+  if (m_rs.m_priorTime.IsZero ())
     {
       return false;
     }
@@ -1513,17 +1564,32 @@ TcpTxBuffer::GenerateRateSample ()
 
   if (m_rs.m_interval < m_tcb->m_minRtt)
     {
-      m_rs.m_interval = Seconds (0);
+      m_rs.m_interval = Time (0);
       return false;
     }
 
-  if (m_rs.m_interval != Seconds (0))
+  if (!m_rs.m_interval.IsZero ())
     {
-      m_rs.m_deliveryRate = DataRate (m_rs.m_delivered * 8.0 / m_rs.m_interval.GetSeconds ());
+      m_rs.m_deliveryRate = GetDeliveryRate (m_rs.m_delivered, m_rs.m_interval);
     }
   return true;
 }
 
+DataRate
+TcpTxBuffer::GetDeliveryRate (uint32_t delivered, Time interval)
+{
+  int64_t ns = interval.GetNanoSeconds ();
+  NS_ASSERT (ns > 0);
+  uint64_t bits = static_cast<uint64_t> (delivered) * 8;
+  if (ns > 18000000000)
+    {
+      // the remainder below could overflow
+      return DataRate (bits * 1e9 / ns);
+    }
+  // split the division, so that the product by 10^9 fits in 64 bits
+  return DataRate (bits / ns * 1000000000 + bits % ns * 1000000000 / ns);
+}
+
 void
 TcpTxBuffer::OnApplicationWrite ()
 {
@@ -30,6 +30,7 @@
 #include "ns3/packet.h"
 #include "ns3/data-rate.h"
 #include "ns3/tcp-socket-base.h"
+#include <deque>
 
 namespace ns3 {
 class Packet;
@@ -123,8 +124,17 @@ public:
  * associated with every segment sent. This is done through the use of the
  * class TcpTxItem: instead of storing a list of packets, we store a list of
  * TcpTxItem. Each item has different flags (check the corresponding
- * documentation) and maintaining the scoreboard is a matter of travelling the
- * list and set the SACK flag on the corresponding segment sent.
+ * documentation) and maintaining the scoreboard is a matter of finding the
+ * segments covered by a SACK block and setting their SACK flag.
+ *
+ * Sent segments are kept ordered by their starting sequence number in a
+ * random access container, so the segment holding a given sequence number is
+ * found with a binary search instead of a walk from SND.UNA. The walks that
+ * remain (the search for the next segment to retransmit and the marking of
+ * lost segments) resume from positions remembered across calls, below which
+ * the scoreboard is known not to have changed: with large windows, processing
+ * an ACK costs O(log n) plus the number of segments whose state changes,
+ * rather than O(n).
  *
  * Item properties
  * ---------------
@@ -453,6 +463,18 @@ public:
    */
   bool GenerateRateSample ();
 
+  /**
+   * \brief Computes a delivery rate in the integer domain
+   *
+   * The rate is the exact quotient of the bits and the interval, rounded
+   * down to the bps, without converting the interval to seconds.
+   *
+   * \param delivered the bytes delivered over the interval
+   * \param interval the length of the interval, which must be positive
+   * \return the delivery rate
+   */
+  static DataRate GetDeliveryRate (uint32_t delivered, Time interval);
+
   /**
    * \brief Checks if connection is app-limited upon each write from the application
    */
@@ -460,7 +482,7 @@ public:
 private:
   friend std::ostream & operator<< (std::ostream & os, TcpTxBuffer const & tcpTxBuf);
 
-  typedef std::list<TcpTxItem*> PacketList; //!< container for data stored in the buffer
+  typedef std::deque<TcpTxItem*> PacketList; //!< container for data stored in the buffer
 
   /**
    * \brief Update the lost count
@@ -477,12 +499,31 @@ private:
    * The {New}Reno cases, for now, are managed in TcpSocketBase through the
    * call to MarkHeadAsLost.
    * This function is, therefore, called after a SACK option has been received,
-   * and updates the lost count. It can be probably optimized by not walking
-   * the entire list, but a subset.
+   * and updates the lost count. The walk stops at m_lostMark, below which
+   * every segment is already either lost or sacked.
    *
    */
   void UpdateLostCount ();
 
+  /**
+   * \brief Find the first sent item starting at or after a sequence number
+   *
+   * \param seq the sequence number
+   * \return an iterator to the item, or the end of m_sentList
+   */
+  PacketList::const_iterator FindSentItem (const SequenceNumber32 &seq) const;
+
+  /**
+   * \brief Move back the scoreboard positions remembered across calls
+   *
+   * To be called when a flag of an item is changed in a way that can make
+   * the item eligible for retransmission again (lost flag set, retransmitted
+   * or sacked flag cleared), or when an item is removed from the tail.
+   *
+   * \param seq starting sequence of the item that changed
+   */
+  void RewindScoreboard (const SequenceNumber32 &seq);
+
   /**
    * \brief Remove the size specified from the lostOut, retrans, sacked count
    *
@@ -656,9 +697,9 @@ private:
 
   /**
    * \brief Find the highest SACK byte
-   * \return a pair with the highest byte and an iterator inside m_sentList
+   * \return a pair with the highest sacked item (or nullptr) and its first byte
    */
-  std::pair <TcpTxBuffer::PacketList::const_iterator, SequenceNumber32>
+  std::pair <TcpTxItem*, SequenceNumber32>
   FindHighestSacked () const;
 
   PacketList m_appList;  //!< Buffer for application data
@@ -668,7 +709,11 @@ private:
   uint32_t m_sentSize;   //!< Size of sent (and not discarded) segments
 
   TracedValue<SequenceNumber32> m_firstByteSeq; //!< Sequence number of the first byte in data (SND.UNA)
-  std::pair <PacketList::const_iterator, SequenceNumber32> m_highestSack; //!< Highest SACK byte
+  std::pair <TcpTxItem*, SequenceNumber32> m_highestSack; //!< Highest SACK item (or nullptr) and its first byte
+
+  mutable SequenceNumber32 m_nextLostHint;     //!< No item before it is lost and not yet retransmitted
+  mutable SequenceNumber32 m_nextUnsackedHint; //!< No item before it is neither sacked nor retransmitted
+  SequenceNumber32 m_lostMark; //!< Every item before it is either lost or sacked
 
   uint32_t m_lostOut   {0}; //!< Number of lost bytes
   uint32_t m_sackedOut {0}; //!< Number of sacked bytes
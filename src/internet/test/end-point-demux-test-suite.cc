@@ -0,0 +1,180 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "../model/ipv4-end-point-demux.h"
+#include "../model/ipv4-end-point.h"
+#include "ns3/ipv4-interface.h"
+#include "../model/ipv6-end-point-demux.h"
+#include "../model/ipv6-end-point.h"
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check the lookups of Ipv4EndPointDemux with many connections
+ */
+class Ipv4EndPointDemuxTestCase : public TestCase
+{
+public:
+  Ipv4EndPointDemuxTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+Ipv4EndPointDemuxTestCase::Ipv4EndPointDemuxTestCase ()
+  : TestCase ("Check the IPv4 end point demux lookups")
+{
+}
+
+void
+Ipv4EndPointDemuxTestCase::DoRun (void)
+{
+  Ipv4EndPointDemux demux;
+  Ptr<Ipv4Interface> iface = CreateObject<Ipv4Interface> ();
+  Ipv4Address local ("10.0.0.1");
+
+  Ipv4EndPoint *listener = demux.Allocate (0, Ipv4Address::GetAny (), 80);
+  NS_TEST_ASSERT_MSG_NE (listener, 0, "The listener must be allocated");
+  NS_TEST_EXPECT_MSG_EQ (demux.Allocate (0, Ipv4Address::GetAny (), 80), 0, "Duplicated listener");
+
+  std::vector<Ipv4EndPoint *> connections;
+  for (uint32_t i = 0; i < 1000; i++)
+    {
+      Ipv4Address peer (Ipv4Address ("10.1.0.0").Get () + i / 10);
+      connections.push_back (demux.Allocate (0, local, 80, peer, 1000 + i % 10));
+      NS_TEST_ASSERT_MSG_NE (connections.back (), 0, "The connection must be allocated");
+    }
+  NS_TEST_EXPECT_MSG_EQ (demux.Allocate (0, local, 80, Ipv4Address ("10.1.0.0"), 1000), 0,
+                         "Duplicated connection");
+  NS_TEST_EXPECT_MSG_EQ (demux.GetAllEndPoints ().size (), 1001, "Unexpected number of end points");
+  NS_TEST_EXPECT_MSG_EQ (demux.LookupPortLocal (80), true, "Port 80 is in use");
+  NS_TEST_EXPECT_MSG_EQ (demux.LookupPortLocal (81), false, "Port 81 is not in use");
+
+  for (uint32_t i = 0; i < connections.size (); i++)
+    {
+      Ipv4EndPointDemux::EndPoints found =
+        demux.Lookup (local, 80, connections[i]->GetPeerAddress (), connections[i]->GetPeerPort (), iface);
+      NS_TEST_ASSERT_MSG_EQ (found.size (), 1, "Exactly one end point must be found");
+      NS_TEST_EXPECT_MSG_EQ (found.front (), connections[i], "The connection must be found");
+    }
+  NS_TEST_EXPECT_MSG_EQ (demux.SimpleLookup (local, 80, Ipv4Address ("10.1.0.5"), 1003), connections[53],
+                         "The connection must be found");
+
+  Ipv4EndPointDemux::EndPoints found = demux.Lookup (local, 80, Ipv4Address ("10.2.0.1"), 1000, iface);
+  NS_TEST_ASSERT_MSG_EQ (found.size (), 1, "The listener must be found");
+  NS_TEST_EXPECT_MSG_EQ (found.front (), listener, "The listener must be found");
+
+  // the index follows the changes of the peer
+  connections[0]->SetPeer (Ipv4Address ("10.2.0.1"), 1000);
+  found = demux.Lookup (local, 80, Ipv4Address ("10.2.0.1"), 1000, iface);
+  NS_TEST_EXPECT_MSG_EQ (found.front (), connections[0], "The connection must be found at its new peer");
+  found = demux.Lookup (local, 80, Ipv4Address ("10.1.0.0"), 1000, iface);
+  NS_TEST_EXPECT_MSG_EQ (found.front (), listener, "The connection must not be found at its old peer");
+
+  // disabled end points are skipped
+  connections[1]->SetRxEnabled (false);
+  found = demux.Lookup (local, 80, Ipv4Address ("10.1.0.0"), 1001, iface);
+  NS_TEST_EXPECT_MSG_EQ (found.front (), listener, "Disabled end points must be skipped");
+
+  demux.DeAllocate (connections[2]);
+  found = demux.Lookup (local, 80, Ipv4Address ("10.1.0.0"), 1002, iface);
+  NS_TEST_EXPECT_MSG_EQ (found.front (), listener, "Deallocated end points must not be found");
+
+  demux.DeAllocate (listener);
+  found = demux.Lookup (local, 80, Ipv4Address ("10.1.0.0"), 1002, iface);
+  NS_TEST_EXPECT_MSG_EQ (found.empty (), true, "No end point must be found");
+  NS_TEST_EXPECT_MSG_EQ (demux.GetAllEndPoints ().size (), 999, "Unexpected number of end points");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check the lookups of Ipv6EndPointDemux with many connections
+ */
+class Ipv6EndPointDemuxTestCase : public TestCase
+{
+public:
+  Ipv6EndPointDemuxTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+Ipv6EndPointDemuxTestCase::Ipv6EndPointDemuxTestCase ()
+  : TestCase ("Check the IPv6 end point demux lookups")
+{
+}
+
+void
+Ipv6EndPointDemuxTestCase::DoRun (void)
+{
+  Ipv6EndPointDemux demux;
+  Ipv6Address local ("2001:1::1");
+  Ipv6Address peer ("2001:2::1");
+
+  Ipv6EndPoint *listener = demux.Allocate (0, local, 80);
+  NS_TEST_ASSERT_MSG_NE (listener, 0, "The listener must be allocated");
+
+  std::vector<Ipv6EndPoint *> connections;
+  for (uint16_t i = 0; i < 100; i++)
+    {
+      connections.push_back (demux.Allocate (0, local, 80, peer, 1000 + i));
+      NS_TEST_ASSERT_MSG_NE (connections.back (), 0, "The connection must be allocated");
+    }
+  NS_TEST_EXPECT_MSG_EQ (demux.Allocate (0, local, 80, peer, 1000), 0, "Duplicated connection");
+  NS_TEST_EXPECT_MSG_EQ (demux.GetEndPoints ().size (), 101, "Unexpected number of end points");
+
+  for (uint16_t i = 0; i < connections.size (); i++)
+    {
+      Ipv6EndPointDemux::EndPoints found = demux.Lookup (local, 80, peer, 1000 + i, 0);
+      NS_TEST_ASSERT_MSG_EQ (found.size (), 1, "Exactly one end point must be found");
+      NS_TEST_EXPECT_MSG_EQ (found.front (), connections[i], "The connection must be found");
+    }
+
+  Ipv6EndPointDemux::EndPoints found = demux.Lookup (local, 80, peer, 2000, 0);
+  NS_TEST_EXPECT_MSG_EQ (found.front (), listener, "The listener must be found");
+
+  connections[0]->SetPeer (peer, 2000);
+  found = demux.Lookup (local, 80, peer, 2000, 0);
+  NS_TEST_EXPECT_MSG_EQ (found.front (), connections[0], "The connection must be found at its new peer");
+
+  demux.DeAllocate (connections[0]);
+  found = demux.Lookup (local, 80, peer, 2000, 0);
+  NS_TEST_EXPECT_MSG_EQ (found.front (), listener, "Deallocated end points must not be found");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief End point demux TestSuite
+ */
+class EndPointDemuxTestSuite : public TestSuite
+{
+public:
+  EndPointDemuxTestSuite ()
+    : TestSuite ("end-point-demux", UNIT)
+  {
+    AddTestCase (new Ipv4EndPointDemuxTestCase (), TestCase::QUICK);
+    AddTestCase (new Ipv6EndPointDemuxTestCase (), TestCase::QUICK);
+  }
+};
+
+static EndPointDemuxTestSuite g_endPointDemuxTestSuite; //!< Static variable for test initialization
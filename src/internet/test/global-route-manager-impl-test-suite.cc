@@ -27,6 +27,8 @@
 #include "ns3/candidate-queue.h"
 #include "ns3/simulator.h"
 #include <cstdlib> // for rand()
+#include <algorithm>
+#include <list>
 
 using namespace ns3;
 
@@ -226,6 +228,104 @@ GlobalRouteManagerImplTestCase::DoRun (void)
 }
 
 
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check the order of the CandidateQueue against a sorted list
+ *
+ * Vertices of equal priority must be popped in the order of a stably
+ * sorted list, since the equal-cost paths found depend on it.
+ */
+class CandidateQueueOrderTestCase : public TestCase
+{
+public:
+  CandidateQueueOrderTestCase ();
+  virtual void DoRun (void);
+
+  /**
+   * \param v1 first vertex
+   * \param v2 second vertex
+   * \return true if v1 is popped before v2
+   */
+  static bool Compare (const SPFVertex *v1, const SPFVertex *v2);
+};
+
+CandidateQueueOrderTestCase::CandidateQueueOrderTestCase ()
+  : TestCase ("CandidateQueue must pop the vertices in the order of a sorted list")
+{
+}
+
+bool
+CandidateQueueOrderTestCase::Compare (const SPFVertex *v1, const SPFVertex *v2)
+{
+  if (v1->GetDistanceFromRoot () != v2->GetDistanceFromRoot ())
+    {
+      return v1->GetDistanceFromRoot () < v2->GetDistanceFromRoot ();
+    }
+  return v1->GetVertexType () == SPFVertex::VertexNetwork
+         && v2->GetVertexType () == SPFVertex::VertexRouter;
+}
+
+void
+CandidateQueueOrderTestCase::DoRun (void)
+{
+  CandidateQueue candidate;
+  std::list<SPFVertex *> reference;
+  uint32_t id = 0;
+  for (int step = 0; step < 5000; ++step)
+    {
+      int op = std::rand () % 8;
+      if (op < 4 || reference.empty ())
+        {
+          // Few distances, so that many vertices are of equal priority
+          SPFVertex *v = new SPFVertex;
+          v->SetVertexId (Ipv4Address (++id));
+          v->SetVertexType (std::rand () % 3 ? SPFVertex::VertexRouter : SPFVertex::VertexNetwork);
+          v->SetDistanceFromRoot (10 + std::rand () % 10);
+          candidate.Push (v);
+          reference.insert (std::upper_bound (reference.begin (), reference.end (), v, &Compare), v);
+        }
+      else if (op < 6)
+        {
+          SPFVertex *v = candidate.Pop ();
+          NS_TEST_ASSERT_MSG_EQ (v, reference.front (), "Wrong vertex popped at step " << step);
+          reference.pop_front ();
+          delete v;
+        }
+      else
+        {
+          // A shorter path to a candidate
+          std::list<SPFVertex *>::iterator i = reference.begin ();
+          std::advance (i, std::rand () % reference.size ());
+          SPFVertex *v = candidate.Find ((*i)->GetVertexId ());
+          NS_TEST_ASSERT_MSG_EQ (v, *i, "Wrong vertex found at step " << step);
+          if (v->GetDistanceFromRoot () > 0)
+            {
+              v->SetDistanceFromRoot (std::rand () % v->GetDistanceFromRoot ());
+            }
+          if (op == 6)
+            {
+              candidate.Reorder (v);
+            }
+          else
+            {
+              candidate.Reorder ();
+            }
+          reference.sort (&Compare);
+        }
+      NS_TEST_ASSERT_MSG_EQ (candidate.Size (), reference.size (), "Wrong size at step " << step);
+    }
+  while (!reference.empty ())
+    {
+      SPFVertex *v = candidate.Pop ();
+      NS_TEST_ASSERT_MSG_EQ (v, reference.front (), "Wrong vertex popped");
+      reference.pop_front ();
+      delete v;
+    }
+  NS_TEST_ASSERT_MSG_EQ (candidate.Empty (), true, "Queue not empty");
+}
+
 /**
  * \ingroup internet-test
  * \ingroup tests
@@ -243,6 +343,7 @@ GlobalRouteManagerImplTestSuite::GlobalRouteManagerImplTestSuite ()
   : TestSuite ("global-route-manager-impl", UNIT)
 {
   AddTestCase (new GlobalRouteManagerImplTestCase (), TestCase::QUICK);
+  AddTestCase (new CandidateQueueOrderTestCase (), TestCase::QUICK);
 }
 
 static GlobalRouteManagerImplTestSuite g_globalRoutingManagerImplTestSuite; //!< Static variable for test initialization
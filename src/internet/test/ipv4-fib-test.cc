@@ -0,0 +1,206 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-static-routing-helper.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/ipv4-routing-table-entry.h"
+#include "ns3/ipv4-fib.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Compare the lookups of an Ipv4Fib with a scan of its prefixes
+ */
+class Ipv4FibLookupTestCase : public TestCase
+{
+public:
+  Ipv4FibLookupTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+Ipv4FibLookupTestCase::Ipv4FibLookupTestCase ()
+  : TestCase ("The forwarding table must return the matching routes in list order")
+{
+}
+
+void
+Ipv4FibLookupTestCase::DoRun (void)
+{
+  Ptr<UniformRandomVariable> rand = CreateObject<UniformRandomVariable> ();
+  std::vector<Ipv4Fib::Prefix> prefixes;
+  // Networks under a few /8, so that the prefixes overlap
+  for (uint32_t i = 0; i < 2000; i++)
+    {
+      uint32_t length = rand->GetInteger (0, 32);
+      uint32_t mask = length == 0 ? 0 : ~0u << (32 - length);
+      uint32_t network = (rand->GetInteger (10, 13) << 24) | rand->GetInteger (0, 0xffffff);
+      prefixes.push_back (std::make_pair (Ipv4Address (network & mask), Ipv4Mask (mask)));
+    }
+  // Duplicated prefixes, a default route and non-contiguous masks
+  prefixes.push_back (prefixes[7]);
+  prefixes.push_back (std::make_pair (Ipv4Address ("0.0.0.0"), Ipv4Mask::GetZero ()));
+  prefixes.push_back (std::make_pair (Ipv4Address ("10.0.0.1"), Ipv4Mask ("255.0.0.255")));
+  prefixes.push_back (std::make_pair (Ipv4Address ("11.0.0.0"), Ipv4Mask ("255.0.255.0")));
+  prefixes.push_back (prefixes[7]);
+
+  Ipv4Fib fib;
+  fib.Build (prefixes);
+
+  std::vector<uint32_t> routes;
+  for (uint32_t i = 0; i < 20000; i++)
+    {
+      // Half of the destinations in a prefix of the table
+      uint32_t dest;
+      if (i % 2 == 0)
+        {
+          const Ipv4Fib::Prefix &prefix = prefixes[rand->GetInteger (0, prefixes.size () - 1)];
+          dest = prefix.first.Get () | (rand->GetInteger (0, 0xffffffff) & ~prefix.second.Get ());
+        }
+      else
+        {
+          dest = rand->GetInteger (0, 0xffffffff);
+        }
+      std::vector<uint32_t> expected;
+      for (uint32_t j = 0; j < prefixes.size (); j++)
+        {
+          if (prefixes[j].second.IsMatch (Ipv4Address (dest), prefixes[j].first))
+            {
+              expected.push_back (j);
+            }
+        }
+      fib.Lookup (Ipv4Address (dest), routes);
+      NS_TEST_ASSERT_MSG_EQ (routes.size (), expected.size (), "Wrong number of routes to " << Ipv4Address (dest));
+      for (uint32_t j = 0; j < routes.size (); j++)
+        {
+          NS_TEST_ASSERT_MSG_EQ (routes[j], expected[j], "Wrong route to " << Ipv4Address (dest));
+        }
+    }
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check the route selection of Ipv4StaticRouting through its forwarding table
+ */
+class Ipv4StaticRoutingFibTestCase : public TestCase
+{
+public:
+  Ipv4StaticRoutingFibTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \param dest a destination
+   * \return the gateway of the route to the destination, or 0.0.0.0 if none
+   */
+  Ipv4Address GetGateway (const char *dest);
+
+  Ptr<Ipv4StaticRouting> m_routing; //!< Routing protocol under test
+};
+
+Ipv4StaticRoutingFibTestCase::Ipv4StaticRoutingFibTestCase ()
+  : TestCase ("Static routing must select the longest prefix, then the lowest metric")
+{
+}
+
+Ipv4Address
+Ipv4StaticRoutingFibTestCase::GetGateway (const char *dest)
+{
+  Ipv4Header header;
+  header.SetDestination (Ipv4Address (dest));
+  Socket::SocketErrno err;
+  Ptr<Ipv4Route> route = m_routing->RouteOutput (Create<Packet> (), header, 0, err);
+  return route == 0 ? Ipv4Address::GetZero () : route->GetGateway ();
+}
+
+void
+Ipv4StaticRoutingFibTestCase::DoRun (void)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  InternetStackHelper internet;
+  internet.Install (node);
+  Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+  device->SetAddress (Mac48Address::Allocate ());
+  node->AddDevice (device);
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  uint32_t interface = ipv4->AddInterface (device);
+  ipv4->AddAddress (interface, Ipv4InterfaceAddress (Ipv4Address ("192.168.0.1"), Ipv4Mask ("/16")));
+  ipv4->SetUp (interface);
+
+  Ipv4StaticRoutingHelper helper;
+  m_routing = helper.GetStaticRouting (ipv4);
+  m_routing->SetDefaultRoute (Ipv4Address ("192.168.0.2"), interface, 5);
+  m_routing->AddNetworkRouteTo (Ipv4Address ("10.0.0.0"), Ipv4Mask ("/8"), Ipv4Address ("192.168.0.3"), interface, 5);
+  m_routing->AddNetworkRouteTo (Ipv4Address ("10.1.0.0"), Ipv4Mask ("/16"), Ipv4Address ("192.168.0.4"), interface, 5);
+  m_routing->AddNetworkRouteTo (Ipv4Address ("10.1.0.0"), Ipv4Mask ("/16"), Ipv4Address ("192.168.0.5"), interface, 2);
+  m_routing->AddNetworkRouteTo (Ipv4Address ("10.1.0.0"), Ipv4Mask ("/16"), Ipv4Address ("192.168.0.6"), interface, 2);
+  m_routing->AddHostRouteTo (Ipv4Address ("10.1.2.3"), Ipv4Address ("192.168.0.7"), interface, 9);
+  m_routing->AddHostRouteTo (Ipv4Address ("10.1.2.3"), Ipv4Address ("192.168.0.8"), interface, 1);
+
+  NS_TEST_ASSERT_MSG_EQ (GetGateway ("172.16.0.1"), Ipv4Address ("192.168.0.2"), "Default route expected");
+  NS_TEST_ASSERT_MSG_EQ (GetGateway ("10.2.0.1"), Ipv4Address ("192.168.0.3"), "/8 route expected");
+  NS_TEST_ASSERT_MSG_EQ (GetGateway ("10.1.0.1"), Ipv4Address ("192.168.0.6"),
+                         "Last /16 route of the lowest metric expected");
+  NS_TEST_ASSERT_MSG_EQ (GetGateway ("10.1.2.3"), Ipv4Address ("192.168.0.7"), "First host route expected");
+  NS_TEST_ASSERT_MSG_EQ (GetGateway ("192.168.3.4"), Ipv4Address ("0.0.0.0"), "Interface route expected");
+
+  // The forwarding table must follow the changes of the routes
+  for (uint32_t i = m_routing->GetNRoutes (); i-- > 0; )
+    {
+      if (m_routing->GetRoute (i).GetGateway () == Ipv4Address ("192.168.0.6")
+          || m_routing->GetRoute (i).GetGateway () == Ipv4Address ("192.168.0.7"))
+        {
+          m_routing->RemoveRoute (i);
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ (GetGateway ("10.1.0.1"), Ipv4Address ("192.168.0.5"), "Remaining /16 route expected");
+  NS_TEST_ASSERT_MSG_EQ (GetGateway ("10.1.2.3"), Ipv4Address ("192.168.0.8"), "Remaining host route expected");
+  m_routing->AddNetworkRouteTo (Ipv4Address ("10.1.2.0"), Ipv4Mask ("/24"), Ipv4Address ("192.168.0.9"), interface, 5);
+  NS_TEST_ASSERT_MSG_EQ (GetGateway ("10.1.2.4"), Ipv4Address ("192.168.0.9"), "New /24 route expected");
+
+  m_routing = 0;
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief IPv4 forwarding table TestSuite
+ */
+static class Ipv4FibTestSuite : public TestSuite
+{
+public:
+  Ipv4FibTestSuite () : TestSuite ("ipv4-fib", UNIT)
+  {
+    AddTestCase (new Ipv4FibLookupTestCase, TestCase::QUICK);
+    AddTestCase (new Ipv4StaticRoutingFibTestCase, TestCase::QUICK);
+  }
+} g_ipv4FibTestSuite;
@@ -15,6 +15,7 @@
  */
 
 #include <vector>
+#include <sstream>
 #include "ns3/boolean.h"
 #include "ns3/config.h"
 #include "ns3/inet-socket-address.h"
@@ -41,6 +42,7 @@
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/ipv4-routing-table-entry.h"
 #include "ns3/ipv4-global-routing.h"
+#include "ns3/global-router-interface.h"
 #include "ns3/bridge-helper.h"
 
 using namespace ns3;
@@ -1244,6 +1246,278 @@ Ipv4GlobalRoutingSlash32TestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief IPv4 GlobalRouting threads test
+ *
+ * The routes of a grid of routers, with equal-cost paths and a LAN per row,
+ * must not depend on the number of threads computing them.
+ */
+class Ipv4GlobalRoutingThreadsTestCase : public TestCase
+{
+public:
+  Ipv4GlobalRoutingThreadsTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Get the global routes of the nodes
+   * \returns one line per route
+   */
+  std::vector<std::string> GetRoutes (void);
+
+  NodeContainer m_nodes; //!< Nodes used in the test.
+};
+
+Ipv4GlobalRoutingThreadsTestCase::Ipv4GlobalRoutingThreadsTestCase ()
+  : TestCase ("Global routes must not depend on the number of threads")
+{
+}
+
+std::vector<std::string>
+Ipv4GlobalRoutingThreadsTestCase::GetRoutes (void)
+{
+  std::vector<std::string> routes;
+  for (uint32_t n = 0; n < m_nodes.GetN (); n++)
+    {
+      Ptr<Ipv4GlobalRouting> routing =
+        m_nodes.Get (n)->GetObject<Ipv4L3Protocol> ()->GetRoutingProtocol ()->GetObject<Ipv4GlobalRouting> ();
+      for (uint32_t i = 0; i < routing->GetNRoutes (); i++)
+        {
+          std::ostringstream oss;
+          oss << n << ": " << *routing->GetRoute (i);
+          routes.push_back (oss.str ());
+        }
+    }
+  return routes;
+}
+
+void
+Ipv4GlobalRoutingThreadsTestCase::DoRun (void)
+{
+  const uint32_t size = 5;
+  m_nodes.Create (size * size);
+  InternetStackHelper internet;
+  Ipv4GlobalRoutingHelper ipv4RoutingHelper;
+  internet.SetRoutingHelper (ipv4RoutingHelper);
+  internet.Install (m_nodes);
+
+  SimpleNetDeviceHelper p2p;
+  p2p.SetNetDevicePointToPointMode (true);
+  SimpleNetDeviceHelper lan;
+  Ipv4AddressHelper ipv4 ("10.1.0.0", "255.255.255.252");
+  Ipv4AddressHelper lanIpv4 ("10.2.0.0", "255.255.255.0");
+  for (uint32_t r = 0; r < size; r++)
+    {
+      NodeContainer row;
+      for (uint32_t c = 0; c < size; c++)
+        {
+          uint32_t n = r * size + c;
+          row.Add (m_nodes.Get (n));
+          if (c + 1 < size)
+            {
+              ipv4.Assign (p2p.Install (NodeContainer (m_nodes.Get (n), m_nodes.Get (n + 1))));
+              ipv4.NewNetwork ();
+            }
+          if (r + 1 < size)
+            {
+              ipv4.Assign (p2p.Install (NodeContainer (m_nodes.Get (n), m_nodes.Get (n + size))));
+              ipv4.NewNetwork ();
+            }
+        }
+      if (r % 2 == 0)
+        {
+          lanIpv4.Assign (lan.Install (row));
+          lanIpv4.NewNetwork ();
+        }
+    }
+
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+  std::vector<std::string> expected = GetRoutes ();
+  NS_TEST_ASSERT_MSG_GT (expected.size (), m_nodes.GetN (), "Too few routes computed");
+
+  Config::SetGlobal ("GlobalRoutingThreads", UintegerValue (4));
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+  std::vector<std::string> routes = GetRoutes ();
+  Config::SetGlobal ("GlobalRoutingThreads", UintegerValue (1));
+
+  NS_TEST_ASSERT_MSG_EQ (routes.size (), expected.size (), "Wrong number of routes");
+  for (uint32_t i = 0; i < routes.size (); i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (routes[i], expected[i], "Different route " << i);
+    }
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief IPv4 GlobalRouting incremental SPF test
+ *
+ * A grid of routers with stub hosts and an external route sees its
+ * interfaces go down and up and its metrics change.  The routes recomputed
+ * after each change must be the same whether the SPF trees are updated or
+ * calculated again.
+ *
+ * The grid has many equal-cost paths.  With a LAN per other row, the
+ * metrics are random instead, since the SPF does not support a LAN reached
+ * through equal-cost paths.
+ */
+class Ipv4GlobalRoutingIncrementalTestCase : public TestCase
+{
+public:
+  Ipv4GlobalRoutingIncrementalTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Build the topology, change it and recompute the routes after
+   * each change
+   * \param incremental whether the SPF trees are kept and updated
+   * \param lans whether to add the LANs, with random metrics
+   * \returns the routes of the nodes after each change, one line per route
+   */
+  std::vector<std::vector<std::string> > RunChanges (bool incremental, bool lans);
+
+  uint32_t m_random; //!< State of the random metrics
+};
+
+Ipv4GlobalRoutingIncrementalTestCase::Ipv4GlobalRoutingIncrementalTestCase ()
+  : TestCase ("Updated SPF trees must give the routes of recalculated ones")
+{
+}
+
+std::vector<std::vector<std::string> >
+Ipv4GlobalRoutingIncrementalTestCase::RunChanges (bool incremental, bool lans)
+{
+  Config::SetGlobal ("GlobalRoutingIncrementalSpf", BooleanValue (incremental));
+  m_random = 12345;
+  const uint32_t size = 5;
+  NodeContainer routers;
+  routers.Create (size * size);
+  NodeContainer hosts;
+  hosts.Create (2);
+  NodeContainer nodes (routers, hosts);
+  InternetStackHelper internet;
+  Ipv4GlobalRoutingHelper ipv4RoutingHelper;
+  internet.SetRoutingHelper (ipv4RoutingHelper);
+  internet.Install (nodes);
+
+  SimpleNetDeviceHelper p2p;
+  p2p.SetNetDevicePointToPointMode (true);
+  SimpleNetDeviceHelper lan;
+  Ipv4AddressHelper ipv4 ("10.1.0.0", "255.255.255.252");
+  Ipv4AddressHelper lanIpv4 ("10.2.0.0", "255.255.255.0");
+  NetDeviceContainer p2pDevices;
+  NetDeviceContainer devices;
+  for (uint32_t r = 0; r < size; r++)
+    {
+      NodeContainer row;
+      for (uint32_t c = 0; c < size; c++)
+        {
+          uint32_t n = r * size + c;
+          row.Add (routers.Get (n));
+          if (c + 1 < size)
+            {
+              p2pDevices.Add (p2p.Install (NodeContainer (routers.Get (n), routers.Get (n + 1))));
+            }
+          if (r + 1 < size)
+            {
+              p2pDevices.Add (p2p.Install (NodeContainer (routers.Get (n), routers.Get (n + size))));
+            }
+        }
+      if (lans && r % 2 == 0)
+        {
+          NetDeviceContainer lanDevices = lan.Install (row);
+          lanIpv4.Assign (lanDevices);
+          lanIpv4.NewNetwork ();
+          devices.Add (lanDevices);
+        }
+    }
+  p2pDevices.Add (p2p.Install (NodeContainer (routers.Get (0), hosts.Get (0))));
+  p2pDevices.Add (p2p.Install (NodeContainer (routers.Get (size * size - 1), hosts.Get (1))));
+  for (uint32_t i = 0; i < p2pDevices.GetN (); i += 2)
+    {
+      ipv4.Assign (NetDeviceContainer (p2pDevices.Get (i), p2pDevices.Get (i + 1)));
+      ipv4.NewNetwork ();
+    }
+  devices.Add (p2pDevices);
+  for (uint32_t d = 0; lans && d < devices.GetN (); d++)
+    {
+      Ptr<Ipv4> ipv4 = devices.Get (d)->GetNode ()->GetObject<Ipv4> ();
+      m_random = m_random * 1103515245 + 12345;
+      ipv4->SetMetric (ipv4->GetInterfaceForDevice (devices.Get (d)), 1 + (m_random >> 16) % 1000);
+    }
+  routers.Get (size * size / 2)->GetObject<GlobalRouter> ()->InjectRoute ("192.168.0.0", "255.255.0.0");
+
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+  std::vector<std::vector<std::string> > routes;
+  for (uint32_t step = 0; step < 60; step++)
+    {
+      uint32_t d = (7 * step + 3) % devices.GetN ();
+      Ptr<NetDevice> device = devices.Get (d);
+      Ptr<Ipv4> ipv4 = device->GetNode ()->GetObject<Ipv4> ();
+      uint32_t interface = ipv4->GetInterfaceForDevice (device);
+      if (step % 4 == 3)
+        {
+          m_random = m_random * 1103515245 + 12345;
+          ipv4->SetMetric (interface, lans ? 1 + (m_random >> 16) % 1000 : 1 + step % 3);
+        }
+      else if (ipv4->IsUp (interface))
+        {
+          ipv4->SetDown (interface);
+        }
+      else
+        {
+          ipv4->SetUp (interface);
+        }
+      Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+      routes.push_back (std::vector<std::string> ());
+      for (uint32_t n = 0; n < nodes.GetN (); n++)
+        {
+          Ptr<Ipv4GlobalRouting> routing =
+            nodes.Get (n)->GetObject<Ipv4L3Protocol> ()->GetRoutingProtocol ()->GetObject<Ipv4GlobalRouting> ();
+          for (uint32_t i = 0; i < routing->GetNRoutes (); i++)
+            {
+              std::ostringstream oss;
+              oss << n << ": " << *routing->GetRoute (i);
+              routes.back ().push_back (oss.str ());
+            }
+        }
+    }
+
+  Simulator::Destroy ();
+  Config::SetGlobal ("GlobalRoutingIncrementalSpf", BooleanValue (false));
+  return routes;
+}
+
+void
+Ipv4GlobalRoutingIncrementalTestCase::DoRun (void)
+{
+  for (int lans = 0; lans < 2; lans++)
+    {
+      std::vector<std::vector<std::string> > expected = RunChanges (false, lans);
+      std::vector<std::vector<std::string> > routes = RunChanges (true, lans);
+      NS_TEST_ASSERT_MSG_EQ (routes.size (), expected.size (), "Wrong number of steps");
+      for (uint32_t step = 0; step < routes.size (); step++)
+        {
+          NS_TEST_ASSERT_MSG_EQ (routes[step].size (), expected[step].size (),
+                                 "Wrong number of routes after change " << step << " (LANs " << lans << ")");
+          for (uint32_t i = 0; i < routes[step].size () && i < expected[step].size (); i++)
+            {
+              NS_TEST_ASSERT_MSG_EQ (routes[step][i], expected[step][i],
+                                     "Different route " << i << " after change " << step << " (LANs " << lans << ")");
+            }
+        }
+    }
+}
+
 /**
  * \ingroup internet-test
  * \ingroup tests
@@ -1267,6 +1541,8 @@ Ipv4GlobalRoutingTestSuite::Ipv4GlobalRoutingTestSuite ()
     AddTestCase (new TwoBridgeTest, TestCase::QUICK);
     AddTestCase (new Ipv4DynamicGlobalRoutingTestCase, TestCase::QUICK);
     AddTestCase (new Ipv4GlobalRoutingSlash32TestCase, TestCase::QUICK);
+    AddTestCase (new Ipv4GlobalRoutingThreadsTestCase, TestCase::QUICK);
+    AddTestCase (new Ipv4GlobalRoutingIncrementalTestCase, TestCase::QUICK);
   }
 
 static Ipv4GlobalRoutingTestSuite g_globalRoutingTestSuite; //!< Static variable for test initialization
@@ -0,0 +1,221 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/socket.h"
+#include "ns3/udp-socket-factory.h"
+#include "ns3/boolean.h"
+#include "ns3/node.h"
+#include "ns3/inet-socket-address.h"
+
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/ipv4-static-routing.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-routing-helper.h"
+
+#include <limits>
+
+using namespace ns3;
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief IPv4 forwarding route cache Test
+ *
+ * A router forwards the packets sent to an address held by two
+ * receivers, along a static host route to either of them.  The packets
+ * must reach the receiver of the current route, with or without the
+ * route cache of the router, when the route is replaced and when the
+ * forwarding is turned off and on.
+ */
+class Ipv4RouteCacheTest : public TestCase
+{
+public:
+  /**
+   * \brief Constructor.
+   * \param routeCache whether the router caches its forwarding routes
+   */
+  Ipv4RouteCacheTest (bool routeCache);
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Receive data.
+   * \param socket The receiving socket.
+   */
+  void ReceivePkt (Ptr<Socket> socket);
+  /**
+   * \brief Send data.
+   * \param socket The sending socket.
+   */
+  void DoSendData (Ptr<Socket> socket);
+  /**
+   * \brief Send a packet and run the simulation.
+   * \param socket The sending socket.
+   * \return The index of the receiver of the packet, or -1 if none.
+   */
+  int32_t SendData (Ptr<Socket> socket);
+  /**
+   * \brief Add a node with a net device on each of the channels.
+   * \param channels The channels.
+   * \param addresses The addresses of the net devices.
+   * \return The node.
+   */
+  Ptr<Node> AddNode (std::vector<Ptr<SimpleChannel> > channels, std::vector<const char *> addresses);
+
+  bool m_routeCache;          //!< Whether the router caches its routes
+  Ptr<Node> m_receivers[2];   //!< The receivers
+  int32_t m_received;         //!< Index of the receiver of the last packet
+};
+
+Ipv4RouteCacheTest::Ipv4RouteCacheTest (bool routeCache)
+  : TestCase (routeCache ? "IPv4 forwarding with the route cache" : "IPv4 forwarding without the route cache"),
+    m_routeCache (routeCache),
+    m_received (-1)
+{
+}
+
+void
+Ipv4RouteCacheTest::ReceivePkt (Ptr<Socket> socket)
+{
+  socket->Recv (std::numeric_limits<uint32_t>::max (), 0);
+  m_received = socket->GetNode () == m_receivers[0] ? 0 : 1;
+}
+
+void
+Ipv4RouteCacheTest::DoSendData (Ptr<Socket> socket)
+{
+  Address realTo = InetSocketAddress (Ipv4Address ("192.168.0.1"), 1234);
+  NS_TEST_EXPECT_MSG_EQ (socket->SendTo (Create<Packet> (123), 0, realTo), 123, "100");
+}
+
+int32_t
+Ipv4RouteCacheTest::SendData (Ptr<Socket> socket)
+{
+  m_received = -1;
+  Simulator::ScheduleWithContext (socket->GetNode ()->GetId (), Seconds (0),
+                                  &Ipv4RouteCacheTest::DoSendData, this, socket);
+  Simulator::Run ();
+  return m_received;
+}
+
+Ptr<Node>
+Ipv4RouteCacheTest::AddNode (std::vector<Ptr<SimpleChannel> > channels, std::vector<const char *> addresses)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  InternetStackHelper internet;
+  internet.SetIpv6StackInstall (false);
+  internet.Install (node);
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  for (uint32_t i = 0; i < channels.size (); i++)
+    {
+      Ptr<SimpleNetDevice> dev = CreateObject<SimpleNetDevice> ();
+      dev->SetAddress (Mac48Address::ConvertFrom (Mac48Address::Allocate ()));
+      dev->SetChannel (channels[i]);
+      node->AddDevice (dev);
+      uint32_t netdev_idx = ipv4->AddInterface (dev);
+      ipv4->AddAddress (netdev_idx, Ipv4InterfaceAddress (Ipv4Address (addresses[i]), Ipv4Mask (0xffff0000U)));
+      ipv4->SetUp (netdev_idx);
+    }
+  return node;
+}
+
+void
+Ipv4RouteCacheTest::DoRun (void)
+{
+  // tx -- router -- receiver 0
+  //          |
+  //          +---- receiver 1
+  std::vector<Ptr<SimpleChannel> > channels;
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      channels.push_back (CreateObject<SimpleChannel> ());
+    }
+  std::vector<const char *> addresses;
+  addresses.push_back ("10.1.0.2");
+  Ptr<Node> txNode = AddNode (std::vector<Ptr<SimpleChannel> > (1, channels[0]), addresses);
+  addresses[0] = "10.1.0.1";
+  addresses.push_back ("10.0.0.1");
+  addresses.push_back ("10.2.0.1");
+  Ptr<Node> router = AddNode (channels, addresses);
+  router->GetObject<Ipv4L3Protocol> ()->SetAttribute ("RouteCache", BooleanValue (m_routeCache));
+  addresses.resize (1);
+  for (uint32_t r = 0; r < 2; r++)
+    {
+      addresses[0] = r == 0 ? "10.0.0.2" : "10.2.0.2";
+      m_receivers[r] = AddNode (std::vector<Ptr<SimpleChannel> > (1, channels[r + 1]), addresses);
+      Ptr<Ipv4> ipv4 = m_receivers[r]->GetObject<Ipv4> ();
+      ipv4->AddAddress (1, Ipv4InterfaceAddress (Ipv4Address ("192.168.0.1"), Ipv4Mask::GetOnes ()));
+      Ptr<Socket> rxSocket = m_receivers[r]->GetObject<UdpSocketFactory> ()->CreateSocket ();
+      NS_TEST_EXPECT_MSG_EQ (rxSocket->Bind (InetSocketAddress (Ipv4Address::GetAny (), 1234)), 0, "trivial");
+      rxSocket->SetRecvCallback (MakeCallback (&Ipv4RouteCacheTest::ReceivePkt, this));
+    }
+
+  Ipv4RoutingHelper::GetRouting<Ipv4StaticRouting> (txNode->GetObject<Ipv4> ()->GetRoutingProtocol ())
+    ->SetDefaultRoute (Ipv4Address ("10.1.0.1"), 1);
+  Ptr<Ipv4StaticRouting> routing =
+    Ipv4RoutingHelper::GetRouting<Ipv4StaticRouting> (router->GetObject<Ipv4> ()->GetRoutingProtocol ());
+  routing->AddHostRouteTo (Ipv4Address ("192.168.0.1"), Ipv4Address ("10.0.0.2"), 2);
+
+  Ptr<Socket> txSocket = txNode->GetObject<UdpSocketFactory> ()->CreateSocket ();
+
+  NS_TEST_EXPECT_MSG_EQ (SendData (txSocket), 0, "First packet");
+  NS_TEST_EXPECT_MSG_EQ (SendData (txSocket), 0, "Second packet, along the same route");
+
+  // Replace the route: a cached route must not outlive it
+  routing->RemoveRoute (routing->GetNRoutes () - 1);
+  routing->AddHostRouteTo (Ipv4Address ("192.168.0.1"), Ipv4Address ("10.2.0.2"), 3);
+  NS_TEST_EXPECT_MSG_EQ (SendData (txSocket), 1, "Packet along the new route");
+  NS_TEST_EXPECT_MSG_EQ (SendData (txSocket), 1, "Packet along the new route again");
+
+  Ptr<Ipv4> ipv4 = router->GetObject<Ipv4> ();
+  ipv4->SetAttribute ("IpForward", BooleanValue (false));
+  NS_TEST_EXPECT_MSG_EQ (SendData (txSocket), -1, "IPv4 Forwarding off");
+  ipv4->SetAttribute ("IpForward", BooleanValue (true));
+  NS_TEST_EXPECT_MSG_EQ (SendData (txSocket), 1, "IPv4 Forwarding on again");
+
+  // No route at all
+  routing->RemoveRoute (routing->GetNRoutes () - 1);
+  NS_TEST_EXPECT_MSG_EQ (SendData (txSocket), -1, "No route");
+
+  Simulator::Destroy ();
+}
+
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief IPv4 forwarding route cache TestSuite
+ */
+class Ipv4RouteCacheTestSuite : public TestSuite
+{
+public:
+  Ipv4RouteCacheTestSuite ();
+};
+
+Ipv4RouteCacheTestSuite::Ipv4RouteCacheTestSuite ()
+  : TestSuite ("ipv4-route-cache", UNIT)
+{
+  AddTestCase (new Ipv4RouteCacheTest (false), TestCase::QUICK);
+  AddTestCase (new Ipv4RouteCacheTest (true), TestCase::QUICK);
+}
+
+static Ipv4RouteCacheTestSuite g_ipv4RouteCacheTestSuite; //!< Static variable for test initialization
@@ -0,0 +1,237 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/node-container.h"
+#include "ns3/packet.h"
+#include "ns3/socket.h"
+#include "ns3/udp-socket-factory.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv6-address-helper.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/ipv4-interface.h"
+#include "ns3/ipv6-l3-protocol.h"
+#include "ns3/ipv6-interface.h"
+#include "ns3/arp-cache.h"
+#include "ns3/ndisc-cache.h"
+#include "ns3/neighbor-cache-table.h"
+#include "ns3/neighbor-cache-helper.h"
+
+#include <limits>
+#include <map>
+
+using namespace ns3;
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Compare a NeighborCacheTable with a std::map under random
+ * insertions and removals
+ */
+class NeighborCacheTableTestCase : public TestCase
+{
+public:
+  NeighborCacheTableTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+NeighborCacheTableTestCase::NeighborCacheTableTestCase ()
+  : TestCase ("The neighbor cache table must hold the entries added and not removed")
+{
+}
+
+void
+NeighborCacheTableTestCase::DoRun (void)
+{
+  Ptr<UniformRandomVariable> rand = CreateObject<UniformRandomVariable> ();
+  NeighborCacheTable<Ipv4Address, uint32_t, Ipv4AddressHash> table;
+  std::map<Ipv4Address, uint32_t *> reference;
+  // Addresses in a few subnets, so that the probe sequences collide
+  std::vector<uint32_t> values (4000);
+  for (uint32_t i = 0; i < values.size (); i++)
+    {
+      values[i] = i;
+    }
+  for (uint32_t step = 0; step < 20000; step++)
+    {
+      Ipv4Address address (0x0a000000 + rand->GetInteger (0, 3) * 0x10000 + rand->GetInteger (0, 999));
+      uint32_t *entry = &values[rand->GetInteger (0, values.size () - 1)];
+      bool present = reference.find (address) != reference.end ();
+      NS_TEST_ASSERT_MSG_EQ (table.Find (address), present ? reference[address] : 0, "Wrong entry found");
+      if (present && rand->GetValue () < 0.6)
+        {
+          NS_TEST_ASSERT_MSG_EQ (table.Erase (address), reference[address], "Wrong entry removed");
+          reference.erase (address);
+        }
+      else if (!present)
+        {
+          table.Insert (address, entry);
+          reference[address] = entry;
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ (table.size (), reference.size (), "Wrong number of entries");
+  uint32_t n = 0;
+  for (NeighborCacheTable<Ipv4Address, uint32_t, Ipv4AddressHash>::Iterator i = table.begin ();
+       i != table.end (); i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (i->entry, reference[i->address], "Wrong entry iterated");
+      n++;
+    }
+  NS_TEST_ASSERT_MSG_EQ (n, reference.size (), "Wrong number of entries iterated");
+  table.Clear ();
+  NS_TEST_ASSERT_MSG_EQ (table.Find (reference.begin ()->first), 0, "Entry found after a clear");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check the caches filled by the NeighborCacheHelper, and that a
+ * first packet is sent without address resolution
+ */
+class NeighborCacheHelperTestCase : public TestCase
+{
+public:
+  NeighborCacheHelperTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * \brief Receive data.
+   * \param socket The receiving socket.
+   */
+  void ReceivePkt (Ptr<Socket> socket);
+  /**
+   * \brief Send data.
+   * \param socket The sending socket.
+   * \param to Destination address.
+   */
+  void SendPkt (Ptr<Socket> socket, Ipv4Address to);
+
+  Time m_received; //!< Time of reception of the packet
+};
+
+NeighborCacheHelperTestCase::NeighborCacheHelperTestCase ()
+  : TestCase ("The neighbor cache helper must add permanent entries for the neighbors")
+{
+}
+
+void
+NeighborCacheHelperTestCase::ReceivePkt (Ptr<Socket> socket)
+{
+  socket->Recv (std::numeric_limits<uint32_t>::max (), 0);
+  m_received = Simulator::Now ();
+}
+
+void
+NeighborCacheHelperTestCase::SendPkt (Ptr<Socket> socket, Ipv4Address to)
+{
+  NS_TEST_EXPECT_MSG_EQ (socket->SendTo (Create<Packet> (100), 0, InetSocketAddress (to, 1234)), 100, "Send failed");
+}
+
+void
+NeighborCacheHelperTestCase::DoRun (void)
+{
+  NodeContainer nodes;
+  nodes.Create (3);
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  SimpleNetDeviceHelper lan;
+  NetDeviceContainer devices = lan.Install (nodes);
+  Ipv4AddressHelper ipv4Address ("10.1.1.0", "255.255.255.0");
+  Ipv4InterfaceContainer ipv4Interfaces = ipv4Address.Assign (devices);
+  Ipv6AddressHelper ipv6Address (Ipv6Address ("2001:1::"), Ipv6Prefix (64));
+  ipv6Address.Assign (devices);
+
+  NeighborCacheHelper::PopulateNeighborCache ();
+
+  for (uint32_t n = 0; n < nodes.GetN (); n++)
+    {
+      Ptr<Ipv4L3Protocol> ipv4 = nodes.Get (n)->GetObject<Ipv4L3Protocol> ();
+      Ptr<ArpCache> arpCache = ipv4->GetInterface (1)->GetArpCache ();
+      Ptr<Ipv6L3Protocol> ipv6 = nodes.Get (n)->GetObject<Ipv6L3Protocol> ();
+      Ptr<NdiscCache> ndiscCache = ipv6->GetInterface (1)->GetNdiscCache ();
+      for (uint32_t m = 0; m < nodes.GetN (); m++)
+        {
+          ArpCache::Entry *arpEntry = arpCache->Lookup (ipv4Interfaces.GetAddress (m));
+          Ptr<Ipv6Interface> neighbor = nodes.Get (m)->GetObject<Ipv6L3Protocol> ()->GetInterface (1);
+          NS_TEST_ASSERT_MSG_EQ (neighbor->GetNAddresses (), 2, "Expected a link-local and a global address");
+          for (uint32_t j = 0; j < neighbor->GetNAddresses (); j++)
+            {
+              NdiscCache::Entry *ndiscEntry = ndiscCache->Lookup (neighbor->GetAddress (j).GetAddress ());
+              if (m == n)
+                {
+                  NS_TEST_ASSERT_MSG_EQ (ndiscEntry, 0, "A node must not be its own neighbor");
+                }
+              else
+                {
+                  NS_TEST_ASSERT_MSG_NE (ndiscEntry, 0, "Missing NDISC entry");
+                  NS_TEST_ASSERT_MSG_EQ (ndiscEntry->IsPermanent (), true, "NDISC entry not permanent");
+                  NS_TEST_ASSERT_MSG_EQ (ndiscEntry->GetMacAddress (), devices.Get (m)->GetAddress (), "Wrong NDISC entry");
+                }
+            }
+          if (m == n)
+            {
+              NS_TEST_ASSERT_MSG_EQ (arpEntry, 0, "A node must not be its own neighbor");
+              continue;
+            }
+          NS_TEST_ASSERT_MSG_NE (arpEntry, 0, "Missing ARP entry");
+          NS_TEST_ASSERT_MSG_EQ (arpEntry->IsPermanent (), true, "ARP entry not permanent");
+          NS_TEST_ASSERT_MSG_EQ (arpEntry->GetMacAddress (), devices.Get (m)->GetAddress (), "Wrong ARP entry");
+        }
+    }
+
+  // Without an ARP exchange, the packet arrives when it is sent
+  Ptr<Socket> rxSocket = Socket::CreateSocket (nodes.Get (1), UdpSocketFactory::GetTypeId ());
+  rxSocket->Bind (InetSocketAddress (Ipv4Address::GetAny (), 1234));
+  rxSocket->SetRecvCallback (MakeCallback (&NeighborCacheHelperTestCase::ReceivePkt, this));
+  Ptr<Socket> txSocket = Socket::CreateSocket (nodes.Get (0), UdpSocketFactory::GetTypeId ());
+  Simulator::Schedule (Seconds (1), &NeighborCacheHelperTestCase::SendPkt, this, txSocket,
+                       ipv4Interfaces.GetAddress (1));
+  m_received = Seconds (0);
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_received, Seconds (1), "The packet was delayed by address resolution");
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Neighbor cache TestSuite
+ */
+class NeighborCacheTestSuite : public TestSuite
+{
+public:
+  NeighborCacheTestSuite ();
+};
+
+NeighborCacheTestSuite::NeighborCacheTestSuite ()
+  : TestSuite ("neighbor-cache", UNIT)
+{
+  AddTestCase (new NeighborCacheTableTestCase, TestCase::QUICK);
+  AddTestCase (new NeighborCacheHelperTestCase, TestCase::QUICK);
+}
+
+static NeighborCacheTestSuite g_neighborCacheTestSuite; //!< Static variable for test initialization
@@ -0,0 +1,204 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/mac48-address.h"
+#include "ns3/tcp-header.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/ipv4-queue-disc-item.h"
+#include "ns3/ipv4-packet-filter.h"
+#include "ns3/fq-codel-queue-disc.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Create an IPv4 queue disc item carrying a TCP segment
+ * \param src the source address
+ * \param dst the destination address
+ * \param srcPort the source port
+ * \param dstPort the destination port
+ * \return the item
+ */
+static Ptr<Ipv4QueueDiscItem>
+CreateTcpItem (const char *src, const char *dst, uint16_t srcPort, uint16_t dstPort)
+{
+  Ptr<Packet> p = Create<Packet> (100);
+  TcpHeader tcpHdr;
+  tcpHdr.SetSourcePort (srcPort);
+  tcpHdr.SetDestinationPort (dstPort);
+  p->AddHeader (tcpHdr);
+
+  Ipv4Header ipHdr;
+  ipHdr.SetSource (Ipv4Address (src));
+  ipHdr.SetDestination (Ipv4Address (dst));
+  ipHdr.SetProtocol (6);
+  ipHdr.SetPayloadSize (p->GetSize ());
+  return Create<Ipv4QueueDiscItem> (p, Mac48Address (), 0x0800, ipHdr);
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check that the flow hash is computed once and travels with the packet
+ */
+class Ipv4FlowHashTestCase : public TestCase
+{
+public:
+  Ipv4FlowHashTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+Ipv4FlowHashTestCase::Ipv4FlowHashTestCase ()
+  : TestCase ("Check the flow hash of IPv4 queue disc items")
+{
+}
+
+void
+Ipv4FlowHashTestCase::DoRun (void)
+{
+  Ptr<Ipv4QueueDiscItem> item = CreateTcpItem ("10.0.0.1", "10.0.0.2", 49153, 80);
+  NS_TEST_EXPECT_MSG_EQ (item->GetPacket ()->GetFlowHash (), 0, "No flow hash should be set yet");
+
+  uint32_t hash = item->GetFlowHash ();
+  NS_TEST_EXPECT_MSG_NE (hash, 0, "The flow hash must be computed");
+  NS_TEST_EXPECT_MSG_EQ (item->GetPacket ()->GetFlowHash (), hash, "The flow hash must be stored in the packet");
+  NS_TEST_EXPECT_MSG_EQ (item->GetPacket ()->Copy ()->GetFlowHash (), hash, "Copies must keep the flow hash");
+  NS_TEST_EXPECT_MSG_EQ (item->GetPacket ()->CreateFragment (0, 10)->GetFlowHash (), hash,
+                         "Fragments must keep the flow hash");
+
+  NS_TEST_EXPECT_MSG_EQ (CreateTcpItem ("10.0.0.1", "10.0.0.2", 49153, 80)->GetFlowHash (), hash,
+                         "Packets of the same flow must have the same flow hash");
+  NS_TEST_EXPECT_MSG_NE (CreateTcpItem ("10.0.0.1", "10.0.0.2", 49154, 80)->GetFlowHash (), hash,
+                         "Packets of different flows should have different flow hashes");
+
+  // once set, the flow hash is not computed again, e.g., at the next hop
+  Ptr<Packet> p = item->GetPacket ()->Copy ();
+  p->SetFlowHash (12345);
+  Ptr<Ipv4QueueDiscItem> next = Create<Ipv4QueueDiscItem> (p, Mac48Address (), 0x0800, item->GetHeader ());
+  NS_TEST_EXPECT_MSG_EQ (next->GetFlowHash (), 12345, "The flow hash of the packet must be used");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief A flow based filter counting how many times it is run
+ */
+class CountingIpv4PacketFilter : public Ipv4PacketFilter
+{
+public:
+  /**
+   * Constructor
+   * \param flowBased whether the filter declares itself flow based
+   */
+  CountingIpv4PacketFilter (bool flowBased)
+    : m_flowBased (flowBased),
+      m_count (0)
+  {
+  }
+  virtual bool IsFlowBased (void) const
+  {
+    return m_flowBased;
+  }
+  /// \return the number of packets classified by the filter
+  uint32_t GetCount (void) const
+  {
+    return m_count;
+  }
+private:
+  virtual int32_t DoClassify (Ptr<QueueDiscItem> item) const
+  {
+    m_count++;
+    return item->GetFlowHash () & 0x7fffffff;
+  }
+  bool m_flowBased;         //!< whether the filter is flow based
+  mutable uint32_t m_count; //!< number of classified packets
+};
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check that queue discs cache the results of flow based filters
+ */
+class ClassifierCacheTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor
+   * \param flowBased whether the filter declares itself flow based
+   */
+  ClassifierCacheTestCase (bool flowBased);
+private:
+  virtual void DoRun (void);
+  bool m_flowBased; //!< whether the filter declares itself flow based
+};
+
+ClassifierCacheTestCase::ClassifierCacheTestCase (bool flowBased)
+  : TestCase (flowBased ? "Check the classifier cache with flow based filters"
+                        : "Check that results of other filters are not cached"),
+    m_flowBased (flowBased)
+{
+}
+
+void
+ClassifierCacheTestCase::DoRun (void)
+{
+  Ptr<FqCoDelQueueDisc> qdisc = CreateObject<FqCoDelQueueDisc> ();
+  qdisc->SetQuantum (1500);
+  Ptr<CountingIpv4PacketFilter> filter = CreateObject<CountingIpv4PacketFilter> (m_flowBased);
+  qdisc->AddPacketFilter (filter);
+  qdisc->Initialize ();
+
+  int32_t first = qdisc->Classify (CreateTcpItem ("10.0.0.1", "10.0.0.2", 49153, 80));
+  int32_t second = qdisc->Classify (CreateTcpItem ("10.0.0.1", "10.0.0.2", 49154, 80));
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (qdisc->Classify (CreateTcpItem ("10.0.0.1", "10.0.0.2", 49153, 80)), first,
+                             "Packets of the same flow must be classified in the same way");
+      NS_TEST_EXPECT_MSG_EQ (qdisc->Classify (CreateTcpItem ("10.0.0.1", "10.0.0.2", 49154, 80)), second,
+                             "Packets of the same flow must be classified in the same way");
+    }
+  NS_TEST_EXPECT_MSG_EQ (filter->GetCount (), (m_flowBased ? 2 : 10), "Unexpected number of filter runs");
+
+  qdisc->Dispose ();
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Flow hash and classifier cache TestSuite
+ */
+class QueueDiscFlowHashTestSuite : public TestSuite
+{
+public:
+  QueueDiscFlowHashTestSuite ()
+    : TestSuite ("queue-disc-flow-hash", UNIT)
+  {
+    AddTestCase (new Ipv4FlowHashTestCase (), TestCase::QUICK);
+    AddTestCase (new ClassifierCacheTestCase (true), TestCase::QUICK);
+    AddTestCase (new ClassifierCacheTestCase (false), TestCase::QUICK);
+  }
+};
+
+static QueueDiscFlowHashTestSuite g_queueDiscFlowHashTestSuite; //!< Static variable for test initialization
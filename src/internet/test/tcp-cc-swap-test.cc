@@ -0,0 +1,218 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/tcp-congestion-ops.h"
+#include "ns3/tcp-cubic.h"
+#include "ns3/tcp-bbr.h"
+#include "tcp-general-test.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TcpCcSwapTestSuite");
+
+/**
+ * \brief A NewReno counting its PktsAcked calls, without declaring hooks
+ */
+class TcpCountingNewReno : public TcpNewReno
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  TcpCountingNewReno () : m_pktsAcked (0)
+  {
+  }
+
+  virtual void PktsAcked (Ptr<TcpSocketState> tcb, uint32_t segmentsAcked,
+                          const Time& rtt)
+  {
+    m_pktsAcked++;
+  }
+
+  uint32_t m_pktsAcked; //!< Number of PktsAcked calls
+};
+
+TypeId
+TcpCountingNewReno::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TcpCountingNewReno")
+    .SetParent<TcpNewReno> ()
+    .AddConstructor<TcpCountingNewReno> ()
+    .SetGroupName ("Internet")
+  ;
+  return tid;
+}
+
+/**
+ * \brief Check the hooks declared by the congestion controls
+ */
+class TcpCcHooksTest : public TestCase
+{
+public:
+  TcpCcHooksTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+TcpCcHooksTest::TcpCcHooksTest ()
+  : TestCase ("The congestion controls must declare the hooks they implement")
+{
+}
+
+void
+TcpCcHooksTest::DoRun (void)
+{
+  NS_TEST_ASSERT_MSG_EQ (CreateObject<TcpNewReno> ()->GetHooks (),
+                         static_cast<uint32_t> (TcpCongestionOps::HOOK_INCREASE_WINDOW),
+                         "NewReno only increases the window");
+  NS_TEST_ASSERT_MSG_EQ (CreateObject<TcpCubic> ()->GetHooks (),
+                         static_cast<uint32_t> (TcpCongestionOps::HOOK_INCREASE_WINDOW | TcpCongestionOps::HOOK_PKTS_ACKED),
+                         "Cubic increases the window and counts the ACKs");
+  NS_TEST_ASSERT_MSG_EQ (CreateObject<TcpBbr> ()->GetHooks (),
+                         static_cast<uint32_t> (TcpCongestionOps::HOOK_CONGESTION_STATE_SET | TcpCongestionOps::HOOK_CWND_EVENT),
+                         "BBR follows the states and the window events");
+  NS_TEST_ASSERT_MSG_EQ (CreateObject<TcpCountingNewReno> ()->GetHooks (),
+                         static_cast<uint32_t> (TcpCongestionOps::HOOK_ALL),
+                         "A subclass declaring no hooks must get all the hooks");
+}
+
+/**
+ * \brief Swap the congestion control of a connected sender
+ */
+class TcpCcSwapTest : public TcpGeneralTest
+{
+public:
+  /**
+   * \brief Constructor
+   * \param from the congestion control before the swap
+   * \param to the congestion control after the swap
+   * \param desc the test description
+   */
+  TcpCcSwapTest (TypeId from, TypeId to, const std::string &desc);
+
+protected:
+  virtual Ptr<TcpSocketMsgBase> CreateSenderSocket (Ptr<Node> node);
+  virtual void ConfigureEnvironment ();
+  virtual void CWndTrace (uint32_t oldValue, uint32_t newValue);
+  virtual void NormalClose (SocketWho who);
+  virtual void FinalChecks ();
+
+private:
+  /// Swap the congestion control of the sender
+  void Swap (void);
+
+  TypeId m_to;                     //!< Congestion control after the swap
+  Ptr<TcpSocketMsgBase> m_sender;  //!< Sender socket
+  Ptr<TcpCongestionOps> m_swapped; //!< Congestion control after the swap
+  uint32_t m_cWndBeforeSwap;       //!< Congestion window at the swap
+  uint32_t m_cWndChanges;          //!< Congestion window changes after the swap
+  bool m_closed;                   //!< Whether the sender closed normally
+};
+
+TcpCcSwapTest::TcpCcSwapTest (TypeId from, TypeId to, const std::string &desc)
+  : TcpGeneralTest (desc),
+    m_to (to),
+    m_cWndBeforeSwap (0),
+    m_cWndChanges (0),
+    m_closed (false)
+{
+  m_congControlTypeId = from;
+}
+
+void
+TcpCcSwapTest::ConfigureEnvironment ()
+{
+  TcpGeneralTest::ConfigureEnvironment ();
+  SetAppPktCount (200);
+  SetPropagationDelay (MilliSeconds (5));
+}
+
+Ptr<TcpSocketMsgBase>
+TcpCcSwapTest::CreateSenderSocket (Ptr<Node> node)
+{
+  m_sender = TcpGeneralTest::CreateSenderSocket (node);
+  Simulator::Schedule (Seconds (10.1), &TcpCcSwapTest::Swap, this);
+  return m_sender;
+}
+
+void
+TcpCcSwapTest::Swap (void)
+{
+  NS_TEST_ASSERT_MSG_GT (GetTcb (SENDER)->m_highTxMark.Get (), SequenceNumber32 (1),
+                         "The swap must happen while data is sent");
+  ObjectFactory factory;
+  factory.SetTypeId (m_to);
+  m_swapped = factory.Create<TcpCongestionOps> ();
+  m_cWndBeforeSwap = GetTcb (SENDER)->m_cWnd;
+  m_sender->SetCongestionControlAlgorithm (m_swapped);
+  NS_TEST_ASSERT_MSG_EQ (GetTcb (SENDER)->m_cWnd.Get (), m_cWndBeforeSwap, "The swap must keep the window");
+}
+
+void
+TcpCcSwapTest::CWndTrace (uint32_t oldValue, uint32_t newValue)
+{
+  if (m_swapped != 0)
+    {
+      m_cWndChanges++;
+    }
+}
+
+void
+TcpCcSwapTest::NormalClose (SocketWho who)
+{
+  if (who == SENDER)
+    {
+      m_closed = true;
+    }
+}
+
+void
+TcpCcSwapTest::FinalChecks ()
+{
+  NS_TEST_ASSERT_MSG_NE (m_swapped, 0, "The congestion control was not swapped");
+  NS_TEST_ASSERT_MSG_EQ (m_sender->GetCongestionControlAlgorithm (), m_swapped,
+                         "The socket must use the new congestion control");
+  NS_TEST_ASSERT_MSG_GT (m_cWndChanges, 0, "The new congestion control must drive the window");
+  NS_TEST_ASSERT_MSG_EQ (m_closed, true, "The transfer must complete after the swap");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Congestion control hooks and swap TestSuite
+ */
+static class TcpCcSwapTestSuite : public TestSuite
+{
+public:
+  TcpCcSwapTestSuite () : TestSuite ("tcp-cc-swap", UNIT)
+  {
+    AddTestCase (new TcpCcHooksTest, TestCase::QUICK);
+    AddTestCase (new TcpCcSwapTest (TcpNewReno::GetTypeId (), TcpBbr::GetTypeId (),
+                                    "Swap from NewReno to BBR on a live connection"), TestCase::QUICK);
+    AddTestCase (new TcpCcSwapTest (TcpBbr::GetTypeId (), TcpCubic::GetTypeId (),
+                                    "Swap from BBR to Cubic on a live connection"), TestCase::QUICK);
+  }
+} g_tcpCcSwapTestSuite;
+
+} // namespace ns3
@@ -0,0 +1,175 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/log.h"
+#include "ns3/tcp-fluid-model.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TcpFluidModelTestSuite");
+
+/**
+ * \brief Check the utilization of a bottleneck by a single flow
+ */
+class TcpFluidModelUtilizationTest : public TestCase
+{
+public:
+  /**
+   * \brief Constructor
+   * \param type the congestion control of the flow
+   * \param name the name of the test
+   */
+  TcpFluidModelUtilizationTest (TcpFluidModel::FlowType_t type, const std::string &name);
+
+private:
+  virtual void DoRun (void);
+  TcpFluidModel::FlowType_t m_type; //!< Congestion control of the flow
+};
+
+TcpFluidModelUtilizationTest::TcpFluidModelUtilizationTest (TcpFluidModel::FlowType_t type,
+                                                            const std::string &name)
+  : TestCase (name),
+    m_type (type)
+{
+}
+
+void
+TcpFluidModelUtilizationTest::DoRun (void)
+{
+  DataRate capacity ("10Mbps");
+  Time duration = Seconds (60);
+
+  Ptr<TcpFluidModel> model = CreateObject<TcpFluidModel> ();
+  // a buffer of one bandwidth-delay product
+  model->AddBottleneck (capacity, 25000);
+  model->AddFlow (0, m_type, MilliSeconds (20), 1000, DataRate ("1Mbps"), 10000);
+  model->Advance (duration);
+
+  double maxBytes = capacity.GetBitRate () / 8.0 * duration.GetSeconds ();
+  NS_TEST_ASSERT_MSG_EQ_TOL (model->GetElapsed (), duration, NanoSeconds (1),
+                             "The model must advance by the requested duration");
+  NS_TEST_ASSERT_MSG_GT (model->GetDelivered (0), 0.85 * maxBytes,
+                         "A single flow must use most of the capacity");
+  NS_TEST_ASSERT_MSG_LT_OR_EQ (model->GetDelivered (0), maxBytes,
+                               "A flow cannot be delivered more than the capacity");
+}
+
+/**
+ * \brief Check the fairness of two flows with the same congestion control and RTT
+ */
+class TcpFluidModelFairnessTest : public TestCase
+{
+public:
+  /**
+   * \brief Constructor
+   * \param type the congestion control of the flows
+   * \param name the name of the test
+   */
+  TcpFluidModelFairnessTest (TcpFluidModel::FlowType_t type, const std::string &name);
+
+private:
+  virtual void DoRun (void);
+  TcpFluidModel::FlowType_t m_type; //!< Congestion control of the flows
+};
+
+TcpFluidModelFairnessTest::TcpFluidModelFairnessTest (TcpFluidModel::FlowType_t type,
+                                                      const std::string &name)
+  : TestCase (name),
+    m_type (type)
+{
+}
+
+void
+TcpFluidModelFairnessTest::DoRun (void)
+{
+  Ptr<TcpFluidModel> model = CreateObject<TcpFluidModel> ();
+  model->AddBottleneck (DataRate ("10Mbps"), 50000);
+  model->AddFlow (0, m_type, MilliSeconds (40), 1000, DataRate ("4Mbps"), 20000);
+  model->AddFlow (0, m_type, MilliSeconds (40), 1000, DataRate ("4Mbps"), 20000);
+  model->Advance (Seconds (30));
+
+  double first = model->GetDelivered (0);
+  double second = model->GetDelivered (1);
+  NS_TEST_ASSERT_MSG_GT (first, 0, "The flows must be delivered data");
+  NS_TEST_ASSERT_MSG_EQ_TOL (second / first, 1, 0.05, "The flows must share the capacity equally");
+}
+
+/**
+ * \brief Check that competing flows are not delivered more than the capacity
+ */
+class TcpFluidModelCapacityTest : public TestCase
+{
+public:
+  TcpFluidModelCapacityTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+TcpFluidModelCapacityTest::TcpFluidModelCapacityTest ()
+  : TestCase ("Competing flows cannot be delivered more than the capacity")
+{
+}
+
+void
+TcpFluidModelCapacityTest::DoRun (void)
+{
+  DataRate capacity ("20Mbps");
+  Time duration = Seconds (20);
+  uint32_t queue = 30000;
+
+  Ptr<TcpFluidModel> model = CreateObject<TcpFluidModel> ();
+  model->AddBottleneck (capacity, 60000, 0.001, queue);
+  model->AddFlow (0, TcpFluidModel::BBR, MilliSeconds (10), 1448, DataRate ("15Mbps"), 20000);
+  model->AddFlow (0, TcpFluidModel::CUBIC, MilliSeconds (50), 1448, DataRate ("5Mbps"), 40000);
+  model->AddFlow (0, TcpFluidModel::RENO, MilliSeconds (100), 536, DataRate ("1Mbps"), 10000);
+
+  double maxBytes = capacity.GetBitRate () / 8.0 * duration.GetSeconds () + queue;
+  for (uint32_t i = 0; i < 20; i++)
+    {
+      model->Advance (duration / 20);
+      uint64_t total = model->GetDelivered (0) + model->GetDelivered (1) + model->GetDelivered (2);
+      NS_TEST_ASSERT_MSG_LT_OR_EQ (total, maxBytes, "The flows cannot be delivered more than the capacity");
+      NS_TEST_ASSERT_MSG_LT_OR_EQ (model->GetQueueSize (0), 60000, "The queue cannot exceed the buffer");
+    }
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      NS_TEST_ASSERT_MSG_GT (model->GetDelivered (i), 0, "All the flows must be delivered data");
+    }
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief TCP fluid model TestSuite
+ */
+static class TcpFluidModelTestSuite : public TestSuite
+{
+public:
+  TcpFluidModelTestSuite () : TestSuite ("tcp-fluid-model", UNIT)
+  {
+    AddTestCase (new TcpFluidModelUtilizationTest (TcpFluidModel::RENO, "A NewReno flow must use most of the capacity"), TestCase::QUICK);
+    AddTestCase (new TcpFluidModelUtilizationTest (TcpFluidModel::CUBIC, "A Cubic flow must use most of the capacity"), TestCase::QUICK);
+    AddTestCase (new TcpFluidModelUtilizationTest (TcpFluidModel::BBR, "A BBR flow must use most of the capacity"), TestCase::QUICK);
+    AddTestCase (new TcpFluidModelFairnessTest (TcpFluidModel::BBR, "Two BBR flows with the same RTT must share equally"), TestCase::QUICK);
+    AddTestCase (new TcpFluidModelFairnessTest (TcpFluidModel::RENO, "Two NewReno flows with the same RTT must share equally"), TestCase::QUICK);
+    AddTestCase (new TcpFluidModelCapacityTest, TestCase::QUICK);
+  }
+} g_tcpFluidModelTestSuite;
+
+} // namespace ns3
@@ -788,7 +788,7 @@ TcpGeneralTest::GetRWnd (SocketWho who)
     }
 }
 
-EventId
+const TcpTimer &
 TcpGeneralTest::GetPersistentEvent (SocketWho who)
 {
   if (who == SENDER)
@@ -1196,7 +1196,7 @@ TcpSocketSmallAcks::SendEmptyPacket (uint8_t flags)
       NS_LOG_LOGIC ("Schedule retransmission timeout at time "
                     << Simulator::Now ().GetSeconds () << " to expire at time "
                     << (Simulator::Now () + m_rto.Get ()).GetSeconds ());
-      m_retxEvent = Simulator::Schedule (m_rto, &TcpSocketSmallAcks::SendEmptyPacket, this, flags);
+      m_retxEvent.Schedule (m_rto, MakeCallback (&TcpSocketSmallAcks::SendEmptyPacket, this).Bind (flags));
     }
 
   // send another ACK if bytes remain
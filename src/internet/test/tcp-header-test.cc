@@ -19,11 +19,16 @@
 
 #define __STDC_LIMIT_MACROS
 #include <stdint.h>
+#include <cstring>
 #include "ns3/test.h"
 #include "ns3/core-module.h"
 #include "ns3/tcp-header.h"
 #include "ns3/buffer.h"
 #include "ns3/tcp-option-rfc793.h"
+#include "ns3/tcp-option-ts.h"
+#include "ns3/packet.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/ipv6-address.h"
 
 using namespace ns3;
 
@@ -421,6 +426,121 @@ TcpHeaderFlagsToString::DoRun (void)
 }
 
 
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief TCP header checksum test.
+ *
+ * The one's complement sum of the pseudo-header and of the serialized
+ * segment, checksum included, must be 0xffff.
+ */
+class TcpHeaderChecksumTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor.
+   * \param name Test description.
+   */
+  TcpHeaderChecksumTestCase (std::string name);
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Sum 16-bit big endian words.
+   * \param buf the data
+   * \param size the data size
+   * \param sum the initial sum
+   * \return the sum, not folded
+   */
+  static uint32_t Sum (const uint8_t *buf, uint32_t size, uint32_t sum);
+
+  /**
+   * \brief Serialize a segment and check its checksum.
+   * \param source the source address
+   * \param destination the destination address
+   * \param pseudo the pseudo-header without the length
+   * \param pseudoSize the size of the pseudo-header
+   */
+  void CheckSegment (const Address &source, const Address &destination,
+                     const uint8_t *pseudo, uint32_t pseudoSize);
+};
+
+TcpHeaderChecksumTestCase::TcpHeaderChecksumTestCase (std::string name)
+  : TestCase (name)
+{
+}
+
+uint32_t
+TcpHeaderChecksumTestCase::Sum (const uint8_t *buf, uint32_t size, uint32_t sum)
+{
+  for (uint32_t i = 0; i < size; i += 2)
+    {
+      sum += (buf[i] << 8) | (i + 1 < size ? buf[i + 1] : 0);
+    }
+  return sum;
+}
+
+void
+TcpHeaderChecksumTestCase::CheckSegment (const Address &source, const Address &destination,
+                                         const uint8_t *pseudo, uint32_t pseudoSize)
+{
+  Ptr<Packet> p = Create<Packet> (101);
+  TcpHeader header;
+  header.SetSourcePort (49153);
+  header.SetDestinationPort (80);
+  header.SetSequenceNumber (SequenceNumber32 (123456));
+  header.SetAckNumber (SequenceNumber32 (654321));
+  header.SetFlags (TcpHeader::ACK);
+  Ptr<TcpOptionTS> ts = CreateObject<TcpOptionTS> ();
+  ts->SetTimestamp (1234);
+  ts->SetEcho (4321);
+  header.AppendOption (ts);
+  header.EnableChecksums ();
+  header.InitializeChecksum (source, destination, 6);
+  p->AddHeader (header);
+
+  uint32_t size = p->GetSize ();
+  uint8_t *buf = new uint8_t[size];
+  p->CopyData (buf, size);
+  uint32_t sum = Sum (pseudo, pseudoSize, size);
+  sum = Sum (buf, size, sum);
+  while (sum >> 16)
+    {
+      sum = (sum & 0xffff) + (sum >> 16);
+    }
+  delete [] buf;
+  NS_TEST_EXPECT_MSG_EQ (sum, 0xffff, "Wrong checksum");
+
+  TcpHeader received;
+  received.EnableChecksums ();
+  received.InitializeChecksum (source, destination, 6);
+  p->RemoveHeader (received);
+  NS_TEST_EXPECT_MSG_EQ (received.IsChecksumOk (), true, "The checksum must be verified");
+}
+
+void
+TcpHeaderChecksumTestCase::DoRun (void)
+{
+  uint8_t pseudo[40];
+  Ipv4Address source4 ("10.1.2.3");
+  Ipv4Address destination4 ("192.168.17.254");
+  source4.Serialize (pseudo);
+  destination4.Serialize (pseudo + 4);
+  pseudo[8] = 0;
+  pseudo[9] = 6;
+  CheckSegment (source4, destination4, pseudo, 10);
+
+  Ipv6Address source6 ("2001:db8::1:2");
+  Ipv6Address destination6 ("fe80::ffff:1234");
+  source6.Serialize (pseudo);
+  destination6.Serialize (pseudo + 16);
+  std::memset (pseudo + 32, 0, 7);
+  pseudo[39] = 6;
+  CheckSegment (source6, destination6, pseudo, 40);
+}
+
 /**
  * \ingroup internet-test
  * \ingroup tests
@@ -436,6 +556,7 @@ public:
     AddTestCase (new TcpHeaderGetSetTestCase ("GetSet test cases"), TestCase::QUICK);
     AddTestCase (new TcpHeaderWithRFC793OptionTestCase ("Test for options in RFC 793"), TestCase::QUICK);
     AddTestCase (new TcpHeaderFlagsToString ("Test flags to string function"), TestCase::QUICK);
+    AddTestCase (new TcpHeaderChecksumTestCase ("Test the checksum of IPv4 and IPv6 segments"), TestCase::QUICK);
   }
 
 };
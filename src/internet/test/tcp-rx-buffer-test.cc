@@ -15,6 +15,7 @@
  *
  */
 
+#include <cstring>
 #include "ns3/test.h"
 #include "ns3/packet.h"
 #include "ns3/log.h"
@@ -44,6 +45,11 @@ private:
    * \brief Test the SACK list update.
    */
   void TestUpdateSACKList ();
+
+  /**
+   * \brief Test the reassembly and the extraction of out-of-order data.
+   */
+  void TestReassembly ();
 };
 
 TcpRxBufferTestCase::TcpRxBufferTestCase ()
@@ -55,6 +61,7 @@ void
 TcpRxBufferTestCase::DoRun ()
 {
   TestUpdateSACKList ();
+  TestReassembly ();
 }
 
 void
@@ -338,6 +345,81 @@ TcpRxBufferTestCase::TestUpdateSACKList ()
                          "SACK list should contain no element");
 }
 
+void
+TcpRxBufferTestCase::TestReassembly ()
+{
+  uint8_t data[1000];
+  for (uint32_t i = 0; i < 1000; ++i)
+    {
+      data[i] = i % 251;
+    }
+
+  TcpRxBuffer rxBuf;
+  rxBuf.SetNextRxSequence (SequenceNumber32 (1));
+  rxBuf.SetMaxBufferSize (1000);
+  TcpHeader h;
+
+  // Odd segments of 100 bytes first, then one overlapping two of them
+  for (uint32_t i = 1; i < 10; i += 2)
+    {
+      h.SetSequenceNumber (SequenceNumber32 (1 + i * 100));
+      NS_TEST_ASSERT_MSG_EQ (rxBuf.Add (Create<Packet> (data + i * 100, 100), h), true,
+                             "Segment not buffered");
+    }
+  h.SetSequenceNumber (SequenceNumber32 (151));
+  NS_TEST_ASSERT_MSG_EQ (rxBuf.Add (Create<Packet> (data + 150, 200), h), true,
+                         "Segment not buffered");
+  NS_TEST_ASSERT_MSG_EQ (rxBuf.Available (), 0, "No data should be available");
+  NS_TEST_ASSERT_MSG_EQ (rxBuf.Size (), 600, "Only new bytes should be buffered");
+  // only four blocks are kept: [101;201) was dropped from the list
+  NS_TEST_ASSERT_MSG_EQ (rxBuf.GetSackList ().front ().first, SequenceNumber32 (201),
+                         "SACK block different than expected");
+  NS_TEST_ASSERT_MSG_EQ (rxBuf.GetSackList ().front ().second, SequenceNumber32 (401),
+                         "SACK block different than expected");
+
+  // Fill the holes, from the head
+  h.SetSequenceNumber (SequenceNumber32 (1));
+  rxBuf.Add (Create<Packet> (data, 100), h);
+  NS_TEST_ASSERT_MSG_EQ (rxBuf.NextRxSequence (), SequenceNumber32 (401),
+                         "Sequence number differs from expected");
+  h.SetSequenceNumber (SequenceNumber32 (201));
+  NS_TEST_ASSERT_MSG_EQ (rxBuf.Add (Create<Packet> (data + 200, 100), h), false,
+                         "Duplicate segment buffered");
+  for (uint32_t i = 4; i < 10; i += 2)
+    {
+      h.SetSequenceNumber (SequenceNumber32 (1 + i * 100));
+      rxBuf.Add (Create<Packet> (data + i * 100, 100), h);
+      NS_TEST_ASSERT_MSG_EQ (rxBuf.NextRxSequence (), SequenceNumber32 (1 + (i + 2) * 100),
+                             "Sequence number differs from expected");
+    }
+  NS_TEST_ASSERT_MSG_EQ (rxBuf.Available (), 1000, "Every byte should be available");
+  NS_TEST_ASSERT_MSG_EQ (rxBuf.GetSackListSize (), 0, "SACK list should be empty");
+
+  // A partial read, then the rest
+  uint8_t out[1000];
+  Ptr<Packet> p = rxBuf.Extract (150);
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 150, "Extracted a wrong amount of data");
+  NS_TEST_ASSERT_MSG_EQ (rxBuf.MaxRxSequence (), SequenceNumber32 (1151),
+                         "The window should start at the first unread byte");
+  p->CopyData (out, 150);
+  p = rxBuf.Extract (2000);
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 850, "Extracted a wrong amount of data");
+  p->CopyData (out + 150, 850);
+  NS_TEST_ASSERT_MSG_EQ (memcmp (out, data, 1000), 0, "Data corrupted or reordered");
+  NS_TEST_ASSERT_MSG_EQ (rxBuf.Size (), 0, "The buffer should be empty");
+  NS_TEST_ASSERT_MSG_EQ ((rxBuf.Extract (100) == nullptr), true, "Nothing should be extracted");
+
+  // The packet given to Add may still be held, e.g. by the trace sinks
+  Ptr<Packet> held = Create<Packet> (data, 100);
+  h.SetSequenceNumber (SequenceNumber32 (1001));
+  rxBuf.Add (held, h);
+  p = rxBuf.Extract (40);
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 40, "Extracted a wrong amount of data");
+  p = rxBuf.Extract (100);
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 60, "Extracted a wrong amount of data");
+  NS_TEST_ASSERT_MSG_EQ (held->GetSize (), 100, "The received packet was modified");
+}
+
 void
 TcpRxBufferTestCase::DoTeardown ()
 {
@@ -0,0 +1,363 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/boolean.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/tcp-timer-wheel.h"
+#include "tcp-general-test.h"
+#include "tcp-error-model.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TcpTimerWheelTestSuite");
+
+/**
+ * \brief Check that timers in a wheel expire at their exact time and in
+ * order, under random arming and cancelling
+ */
+class TcpTimerWheelExpiryTest : public TestCase
+{
+public:
+  TcpTimerWheelExpiryTest ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Arm or cancel random timers, and schedule the next operations
+   * \param remaining the number of operations left
+   */
+  void Operate (uint32_t remaining);
+
+  /**
+   * \brief Called on the expiry of a timer
+   * \param index the index of the timer
+   */
+  void Expired (uint32_t index);
+
+  /// \return a random delay, from nanoseconds to months
+  Time RandomDelay (void);
+
+  static const uint32_t N_TIMERS = 200; //!< Number of timers
+  Ptr<TcpTimerWheel> m_wheel;          //!< The wheel
+  Ptr<UniformRandomVariable> m_uv;     //!< Random operations
+  TcpTimer m_timers[N_TIMERS];         //!< The timers
+  Time m_deadlines[N_TIMERS];          //!< Expected expiry of the running timers
+  Time m_lastExpiry;                   //!< Time of the last expiry
+  uint32_t m_expired;                  //!< Number of expiries
+};
+
+TcpTimerWheelExpiryTest::TcpTimerWheelExpiryTest ()
+  : TestCase ("Timers in a wheel must expire at their time, in order"),
+    m_expired (0)
+{
+}
+
+Time
+TcpTimerWheelExpiryTest::RandomDelay (void)
+{
+  // 1 ns to 10^15 ns, to fill all the levels and the overflow
+  uint32_t exponent = m_uv->GetInteger (0, 14);
+  int64_t delay = m_uv->GetInteger (1, 10);
+  for (uint32_t i = 0; i < exponent; i++)
+    {
+      delay *= 10;
+    }
+  return NanoSeconds (delay + m_uv->GetInteger (0, 999));
+}
+
+void
+TcpTimerWheelExpiryTest::Operate (uint32_t remaining)
+{
+  for (uint32_t i = 0; i < 20; i++)
+    {
+      uint32_t index = m_uv->GetInteger (0, N_TIMERS - 1);
+      if (m_uv->GetInteger (0, 3) == 0)
+        {
+          m_timers[index].Cancel ();
+        }
+      else
+        {
+          Time delay = RandomDelay ();
+          m_timers[index].Schedule (delay);
+          m_deadlines[index] = Simulator::Now () + delay;
+          NS_TEST_ASSERT_MSG_EQ (m_timers[index].GetDelayLeft (), delay,
+                                 "The delay left of an armed timer is its delay");
+        }
+    }
+  if (remaining > 0)
+    {
+      Simulator::Schedule (RandomDelay (), &TcpTimerWheelExpiryTest::Operate, this, remaining - 1);
+    }
+}
+
+void
+TcpTimerWheelExpiryTest::Expired (uint32_t index)
+{
+  NS_TEST_ASSERT_MSG_EQ (Simulator::Now (), m_deadlines[index], "Timer " << index << " expired at the wrong time");
+  NS_TEST_ASSERT_MSG_GT_OR_EQ (Simulator::Now (), m_lastExpiry, "Timers expired out of order");
+  NS_TEST_ASSERT_MSG_EQ (m_timers[index].IsRunning (), false, "An expired timer is not running");
+  m_lastExpiry = Simulator::Now ();
+  m_expired++;
+
+  // rearm from the expiry, as a retransmission timer does
+  if (m_uv->GetInteger (0, 1) == 0)
+    {
+      Time delay = RandomDelay ();
+      m_timers[index].Schedule (delay);
+      m_deadlines[index] = Simulator::Now () + delay;
+    }
+}
+
+void
+TcpTimerWheelExpiryTest::DoRun (void)
+{
+  m_wheel = CreateObject<TcpTimerWheel> ();
+  m_uv = CreateObject<UniformRandomVariable> ();
+  m_uv->SetStream (1);
+  for (uint32_t i = 0; i < N_TIMERS; i++)
+    {
+      m_timers[i].SetWheel (m_wheel);
+      m_timers[i].SetFunction (MakeCallback (&TcpTimerWheelExpiryTest::Expired, this).Bind (i));
+    }
+
+  Simulator::Schedule (Seconds (1), &TcpTimerWheelExpiryTest::Operate, this, 2000);
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_GT (m_expired, 10000, "Not enough timers expired");
+  NS_TEST_ASSERT_MSG_EQ (m_wheel->GetNTimers (), 0, "All the timers must have expired");
+  Simulator::Destroy ();
+}
+
+/**
+ * \brief Check that rearming a timer of a wheel does not schedule a
+ * simulator event each time
+ */
+class TcpTimerWheelEventsTest : public TestCase
+{
+public:
+  /**
+   * \brief Constructor
+   * \param wheel whether the timer uses a wheel
+   */
+  TcpTimerWheelEventsTest (bool wheel);
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Rearm the timer, as on the reception of an ACK
+   * \param remaining the number of ACKs left
+   */
+  void Ack (uint32_t remaining);
+
+  /// Called on the expiry of the timer
+  void Expired (void);
+
+  bool m_wheelEnabled;     //!< Whether the timer uses a wheel
+  TcpTimer m_timer;        //!< The timer
+  uint32_t m_expired;      //!< Number of expiries
+};
+
+TcpTimerWheelEventsTest::TcpTimerWheelEventsTest (bool wheel)
+  : TestCase (wheel ? "Rearming a timer in a wheel must not schedule events"
+                    : "Rearming a timer without wheel must schedule an event"),
+    m_wheelEnabled (wheel),
+    m_expired (0)
+{
+}
+
+void
+TcpTimerWheelEventsTest::Ack (uint32_t remaining)
+{
+  m_timer.Schedule (MilliSeconds (200));
+  if (remaining > 0)
+    {
+      Simulator::Schedule (MilliSeconds (1), &TcpTimerWheelEventsTest::Ack, this, remaining - 1);
+    }
+}
+
+void
+TcpTimerWheelEventsTest::Expired (void)
+{
+  m_expired++;
+}
+
+void
+TcpTimerWheelEventsTest::DoRun (void)
+{
+  const uint32_t acks = 10000;
+  if (m_wheelEnabled)
+    {
+      m_timer.SetWheel (CreateObject<TcpTimerWheel> ());
+    }
+  m_timer.SetFunction (MakeCallback (&TcpTimerWheelEventsTest::Expired, this));
+
+  uint32_t firstUid = Simulator::Schedule (Seconds (0), &TcpTimerWheelEventsTest::Ack, this, acks - 1).GetUid ();
+  Simulator::Run ();
+  Time end = Simulator::Now ();
+  // ACK events, plus the events of the timer
+  uint32_t timerEvents = Simulator::ScheduleNow (&TcpTimerWheelEventsTest::Expired, this).GetUid () - firstUid - acks;
+  Simulator::Destroy ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_expired, 1, "The timer must expire once");
+  NS_TEST_ASSERT_MSG_EQ (end, MilliSeconds (acks - 1 + 200), "The timer must expire after the last ACK");
+  if (m_wheelEnabled)
+    {
+      // one wake-up of the wheel per timeout at most
+      NS_TEST_ASSERT_MSG_LT_OR_EQ (timerEvents, acks / 200 + 2, "Too many events for the wheel");
+    }
+  else
+    {
+      NS_TEST_ASSERT_MSG_EQ (timerEvents, acks, "Each rearm must schedule an event");
+    }
+}
+
+/**
+ * \brief Check that the TCP timers give the same transmissions in a wheel
+ * and as simulator events, with a lost segment recovered by an RTO
+ */
+class TcpTimerWheelSocketTest : public TcpGeneralTest
+{
+public:
+  /// Time of the transmissions of the sender
+  typedef std::vector<std::pair<Time, SequenceNumber32> > TxTimes;
+
+  /**
+   * \brief Constructor
+   * \param wheel whether the timers use a wheel
+   * \param reference the transmissions without wheel, filled without wheel
+   * and compared with a wheel
+   */
+  TcpTimerWheelSocketTest (bool wheel, TxTimes *reference);
+
+protected:
+  virtual Ptr<TcpSocketMsgBase> CreateSocket (Ptr<Node> node, TypeId socketType,
+                                              TypeId congControl);
+  virtual Ptr<ErrorModel> CreateReceiverErrorModel ();
+  virtual void ConfigureEnvironment ();
+  virtual void Tx (const Ptr<const Packet> p, const TcpHeader&h, SocketWho who);
+  virtual void AfterRTOExpired (const Ptr<const TcpSocketState> tcb, SocketWho who);
+  virtual void FinalChecks ();
+
+private:
+  bool m_wheelEnabled;      //!< Whether the timers use a wheel
+  TxTimes *m_reference;     //!< Transmissions without wheel
+  TxTimes m_txTimes;        //!< Transmissions of this run
+  uint32_t m_rtoExpired;    //!< Number of RTO expiries
+};
+
+TcpTimerWheelSocketTest::TcpTimerWheelSocketTest (bool wheel, TxTimes *reference)
+  : TcpGeneralTest (wheel ? "TCP timers in a wheel must behave as simulator events"
+                          : "Reference run with TCP timers as simulator events"),
+    m_wheelEnabled (wheel),
+    m_reference (reference),
+    m_rtoExpired (0)
+{
+}
+
+void
+TcpTimerWheelSocketTest::ConfigureEnvironment ()
+{
+  TcpGeneralTest::ConfigureEnvironment ();
+  SetAppPktCount (50);
+  SetPropagationDelay (MilliSeconds (7));
+}
+
+Ptr<TcpSocketMsgBase>
+TcpTimerWheelSocketTest::CreateSocket (Ptr<Node> node, TypeId socketType,
+                                       TypeId congControl)
+{
+  node->GetObject<TcpL4Protocol> ()->SetAttribute ("TimerWheel", BooleanValue (m_wheelEnabled));
+  return TcpGeneralTest::CreateSocket (node, socketType, congControl);
+}
+
+Ptr<ErrorModel>
+TcpTimerWheelSocketTest::CreateReceiverErrorModel ()
+{
+  // drop a segment and its first retransmission, to force an RTO
+  Ptr<TcpSeqErrorModel> errorModel = CreateObject<TcpSeqErrorModel> ();
+  errorModel->AddSeqToKill (SequenceNumber32 (5001));
+  errorModel->AddSeqToKill (SequenceNumber32 (5001));
+  return errorModel;
+}
+
+void
+TcpTimerWheelSocketTest::Tx (const Ptr<const Packet> p, const TcpHeader &h, SocketWho who)
+{
+  if (who == SENDER)
+    {
+      m_txTimes.push_back (std::make_pair (Simulator::Now (), h.GetSequenceNumber ()));
+    }
+}
+
+void
+TcpTimerWheelSocketTest::AfterRTOExpired (const Ptr<const TcpSocketState> tcb, SocketWho who)
+{
+  if (who == SENDER)
+    {
+      m_rtoExpired++;
+    }
+}
+
+void
+TcpTimerWheelSocketTest::FinalChecks ()
+{
+  NS_TEST_ASSERT_MSG_GT (m_rtoExpired, 0, "The RTO must expire");
+  NS_TEST_ASSERT_MSG_GT (m_txTimes.size (), 50, "The segments must be sent");
+  if (!m_wheelEnabled)
+    {
+      *m_reference = m_txTimes;
+      return;
+    }
+
+  NS_TEST_ASSERT_MSG_EQ (m_txTimes.size (), m_reference->size (), "The number of transmissions differs");
+  for (uint32_t i = 0; i < m_txTimes.size () && i < m_reference->size (); i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (m_txTimes[i].first, (*m_reference)[i].first,
+                             "Transmission " << i << " at a different time");
+      NS_TEST_ASSERT_MSG_EQ (m_txTimes[i].second, (*m_reference)[i].second,
+                             "Transmission " << i << " of a different segment");
+    }
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief TCP timer wheel TestSuite
+ */
+static class TcpTimerWheelTestSuite : public TestSuite
+{
+public:
+  TcpTimerWheelTestSuite () : TestSuite ("tcp-timer-wheel", UNIT)
+  {
+    AddTestCase (new TcpTimerWheelExpiryTest, TestCase::QUICK);
+    AddTestCase (new TcpTimerWheelEventsTest (false), TestCase::QUICK);
+    AddTestCase (new TcpTimerWheelEventsTest (true), TestCase::QUICK);
+    // the reference run comes first
+    AddTestCase (new TcpTimerWheelSocketTest (false, &m_reference), TestCase::QUICK);
+    AddTestCase (new TcpTimerWheelSocketTest (true, &m_reference), TestCase::QUICK);
+  }
+
+private:
+  TcpTimerWheelSocketTest::TxTimes m_reference; //!< Transmissions without wheel
+} g_tcpTimerWheelTestSuite;
+
+} // namespace ns3
@@ -50,6 +50,8 @@ private:
   void TestTransmittedBlock ();
   /** \brief Test the generation of the "next" block */
   void TestNextSeg ();
+  /** \brief Test the scoreboard with a large window and scattered losses */
+  void TestLargeWindow ();
 };
 
 TcpTxBufferTestCase::TcpTxBufferTestCase ()
@@ -82,6 +84,8 @@ TcpTxBufferTestCase::DoRun ()
                        &TcpTxBufferTestCase::TestTransmittedBlock, this);
   Simulator::Schedule (Seconds (0.0),
                        &TcpTxBufferTestCase::TestNextSeg, this);
+  Simulator::Schedule (Seconds (0.0),
+                       &TcpTxBufferTestCase::TestLargeWindow, this);
 
   Simulator::Run ();
   Simulator::Destroy ();
@@ -268,6 +272,68 @@ TcpTxBufferTestCase::TestNextSeg ()
                          "Data inside the buffer");
 }
 
+void
+TcpTxBufferTestCase::TestLargeWindow ()
+{
+  // 1000 segments in flight, one every 50 is lost and the others are sacked
+  const uint32_t segments = 1000;
+  TcpTxBuffer txBuf;
+  txBuf.SetHeadSequence (SequenceNumber32 (1));
+  txBuf.SetMaxBufferSize (segments * 1000);
+  txBuf.SetSegmentSize (1000);
+  txBuf.SetDupAckThresh (3);
+
+  txBuf.Add (Create<Packet> (segments * 1000));
+  for (uint32_t i = 0; i < segments; ++i)
+    {
+      txBuf.CopyFromSequence (1000, SequenceNumber32 ((i * 1000) + 1));
+    }
+
+  for (uint32_t i = 0; i < segments; ++i)
+    {
+      if (i % 50 != 0)
+        {
+          TcpOptionSack::SackList list;
+          list.push_back (TcpOptionSack::SackBlock (SequenceNumber32 ((i * 1000) + 1),
+                                                    SequenceNumber32 ((i * 1000) + 1001)));
+          txBuf.Update (list);
+        }
+    }
+
+  NS_TEST_ASSERT_MSG_EQ (txBuf.GetSacked (), (segments - 20) * 1000,
+                         "Sacked bytes are miscalculated");
+  NS_TEST_ASSERT_MSG_EQ (txBuf.GetLost (), 20 * 1000,
+                         "Lost bytes are miscalculated");
+  NS_TEST_ASSERT_MSG_EQ (txBuf.BytesInFlight (), 0,
+                         "TxBuf miscalculates size of in flight segments");
+  for (uint32_t i = 0; i < segments; ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (txBuf.IsLost (SequenceNumber32 ((i * 1000) + 1)), (i % 50 == 0),
+                             "Wrong lost status for segment " << i);
+    }
+
+  // The lost segments are returned in order, once each
+  SequenceNumber32 seq;
+  for (uint32_t i = 0; i < 20; ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (txBuf.NextSeg (&seq, true), true,
+                             "No segment returned while lost segments remain");
+      NS_TEST_ASSERT_MSG_EQ (seq, SequenceNumber32 ((i * 50 * 1000) + 1),
+                             "Wrong segment returned for retransmission");
+      txBuf.CopyFromSequence (1000, seq);
+      NS_TEST_ASSERT_MSG_EQ (txBuf.BytesInFlight (), (i + 1) * 1000,
+                             "TxBuf miscalculates size of in flight segments");
+    }
+  NS_TEST_ASSERT_MSG_EQ (txBuf.NextSeg (&seq, true), false,
+                         "Nothing should be left to transmit");
+
+  txBuf.DiscardUpTo (SequenceNumber32 ((segments * 1000) + 1));
+  NS_TEST_ASSERT_MSG_EQ (txBuf.Size (), 0,
+                         "Size is different than expected");
+  NS_TEST_ASSERT_MSG_EQ (txBuf.BytesInFlight (), 0,
+                         "TxBuf miscalculates size of in flight segments");
+}
+
 void
 TcpTxBufferTestCase::TestNewBlock ()
 {
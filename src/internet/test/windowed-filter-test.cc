@@ -0,0 +1,130 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/log.h"
+#include "ns3/data-rate.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/windowed-filter.h"
+#include "ns3/tcp-congestion-ops.h"
+#include "ns3/tcp-tx-buffer.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("WindowedFilterTestSuite");
+
+/**
+ * \brief Check that a max filter of bit rates and a max filter of DataRate
+ * give the same estimates
+ */
+class WindowedFilterIntegerTest : public TestCase
+{
+public:
+  WindowedFilterIntegerTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+WindowedFilterIntegerTest::WindowedFilterIntegerTest ()
+  : TestCase ("An integer max filter must give the estimates of a DataRate max filter")
+{
+}
+
+void
+WindowedFilterIntegerTest::DoRun (void)
+{
+  WindowedFilter<DataRate, MaxFilter<DataRate>, uint32_t, uint32_t> rateFilter (10, DataRate (1000), 0);
+  WindowedFilter<uint64_t, MaxFilter<uint64_t>, uint32_t, uint32_t> bpsFilter (10, 1000, 0);
+
+  Ptr<UniformRandomVariable> uv = CreateObject<UniformRandomVariable> ();
+  uv->SetStream (1);
+  uint32_t round = 0;
+  for (uint32_t i = 0; i < 100000; i++)
+    {
+      // a bandwidth that drifts, with rounds of a few samples
+      uint64_t bps = uv->GetInteger (1, 100000) * (1 + (i / 1000) % 7);
+      round += uv->GetInteger (0, 4) == 0 ? 1 : 0;
+      rateFilter.Update (DataRate (bps), round);
+      bpsFilter.Update (bps, round);
+      NS_TEST_ASSERT_MSG_EQ (bpsFilter.GetBest (), rateFilter.GetBest ().GetBitRate (),
+                             "Best estimates differ at sample " << i);
+      NS_TEST_ASSERT_MSG_EQ (bpsFilter.GetSecondBest (), rateFilter.GetSecondBest ().GetBitRate (),
+                             "Second best estimates differ at sample " << i);
+      NS_TEST_ASSERT_MSG_EQ (bpsFilter.GetThirdBest (), rateFilter.GetThirdBest ().GetBitRate (),
+                             "Third best estimates differ at sample " << i);
+    }
+}
+
+/**
+ * \brief Check the integer delivery rate against the rate computed from
+ * the interval in seconds
+ */
+class TcpDeliveryRateTest : public TestCase
+{
+public:
+  TcpDeliveryRateTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+TcpDeliveryRateTest::TcpDeliveryRateTest ()
+  : TestCase ("The integer delivery rate must match the rate computed in seconds")
+{
+}
+
+void
+TcpDeliveryRateTest::DoRun (void)
+{
+  NS_TEST_ASSERT_MSG_EQ (TcpTxBuffer::GetDeliveryRate (1000, MilliSeconds (1)).GetBitRate (), 8000000,
+                         "1000 bytes in 1 ms are 8 Mbps");
+  NS_TEST_ASSERT_MSG_EQ (TcpTxBuffer::GetDeliveryRate (3, NanoSeconds (7)).GetBitRate (), 3428571428,
+                         "The rate must be rounded down");
+  NS_TEST_ASSERT_MSG_EQ (TcpTxBuffer::GetDeliveryRate (4000000000U, Seconds (20)).GetBitRate (), 1600000000,
+                         "Long intervals must not overflow");
+
+  Ptr<UniformRandomVariable> uv = CreateObject<UniformRandomVariable> ();
+  uv->SetStream (2);
+  for (uint32_t i = 0; i < 100000; i++)
+    {
+      uint32_t delivered = uv->GetInteger (1, 100000000);
+      Time interval = NanoSeconds (uv->GetInteger (1000, 2000000000));
+      uint64_t expected = DataRate (delivered * 8.0 / interval.GetSeconds ()).GetBitRate ();
+      uint64_t rate = TcpTxBuffer::GetDeliveryRate (delivered, interval).GetBitRate ();
+      // the rate in seconds may be off by one, on either side, when rounding down
+      NS_TEST_ASSERT_MSG_EQ_TOL (rate, expected, 1,
+                                 delivered << " bytes in " << interval);
+    }
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Windowed filter and delivery rate TestSuite
+ */
+static class WindowedFilterTestSuite : public TestSuite
+{
+public:
+  WindowedFilterTestSuite () : TestSuite ("windowed-filter", UNIT)
+  {
+    AddTestCase (new WindowedFilterIntegerTest, TestCase::QUICK);
+    AddTestCase (new TcpDeliveryRateTest, TestCase::QUICK);
+  }
+} g_windowedFilterTestSuite;
+
+} // namespace ns3
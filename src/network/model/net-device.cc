@@ -20,6 +20,8 @@
 
 #include "ns3/log.h"
 #include "net-device.h"
+#include "ns3/queue-item.h"
+#include "ns3/net-device-queue-interface.h"
 
 namespace ns3 {
 
@@ -41,4 +43,29 @@ NetDevice::~NetDevice ()
   NS_LOG_FUNCTION (this);
 }
 
+uint32_t
+NetDevice::SendBatch (const std::vector<Ptr<QueueDiscItem> > &items)
+{
+  NS_LOG_FUNCTION (this << items.size ());
+
+  Ptr<NetDeviceQueueInterface> ndqi = GetObject<NetDeviceQueueInterface> ();
+  uint32_t sent = 0;
+  for (std::vector<Ptr<QueueDiscItem> >::const_iterator it = items.begin ();
+       it != items.end (); it++, sent++)
+    {
+      if (ndqi && ndqi->GetTxQueue ((*it)->GetTxQueueIndex ())->IsStopped ())
+        {
+          break;
+        }
+      Send ((*it)->GetPacket (), (*it)->GetAddress (), (*it)->GetProtocol ());
+    }
+  return sent;
+}
+
+bool
+NetDevice::SupportsGso (void) const
+{
+  return false;
+}
+
 } // namespace ns3
@@ -22,6 +22,7 @@
 #define NET_DEVICE_H
 
 #include <stdint.h>
+#include <vector>
 #include "ns3/callback.h"
 #include "ns3/object.h"
 #include "ns3/ptr.h"
@@ -34,6 +35,7 @@ namespace ns3 {
 
 class Node;
 class Channel;
+class QueueDiscItem;
 
 /**
  * \ingroup network
@@ -260,6 +262,35 @@ public:
    * \return whether the Send operation succeeded 
    */
   virtual bool SendFrom (Ptr<Packet> packet, const Address& source, const Address& dest, uint16_t protocolNumber) = 0;
+  /**
+   * \param items packets sent from above down to Network Device, in
+   *        transmission order.  The packet, destination address and
+   *        protocol number of each item are used as in Send ().
+   *
+   *  Called by the traffic control layer to hand a burst of packets to
+   *  the Network Device in a single call, much like the xmit_more hint
+   *  of Linux drivers.  The device consumes the items in order and stops
+   *  at the first one it cannot take because its transmission queue is
+   *  stopped; the caller keeps the remaining items.  Items the device
+   *  drops (e.g., because the link is down) count as consumed.
+   *
+   *  The default implementation calls Send () on each item.  Devices can
+   *  override it to perform the per-call checks once per burst.
+   *
+   * \return the number of items consumed
+   */
+  virtual uint32_t SendBatch (const std::vector<Ptr<QueueDiscItem> > &items);
+
+  /**
+   * \return true if this device can transmit super-segments, false otherwise.
+   *
+   * A device supporting generic segmentation offload transmits a packet
+   * carrying a GsoTag as if its segments had been sent back to back, each
+   * one with its own copy of the headers, and applies its receive error
+   * model to each segment.  Super-segments are split before being handed
+   * to other devices.  The default implementation returns false.
+   */
+  virtual bool SupportsGso (void) const;
   /**
    * \returns the node base class which contains this network
    *          interface.
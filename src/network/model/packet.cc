@@ -137,7 +137,8 @@ Packet::Packet ()
      * global UID
      */
     m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, 0),
-    m_nixVector (0)
+    m_nixVector (0),
+    m_flowHash (0)
 {
   m_globalUid++;
 }
@@ -146,7 +147,8 @@ Packet::Packet (const Packet &o)
   : m_buffer (o.m_buffer),
     m_byteTagList (o.m_byteTagList),
     m_packetTagList (o.m_packetTagList),
-    m_metadata (o.m_metadata)
+    m_metadata (o.m_metadata),
+    m_flowHash (o.m_flowHash)
 {
   o.m_nixVector ? m_nixVector = o.m_nixVector->Copy ()
     : m_nixVector = 0;
@@ -165,6 +167,7 @@ Packet::operator = (const Packet &o)
   m_metadata = o.m_metadata;
   o.m_nixVector ? m_nixVector = o.m_nixVector->Copy () 
     : m_nixVector = 0;
+  m_flowHash = o.m_flowHash;
   return *this;
 }
 
@@ -179,7 +182,8 @@ Packet::Packet (uint32_t size)
      * global UID
      */
     m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, size),
-    m_nixVector (0)
+    m_nixVector (0),
+    m_flowHash (0)
 {
   m_globalUid++;
 }
@@ -188,7 +192,8 @@ Packet::Packet (uint8_t const *buffer, uint32_t size, bool magic)
     m_byteTagList (),
     m_packetTagList (),
     m_metadata (0,0),
-    m_nixVector (0)
+    m_nixVector (0),
+    m_flowHash (0)
 {
   NS_ASSERT (magic);
   Deserialize (buffer, size);
@@ -205,7 +210,8 @@ Packet::Packet (uint8_t const*buffer, uint32_t size)
      * global UID
      */
     m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, size),
-    m_nixVector (0)
+    m_nixVector (0),
+    m_flowHash (0)
 {
   m_globalUid++;
   m_buffer.AddAtStart (size);
@@ -219,7 +225,8 @@ Packet::Packet (const Buffer &buffer,  const ByteTagList &byteTagList,
     m_byteTagList (byteTagList),
     m_packetTagList (packetTagList),
     m_metadata (metadata),
-    m_nixVector (0)
+    m_nixVector (0),
+    m_flowHash (0)
 {
 }
 
@@ -237,6 +244,7 @@ Packet::CreateFragment (uint32_t start, uint32_t length) const
   // through Create because it is private.
   Ptr<Packet> ret = Ptr<Packet> (new Packet (buffer, byteTagList, m_packetTagList, metadata), false);
   ret->SetNixVector (GetNixVector ());
+  ret->m_flowHash = m_flowHash;
   return ret;
 }
 
@@ -252,6 +260,18 @@ Packet::GetNixVector (void) const
   return m_nixVector;
 } 
 
+void
+Packet::SetFlowHash (uint32_t hash)
+{
+  m_flowHash = hash;
+}
+
+uint32_t
+Packet::GetFlowHash (void) const
+{
+  return m_flowHash;
+}
+
 void
 Packet::AddHeader (const Header &header)
 {
@@ -685,6 +685,28 @@ public:
    */
   Ptr<NixVector> GetNixVector (void) const; 
 
+  /**
+   * \brief Set the flow hash of the packet.
+   *
+   * The flow hash identifies the flow (e.g., the 5-tuple) the packet
+   * belongs to, in the spirit of the skb->hash field of Linux.  It is
+   * computed once, by the first layer that needs it, and then travels
+   * with the packet (and its copies and fragments) so that queue discs
+   * along the path can classify the packet without parsing its headers
+   * again.  The flow hash is not serialized.
+   *
+   * \param hash the flow hash, or 0 to clear it
+   */
+  void SetFlowHash (uint32_t hash);
+  /**
+   * \brief Get the flow hash of the packet.
+   *
+   * See the comment on SetFlowHash
+   *
+   * \returns the flow hash, or 0 if it has not been set
+   */
+  uint32_t GetFlowHash (void) const;
+
   /**
    * TracedCallback signature for Ptr<Packet>
    *
@@ -755,6 +777,7 @@ private:
 
   /* Please see comments above about nix-vector */
   Ptr<NixVector> m_nixVector; //!< the packet's Nix vector
+  uint32_t m_flowHash;        //!< the packet's flow hash (0 if not set)
 
   static uint32_t m_globalUid; //!< Global counter of packets Uid
 };
@@ -19,6 +19,7 @@
 #include "ns3/test.h"
 #include "ns3/drop-tail-queue.h"
 #include "ns3/uinteger.h"
+#include "ns3/gso-tag.h"
 
 using namespace ns3;
 
@@ -83,6 +84,51 @@ DropTailQueueTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ ((packet == 0), true, "There are really no packets in there");
 }
 
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * DropTailQueue test with super-segments, which count as their segments.
+ */
+class DropTailQueueGsoTestCase : public TestCase
+{
+public:
+  DropTailQueueGsoTestCase ();
+  virtual void DoRun (void);
+};
+
+DropTailQueueGsoTestCase::DropTailQueueGsoTestCase ()
+  : TestCase ("Check that the drop tail queue counts the segments of a super-segment")
+{
+}
+void
+DropTailQueueGsoTestCase::DoRun (void)
+{
+  Ptr<DropTailQueue<Packet> > queue = CreateObject<DropTailQueue<Packet> > ();
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MaxSize", QueueSizeValue (QueueSize ("6p"))), true,
+                         "Verify that we can actually set the attribute");
+
+  Ptr<Packet> p1, p2, p3;
+  p1 = Create<Packet> (4000);
+  p1->AddPacketTag (GsoTag (1000, 4000));
+  p2 = Create<Packet> (3000);
+  p2->AddPacketTag (GsoTag (1000, 3000));
+  p3 = Create<Packet> (1000);
+
+  NS_TEST_EXPECT_MSG_EQ (queue->Enqueue (p1), true, "The first super-segment must fit");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 4, "A super-segment counts as its segments");
+  NS_TEST_EXPECT_MSG_EQ (queue->Enqueue (p2), false, "The second super-segment must not fit");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetTotalDroppedPackets (), 3, "The dropped segments must be counted");
+  NS_TEST_EXPECT_MSG_EQ (queue->Enqueue (p3), true, "A packet must still fit");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 5, "There should be five segments in there");
+
+  Ptr<Packet> packet = queue->Dequeue ();
+  NS_TEST_EXPECT_MSG_EQ (packet->GetUid (), p1->GetUid (), "Was this the super-segment ?");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 1, "There should be one packet in there");
+  packet = queue->Dequeue ();
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 0, "There should be no packets in there");
+}
+
 /**
  * \ingroup network-test
  * \ingroup tests
@@ -96,6 +142,7 @@ public:
     : TestSuite ("drop-tail-queue", UNIT)
   {
     AddTestCase (new DropTailQueueTestCase (), TestCase::QUICK);
+    AddTestCase (new DropTailQueueGsoTestCase (), TestCase::QUICK);
   }
 };
 
@@ -20,11 +20,15 @@
 #include <cstdio>
 #include <cstdlib>
 #include <sstream>
+#include <fstream>
 #include <cstring>
 
+#include "ns3/core-config.h"
 #include "ns3/log.h"
 #include "ns3/test.h"
+#include "ns3/fatal-impl.h"
 #include "ns3/pcap-file.h"
+#include "ns3/pcap-mmap-reader.h"
 
 using namespace ns3;
 
@@ -1144,6 +1148,277 @@ DiffTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (usec, 3696, "Files are different from 2.3696 seconds");
 }
 
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * \brief Test case to make sure that PcapMmapReader reads pcap and pcapng
+ * files.
+ */
+class MmapReaderTestCase : public TestCase
+{
+public:
+  MmapReaderTestCase ();
+
+private:
+  virtual void DoSetup (void);
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+
+  std::string m_testFilename; //!< File name
+};
+
+MmapReaderTestCase::MmapReaderTestCase ()
+  : TestCase ("Check to see that PcapMmapReader reads pcap and pcapng files")
+{
+}
+
+void
+MmapReaderTestCase::DoSetup (void)
+{
+  std::stringstream filename;
+  uint32_t n = rand ();
+  filename << n;
+  m_testFilename = CreateTempDirFilename (filename.str () + ".pcapng");
+}
+
+void
+MmapReaderTestCase::DoTeardown (void)
+{
+  if (remove (m_testFilename.c_str ()))
+    {
+      NS_LOG_ERROR ("Failed to delete file " << m_testFilename);
+    }
+}
+
+void
+MmapReaderTestCase::DoRun (void)
+{
+  //
+  // The known good pcap file must read back exactly as through PcapFile.
+  //
+  std::string filename = CreateDataDirFilename ("known.pcap");
+  PcapMmapReader r;
+  r.Open (filename);
+  NS_TEST_ASSERT_MSG_EQ (r.Fail (), false, "Open (" << filename << ") returns error");
+  NS_TEST_ASSERT_MSG_EQ (r.IsPcapNg (), false, "known.pcap is not a pcapng file");
+
+  PcapMmapReader::Record record;
+  for (uint32_t i = 0; i < N_KNOWN_PACKETS; ++i)
+    {
+      PacketEntry const & p = knownPackets[i];
+      NS_TEST_ASSERT_MSG_EQ (r.Next (record), true, "Next () of known good pcap file returns no record");
+      NS_TEST_ASSERT_MSG_EQ (record.tsNs, p.tsSec * 1000000000ULL + p.tsUsec * 1000ULL, "Incorrect timestamp");
+      NS_TEST_ASSERT_MSG_EQ (record.inclLen, p.inclLen, "Incorrect included length");
+      NS_TEST_ASSERT_MSG_EQ (record.origLen, p.origLen, "Incorrect original length");
+      NS_TEST_ASSERT_MSG_EQ (record.dataLinkType, 1, "Incorrect data link type");
+      // The known packet data starts after the 14 byte Ethernet header.
+      for (uint32_t j = 0; j < N_PACKET_BYTES; ++j)
+        {
+          uint16_t word = (record.data[14 + 2 * j] << 8) | record.data[14 + 2 * j + 1];
+          NS_TEST_ASSERT_MSG_EQ (word, p.data[j], "Incorrect packet data");
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ (r.Next (record), false, "Next () past the last record returns a record");
+  NS_TEST_ASSERT_MSG_EQ (r.Eof (), true, "Next () past the last record does not set eof");
+  NS_TEST_ASSERT_MSG_EQ (r.Fail (), false, "Next () past the last record sets fail");
+  r.Rewind ();
+  NS_TEST_ASSERT_MSG_EQ (r.Next (record), true, "Next () after Rewind () returns no record");
+  NS_TEST_ASSERT_MSG_EQ (record.origLen, knownPackets[0].origLen, "Rewind () does not restart at the first record");
+  r.Close ();
+
+  //
+  // A big endian pcapng file with a section header, an interface with
+  // nanosecond resolution and PPP link type, an unknown block and one
+  // enhanced packet block of five bytes.
+  //
+  const uint8_t ng[] = {
+    // Section header block
+    0x0a, 0x0d, 0x0d, 0x0a, 0x00, 0x00, 0x00, 0x1c, 0x1a, 0x2b, 0x3c, 0x4d,
+    0x00, 0x01, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0x00, 0x00, 0x00, 0x1c,
+    // Interface description block, if_tsresol = 9
+    0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x20, 0x00, 0x09, 0x00, 0x00,
+    0x00, 0x00, 0xff, 0xff, 0x00, 0x09, 0x00, 0x01, 0x09, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x20,
+    // Unknown block
+    0x00, 0x00, 0x0b, 0xad, 0x00, 0x00, 0x00, 0x10, 0xde, 0xad, 0xbe, 0xef,
+    0x00, 0x00, 0x00, 0x10,
+    // Enhanced packet block, ts = 0x1_00000002 ns, 5 of 60 bytes captured
+    0x00, 0x00, 0x00, 0x06, 0x00, 0x00, 0x00, 0x28, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x05,
+    0x00, 0x00, 0x00, 0x3c, 0x01, 0x02, 0x03, 0x04, 0x05, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x28
+  };
+  std::ofstream out (m_testFilename.c_str (), std::ios::binary);
+  out.write ((const char *)ng, sizeof (ng));
+  out.close ();
+
+  r.Open (m_testFilename);
+#ifndef HAVE_SYS_MMAN_H
+  // Without mmap () the file is read through PcapFile, which does not
+  // understand pcapng.
+  NS_TEST_ASSERT_MSG_EQ (r.Fail (), true, "Open (" << m_testFilename << ") of a pcapng file without mmap () succeeds");
+  r.Close ();
+  return;
+#endif
+  NS_TEST_ASSERT_MSG_EQ (r.Fail (), false, "Open (" << m_testFilename << ") returns error");
+  NS_TEST_ASSERT_MSG_EQ (r.IsPcapNg (), true, "pcapng file not detected");
+  NS_TEST_ASSERT_MSG_EQ (r.Next (record), true, "Next () of pcapng file returns no record");
+  NS_TEST_ASSERT_MSG_EQ (record.tsNs, 0x100000002ULL, "Incorrect pcapng timestamp");
+  NS_TEST_ASSERT_MSG_EQ (record.inclLen, 5, "Incorrect pcapng included length");
+  NS_TEST_ASSERT_MSG_EQ (record.origLen, 60, "Incorrect pcapng original length");
+  NS_TEST_ASSERT_MSG_EQ (record.dataLinkType, 9, "Incorrect pcapng data link type");
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t)record.data[4], 5, "Incorrect pcapng packet data");
+  NS_TEST_ASSERT_MSG_EQ (r.Next (record), false, "Next () past the last pcapng block returns a record");
+  NS_TEST_ASSERT_MSG_EQ (r.Fail (), false, "Next () past the last pcapng block sets fail");
+  r.Close ();
+}
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * \brief Test case to make sure that buffered writes (synchronous and
+ * asynchronous) produce the same file as unbuffered writes.
+ */
+class BufferedWriteTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor.
+   * \param asyncFlush whether to flush the write buffer from a background thread
+   */
+  BufferedWriteTestCase (bool asyncFlush);
+
+private:
+  virtual void DoSetup (void);
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+
+  /**
+   * Write a fixed sequence of records to a file.
+   * \param f the (initialized) file to write to
+   */
+  void WriteRecords (PcapFile &f);
+
+  bool m_asyncFlush;               //!< Flush the write buffer from a background thread
+  std::string m_referenceFilename; //!< Unbuffered file name
+  std::string m_bufferedFilename;  //!< Buffered file name
+};
+
+BufferedWriteTestCase::BufferedWriteTestCase (bool asyncFlush)
+  : TestCase (asyncFlush ? "Check that PcapFile buffered writes with async flush match unbuffered writes"
+              : "Check that PcapFile buffered writes match unbuffered writes"),
+    m_asyncFlush (asyncFlush)
+{
+}
+
+void
+BufferedWriteTestCase::DoSetup (void)
+{
+  std::stringstream filename;
+  uint32_t n = rand ();
+  filename << n;
+  m_referenceFilename = CreateTempDirFilename (filename.str () + "-ref.pcap");
+  m_bufferedFilename = CreateTempDirFilename (filename.str () + "-buf.pcap");
+}
+
+void
+BufferedWriteTestCase::DoTeardown (void)
+{
+  if (remove (m_referenceFilename.c_str ()))
+    {
+      NS_LOG_ERROR ("Failed to delete file " << m_referenceFilename);
+    }
+  if (remove (m_bufferedFilename.c_str ()))
+    {
+      NS_LOG_ERROR ("Failed to delete file " << m_bufferedFilename);
+    }
+}
+
+void
+BufferedWriteTestCase::WriteRecords (PcapFile &f)
+{
+  uint8_t buffer[512];
+  for (uint32_t i = 0; i < sizeof (buffer); ++i)
+    {
+      buffer[i] = i & 0xff;
+    }
+
+  //
+  // Record sizes wrap around the snap length (128) and the chunk size (300)
+  // so that truncation, chunk hand-off and oversized records are all hit.
+  //
+  for (uint32_t i = 0; i < 1000; ++i)
+    {
+      f.Write (i / 100, i * 7 % 1000000, buffer, (i * 37) % sizeof (buffer));
+    }
+}
+
+void
+BufferedWriteTestCase::DoRun (void)
+{
+  PcapFile f;
+  f.Open (m_referenceFilename, std::ios::out);
+  NS_TEST_ASSERT_MSG_EQ (f.Fail (), false, "Open (" << m_referenceFilename << ", \"std::ios::out\") returns error");
+  f.Init (1, 128);
+  WriteRecords (f);
+  f.Close ();
+
+  PcapFile g;
+  g.Open (m_bufferedFilename, std::ios::out);
+  NS_TEST_ASSERT_MSG_EQ (g.Fail (), false, "Open (" << m_bufferedFilename << ", \"std::ios::out\") returns error");
+  g.Init (1, 128);
+  g.SetWriteBuffer (300, m_asyncFlush);
+  WriteRecords (g);
+  g.Flush ();
+  NS_TEST_ASSERT_MSG_EQ (g.Fail (), false, "Flush () of buffered file returns error");
+  g.Close ();
+
+  uint32_t sec (0), usec (0), packets (0);
+  bool diff = PcapFile::Diff (m_referenceFilename, m_bufferedFilename, sec, usec, packets, 128);
+  NS_TEST_EXPECT_MSG_EQ (diff, false, "Buffered file differs from unbuffered file at packet " << packets);
+  NS_TEST_EXPECT_MSG_EQ (packets, 1000, "Unexpected number of packets in buffered file");
+
+  std::ifstream ref (m_referenceFilename.c_str (), std::ios::binary | std::ios::ate);
+  std::ifstream buf (m_bufferedFilename.c_str (), std::ios::binary | std::ios::ate);
+  NS_TEST_EXPECT_MSG_EQ (static_cast<std::streamoff> (ref.tellg ()), static_cast<std::streamoff> (buf.tellg ()),
+                         "Buffered file has a different length");
+
+  //
+  // On a fatal error, the records still buffered are written out too.
+  //
+  PcapFile fatal;
+  fatal.Open (m_bufferedFilename, std::ios::out);
+  NS_TEST_ASSERT_MSG_EQ (fatal.Fail (), false, "Open (" << m_bufferedFilename << ", \"std::ios::out\") returns error");
+  fatal.Init (1, 128);
+  fatal.SetWriteBuffer (300, m_asyncFlush);
+  WriteRecords (fatal);
+  FatalImpl::FlushStreams ();
+  sec = usec = packets = 0;
+  diff = PcapFile::Diff (m_referenceFilename, m_bufferedFilename, sec, usec, packets, 128);
+  NS_TEST_EXPECT_MSG_EQ (diff, false, "File flushed on a fatal error differs at packet " << packets);
+  NS_TEST_EXPECT_MSG_EQ (packets, 1000, "Unexpected number of packets flushed on a fatal error");
+  fatal.Close ();
+
+  //
+  // A write failure of the (background) writer is reported by Fail () once
+  // the records are flushed, and forgotten by Clear ().
+  //
+  PcapFile h;
+  h.Open (m_referenceFilename, std::ios::in);
+  NS_TEST_ASSERT_MSG_EQ (h.Fail (), false, "Open (" << m_referenceFilename << ", \"std::ios::in\") returns error");
+  h.SetWriteBuffer (300, m_asyncFlush);
+  uint8_t record[100] = { 0 };
+  h.Write (0, 0, record, sizeof (record));
+  h.Flush ();
+  NS_TEST_EXPECT_MSG_EQ (h.Fail (), true, "Writing to a read-only file does not fail");
+  h.Clear ();
+  NS_TEST_EXPECT_MSG_EQ (h.Fail (), false, "Clear () does not clear the write failure");
+  h.Close ();
+}
+
 /**
  * \ingroup network-test
  * \ingroup tests
@@ -1167,6 +1442,9 @@ PcapFileTestSuite::PcapFileTestSuite ()
   AddTestCase (new RecordHeaderTestCase, TestCase::QUICK);
   AddTestCase (new ReadFileTestCase, TestCase::QUICK);
   AddTestCase (new DiffTestCase, TestCase::QUICK);
+  AddTestCase (new MmapReaderTestCase, TestCase::QUICK);
+  AddTestCase (new BufferedWriteTestCase (false), TestCase::QUICK);
+  AddTestCase (new BufferedWriteTestCase (true), TestCase::QUICK);
 }
 
 static PcapFileTestSuite pcapFileTestSuite; //!< Static variable for test initialization
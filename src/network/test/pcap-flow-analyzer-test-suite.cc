@@ -0,0 +1,256 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "ns3/log.h"
+#include "ns3/test.h"
+#include "ns3/pcap-file.h"
+#include "ns3/pcap-mmap-reader.h"
+#include "ns3/pcap-flow-analyzer.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("PcapFlowAnalyzerTestSuite");
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * \brief Test case to make sure that PcapFlowAnalyzer computes the
+ * per-flow statistics of a small generated capture.
+ */
+class PcapFlowAnalyzerTestCase : public TestCase
+{
+public:
+  PcapFlowAnalyzerTestCase ();
+
+private:
+  virtual void DoSetup (void);
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+
+  /**
+   * Write a raw IPv4 packet to the capture.
+   * \param f the capture
+   * \param tsUsec capture time, in microseconds after one second
+   * \param src source address, last byte of 10.0.0.x
+   * \param dst destination address, last byte of 10.0.0.x
+   * \param proto IP protocol
+   * \param sport source port
+   * \param dport destination port
+   * \param payload transport payload length
+   * \param seq TCP sequence number
+   * \param flags TCP flags
+   * \param tsVal TCP timestamp value
+   * \param tsEcr TCP timestamp echo reply
+   */
+  void WritePacket (PcapFile &f, uint32_t tsUsec, uint8_t src, uint8_t dst, uint8_t proto,
+                    uint16_t sport, uint16_t dport, uint32_t payload,
+                    uint32_t seq = 0, uint8_t flags = 0, uint32_t tsVal = 0, uint32_t tsEcr = 0);
+
+  std::string m_pcapFilename; //!< Generated capture
+  std::string m_npzFilename;  //!< Analyzer output
+};
+
+PcapFlowAnalyzerTestCase::PcapFlowAnalyzerTestCase ()
+  : TestCase ("Check the per-flow statistics of PcapFlowAnalyzer on a generated capture")
+{
+}
+
+void
+PcapFlowAnalyzerTestCase::DoSetup (void)
+{
+  std::stringstream filename;
+  uint32_t n = rand ();
+  filename << n;
+  m_pcapFilename = CreateTempDirFilename (filename.str () + ".pcap");
+  m_npzFilename = CreateTempDirFilename (filename.str () + ".npz");
+}
+
+void
+PcapFlowAnalyzerTestCase::DoTeardown (void)
+{
+  if (remove (m_pcapFilename.c_str ()))
+    {
+      NS_LOG_ERROR ("Failed to delete file " << m_pcapFilename);
+    }
+  if (remove (m_npzFilename.c_str ()))
+    {
+      NS_LOG_ERROR ("Failed to delete file " << m_npzFilename);
+    }
+}
+
+void
+PcapFlowAnalyzerTestCase::WritePacket (PcapFile &f, uint32_t tsUsec, uint8_t src, uint8_t dst, uint8_t proto,
+                                       uint16_t sport, uint16_t dport, uint32_t payload,
+                                       uint32_t seq, uint8_t flags, uint32_t tsVal, uint32_t tsEcr)
+{
+  // Only the headers are captured; the payload length comes from the IP
+  // total length.
+  uint8_t buf[64];
+  std::memset (buf, 0, sizeof (buf));
+  uint32_t transport = proto == 6 ? 32 : 8;
+  uint32_t totalLen = 20 + transport + payload;
+  buf[0] = 0x45;
+  buf[2] = totalLen >> 8;
+  buf[3] = totalLen & 0xff;
+  buf[8] = 64;
+  buf[9] = proto;
+  buf[12] = 10;
+  buf[15] = src;
+  buf[16] = 10;
+  buf[19] = dst;
+  uint8_t *t = buf + 20;
+  t[0] = sport >> 8;
+  t[1] = sport & 0xff;
+  t[2] = dport >> 8;
+  t[3] = dport & 0xff;
+  if (proto == 6)
+    {
+      t[4] = seq >> 24;
+      t[5] = (seq >> 16) & 0xff;
+      t[6] = (seq >> 8) & 0xff;
+      t[7] = seq & 0xff;
+      t[12] = (transport / 4) << 4;
+      t[13] = flags;
+      // NOP, NOP, timestamps
+      t[20] = 1;
+      t[21] = 1;
+      t[22] = 8;
+      t[23] = 10;
+      for (uint32_t i = 0; i < 4; ++i)
+        {
+          t[24 + i] = (tsVal >> (24 - 8 * i)) & 0xff;
+          t[28 + i] = (tsEcr >> (24 - 8 * i)) & 0xff;
+        }
+    }
+  f.Write (1, tsUsec, buf, totalLen);
+}
+
+void
+PcapFlowAnalyzerTestCase::DoRun (void)
+{
+  const uint8_t TCP = 6;
+  const uint8_t UDP = 17;
+  const uint8_t ACK = 0x10;
+
+  PcapFile f;
+  f.Open (m_pcapFilename, std::ios::out);
+  NS_TEST_ASSERT_MSG_EQ (f.Fail (), false, "Open (" << m_pcapFilename << ") returns error");
+  f.Init (101, 64);   // DLT_RAW
+
+  // Flow 0, 10.0.0.1:1000 -> 10.0.0.2:80: 1000 byte segments, the third
+  // one after a gap of one segment, then a retransmission.
+  WritePacket (f, 0, 1, 2, TCP, 1000, 80, 1000, 1, ACK, 100, 0);
+  WritePacket (f, 10000, 1, 2, TCP, 1000, 80, 1000, 1001, ACK, 101, 0);
+  WritePacket (f, 20000, 1, 2, TCP, 1000, 80, 1000, 3001, ACK, 102, 0);
+  WritePacket (f, 30000, 1, 2, TCP, 1000, 80, 1000, 1001, ACK, 103, 0);
+  // Flow 1, the pure ACKs of flow 0.  The third one echoes a TSval that
+  // was already matched and gives no RTT sample.
+  WritePacket (f, 50000, 2, 1, TCP, 80, 1000, 0, 1, ACK, 500, 100);
+  WritePacket (f, 60000, 2, 1, TCP, 80, 1000, 0, 1, ACK, 501, 101);
+  WritePacket (f, 70000, 2, 1, TCP, 80, 1000, 0, 1, ACK, 502, 101);
+  // Flow 2, UDP.
+  WritePacket (f, 80000, 3, 4, UDP, 5000, 6000, 200);
+  // Not IPv4: skipped.
+  uint8_t ipv6[40];
+  std::memset (ipv6, 0, sizeof (ipv6));
+  ipv6[0] = 0x60;
+  f.Write (1, 90000, ipv6, sizeof (ipv6));
+  f.Close ();
+
+  PcapMmapReader reader;
+  reader.Open (m_pcapFilename);
+  NS_TEST_ASSERT_MSG_EQ (reader.Fail (), false, "Open (" << m_pcapFilename << ") returns error");
+
+  // 10 ms steps, 100 ms window
+  PcapFlowAnalyzer analyzer (10000000, 10);
+  analyzer.Run (reader);
+  NS_TEST_ASSERT_MSG_EQ (reader.Fail (), false, "Reading the capture fails");
+  NS_TEST_EXPECT_MSG_EQ (analyzer.GetNPackets (), 9, "Wrong number of records");
+  NS_TEST_EXPECT_MSG_EQ (analyzer.GetNSkipped (), 1, "Wrong number of skipped records");
+  NS_TEST_ASSERT_MSG_EQ (analyzer.GetNFlows (), 3, "Wrong number of flows");
+
+  const PcapFlowAnalyzer::Flow &data = analyzer.GetFlow (0);
+  NS_TEST_EXPECT_MSG_EQ (data.key.srcIp, 0x0a000001, "Wrong source address of flow 0");
+  NS_TEST_EXPECT_MSG_EQ (data.key.dstIp, 0x0a000002, "Wrong destination address of flow 0");
+  NS_TEST_EXPECT_MSG_EQ (data.key.srcPort, 1000, "Wrong source port of flow 0");
+  NS_TEST_EXPECT_MSG_EQ (data.key.dstPort, 80, "Wrong destination port of flow 0");
+  NS_TEST_EXPECT_MSG_EQ ((uint32_t)data.key.proto, 6, "Wrong protocol of flow 0");
+  NS_TEST_EXPECT_MSG_EQ (data.packets, 4, "Wrong packet count of flow 0");
+  NS_TEST_EXPECT_MSG_EQ (data.bytes, 4000, "Wrong byte count of flow 0");
+  NS_TEST_EXPECT_MSG_EQ (data.lostBytes, 1000, "The sequence gap of flow 0 is not counted as lost");
+  NS_TEST_EXPECT_MSG_EQ (data.retransmits, 1, "The retransmission of flow 0 is not counted");
+  NS_TEST_EXPECT_MSG_EQ (data.firstNs, 1000000000ULL, "Wrong first packet time of flow 0");
+  NS_TEST_EXPECT_MSG_EQ (data.lastNs, 1030000000ULL, "Wrong last packet time of flow 0");
+
+  std::vector<double> rtt = analyzer.GetRttSamples (0);
+  NS_TEST_ASSERT_MSG_EQ (rtt.size (), 2, "Wrong number of RTT samples of flow 0");
+  NS_TEST_EXPECT_MSG_EQ_TOL (rtt[0], 50000, 1e-6, "Wrong first RTT sample");
+  NS_TEST_EXPECT_MSG_EQ_TOL (rtt[1], 50000, 1e-6, "Wrong second RTT sample");
+
+  const PcapFlowAnalyzer::Flow &acks = analyzer.GetFlow (1);
+  NS_TEST_EXPECT_MSG_EQ (acks.key.srcIp, 0x0a000002, "Flow 1 is not the reverse of flow 0");
+  NS_TEST_EXPECT_MSG_EQ (acks.packets, 3, "Wrong packet count of flow 1");
+  NS_TEST_EXPECT_MSG_EQ (acks.bytes, 0, "Wrong byte count of flow 1");
+  NS_TEST_EXPECT_MSG_EQ (acks.lostBytes, 0, "Pure ACKs are counted as lost");
+  NS_TEST_EXPECT_MSG_EQ (analyzer.GetRttSamples (1).size (), 0, "Flow 1 has RTT samples");
+
+  const PcapFlowAnalyzer::Flow &udp = analyzer.GetFlow (2);
+  NS_TEST_EXPECT_MSG_EQ ((uint32_t)udp.key.proto, 17, "Wrong protocol of flow 2");
+  NS_TEST_EXPECT_MSG_EQ (udp.key.dstPort, 6000, "Wrong destination port of flow 2");
+  NS_TEST_EXPECT_MSG_EQ (udp.packets, 1, "Wrong packet count of flow 2");
+  NS_TEST_EXPECT_MSG_EQ (udp.bytes, 200, "Wrong byte count of flow 2");
+
+  //
+  // The results are written as a zip archive of .npy arrays.
+  //
+  NS_TEST_ASSERT_MSG_EQ (analyzer.Write (m_npzFilename), true, "Write (" << m_npzFilename << ") fails");
+  std::ifstream in (m_npzFilename.c_str (), std::ios::binary);
+  std::string npz ((std::istreambuf_iterator<char> (in)), std::istreambuf_iterator<char> ());
+  NS_TEST_ASSERT_MSG_EQ (npz.compare (0, 4, "PK\x03\x04"), 0, "The output is not a zip archive");
+  NS_TEST_EXPECT_MSG_NE (npz.find ("flow_bytes.npy"), std::string::npos, "The output has no flow_bytes array");
+  NS_TEST_EXPECT_MSG_NE (npz.find ("'shape': (3,)"), std::string::npos, "The output has no per-flow arrays of three flows");
+  NS_TEST_EXPECT_MSG_NE (npz.find ("rtt_us.npy"), std::string::npos, "The output has no rtt_us array");
+}
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * \brief PcapFlowAnalyzer TestSuite
+ */
+class PcapFlowAnalyzerTestSuite : public TestSuite
+{
+public:
+  PcapFlowAnalyzerTestSuite ();
+};
+
+PcapFlowAnalyzerTestSuite::PcapFlowAnalyzerTestSuite ()
+  : TestSuite ("pcap-flow-analyzer", UNIT)
+{
+  AddTestCase (new PcapFlowAnalyzerTestCase, TestCase::QUICK);
+}
+
+static PcapFlowAnalyzerTestSuite pcapFlowAnalyzerTestSuite; //!< Static variable for test initialization
@@ -0,0 +1,193 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/ring-buffer.h"
+#include "ns3/packet.h"
+#include <list>
+#include <cstdlib>
+
+using namespace ns3;
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * Check that iterators survive the removal of other elements, as queues
+ * removing expired items while browsing them expect.
+ */
+class RingBufferEraseTestCase : public TestCase
+{
+public:
+  RingBufferEraseTestCase ();
+  virtual void DoRun (void);
+};
+
+RingBufferEraseTestCase::RingBufferEraseTestCase ()
+  : TestCase ("Check iterator stability across erase")
+{
+}
+
+void
+RingBufferEraseTestCase::DoRun (void)
+{
+  RingBuffer<Ptr<Packet> > ring;
+  std::vector<Ptr<Packet> > packets;
+  for (uint32_t i = 0; i < 20; i++)
+    {
+      packets.push_back (Create<Packet> (i));
+      ring.insert (ring.cend (), packets.back ());
+    }
+  NS_TEST_EXPECT_MSG_EQ (ring.size (), 20, "Unexpected number of elements");
+
+  // remove every odd packet while browsing the buffer
+  RingBuffer<Ptr<Packet> >::ConstIterator end = ring.cend ();
+  uint32_t n = 0;
+  for (RingBuffer<Ptr<Packet> >::ConstIterator it = ring.cbegin (); it != ring.cend (); n++)
+    {
+      RingBuffer<Ptr<Packet> >::ConstIterator curr = it++;
+      if (n % 2 == 1)
+        {
+          ring.erase (curr);
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (n, 20, "Every element should have been visited");
+  NS_TEST_EXPECT_MSG_EQ ((end == ring.cend ()), true, "The end iterator should not move");
+  NS_TEST_EXPECT_MSG_EQ (ring.size (), 10, "Unexpected number of elements");
+
+  n = 0;
+  for (RingBuffer<Ptr<Packet> >::ConstIterator it = ring.cbegin (); it != ring.cend (); ++it, n += 2)
+    {
+      NS_TEST_EXPECT_MSG_EQ ((*it)->GetUid (), packets[n]->GetUid (), "Unexpected element");
+    }
+
+  // browse backwards, skipping the holes
+  RingBuffer<Ptr<Packet> >::ConstIterator it = ring.cend ();
+  for (n = 18; it != ring.cbegin (); n -= 2)
+    {
+      --it;
+      NS_TEST_EXPECT_MSG_EQ ((*it)->GetUid (), packets[n]->GetUid (), "Unexpected element");
+    }
+
+  // remove the remaining ones from the back, then from the front
+  ring.erase (--ring.cend ());
+  while (!ring.empty ())
+    {
+      ring.erase (ring.cbegin ());
+    }
+  NS_TEST_EXPECT_MSG_EQ ((ring.cbegin () == ring.cend ()), true, "The buffer should be empty");
+}
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * Compare a RingBuffer against an std::list under random insertions and
+ * removals.
+ */
+class RingBufferRandomTestCase : public TestCase
+{
+public:
+  RingBufferRandomTestCase ();
+  virtual void DoRun (void);
+};
+
+RingBufferRandomTestCase::RingBufferRandomTestCase ()
+  : TestCase ("Compare against std::list under random operations")
+{
+}
+
+void
+RingBufferRandomTestCase::DoRun (void)
+{
+  typedef RingBuffer<Ptr<Packet> >::ConstIterator RingIterator;
+  typedef std::list<Ptr<Packet> >::iterator ListIterator;
+
+  RingBuffer<Ptr<Packet> > ring;
+  std::list<Ptr<Packet> > list;
+  srand (1);
+
+  for (uint32_t step = 0; step < 5000; step++)
+    {
+      uint32_t op = rand () % 8;
+      uint32_t pos = list.empty () ? 0 : rand () % (list.size () + 1);
+      RingIterator rit = ring.cbegin ();
+      ListIterator lit = list.begin ();
+      for (uint32_t i = 0; i < pos; i++)
+        {
+          ++rit;
+          ++lit;
+        }
+      if (op < 4 || list.empty ())
+        {
+          // enqueue, mostly at the tail
+          if (op < 2)
+            {
+              rit = ring.cend ();
+              lit = list.end ();
+            }
+          Ptr<Packet> p = Create<Packet> ();
+          rit = ring.insert (rit, p);
+          lit = list.insert (lit, p);
+          NS_TEST_ASSERT_MSG_EQ (*rit, *lit, "insert returned a wrong position");
+        }
+      else if (lit != list.end ())
+        {
+          // dequeue, mostly from the head
+          if (op < 6)
+            {
+              rit = ring.cbegin ();
+              lit = list.begin ();
+            }
+          rit = ring.erase (rit);
+          lit = list.erase (lit);
+          NS_TEST_ASSERT_MSG_EQ ((rit == ring.cend ()), (lit == list.end ()),
+                                 "erase returned a wrong position");
+          if (lit != list.end ())
+            {
+              NS_TEST_ASSERT_MSG_EQ (*rit, *lit, "erase returned a wrong position");
+            }
+        }
+
+      NS_TEST_ASSERT_MSG_EQ (ring.size (), list.size (), "Size mismatch");
+      lit = list.begin ();
+      for (rit = ring.cbegin (); rit != ring.cend (); ++rit, ++lit)
+        {
+          NS_TEST_ASSERT_MSG_EQ (*rit, *lit, "Content mismatch at step " << step);
+        }
+    }
+  ring.clear ();
+  NS_TEST_EXPECT_MSG_EQ (ring.empty (), true, "The buffer should be empty");
+}
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * \brief RingBuffer TestSuite
+ */
+class RingBufferTestSuite : public TestSuite
+{
+public:
+  RingBufferTestSuite ()
+    : TestSuite ("ring-buffer", UNIT)
+  {
+    AddTestCase (new RingBufferEraseTestCase (), TestCase::QUICK);
+    AddTestCase (new RingBufferRandomTestCase (), TestCase::QUICK);
+  }
+};
+
+static RingBufferTestSuite g_ringBufferTestSuite; //!< Static variable for test initialization
@@ -0,0 +1,167 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <map>
+#include "gso-tag.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("GsoTag");
+
+NS_OBJECT_ENSURE_REGISTERED (GsoTag);
+
+namespace {
+
+/**
+ * \return the segmenters, by network protocol number
+ */
+std::map<uint16_t, GsoTag::Segmenter> &
+GetSegmenters (void)
+{
+  static std::map<uint16_t, GsoTag::Segmenter> segmenters;
+  return segmenters;
+}
+
+} // unnamed namespace
+
+TypeId
+GsoTag::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::GsoTag")
+    .SetParent<Tag> ()
+    .SetGroupName ("Network")
+    .AddConstructor<GsoTag> ()
+  ;
+  return tid;
+}
+TypeId
+GsoTag::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+uint32_t
+GsoTag::GetSerializedSize (void) const
+{
+  return 2 + 4 + 8;
+}
+void
+GsoTag::Serialize (TagBuffer buf) const
+{
+  buf.WriteU16 (m_segmentSize);
+  buf.WriteU32 (m_payloadSize);
+  buf.WriteU64 (m_lost);
+}
+void
+GsoTag::Deserialize (TagBuffer buf)
+{
+  m_segmentSize = buf.ReadU16 ();
+  m_payloadSize = buf.ReadU32 ();
+  m_lost = buf.ReadU64 ();
+}
+void
+GsoTag::Print (std::ostream &os) const
+{
+  os << "SegmentSize=" << m_segmentSize << " PayloadSize=" << m_payloadSize
+     << " Lost=0x" << std::hex << m_lost << std::dec;
+}
+GsoTag::GsoTag ()
+  : Tag (),
+    m_segmentSize (0),
+    m_payloadSize (0),
+    m_lost (0)
+{
+}
+
+GsoTag::GsoTag (uint16_t segmentSize, uint32_t payloadSize)
+  : Tag (),
+    m_segmentSize (segmentSize),
+    m_payloadSize (payloadSize),
+    m_lost (0)
+{
+  NS_LOG_FUNCTION (this << segmentSize << payloadSize);
+  NS_ASSERT_MSG (segmentSize > 0, "The segment size must be positive");
+  NS_ASSERT_MSG (GetNSegments () <= MAX_SEGMENTS, "Too many segments: " << GetNSegments ());
+}
+
+uint16_t
+GsoTag::GetSegmentSize (void) const
+{
+  return m_segmentSize;
+}
+
+uint32_t
+GsoTag::GetPayloadSize (void) const
+{
+  return m_payloadSize;
+}
+
+uint32_t
+GsoTag::GetNSegments (void) const
+{
+  return (m_payloadSize + m_segmentSize - 1) / m_segmentSize;
+}
+
+uint32_t
+GsoTag::GetSegmentPayloadSize (uint32_t i) const
+{
+  NS_ASSERT (i < GetNSegments ());
+  if (i + 1 < GetNSegments ())
+    {
+      return m_segmentSize;
+    }
+  return m_payloadSize - i * m_segmentSize;
+}
+
+bool
+GsoTag::IsLost (uint32_t i) const
+{
+  NS_ASSERT (i < GetNSegments ());
+  return (m_lost >> i) & 1;
+}
+
+void
+GsoTag::SetLost (uint32_t i)
+{
+  NS_LOG_FUNCTION (this << i);
+  NS_ASSERT (i < GetNSegments ());
+  m_lost |= static_cast<uint64_t> (1) << i;
+}
+
+bool
+GsoTag::HasLosses (void) const
+{
+  return m_lost != 0;
+}
+
+void
+GsoTag::SetSegmenter (uint16_t protocol, Segmenter segmenter)
+{
+  NS_LOG_FUNCTION (protocol);
+  GetSegmenters ()[protocol] = segmenter;
+}
+
+GsoTag::Segmenter
+GsoTag::GetSegmenter (uint16_t protocol)
+{
+  std::map<uint16_t, Segmenter>::const_iterator it = GetSegmenters ().find (protocol);
+  if (it == GetSegmenters ().end ())
+    {
+      return Segmenter ();
+    }
+  return it->second;
+}
+
+} // namespace ns3
@@ -0,0 +1,136 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef GSO_TAG_H
+#define GSO_TAG_H
+
+#include <list>
+#include "ns3/tag.h"
+#include "ns3/callback.h"
+#include "ns3/packet.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup network
+ *
+ * \brief Packet tag marking a super-segment (generic segmentation offload)
+ *
+ * A super-segment carries the payload of several segments behind a single
+ * copy of the protocol headers.  It travels through the stack as one
+ * packet, and devices supporting it (see NetDevice::SupportsGso) transmit
+ * it as if each segment, headers included, had been sent back to back.
+ * The receiving device marks the segments its error model corrupts as
+ * lost, and the transport protocol skips them.
+ *
+ * The payload is the last GetPayloadSize () bytes of the packet; all the
+ * segments carry GetSegmentSize () bytes of it, except possibly the last
+ * one.
+ *
+ * Network protocols which create super-segments register a Segmenter, so
+ * that devices can show the segments to their sniffers (and thus to pcap
+ * traces) as the separate frames they stand for.
+ */
+class GsoTag : public Tag
+{
+public:
+  /**
+   * \brief Maximum number of segments in a super-segment.
+   */
+  static const uint32_t MAX_SEGMENTS = 64;
+
+  /**
+   * \brief Callback splitting a super-segment into its segments
+   *
+   * The super-segment starts with the header of the network protocol the
+   * segmenter is registered for.  The returned segments each have their
+   * own copy of the headers and no GsoTag; the segments marked as lost
+   * are left out.
+   */
+  typedef Callback<std::list<Ptr<Packet> >, Ptr<const Packet> > Segmenter;
+
+  /**
+   * \brief Register the segmenter of a network protocol
+   * \param protocol the protocol number (e.g., 0x0800 for IPv4)
+   * \param segmenter the segmenter
+   */
+  static void SetSegmenter (uint16_t protocol, Segmenter segmenter);
+  /**
+   * \param protocol the protocol number
+   * \return the segmenter registered for the protocol, or a null callback
+   */
+  static Segmenter GetSegmenter (uint16_t protocol);
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (TagBuffer buf) const;
+  virtual void Deserialize (TagBuffer buf);
+  virtual void Print (std::ostream &os) const;
+  GsoTag ();
+
+  /**
+   * Constructs a GsoTag
+   *
+   * \param segmentSize the payload size of each segment
+   * \param payloadSize the total payload size
+   */
+  GsoTag (uint16_t segmentSize, uint32_t payloadSize);
+
+  /**
+   * \return the payload size of each segment
+   */
+  uint16_t GetSegmentSize (void) const;
+  /**
+   * \return the total payload size
+   */
+  uint32_t GetPayloadSize (void) const;
+  /**
+   * \return the number of segments
+   */
+  uint32_t GetNSegments (void) const;
+  /**
+   * \param i the index of a segment
+   * \return the payload size of the segment
+   */
+  uint32_t GetSegmentPayloadSize (uint32_t i) const;
+  /**
+   * \param i the index of a segment
+   * \return true if the segment has been lost
+   */
+  bool IsLost (uint32_t i) const;
+  /**
+   * \brief Mark a segment as lost
+   * \param i the index of the segment
+   */
+  void SetLost (uint32_t i);
+  /**
+   * \return true if any segment has been lost
+   */
+  bool HasLosses (void) const;
+
+private:
+  uint16_t m_segmentSize; //!< Payload size of each segment
+  uint32_t m_payloadSize; //!< Total payload size
+  uint64_t m_lost;        //!< Bitmap of the lost segments
+};
+
+} // namespace ns3
+
+#endif /* GSO_TAG_H */
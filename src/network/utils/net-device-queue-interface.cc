@@ -23,6 +23,7 @@
 #include "ns3/queue-limits.h"
 #include "ns3/net-device-queue-interface.h"
 #include "ns3/simulator.h"
+#include <limits>
 
 namespace ns3 {
 
@@ -82,6 +83,22 @@ NetDeviceQueue::SetWakeCallback (WakeCallback cb)
   m_wakeCallback = cb;
 }
 
+void
+NetDeviceQueue::SetRoomCallback (RoomCallback cb)
+{
+  m_roomCallback = cb;
+}
+
+uint32_t
+NetDeviceQueue::GetRoom (void) const
+{
+  if (m_roomCallback.IsNull ())
+    {
+      return std::numeric_limits<uint32_t>::max ();
+    }
+  return m_roomCallback ();
+}
+
 void
 NetDeviceQueue::NotifyQueuedBytes (uint32_t bytes)
 {
@@ -201,6 +218,11 @@ NetDeviceQueueInterface::DoDispose (void)
     }
 
   m_traceMap.clear ();
+  for (auto &txq : m_txQueuesVector)
+    {
+      // the room callback holds a reference to this object
+      txq->SetRoomCallback (MakeNullCallback<uint32_t> ());
+    }
   m_txQueuesVector.clear ();
   Object::DoDispose ();
 }
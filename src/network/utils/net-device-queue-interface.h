@@ -107,6 +107,30 @@ public:
    */
   virtual void SetWakeCallback (WakeCallback cb);
 
+  /// Callback returning how many packets the device queue can still accept
+  typedef Callback< uint32_t > RoomCallback;
+
+  /**
+   * \brief Set the room callback
+   * \param cb the callback to set
+   *
+   * Set by NetDeviceQueueInterface::ConnectQueueTraces, so that queue discs
+   * can size the bursts of packets they hand to the device.
+   */
+  void SetRoomCallback (RoomCallback cb);
+
+  /**
+   * \brief Get the number of packets the device can accept before it stops
+   *        this transmission queue
+   * \return the number of MTU-sized packets the device queue can still
+   *         store, or the maximum uint32_t value if the device queue is not
+   *         known
+   *
+   * Called by queue discs to bound bulk dequeues, in the spirit of the
+   * qdisc_avail_bulklimit function of the Linux kernel.
+   */
+  uint32_t GetRoom (void) const;
+
   /**
    * \brief Called by the netdevice to report the number of bytes queued to the device queue
    * \param bytes number of bytes queued to the device queue
@@ -192,11 +216,24 @@ public:
                                Ptr<NetDeviceQueueInterface> ndqi,
                                uint8_t txq, Ptr<const Item> item);
 
+  /**
+   * \brief Compute the number of MTU-sized packets the queue of a netdevice
+   *        can store before the transmission queue is stopped by PacketEnqueued
+   *
+   * \param queue the device queue
+   * \param ndqi the NetDeviceQueueInterface object aggregated to the device
+   * \return the number of packets
+   */
+  template <typename Item>
+  static uint32_t PacketRoom (Ptr<Queue<Item> > queue,
+                              Ptr<NetDeviceQueueInterface> ndqi);
+
 private:
   bool m_stoppedByDevice;         //!< True if the queue has been stopped by the device
   bool m_stoppedByQueueLimits;    //!< True if the queue has been stopped by a queue limits object
   Ptr<QueueLimits> m_queueLimits; //!< Queue limits object
   WakeCallback m_wakeCallback;    //!< Wake callback
+  RoomCallback m_roomCallback;    //!< Room callback
 };
 
 
@@ -350,6 +387,8 @@ NetDeviceQueueInterface::ConnectQueueTraces (Ptr<Queue<Item> > queue, uint8_t tx
   queue->TraceConnectWithoutContext ("Dequeue", m_traceMap[queue][1]);
   queue->TraceConnectWithoutContext ("DropAfterDequeue", m_traceMap[queue][1]);
   queue->TraceConnectWithoutContext ("DropBeforeEnqueue", m_traceMap[queue][2]);
+
+  GetTxQueue (txq)->SetRoomCallback (MakeBoundCallback (&NetDeviceQueue::PacketRoom<Item>, queue, this));
 }
 
 template <typename Item>
@@ -430,6 +469,26 @@ NetDeviceQueue::PacketDiscarded (Ptr<Queue<Item> > queue,
   ndqi->GetTxQueue (txq)->Stop ();
 }
 
+template <typename Item>
+uint32_t
+NetDeviceQueue::PacketRoom (Ptr<Queue<Item> > queue, Ptr<NetDeviceQueueInterface> ndqi)
+{
+  // This mirrors the condition under which PacketEnqueued stops the queue
+
+  if (queue->GetMode () == QueueBase::QUEUE_MODE_PACKETS)
+    {
+      return queue->GetNPackets () < queue->GetMaxPackets () ?
+             queue->GetMaxPackets () - queue->GetNPackets () : 0;
+    }
+
+  uint16_t mtu = ndqi->GetObject<NetDevice> ()->GetMtu ();
+  if (mtu == 0 || queue->GetNBytes () >= queue->GetMaxBytes ())
+    {
+      return 0;
+    }
+  return (queue->GetMaxBytes () - queue->GetNBytes ()) / mtu;
+}
+
 } // namespace ns3
 
 #endif /* NET_DEVICE_QUEUE_INTERFACE_H */
@@ -46,6 +46,19 @@ PcapFileWrapper::GetTypeId (void)
                    BooleanValue (false),
                    MakeBooleanAccessor (&PcapFileWrapper::m_nanosecMode),
                    MakeBooleanChecker())
+    .AddAttribute ("WriteBufferSize",
+                   "Size in bytes of the in-memory chunks in which records are "
+                   "accumulated before being written to the file. "
+                   "Zero writes every record immediately.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&PcapFileWrapper::m_writeBufferSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("AsyncFlush",
+                   "Whether full write buffer chunks are written to the file by "
+                   "a background thread. Only used if WriteBufferSize is not zero.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&PcapFileWrapper::m_asyncFlush),
+                   MakeBooleanChecker())
   ;
   return tid;
 }
@@ -89,6 +102,13 @@ PcapFileWrapper::Close (void)
   m_file.Close ();
 }
 
+void
+PcapFileWrapper::Flush (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_file.Flush ();
+}
+
 void
 PcapFileWrapper::Open (std::string const &filename, std::ios::openmode mode)
 {
@@ -113,6 +133,10 @@ PcapFileWrapper::Init (uint32_t dataLinkType, uint32_t snapLen, int32_t tzCorrec
     {
       m_file.Init (dataLinkType, m_snapLen, tzCorrection, false, m_nanosecMode);
     } 
+  if (m_writeBufferSize > 0)
+    {
+      m_file.SetWriteBuffer (m_writeBufferSize, m_asyncFlush);
+    }
 }
 
 void
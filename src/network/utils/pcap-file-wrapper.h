@@ -82,6 +82,12 @@ public:
    */
   void Close (void);
 
+  /**
+   * Write any records held in the write buffer (see the WriteBufferSize
+   * attribute) to the underlying pcap file.
+   */
+  void Flush (void);
+
   /**
    * Initialize the pcap file associated with this wrapper.  This file must have
    * been previously opened with write permissions.
@@ -224,6 +230,8 @@ private:
   PcapFile m_file; //!< Pcap file
   uint32_t m_snapLen; //!< max length of saved packets
   bool     m_nanosecMode; //!< Timestamps in nanosecond mode
+  uint32_t m_writeBufferSize; //!< Size of the write buffer chunks, zero if unbuffered
+  bool     m_asyncFlush; //!< Write full chunks from a background thread
 };
 
 } // namespace ns3
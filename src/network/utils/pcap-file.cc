@@ -20,6 +20,8 @@
 
 #include <iostream>
 #include <cstring>
+#include <deque>
+#include "ns3/core-config.h"
 #include "ns3/assert.h"
 #include "ns3/packet.h"
 #include "ns3/fatal-error.h"
@@ -29,6 +31,11 @@
 #include "pcap-file.h"
 #include "ns3/log.h"
 #include "ns3/build-profile.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-thread.h"
+#include "ns3/system-mutex.h"
+#include "ns3/system-condition.h"
+#endif
 //
 // This file is used as part of the ns-3 test framework, so please refrain from 
 // adding any ns-3 specific constructs such as Packet to this file.
@@ -47,20 +54,264 @@ const uint32_t NS_SWAPPED_MAGIC = 0x4d3cb2a1; /**< Looks this way if byte swappi
 const uint16_t VERSION_MAJOR = 2;             /**< Major version of supported pcap file format */
 const uint16_t VERSION_MINOR = 4;             /**< Minor version of supported pcap file format */
 
+const uint32_t RECORD_HEADER_SIZE = 16;       /**< Serialized size of a pcap record header */
+
+#ifdef HAVE_PTHREAD_H
+
+/**
+ * \brief Background writer for buffered pcap files
+ *
+ * Owns a small ring of chunks.  The simulation thread fills a chunk and
+ * queues it with Submit (); the writer thread writes queued chunks to the
+ * file stream and recycles them.  While the writer exists, only its thread
+ * touches the file stream; the state of the stream is reported to the
+ * simulation thread through an error flag guarded by the mutex.  The SystemCondition waits are bounded so
+ * that a wake-up racing with a wait only costs a few milliseconds.
+ */
+class PcapFile::AsyncWriter
+{
+public:
+  /**
+   * \param file the stream written to by the background thread
+   */
+  AsyncWriter (std::fstream *file);
+  ~AsyncWriter ();
+
+  /**
+   * \brief Queue a chunk for writing
+   *
+   * Blocks while the ring is full.
+   *
+   * \param chunk [in,out] the chunk to write; replaced by an empty chunk
+   * \param used number of valid bytes in chunk
+   * \returns true if writing a previous chunk failed
+   */
+  bool Submit (std::vector<uint8_t> &chunk, uint32_t used);
+  /**
+   * \brief Wait until every queued chunk has been written
+   *
+   * The writer thread is idle and does not touch the file stream when
+   * this returns, until the next Submit ().
+   */
+  void Drain (void);
+  /**
+   * \returns true if writing a chunk failed
+   */
+  bool Failed (void);
+  /**
+   * \brief Forget a write failure, once the stream state has been cleared
+   */
+  void ClearFailed (void);
+
+private:
+  /** The writer thread body. */
+  void Run (void);
+
+  static const uint32_t MAX_PENDING = 4;      //!< chunks queued before Submit () blocks
+  static const uint64_t WAIT_NS = 5000000;    //!< upper bound on a single condition wait
+
+  std::fstream *m_file;                       //!< file stream
+  Ptr<SystemThread> m_thread;                 //!< writer thread
+  SystemMutex m_mutex;                        //!< protects the fields below
+  std::deque<std::vector<uint8_t> > m_pending; //!< chunks waiting to be written
+  std::vector<std::vector<uint8_t> > m_free;  //!< written chunks available for reuse
+  bool m_busy;                                //!< writer is writing a chunk
+  bool m_stop;                                //!< writer should exit once idle
+  bool m_failed;                              //!< writing a chunk failed
+  SystemCondition m_ready;                    //!< signalled when a chunk is queued
+  SystemCondition m_done;                     //!< signalled when a chunk is written
+};
+
+PcapFile::AsyncWriter::AsyncWriter (std::fstream *file)
+  : m_file (file),
+    m_busy (false),
+    m_stop (false),
+    m_failed (false)
+{
+  m_thread = Create<SystemThread> (MakeCallback (&PcapFile::AsyncWriter::Run, this));
+  m_thread->Start ();
+}
+
+PcapFile::AsyncWriter::~AsyncWriter ()
+{
+  {
+    CriticalSection cs (m_mutex);
+    m_stop = true;
+  }
+  m_ready.SetCondition (true);
+  m_ready.Signal ();
+  m_thread->Join ();
+}
+
+bool
+PcapFile::AsyncWriter::Submit (std::vector<uint8_t> &chunk, uint32_t used)
+{
+  std::vector<uint8_t> next;
+  bool failed;
+  while (true)
+    {
+      m_done.SetCondition (false);
+      {
+        CriticalSection cs (m_mutex);
+        if (m_pending.size () < MAX_PENDING)
+          {
+            uint32_t capacity = chunk.size ();
+            chunk.resize (used);
+            m_pending.push_back (std::vector<uint8_t> ());
+            m_pending.back ().swap (chunk);
+            if (!m_free.empty ())
+              {
+                next.swap (m_free.back ());
+                m_free.pop_back ();
+              }
+            next.resize (capacity);
+            failed = m_failed;
+            break;
+          }
+      }
+      m_done.TimedWait (WAIT_NS);
+    }
+  chunk.swap (next);
+  m_ready.SetCondition (true);
+  m_ready.Signal ();
+  return failed;
+}
+
+void
+PcapFile::AsyncWriter::Drain (void)
+{
+  while (true)
+    {
+      m_done.SetCondition (false);
+      {
+        CriticalSection cs (m_mutex);
+        if (m_pending.empty () && !m_busy)
+          {
+            return;
+          }
+      }
+      m_done.TimedWait (WAIT_NS);
+    }
+}
+
+bool
+PcapFile::AsyncWriter::Failed (void)
+{
+  CriticalSection cs (m_mutex);
+  return m_failed;
+}
+
+void
+PcapFile::AsyncWriter::ClearFailed (void)
+{
+  CriticalSection cs (m_mutex);
+  m_failed = false;
+}
+
+void
+PcapFile::AsyncWriter::Run (void)
+{
+  std::vector<uint8_t> chunk;
+  bool writeFailed = false;
+  while (true)
+    {
+      m_ready.SetCondition (false);
+      bool recycled = false;
+      bool stop = false;
+      {
+        CriticalSection cs (m_mutex);
+        m_failed = m_failed || writeFailed;
+        if (m_busy)
+          {
+            m_free.push_back (std::vector<uint8_t> ());
+            m_free.back ().swap (chunk);
+            m_busy = false;
+            recycled = true;
+          }
+        if (!m_pending.empty ())
+          {
+            chunk.swap (m_pending.front ());
+            m_pending.pop_front ();
+            m_busy = true;
+          }
+        stop = m_stop && !m_busy;
+      }
+      if (recycled || !m_busy)
+        {
+          m_done.SetCondition (true);
+          m_done.Signal ();
+        }
+      if (m_busy)
+        {
+          m_file->write ((const char *)&chunk[0], chunk.size ());
+          writeFailed = m_file->fail ();
+        }
+      else if (stop)
+        {
+          break;
+        }
+      else
+        {
+          m_ready.TimedWait (WAIT_NS);
+        }
+    }
+}
+
+#endif /* HAVE_PTHREAD_H */
+
+/**
+ * \brief Stream registered with FatalImpl in place of the file stream
+ *
+ * Being its own stream buffer, flushing it on a fatal error calls Flush (),
+ * which writes out the buffered records and waits for the background
+ * writer to be idle before flushing the file stream: the file stream
+ * itself is never flushed while the writer thread may be writing to it.
+ */
+class PcapFile::FatalStream : public std::streambuf, public std::ostream
+{
+public:
+  /**
+   * \param file the pcap file flushed with this stream
+   */
+  FatalStream (PcapFile *file)
+    : std::ostream (this),
+      m_file (file)
+  {
+  }
+
+protected:
+  virtual int sync (void)
+  {
+    m_file->Flush ();
+    return 0;
+  }
+
+private:
+  PcapFile *m_file; //!< pcap file
+};
+
 PcapFile::PcapFile ()
   : m_file (),
     m_swapMode (false),
-    m_nanosecMode (false)
+    m_nanosecMode (false),
+    m_bufferSize (0),
+    m_chunkUsed (0),
+    m_asyncWriter (0),
+    m_writeFailed (false),
+    m_fatalStream (new FatalStream (this))
 {
   NS_LOG_FUNCTION (this);
-  FatalImpl::RegisterStream (&m_file); 
+  // The records buffered, and the file stream while the background writer
+  // uses it, are only safe to flush through Flush ()
+  FatalImpl::RegisterStream (m_fatalStream);
 }
 
 PcapFile::~PcapFile ()
 {
   NS_LOG_FUNCTION (this);
-  FatalImpl::UnregisterStream (&m_file);
+  FatalImpl::UnregisterStream (m_fatalStream);
   Close ();
+  delete m_fatalStream;
 }
 
 
@@ -68,18 +319,40 @@ bool
 PcapFile::Fail (void) const
 {
   NS_LOG_FUNCTION (this);
+#ifdef HAVE_PTHREAD_H
+  if (m_asyncWriter)
+    {
+      // The stream belongs to the writer thread
+      return m_asyncWriter->Failed ();
+    }
+#endif
   return m_file.fail ();
 }
 bool 
 PcapFile::Eof (void) const
 {
   NS_LOG_FUNCTION (this);
+#ifdef HAVE_PTHREAD_H
+  if (m_asyncWriter)
+    {
+      // Only written to by the writer thread
+      return false;
+    }
+#endif
   return m_file.eof ();
 }
 void 
 PcapFile::Clear (void)
 {
   NS_LOG_FUNCTION (this);
+#ifdef HAVE_PTHREAD_H
+  if (m_asyncWriter)
+    {
+      m_asyncWriter->Drain ();
+      m_asyncWriter->ClearFailed ();
+    }
+#endif
+  m_writeFailed = false;
   m_file.clear ();
 }
 
@@ -88,9 +361,76 @@ void
 PcapFile::Close (void)
 {
   NS_LOG_FUNCTION (this);
+  if (m_bufferSize > 0)
+    {
+      SetWriteBuffer (0);
+    }
   m_file.close ();
 }
 
+void
+PcapFile::SetWriteBuffer (uint32_t bufferSize, bool asyncFlush)
+{
+  NS_LOG_FUNCTION (this << bufferSize << asyncFlush);
+  Flush ();
+#ifdef HAVE_PTHREAD_H
+  delete m_asyncWriter;
+  m_asyncWriter = 0;
+  if (bufferSize > 0 && asyncFlush)
+    {
+      m_asyncWriter = new AsyncWriter (&m_file);
+    }
+#else
+  if (asyncFlush)
+    {
+      NS_LOG_WARN ("No threading support; pcap write buffer is flushed synchronously");
+    }
+#endif
+  m_bufferSize = bufferSize;
+  m_writeFailed = false;
+  std::vector<uint8_t> chunk (bufferSize);
+  m_chunk.swap (chunk);
+  m_chunkUsed = 0;
+}
+
+void
+PcapFile::Flush (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_chunkUsed > 0)
+    {
+      SubmitChunk ();
+    }
+#ifdef HAVE_PTHREAD_H
+  if (m_asyncWriter)
+    {
+      // Once drained, the writer thread leaves the stream alone
+      m_asyncWriter->Drain ();
+    }
+#endif
+  if (m_file.is_open ())
+    {
+      m_file.flush ();
+    }
+}
+
+void
+PcapFile::SubmitChunk (void)
+{
+  NS_LOG_FUNCTION (this);
+#ifdef HAVE_PTHREAD_H
+  if (m_asyncWriter)
+    {
+      m_writeFailed = m_asyncWriter->Submit (m_chunk, m_chunkUsed) || m_writeFailed;
+      m_chunkUsed = 0;
+      return;
+    }
+#endif
+  m_file.write ((const char *)&m_chunk[0], m_chunkUsed);
+  m_writeFailed = m_file.fail ();
+  m_chunkUsed = 0;
+}
+
 uint32_t
 PcapFile::GetMagic (void)
 {
@@ -326,6 +666,11 @@ PcapFile::Open (std::string const &filename, std::ios::openmode mode)
 {
   NS_LOG_FUNCTION (this << filename << mode);
   NS_ASSERT ((mode & std::ios::app) == 0);
+  if (m_bufferSize > 0)
+    {
+      // Stop the writer thread before the stream is reused
+      SetWriteBuffer (0);
+    }
   NS_ASSERT (!m_file.fail ());
   //
   // All pcap files are binary files, so we just do this automatically.
@@ -346,6 +691,14 @@ PcapFile::Init (uint32_t dataLinkType, uint32_t snapLen, int32_t timeZoneCorrect
 {
   NS_LOG_FUNCTION (this << dataLinkType << snapLen << timeZoneCorrection << swapMode);
 
+#ifdef HAVE_PTHREAD_H
+  if (m_asyncWriter)
+    {
+      // The file header is written by this thread
+      m_asyncWriter->Drain ();
+    }
+#endif
+
   //
   // Initialize the magic number and nanosecond mode flag
   //
@@ -403,6 +756,8 @@ uint32_t
 PcapFile::WritePacketHeader (uint32_t tsSec, uint32_t tsUsec, uint32_t totalLen)
 {
   NS_LOG_FUNCTION (this << tsSec << tsUsec << totalLen);
+  // Unbuffered records are written directly, never with a writer thread
+  NS_ASSERT (m_bufferSize == 0 && m_asyncWriter == 0);
   NS_ASSERT (m_file.good ());
 
   uint32_t inclLen = totalLen > m_fileHeader.m_snapLen ? m_fileHeader.m_snapLen : totalLen;
@@ -430,10 +785,60 @@ PcapFile::WritePacketHeader (uint32_t tsSec, uint32_t tsUsec, uint32_t totalLen)
   return inclLen;
 }
 
+uint8_t *
+PcapFile::ReserveRecord (uint32_t tsSec, uint32_t tsUsec, uint32_t totalLen, uint32_t &inclLen)
+{
+  NS_LOG_FUNCTION (this << tsSec << tsUsec << totalLen);
+  // The stream may be in use by the writer thread: check the failures
+  // reported by the chunks submitted instead
+  NS_ASSERT (!m_writeFailed);
+
+  inclLen = totalLen > m_fileHeader.m_snapLen ? m_fileHeader.m_snapLen : totalLen;
+  uint32_t needed = RECORD_HEADER_SIZE + inclLen;
+  if (m_chunkUsed + needed > m_chunk.size ())
+    {
+      if (m_chunkUsed > 0)
+        {
+          SubmitChunk ();
+        }
+      if (needed > m_chunk.size ())
+        {
+          // A single record larger than the configured chunk size.
+          m_chunk.resize (needed);
+        }
+    }
+
+  PcapRecordHeader header;
+  header.m_tsSec = tsSec;
+  header.m_tsUsec = tsUsec;
+  header.m_inclLen = inclLen;
+  header.m_origLen = totalLen;
+
+  if (m_swapMode)
+    {
+      Swap (&header, &header);
+    }
+
+  uint8_t *start = &m_chunk[m_chunkUsed];
+  memcpy (start, &header.m_tsSec, sizeof(header.m_tsSec));
+  memcpy (start + 4, &header.m_tsUsec, sizeof(header.m_tsUsec));
+  memcpy (start + 8, &header.m_inclLen, sizeof(header.m_inclLen));
+  memcpy (start + 12, &header.m_origLen, sizeof(header.m_origLen));
+  m_chunkUsed += needed;
+  return start + RECORD_HEADER_SIZE;
+}
+
 void
 PcapFile::Write (uint32_t tsSec, uint32_t tsUsec, uint8_t const * const data, uint32_t totalLen)
 {
   NS_LOG_FUNCTION (this << tsSec << tsUsec << &data << totalLen);
+  if (m_bufferSize > 0)
+    {
+      uint32_t inclLen;
+      uint8_t *payload = ReserveRecord (tsSec, tsUsec, totalLen, inclLen);
+      memcpy (payload, data, inclLen);
+      return;
+    }
   uint32_t inclLen = WritePacketHeader (tsSec, tsUsec, totalLen);
   m_file.write ((const char *)data, inclLen);
   NS_BUILD_DEBUG(m_file.flush());
@@ -443,6 +848,14 @@ void
 PcapFile::Write (uint32_t tsSec, uint32_t tsUsec, Ptr<const Packet> p)
 {
   NS_LOG_FUNCTION (this << tsSec << tsUsec << p);
+  if (m_bufferSize > 0)
+    {
+      // Only the bytes that fit in the snap length are copied out of the packet.
+      uint32_t inclLen;
+      uint8_t *payload = ReserveRecord (tsSec, tsUsec, p->GetSize (), inclLen);
+      p->CopyData (payload, inclLen);
+      return;
+    }
   uint32_t inclLen = WritePacketHeader (tsSec, tsUsec, p->GetSize ());
   p->CopyData (&m_file, inclLen);
   NS_BUILD_DEBUG(m_file.flush());
@@ -454,11 +867,22 @@ PcapFile::Write (uint32_t tsSec, uint32_t tsUsec, const Header &header, Ptr<cons
   NS_LOG_FUNCTION (this << tsSec << tsUsec << &header << p);
   uint32_t headerSize = header.GetSerializedSize ();
   uint32_t totalSize = headerSize + p->GetSize ();
-  uint32_t inclLen = WritePacketHeader (tsSec, tsUsec, totalSize);
 
   Buffer headerBuffer;
   headerBuffer.AddAtStart (headerSize);
   header.Serialize (headerBuffer.Begin ());
+
+  if (m_bufferSize > 0)
+    {
+      uint32_t inclLen;
+      uint8_t *payload = ReserveRecord (tsSec, tsUsec, totalSize, inclLen);
+      uint32_t toCopy = std::min (headerSize, inclLen);
+      headerBuffer.CopyData (payload, toCopy);
+      p->CopyData (payload + toCopy, inclLen - toCopy);
+      return;
+    }
+
+  uint32_t inclLen = WritePacketHeader (tsSec, tsUsec, totalSize);
   uint32_t toCopy = std::min (headerSize, inclLen);
   headerBuffer.CopyData (&m_file, toCopy);
   inclLen -= toCopy;
@@ -476,6 +900,7 @@ PcapFile::Read (
   uint32_t &readLen)
 {
   NS_LOG_FUNCTION (this << &data <<maxBytes << tsSec << tsUsec << inclLen << origLen << readLen);
+  NS_ASSERT (m_asyncWriter == 0);
   NS_ASSERT (m_file.good ());
 
   PcapRecordHeader header;
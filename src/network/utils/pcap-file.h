@@ -23,6 +23,7 @@
 
 #include <string>
 #include <fstream>
+#include <vector>
 #include <stdint.h>
 #include "ns3/ptr.h"
 
@@ -82,9 +83,40 @@ public:
 
   /**
    * Close the underlying file.
+   *
+   * Any records held in the write buffer are written out first and
+   * buffering is disabled; call SetWriteBuffer () again after reopening.
    */
   void Close (void);
 
+  /**
+   * \brief Enable buffered writing of packet records.
+   *
+   * By default every record is written to the underlying stream as soon as
+   * it is passed to Write ().  When buffering is enabled, records are
+   * serialized (and truncated to the snap length) into an in-memory chunk
+   * of \p bufferSize bytes, and the chunk is written to the file in a
+   * single operation when it fills up, on Flush () or on Close ().
+   *
+   * If \p asyncFlush is true, full chunks are queued to a background thread
+   * that owns the file I/O, so the caller only pays for the memory copy.
+   * A small ring of chunks is kept in flight; the caller blocks only if
+   * the writer thread falls behind by more than the whole ring.  If the
+   * build has no threading support, chunks are written synchronously.
+   *
+   * \param bufferSize Size of each chunk in bytes; zero disables buffering.
+   * \param asyncFlush Whether full chunks are written by a background thread.
+   */
+  void SetWriteBuffer (uint32_t bufferSize, bool asyncFlush = false);
+
+  /**
+   * \brief Write any buffered records to the underlying file.
+   *
+   * Returns once all of the data handed to Write () so far has been passed
+   * to the file stream, including chunks queued to the background writer.
+   */
+  void Flush (void);
+
   /**
    * Initialize the pcap file associated with this object.  This file must have
    * been previously opened with write permissions.
@@ -366,11 +398,39 @@ private:
    */
   void ReadAndVerifyFileHeader (void);
 
+  /**
+   * \brief Reserve room for a record in the write buffer
+   *
+   * Serializes the record header into the current chunk, handing the chunk
+   * off first if the record does not fit.
+   *
+   * \param tsSec Time stamp (seconds part)
+   * \param tsUsec Time stamp (microseconds part)
+   * \param totalLen total packet length
+   * \param inclLen [out] the number of packet bytes to copy into the record
+   * \returns a pointer to where the inclLen packet bytes must be copied
+   */
+  uint8_t * ReserveRecord (uint32_t tsSec, uint32_t tsUsec, uint32_t totalLen, uint32_t &inclLen);
+
+  /**
+   * \brief Hand the current chunk to the file, or to the background writer
+   */
+  void SubmitChunk (void);
+
+  class AsyncWriter;
+  class FatalStream;
+
   std::string    m_filename;    //!< file name
   std::fstream   m_file;        //!< file stream
   PcapFileHeader m_fileHeader;  //!< file header
   bool m_swapMode;              //!< swap mode
   bool m_nanosecMode;           //!< nanosecond timestamp mode
+  uint32_t m_bufferSize;        //!< write buffer chunk size, zero if unbuffered
+  std::vector<uint8_t> m_chunk; //!< chunk currently being filled
+  uint32_t m_chunkUsed;         //!< number of bytes used in m_chunk
+  AsyncWriter *m_asyncWriter;   //!< background writer, if any
+  bool m_writeFailed;           //!< writing a submitted chunk failed
+  FatalStream *m_fatalStream;   //!< stream flushing this file on fatal errors
 };
 
 } // namespace ns3
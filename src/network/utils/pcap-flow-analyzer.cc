@@ -0,0 +1,719 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include "crc32.h"
+#include "ipv4-address.h"
+#include "pcap-flow-analyzer.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("PcapFlowAnalyzer");
+
+namespace {
+
+/// Data link types (see the pcap-linktype man page).
+enum
+{
+  DLT_NULL = 0,
+  DLT_EN10MB = 1,
+  DLT_PPP = 9,
+  DLT_RAW = 101,
+  DLT_LINUX_SLL = 113,
+  DLT_IPV4 = 228
+};
+
+/// IP protocol numbers.
+enum
+{
+  PROTO_TCP = 6,
+  PROTO_UDP = 17
+};
+
+/// TCP flags.
+enum
+{
+  TCP_FIN = 0x01,
+  TCP_SYN = 0x02,
+  TCP_ACK = 0x10
+};
+
+/**
+ * \param p pointer to two bytes in network byte order
+ * \return the host order value
+ */
+inline uint16_t
+Ntoh16 (const uint8_t *p)
+{
+  return (p[0] << 8) | p[1];
+}
+
+/**
+ * \param p pointer to four bytes in network byte order
+ * \return the host order value
+ */
+inline uint32_t
+Ntoh32 (const uint8_t *p)
+{
+  return (static_cast<uint32_t> (p[0]) << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+/**
+ * \param a a 32 bit sequence number
+ * \param b a 32 bit sequence number
+ * \return the signed distance from b to a
+ */
+inline int32_t
+SeqDiff (uint32_t a, uint32_t b)
+{
+  return static_cast<int32_t> (a - b);
+}
+
+/**
+ * \brief Minimal writer for numpy .npz archives (uncompressed zip of .npy)
+ */
+class NpzWriter
+{
+public:
+  /**
+   * \param filename output file name
+   */
+  NpzWriter (const std::string &filename)
+    : m_file (filename.c_str (), std::ios::out | std::ios::binary | std::ios::trunc),
+      m_offset (0)
+  {
+  }
+
+  /**
+   * \return true if the output file could not be written
+   */
+  bool Fail (void) const
+  {
+    return m_file.fail ();
+  }
+
+  /**
+   * Add a one dimensional array to the archive.
+   * \param name the array name
+   * \param descr the numpy type code, without byte order (e.g. "f8")
+   * \param data the array contents
+   */
+  template <typename T>
+  void Add (const std::string &name, const std::string &descr, const std::vector<T> &data)
+  {
+    union {
+      uint32_t a;
+      uint8_t  b[4];
+    } u;
+    u.a = 1;
+    std::ostringstream dict;
+    dict << "{'descr': '" << (descr[0] == 'u' && descr[1] == '1' ? '|' : (u.b[0] ? '<' : '>')) << descr
+         << "', 'fortran_order': False, 'shape': (" << data.size () << ",), }";
+    std::string header = dict.str ();
+    // Magic (6), version (2) and header length (2) precede the header,
+    // whose end is padded so that the data is 64 byte aligned.
+    uint32_t total = 10 + header.size () + 1;
+    header.append ((64 - total % 64) % 64, ' ');
+    header.push_back ('\n');
+
+    std::string npy ("\x93NUMPY\x01\x00", 8);
+    npy.push_back (static_cast<char> (header.size () & 0xff));
+    npy.push_back (static_cast<char> (header.size () >> 8));
+    npy.append (header);
+    npy.append (reinterpret_cast<const char *> (data.empty () ? 0 : &data[0]), data.size () * sizeof (T));
+    AddEntry (name + ".npy", npy);
+  }
+
+  /**
+   * Write the zip central directory and close the file.
+   */
+  void Close (void)
+  {
+    uint32_t cdStart = m_offset;
+    for (std::vector<Entry>::const_iterator i = m_entries.begin (); i != m_entries.end (); ++i)
+      {
+        Put32 (0x02014b50);
+        Put16 (20);           // version made by
+        Put16 (20);           // version needed
+        Put16 (0);            // flags
+        Put16 (0);            // stored
+        Put16 (0);            // time
+        Put16 (0x21);         // date (1980-01-01)
+        Put32 (i->crc);
+        Put32 (i->size);
+        Put32 (i->size);
+        Put16 (i->name.size ());
+        Put16 (0);            // extra
+        Put16 (0);            // comment
+        Put16 (0);            // disk
+        Put16 (0);            // internal attributes
+        Put32 (0);            // external attributes
+        Put32 (i->offset);
+        PutBytes (i->name.data (), i->name.size ());
+      }
+    uint32_t cdSize = m_offset - cdStart;
+    Put32 (0x06054b50);
+    Put16 (0);
+    Put16 (0);
+    Put16 (m_entries.size ());
+    Put16 (m_entries.size ());
+    Put32 (cdSize);
+    Put32 (cdStart);
+    Put16 (0);
+    m_file.close ();
+  }
+
+private:
+  /// A zip archive member
+  struct Entry
+  {
+    std::string name;   //!< member name
+    uint32_t crc;       //!< CRC-32 of the contents
+    uint32_t size;      //!< size of the contents
+    uint32_t offset;    //!< offset of the local header
+  };
+
+  /**
+   * \param name member name
+   * \param contents member contents
+   */
+  void AddEntry (const std::string &name, const std::string &contents)
+  {
+    Entry e;
+    e.name = name;
+    e.crc = CRC32Calculate (reinterpret_cast<const uint8_t *> (contents.data ()), contents.size ());
+    e.size = contents.size ();
+    e.offset = m_offset;
+    m_entries.push_back (e);
+
+    Put32 (0x04034b50);
+    Put16 (20);
+    Put16 (0);
+    Put16 (0);
+    Put16 (0);
+    Put16 (0x21);
+    Put32 (e.crc);
+    Put32 (e.size);
+    Put32 (e.size);
+    Put16 (name.size ());
+    Put16 (0);
+    PutBytes (name.data (), name.size ());
+    PutBytes (contents.data (), contents.size ());
+  }
+
+  /// \param v little endian value to write
+  void Put16 (uint16_t v)
+  {
+    char b[2] = { static_cast<char> (v & 0xff), static_cast<char> (v >> 8) };
+    PutBytes (b, 2);
+  }
+  /// \param v little endian value to write
+  void Put32 (uint32_t v)
+  {
+    Put16 (v & 0xffff);
+    Put16 (v >> 16);
+  }
+  /**
+   * \param data bytes to write
+   * \param size number of bytes
+   */
+  void PutBytes (const char *data, uint32_t size)
+  {
+    m_file.write (data, size);
+    m_offset += size;
+  }
+
+  std::ofstream m_file;           //!< output file
+  uint32_t m_offset;              //!< current output offset
+  std::vector<Entry> m_entries;   //!< members written so far
+};
+
+} // unnamed namespace
+
+struct PcapFlowAnalyzer::Decoded
+{
+  uint32_t srcIp;       //!< Source address
+  uint32_t dstIp;       //!< Destination address
+  uint16_t srcPort;     //!< Source port
+  uint16_t dstPort;     //!< Destination port
+  uint8_t proto;        //!< IP protocol
+  uint32_t payload;     //!< Transport payload length, from the IP header
+  uint32_t seq;         //!< TCP sequence number
+  uint8_t flags;        //!< TCP flags
+  bool hasTs;           //!< TCP timestamp option present
+  uint32_t tsVal;       //!< TCP timestamp value
+  uint32_t tsEcr;       //!< TCP timestamp echo reply
+};
+
+bool
+PcapFlowAnalyzer::FlowKey::operator< (const FlowKey &o) const
+{
+  if (srcIp != o.srcIp)
+    {
+      return srcIp < o.srcIp;
+    }
+  if (dstIp != o.dstIp)
+    {
+      return dstIp < o.dstIp;
+    }
+  if (srcPort != o.srcPort)
+    {
+      return srcPort < o.srcPort;
+    }
+  if (dstPort != o.dstPort)
+    {
+      return dstPort < o.dstPort;
+    }
+  return proto < o.proto;
+}
+
+PcapFlowAnalyzer::PcapFlowAnalyzer (uint64_t stepNs, uint32_t windowSteps)
+  : m_stepNs (stepNs),
+    m_windowSteps (windowSteps),
+    m_originNs (0),
+    m_packets (0),
+    m_skipped (0)
+{
+  NS_LOG_FUNCTION (this << stepNs << windowSteps);
+}
+
+void
+PcapFlowAnalyzer::Run (PcapMmapReader &reader)
+{
+  PcapMmapReader::Record r;
+  Decoded d;
+  while (reader.Next (r))
+    {
+      if (m_packets == 0)
+        {
+          // Throughput bins are relative to the start of the capture, so
+          // that captures with wall clock timestamps stay compact.
+          m_originNs = r.tsNs - r.tsNs % m_stepNs;
+        }
+      ++m_packets;
+      if (!Decode (r, d))
+        {
+          ++m_skipped;
+          continue;
+        }
+      Process (r.tsNs, d);
+    }
+}
+
+bool
+PcapFlowAnalyzer::Write (const std::string &filename) const
+{
+  NpzWriter npz (filename);
+  if (npz.Fail ())
+    {
+      return false;
+    }
+
+  std::vector<uint32_t> srcIp, dstIp;
+  std::vector<uint16_t> srcPort, dstPort;
+  std::vector<uint8_t> proto;
+  std::vector<uint64_t> packets, bytes, lostBytes, retransmits;
+  std::vector<double> first, last;
+  for (std::vector<Flow>::const_iterator f = m_flows.begin (); f != m_flows.end (); ++f)
+    {
+      srcIp.push_back (f->key.srcIp);
+      dstIp.push_back (f->key.dstIp);
+      srcPort.push_back (f->key.srcPort);
+      dstPort.push_back (f->key.dstPort);
+      proto.push_back (f->key.proto);
+      packets.push_back (f->packets);
+      bytes.push_back (f->bytes);
+      lostBytes.push_back (f->lostBytes);
+      retransmits.push_back (f->retransmits);
+      first.push_back (f->firstNs / 1e9);
+      last.push_back (f->lastNs / 1e9);
+    }
+  npz.Add ("flow_src_ip", "u4", srcIp);
+  npz.Add ("flow_dst_ip", "u4", dstIp);
+  npz.Add ("flow_src_port", "u2", srcPort);
+  npz.Add ("flow_dst_port", "u2", dstPort);
+  npz.Add ("flow_proto", "u1", proto);
+  npz.Add ("flow_packets", "u8", packets);
+  npz.Add ("flow_bytes", "u8", bytes);
+  npz.Add ("flow_lost_bytes", "u8", lostBytes);
+  npz.Add ("flow_retransmits", "u8", retransmits);
+  npz.Add ("flow_first_s", "f8", first);
+  npz.Add ("flow_last_s", "f8", last);
+
+  std::vector<uint32_t> tputFlow;
+  std::vector<double> tputTime, tputBps;
+  double windowS = m_windowSteps * m_stepNs / 1e9;
+  for (uint32_t id = 0; id < m_flows.size (); ++id)
+    {
+      const std::vector<uint64_t> &bins = m_flows[id].bins;
+      uint64_t sum = 0;
+      uint64_t firstBin = (m_flows[id].firstNs - m_originNs) / m_stepNs;
+      for (uint32_t i = 0; i < bins.size (); ++i)
+        {
+          sum += bins[i];
+          if (i >= m_windowSteps)
+            {
+              sum -= bins[i - m_windowSteps];
+            }
+          if (i < firstBin)
+            {
+              continue;
+            }
+          tputFlow.push_back (id);
+          tputTime.push_back ((m_originNs + (i + 1) * m_stepNs) / 1e9);
+          tputBps.push_back (sum * 8 / windowS);
+        }
+    }
+  npz.Add ("tput_flow", "u4", tputFlow);
+  npz.Add ("tput_time_s", "f8", tputTime);
+  npz.Add ("tput_bps", "f8", tputBps);
+
+  npz.Add ("rtt_flow", "u4", m_rttFlow);
+  npz.Add ("rtt_time_s", "f8", m_rttTime);
+  npz.Add ("rtt_us", "f8", m_rttUs);
+
+  npz.Add ("loss_flow", "u4", m_lossFlow);
+  npz.Add ("loss_time_s", "f8", m_lossTime);
+  npz.Add ("loss_bytes", "u4", m_lossBytes);
+
+  npz.Close ();
+  return true;
+}
+
+void
+PcapFlowAnalyzer::Print (std::ostream &os) const
+{
+  os << m_packets << " packets, " << m_skipped << " not IPv4 TCP/UDP, "
+     << m_flows.size () << " flows" << std::endl;
+  for (uint32_t id = 0; id < m_flows.size (); ++id)
+    {
+      const Flow &f = m_flows[id];
+      double durS = (f.lastNs - f.firstNs) / 1e9;
+      os << "  " << id << ": " << Ipv4Address (f.key.srcIp) << ":" << f.key.srcPort
+         << " -> " << Ipv4Address (f.key.dstIp) << ":" << f.key.dstPort
+         << " proto " << static_cast<uint32_t> (f.key.proto)
+         << ", " << f.packets << " packets, " << f.bytes << " bytes";
+      if (durS > 0)
+        {
+          os << ", " << f.bytes * 8 / durS / 1e6 << " Mb/s";
+        }
+      if (f.lostBytes > 0 || f.retransmits > 0)
+        {
+          os << ", " << f.lostBytes << " bytes lost, " << f.retransmits << " retransmits";
+        }
+      os << std::endl;
+    }
+}
+
+uint64_t
+PcapFlowAnalyzer::GetNPackets (void) const
+{
+  return m_packets;
+}
+
+uint64_t
+PcapFlowAnalyzer::GetNSkipped (void) const
+{
+  return m_skipped;
+}
+
+uint32_t
+PcapFlowAnalyzer::GetNFlows (void) const
+{
+  return m_flows.size ();
+}
+
+const PcapFlowAnalyzer::Flow &
+PcapFlowAnalyzer::GetFlow (uint32_t id) const
+{
+  NS_ASSERT (id < m_flows.size ());
+  return m_flows[id];
+}
+
+std::vector<double>
+PcapFlowAnalyzer::GetRttSamples (uint32_t id) const
+{
+  std::vector<double> samples;
+  for (uint32_t i = 0; i < m_rttFlow.size (); ++i)
+    {
+      if (m_rttFlow[i] == id)
+        {
+          samples.push_back (m_rttUs[i]);
+        }
+    }
+  return samples;
+}
+
+bool
+PcapFlowAnalyzer::Decode (const PcapMmapReader::Record &r, Decoded &d)
+{
+  const uint8_t *p = r.data;
+  uint32_t len = r.inclLen;
+  uint32_t off;
+  switch (r.dataLinkType)
+    {
+    case DLT_PPP:
+      if (len >= 4 && p[0] == 0xff && p[1] == 0x03)
+        {
+          p += 2;
+          len -= 2;
+        }
+      if (len < 2 || Ntoh16 (p) != 0x0021)
+        {
+          return false;
+        }
+      off = 2;
+      break;
+    case DLT_EN10MB:
+      {
+        if (len < 14)
+          {
+            return false;
+          }
+        uint16_t etherType = Ntoh16 (p + 12);
+        off = 14;
+        while (etherType == 0x8100 && len >= off + 4)
+          {
+            etherType = Ntoh16 (p + off + 2);
+            off += 4;
+          }
+        if (etherType != 0x0800)
+          {
+            return false;
+          }
+        break;
+      }
+    case DLT_LINUX_SLL:
+      if (len < 16 || Ntoh16 (p + 14) != 0x0800)
+        {
+          return false;
+        }
+      off = 16;
+      break;
+    case DLT_NULL:
+      off = 4;
+      break;
+    case DLT_RAW:
+    case DLT_IPV4:
+      off = 0;
+      break;
+    default:
+      return false;
+    }
+  if (len < off + 20)
+    {
+      return false;
+    }
+  p += off;
+  len -= off;
+  if ((p[0] >> 4) != 4)
+    {
+      return false;
+    }
+  uint32_t ihl = (p[0] & 0x0f) * 4;
+  uint32_t totalLen = Ntoh16 (p + 2);
+  if ((Ntoh16 (p + 6) & 0x1fff) != 0)
+    {
+      // Non-first fragment: no transport header.
+      return false;
+    }
+  d.proto = p[9];
+  d.srcIp = Ntoh32 (p + 12);
+  d.dstIp = Ntoh32 (p + 16);
+  if (ihl < 20 || totalLen < ihl || len < ihl + 8)
+    {
+      return false;
+    }
+  const uint8_t *t = p + ihl;
+  uint32_t tlen = len - ihl;
+  d.srcPort = Ntoh16 (t);
+  d.dstPort = Ntoh16 (t + 2);
+  d.hasTs = false;
+  d.tsVal = 0;
+  d.tsEcr = 0;
+  d.seq = 0;
+  d.flags = 0;
+  if (d.proto == PROTO_UDP)
+    {
+      d.payload = totalLen - ihl >= 8 ? totalLen - ihl - 8 : 0;
+      return true;
+    }
+  if (d.proto != PROTO_TCP || tlen < 20)
+    {
+      return false;
+    }
+  d.seq = Ntoh32 (t + 4);
+  uint32_t dataOffset = (t[12] >> 4) * 4;
+  d.flags = t[13];
+  d.payload = totalLen - ihl >= dataOffset ? totalLen - ihl - dataOffset : 0;
+  // Options, as far as they were captured.
+  uint32_t optEnd = std::min (dataOffset, tlen);
+  uint32_t o = 20;
+  while (o < optEnd)
+    {
+      uint8_t kind = t[o];
+      if (kind == 0)
+        {
+          break;
+        }
+      if (kind == 1)
+        {
+          ++o;
+          continue;
+        }
+      if (o + 1 >= optEnd || t[o + 1] < 2)
+        {
+          break;
+        }
+      uint8_t optLen = t[o + 1];
+      if (kind == 8 && optLen == 10 && o + 10 <= optEnd)
+        {
+          d.hasTs = true;
+          d.tsVal = Ntoh32 (t + o + 2);
+          d.tsEcr = Ntoh32 (t + o + 6);
+        }
+      o += optLen;
+    }
+  return true;
+}
+
+uint32_t
+PcapFlowAnalyzer::GetFlowId (const FlowKey &key)
+{
+  std::map<FlowKey, uint32_t>::iterator it = m_index.find (key);
+  if (it != m_index.end ())
+    {
+      return it->second;
+    }
+  uint32_t id = m_flows.size ();
+  m_index.insert (std::make_pair (key, id));
+  m_flows.push_back (Flow ());
+  Flow &f = m_flows.back ();
+  f.key = key;
+  f.packets = 0;
+  f.bytes = 0;
+  f.firstNs = 0;
+  f.lastNs = 0;
+  f.seqValid = false;
+  f.nextSeq = 0;
+  f.lostBytes = 0;
+  f.retransmits = 0;
+  return id;
+}
+
+void
+PcapFlowAnalyzer::Process (uint64_t tsNs, const Decoded &d)
+{
+  FlowKey key;
+  key.srcIp = d.srcIp;
+  key.dstIp = d.dstIp;
+  key.srcPort = d.srcPort;
+  key.dstPort = d.dstPort;
+  key.proto = d.proto;
+  uint32_t id = GetFlowId (key);
+  Flow &f = m_flows[id];
+  if (f.packets == 0)
+    {
+      f.firstNs = tsNs;
+    }
+  ++f.packets;
+  f.bytes += d.payload;
+  f.lastNs = tsNs;
+
+  uint64_t bin = tsNs >= m_originNs ? (tsNs - m_originNs) / m_stepNs : 0;
+  if (bin >= f.bins.size ())
+    {
+      f.bins.resize (bin + 1, 0);
+    }
+  f.bins[bin] += d.payload;
+
+  if (d.proto != PROTO_TCP)
+    {
+      return;
+    }
+
+  uint32_t segLen = d.payload + ((d.flags & TCP_SYN) ? 1 : 0) + ((d.flags & TCP_FIN) ? 1 : 0);
+  if (segLen > 0)
+    {
+      uint32_t end = d.seq + segLen;
+      if (!f.seqValid || (d.flags & TCP_SYN))
+        {
+          f.seqValid = true;
+          f.nextSeq = end;
+        }
+      else if (SeqDiff (d.seq, f.nextSeq) > 0)
+        {
+          uint32_t gap = d.seq - f.nextSeq;
+          f.lostBytes += gap;
+          m_lossFlow.push_back (id);
+          m_lossTime.push_back (tsNs / 1e9);
+          m_lossBytes.push_back (gap);
+          f.nextSeq = end;
+        }
+      else if (SeqDiff (end, f.nextSeq) <= 0)
+        {
+          ++f.retransmits;
+        }
+      else
+        {
+          f.nextSeq = end;
+        }
+
+    }
+
+  if (d.hasTs)
+    {
+      // Only the first packet carrying a given TSval gives an
+      // unambiguous sample.
+      f.tsSent.insert (std::make_pair (d.tsVal, tsNs));
+      if (f.tsSent.size () > MAX_OUTSTANDING_TS)
+        {
+          // The reverse direction is not in the capture.
+          f.tsSent.erase (f.tsSent.begin ());
+        }
+    }
+
+  if ((d.flags & TCP_ACK) && d.hasTs)
+    {
+      FlowKey reverse;
+      reverse.srcIp = d.dstIp;
+      reverse.dstIp = d.srcIp;
+      reverse.srcPort = d.dstPort;
+      reverse.dstPort = d.srcPort;
+      reverse.proto = d.proto;
+      std::map<FlowKey, uint32_t>::iterator it = m_index.find (reverse);
+      if (it == m_index.end ())
+        {
+          return;
+        }
+      Flow &data = m_flows[it->second];
+      std::map<uint32_t, uint64_t>::iterator sent = data.tsSent.find (d.tsEcr);
+      if (sent != data.tsSent.end ())
+        {
+          m_rttFlow.push_back (it->second);
+          m_rttTime.push_back (tsNs / 1e9);
+          m_rttUs.push_back ((tsNs - sent->second) / 1e3);
+        }
+      // Every TSval up to the one echoed has now been acknowledged.
+      data.tsSent.erase (data.tsSent.begin (), data.tsSent.upper_bound (d.tsEcr));
+    }
+}
+
+} // namespace ns3
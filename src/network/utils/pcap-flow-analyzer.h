@@ -0,0 +1,180 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PCAP_FLOW_ANALYZER_H
+#define PCAP_FLOW_ANALYZER_H
+
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "pcap-mmap-reader.h"
+
+namespace ns3 {
+
+/**
+ * \brief Per-flow statistics of a pcap or pcapng capture
+ *
+ * Computes, for every IPv4 5-tuple flow of a capture read with
+ * PcapMmapReader:
+ *
+ * - the number of packets and transport payload bytes, the time of the
+ *   first and last packet, the bytes missing from TCP sequence gaps
+ *   (lost upstream of the capture point) and the retransmitted segments;
+ * - the throughput over a sliding window, sampled every step;
+ * - RTT samples from TCP timestamps: the first packet carrying a TSval is
+ *   matched with the first reverse-direction packet echoing it, so a
+ *   sample of a flow measures the time from the capture point to the far
+ *   end of the flow and back.
+ *
+ * Write () stores the results as a numpy .npz archive; see
+ * utils/pcap-flow-analyzer.cc for the names of its arrays.
+ */
+class PcapFlowAnalyzer
+{
+public:
+  /**
+   * \brief Flow identifier
+   */
+  struct FlowKey
+  {
+    uint32_t srcIp;       //!< Source address
+    uint32_t dstIp;       //!< Destination address
+    uint16_t srcPort;     //!< Source port
+    uint16_t dstPort;     //!< Destination port
+    uint8_t proto;        //!< IP protocol
+
+    /**
+     * \param o other key
+     * \return true if this key sorts before o
+     */
+    bool operator< (const FlowKey &o) const;
+  };
+
+  /**
+   * \brief Per-flow analysis state
+   */
+  struct Flow
+  {
+    FlowKey key;                      //!< Flow identifier
+    uint64_t packets;                 //!< Number of packets
+    uint64_t bytes;                   //!< Transport payload bytes
+    uint64_t firstNs;                 //!< Time of the first packet
+    uint64_t lastNs;                  //!< Time of the last packet
+    bool seqValid;                    //!< nextSeq has been initialized
+    uint32_t nextSeq;                 //!< Highest sequence number seen, plus one
+    uint64_t lostBytes;               //!< Bytes missing from sequence gaps
+    uint64_t retransmits;             //!< Segments entirely below nextSeq
+    std::map<uint32_t, uint64_t> tsSent; //!< First time each unechoed TSval was seen
+    std::vector<uint64_t> bins;       //!< Payload bytes per step, from the capture origin
+  };
+
+  /**
+   * \param stepNs throughput bin width, in nanoseconds
+   * \param windowSteps throughput window, in bins
+   */
+  PcapFlowAnalyzer (uint64_t stepNs, uint32_t windowSteps);
+
+  /**
+   * Process every record of a capture.
+   * \param reader the opened capture
+   */
+  void Run (PcapMmapReader &reader);
+
+  /**
+   * Write the results.
+   * \param filename output .npz file name
+   * \return false if the file could not be written
+   */
+  bool Write (const std::string &filename) const;
+
+  /**
+   * Print a per-flow summary.
+   * \param os output stream
+   */
+  void Print (std::ostream &os) const;
+
+  /**
+   * \return the number of records read
+   */
+  uint64_t GetNPackets (void) const;
+  /**
+   * \return the number of records that were not IPv4 TCP or UDP packets
+   */
+  uint64_t GetNSkipped (void) const;
+  /**
+   * \return the number of flows, in order of their first packet
+   */
+  uint32_t GetNFlows (void) const;
+  /**
+   * \param id flow index, smaller than GetNFlows ()
+   * \return the flow
+   */
+  const Flow & GetFlow (uint32_t id) const;
+  /**
+   * \param id flow index, smaller than GetNFlows ()
+   * \return the RTT samples of the flow, in microseconds
+   */
+  std::vector<double> GetRttSamples (uint32_t id) const;
+
+private:
+  /**
+   * \brief The fields of a packet the analysis cares about
+   */
+  struct Decoded;
+
+  /**
+   * Extract the IPv4 and transport fields of a record.
+   * \param r the record
+   * \param d [out] the decoded fields
+   * \return false if the record is not an IPv4 TCP or UDP packet
+   */
+  static bool Decode (const PcapMmapReader::Record &r, Decoded &d);
+
+  /**
+   * \param key flow identifier
+   * \return the index of the flow, creating it if needed
+   */
+  uint32_t GetFlowId (const FlowKey &key);
+
+  /**
+   * Account for one decoded packet.
+   * \param tsNs capture time
+   * \param d decoded packet
+   */
+  void Process (uint64_t tsNs, const Decoded &d);
+
+  static const uint32_t MAX_OUTSTANDING_TS = 65536; //!< Bound on unmatched TSvals per flow
+
+  uint64_t m_stepNs;                       //!< Throughput bin width
+  uint32_t m_windowSteps;                  //!< Throughput window, in bins
+  uint64_t m_originNs;                     //!< Start of the first throughput bin
+  uint64_t m_packets;                      //!< Records read
+  uint64_t m_skipped;                      //!< Records that were not analyzed
+  std::map<FlowKey, uint32_t> m_index;     //!< Flow index by key
+  std::vector<Flow> m_flows;               //!< Flows, by index
+  std::vector<uint32_t> m_rttFlow;         //!< RTT sample flow
+  std::vector<double> m_rttTime;           //!< RTT sample time
+  std::vector<double> m_rttUs;             //!< RTT sample value
+  std::vector<uint32_t> m_lossFlow;        //!< Loss event flow
+  std::vector<double> m_lossTime;          //!< Loss event time
+  std::vector<uint32_t> m_lossBytes;       //!< Loss event size
+};
+
+} // namespace ns3
+
+#endif /* PCAP_FLOW_ANALYZER_H */
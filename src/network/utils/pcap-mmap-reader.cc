@@ -0,0 +1,588 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cstring>
+#include "ns3/core-config.h"
+#ifdef HAVE_SYS_MMAN_H
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#include "ns3/log.h"
+#include "pcap-mmap-reader.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("PcapMmapReader");
+
+namespace {
+
+const uint32_t MAGIC = 0xa1b2c3d4;            /**< Magic number identifying standard pcap file format */
+const uint32_t SWAPPED_MAGIC = 0xd4c3b2a1;    /**< Looks this way if byte swapping is required */
+const uint32_t NS_MAGIC = 0xa1b23c4d;         /**< Magic number identifying nanosec resolution pcap file format */
+const uint32_t NS_SWAPPED_MAGIC = 0x4d3cb2a1; /**< Looks this way if byte swapping is required */
+
+const uint32_t PCAP_FILE_HEADER_SIZE = 24;    /**< Size of the classic pcap file header */
+const uint32_t PCAP_RECORD_HEADER_SIZE = 16;  /**< Size of a classic pcap record header */
+
+const uint32_t PCAPNG_SHB = 0x0a0d0d0a;       /**< Section header block type */
+const uint32_t PCAPNG_IDB = 0x00000001;       /**< Interface description block type */
+const uint32_t PCAPNG_PB = 0x00000002;        /**< Obsolete packet block type */
+const uint32_t PCAPNG_SPB = 0x00000003;       /**< Simple packet block type */
+const uint32_t PCAPNG_EPB = 0x00000006;       /**< Enhanced packet block type */
+const uint32_t PCAPNG_BYTE_ORDER_MAGIC = 0x1a2b3c4d;         /**< Section byte order magic */
+const uint32_t PCAPNG_SWAPPED_BYTE_ORDER_MAGIC = 0x4d3c2b1a; /**< Looks this way if byte swapping is required */
+
+const uint16_t PCAPNG_OPT_ENDOFOPT = 0;       /**< End of options */
+const uint16_t PCAPNG_OPT_IF_TSRESOL = 9;     /**< Interface timestamp resolution option */
+const uint16_t PCAPNG_OPT_IF_TSOFFSET = 14;   /**< Interface timestamp offset option */
+
+/**
+ * \param len a length
+ * \return len rounded up to a multiple of four
+ */
+inline uint32_t
+Pad4 (uint32_t len)
+{
+  return (len + 3) & ~3U;
+}
+
+} // unnamed namespace
+
+PcapMmapReader::PcapMmapReader ()
+  : m_data (0),
+    m_size (0),
+    m_offset (0),
+    m_first (0),
+    m_fail (false),
+    m_eof (false),
+    m_pcapNg (false),
+    m_swapMode (false),
+    m_nanosecMode (false),
+    m_snapLen (0),
+    m_dataLinkType (0),
+    m_usePcapFile (false)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+PcapMmapReader::~PcapMmapReader ()
+{
+  NS_LOG_FUNCTION (this);
+  Close ();
+}
+
+void
+PcapMmapReader::Open (std::string const &filename)
+{
+  NS_LOG_FUNCTION (this << filename);
+  Close ();
+  m_fail = false;
+  m_eof = false;
+  m_filename = filename;
+
+#ifdef HAVE_SYS_MMAN_H
+  int fd = open (filename.c_str (), O_RDONLY);
+  if (fd < 0)
+    {
+      NS_LOG_WARN ("Unable to open " << filename);
+      SetFail ();
+      return;
+    }
+  struct stat st;
+  if (fstat (fd, &st) != 0 || st.st_size < 4)
+    {
+      NS_LOG_WARN ("Unable to stat " << filename << " or file too short");
+      close (fd);
+      SetFail ();
+      return;
+    }
+  void *addr = mmap (0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close (fd);
+  if (addr == MAP_FAILED)
+    {
+      NS_LOG_WARN ("Unable to map " << filename << ", reading it with PcapFile");
+      OpenPcapFile ();
+      return;
+    }
+#ifdef MADV_SEQUENTIAL
+  madvise (addr, st.st_size, MADV_SEQUENTIAL);
+#endif
+  m_data = static_cast<const uint8_t *> (addr);
+  m_size = st.st_size;
+
+  uint32_t magic;
+  std::memcpy (&magic, m_data, sizeof (magic));
+  if (magic == PCAPNG_SHB)
+    {
+      m_pcapNg = true;
+      m_first = 0;
+      m_offset = 0;
+    }
+  else
+    {
+      m_pcapNg = false;
+      ReadPcapHeader ();
+    }
+#else
+  OpenPcapFile ();
+#endif
+}
+
+void
+PcapMmapReader::OpenPcapFile (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_usePcapFile = true;
+  m_pcapNg = false;
+  m_pcapFile.Open (m_filename, std::ios::in);
+  if (m_pcapFile.Fail ())
+    {
+      NS_LOG_WARN ("Unable to read " << m_filename << " as a pcap file");
+      SetFail ();
+      return;
+    }
+  m_nanosecMode = m_pcapFile.IsNanoSecMode ();
+  m_snapLen = m_pcapFile.GetSnapLen ();
+  m_dataLinkType = m_pcapFile.GetDataLinkType ();
+  m_buffer.resize (m_snapLen);
+}
+
+void
+PcapMmapReader::Close (void)
+{
+  NS_LOG_FUNCTION (this);
+#ifdef HAVE_SYS_MMAN_H
+  if (m_data)
+    {
+      munmap (const_cast<uint8_t *> (m_data), m_size);
+    }
+#endif
+  if (m_usePcapFile)
+    {
+      m_pcapFile.Close ();
+      m_pcapFile.Clear ();
+      m_usePcapFile = false;
+    }
+  m_data = 0;
+  m_size = 0;
+  m_offset = 0;
+  m_first = 0;
+  m_interfaces.clear ();
+}
+
+bool
+PcapMmapReader::Fail (void) const
+{
+  return m_fail;
+}
+
+bool
+PcapMmapReader::Eof (void) const
+{
+  return m_eof;
+}
+
+bool
+PcapMmapReader::IsPcapNg (void) const
+{
+  return m_pcapNg;
+}
+
+uint64_t
+PcapMmapReader::GetSize (void) const
+{
+  return m_size;
+}
+
+void
+PcapMmapReader::Rewind (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_usePcapFile)
+    {
+      m_pcapFile.Close ();
+      m_pcapFile.Clear ();
+      m_fail = false;
+      m_eof = false;
+      OpenPcapFile ();
+      return;
+    }
+  m_offset = m_first;
+  m_eof = false;
+  if (m_pcapNg)
+    {
+      m_interfaces.clear ();
+    }
+}
+
+void
+PcapMmapReader::SetFail (void)
+{
+  m_fail = true;
+}
+
+uint16_t
+PcapMmapReader::Read16 (const uint8_t *p) const
+{
+  uint16_t v;
+  std::memcpy (&v, p, sizeof (v));
+  if (m_swapMode)
+    {
+      v = ((v >> 8) & 0x00ff) | ((v << 8) & 0xff00);
+    }
+  return v;
+}
+
+uint32_t
+PcapMmapReader::Read32 (const uint8_t *p) const
+{
+  uint32_t v;
+  std::memcpy (&v, p, sizeof (v));
+  if (m_swapMode)
+    {
+      v = ((v >> 24) & 0x000000ff) | ((v >> 8) & 0x0000ff00) | ((v << 8) & 0x00ff0000) | ((v << 24) & 0xff000000);
+    }
+  return v;
+}
+
+void
+PcapMmapReader::ReadPcapHeader (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_size < PCAP_FILE_HEADER_SIZE)
+    {
+      SetFail ();
+      return;
+    }
+  uint32_t magic;
+  std::memcpy (&magic, m_data, sizeof (magic));
+  switch (magic)
+    {
+    case MAGIC:
+      m_swapMode = false;
+      m_nanosecMode = false;
+      break;
+    case SWAPPED_MAGIC:
+      m_swapMode = true;
+      m_nanosecMode = false;
+      break;
+    case NS_MAGIC:
+      m_swapMode = false;
+      m_nanosecMode = true;
+      break;
+    case NS_SWAPPED_MAGIC:
+      m_swapMode = true;
+      m_nanosecMode = true;
+      break;
+    default:
+      SetFail ();
+      return;
+    }
+  m_snapLen = Read32 (m_data + 16);
+  m_dataLinkType = Read32 (m_data + 20);
+  m_first = PCAP_FILE_HEADER_SIZE;
+  m_offset = m_first;
+}
+
+bool
+PcapMmapReader::Next (Record &record)
+{
+  if (m_fail || m_eof)
+    {
+      return false;
+    }
+  if (m_usePcapFile)
+    {
+      return NextPcapFile (record);
+    }
+  if (m_data == 0)
+    {
+      return false;
+    }
+  return m_pcapNg ? NextPcapNg (record) : NextPcap (record);
+}
+
+bool
+PcapMmapReader::NextPcap (Record &record)
+{
+  if (m_offset == m_size)
+    {
+      m_eof = true;
+      return false;
+    }
+  if (m_size - m_offset < PCAP_RECORD_HEADER_SIZE)
+    {
+      // Truncated record header, most likely an interrupted capture.
+      m_eof = true;
+      return false;
+    }
+  const uint8_t *p = m_data + m_offset;
+  uint32_t tsSec = Read32 (p);
+  uint32_t tsFrac = Read32 (p + 4);
+  record.inclLen = Read32 (p + 8);
+  record.origLen = Read32 (p + 12);
+  if (record.inclLen > m_size - m_offset - PCAP_RECORD_HEADER_SIZE)
+    {
+      m_eof = true;
+      return false;
+    }
+  record.tsNs = tsSec * 1000000000ULL + (m_nanosecMode ? tsFrac : tsFrac * 1000ULL);
+  record.dataLinkType = m_dataLinkType;
+  record.interfaceId = 0;
+  record.data = p + PCAP_RECORD_HEADER_SIZE;
+  m_offset += PCAP_RECORD_HEADER_SIZE + record.inclLen;
+  return true;
+}
+
+bool
+PcapMmapReader::NextPcapFile (Record &record)
+{
+  uint32_t tsSec, tsFrac, readLen;
+  m_pcapFile.Read (m_buffer.empty () ? 0 : &m_buffer[0], m_buffer.size (),
+                   tsSec, tsFrac, record.inclLen, record.origLen, readLen);
+  if (m_pcapFile.Fail ())
+    {
+      // As with a mapped file, a truncated last record ends the capture.
+      m_eof = true;
+      return false;
+    }
+  record.tsNs = tsSec * 1000000000ULL + (m_nanosecMode ? tsFrac : tsFrac * 1000ULL);
+  record.inclLen = readLen;
+  record.dataLinkType = m_dataLinkType;
+  record.interfaceId = 0;
+  record.data = m_buffer.empty () ? 0 : &m_buffer[0];
+  return true;
+}
+
+bool
+PcapMmapReader::NextPcapNg (Record &record)
+{
+  while (true)
+    {
+      if (m_offset == m_size)
+        {
+          m_eof = true;
+          return false;
+        }
+      if (m_size - m_offset < 12)
+        {
+          m_eof = true;
+          return false;
+        }
+      const uint8_t *p = m_data + m_offset;
+      uint32_t type;
+      std::memcpy (&type, p, sizeof (type));
+      if (type == PCAPNG_SHB)
+        {
+          // The section header defines the byte order of everything up to
+          // the next section header, including its own length field.
+          uint32_t bom;
+          std::memcpy (&bom, p + 8, sizeof (bom));
+          if (bom == PCAPNG_BYTE_ORDER_MAGIC)
+            {
+              m_swapMode = false;
+            }
+          else if (bom == PCAPNG_SWAPPED_BYTE_ORDER_MAGIC)
+            {
+              m_swapMode = true;
+            }
+          else
+            {
+              SetFail ();
+              return false;
+            }
+          m_interfaces.clear ();
+        }
+      else
+        {
+          type = Read32 (p);
+        }
+
+      uint32_t blockLen = Read32 (p + 4);
+      if (blockLen < 12 || blockLen % 4 != 0 || blockLen > m_size - m_offset)
+        {
+          if (blockLen > m_size - m_offset)
+            {
+              // Truncated trailing block.
+              m_eof = true;
+            }
+          else
+            {
+              SetFail ();
+            }
+          return false;
+        }
+      m_offset += blockLen;
+
+      const uint8_t *body = p + 8;
+      uint32_t bodyLen = blockLen - 12;
+      switch (type)
+        {
+        case PCAPNG_IDB:
+          ReadInterface (body, bodyLen);
+          break;
+        case PCAPNG_EPB:
+        case PCAPNG_PB:
+          {
+            if (bodyLen < 20)
+              {
+                SetFail ();
+                return false;
+              }
+            uint32_t ifId = type == PCAPNG_EPB ? Read32 (body) : Read16 (body);
+            if (ifId >= m_interfaces.size ())
+              {
+                SetFail ();
+                return false;
+              }
+            const Interface &iface = m_interfaces[ifId];
+            uint64_t units = (static_cast<uint64_t> (Read32 (body + 4)) << 32) | Read32 (body + 8);
+            record.inclLen = Read32 (body + 12);
+            record.origLen = Read32 (body + 16);
+            if (record.inclLen > bodyLen - 20)
+              {
+                SetFail ();
+                return false;
+              }
+            record.tsNs = ToNanoSeconds (iface, units);
+            record.dataLinkType = iface.dataLinkType;
+            record.interfaceId = ifId;
+            record.data = body + 20;
+            return true;
+          }
+        case PCAPNG_SPB:
+          {
+            if (bodyLen < 4 || m_interfaces.empty ())
+              {
+                SetFail ();
+                return false;
+              }
+            const Interface &iface = m_interfaces[0];
+            record.origLen = Read32 (body);
+            record.inclLen = record.origLen;
+            if (iface.snapLen != 0 && record.inclLen > iface.snapLen)
+              {
+                record.inclLen = iface.snapLen;
+              }
+            if (record.inclLen > bodyLen - 4)
+              {
+                record.inclLen = bodyLen - 4;
+              }
+            // Simple packet blocks carry no timestamp.
+            record.tsNs = 0;
+            record.dataLinkType = iface.dataLinkType;
+            record.interfaceId = 0;
+            record.data = body + 4;
+            return true;
+          }
+        default:
+          // Section headers and blocks we do not care about.
+          break;
+        }
+    }
+}
+
+void
+PcapMmapReader::ReadInterface (const uint8_t *body, uint32_t length)
+{
+  NS_LOG_FUNCTION (this << length);
+  Interface iface;
+  iface.dataLinkType = 0;
+  iface.snapLen = 0;
+  iface.unitsPerSec = 1000000;
+  iface.binaryResolution = false;
+  iface.resolutionExp = 6;
+  iface.tsOffsetSec = 0;
+  if (length < 8)
+    {
+      SetFail ();
+      return;
+    }
+  iface.dataLinkType = Read16 (body);
+  iface.snapLen = Read32 (body + 4);
+
+  uint32_t offset = 8;
+  while (offset + 4 <= length)
+    {
+      uint16_t code = Read16 (body + offset);
+      uint16_t optLen = Read16 (body + offset + 2);
+      offset += 4;
+      if (code == PCAPNG_OPT_ENDOFOPT || offset + optLen > length)
+        {
+          break;
+        }
+      if (code == PCAPNG_OPT_IF_TSRESOL && optLen >= 1)
+        {
+          uint8_t resol = body[offset];
+          iface.binaryResolution = (resol & 0x80) != 0;
+          iface.resolutionExp = resol & 0x7f;
+          if (iface.binaryResolution)
+            {
+              iface.unitsPerSec = iface.resolutionExp < 64 ? (1ULL << iface.resolutionExp) : 0;
+            }
+          else
+            {
+              iface.unitsPerSec = 1;
+              for (uint8_t i = 0; i < iface.resolutionExp && i < 19; ++i)
+                {
+                  iface.unitsPerSec *= 10;
+                }
+            }
+        }
+      else if (code == PCAPNG_OPT_IF_TSOFFSET && optLen >= 8)
+        {
+          // A single 64 bit value in section byte order.
+          uint64_t first = Read32 (body + offset);
+          uint64_t second = Read32 (body + offset + 4);
+          union {
+            uint32_t a;
+            uint8_t  b[4];
+          } u;
+          u.a = 1;
+          bool littleEndianFile = (u.b[0] == 1) != m_swapMode;
+          iface.tsOffsetSec = static_cast<int64_t> (littleEndianFile ? (second << 32) | first : (first << 32) | second);
+        }
+      offset += Pad4 (optLen);
+    }
+  m_interfaces.push_back (iface);
+}
+
+uint64_t
+PcapMmapReader::ToNanoSeconds (const Interface &iface, uint64_t units) const
+{
+  uint64_t ns;
+  if (iface.unitsPerSec == 0)
+    {
+      ns = 0;
+    }
+  else if (!iface.binaryResolution && iface.resolutionExp <= 9)
+    {
+      uint64_t scale = 1000000000ULL / iface.unitsPerSec;
+      ns = units * scale;
+    }
+  else
+    {
+      uint64_t sec = units / iface.unitsPerSec;
+      uint64_t frac = units % iface.unitsPerSec;
+      ns = sec * 1000000000ULL
+        + static_cast<uint64_t> (static_cast<long double> (frac) * 1e9L / iface.unitsPerSec);
+    }
+  return ns + iface.tsOffsetSec * 1000000000LL;
+}
+
+} // namespace ns3
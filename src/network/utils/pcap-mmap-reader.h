@@ -0,0 +1,201 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PCAP_MMAP_READER_H
+#define PCAP_MMAP_READER_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "pcap-file.h"
+
+namespace ns3 {
+
+/**
+ * \brief A read-only, memory-mapped view of a pcap or pcapng file
+ *
+ * Unlike PcapFile, which reads each record through an std::fstream into a
+ * caller-provided buffer, this class maps the whole file into memory and
+ * hands out pointers into the mapping, so iterating over a capture does
+ * not copy packet data.  Both the classic pcap format (micro- and
+ * nanosecond variants, either byte order) and pcapng (section header,
+ * interface description, enhanced, simple and obsolete packet blocks,
+ * with per-interface link types and timestamp resolutions) are supported.
+ *
+ * Record data pointers remain valid until Close () is called or the
+ * reader is destroyed.
+ *
+ * On systems without mmap (), or if a file cannot be mapped, classic pcap
+ * files are read record by record through PcapFile instead; the data
+ * pointer of a record is then only valid until the next call to Next (),
+ * and pcapng files are not supported.
+ */
+class PcapMmapReader
+{
+public:
+  /**
+   * \brief A single captured packet
+   */
+  struct Record
+  {
+    uint64_t tsNs;           //!< Timestamp, in nanoseconds since the epoch
+    uint32_t inclLen;        //!< Number of captured bytes pointed to by data
+    uint32_t origLen;        //!< Length of the packet on the wire
+    uint32_t dataLinkType;   //!< Data link type of the capturing interface
+    uint32_t interfaceId;    //!< Capturing interface (always 0 for pcap)
+    const uint8_t *data;     //!< Captured bytes, inside the file mapping
+  };
+
+  PcapMmapReader ();
+  ~PcapMmapReader ();
+
+  /**
+   * Map a capture file and parse its file (or first section) header.
+   *
+   * \param filename Name of the file to map.
+   */
+  void Open (std::string const &filename);
+
+  /**
+   * Unmap the file.
+   */
+  void Close (void);
+
+  /**
+   * \return true if the file could not be mapped or is malformed.
+   */
+  bool Fail (void) const;
+
+  /**
+   * \return true if the last call to Next () reached the end of the file.
+   */
+  bool Eof (void) const;
+
+  /**
+   * \return true if the file is in pcapng format.
+   */
+  bool IsPcapNg (void) const;
+
+  /**
+   * \return the size of the mapped file in bytes, or 0 if the file is read
+   * through PcapFile.
+   */
+  uint64_t GetSize (void) const;
+
+  /**
+   * Restart iteration at the first record.
+   */
+  void Rewind (void);
+
+  /**
+   * \brief Get the next packet record
+   *
+   * \param record [out] The next record.  Its data pointer refers to the
+   * file mapping.
+   * \return false at the end of the file or if the file is malformed, in
+   * which case Eof () or Fail () tells which.
+   */
+  bool Next (Record &record);
+
+private:
+  /**
+   * \brief Per-interface state of a pcapng section
+   */
+  struct Interface
+  {
+    uint32_t dataLinkType;   //!< Link type of the interface
+    uint32_t snapLen;        //!< Snap length of the interface
+    uint64_t unitsPerSec;    //!< Timestamp units per second
+    bool binaryResolution;   //!< Resolution is a power of two
+    uint8_t resolutionExp;   //!< Exponent of the timestamp resolution
+    int64_t tsOffsetSec;     //!< Offset added to timestamps, in seconds
+  };
+
+  /**
+   * \param p pointer into the mapping
+   * \return the 16 bit value at p in file byte order
+   */
+  uint16_t Read16 (const uint8_t *p) const;
+  /**
+   * \param p pointer into the mapping
+   * \return the 32 bit value at p in file byte order
+   */
+  uint32_t Read32 (const uint8_t *p) const;
+
+  /**
+   * Parse the classic pcap file header.
+   */
+  void ReadPcapHeader (void);
+  /**
+   * \param record [out] next record
+   * \return false at the end of the file or on error
+   */
+  bool NextPcap (Record &record);
+  /**
+   * \param record [out] next record
+   * \return false at the end of the file or on error
+   */
+  bool NextPcapNg (Record &record);
+  /**
+   * Parse an interface description block body.
+   * \param body start of the block body
+   * \param length length of the block body
+   */
+  void ReadInterface (const uint8_t *body, uint32_t length);
+  /**
+   * Convert a pcapng timestamp to nanoseconds.
+   * \param iface the capturing interface
+   * \param units the raw timestamp
+   * \return the timestamp in nanoseconds
+   */
+  uint64_t ToNanoSeconds (const Interface &iface, uint64_t units) const;
+
+  /**
+   * Open the file with PcapFile, for when it cannot be mapped.
+   */
+  void OpenPcapFile (void);
+  /**
+   * \param record [out] next record, read through PcapFile
+   * \return false at the end of the file or on error
+   */
+  bool NextPcapFile (Record &record);
+
+  /**
+   * Mark the file as malformed.
+   */
+  void SetFail (void);
+
+  const uint8_t *m_data;   //!< Start of the mapping
+  uint64_t m_size;         //!< Size of the mapping
+  uint64_t m_offset;       //!< Offset of the next record or block
+  uint64_t m_first;        //!< Offset of the first record or block
+  bool m_fail;             //!< File could not be mapped or is malformed
+  bool m_eof;              //!< End of file reached
+  bool m_pcapNg;           //!< File is in pcapng format
+  bool m_swapMode;         //!< File byte order differs from host byte order
+  bool m_nanosecMode;      //!< Classic pcap timestamps are in nanoseconds
+  uint32_t m_snapLen;      //!< Classic pcap snap length
+  uint32_t m_dataLinkType; //!< Classic pcap data link type
+  std::vector<Interface> m_interfaces; //!< Interfaces of the current pcapng section
+  std::string m_filename;  //!< Name of the open file
+  bool m_usePcapFile;      //!< File is read through m_pcapFile
+  PcapFile m_pcapFile;     //!< Reader used when the file cannot be mapped
+  std::vector<uint8_t> m_buffer; //!< Data of the last record read through m_pcapFile
+};
+
+} // namespace ns3
+
+#endif /* PCAP_MMAP_READER_H */
@@ -129,6 +129,19 @@ QueueDiscItem::SetTimeStamp (Time t)
   m_tstamp = t;
 }
 
+uint32_t
+QueueDiscItem::GetFlowHash (void) const
+{
+  return GetPacket ()->GetFlowHash ();
+}
+
+std::list<Ptr<QueueDiscItem> >
+QueueDiscItem::SegmentGso (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return std::list<Ptr<QueueDiscItem> > ();
+}
+
 void
 QueueDiscItem::Print (std::ostream& os) const
 {
@@ -24,6 +24,7 @@
 #include "ns3/simple-ref-count.h"
 #include <ns3/address.h>
 #include "ns3/nstime.h"
+#include <list>
 
 namespace ns3 {
 
@@ -202,6 +203,18 @@ public:
    */
   virtual void AddHeader (void) = 0;
 
+  /**
+   * \brief Get the flow hash of the packet included in this item
+   *
+   * Subclasses aware of the protocol headers compute the flow hash and store
+   * it in the packet (see Packet::SetFlowHash) the first time it is needed,
+   * so that it is computed once along the path of the packet.  This default
+   * implementation only returns the flow hash already stored in the packet.
+   *
+   * \return the flow hash, or 0 if it is not known.
+   */
+  virtual uint32_t GetFlowHash (void) const;
+
   /**
    * \brief Print the item contents.
    * \param os output stream in which the data should be printed.
@@ -215,6 +228,17 @@ public:
    */
   virtual bool Mark (void) = 0;
 
+  /**
+   * \brief Split the super-segment (see GsoTag) included in this item
+   *
+   * Subclasses aware of the protocol headers return an item for each
+   * segment, with its own copy of the headers.  This default
+   * implementation returns no item: the super-segment cannot be split.
+   *
+   * \return the items of the segments which are not lost, in order
+   */
+  virtual std::list<Ptr<QueueDiscItem> > SegmentGso (void) const;
+
 private:
   /**
    * \brief Default constructor
@@ -21,6 +21,8 @@
 #include "queue-size.h"
 #include "ns3/log.h"
 #include "ns3/unused.h"
+#include "ns3/packet.h"
+#include "gso-tag.h"
 
 namespace ns3 {
 
@@ -208,4 +210,21 @@ std::istream &operator >> (std::istream &is, QueueSize &size)
   return is;
 }
 
+uint32_t
+GetNWirePackets (Ptr<const Packet> packet)
+{
+  GsoTag gso;
+  if (packet->PeekPacketTag (gso))
+    {
+      return gso.GetNSegments ();
+    }
+  return 1;
+}
+
+uint32_t
+GetNWirePackets (Ptr<Packet> packet)
+{
+  return GetNWirePackets (Ptr<const Packet> (packet));
+}
+
 } // namespace ns3
@@ -26,6 +26,7 @@
 #include "ns3/attribute.h"
 #include "ns3/attribute-helper.h"
 #include "ns3/abort.h"
+#include "ns3/ptr.h"
 
 namespace ns3 {
 
@@ -220,6 +221,31 @@ std::istream &operator >> (std::istream &is, QueueSize &size);
 
 ATTRIBUTE_HELPER_HEADER (QueueSize);
 
+class Packet;
+
+/**
+ * \brief Get the number of packets an item stands for on the wire
+ *
+ * A super-segment (see GsoTag) stands for its number of segments, so that
+ * the packet limits and counters of queues and queue discs do not depend
+ * on segmentation offload.  Any other packet stands for one packet.
+ *
+ * \param packet the packet
+ * \return the number of packets
+ */
+uint32_t GetNWirePackets (Ptr<const Packet> packet);
+/**
+ * \copydoc GetNWirePackets(Ptr<const Packet>)
+ */
+uint32_t GetNWirePackets (Ptr<Packet> packet);
+/**
+ * \brief Get the number of packets a queue item stands for on the wire
+ *
+ * \param item the queue item
+ * \return the number of packets of the packet held by the item
+ */
+template <typename Item>
+uint32_t GetNWirePackets (const Ptr<Item> &item);
 
 /**
  * \brief Increase the queue size by a packet size
@@ -245,13 +271,18 @@ QueueSize operator+ (const Ptr<Item>& lhs, const QueueSize& rhs);
  * Implementation of the templates declared above.
  */
 
+template <typename Item>
+uint32_t GetNWirePackets (const Ptr<Item> &item)
+{
+  return GetNWirePackets (item->GetPacket ());
+}
 
 template <typename Item>
 QueueSize operator+ (const QueueSize& lhs, const Ptr<Item>& rhs)
 {
   if (lhs.GetUnit () == QueueSizeUnit::PACKETS)
     {
-      return QueueSize (lhs.GetUnit (), lhs.GetValue () + 1);
+      return QueueSize (lhs.GetUnit (), lhs.GetValue () + GetNWirePackets (rhs));
     }
   if (lhs.GetUnit () == QueueSizeUnit::BYTES)
     {
@@ -265,7 +296,7 @@ QueueSize operator+ (const Ptr<Item>& lhs, const QueueSize& rhs)
 {
   if (rhs.GetUnit () == QueueSizeUnit::PACKETS)
     {
-      return QueueSize (rhs.GetUnit (), rhs.GetValue () + 1);
+      return QueueSize (rhs.GetUnit (), rhs.GetValue () + GetNWirePackets (lhs));
     }
   if (rhs.GetUnit () == QueueSizeUnit::BYTES)
     {
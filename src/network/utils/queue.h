@@ -30,9 +30,9 @@
 #include "ns3/unused.h"
 #include "ns3/log.h"
 #include "ns3/queue-size.h"
+#include "ns3/ring-buffer.h"
 #include <string>
 #include <sstream>
-#include <list>
 
 namespace ns3 {
 
@@ -47,6 +47,12 @@ namespace ns3 {
  *
  * This class defines the subset of the base APIs for packet queues in the ns-3 system
  * that is independent of the type of enqueued objects
+ *
+ * Packet counts and limits are in packets on the wire: a super-segment
+ * (see GsoTag) counts as its number of segments.  A queue drops a
+ * super-segment which does not fit whole; the devices supporting them
+ * (see NetDevice::SupportsGso) enqueue such a super-segment as its
+ * segments instead, so that only the segments which do not fit are dropped.
  */
 class QueueBase : public Object
 {
@@ -356,8 +362,13 @@ public:
 
 protected:
 
-  /// Const iterator.
-  typedef typename std::list<Ptr<Item> >::const_iterator ConstIterator;
+  /**
+   * Const iterator.  Items are stored in a RingBuffer, whose iterators,
+   * like those of an std::list, remain valid when other items are removed.
+   * Enqueuing an item anywhere but at the head or at the tail of the queue
+   * invalidates all iterators, though.
+   */
+  typedef typename RingBuffer<Ptr<Item> >::ConstIterator ConstIterator;
 
   /**
    * \brief Get a const iterator which refers to the first item in the queue.
@@ -441,7 +452,7 @@ protected:
   void DropAfterDequeue (Ptr<Item> item);
 
 private:
-  std::list<Ptr<Item> > m_packets;          //!< the items in the queue
+  RingBuffer<Ptr<Item> > m_packets;         //!< the items in the queue
   NS_LOG_TEMPLATE_DECLARE;                  //!< the log component
 
   /// Traced callback: fired when a packet is enqueued
@@ -518,8 +529,9 @@ Queue<Item>::DoEnqueue (ConstIterator pos, Ptr<Item> item)
   m_nBytes += size;
   m_nTotalReceivedBytes += size;
 
-  m_nPackets++;
-  m_nTotalReceivedPackets++;
+  uint32_t nPackets = GetNWirePackets (item);
+  m_nPackets += nPackets;
+  m_nTotalReceivedPackets += nPackets;
 
   NS_LOG_LOGIC ("m_traceEnqueue (p)");
   m_traceEnqueue (item);
@@ -544,11 +556,12 @@ Queue<Item>::DoDequeue (ConstIterator pos)
 
   if (item != 0)
     {
+      uint32_t nPackets = GetNWirePackets (item);
       NS_ASSERT (m_nBytes.Get () >= item->GetSize ());
-      NS_ASSERT (m_nPackets.Get () > 0);
+      NS_ASSERT (m_nPackets.Get () >= nPackets);
 
       m_nBytes -= item->GetSize ();
-      m_nPackets--;
+      m_nPackets -= nPackets;
 
       NS_LOG_LOGIC ("m_traceDequeue (p)");
       m_traceDequeue (item);
@@ -573,11 +586,12 @@ Queue<Item>::DoRemove (ConstIterator pos)
 
   if (item != 0)
     {
+      uint32_t nPackets = GetNWirePackets (item);
       NS_ASSERT (m_nBytes.Get () >= item->GetSize ());
-      NS_ASSERT (m_nPackets.Get () > 0);
+      NS_ASSERT (m_nPackets.Get () >= nPackets);
 
       m_nBytes -= item->GetSize ();
-      m_nPackets--;
+      m_nPackets -= nPackets;
 
       // packets are first dequeued and then dropped
       NS_LOG_LOGIC ("m_traceDequeue (p)");
@@ -632,8 +646,9 @@ Queue<Item>::DropBeforeEnqueue (Ptr<Item> item)
 {
   NS_LOG_FUNCTION (this << item);
 
-  m_nTotalDroppedPackets++;
-  m_nTotalDroppedPacketsBeforeEnqueue++;
+  uint32_t nPackets = GetNWirePackets (item);
+  m_nTotalDroppedPackets += nPackets;
+  m_nTotalDroppedPacketsBeforeEnqueue += nPackets;
   m_nTotalDroppedBytes += item->GetSize ();
   m_nTotalDroppedBytesBeforeEnqueue += item->GetSize ();
 
@@ -648,8 +663,9 @@ Queue<Item>::DropAfterDequeue (Ptr<Item> item)
 {
   NS_LOG_FUNCTION (this << item);
 
-  m_nTotalDroppedPackets++;
-  m_nTotalDroppedPacketsAfterDequeue++;
+  uint32_t nPackets = GetNWirePackets (item);
+  m_nTotalDroppedPackets += nPackets;
+  m_nTotalDroppedPacketsAfterDequeue += nPackets;
   m_nTotalDroppedBytes += item->GetSize ();
   m_nTotalDroppedBytesAfterDequeue += item->GetSize ();
 
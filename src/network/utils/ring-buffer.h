@@ -0,0 +1,375 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <vector>
+#include <iterator>
+#include <cstddef>
+#include <stdint.h>
+#include "ns3/assert.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup network
+ * \brief A growable circular buffer with list-like iterators
+ *
+ * RingBuffer stores its elements contiguously in a power-of-two sized
+ * vector and addresses them through monotonically increasing absolute
+ * indices, so pushing at either end and popping from the head cost a
+ * couple of integer operations and no allocation once the buffer has
+ * reached its working size.  This is the access pattern of packet queues,
+ * which is why Queue uses this container instead of an std::list.
+ *
+ * To preserve the std::list guarantees Queue subclasses rely on, erasing
+ * an element never moves the other ones: an element erased anywhere but
+ * at the head is replaced by a hole (a default-constructed T), which
+ * iterators skip and which is reclaimed when the buffer is compacted.
+ * Hence erase () invalidates only the iterators to the erased element.
+ * The end iterator is stable as well, even when the last element is
+ * erased.
+ *
+ * Inserting at the head or at the tail does not invalidate iterators
+ * unless the buffer has to grow.  Inserting before any other element
+ * shifts the shorter side of the buffer by one slot (or fills a hole
+ * right before the position, if there is one) and invalidates all
+ * iterators.
+ *
+ * \tparam T the element type.  A default-constructed T must evaluate to
+ * false and no element stored in the buffer may do so, which is the case
+ * for non-null smart pointers like Ptr.
+ */
+template <typename T>
+class RingBuffer
+{
+public:
+  /**
+   * \brief Bidirectional iterator over the elements of a RingBuffer
+   */
+  class ConstIterator
+  {
+public:
+    /// Iterator category
+    typedef std::bidirectional_iterator_tag iterator_category;
+    /// Value type
+    typedef T value_type;
+    /// Difference type
+    typedef std::ptrdiff_t difference_type;
+    /// Pointer type
+    typedef const T *pointer;
+    /// Reference type
+    typedef const T &reference;
+
+    ConstIterator ()
+      : m_ring (0),
+        m_index (0)
+    {
+    }
+    /// \return the element the iterator points to
+    const T & operator* () const
+    {
+      return m_ring->Slot (m_index);
+    }
+    /// \return a pointer to the element the iterator points to
+    const T * operator-> () const
+    {
+      return &m_ring->Slot (m_index);
+    }
+    /// \return the iterator, advanced to the next element
+    ConstIterator & operator++ ()
+    {
+      m_index = m_ring->NextLive (m_index + 1);
+      return *this;
+    }
+    /// \return a copy of the iterator before advancing it
+    ConstIterator operator++ (int)
+    {
+      ConstIterator tmp = *this;
+      ++*this;
+      return tmp;
+    }
+    /// \return the iterator, moved back to the previous element
+    ConstIterator & operator-- ()
+    {
+      m_index = m_ring->PrevLive (m_index - 1);
+      return *this;
+    }
+    /// \return a copy of the iterator before moving it back
+    ConstIterator operator-- (int)
+    {
+      ConstIterator tmp = *this;
+      --*this;
+      return tmp;
+    }
+    /**
+     * \param o the other iterator
+     * \return true if both iterators point to the same position
+     */
+    bool operator== (const ConstIterator &o) const
+    {
+      return m_index == o.m_index && m_ring == o.m_ring;
+    }
+    /**
+     * \param o the other iterator
+     * \return true if the iterators point to different positions
+     */
+    bool operator!= (const ConstIterator &o) const
+    {
+      return !(*this == o);
+    }
+
+private:
+    friend class RingBuffer<T>;
+    /**
+     * \param ring the container
+     * \param index the absolute index of the element
+     */
+    ConstIterator (const RingBuffer<T> *ring, uint64_t index)
+      : m_ring (ring),
+        m_index (index)
+    {
+    }
+    const RingBuffer<T> *m_ring; //!< The container
+    uint64_t m_index;            //!< Absolute index of the element
+  };
+
+  RingBuffer ()
+    : m_mask (0),
+      m_head (0),
+      m_tail (0),
+      m_size (0),
+      m_holes (0)
+  {
+  }
+
+  /// \return true if the buffer holds no element
+  bool empty (void) const
+  {
+    return m_size == 0;
+  }
+  /// \return the number of elements in the buffer
+  uint32_t size (void) const
+  {
+    return m_size;
+  }
+  /// \return the number of slots currently allocated
+  uint32_t capacity (void) const
+  {
+    return m_slots.size ();
+  }
+  /// \return an iterator to the first element
+  ConstIterator cbegin (void) const
+  {
+    return ConstIterator (this, m_head);
+  }
+  /// \return an iterator past the last element
+  ConstIterator cend (void) const
+  {
+    return ConstIterator (this, m_tail);
+  }
+
+  /**
+   * Insert an element before the given position.
+   *
+   * \param pos the position the element is inserted before
+   * \param value the element to insert
+   * \return an iterator to the inserted element
+   */
+  ConstIterator insert (ConstIterator pos, const T &value)
+  {
+    NS_ASSERT (pos.m_ring == this && value);
+    uint64_t index = pos.m_index;
+    if (index == m_tail)
+      {
+        if (m_tail - m_head == m_slots.size ())
+          {
+            Grow ();
+          }
+        Slot (m_tail++) = value;
+        m_size++;
+        return ConstIterator (this, m_tail - 1);
+      }
+    if (index != m_head && !Slot (index - 1))
+      {
+        Slot (index - 1) = value;
+        m_holes--;
+        m_size++;
+        return ConstIterator (this, index - 1);
+      }
+    if (m_tail - m_head == m_slots.size ())
+      {
+        // Grow () drops the holes, so locate the position by the number
+        // of elements preceding it
+        uint64_t offset = 0;
+        for (uint64_t i = m_head; i != index; i++)
+          {
+            offset += Slot (i) ? 1 : 0;
+          }
+        Grow ();
+        index = m_head + offset;
+      }
+    if (index - m_head <= m_tail - index)
+      {
+        // shift [m_head, index) one slot towards the front
+        for (uint64_t i = m_head; i != index; i++)
+          {
+            Slot (i - 1) = Slot (i);
+          }
+        m_head--;
+        index--;
+      }
+    else
+      {
+        // shift [index, m_tail) one slot towards the back
+        for (uint64_t i = m_tail; i != index; i--)
+          {
+            Slot (i) = Slot (i - 1);
+          }
+        m_tail++;
+      }
+    Slot (index) = value;
+    m_size++;
+    return ConstIterator (this, index);
+  }
+
+  /**
+   * Erase the element at the given position.
+   *
+   * \param pos the position of the element to erase
+   * \return an iterator to the element following the erased one
+   */
+  ConstIterator erase (ConstIterator pos)
+  {
+    NS_ASSERT (pos.m_ring == this && pos.m_index != m_tail && Slot (pos.m_index));
+    uint64_t index = pos.m_index;
+    Slot (index) = T ();
+    m_size--;
+    if (index == m_head)
+      {
+        m_head++;
+        while (m_head != m_tail && !Slot (m_head))
+          {
+            m_head++;
+            m_holes--;
+          }
+        return ConstIterator (this, m_head);
+      }
+    m_holes++;
+    return ConstIterator (this, NextLive (index + 1));
+  }
+
+  /**
+   * Erase all the elements.  All iterators are invalidated.
+   */
+  void clear (void)
+  {
+    for (uint64_t i = m_head; i != m_tail; i++)
+      {
+        Slot (i) = T ();
+      }
+    m_head = m_tail = 0;
+    m_size = 0;
+    m_holes = 0;
+  }
+
+private:
+  /**
+   * \param index an absolute index
+   * \return the slot holding the given index
+   */
+  T & Slot (uint64_t index)
+  {
+    return m_slots[index & m_mask];
+  }
+  /**
+   * \param index an absolute index
+   * \return the slot holding the given index
+   */
+  const T & Slot (uint64_t index) const
+  {
+    return m_slots[index & m_mask];
+  }
+  /**
+   * \param index an absolute index in [m_head, m_tail]
+   * \return the index of the first element at or after index, or m_tail
+   */
+  uint64_t NextLive (uint64_t index) const
+  {
+    if (m_holes != 0)
+      {
+        while (index != m_tail && !Slot (index))
+          {
+            index++;
+          }
+      }
+    return index;
+  }
+  /**
+   * \param index an absolute index in [m_head, m_tail)
+   * \return the index of the last element at or before index
+   */
+  uint64_t PrevLive (uint64_t index) const
+  {
+    if (m_holes != 0)
+      {
+        while (index != m_head && !Slot (index))
+          {
+            index--;
+          }
+      }
+    return index;
+  }
+  /**
+   * Make room for at least one more element, dropping the holes.  The
+   * head keeps its absolute index.
+   */
+  void Grow (void)
+  {
+    uint64_t needed = m_size + 1;
+    uint64_t capacity = m_slots.empty () ? 8 : m_slots.size ();
+    while (capacity < needed + needed / 4)
+      {
+        capacity *= 2;
+      }
+    std::vector<T> slots (capacity);
+    uint64_t mask = capacity - 1;
+    uint64_t tail = m_head;
+    for (uint64_t i = m_head; i != m_tail; i++)
+      {
+        if (Slot (i))
+          {
+            slots[tail++ & mask] = Slot (i);
+          }
+      }
+    m_slots.swap (slots);
+    m_mask = mask;
+    m_tail = tail;
+    m_holes = 0;
+  }
+
+  std::vector<T> m_slots; //!< Power-of-two sized storage
+  uint64_t m_mask;        //!< Number of slots minus one
+  uint64_t m_head;        //!< Absolute index of the first element
+  uint64_t m_tail;        //!< Absolute index past the last element
+  uint32_t m_size;        //!< Number of elements
+  uint32_t m_holes;       //!< Number of holes in [m_head, m_tail)
+};
+
+} // namespace ns3
+
+#endif /* RING_BUFFER_H */
@@ -500,6 +500,56 @@ SimpleNetDevice::SendFrom (Ptr<Packet> p, const Address& source, const Address&
   return true;
 }
 
+uint32_t
+SimpleNetDevice::SendBatch (const std::vector<Ptr<QueueDiscItem> > &items)
+{
+  NS_LOG_FUNCTION (this << items.size ());
+
+  Ptr<NetDeviceQueue> txq = m_queueInterface ? m_queueInterface->GetTxQueue (0) : 0;
+  uint32_t sent = 0;
+  for (; sent < items.size (); sent++)
+    {
+      if (txq && txq->IsStopped ())
+        {
+          break;
+        }
+      Ptr<Packet> p = items[sent]->GetPacket ();
+      if (p->GetSize () > GetMtu ())
+        {
+          continue;
+        }
+
+      SimpleTag tag;
+      tag.SetSrc (m_address);
+      tag.SetDst (Mac48Address::ConvertFrom (items[sent]->GetAddress ()));
+      tag.SetProto (items[sent]->GetProtocol ());
+
+      p->AddPacketTag (tag);
+
+      if (!m_queue->Enqueue (p))
+        {
+          p->RemovePacketTag (tag);
+          m_channel->Send (p, tag.GetProto (), tag.GetDst (), tag.GetSrc (), this);
+        }
+    }
+
+  // start the transmission of the burst, if the device is idle
+  if (m_queue->GetNPackets () > 0 && !TransmitCompleteEvent.IsRunning ())
+    {
+      Ptr<Packet> p = m_queue->Dequeue ();
+      SimpleTag tag;
+      p->RemovePacketTag (tag);
+      Time txTime = Time (0);
+      if (m_bps > DataRate (0))
+        {
+          txTime = m_bps.CalculateBytesTxTime (p->GetSize ());
+        }
+      m_channel->Send (p, tag.GetProto (), tag.GetDst (), tag.GetSrc (), this);
+      TransmitCompleteEvent = Simulator::Schedule (txTime, &SimpleNetDevice::TransmitComplete, this);
+    }
+  return sent;
+}
+
 
 void
 SimpleNetDevice::TransmitComplete ()
@@ -0,0 +1,487 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/node.h"
+#include "ns3/node-list.h"
+#include "ns3/ipv4.h"
+#include "ns3/global-value.h"
+#include "ns3/uinteger.h"
+#include "ns3/core-config.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-thread.h"
+#endif
+
+#include "ipv4-nix-vector-graph.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("Ipv4NixVectorGraph");
+
+/**
+ * \brief The number of threads computing the routing trees of
+ * Ipv4NixVectorGraph::ComputeTrees.
+ *
+ * The routes do not depend on it.
+ */
+static GlobalValue g_nixVectorRoutingThreads ("NixVectorRoutingThreads",
+                                              "The number of threads computing the nix-vector "
+                                              "routing trees of a set of destinations",
+                                              UintegerValue (1),
+                                              MakeUintegerChecker<uint32_t> (1));
+
+const uint32_t Ipv4NixVectorGraph::NONE;
+
+Ipv4NixVectorGraph::Ipv4NixVectorGraph ()
+  : m_valid (false)
+{
+}
+
+void
+Ipv4NixVectorGraph::Invalidate (void)
+{
+  m_valid = false;
+}
+
+void
+Ipv4NixVectorGraph::Clear (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_valid = false;
+  std::vector<uint32_t> ().swap (m_offsets);
+  std::vector<Edge> ().swap (m_edges);
+  std::vector<Tree> ().swap (m_trees);
+  m_addressNodes.clear ();
+  std::vector<Ipv4Address> ().swap (m_nodeAddresses);
+}
+
+void
+Ipv4NixVectorGraph::Build (std::vector<uint32_t> &offsets, std::vector<Edge> &edges)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t nNodes = NodeList::GetNNodes ();
+  offsets.clear ();
+  edges.clear ();
+  m_addressNodes.clear ();
+  m_nodeAddresses.assign (nNodes, Ipv4Address ());
+  for (uint32_t n = 0; n < nNodes; n++)
+    {
+      Ptr<Node> node = NodeList::GetNode (n);
+      Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+      offsets.push_back (edges.size ());
+      if (ipv4)
+        {
+          // The first node having an address is the destination of the
+          // address
+          for (uint32_t i = 0; i < ipv4->GetNInterfaces (); i++)
+            {
+              for (uint32_t j = 0; j < ipv4->GetNAddresses (i); j++)
+                {
+                  Ipv4Address address = ipv4->GetAddress (i, j).GetLocal ();
+                  m_addressNodes.insert (std::make_pair (address, n));
+                  if (m_nodeAddresses[n] == Ipv4Address () || m_nodeAddresses[n].IsLocalhost ())
+                    {
+                      m_nodeAddresses[n] = address;
+                    }
+                }
+            }
+        }
+
+      for (uint32_t i = 0; i < node->GetNDevices (); i++)
+        {
+          // Get a net device from the node
+          // as well as the channel, and figure
+          // out the adjacent net devices
+          Ptr<NetDevice> localNetDevice = node->GetDevice (i);
+          if (localNetDevice->IsBridge ())
+            {
+              continue;
+            }
+          Ptr<Channel> channel = localNetDevice->GetChannel ();
+          if (channel == 0)
+            {
+              continue;
+            }
+
+          // make sure that we can go this way
+          Edge edge;
+          edge.device = i;
+          edge.interface = NONE;
+          edge.up = localNetDevice->IsLinkUp ();
+          if (ipv4)
+            {
+              int32_t interface = ipv4->GetInterfaceForDevice (localNetDevice);
+              if (interface == -1)
+                {
+                  edge.up = false;
+                }
+              else
+                {
+                  edge.interface = interface;
+                  edge.up = edge.up && ipv4->IsUp (interface);
+                }
+            }
+
+          NetDeviceContainer netDeviceContainer;
+          GetAdjacentNetDevices (localNetDevice, channel, netDeviceContainer);
+          for (NetDeviceContainer::Iterator iter = netDeviceContainer.Begin (); iter != netDeviceContainer.End (); iter++)
+            {
+              Ptr<Node> remoteNode = (*iter)->GetNode ();
+              Ptr<Ipv4> remoteIpv4 = remoteNode->GetObject<Ipv4> ();
+              edge.node = remoteNode->GetId ();
+              edge.gateway = Ipv4Address ();
+              if (remoteIpv4)
+                {
+                  int32_t interface = remoteIpv4->GetInterfaceForDevice (*iter);
+                  if (interface != -1 && remoteIpv4->GetNAddresses (interface) > 0)
+                    {
+                      edge.gateway = remoteIpv4->GetAddress (interface, 0).GetLocal ();
+                    }
+                }
+              edges.push_back (edge);
+            }
+        }
+    }
+  offsets.push_back (edges.size ());
+}
+
+void
+Ipv4NixVectorGraph::Update (void)
+{
+  uint32_t nNodes = NodeList::GetNNodes ();
+  if (m_valid && m_offsets.size () == nNodes + 1)
+    {
+      return;
+    }
+  NS_LOG_FUNCTION (this);
+
+  std::vector<uint32_t> offsets;
+  std::vector<Edge> edges;
+  Build (offsets, edges);
+
+  bool sameLinks = offsets == m_offsets;
+  for (uint32_t e = 0; sameLinks && e < edges.size (); e++)
+    {
+      sameLinks = edges[e].node == m_edges[e].node && edges[e].device == m_edges[e].device;
+    }
+  if (!sameLinks)
+    {
+      NS_LOG_LOGIC ("Links changed, dropping all the routing trees");
+      std::vector<Tree> (nNodes).swap (m_trees);
+    }
+  else
+    {
+      // A breadth-first search from a source goes the same way after the
+      // change of a link, unless the link was in the tree, or it now
+      // leads to its node by at most as many hops, which may win the tie
+      for (uint32_t n = 0; n < nNodes; n++)
+        {
+          for (uint32_t e = offsets[n]; e < offsets[n + 1]; e++)
+            {
+              if (edges[e].up == m_edges[e].up)
+                {
+                  continue;
+                }
+              NS_LOG_LOGIC ("Link " << e << " of node " << n << " is now " << (edges[e].up ? "up" : "down"));
+              for (uint32_t source = 0; source < nNodes; source++)
+                {
+                  Tree &tree = m_trees[source];
+                  if (tree.empty ())
+                    {
+                      continue;
+                    }
+                  bool changed;
+                  if (edges[e].up)
+                    {
+                      uint32_t distance = GetDistance (tree, source, n);
+                      changed = distance != NONE && edges[e].node != source
+                        && GetDistance (tree, source, edges[e].node) > distance;
+                    }
+                  else
+                    {
+                      changed = tree[edges[e].node] == e;
+                    }
+                  if (changed)
+                    {
+                      NS_LOG_LOGIC ("Dropping the routing tree of node " << source);
+                      Tree ().swap (tree);
+                    }
+                }
+            }
+        }
+    }
+  m_offsets.swap (offsets);
+  m_edges.swap (edges);
+  m_valid = true;
+}
+
+uint32_t
+Ipv4NixVectorGraph::GetNodeByAddress (Ipv4Address address) const
+{
+  std::unordered_map<Ipv4Address, uint32_t, Ipv4AddressHash>::const_iterator i = m_addressNodes.find (address);
+  if (i == m_addressNodes.end ())
+    {
+      return NONE;
+    }
+  return i->second;
+}
+
+Ipv4Address
+Ipv4NixVectorGraph::GetNodeAddress (uint32_t node) const
+{
+  return m_nodeAddresses.at (node);
+}
+
+uint32_t
+Ipv4NixVectorGraph::GetNNeighbors (uint32_t node) const
+{
+  return m_offsets.at (node + 1) - m_offsets[node];
+}
+
+const Ipv4NixVectorGraph::Edge &
+Ipv4NixVectorGraph::GetEdge (uint32_t node, uint32_t neighbor) const
+{
+  NS_ASSERT (neighbor < GetNNeighbors (node));
+  return m_edges[m_offsets[node] + neighbor];
+}
+
+bool
+Ipv4NixVectorGraph::GetRoute (uint32_t source, uint32_t dest, uint32_t device,
+                              std::vector<uint32_t> &neighbors)
+{
+  NS_LOG_FUNCTION (this << source << dest << device);
+  neighbors.clear ();
+  std::vector<uint32_t> queue;
+  Tree restricted;
+  if (device != NONE)
+    {
+      // The first hop is bound to the device: the tree is not shared
+      ComputeTree (source, device, restricted, queue);
+    }
+  else if (m_trees.at (source).empty ())
+    {
+      ComputeTree (source, NONE, m_trees[source], queue);
+    }
+  const Tree &tree = device != NONE ? restricted : m_trees[source];
+
+  for (uint32_t node = dest; node != source; )
+    {
+      uint32_t edge = tree.at (node);
+      if (edge == NONE)
+        {
+          neighbors.clear ();
+          return false;
+        }
+      node = GetEdgeSource (edge);
+      neighbors.push_back (edge - m_offsets[node]);
+    }
+  std::reverse (neighbors.begin (), neighbors.end ());
+  return true;
+}
+
+bool
+Ipv4NixVectorGraph::IsTreeComputed (uint32_t source) const
+{
+  return source < m_trees.size () && !m_trees[source].empty ();
+}
+
+void
+Ipv4NixVectorGraph::ComputeTree (uint32_t source, uint32_t device, Tree &tree,
+                                 std::vector<uint32_t> &queue) const
+{
+  Tree (m_offsets.size () - 1, NONE).swap (tree);
+  queue.clear ();
+  queue.push_back (source);
+  for (uint32_t head = 0; head < queue.size (); head++)
+    {
+      // The neighbors of the current node over its usable links, in the
+      // order of the links, not yet discovered, are reached through it
+      uint32_t node = queue[head];
+      for (uint32_t e = m_offsets[node]; e < m_offsets[node + 1]; e++)
+        {
+          const Edge &edge = m_edges[e];
+          if (node == source && device != NONE && edge.device != device)
+            {
+              continue;
+            }
+          if (edge.up && tree[edge.node] == NONE && edge.node != source)
+            {
+              tree[edge.node] = e;
+              queue.push_back (edge.node);
+            }
+        }
+    }
+}
+
+void
+Ipv4NixVectorGraph::ComputeTrees (const std::vector<uint32_t> &sources)
+{
+  NS_LOG_FUNCTION (this);
+  std::vector<uint32_t> missing;
+  for (std::vector<uint32_t>::const_iterator i = sources.begin (); i != sources.end (); i++)
+    {
+      if (!IsTreeComputed (*i))
+        {
+          missing.push_back (*i);
+        }
+    }
+  std::sort (missing.begin (), missing.end ());
+  missing.erase (std::unique (missing.begin (), missing.end ()), missing.end ());
+
+  UintegerValue nThreads;
+  g_nixVectorRoutingThreads.GetValue (nThreads);
+  uint32_t threads = std::min<uint32_t> (nThreads.Get (), missing.size ());
+#ifdef HAVE_PTHREAD_H
+  if (threads > 1)
+    {
+      NS_LOG_INFO ("Computing " << missing.size () << " routing trees in " << threads << " threads");
+      std::vector<Batch> batches (threads);
+      std::vector<Ptr<SystemThread> > systemThreads;
+      for (uint32_t t = 0; t < threads; t++)
+        {
+          Batch batch = { this, &missing, t, threads };
+          batches[t] = batch;
+          systemThreads.push_back (Create<SystemThread> (MakeCallback (&Batch::Run, &batches[t])));
+          systemThreads.back ()->Start ();
+        }
+      for (uint32_t t = 0; t < threads; t++)
+        {
+          systemThreads[t]->Join ();
+        }
+      return;
+    }
+#endif /* HAVE_PTHREAD_H */
+  Batch batch = { this, &missing, 0, 1 };
+  batch.Run ();
+}
+
+void
+Ipv4NixVectorGraph::Batch::Run (void)
+{
+  std::vector<uint32_t> queue;
+  for (uint32_t i = first; i < sources->size (); i += step)
+    {
+      uint32_t source = (*sources)[i];
+      graph->ComputeTree (source, NONE, graph->m_trees[source], queue);
+    }
+}
+
+uint32_t
+Ipv4NixVectorGraph::GetEdgeSource (uint32_t edge) const
+{
+  return std::upper_bound (m_offsets.begin (), m_offsets.end (), edge) - m_offsets.begin () - 1;
+}
+
+uint32_t
+Ipv4NixVectorGraph::GetDistance (const Tree &tree, uint32_t source, uint32_t node) const
+{
+  uint32_t distance = 0;
+  while (node != source)
+    {
+      if (tree[node] == NONE)
+        {
+          return NONE;
+        }
+      node = GetEdgeSource (tree[node]);
+      distance++;
+    }
+  return distance;
+}
+
+void
+Ipv4NixVectorGraph::GetAdjacentNetDevices (Ptr<NetDevice> netDevice, Ptr<Channel> channel, NetDeviceContainer & netDeviceContainer)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+
+  for (uint32_t i = 0; i < channel->GetNDevices (); i++)
+    {
+      Ptr<NetDevice> remoteDevice = channel->GetDevice (i);
+      if (remoteDevice != netDevice)
+        {
+          Ptr<BridgeNetDevice> bd = NetDeviceIsBridged (remoteDevice);
+          // we have a bridged device, we need to add all
+          // bridged devices
+          if (bd)
+            {
+              NS_LOG_LOGIC ("Looking through bridge ports of bridge net device " << bd);
+              for (uint32_t j = 0; j < bd->GetNBridgePorts (); ++j)
+                {
+                  Ptr<NetDevice> ndBridged = bd->GetBridgePort (j);
+                  if (ndBridged == remoteDevice)
+                    {
+                      NS_LOG_LOGIC ("That bridge port is me, don't walk backward");
+                      continue;
+                    }
+                  Ptr<Channel> chBridged = ndBridged->GetChannel ();
+                  if (chBridged == 0)
+                    {
+                      continue;
+                    }
+                  GetAdjacentNetDevices (ndBridged, chBridged, netDeviceContainer);
+                }
+            }
+          else
+            {
+              netDeviceContainer.Add (channel->GetDevice (i));
+            }
+        }
+    }
+}
+
+Ptr<BridgeNetDevice>
+Ipv4NixVectorGraph::NetDeviceIsBridged (Ptr<NetDevice> nd)
+{
+  NS_LOG_FUNCTION (nd);
+
+  Ptr<Node> node = nd->GetNode ();
+  uint32_t nDevices = node->GetNDevices ();
+
+  //
+  // There is no bit on a net device that says it is being bridged, so we have
+  // to look for bridges on the node to which the device is attached.  If we
+  // find a bridge, we need to look through its bridge ports (the devices it
+  // bridges) to see if we find the device in question.
+  //
+  for (uint32_t i = 0; i < nDevices; ++i)
+    {
+      Ptr<NetDevice> ndTest = node->GetDevice (i);
+      NS_LOG_LOGIC ("Examine device " << i << " " << ndTest);
+
+      if (ndTest->IsBridge ())
+        {
+          NS_LOG_LOGIC ("device " << i << " is a bridge net device");
+          Ptr<BridgeNetDevice> bnd = ndTest->GetObject<BridgeNetDevice> ();
+          NS_ABORT_MSG_UNLESS (bnd, "Ipv4NixVectorGraph::NetDeviceIsBridged (): GetObject for <BridgeNetDevice> failed");
+
+          for (uint32_t j = 0; j < bnd->GetNBridgePorts (); ++j)
+            {
+              NS_LOG_LOGIC ("Examine bridge port " << j << " " << bnd->GetBridgePort (j));
+              if (bnd->GetBridgePort (j) == nd)
+                {
+                  NS_LOG_LOGIC ("Net device " << nd << " is bridged by " << bnd);
+                  return bnd;
+                }
+            }
+        }
+    }
+  NS_LOG_LOGIC ("Net device " << nd << " is not bridged");
+  return 0;
+}
+
+} // namespace ns3
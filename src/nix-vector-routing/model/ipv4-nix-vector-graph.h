@@ -0,0 +1,225 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef IPV4_NIX_VECTOR_GRAPH_H
+#define IPV4_NIX_VECTOR_GRAPH_H
+
+#include <stdint.h>
+#include <vector>
+#include <unordered_map>
+
+#include "ns3/ipv4-address.h"
+#include "ns3/net-device-container.h"
+#include "ns3/channel.h"
+#include "ns3/bridge-net-device.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup nix-vector-routing
+ *
+ * \brief Graph of the nodes, with the routing trees of the sources,
+ * shared by the nix-vector routing protocols of all the nodes
+ *
+ * The neighbors of a node are the nodes adjacent to its net devices, in
+ * the order of the devices, looking through the bridges: the neighbor
+ * index of a nix-vector hop is an index in this list.  The neighbors of
+ * all the nodes are held in a single array, the neighbors of node n at
+ * the indexes [offset[n], offset[n+1]) (compressed sparse rows).
+ *
+ * A routing tree is computed for a source when it first needs a route,
+ * by a breadth-first search from the source over its usable links, in
+ * the order of the neighbors: it gives every node its parent on a
+ * shortest path from the source, so that the routes to all the
+ * destinations are read from the tree.  A tie between paths as short
+ * goes to the first one discovered, as in a search per route.
+ *
+ * The graph is rebuilt when the interfaces of a node change.  The routing
+ * trees that the changes leave intact are kept: those using none of the
+ * links that went down, and to which none of the links that went up
+ * gives a path as short.  The others are recomputed on demand.
+ */
+class Ipv4NixVectorGraph
+{
+public:
+  /// A link from a node to one of its neighbors
+  struct Edge
+  {
+    uint32_t node;        //!< The neighbor
+    uint32_t device;      //!< The index of the net device of the node
+    uint32_t interface;   //!< The interface of the net device, or NONE if none
+    Ipv4Address gateway;  //!< The address of the neighbor on the link
+    bool up;              //!< Whether the node can send on the link
+  };
+
+  /// Value of the node and edge indexes standing for none
+  static const uint32_t NONE = 0xffffffff;
+
+  Ipv4NixVectorGraph ();
+
+  /**
+   * \brief Have the graph rebuilt on the next Update
+   *
+   * Called when the interfaces or addresses of a node change.
+   */
+  void Invalidate (void);
+
+  /**
+   * \brief Drop the graph and all the routing trees
+   */
+  void Clear (void);
+
+  /**
+   * \brief Rebuild the graph if it was invalidated, and drop the routing
+   * trees affected by the changes
+   */
+  void Update (void);
+
+  /**
+   * \param address an address
+   * \return the first node in the node list having the address, or NONE
+   */
+  uint32_t GetNodeByAddress (Ipv4Address address) const;
+
+  /**
+   * \param node a node
+   * \return an address of the node, preferably not a loopback one
+   */
+  Ipv4Address GetNodeAddress (uint32_t node) const;
+
+  /**
+   * \param node a node
+   * \return the number of neighbors of the node
+   */
+  uint32_t GetNNeighbors (uint32_t node) const;
+
+  /**
+   * \param node a node
+   * \param neighbor the neighbor index
+   * \return the link from the node to its neighbor
+   */
+  const Edge & GetEdge (uint32_t node, uint32_t neighbor) const;
+
+  /**
+   * \brief Find the route from a node to another one
+   *
+   * \param source the source node
+   * \param dest the destination node
+   * \param device the index of the net device of the source to leave
+   *        through, or NONE for any
+   * \param neighbors the neighbor indexes of the hops, from the source
+   * \return false if there is no route
+   */
+  bool GetRoute (uint32_t source, uint32_t dest, uint32_t device,
+                 std::vector<uint32_t> &neighbors);
+
+  /**
+   * \brief Compute the routing trees of sources not computed yet
+   *
+   * The trees are computed by the number of threads of the
+   * NixVectorRoutingThreads global value.
+   *
+   * \param sources the source nodes
+   */
+  void ComputeTrees (const std::vector<uint32_t> &sources);
+
+  /**
+   * \return whether the routing tree of a source is computed
+   * \param source the source node
+   */
+  bool IsTreeComputed (uint32_t source) const;
+
+  /**
+   * \brief Append the nodes adjacent to a net device on a channel, looking
+   * through the bridges
+   * \param [in] netDevice the NetDevice attached to the channel.
+   * \param [in] channel the channel to check
+   * \param [out] netDeviceContainer the NetDeviceContainer of the NetDevices in the channel.
+   */
+  static void GetAdjacentNetDevices (Ptr<NetDevice> netDevice, Ptr<Channel> channel,
+                                     NetDeviceContainer & netDeviceContainer);
+
+  /**
+   * Determine if the NetDevice is bridged
+   * \param nd the NetDevice to check
+   * \returns the bridging NetDevice (or null if the NetDevice is not bridged)
+   */
+  static Ptr<BridgeNetDevice> NetDeviceIsBridged (Ptr<NetDevice> nd);
+
+private:
+  /// Routing tree of a source: the edge from the parent of every node,
+  /// NONE if unreachable and for the source
+  typedef std::vector<uint32_t> Tree;
+
+  /// The routing trees of a range of sources, computed by a thread
+  struct Batch
+  {
+    Ipv4NixVectorGraph *graph;             //!< The graph
+    const std::vector<uint32_t> *sources;  //!< The sources
+    uint32_t first;                        //!< The first source of the batch
+    uint32_t step;                         //!< The stride between the sources of the batch
+    /// Compute the trees of the batch
+    void Run (void);
+  };
+
+  /**
+   * \brief Compute the routing tree of a source
+   *
+   * Only reads the graph, so that the trees of different sources can be
+   * computed in parallel.
+   *
+   * \param source the source node
+   * \param device the index of the net device of the source to leave
+   *        through, or NONE for any
+   * \param tree the computed tree
+   * \param queue a scratch queue of nodes
+   */
+  void ComputeTree (uint32_t source, uint32_t device, Tree &tree,
+                    std::vector<uint32_t> &queue) const;
+
+  /**
+   * \param edge a link
+   * \return the node the link leaves from
+   */
+  uint32_t GetEdgeSource (uint32_t edge) const;
+
+  /**
+   * \param tree a routing tree
+   * \param source the source of the tree
+   * \param node a node
+   * \return the number of hops from the source to the node, NONE if
+   * unreachable
+   */
+  uint32_t GetDistance (const Tree &tree, uint32_t source, uint32_t node) const;
+
+  /**
+   * \brief Build the graph of the current nodes
+   * \param offsets the offsets of the neighbors of the nodes
+   * \param edges the links to the neighbors
+   */
+  void Build (std::vector<uint32_t> &offsets, std::vector<Edge> &edges);
+
+  bool m_valid;                      //!< Whether the graph follows the nodes
+  std::vector<uint32_t> m_offsets;   //!< Index of the first neighbor of the nodes, then the number of edges
+  std::vector<Edge> m_edges;         //!< Links of the nodes to their neighbors
+  std::vector<Tree> m_trees;         //!< Routing trees of the nodes, empty if not computed
+  std::unordered_map<Ipv4Address, uint32_t, Ipv4AddressHash> m_addressNodes; //!< Nodes of the addresses
+  std::vector<Ipv4Address> m_nodeAddresses; //!< An address of the nodes
+};
+
+} // namespace ns3
+
+#endif /* IPV4_NIX_VECTOR_GRAPH_H */
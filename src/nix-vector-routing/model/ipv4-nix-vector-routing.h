@@ -21,8 +21,6 @@
 #ifndef IPV4_NIX_VECTOR_ROUTING_H
 #define IPV4_NIX_VECTOR_ROUTING_H
 
-#include <map>
-
 #include "ns3/channel.h"
 #include "ns3/node-container.h"
 #include "ns3/node-list.h"
@@ -32,6 +30,7 @@
 #include "ns3/nix-vector.h"
 #include "ns3/bridge-net-device.h"
 #include "ns3/nstime.h"
+#include "ipv4-nix-vector-graph.h"
 
 namespace ns3 {
 
@@ -42,20 +41,12 @@ namespace ns3 {
  * intended for large network topologies.
  */
 
-/**
- * \ingroup nix-vector-routing
- * Map of Ipv4Address to NixVector
- */
-typedef std::map<Ipv4Address, Ptr<NixVector> > NixMap_t;
-/**
- * \ingroup nix-vector-routing
- * Map of Ipv4Address to Ipv4Route
- */
-typedef std::map<Ipv4Address, Ptr<Ipv4Route> > Ipv4RouteMap_t;
-
 /**
  * \ingroup nix-vector-routing
  * Nix-vector routing protocol
+ *
+ * The routes are read from an Ipv4NixVectorGraph shared by the protocols
+ * of all the nodes, holding the routing trees of the sources.
  */
 class Ipv4NixVectorRouting : public Ipv4RoutingProtocol
 {
@@ -78,135 +69,48 @@ public:
 
   /**
    * @brief Called when run-time link topology change occurs
-   * which iterates through the node list and flushes any
-   * nix vector caches
+   * which flushes the routes of all the nodes
    *
    * \internal
    * \c const is used here due to need to potentially flush the cache
-   * in const methods such as PrintRoutingTable.  Caches are stored in
-   * mutable variables and flushed in const methods.
+   * in const methods such as PrintRoutingTable.  The routes are shared
+   * by the nodes and flushed in const methods.
    */
   void FlushGlobalNixRoutingCache (void) const;
 
-private:
-
-  /**
-   * Flushes the cache which stores nix-vector based on
-   * destination IP
-   */
-  void FlushNixCache (void) const;
-
   /**
-   * Flushes the cache which stores the Ipv4 route
-   * based on the destination IP
+   * @brief Compute the routes from some nodes, to all the nodes
+   *
+   * The routes from a node are otherwise computed when it first sends a
+   * packet.  They are computed by the number of threads of the
+   * NixVectorRoutingThreads global value.
+   *
+   * \param sources the source nodes
    */
-  void FlushIpv4RouteCache (void) const;
+  static void ComputeRoutes (NodeContainer sources);
 
-  /**
-   * Upon a run-time topology change caches are
-   * flushed and the total number of neighbors is
-   * reset to zero
-   */
-  void ResetTotalNeighbors (void);
+private:
 
   /**
-   * Takes in the source node and dest IP and calls GetNodeByIp,
-   * BFS, accounting for any output interface specified, and finally
-   * BuildNixVector to return the built nix-vector
+   * Takes in the source node and dest IP, finds the destination node and
+   * builds the nix-vector of the route, accounting for any output
+   * interface specified
    *
    * \param source Source node
    * \param dest Destination node address
    * \param oif Preferred output interface
    * \returns The NixVector to be used in routing.
    */
-  Ptr<NixVector> GetNixVector (Ptr<Node> source, Ipv4Address dest, Ptr<NetDevice> oif);
+  Ptr<NixVector> GetNixVector (Ptr<Node> source, Ipv4Address dest, Ptr<NetDevice> oif) const;
 
   /**
-   * Checks the cache based on dest IP for the nix-vector
-   * \param address Address to check
-   * \returns The NixVector to be used in routing.
+   * Builds the route to the neighbor of a nix-vector hop
+   * \param dest Destination address
+   * \param nodeIndex Nix neighbor index
+   * \param oif Specified output interface, or null
+   * \returns The route, or null if there is no such neighbor
    */
-  Ptr<NixVector> GetNixVectorInCache (Ipv4Address address);
-
-  /**
-   * Checks the cache based on dest IP for the Ipv4Route
-   * \param address Address to check
-   * \returns The cached route.
-   */
-  Ptr<Ipv4Route> GetIpv4RouteInCache (Ipv4Address address);
-
-  /**
-   * Given a net-device returns all the adjacent net-devices,
-   * essentially getting the neighbors on that channel
-   * \param [in] netDevice the NetDevice attached to the channel.
-   * \param [in] channel the channel to check
-   * \param [out] netDeviceContainer the NetDeviceContainer of the NetDevices in the channel.
-   */
-  void GetAdjacentNetDevices (Ptr<NetDevice> netDevice, Ptr<Channel> channel, NetDeviceContainer & netDeviceContainer);
-
-  /**
-   * Iterates through the node list and finds the one
-   * corresponding to the given Ipv4Address
-   * \param dest detination node IP
-   * \return The node with the specified IP.
-   */
-  Ptr<Node> GetNodeByIp (Ipv4Address dest);
-
-  /**
-   * Recurses the parent vector, created by BFS and actually builds the nixvector
-   * \param [in] parentVector Parent vector for retracing routes
-   * \param [in] source Source Node index
-   * \param [in] dest Destination Node index
-   * \param [out] nixVector the NixVector to be used for routing
-   * \returns true on success, false otherwise.
-   */
-  bool BuildNixVector (const std::vector< Ptr<Node> > & parentVector, uint32_t source, uint32_t dest, Ptr<NixVector> nixVector);
-
-  /**
-   * Special variation of BuildNixVector for when a node is sending to itself
-   * \param [out] nixVector the NixVector to be used for routing
-   * \returns true on success, false otherwise.
-   */
-  bool BuildNixVectorLocal (Ptr<NixVector> nixVector);
-
-  /**
-   * Simple iterates through the nodes net-devices and determines
-   * how many neighbors it has
-   * \returns the number of neighbors.
-   */
-  uint32_t FindTotalNeighbors (void);
-
-  /**
-   * Determine if the NetDevice is bridged
-   * \param nd the NetDevice to check
-   * \returns the bridging NetDevice (or null if the NetDevice is not bridged)
-   */
-  Ptr<BridgeNetDevice> NetDeviceIsBridged (Ptr<NetDevice> nd) const;
-
-
-  /**
-   * Nix index is with respect to the neighbors.  The net-device index must be
-   * derived from this
-   * \param [in] nodeIndex Nix Node index
-   * \param [out] gatewayIp IP address of the gateway
-   * \returns the index of the NetDevice in the node.
-   */
-  uint32_t FindNetDeviceForNixIndex (uint32_t nodeIndex, Ipv4Address & gatewayIp);
-
-  /**
-   * \brief Breadth first search algorithm.
-   * \param [in] numberOfNodes total number of nodes
-   * \param [in] source Source Node
-   * \param [in] dest Destination Node
-   * \param [out] parentVector Parent vector for retracing routes
-   * \param [in] oif specific output interface to use from source node, if not null
-   * \returns false if dest not found, true o.w.
-   */
-  bool BFS (uint32_t numberOfNodes,
-            Ptr<Node> source,
-            Ptr<Node> dest,
-            std::vector< Ptr<Node> > & parentVector,
-            Ptr<NetDevice> oif);
+  Ptr<Ipv4Route> GetIpv4Route (Ipv4Address dest, uint32_t nodeIndex, Ptr<NetDevice> oif) const;
 
   void DoDispose (void);
 
@@ -223,27 +127,17 @@ private:
   virtual void PrintRoutingTable (Ptr<OutputStreamWrapper> stream, Time::Unit unit = Time::S) const;
  
   /**
-   * Flushes routing caches if required.
+   * Updates the shared routing state after topology changes.
    */
   void CheckCacheStateAndFlush (void) const;
 
-  /**
-   * Flag to mark when caches are dirty and need to be flushed.  
-   * Used for lazy cleanup of caches when there are many topology changes.
-   */
-  static bool g_isCacheDirty;
-
-  /** Cache stores nix-vectors based on destination ip */
-  mutable NixMap_t m_nixCache;
-
-  /** Cache stores Ipv4Routes based on destination ip */
-  mutable Ipv4RouteMap_t m_ipv4RouteCache;
+  /** Routing state shared by the nodes */
+  static Ipv4NixVectorGraph g_graph;
+  /** Number of protocols not disposed of, sharing g_graph */
+  static uint32_t g_nProtocols;
 
   Ptr<Ipv4> m_ipv4; //!< IPv4 object
   Ptr<Node> m_node; //!< Node object
-
-  /** Total neighbors used for nix-vector to determine number of bits */
-  uint32_t m_totalNeighbors;
 };
 } // namespace ns3
 
@@ -0,0 +1,350 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <queue>
+#include <sstream>
+#include <vector>
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/node-container.h"
+#include "ns3/node-list.h"
+#include "ns3/packet.h"
+#include "ns3/output-stream-wrapper.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/ipv4.h"
+#include "ns3/ipv4-nix-vector-helper.h"
+#include "ns3/ipv4-nix-vector-routing.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup nix-vector-routing
+ * \defgroup nix-vector-routing-test Nix-vector routing tests
+ */
+
+/**
+ * \ingroup nix-vector-routing-test
+ * \ingroup tests
+ *
+ * \brief Nix-vector routes, compared with a breadth-first search per
+ * route
+ *
+ * The reference is the search the routing trees replaced: from the
+ * source, over the net devices of every node in order, the first node
+ * discovering another one being its parent.  The topology has paths as
+ * short between several pairs of nodes, on which a search from the
+ * destination would break the ties the other way:
+ *
+ * \verbatim
+          n1 ------ n4
+         /            \
+       n0              n5
+         \            / |
+          n2 ------ n3  |
+           \        |   |
+            +--LAN--+-- n6
+   \endverbatim
+ *
+ * Every packet is followed hop by hop through RouteOutput and
+ * RouteInput, with all the routes as the interface of n1 to n4 goes
+ * down and up again, then with an output device bound.
+ */
+class Ipv4NixVectorRoutingTestCase : public TestCase
+{
+public:
+  Ipv4NixVectorRoutingTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Find the route of the reference search
+   * \param source the source node
+   * \param dest the destination node
+   * \param oif the net device of the source to leave through, or null
+   * \return the nodes of the route, from the source, or empty if none
+   */
+  static std::vector<uint32_t> ReferenceRoute (Ptr<Node> source, Ptr<Node> dest,
+                                               Ptr<NetDevice> oif);
+
+  /**
+   * \brief Send a packet through the routing protocols of the nodes
+   * \param source the source node
+   * \param dest the destination node
+   * \param oif the net device of the source to leave through, or null
+   * \return the nodes the packet went through, from the source, or empty
+   * if it was not delivered
+   */
+  std::vector<uint32_t> Follow (Ptr<Node> source, Ptr<Node> dest, Ptr<NetDevice> oif);
+
+  /**
+   * \brief Check the routes between all the pairs of nodes
+   * \param step the name of the step
+   */
+  void CheckAllRoutes (std::string step);
+
+  /**
+   * Unicast forward callback
+   * \param route the route
+   * \param p the packet
+   * \param header the IP header
+   */
+  void Forward (Ptr<Ipv4Route> route, Ptr<const Packet> p, const Ipv4Header &header);
+  /**
+   * Local deliver callback
+   * \param p the packet
+   * \param header the IP header
+   * \param iif the input interface
+   */
+  void Deliver (Ptr<const Packet> p, const Ipv4Header &header, uint32_t iif);
+
+  Ptr<Ipv4Route> m_forwardRoute; //!< Route given to the forward callback
+  bool m_delivered;              //!< Whether the deliver callback was called
+};
+
+Ipv4NixVectorRoutingTestCase::Ipv4NixVectorRoutingTestCase ()
+  : TestCase ("Nix-vector routes match a breadth-first search from the source"),
+    m_delivered (false)
+{
+}
+
+void
+Ipv4NixVectorRoutingTestCase::Forward (Ptr<Ipv4Route> route, Ptr<const Packet> p, const Ipv4Header &header)
+{
+  m_forwardRoute = route;
+}
+
+void
+Ipv4NixVectorRoutingTestCase::Deliver (Ptr<const Packet> p, const Ipv4Header &header, uint32_t iif)
+{
+  m_delivered = true;
+}
+
+std::vector<uint32_t>
+Ipv4NixVectorRoutingTestCase::ReferenceRoute (Ptr<Node> source, Ptr<Node> dest, Ptr<NetDevice> oif)
+{
+  std::vector<Ptr<Node> > parents (NodeList::GetNNodes ());
+  std::queue<Ptr<Node> > queue;
+  parents[source->GetId ()] = source;
+  queue.push (source);
+  while (!queue.empty ())
+    {
+      Ptr<Node> node = queue.front ();
+      queue.pop ();
+      Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+      for (uint32_t i = 0; i < node->GetNDevices (); i++)
+        {
+          Ptr<NetDevice> device = node->GetDevice (i);
+          if (node == source && oif && device != oif)
+            {
+              continue;
+            }
+          int32_t interface = ipv4->GetInterfaceForDevice (device);
+          if (interface == -1 || !ipv4->IsUp (interface) || !device->IsLinkUp ()
+              || device->GetChannel () == 0)
+            {
+              continue;
+            }
+          NetDeviceContainer adjacent;
+          Ipv4NixVectorGraph::GetAdjacentNetDevices (device, device->GetChannel (), adjacent);
+          for (NetDeviceContainer::Iterator j = adjacent.Begin (); j != adjacent.End (); j++)
+            {
+              Ptr<Node> neighbor = (*j)->GetNode ();
+              if (parents[neighbor->GetId ()] == 0)
+                {
+                  parents[neighbor->GetId ()] = node;
+                  queue.push (neighbor);
+                }
+            }
+        }
+    }
+
+  std::vector<uint32_t> route;
+  if (parents[dest->GetId ()] == 0)
+    {
+      return route;
+    }
+  for (Ptr<Node> node = dest; node != source; node = parents[node->GetId ()])
+    {
+      route.insert (route.begin (), node->GetId ());
+    }
+  route.insert (route.begin (), source->GetId ());
+  return route;
+}
+
+std::vector<uint32_t>
+Ipv4NixVectorRoutingTestCase::Follow (Ptr<Node> source, Ptr<Node> dest, Ptr<NetDevice> oif)
+{
+  Ptr<Packet> packet = Create<Packet> ();
+  Ipv4Header header;
+  header.SetDestination (dest->GetObject<Ipv4> ()->GetAddress (1, 0).GetLocal ());
+  Socket::SocketErrno err;
+  Ptr<Ipv4Route> route = source->GetObject<Ipv4> ()->GetRoutingProtocol ()->RouteOutput (packet, header, oif, err);
+  std::vector<uint32_t> nodes (1, source->GetId ());
+  m_delivered = false;
+  while (route != 0 && nodes.size () < NodeList::GetNNodes ())
+    {
+      // The device of the gateway on the channel
+      Ptr<NetDevice> device = route->GetOutputDevice ();
+      Ptr<Channel> channel = device->GetChannel ();
+      Ptr<NetDevice> peer;
+      for (uint32_t i = 0; i < channel->GetNDevices (); i++)
+        {
+          Ptr<NetDevice> d = channel->GetDevice (i);
+          Ptr<Ipv4> ipv4 = d->GetNode ()->GetObject<Ipv4> ();
+          if (d != device && ipv4->GetAddress (ipv4->GetInterfaceForDevice (d), 0).GetLocal () == route->GetGateway ())
+            {
+              peer = d;
+            }
+        }
+      NS_ASSERT_MSG (peer, "No device with the gateway address " << route->GetGateway ());
+      nodes.push_back (peer->GetNode ()->GetId ());
+      m_forwardRoute = 0;
+      peer->GetNode ()->GetObject<Ipv4> ()->GetRoutingProtocol ()->RouteInput (
+        packet, header, peer,
+        MakeCallback (&Ipv4NixVectorRoutingTestCase::Forward, this),
+        Ipv4RoutingProtocol::MulticastForwardCallback (),
+        MakeCallback (&Ipv4NixVectorRoutingTestCase::Deliver, this),
+        Ipv4RoutingProtocol::ErrorCallback ());
+      route = m_forwardRoute;
+    }
+  if (!m_delivered)
+    {
+      nodes.clear ();
+    }
+  return nodes;
+}
+
+/**
+ * \param route the nodes of a route
+ * \return the route as text
+ */
+static std::string
+RouteToString (const std::vector<uint32_t> &route)
+{
+  std::ostringstream os;
+  for (uint32_t i = 0; i < route.size (); i++)
+    {
+      os << (i ? "-" : "") << route[i];
+    }
+  return os.str ();
+}
+
+void
+Ipv4NixVectorRoutingTestCase::CheckAllRoutes (std::string step)
+{
+  for (uint32_t s = 0; s < NodeList::GetNNodes (); s++)
+    {
+      for (uint32_t d = 0; d < NodeList::GetNNodes (); d++)
+        {
+          if (s == d)
+            {
+              continue;
+            }
+          Ptr<Node> source = NodeList::GetNode (s);
+          Ptr<Node> dest = NodeList::GetNode (d);
+          NS_TEST_EXPECT_MSG_EQ (RouteToString (Follow (source, dest, 0)),
+                                 RouteToString (ReferenceRoute (source, dest, 0)),
+                                 step << ": route from n" << s << " to n" << d);
+        }
+    }
+}
+
+void
+Ipv4NixVectorRoutingTestCase::DoRun (void)
+{
+  NodeContainer nodes;
+  nodes.Create (7);
+
+  Ipv4NixVectorHelper nixRouting;
+  InternetStackHelper internet;
+  internet.SetRoutingHelper (nixRouting);
+  internet.Install (nodes);
+
+  SimpleNetDeviceHelper simple;
+  Ipv4AddressHelper address ("10.1.1.0", "255.255.255.0");
+  uint32_t links[][2] = { { 0, 1 }, { 0, 2 }, { 1, 4 }, { 2, 3 }, { 3, 5 }, { 4, 5 }, { 6, 5 } };
+  NetDeviceContainer n1n4;
+  for (uint32_t i = 0; i < sizeof (links) / sizeof (links[0]); i++)
+    {
+      NetDeviceContainer devices = simple.Install (NodeContainer (nodes.Get (links[i][0]), nodes.Get (links[i][1])));
+      address.Assign (devices);
+      address.NewNetwork ();
+      if (i == 2)
+        {
+          n1n4 = devices;
+        }
+    }
+  NetDeviceContainer lan = simple.Install (NodeContainer (nodes.Get (2), nodes.Get (3), nodes.Get (6)));
+  address.Assign (lan);
+
+  // The first path discovered from n0 wins the tie with n0-n2-n3-n5
+  NS_TEST_ASSERT_MSG_EQ (RouteToString (Follow (nodes.Get (0), nodes.Get (5), 0)), "0-1-4-5",
+                         "Tie not broken as by a search from the source");
+  CheckAllRoutes ("Initial routes");
+
+  Ptr<Ipv4> ipv4 = nodes.Get (1)->GetObject<Ipv4> ();
+  uint32_t interface = ipv4->GetInterfaceForDevice (n1n4.Get (0));
+  ipv4->SetDown (interface);
+  NS_TEST_ASSERT_MSG_EQ (RouteToString (Follow (nodes.Get (0), nodes.Get (5), 0)), "0-2-3-5",
+                         "Route not updated when the link went down");
+  CheckAllRoutes ("Interface down");
+
+  ipv4->SetUp (interface);
+  NS_TEST_ASSERT_MSG_EQ (RouteToString (Follow (nodes.Get (0), nodes.Get (5), 0)), "0-1-4-5",
+                         "Route not restored when the link went up");
+  CheckAllRoutes ("Interface up again");
+
+  // Bound to the LAN, n2 goes around the loop to reach n0
+  Ptr<NetDevice> oif = lan.Get (0);
+  NS_TEST_EXPECT_MSG_EQ (RouteToString (Follow (nodes.Get (2), nodes.Get (0), oif)),
+                         RouteToString (ReferenceRoute (nodes.Get (2), nodes.Get (0), oif)),
+                         "Route bound to an output device");
+  NS_TEST_EXPECT_MSG_EQ (RouteToString (Follow (nodes.Get (2), nodes.Get (0), oif)), "2-3-5-4-1-0",
+                         "Route bound to an output device");
+
+  // The routes are shared: disposing of a protocol keeps those of the others
+  Ptr<Ipv4NixVectorRouting> spare = CreateObject<Ipv4NixVectorRouting> ();
+  spare->Dispose ();
+  std::ostringstream table;
+  ipv4->GetRoutingProtocol ()->PrintRoutingTable (Create<OutputStreamWrapper> (&table));
+  NS_TEST_EXPECT_MSG_NE (table.str ().find ("Destination"), std::string::npos,
+                         "Routes dropped with another protocol:\n" << table.str ());
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup nix-vector-routing-test
+ * \ingroup tests
+ *
+ * \brief Nix-vector routing TestSuite
+ */
+class Ipv4NixVectorRoutingTestSuite : public TestSuite
+{
+public:
+  Ipv4NixVectorRoutingTestSuite ()
+    : TestSuite ("ipv4-nix-vector-routing", UNIT)
+  {
+    AddTestCase (new Ipv4NixVectorRoutingTestCase (), TestCase::QUICK);
+  }
+};
+
+static Ipv4NixVectorRoutingTestSuite g_ipv4NixVectorRoutingTestSuite; //!< Static variable for test initialization
@@ -26,6 +26,7 @@
 #include "ns3/uinteger.h"
 #include "ns3/pointer.h"
 #include "ns3/net-device-queue-interface.h"
+#include "ns3/gso-tag.h"
 #include "point-to-point-net-device.h"
 #include "point-to-point-channel.h"
 #include "ppp-header.h"
@@ -284,7 +285,7 @@ PointToPointNetDevice::TransmitStart (Ptr<Packet> p)
   m_currentPkt = p;
   m_phyTxBeginTrace (m_currentPkt);
 
-  Time txTime = m_bps.CalculateBytesTxTime (p->GetSize ());
+  Time txTime = GetTxTime (p);
   Time txCompleteTime = txTime + m_tInterframeGap;
 
   NS_LOG_LOGIC ("Schedule TransmitCompleteEvent in " << txCompleteTime.GetSeconds () << "sec");
@@ -298,6 +299,27 @@ PointToPointNetDevice::TransmitStart (Ptr<Packet> p)
   return result;
 }
 
+Time
+PointToPointNetDevice::GetTxTime (Ptr<const Packet> p) const
+{
+  GsoTag gso;
+  if (!p->PeekPacketTag (gso))
+    {
+      return m_bps.CalculateBytesTxTime (p->GetSize ());
+    }
+  uint32_t headers = p->GetSize () - gso.GetPayloadSize ();
+  Time txTime = Seconds (0);
+  for (uint32_t i = 0; i < gso.GetNSegments (); i++)
+    {
+      if (i > 0)
+        {
+          txTime += m_tInterframeGap;
+        }
+      txTime += m_bps.CalculateBytesTxTime (headers + gso.GetSegmentPayloadSize (i));
+    }
+  return txTime;
+}
+
 void
 PointToPointNetDevice::TransmitComplete (void)
 {
@@ -327,8 +349,7 @@ PointToPointNetDevice::TransmitComplete (void)
   //
   // Got another packet off of the queue, so start the transmit process again.
   //
-  m_snifferTrace (p);
-  m_promiscSnifferTrace (p);
+  Sniff (p, true);
   TransmitStart (p);
 }
 
@@ -370,7 +391,7 @@ PointToPointNetDevice::Receive (Ptr<Packet> packet)
   NS_LOG_FUNCTION (this << packet);
   uint16_t protocol = 0;
 
-  if (m_receiveErrorModel && m_receiveErrorModel->IsCorrupt (packet) ) 
+  if (m_receiveErrorModel && IsCorrupt (packet))
     {
       // 
       // If we have an error model and it indicates that it is time to lose a
@@ -385,8 +406,7 @@ PointToPointNetDevice::Receive (Ptr<Packet> packet)
       // device because it is so simple, but this is not usually the case in
       // more complicated devices.
       //
-      m_snifferTrace (packet);
-      m_promiscSnifferTrace (packet);
+      Sniff (packet, false);
       m_phyRxEndTrace (packet);
 
       //
@@ -414,6 +434,150 @@ PointToPointNetDevice::Receive (Ptr<Packet> packet)
     }
 }
 
+bool
+PointToPointNetDevice::IsCorrupt (Ptr<Packet> packet)
+{
+  NS_LOG_FUNCTION (this << packet);
+  GsoTag gso;
+  if (!packet->PeekPacketTag (gso))
+    {
+      return m_receiveErrorModel->IsCorrupt (packet);
+    }
+
+  //
+  // The error model decides the fate of each segment of a super-segment
+  // separately.  The transport protocol skips the segments marked as lost.
+  //
+  uint32_t headers = packet->GetSize () - gso.GetPayloadSize ();
+  uint32_t nLost = 0;
+  uint32_t offset = headers;
+  bool lost = false;
+  for (uint32_t i = 0; i < gso.GetNSegments (); i++)
+    {
+      uint32_t size = gso.GetSegmentPayloadSize (i);
+      if (gso.IsLost (i))
+        {
+          // lost on a previous link, so it is not on this one
+          nLost++;
+        }
+      else
+        {
+          Ptr<Packet> segment = packet->CreateFragment (0, headers);
+          segment->AddAtEnd (packet->CreateFragment (offset, size));
+          GsoTag segmentTag;
+          segment->RemovePacketTag (segmentTag);
+          if (m_receiveErrorModel->IsCorrupt (segment))
+            {
+              gso.SetLost (i);
+              nLost++;
+              lost = true;
+            }
+        }
+      offset += size;
+    }
+  if (lost)
+    {
+      packet->ReplacePacketTag (gso);
+    }
+  return nLost == gso.GetNSegments ();
+}
+
+bool
+PointToPointNetDevice::Enqueue (Ptr<Packet> packet, uint16_t protocolNumber)
+{
+  NS_LOG_FUNCTION (this << packet << protocolNumber);
+
+  //
+  // Stick a point to point protocol header on the packet in preparation for
+  // shoving it out the door.
+  //
+  AddHeader (packet, protocolNumber);
+
+  std::list<Ptr<Packet> > frames;
+  GsoTag gso;
+  GsoTag::Segmenter segmenter;
+  if (packet->PeekPacketTag (gso) && m_queue->GetCurrentSize () + packet > m_queue->GetMaxSize ())
+    {
+      segmenter = GsoTag::GetSegmenter (protocolNumber);
+    }
+  if (!segmenter.IsNull ())
+    {
+      // The super-segment does not fit whole: enqueue its segments, so
+      // that only those which do not fit are dropped
+      PppHeader ppp;
+      packet->RemoveHeader (ppp);
+      frames = segmenter (packet);
+      for (std::list<Ptr<Packet> >::iterator it = frames.begin (); it != frames.end (); ++it)
+        {
+          (*it)->AddHeader (ppp);
+        }
+    }
+  else
+    {
+      frames.push_back (packet);
+    }
+
+  bool enqueued = false;
+  for (std::list<Ptr<Packet> >::iterator it = frames.begin (); it != frames.end (); ++it)
+    {
+      m_macTxTrace (*it);
+      if (m_queue->Enqueue (*it))
+        {
+          enqueued = true;
+        }
+      else
+        {
+          m_macTxDropTrace (*it);
+        }
+    }
+  return enqueued;
+}
+
+void
+PointToPointNetDevice::Sniff (Ptr<const Packet> packet, bool transmit)
+{
+  GsoTag gso;
+  if ((m_snifferTrace.IsEmpty () && m_promiscSnifferTrace.IsEmpty ())
+      || !packet->PeekPacketTag (gso))
+    {
+      SniffFrame (packet);
+      return;
+    }
+
+  Ptr<Packet> p = packet->Copy ();
+  PppHeader ppp;
+  p->RemoveHeader (ppp);
+  GsoTag::Segmenter segmenter = GsoTag::GetSegmenter (PppToEther (ppp.GetProtocol ()));
+  if (segmenter.IsNull ())
+    {
+      SniffFrame (packet);
+      return;
+    }
+
+  std::list<Ptr<Packet> > segments = segmenter (p);
+  Time start = Seconds (0);
+  for (std::list<Ptr<Packet> >::iterator it = segments.begin (); it != segments.end (); ++it)
+    {
+      (*it)->AddHeader (ppp);
+      if (!transmit || start.IsZero ())
+        {
+          SniffFrame (*it);
+        }
+      else
+        {
+          Simulator::Schedule (start, &PointToPointNetDevice::SniffFrame, this, *it);
+        }
+      start += m_bps.CalculateBytesTxTime ((*it)->GetSize ()) + m_tInterframeGap;
+    }
+}
+
+void
+PointToPointNetDevice::SniffFrame (Ptr<const Packet> packet)
+{
+  m_snifferTrace (packet);
+  m_promiscSnifferTrace (packet);
+}
+
 Ptr<Queue<Packet> >
 PointToPointNetDevice::GetQueue (void) const
 { 
@@ -559,18 +723,10 @@ PointToPointNetDevice::Send (
       return false;
     }
 
-  //
-  // Stick a point to point protocol header on the packet in preparation for
-  // shoving it out the door.
-  //
-  AddHeader (packet, protocolNumber);
-
-  m_macTxTrace (packet);
-
   //
   // We should enqueue and dequeue the packet to hit the tracing hooks.
   //
-  if (m_queue->Enqueue (packet))
+  if (Enqueue (packet, protocolNumber))
     {
       //
       // If the channel is ready for transition we send the packet right now
@@ -578,8 +734,7 @@ PointToPointNetDevice::Send (
       if (m_txMachineState == READY)
         {
           packet = m_queue->Dequeue ();
-          m_snifferTrace (packet);
-          m_promiscSnifferTrace (packet);
+          Sniff (packet, true);
           bool ret = TransmitStart (packet);
           return ret;
         }
@@ -587,11 +742,47 @@ PointToPointNetDevice::Send (
     }
 
   // Enqueue may fail (overflow)
-
-  m_macTxDropTrace (packet);
   return false;
 }
 
+uint32_t
+PointToPointNetDevice::SendBatch (const std::vector<Ptr<QueueDiscItem> > &items)
+{
+  NS_LOG_FUNCTION (this << items.size ());
+
+  if (IsLinkUp () == false)
+    {
+      for (uint32_t i = 0; i < items.size (); i++)
+        {
+          m_macTxDropTrace (items[i]->GetPacket ());
+        }
+      return items.size ();
+    }
+
+  Ptr<NetDeviceQueue> txq = m_queueInterface ? m_queueInterface->GetTxQueue (0) : 0;
+  uint32_t sent = 0;
+  for (; sent < items.size (); sent++)
+    {
+      if (txq && txq->IsStopped ())
+        {
+          break;
+        }
+      Enqueue (items[sent]->GetPacket (), items[sent]->GetProtocol ());
+    }
+
+  //
+  // Like a driver honoring xmit_more, only kick the transmitter once the
+  // whole burst is in the queue.
+  //
+  if (m_txMachineState == READY && !m_queue->IsEmpty ())
+    {
+      Ptr<Packet> packet = m_queue->Dequeue ();
+      Sniff (packet, true);
+      TransmitStart (packet);
+    }
+  return sent;
+}
+
 bool
 PointToPointNetDevice::SendFrom (Ptr<Packet> packet, 
                                  const Address &source, 
@@ -641,6 +832,13 @@ PointToPointNetDevice::SupportsSendFrom (void) const
   return false;
 }
 
+bool
+PointToPointNetDevice::SupportsGso (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return true;
+}
+
 void
 PointToPointNetDevice::DoMpiReceive (Ptr<Packet> p)
 {
@@ -178,6 +178,7 @@ public:
 
   virtual bool Send (Ptr<Packet> packet, const Address &dest, uint16_t protocolNumber);
   virtual bool SendFrom (Ptr<Packet> packet, const Address& source, const Address& dest, uint16_t protocolNumber);
+  virtual uint32_t SendBatch (const std::vector<Ptr<QueueDiscItem> > &items);
 
   virtual Ptr<Node> GetNode (void) const;
   virtual void SetNode (Ptr<Node> node);
@@ -190,6 +191,7 @@ public:
 
   virtual void SetPromiscReceiveCallback (PromiscReceiveCallback cb);
   virtual bool SupportsSendFrom (void) const;
+  virtual bool SupportsGso (void) const;
 
 protected:
   /**
@@ -254,6 +256,19 @@ private:
    */
   bool ProcessHeader (Ptr<Packet> p, uint16_t& param);
 
+  /**
+   * \brief Add the PPP header to a packet and enqueue it in the device queue
+   *
+   * A super-segment (see GsoTag) which the queue cannot hold whole is
+   * enqueued as its segments, so that only those which do not fit are
+   * dropped.
+   *
+   * \param packet the packet, starting with the header of its protocol
+   * \param protocolNumber the protocol number
+   * \return true if the packet, or one of its segments, was enqueued
+   */
+  bool Enqueue (Ptr<Packet> packet, uint16_t protocolNumber);
+
   /**
    * Start Sending a Packet Down the Wire.
    *
@@ -271,6 +286,50 @@ private:
    */
   bool TransmitStart (Ptr<Packet> p);
 
+  /**
+   * \brief Compute the time needed to put a packet on the wire
+   *
+   * A super-segment (see GsoTag) takes the time its segments would take
+   * if they were transmitted back to back, each one with its own copy of
+   * the headers and separated by the interframe gap.
+   *
+   * \param p the packet
+   * \return the transmission time
+   */
+  Time GetTxTime (Ptr<const Packet> p) const;
+
+  /**
+   * \brief Apply the receive error model to a packet
+   *
+   * The segments of a super-segment (see GsoTag) are corrupted
+   * independently of each other: the error model is applied to a copy of
+   * the packet holding the headers and the payload of each segment, in
+   * turn.  The lost segments are marked in the tag.
+   *
+   * \param packet the received packet
+   * \return true if the whole packet is corrupted
+   */
+  bool IsCorrupt (Ptr<Packet> packet);
+
+  /**
+   * \brief Hit the sniffer trace hooks with a packet
+   *
+   * The sniffers see the segments of a super-segment (see GsoTag) as the
+   * separate frames they stand for on the wire.  When transmitting, each
+   * segment is traced when it would start; when receiving, all segments
+   * are traced when the super-segment has been received.
+   *
+   * \param packet the packet, with its PPP header
+   * \param transmit true if the packet is being transmitted
+   */
+  void Sniff (Ptr<const Packet> packet, bool transmit);
+
+  /**
+   * \brief Hit the sniffer trace hooks with a frame
+   * \param packet the frame
+   */
+  void SniffFrame (Ptr<const Packet> packet);
+
   /**
    * Stop Sending a Packet Down the Wire and Begin the Interframe Gap.
    *
@@ -0,0 +1,125 @@
+"""
+Read a columnar file written by a ColumnarFileWriter, ColumnarAggregator or
+ColumnarDataOutput, and print it as CSV.
+
+read_columns() returns an ordered dictionary of the columns of the file,
+each a list of its values; it may be passed as is to pandas.DataFrame.
+"""
+import collections
+import csv
+import struct
+import sys
+
+## The magic bytes at the start and the end of a columnar file
+MAGIC = b'NS3COLF1'
+
+## The column types
+INTEGER, DOUBLE, STRING = 0, 1, 2
+
+_DOUBLE = struct.Struct('<d')
+_UINT64 = struct.Struct('<Q')
+
+
+def _varint(data, pos):
+    """Return the variable-length integer at pos, and the position after it."""
+    value = 0
+    shift = 0
+    while True:
+        byte = bytearray(data[pos:pos + 1])[0]
+        pos += 1
+        value |= (byte & 0x7f) << shift
+        if byte < 0x80:
+            return value, pos
+        shift += 7
+
+
+def _decode_integers(chunk, n_rows):
+    values = []
+    previous = 0
+    pos = 0
+    for _ in range(n_rows):
+        zigzag, pos = _varint(chunk, pos)
+        delta = (zigzag >> 1) ^ -(zigzag & 1)
+        previous = (previous + delta) & 0xffffffffffffffff
+        values.append(previous - (1 << 64) if previous >> 63 else previous)
+    return values
+
+
+def _decode_doubles(chunk, n_rows):
+    values = []
+    previous = 0
+    chunk = bytearray(chunk)
+    pos = 0
+    for _ in range(n_rows):
+        control = chunk[pos]
+        pos += 1
+        leading, trailing = control >> 4, control & 0x0f
+        x = 0
+        for b in range(trailing, 8 - leading):
+            x |= chunk[pos] << (8 * b)
+            pos += 1
+        previous ^= x
+        values.append(_DOUBLE.unpack(_UINT64.pack(previous))[0])
+    return values
+
+
+def _decode_strings(chunk, n_rows):
+    n_entries, pos = _varint(chunk, 0)
+    dictionary = []
+    for _ in range(n_entries):
+        length, pos = _varint(chunk, pos)
+        dictionary.append(chunk[pos:pos + length].decode('utf-8'))
+        pos += length
+    values = []
+    for _ in range(n_rows):
+        index, pos = _varint(chunk, pos)
+        values.append(dictionary[index])
+    return values
+
+
+_DECODERS = {INTEGER: _decode_integers, DOUBLE: _decode_doubles, STRING: _decode_strings}
+
+
+def read_columns(filename, names=None):
+    """Return the columns of a columnar file, or only those named, as an
+    ordered dictionary of lists."""
+    with open(filename, 'rb') as f:
+        data = f.read()
+    if len(data) < 2 * len(MAGIC) + 8 or data[:len(MAGIC)] != MAGIC or data[-len(MAGIC):] != MAGIC:
+        raise ValueError("%s is not a columnar file" % filename)
+    footer_offset = _UINT64.unpack_from(data, len(data) - len(MAGIC) - 8)[0]
+    n_columns, pos = _varint(data, footer_offset)
+    columns = []
+    for _ in range(n_columns):
+        length, pos = _varint(data, pos)
+        name = data[pos:pos + length].decode('utf-8')
+        pos += length
+        columns.append((name, bytearray(data[pos:pos + 1])[0]))
+        pos += 1
+    result = collections.OrderedDict((name, []) for name, _ in columns if names is None or name in names)
+    n_row_groups, pos = _varint(data, pos)
+    for _ in range(n_row_groups):
+        offset, pos = _varint(data, pos)
+        n_rows, pos = _varint(data, pos)
+        for name, column_type in columns:
+            size, pos = _varint(data, pos)
+            if name in result:
+                result[name].extend(_DECODERS[column_type](data[offset:offset + size], n_rows))
+            offset += size
+    return result
+
+
+def main(argv):
+    if len(argv) != 2:
+        sys.stderr.write("usage: %s COLUMNAR-FILE\n" % argv[0])
+        return 1
+    columns = read_columns(argv[1])
+    writer = csv.writer(sys.stdout)
+    writer.writerow(list(columns))
+    for row in zip(*columns.values()):
+        writer.writerow(row)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
@@ -0,0 +1,93 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "columnar-aggregator.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("ColumnarAggregator");
+
+NS_OBJECT_ENSURE_REGISTERED (ColumnarAggregator);
+
+TypeId
+ColumnarAggregator::GetTypeId ()
+{
+  static TypeId tid = TypeId ("ns3::ColumnarAggregator")
+    .SetParent<DataCollectionObject> ()
+    .SetGroupName ("Stats")
+  ;
+
+  return tid;
+}
+
+ColumnarAggregator::ColumnarAggregator (const std::string &outputFileName, uint32_t rowGroupSize)
+{
+  NS_LOG_FUNCTION (this << outputFileName << rowGroupSize);
+  m_writer.Open (outputFileName, rowGroupSize);
+  m_contextColumn = m_writer.AddColumn ("context", ColumnarFileWriter::STRING);
+  m_xColumn = m_writer.AddColumn ("x", ColumnarFileWriter::DOUBLE);
+  m_yColumn = m_writer.AddColumn ("y", ColumnarFileWriter::DOUBLE);
+}
+
+ColumnarAggregator::~ColumnarAggregator ()
+{
+  NS_LOG_FUNCTION (this);
+  if (m_writer.IsOpen ())
+    {
+      m_writer.Close ();
+    }
+}
+
+void
+ColumnarAggregator::Write1d (std::string context, double v1)
+{
+  NS_LOG_FUNCTION (this << context << v1);
+
+  if (m_enabled && m_writer.IsOpen ())
+    {
+      m_writer.AppendString (m_contextColumn, context);
+      m_writer.AppendDouble (m_xColumn, m_1dRanks[context]++);
+      m_writer.AppendDouble (m_yColumn, v1);
+      m_writer.EndRow ();
+    }
+}
+
+void
+ColumnarAggregator::Write2d (std::string context, double v1, double v2)
+{
+  NS_LOG_FUNCTION (this << context << v1 << v2);
+
+  if (m_enabled && m_writer.IsOpen ())
+    {
+      m_writer.AppendString (m_contextColumn, context);
+      m_writer.AppendDouble (m_xColumn, v1);
+      m_writer.AppendDouble (m_yColumn, v2);
+      m_writer.EndRow ();
+    }
+}
+
+void
+ColumnarAggregator::Close (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_writer.IsOpen ())
+    {
+      m_writer.Close ();
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,91 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef COLUMNAR_AGGREGATOR_H
+#define COLUMNAR_AGGREGATOR_H
+
+#include <map>
+#include <string>
+#include "ns3/data-collection-object.h"
+#include "ns3/columnar-file.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup aggregator
+ *
+ * This aggregator buffers the values it receives by column, and writes
+ * them to a columnar file (see ColumnarFileWriter) with the columns
+ * "context", "x" and "y".  It is meant for the long time series of
+ * probes and TimeSeriesAdaptors, which it writes much faster and in
+ * much less space than a FileAggregator:
+ *
+ * \code
+ *   adaptor->TraceConnect ("Output", "cwnd",
+ *                          MakeCallback (&ColumnarAggregator::Write2d, aggregator));
+ * \endcode
+ *
+ * The file is complete once the aggregator is destroyed or closed.
+ **/
+class ColumnarAggregator : public DataCollectionObject
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId ();
+
+  /**
+   * \param outputFileName name of the file to write.
+   * \param rowGroupSize number of values buffered before being written.
+   */
+  ColumnarAggregator (const std::string &outputFileName, uint32_t rowGroupSize = 65536);
+
+  virtual ~ColumnarAggregator ();
+
+  /**
+   * \param context specifies the 1D dataset these values came from.
+   * \param v1 value for the new data point.
+   *
+   * \brief Writes 1 value to the file, in the column "y", the column
+   * "x" holding the rank of the value in its context.
+   */
+  void Write1d (std::string context, double v1);
+
+  /**
+   * \param context specifies the 2D dataset these values came from.
+   * \param v1 first value for the new data point, in the column "x".
+   * \param v2 second value for the new data point, in the column "y".
+   *
+   * \brief Writes 2 values to the file.
+   */
+  void Write2d (std::string context, double v1, double v2);
+
+  /// \brief Writes the values buffered and closes the file.
+  void Close (void);
+
+private:
+  ColumnarFileWriter m_writer;  //!< The file written
+  uint32_t m_contextColumn;     //!< Index of the column "context"
+  uint32_t m_xColumn;           //!< Index of the column "x"
+  uint32_t m_yColumn;           //!< Index of the column "y"
+  std::map<std::string, uint64_t> m_1dRanks; //!< Number of 1D values per context
+};
+
+} // namespace ns3
+
+#endif // COLUMNAR_AGGREGATOR_H
@@ -0,0 +1,197 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <limits>
+
+#include "ns3/log.h"
+#include "ns3/nstime.h"
+
+#include "data-collector.h"
+#include "data-calculator.h"
+#include "columnar-data-output.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("ColumnarDataOutput");
+
+/// The columns of the file of a run
+enum ColumnarDataOutputColumn
+{
+  RUN_COLUMN,
+  EXPERIMENT_COLUMN,
+  STRATEGY_COLUMN,
+  INPUT_COLUMN,
+  CONTEXT_COLUMN,
+  VARIABLE_COLUMN,
+  VALUE_COLUMN,
+  TEXT_COLUMN
+};
+
+//--------------------------------------------------------------
+//----------------------------------------------
+ColumnarDataOutput::ColumnarDataOutput()
+{
+  NS_LOG_FUNCTION (this);
+
+  m_filePrefix = "data";
+}
+ColumnarDataOutput::~ColumnarDataOutput()
+{
+  NS_LOG_FUNCTION (this);
+}
+/* static */
+TypeId
+ColumnarDataOutput::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::ColumnarDataOutput")
+    .SetParent<DataOutputInterface> ()
+    .SetGroupName ("Stats")
+    .AddConstructor<ColumnarDataOutput> ();
+  return tid;
+}
+
+void
+ColumnarDataOutput::DoDispose ()
+{
+  NS_LOG_FUNCTION (this);
+
+  DataOutputInterface::DoDispose ();
+  // end ColumnarDataOutput::DoDispose
+}
+
+//----------------------------------------------
+void
+ColumnarDataOutput::Output (DataCollector &dc)
+{
+  NS_LOG_FUNCTION (this << &dc);
+
+  std::string fn = m_filePrefix + "-" + dc.GetRunLabel () + ".col";
+  m_writer.Open (fn);
+  m_writer.AddColumn ("run", ColumnarFileWriter::STRING);
+  m_writer.AddColumn ("experiment", ColumnarFileWriter::STRING);
+  m_writer.AddColumn ("strategy", ColumnarFileWriter::STRING);
+  m_writer.AddColumn ("input", ColumnarFileWriter::STRING);
+  m_writer.AddColumn ("context", ColumnarFileWriter::STRING);
+  m_writer.AddColumn ("variable", ColumnarFileWriter::STRING);
+  m_writer.AddColumn ("value", ColumnarFileWriter::DOUBLE);
+  m_writer.AddColumn ("text", ColumnarFileWriter::STRING);
+
+  ColumnarOutputCallback callback (this, dc);
+  // The metadata of the run, as string values of the context "metadata"
+  for (MetadataList::iterator i = dc.MetadataBegin ();
+       i != dc.MetadataEnd (); i++) {
+      callback.OutputSingleton ("metadata", i->first, i->second);
+    }
+  for (DataCalculatorList::iterator i = dc.DataCalculatorBegin ();
+       i != dc.DataCalculatorEnd (); i++) {
+      (*i)->Output (callback);
+    }
+
+  m_writer.Close ();
+
+  // end ColumnarDataOutput::Output
+}
+
+ColumnarDataOutput::ColumnarOutputCallback::ColumnarOutputCallback
+  (Ptr<ColumnarDataOutput> owner, DataCollector &dc) :
+  m_owner (owner),
+  m_dc (dc)
+{
+  NS_LOG_FUNCTION (this << owner << &dc);
+}
+
+void
+ColumnarDataOutput::ColumnarOutputCallback::WriteRow (const std::string &context,
+                                                      const std::string &name,
+                                                      double value,
+                                                      const std::string &text)
+{
+  ColumnarFileWriter &writer = m_owner->m_writer;
+  writer.AppendString (RUN_COLUMN, m_dc.GetRunLabel ());
+  writer.AppendString (EXPERIMENT_COLUMN, m_dc.GetExperimentLabel ());
+  writer.AppendString (STRATEGY_COLUMN, m_dc.GetStrategyLabel ());
+  writer.AppendString (INPUT_COLUMN, m_dc.GetInputLabel ());
+  writer.AppendString (CONTEXT_COLUMN, context);
+  writer.AppendString (VARIABLE_COLUMN, name);
+  writer.AppendDouble (VALUE_COLUMN, value);
+  writer.AppendString (TEXT_COLUMN, text);
+  writer.EndRow ();
+}
+
+void
+ColumnarDataOutput::ColumnarOutputCallback::OutputStatistic (std::string context,
+                                                             std::string name,
+                                                             const StatisticalSummary *statSum)
+{
+  NS_LOG_FUNCTION (this << context << name << statSum);
+
+  OutputSingleton (context, name + "-count", (double)statSum->getCount ());
+  if (!isNaN (statSum->getSum ()))
+    OutputSingleton (context, name + "-total", statSum->getSum ());
+  if (!isNaN (statSum->getMax ()))
+    OutputSingleton (context, name + "-max", statSum->getMax ());
+  if (!isNaN (statSum->getMin ()))
+    OutputSingleton (context, name + "-min", statSum->getMin ());
+  if (!isNaN (statSum->getSqrSum ()))
+    OutputSingleton (context, name + "-sqrsum", statSum->getSqrSum ());
+  if (!isNaN (statSum->getStddev ()))
+    OutputSingleton (context, name + "-stddev", statSum->getStddev ());
+}
+
+void
+ColumnarDataOutput::ColumnarOutputCallback::OutputSingleton (std::string context,
+                                                             std::string name,
+                                                             int val)
+{
+  NS_LOG_FUNCTION (this << context << name << val);
+  WriteRow (context, name, val, "");
+}
+
+void
+ColumnarDataOutput::ColumnarOutputCallback::OutputSingleton (std::string context,
+                                                             std::string name,
+                                                             uint32_t val)
+{
+  NS_LOG_FUNCTION (this << context << name << val);
+  WriteRow (context, name, val, "");
+}
+
+void
+ColumnarDataOutput::ColumnarOutputCallback::OutputSingleton (std::string context,
+                                                             std::string name,
+                                                             double val)
+{
+  NS_LOG_FUNCTION (this << context << name << val);
+  WriteRow (context, name, val, "");
+}
+
+void
+ColumnarDataOutput::ColumnarOutputCallback::OutputSingleton (std::string context,
+                                                             std::string name,
+                                                             std::string val)
+{
+  NS_LOG_FUNCTION (this << context << name << val);
+  WriteRow (context, name, std::numeric_limits<double>::quiet_NaN (), val);
+}
+
+void
+ColumnarDataOutput::ColumnarOutputCallback::OutputSingleton (std::string context,
+                                                             std::string name,
+                                                             Time val)
+{
+  NS_LOG_FUNCTION (this << context << name << val);
+  WriteRow (context, name, val.GetSeconds (), "");
+}
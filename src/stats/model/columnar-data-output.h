@@ -0,0 +1,160 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef COLUMNAR_DATA_OUTPUT_H
+#define COLUMNAR_DATA_OUTPUT_H
+
+#include "ns3/nstime.h"
+
+#include "data-output-interface.h"
+#include "columnar-file.h"
+
+namespace ns3 {
+
+//------------------------------------------------------------
+//--------------------------------------------
+/**
+ * \ingroup dataoutput
+ * \class ColumnarDataOutput
+ * \brief Outputs data to a columnar file
+ *
+ * Each run is written to the file prefix-run.col (see
+ * ColumnarFileWriter), with one row per value and the string columns
+ * "run", "experiment", "strategy", "input", "context" and "variable",
+ * the double column "value" and the string column "text", which holds
+ * the string values.  Times are written in seconds.  The statistics are
+ * written as the values variable-count, variable-total, variable-max,
+ * variable-min, variable-sqrsum and variable-stddev, as with
+ * SqliteDataOutput.
+ */
+class ColumnarDataOutput : public DataOutputInterface {
+public:
+  ColumnarDataOutput();
+  virtual ~ColumnarDataOutput();
+
+  /**
+   * Register this type.
+   * \return The TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  virtual void Output (DataCollector &dc);
+
+protected:
+  virtual void DoDispose ();
+
+private:
+  /**
+   * \ingroup dataoutput
+   *
+   * \brief Class to generate the rows of the columnar file
+   */
+  class ColumnarOutputCallback : public DataOutputCallback {
+public:
+    /**
+     * Constructor
+     * \param owner pointer to the instance this object belongs to
+     * \param dc the DataCollector output
+     */
+    ColumnarOutputCallback(Ptr<ColumnarDataOutput> owner, DataCollector &dc);
+
+    /**
+     * \brief Generates data statistics
+     * \param context the output context
+     * \param name the output name
+     * \param statSum the stats to print
+     */
+    void OutputStatistic (std::string context,
+                          std::string name,
+                          const StatisticalSummary *statSum);
+
+    /**
+     * \brief Generates a single data output
+     * \param context the output context
+     * \param name the output name
+     * \param val the value
+     */
+    void OutputSingleton (std::string context,
+                          std::string name,
+                          int val);
+
+    /**
+     * \brief Generates a single data output
+     * \param context the output context
+     * \param name the output name
+     * \param val the value
+     */
+    void OutputSingleton (std::string context,
+                          std::string name,
+                          uint32_t val);
+
+    /**
+     * \brief Generates a single data output
+     * \param context the output context
+     * \param name the output name
+     * \param val the value
+     */
+    void OutputSingleton (std::string context,
+                          std::string name,
+                          double val);
+
+    /**
+     * \brief Generates a single data output
+     * \param context the output context
+     * \param name the output name
+     * \param val the value
+     */
+    void OutputSingleton (std::string context,
+                          std::string name,
+                          std::string val);
+
+    /**
+     * \brief Generates a single data output
+     * \param context the output context
+     * \param name the output name
+     * \param val the value
+     */
+    void OutputSingleton (std::string context,
+                          std::string name,
+                          Time val);
+
+private:
+    /**
+     * \brief Write a row
+     * \param context the output context
+     * \param name the output name
+     * \param value the numeric value
+     * \param text the string value
+     */
+    void WriteRow (const std::string &context, const std::string &name,
+                   double value, const std::string &text);
+
+    Ptr<ColumnarDataOutput> m_owner; //!< the instance this object belongs to
+    DataCollector &m_dc;             //!< the DataCollector output
+
+    // end class ColumnarOutputCallback
+  };
+
+  ColumnarFileWriter m_writer; //!< The file of the run being output
+
+  // end class ColumnarDataOutput
+};
+
+// end namespace ns3
+};
+
+
+#endif /* COLUMNAR_DATA_OUTPUT_H */
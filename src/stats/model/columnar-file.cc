@@ -0,0 +1,577 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cstring>
+
+#include "columnar-file.h"
+#include "ns3/abort.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("ColumnarFile");
+
+/// The magic bytes at the start and the end of a columnar file
+static const char COLUMNAR_FILE_MAGIC[8] = { 'N', 'S', '3', 'C', 'O', 'L', 'F', '1' };
+
+/**
+ * Append a variable-length unsigned integer, 7 bits per byte
+ * \param out the buffer
+ * \param value the value
+ */
+static void
+PutVarint (std::string &out, uint64_t value)
+{
+  while (value >= 0x80)
+    {
+      out.push_back (static_cast<char> ((value & 0x7f) | 0x80));
+      value >>= 7;
+    }
+  out.push_back (static_cast<char> (value));
+}
+
+/**
+ * Read a variable-length unsigned integer
+ * \param in the buffer
+ * \param pos the position in the buffer, moved past the integer
+ * \param value the value read
+ * \return false if the buffer ends before the integer
+ */
+static bool
+GetVarint (const std::string &in, size_t &pos, uint64_t &value)
+{
+  value = 0;
+  for (uint32_t shift = 0; shift < 64; shift += 7)
+    {
+      if (pos >= in.size ())
+        {
+          return false;
+        }
+      uint8_t byte = static_cast<uint8_t> (in[pos++]);
+      value |= static_cast<uint64_t> (byte & 0x7f) << shift;
+      if ((byte & 0x80) == 0)
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
+/**
+ * \param value a double
+ * \return the bits of the double
+ */
+static uint64_t
+DoubleToBits (double value)
+{
+  uint64_t bits;
+  std::memcpy (&bits, &value, sizeof (bits));
+  return bits;
+}
+
+/**
+ * \param bits the bits of a double
+ * \return the double
+ */
+static double
+BitsToDouble (uint64_t bits)
+{
+  double value;
+  std::memcpy (&value, &bits, sizeof (value));
+  return value;
+}
+
+ColumnarFileWriter::ColumnarFileWriter ()
+  : m_rowGroupSize (65536),
+    m_nBufferedRows (0),
+    m_nRows (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+ColumnarFileWriter::~ColumnarFileWriter ()
+{
+  NS_LOG_FUNCTION (this);
+  if (IsOpen ())
+    {
+      Close ();
+    }
+}
+
+void
+ColumnarFileWriter::Open (const std::string &fileName, uint32_t rowGroupSize)
+{
+  NS_LOG_FUNCTION (this << fileName << rowGroupSize);
+  NS_ABORT_MSG_IF (IsOpen (), "Columnar file already open");
+  NS_ABORT_MSG_IF (rowGroupSize == 0, "Empty row groups");
+  m_file.open (fileName.c_str (), std::ios::out | std::ios::binary | std::ios::trunc);
+  NS_ABORT_MSG_UNLESS (m_file.is_open (), "Cannot open " << fileName);
+  m_file.write (COLUMNAR_FILE_MAGIC, sizeof (COLUMNAR_FILE_MAGIC));
+  m_rowGroupSize = rowGroupSize;
+  m_columns.clear ();
+  m_rowGroups.clear ();
+  m_nBufferedRows = 0;
+  m_nRows = 0;
+}
+
+uint32_t
+ColumnarFileWriter::AddColumn (const std::string &name, ColumnType type)
+{
+  NS_LOG_FUNCTION (this << name << type);
+  NS_ABORT_MSG_IF (m_nRows > 0 || m_nBufferedRows > 0, "Column " << name << " added after the first row");
+  m_columns.push_back (Column ());
+  m_columns.back ().name = name;
+  m_columns.back ().type = type;
+  return m_columns.size () - 1;
+}
+
+void
+ColumnarFileWriter::AppendInteger (uint32_t column, int64_t value)
+{
+  NS_ASSERT (column < m_columns.size () && m_columns[column].type == INTEGER);
+  m_columns[column].integers.push_back (value);
+}
+
+void
+ColumnarFileWriter::AppendDouble (uint32_t column, double value)
+{
+  NS_ASSERT (column < m_columns.size () && m_columns[column].type == DOUBLE);
+  m_columns[column].doubles.push_back (value);
+}
+
+void
+ColumnarFileWriter::AppendString (uint32_t column, const std::string &value)
+{
+  NS_ASSERT (column < m_columns.size () && m_columns[column].type == STRING);
+  Column &col = m_columns[column];
+  std::pair<std::unordered_map<std::string, uint32_t>::iterator, bool> inserted =
+    col.dictionaryIndex.insert (std::make_pair (value, col.dictionary.size ()));
+  if (inserted.second)
+    {
+      col.dictionary.push_back (value);
+    }
+  col.indices.push_back (inserted.first->second);
+}
+
+void
+ColumnarFileWriter::EndRow (void)
+{
+  m_nBufferedRows++;
+  m_nRows++;
+#ifdef NS3_ASSERT_ENABLE
+  for (std::vector<Column>::const_iterator i = m_columns.begin (); i != m_columns.end (); i++)
+    {
+      size_t n = i->type == INTEGER ? i->integers.size () : i->type == DOUBLE ? i->doubles.size () : i->indices.size ();
+      NS_ASSERT_MSG (n == m_nBufferedRows, "Column " << i->name << " not set in row " << m_nRows);
+    }
+#endif
+  if (m_nBufferedRows == m_rowGroupSize)
+    {
+      WriteRowGroup ();
+    }
+}
+
+void
+ColumnarFileWriter::WriteRowGroup (void)
+{
+  NS_LOG_FUNCTION (this << m_nBufferedRows);
+  RowGroup rowGroup;
+  rowGroup.offset = m_file.tellp ();
+  rowGroup.nRows = m_nBufferedRows;
+  for (std::vector<Column>::iterator col = m_columns.begin (); col != m_columns.end (); col++)
+    {
+      m_chunk.clear ();
+      switch (col->type)
+        {
+        case INTEGER:
+          {
+            uint64_t previous = 0;
+            for (std::vector<int64_t>::const_iterator i = col->integers.begin (); i != col->integers.end (); i++)
+              {
+                // zigzag of the delta, so that small negative deltas are small
+                int64_t delta = static_cast<int64_t> (static_cast<uint64_t> (*i) - previous);
+                PutVarint (m_chunk, (static_cast<uint64_t> (delta) << 1) ^ static_cast<uint64_t> (delta >> 63));
+                previous = static_cast<uint64_t> (*i);
+              }
+            col->integers.clear ();
+            break;
+          }
+        case DOUBLE:
+          {
+            uint64_t previous = 0;
+            for (std::vector<double>::const_iterator i = col->doubles.begin (); i != col->doubles.end (); i++)
+              {
+                uint64_t bits = DoubleToBits (*i);
+                uint64_t x = bits ^ previous;
+                previous = bits;
+                if (x == 0)
+                  {
+                    m_chunk.push_back (static_cast<char> (8 << 4));
+                    continue;
+                  }
+                uint32_t leading = __builtin_clzll (x) / 8;
+                uint32_t trailing = __builtin_ctzll (x) / 8;
+                m_chunk.push_back (static_cast<char> ((leading << 4) | trailing));
+                for (uint32_t b = trailing; b < 8 - leading; b++)
+                  {
+                    m_chunk.push_back (static_cast<char> (x >> (8 * b)));
+                  }
+              }
+            col->doubles.clear ();
+            break;
+          }
+        case STRING:
+          {
+            PutVarint (m_chunk, col->dictionary.size ());
+            for (std::vector<std::string>::const_iterator i = col->dictionary.begin (); i != col->dictionary.end (); i++)
+              {
+                PutVarint (m_chunk, i->size ());
+                m_chunk.append (*i);
+              }
+            for (std::vector<uint32_t>::const_iterator i = col->indices.begin (); i != col->indices.end (); i++)
+              {
+                PutVarint (m_chunk, *i);
+              }
+            col->indices.clear ();
+            col->dictionary.clear ();
+            col->dictionaryIndex.clear ();
+            break;
+          }
+        }
+      m_file.write (m_chunk.data (), m_chunk.size ());
+      rowGroup.chunkSizes.push_back (m_chunk.size ());
+    }
+  m_rowGroups.push_back (rowGroup);
+  m_nBufferedRows = 0;
+}
+
+void
+ColumnarFileWriter::Close (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ABORT_MSG_UNLESS (IsOpen (), "Columnar file not open");
+  if (m_nBufferedRows > 0)
+    {
+      WriteRowGroup ();
+    }
+  uint64_t footerOffset = m_file.tellp ();
+  std::string footer;
+  PutVarint (footer, m_columns.size ());
+  for (std::vector<Column>::const_iterator col = m_columns.begin (); col != m_columns.end (); col++)
+    {
+      PutVarint (footer, col->name.size ());
+      footer.append (col->name);
+      footer.push_back (static_cast<char> (col->type));
+    }
+  PutVarint (footer, m_rowGroups.size ());
+  for (std::vector<RowGroup>::const_iterator rowGroup = m_rowGroups.begin (); rowGroup != m_rowGroups.end (); rowGroup++)
+    {
+      PutVarint (footer, rowGroup->offset);
+      PutVarint (footer, rowGroup->nRows);
+      for (std::vector<uint64_t>::const_iterator size = rowGroup->chunkSizes.begin ();
+           size != rowGroup->chunkSizes.end (); size++)
+        {
+          PutVarint (footer, *size);
+        }
+    }
+  for (uint32_t b = 0; b < 8; b++)
+    {
+      footer.push_back (static_cast<char> (footerOffset >> (8 * b)));
+    }
+  footer.append (COLUMNAR_FILE_MAGIC, sizeof (COLUMNAR_FILE_MAGIC));
+  m_file.write (footer.data (), footer.size ());
+  m_file.close ();
+  m_columns.clear ();
+  m_rowGroups.clear ();
+}
+
+bool
+ColumnarFileWriter::IsOpen (void) const
+{
+  return m_file.is_open ();
+}
+
+uint64_t
+ColumnarFileWriter::GetNRows (void) const
+{
+  return m_nRows;
+}
+
+ColumnarFileReader::ColumnarFileReader ()
+  : m_nRows (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+bool
+ColumnarFileReader::Open (const std::string &fileName)
+{
+  NS_LOG_FUNCTION (this << fileName);
+  m_names.clear ();
+  m_types.clear ();
+  m_rowGroups.clear ();
+  m_nRows = 0;
+  if (m_file.is_open ())
+    {
+      m_file.close ();
+    }
+  m_file.open (fileName.c_str (), std::ios::in | std::ios::binary);
+  if (!m_file.is_open ())
+    {
+      return false;
+    }
+  char magic[sizeof (COLUMNAR_FILE_MAGIC)];
+  m_file.seekg (0, std::ios::end);
+  uint64_t size = m_file.tellg ();
+  if (size < 2 * sizeof (magic) + 8)
+    {
+      return false;
+    }
+  m_file.seekg (0);
+  m_file.read (magic, sizeof (magic));
+  if (std::memcmp (magic, COLUMNAR_FILE_MAGIC, sizeof (magic)) != 0)
+    {
+      return false;
+    }
+  char trailer[8 + sizeof (magic)];
+  m_file.seekg (size - sizeof (trailer));
+  m_file.read (trailer, sizeof (trailer));
+  if (!m_file || std::memcmp (trailer + 8, COLUMNAR_FILE_MAGIC, sizeof (magic)) != 0)
+    {
+      return false;
+    }
+  uint64_t footerOffset = 0;
+  for (uint32_t b = 0; b < 8; b++)
+    {
+      footerOffset |= static_cast<uint64_t> (static_cast<uint8_t> (trailer[b])) << (8 * b);
+    }
+  if (footerOffset < sizeof (magic) || footerOffset > size - sizeof (trailer))
+    {
+      return false;
+    }
+  std::string footer (size - sizeof (trailer) - footerOffset, '\0');
+  m_file.seekg (footerOffset);
+  m_file.read (&footer[0], footer.size ());
+  if (!m_file)
+    {
+      return false;
+    }
+
+  size_t pos = 0;
+  uint64_t nColumns;
+  if (!GetVarint (footer, pos, nColumns))
+    {
+      return false;
+    }
+  for (uint64_t c = 0; c < nColumns; c++)
+    {
+      uint64_t length;
+      if (!GetVarint (footer, pos, length) || pos + length + 1 > footer.size ())
+        {
+          return false;
+        }
+      m_names.push_back (footer.substr (pos, length));
+      pos += length;
+      uint8_t type = static_cast<uint8_t> (footer[pos++]);
+      if (type > ColumnarFileWriter::STRING)
+        {
+          return false;
+        }
+      m_types.push_back (static_cast<ColumnarFileWriter::ColumnType> (type));
+    }
+  uint64_t nRowGroups;
+  if (!GetVarint (footer, pos, nRowGroups))
+    {
+      return false;
+    }
+  for (uint64_t g = 0; g < nRowGroups; g++)
+    {
+      RowGroup rowGroup;
+      uint64_t nRows;
+      if (!GetVarint (footer, pos, rowGroup.offset) || !GetVarint (footer, pos, nRows))
+        {
+          return false;
+        }
+      rowGroup.nRows = nRows;
+      uint64_t end = rowGroup.offset;
+      for (uint64_t c = 0; c < nColumns; c++)
+        {
+          uint64_t chunkSize;
+          if (!GetVarint (footer, pos, chunkSize))
+            {
+              return false;
+            }
+          rowGroup.chunkSizes.push_back (chunkSize);
+          end += chunkSize;
+        }
+      if (end > footerOffset)
+        {
+          return false;
+        }
+      m_rowGroups.push_back (rowGroup);
+      m_nRows += nRows;
+    }
+  return pos == footer.size ();
+}
+
+uint32_t
+ColumnarFileReader::GetNColumns (void) const
+{
+  return m_names.size ();
+}
+
+uint64_t
+ColumnarFileReader::GetNRows (void) const
+{
+  return m_nRows;
+}
+
+std::string
+ColumnarFileReader::GetColumnName (uint32_t column) const
+{
+  NS_ASSERT (column < m_names.size ());
+  return m_names[column];
+}
+
+ColumnarFileWriter::ColumnType
+ColumnarFileReader::GetColumnType (uint32_t column) const
+{
+  NS_ASSERT (column < m_types.size ());
+  return m_types[column];
+}
+
+int32_t
+ColumnarFileReader::GetColumnIndex (const std::string &name) const
+{
+  for (uint32_t c = 0; c < m_names.size (); c++)
+    {
+      if (m_names[c] == name)
+        {
+          return c;
+        }
+    }
+  return -1;
+}
+
+std::string
+ColumnarFileReader::ReadChunk (const RowGroup &rowGroup, uint32_t column)
+{
+  uint64_t offset = rowGroup.offset;
+  for (uint32_t c = 0; c < column; c++)
+    {
+      offset += rowGroup.chunkSizes[c];
+    }
+  std::string chunk (rowGroup.chunkSizes[column], '\0');
+  m_file.clear ();
+  m_file.seekg (offset);
+  m_file.read (&chunk[0], chunk.size ());
+  NS_ABORT_MSG_UNLESS (m_file, "Cannot read the chunk of column " << m_names[column]);
+  return chunk;
+}
+
+std::vector<int64_t>
+ColumnarFileReader::ReadIntegerColumn (uint32_t column)
+{
+  NS_LOG_FUNCTION (this << column);
+  NS_ABORT_MSG_UNLESS (GetColumnType (column) == ColumnarFileWriter::INTEGER,
+                       "Column " << m_names[column] << " is not an integer column");
+  std::vector<int64_t> values;
+  values.reserve (m_nRows);
+  for (std::vector<RowGroup>::const_iterator rowGroup = m_rowGroups.begin (); rowGroup != m_rowGroups.end (); rowGroup++)
+    {
+      std::string chunk = ReadChunk (*rowGroup, column);
+      size_t pos = 0;
+      uint64_t previous = 0;
+      for (uint32_t r = 0; r < rowGroup->nRows; r++)
+        {
+          uint64_t zigzag;
+          NS_ABORT_MSG_UNLESS (GetVarint (chunk, pos, zigzag), "Truncated chunk of column " << m_names[column]);
+          previous += (zigzag >> 1) ^ (~(zigzag & 1) + 1);
+          values.push_back (static_cast<int64_t> (previous));
+        }
+    }
+  return values;
+}
+
+std::vector<double>
+ColumnarFileReader::ReadDoubleColumn (uint32_t column)
+{
+  NS_LOG_FUNCTION (this << column);
+  NS_ABORT_MSG_UNLESS (GetColumnType (column) == ColumnarFileWriter::DOUBLE,
+                       "Column " << m_names[column] << " is not a double column");
+  std::vector<double> values;
+  values.reserve (m_nRows);
+  for (std::vector<RowGroup>::const_iterator rowGroup = m_rowGroups.begin (); rowGroup != m_rowGroups.end (); rowGroup++)
+    {
+      std::string chunk = ReadChunk (*rowGroup, column);
+      size_t pos = 0;
+      uint64_t previous = 0;
+      for (uint32_t r = 0; r < rowGroup->nRows; r++)
+        {
+          NS_ABORT_MSG_UNLESS (pos < chunk.size (), "Truncated chunk of column " << m_names[column]);
+          uint8_t control = static_cast<uint8_t> (chunk[pos++]);
+          uint32_t leading = control >> 4;
+          uint32_t trailing = control & 0x0f;
+          NS_ABORT_MSG_UNLESS (leading + trailing <= 8 && pos + 8 - leading - trailing <= chunk.size (),
+                               "Corrupt chunk of column " << m_names[column]);
+          uint64_t x = 0;
+          for (uint32_t b = trailing; b < 8 - leading; b++)
+            {
+              x |= static_cast<uint64_t> (static_cast<uint8_t> (chunk[pos++])) << (8 * b);
+            }
+          previous ^= x;
+          values.push_back (BitsToDouble (previous));
+        }
+    }
+  return values;
+}
+
+std::vector<std::string>
+ColumnarFileReader::ReadStringColumn (uint32_t column)
+{
+  NS_LOG_FUNCTION (this << column);
+  NS_ABORT_MSG_UNLESS (GetColumnType (column) == ColumnarFileWriter::STRING,
+                       "Column " << m_names[column] << " is not a string column");
+  std::vector<std::string> values;
+  values.reserve (m_nRows);
+  for (std::vector<RowGroup>::const_iterator rowGroup = m_rowGroups.begin (); rowGroup != m_rowGroups.end (); rowGroup++)
+    {
+      std::string chunk = ReadChunk (*rowGroup, column);
+      size_t pos = 0;
+      uint64_t nStrings;
+      NS_ABORT_MSG_UNLESS (GetVarint (chunk, pos, nStrings), "Truncated chunk of column " << m_names[column]);
+      std::vector<std::string> dictionary;
+      for (uint64_t s = 0; s < nStrings; s++)
+        {
+          uint64_t length;
+          NS_ABORT_MSG_UNLESS (GetVarint (chunk, pos, length) && pos + length <= chunk.size (),
+                               "Truncated chunk of column " << m_names[column]);
+          dictionary.push_back (chunk.substr (pos, length));
+          pos += length;
+        }
+      for (uint32_t r = 0; r < rowGroup->nRows; r++)
+        {
+          uint64_t index;
+          NS_ABORT_MSG_UNLESS (GetVarint (chunk, pos, index) && index < dictionary.size (),
+                               "Corrupt chunk of column " << m_names[column]);
+          values.push_back (dictionary[index]);
+        }
+    }
+  return values;
+}
+
+} // namespace ns3
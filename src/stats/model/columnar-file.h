@@ -0,0 +1,227 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef COLUMNAR_FILE_H
+#define COLUMNAR_FILE_H
+
+#include <stdint.h>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup stats
+ *
+ * \brief Writes a table to a self-contained columnar file
+ *
+ * The values of the rows are buffered by column, in typed arrays, and
+ * written in groups of rows: each row group holds one chunk per column,
+ * encoded according to the type of the column.
+ *
+ * - Integer columns are delta-encoded, and the deltas written as
+ *   zigzag variable-length integers.
+ * - Double columns are XOR-ed with the previous value, and only the
+ *   non-zero bytes of the result are written, after a byte counting the
+ *   leading and trailing zero bytes.  Slowly-changing or repeated values,
+ *   such as the times and values of a time series, take a few bytes.
+ * - String columns are dictionary-encoded: each chunk holds the distinct
+ *   strings of the row group, followed by the index of the string of
+ *   each row.
+ *
+ * The file starts and ends with the magic bytes "NS3COLF1".  A footer
+ * before the final magic holds the names and types of the columns, and
+ * the offset, number of rows and chunk sizes of each row group, followed
+ * by the offset of the footer on 8 bytes.  All the integers are
+ * little-endian.  The file may be read with a ColumnarFileReader, or in
+ * Python with src/stats/examples/read-columnar-file.py.
+ */
+class ColumnarFileWriter
+{
+public:
+  /// The type of the values of a column
+  enum ColumnType
+  {
+    INTEGER = 0,  //!< 64-bit signed integers
+    DOUBLE = 1,   //!< doubles
+    STRING = 2    //!< strings
+  };
+
+  ColumnarFileWriter ();
+  /// Closes the file, if open
+  ~ColumnarFileWriter ();
+
+  /**
+   * \brief Create a file
+   * \param fileName the name of the file
+   * \param rowGroupSize the number of rows buffered before being written
+   */
+  void Open (const std::string &fileName, uint32_t rowGroupSize = 65536);
+
+  /**
+   * \brief Add a column, before the first row
+   * \param name the name of the column
+   * \param type the type of the column
+   * \return the index of the column
+   */
+  uint32_t AddColumn (const std::string &name, ColumnType type);
+
+  /**
+   * \brief Set the value of an integer column in the current row
+   * \param column the index of the column
+   * \param value the value
+   */
+  void AppendInteger (uint32_t column, int64_t value);
+  /**
+   * \brief Set the value of a double column in the current row
+   * \param column the index of the column
+   * \param value the value
+   */
+  void AppendDouble (uint32_t column, double value);
+  /**
+   * \brief Set the value of a string column in the current row
+   * \param column the index of the column
+   * \param value the value
+   */
+  void AppendString (uint32_t column, const std::string &value);
+
+  /// End the current row, once the values of all its columns are set
+  void EndRow (void);
+
+  /// Write the rows buffered and the footer, and close the file
+  void Close (void);
+
+  /// \return whether the file is open
+  bool IsOpen (void) const;
+
+  /// \return the number of rows ended
+  uint64_t GetNRows (void) const;
+
+private:
+  /// The buffered values of a column
+  struct Column
+  {
+    std::string name;                     //!< Name of the column
+    ColumnType type;                      //!< Type of the column
+    std::vector<int64_t> integers;        //!< Values of an integer column
+    std::vector<double> doubles;          //!< Values of a double column
+    std::vector<uint32_t> indices;        //!< Dictionary indices of the values of a string column
+    std::vector<std::string> dictionary;  //!< Distinct values of a string column
+    std::unordered_map<std::string, uint32_t> dictionaryIndex; //!< Value --> index in dictionary
+  };
+
+  /// A row group written
+  struct RowGroup
+  {
+    uint64_t offset;                  //!< Offset of its first chunk in the file
+    uint32_t nRows;                   //!< Number of rows
+    std::vector<uint64_t> chunkSizes; //!< Size of the chunk of each column
+  };
+
+  /// Encode the columns buffered into a row group, and write it
+  void WriteRowGroup (void);
+
+  std::ofstream m_file;               //!< The file
+  uint32_t m_rowGroupSize;            //!< Number of rows per row group
+  std::vector<Column> m_columns;      //!< The columns
+  std::vector<RowGroup> m_rowGroups;  //!< The row groups written
+  uint32_t m_nBufferedRows;           //!< Number of rows buffered
+  uint64_t m_nRows;                   //!< Number of rows ended
+  std::string m_chunk;                //!< Encoding buffer
+};
+
+/**
+ * \ingroup stats
+ *
+ * \brief Reads the columns of a file written by a ColumnarFileWriter
+ */
+class ColumnarFileReader
+{
+public:
+  ColumnarFileReader ();
+
+  /**
+   * \brief Open a file and read its footer
+   * \param fileName the name of the file
+   * \return false if the file cannot be read or is not a columnar file
+   */
+  bool Open (const std::string &fileName);
+
+  /// \return the number of columns
+  uint32_t GetNColumns (void) const;
+  /// \return the number of rows
+  uint64_t GetNRows (void) const;
+  /**
+   * \param column the index of a column
+   * \return the name of the column
+   */
+  std::string GetColumnName (uint32_t column) const;
+  /**
+   * \param column the index of a column
+   * \return the type of the column
+   */
+  ColumnarFileWriter::ColumnType GetColumnType (uint32_t column) const;
+  /**
+   * \param name the name of a column
+   * \return the index of the column, or -1 if none
+   */
+  int32_t GetColumnIndex (const std::string &name) const;
+
+  /**
+   * \param column the index of an integer column
+   * \return the values of the column
+   */
+  std::vector<int64_t> ReadIntegerColumn (uint32_t column);
+  /**
+   * \param column the index of a double column
+   * \return the values of the column
+   */
+  std::vector<double> ReadDoubleColumn (uint32_t column);
+  /**
+   * \param column the index of a string column
+   * \return the values of the column
+   */
+  std::vector<std::string> ReadStringColumn (uint32_t column);
+
+private:
+  /// A row group of the file
+  struct RowGroup
+  {
+    uint64_t offset;                  //!< Offset of its first chunk in the file
+    uint32_t nRows;                   //!< Number of rows
+    std::vector<uint64_t> chunkSizes; //!< Size of the chunk of each column
+  };
+
+  /**
+   * \brief Read the chunk of a column in a row group
+   * \param rowGroup the row group
+   * \param column the index of the column
+   * \return the chunk
+   */
+  std::string ReadChunk (const RowGroup &rowGroup, uint32_t column);
+
+  std::ifstream m_file;                                   //!< The file
+  std::vector<std::string> m_names;                       //!< Names of the columns
+  std::vector<ColumnarFileWriter::ColumnType> m_types;    //!< Types of the columns
+  std::vector<RowGroup> m_rowGroups;                      //!< The row groups
+  uint64_t m_nRows;                                       //!< Number of rows
+};
+
+} // namespace ns3
+
+#endif /* COLUMNAR_FILE_H */
@@ -24,6 +24,8 @@
 
 #include "ns3/log.h"
 #include "ns3/nstime.h"
+#include "ns3/uinteger.h"
+#include "ns3/enum.h"
 
 #include "data-collector.h"
 #include "data-calculator.h"
@@ -35,7 +37,9 @@ NS_LOG_COMPONENT_DEFINE ("SqliteDataOutput");
 
 //--------------------------------------------------------------
 //----------------------------------------------
-SqliteDataOutput::SqliteDataOutput()
+SqliteDataOutput::SqliteDataOutput() :
+  m_db (0),
+  m_uncommittedRows (0)
 {
   NS_LOG_FUNCTION (this);
 
@@ -52,7 +56,27 @@ SqliteDataOutput::GetTypeId (void)
   static TypeId tid = TypeId ("ns3::SqliteDataOutput")
     .SetParent<DataOutputInterface> ()
     .SetGroupName ("Stats")
-    .AddConstructor<SqliteDataOutput> ();
+    .AddConstructor<SqliteDataOutput> ()
+    .AddAttribute ("CommitSize",
+                   "The number of rows inserted per transaction, or 0 "
+                   "to insert all the rows of a run in one transaction.",
+                   UintegerValue (10000),
+                   MakeUintegerAccessor (&SqliteDataOutput::m_commitSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("JournalMode",
+                   "The journal mode of the database.  In WAL mode, the "
+                   "database may be read while it is written, and the "
+                   "transactions are not synced to disk as they commit.",
+                   EnumValue (JOURNAL_WAL),
+                   MakeEnumAccessor (&SqliteDataOutput::m_journalMode),
+                   MakeEnumChecker (JOURNAL_DELETE, "Delete",
+                                    JOURNAL_WAL, "WAL"))
+    .AddAttribute ("BusyTimeout",
+                   "The time waited for the other processes writing to "
+                   "the database to commit their transaction.",
+                   TimeValue (Seconds (60)),
+                   MakeTimeAccessor (&SqliteDataOutput::m_busyTimeout),
+                   MakeTimeChecker ());
   return tid;
 }
   
@@ -83,6 +107,7 @@ SqliteDataOutput::Exec (std::string exe) {
 
   if (res != SQLITE_OK) {
       NS_LOG_ERROR ("sqlite3 error: \"" << errMsg << "\"");
+      sqlite3_free (errMsg);
       /*
       } else {
         // std::cout << "nrows " << nrows << " ncols " << ncols << std::endl;
@@ -110,6 +135,26 @@ SqliteDataOutput::Exec (std::string exe) {
   // end SqliteDataOutput::Exec
 }
 
+int
+SqliteDataOutput::Insert (sqlite3_stmt *stmt)
+{
+  int res = sqlite3_step (stmt);
+  // Reset the statement, so that it does not hold the transaction open
+  sqlite3_reset (stmt);
+  if (res != SQLITE_DONE)
+    {
+      NS_LOG_ERROR ("sqlite3 error: \"" << sqlite3_errmsg (m_db) << "\"");
+      return res;
+    }
+  if (m_commitSize > 0 && ++m_uncommittedRows >= m_commitSize)
+    {
+      Exec ("COMMIT");
+      Exec ("BEGIN IMMEDIATE");
+      m_uncommittedRows = 0;
+    }
+  return res;
+}
+
 //----------------------------------------------
 void
 SqliteDataOutput::Output (DataCollector &dc)
@@ -126,6 +171,23 @@ SqliteDataOutput::Output (DataCollector &dc)
       return;
     }
 
+  // Wait for the other writers, rather than failing
+  sqlite3_busy_timeout (m_db, static_cast<int> (m_busyTimeout.GetMilliSeconds ()));
+  if (m_journalMode == JOURNAL_WAL)
+    {
+      Exec ("PRAGMA journal_mode=WAL");
+      Exec ("PRAGMA synchronous=NORMAL");
+    }
+  else
+    {
+      Exec ("PRAGMA journal_mode=DELETE");
+    }
+
+  // Take the write lock up front: a deferred transaction which reads
+  // first could not be upgraded while another process writes
+  Exec ("BEGIN IMMEDIATE");
+  m_uncommittedRows = 0;
+
   Exec ("create table if not exists Experiments (run, experiment, strategy, input, description text)");
 
   sqlite3_stmt *stmt;
@@ -146,7 +208,7 @@ SqliteDataOutput::Output (DataCollector &dc)
                               dc.GetInputLabel ().length (), SQLITE_TRANSIENT);
   sqlite3_bind_text (stmt, 5, dc.GetDescription ().c_str (),
                               dc.GetDescription ().length (), SQLITE_TRANSIENT);
-  sqlite3_step (stmt);
+  Insert (stmt);
   sqlite3_finalize (stmt);
 
   Exec ("create table if not exists Metadata ( run text, key text, value)");
@@ -161,26 +223,27 @@ SqliteDataOutput::Output (DataCollector &dc)
        i != dc.MetadataEnd (); i++) {
       std::pair<std::string, std::string> blob = (*i);
 
-      sqlite3_reset (stmt);
       sqlite3_bind_text (stmt, 1, run.c_str (),
                                   run.length (), SQLITE_TRANSIENT);
       sqlite3_bind_text (stmt, 2, blob.first.c_str (),
                                   blob.first.length (), SQLITE_TRANSIENT);
       sqlite3_bind_text (stmt, 3, blob.second.c_str (),
                                   blob.second.length (), SQLITE_TRANSIENT);
-      sqlite3_step (stmt);
+      Insert (stmt);
     }
   sqlite3_finalize (stmt);
 
-  Exec ("BEGIN");
-  SqliteOutputCallback callback (this, run);
-  for (DataCalculatorList::iterator i = dc.DataCalculatorBegin ();
-       i != dc.DataCalculatorEnd (); i++) {
-      (*i)->Output (callback);
-    }
+  {
+    SqliteOutputCallback callback (this, run);
+    for (DataCalculatorList::iterator i = dc.DataCalculatorBegin ();
+         i != dc.DataCalculatorEnd (); i++) {
+        (*i)->Output (callback);
+      }
+  }
   Exec ("COMMIT");
 
   sqlite3_close (m_db);
+  m_db = 0;
 
   // end SqliteDataOutput::Output
 }
@@ -238,11 +301,10 @@ SqliteDataOutput::SqliteOutputCallback::OutputSingleton (std::string key,
 {
   NS_LOG_FUNCTION (this << key << variable << val);
 
-  sqlite3_reset (m_insertSingletonStatement);
   sqlite3_bind_text (m_insertSingletonStatement, 2, key.c_str (), key.length (), SQLITE_TRANSIENT);
   sqlite3_bind_text (m_insertSingletonStatement, 3, variable.c_str (), variable.length (), SQLITE_TRANSIENT);
   sqlite3_bind_int (m_insertSingletonStatement, 4, val);
-  sqlite3_step (m_insertSingletonStatement);
+  m_owner->Insert (m_insertSingletonStatement);
 }
 void
 SqliteDataOutput::SqliteOutputCallback::OutputSingleton (std::string key,
@@ -251,11 +313,10 @@ SqliteDataOutput::SqliteOutputCallback::OutputSingleton (std::string key,
 {
   NS_LOG_FUNCTION (this << key << variable << val);
 
-  sqlite3_reset (m_insertSingletonStatement);
   sqlite3_bind_text (m_insertSingletonStatement, 2, key.c_str (), key.length (), SQLITE_TRANSIENT);
   sqlite3_bind_text (m_insertSingletonStatement, 3, variable.c_str (), variable.length (), SQLITE_TRANSIENT);
   sqlite3_bind_int64 (m_insertSingletonStatement, 4, val);
-  sqlite3_step (m_insertSingletonStatement);
+  m_owner->Insert (m_insertSingletonStatement);
 }
 
 void
@@ -265,11 +326,10 @@ SqliteDataOutput::SqliteOutputCallback::OutputSingleton (std::string key,
 {
   NS_LOG_FUNCTION (this << key << variable << val);
 
-  sqlite3_reset (m_insertSingletonStatement);
   sqlite3_bind_text (m_insertSingletonStatement, 2, key.c_str (), key.length (), SQLITE_TRANSIENT);
   sqlite3_bind_text (m_insertSingletonStatement, 3, variable.c_str (), variable.length (), SQLITE_TRANSIENT);
   sqlite3_bind_double (m_insertSingletonStatement, 4, val);
-  sqlite3_step (m_insertSingletonStatement);
+  m_owner->Insert (m_insertSingletonStatement);
 }
 
 void
@@ -279,11 +339,10 @@ SqliteDataOutput::SqliteOutputCallback::OutputSingleton (std::string key,
 {
   NS_LOG_FUNCTION (this << key << variable << val);
 
-  sqlite3_reset (m_insertSingletonStatement);
   sqlite3_bind_text (m_insertSingletonStatement, 2, key.c_str (), key.length (), SQLITE_TRANSIENT);
   sqlite3_bind_text (m_insertSingletonStatement, 3, variable.c_str (), variable.length (), SQLITE_TRANSIENT);
   sqlite3_bind_text (m_insertSingletonStatement, 4, val.c_str (), val.length (), SQLITE_TRANSIENT);
-  sqlite3_step (m_insertSingletonStatement);
+  m_owner->Insert (m_insertSingletonStatement);
 }
 
 void
@@ -293,9 +352,8 @@ SqliteDataOutput::SqliteOutputCallback::OutputSingleton (std::string key,
 {
   NS_LOG_FUNCTION (this << key << variable << val);
 
-  sqlite3_reset (m_insertSingletonStatement);
   sqlite3_bind_text (m_insertSingletonStatement, 2, key.c_str (), key.length (), SQLITE_TRANSIENT);
   sqlite3_bind_text (m_insertSingletonStatement, 3, variable.c_str (), variable.length (), SQLITE_TRANSIENT);
   sqlite3_bind_int64 (m_insertSingletonStatement, 4, val.GetTimeStep ());
-  sqlite3_step (m_insertSingletonStatement);
+  m_owner->Insert (m_insertSingletonStatement);
 }
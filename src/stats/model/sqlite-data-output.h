@@ -37,6 +37,15 @@ namespace ns3 {
  * \ingroup dataoutput
  * \class SqliteDataOutput
  * \brief Outputs data in a format compatible with SQLite
+ *
+ * The rows of a run are inserted with prepared statements, in
+ * transactions of CommitSize rows.  The database is opened in the
+ * journal mode of the JournalMode attribute, by default WAL, in which the
+ * readers do not block the writer: the worker processes of a sweep may
+ * each output their runs to the same database, labelled by run, a writer
+ * waiting up to BusyTimeout for the others to commit their transaction.
+ * The database must not be open when the workers are forked, which is
+ * the case outside of Output ().
  */
 class SqliteDataOutput : public DataOutputInterface {
 public:
@@ -51,6 +60,13 @@ public:
   
   virtual void Output (DataCollector &dc);
 
+  /// The journal modes of the database
+  enum JournalMode
+  {
+    JOURNAL_DELETE,  //!< Rollback journal, deleted at the end of each transaction
+    JOURNAL_WAL      //!< Write-ahead log
+  };
+
 protected:
   virtual void DoDispose ();
 
@@ -144,6 +160,10 @@ private:
 
 
   sqlite3 *m_db; //!< pointer to the SQL database
+  uint32_t m_commitSize;      //!< Number of rows inserted per transaction, or 0 for one transaction per run
+  JournalMode m_journalMode;  //!< The journal mode of the database
+  Time m_busyTimeout;         //!< Time waited for the lock of the database
+  uint32_t m_uncommittedRows; //!< Number of rows inserted in the current transaction
 
   /**
    * \brief Execute a sqlite3 query
@@ -152,6 +172,14 @@ private:
    */
   int Exec (std::string exe);
 
+  /**
+   * \brief Execute a prepared insert statement, and commit the current
+   * transaction after CommitSize rows
+   * \param stmt the statement, with its parameters bound
+   * \return sqlite return code.
+   */
+  int Insert (sqlite3_stmt *stmt);
+
   // end class SqliteDataOutput
 };
 
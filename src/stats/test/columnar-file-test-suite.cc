@@ -0,0 +1,264 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <sstream>
+
+#include "ns3/test.h"
+#include "ns3/columnar-file.h"
+#include "ns3/columnar-aggregator.h"
+#include "ns3/columnar-data-output.h"
+#include "ns3/data-collector.h"
+#include "ns3/basic-data-calculators.h"
+#include "ns3/random-variable-stream.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup stats-tests
+ *
+ * \brief Write a table over several row groups, and read it back
+ */
+class ColumnarFileRoundTripTestCase : public TestCase
+{
+public:
+  ColumnarFileRoundTripTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+ColumnarFileRoundTripTestCase::ColumnarFileRoundTripTestCase ()
+  : TestCase ("The values read from a columnar file must be the values written")
+{
+}
+
+void
+ColumnarFileRoundTripTestCase::DoRun (void)
+{
+  Ptr<UniformRandomVariable> rand = CreateObject<UniformRandomVariable> ();
+  const uint32_t nRows = 2500;
+  std::vector<int64_t> integers;
+  std::vector<double> doubles;
+  std::vector<std::string> strings;
+  for (uint32_t i = 0; i < nRows; i++)
+    {
+      switch (i % 10)
+        {
+        case 0:
+          integers.push_back (std::numeric_limits<int64_t>::min ());
+          doubles.push_back (std::numeric_limits<double>::quiet_NaN ());
+          strings.push_back ("");
+          break;
+        case 1:
+          integers.push_back (std::numeric_limits<int64_t>::max ());
+          doubles.push_back (-0.0);
+          strings.push_back ("a longer string, repeated");
+          break;
+        case 2:
+          integers.push_back (-rand->GetInteger (0, 1000000));
+          doubles.push_back (std::numeric_limits<double>::infinity ());
+          strings.push_back ("a longer string, repeated");
+          break;
+        default:
+          integers.push_back (i * 1000);
+          doubles.push_back (i % 2 ? 0.001 * i : rand->GetValue (-1e9, 1e9));
+          std::ostringstream oss;
+          oss << "node-" << rand->GetInteger (0, 99);
+          strings.push_back (oss.str ());
+        }
+    }
+
+  std::string fileName = CreateTempDirFilename ("columnar-round-trip.col");
+  ColumnarFileWriter writer;
+  writer.Open (fileName, 1000);
+  uint32_t integerColumn = writer.AddColumn ("integer", ColumnarFileWriter::INTEGER);
+  uint32_t doubleColumn = writer.AddColumn ("double", ColumnarFileWriter::DOUBLE);
+  uint32_t stringColumn = writer.AddColumn ("string", ColumnarFileWriter::STRING);
+  for (uint32_t i = 0; i < nRows; i++)
+    {
+      writer.AppendInteger (integerColumn, integers[i]);
+      writer.AppendDouble (doubleColumn, doubles[i]);
+      writer.AppendString (stringColumn, strings[i]);
+      writer.EndRow ();
+    }
+  writer.Close ();
+  NS_TEST_ASSERT_MSG_EQ (writer.GetNRows (), nRows, "Wrong number of rows written");
+
+  ColumnarFileReader reader;
+  NS_TEST_ASSERT_MSG_EQ (reader.Open (fileName), true, "Cannot read the file");
+  NS_TEST_ASSERT_MSG_EQ (reader.GetNColumns (), 3, "Wrong number of columns");
+  NS_TEST_ASSERT_MSG_EQ (reader.GetNRows (), nRows, "Wrong number of rows read");
+  NS_TEST_ASSERT_MSG_EQ (reader.GetColumnName (1), "double", "Wrong column name");
+  NS_TEST_ASSERT_MSG_EQ (reader.GetColumnType (2), ColumnarFileWriter::STRING, "Wrong column type");
+  NS_TEST_ASSERT_MSG_EQ (reader.GetColumnIndex ("string"), 2, "Wrong column index");
+  NS_TEST_ASSERT_MSG_EQ (reader.GetColumnIndex ("none"), -1, "Unexpected column");
+
+  std::vector<int64_t> readIntegers = reader.ReadIntegerColumn (integerColumn);
+  std::vector<double> readDoubles = reader.ReadDoubleColumn (doubleColumn);
+  std::vector<std::string> readStrings = reader.ReadStringColumn (stringColumn);
+  NS_TEST_ASSERT_MSG_EQ (readIntegers.size (), nRows, "Wrong number of integers");
+  NS_TEST_ASSERT_MSG_EQ (readDoubles.size (), nRows, "Wrong number of doubles");
+  NS_TEST_ASSERT_MSG_EQ (readStrings.size (), nRows, "Wrong number of strings");
+  for (uint32_t i = 0; i < nRows; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (readIntegers[i], integers[i], "Wrong integer in row " << i);
+      // Bitwise comparison, for NaN and -0
+      NS_TEST_ASSERT_MSG_EQ (std::memcmp (&readDoubles[i], &doubles[i], sizeof (double)), 0,
+                             "Wrong double in row " << i);
+      NS_TEST_ASSERT_MSG_EQ (readStrings[i], strings[i], "Wrong string in row " << i);
+    }
+
+  ColumnarFileReader notColumnar;
+  NS_TEST_ASSERT_MSG_EQ (notColumnar.Open (CreateTempDirFilename ("none.col")), false,
+                         "A missing file must not be read");
+}
+
+/**
+ * \ingroup stats-tests
+ *
+ * \brief Check the file written by a ColumnarAggregator
+ */
+class ColumnarAggregatorTestCase : public TestCase
+{
+public:
+  ColumnarAggregatorTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+ColumnarAggregatorTestCase::ColumnarAggregatorTestCase ()
+  : TestCase ("The columnar aggregator must write the values of each context")
+{
+}
+
+void
+ColumnarAggregatorTestCase::DoRun (void)
+{
+  std::string fileName = CreateTempDirFilename ("columnar-aggregator.col");
+  Ptr<ColumnarAggregator> aggregator = CreateObject<ColumnarAggregator> (fileName, 7);
+  for (uint32_t i = 0; i < 20; i++)
+    {
+      aggregator->Write2d ("cwnd", 0.1 * i, 536 * i);
+      aggregator->Write1d ("rtt", 0.2 + i);
+    }
+  aggregator->Disable ();
+  aggregator->Write2d ("cwnd", 100, 100);
+  aggregator->Close ();
+
+  ColumnarFileReader reader;
+  NS_TEST_ASSERT_MSG_EQ (reader.Open (fileName), true, "Cannot read the file");
+  NS_TEST_ASSERT_MSG_EQ (reader.GetNRows (), 40, "Wrong number of rows");
+  std::vector<std::string> contexts = reader.ReadStringColumn (reader.GetColumnIndex ("context"));
+  std::vector<double> x = reader.ReadDoubleColumn (reader.GetColumnIndex ("x"));
+  std::vector<double> y = reader.ReadDoubleColumn (reader.GetColumnIndex ("y"));
+  for (uint32_t i = 0; i < 20; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (contexts[2 * i], "cwnd", "Wrong context");
+      NS_TEST_ASSERT_MSG_EQ (x[2 * i], 0.1 * i, "Wrong 2D x value");
+      NS_TEST_ASSERT_MSG_EQ (y[2 * i], 536 * i, "Wrong 2D y value");
+      NS_TEST_ASSERT_MSG_EQ (contexts[2 * i + 1], "rtt", "Wrong context");
+      NS_TEST_ASSERT_MSG_EQ (x[2 * i + 1], i, "Wrong 1D rank");
+      NS_TEST_ASSERT_MSG_EQ (y[2 * i + 1], 0.2 + i, "Wrong 1D value");
+    }
+}
+
+/**
+ * \ingroup stats-tests
+ *
+ * \brief Check the file written by a ColumnarDataOutput
+ */
+class ColumnarDataOutputTestCase : public TestCase
+{
+public:
+  ColumnarDataOutputTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+ColumnarDataOutputTestCase::ColumnarDataOutputTestCase ()
+  : TestCase ("The columnar data output must write the values of the calculators")
+{
+}
+
+void
+ColumnarDataOutputTestCase::DoRun (void)
+{
+  DataCollector data;
+  data.DescribeRun ("experiment", "strategy", "input", "run-1");
+
+  Ptr<CounterCalculator<> > counter = CreateObject<CounterCalculator<> > ();
+  counter->SetKey ("packets");
+  counter->SetContext ("node[0]");
+  counter->Update (42);
+  data.AddDataCalculator (counter);
+
+  Ptr<MinMaxAvgTotalCalculator<double> > delay = CreateObject<MinMaxAvgTotalCalculator<double> > ();
+  delay->SetKey ("delay");
+  delay->SetContext ("node[1]");
+  delay->Update (1);
+  delay->Update (3);
+  data.AddDataCalculator (delay);
+
+  Ptr<ColumnarDataOutput> output = CreateObject<ColumnarDataOutput> ();
+  output->SetFilePrefix (CreateTempDirFilename ("columnar-data"));
+  output->Output (data);
+
+  ColumnarFileReader reader;
+  NS_TEST_ASSERT_MSG_EQ (reader.Open (CreateTempDirFilename ("columnar-data-run-1.col")), true,
+                         "Cannot read the file");
+  std::vector<std::string> runs = reader.ReadStringColumn (reader.GetColumnIndex ("run"));
+  std::vector<std::string> contexts = reader.ReadStringColumn (reader.GetColumnIndex ("context"));
+  std::vector<std::string> variables = reader.ReadStringColumn (reader.GetColumnIndex ("variable"));
+  std::vector<double> values = reader.ReadDoubleColumn (reader.GetColumnIndex ("value"));
+  std::map<std::string, double> valueOf;
+  for (uint32_t i = 0; i < reader.GetNRows (); i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (runs[i], "run-1", "Wrong run label");
+      valueOf[contexts[i] + "/" + variables[i]] = values[i];
+    }
+  NS_TEST_ASSERT_MSG_EQ (valueOf["node[0]/packets"], 42, "Wrong counter");
+  NS_TEST_ASSERT_MSG_EQ (valueOf["node[1]/delay-count"], 2, "Wrong count");
+  NS_TEST_ASSERT_MSG_EQ (valueOf["node[1]/delay-total"], 4, "Wrong total");
+  NS_TEST_ASSERT_MSG_EQ (valueOf["node[1]/delay-max"], 3, "Wrong maximum");
+  NS_TEST_ASSERT_MSG_EQ (valueOf["node[1]/delay-min"], 1, "Wrong minimum");
+}
+
+/**
+ * \ingroup stats-tests
+ *
+ * \brief Columnar file TestSuite
+ */
+class ColumnarFileTestSuite : public TestSuite
+{
+public:
+  ColumnarFileTestSuite ();
+};
+
+ColumnarFileTestSuite::ColumnarFileTestSuite ()
+  : TestSuite ("columnar-file", UNIT)
+{
+  AddTestCase (new ColumnarFileRoundTripTestCase, TestCase::QUICK);
+  AddTestCase (new ColumnarAggregatorTestCase, TestCase::QUICK);
+  AddTestCase (new ColumnarDataOutputTestCase, TestCase::QUICK);
+}
+
+static ColumnarFileTestSuite g_columnarFileTestSuite; //!< Static variable for test initialization
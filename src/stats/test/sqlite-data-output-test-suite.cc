@@ -0,0 +1,226 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <sstream>
+#include <vector>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "ns3/test.h"
+#include "ns3/sqlite-data-output.h"
+#include "ns3/data-collector.h"
+#include "ns3/basic-data-calculators.h"
+#include "ns3/uinteger.h"
+#include "ns3/enum.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup stats-tests
+ *
+ * \brief Output several runs to a database, in transactions of a few
+ * rows, and check its rows
+ *
+ * The runs are output by the test process, or split between forked
+ * writer processes outputting to the same database at once.
+ */
+class SqliteDataOutputTestCase : public TestCase
+{
+public:
+  /**
+   * \param commitSize the number of rows per transaction
+   * \param journalMode the journal mode of the database
+   * \param nWriters the number of forked writer processes, 0 for none
+   */
+  SqliteDataOutputTestCase (uint32_t commitSize, SqliteDataOutput::JournalMode journalMode,
+                            uint32_t nWriters);
+
+private:
+  virtual void DoRun (void);
+  /**
+   * \param commitSize the number of rows per transaction
+   * \param journalMode the journal mode of the database
+   * \param nWriters the number of forked writer processes
+   * \return the name of the test case
+   */
+  static std::string GetName (uint32_t commitSize, SqliteDataOutput::JournalMode journalMode,
+                              uint32_t nWriters);
+  /**
+   * \brief Output a run to the database
+   * \param prefix the prefix of the database
+   * \param run the index of the run
+   */
+  void OutputRun (const std::string &prefix, uint32_t run);
+  /**
+   * \param db a database
+   * \param query a query returning a single value
+   * \return the value
+   */
+  std::string Query (sqlite3 *db, const std::string &query);
+
+  uint32_t m_commitSize;                       //!< Number of rows per transaction
+  SqliteDataOutput::JournalMode m_journalMode; //!< The journal mode
+  uint32_t m_nWriters;                         //!< Number of writer processes
+};
+
+SqliteDataOutputTestCase::SqliteDataOutputTestCase (uint32_t commitSize,
+                                                    SqliteDataOutput::JournalMode journalMode,
+                                                    uint32_t nWriters)
+  : TestCase (GetName (commitSize, journalMode, nWriters)),
+    m_commitSize (commitSize),
+    m_journalMode (journalMode),
+    m_nWriters (nWriters)
+{
+}
+
+std::string
+SqliteDataOutputTestCase::GetName (uint32_t commitSize, SqliteDataOutput::JournalMode journalMode,
+                                   uint32_t nWriters)
+{
+  std::ostringstream name;
+  name << "The database must hold the rows of each run output, CommitSize=" << commitSize
+       << ", JournalMode=" << (journalMode == SqliteDataOutput::JOURNAL_WAL ? "WAL" : "Delete");
+  if (nWriters > 0)
+    {
+      name << ", " << nWriters << " forked writers";
+    }
+  return name.str ();
+}
+
+void
+SqliteDataOutputTestCase::OutputRun (const std::string &prefix, uint32_t run)
+{
+  DataCollector data;
+  std::ostringstream runLabel;
+  runLabel << "run-" << run;
+  data.DescribeRun ("experiment", "strategy", "input", runLabel.str ());
+  data.AddMetadata ("seed", run);
+  for (uint32_t n = 0; n < 50; n++)
+    {
+      Ptr<CounterCalculator<> > counter = CreateObject<CounterCalculator<> > ();
+      std::ostringstream context;
+      context << "node[" << n << "]";
+      counter->SetKey ("packets");
+      counter->SetContext (context.str ());
+      counter->Update (10 * run + n);
+      data.AddDataCalculator (counter);
+    }
+  Ptr<SqliteDataOutput> output = CreateObject<SqliteDataOutput> ();
+  output->SetAttribute ("CommitSize", UintegerValue (m_commitSize));
+  output->SetAttribute ("JournalMode", EnumValue (m_journalMode));
+  output->SetFilePrefix (prefix);
+  output->Output (data);
+}
+
+std::string
+SqliteDataOutputTestCase::Query (sqlite3 *db, const std::string &query)
+{
+  sqlite3_stmt *stmt;
+  std::string value;
+  if (sqlite3_prepare_v2 (db, query.c_str (), -1, &stmt, NULL) == SQLITE_OK)
+    {
+      if (sqlite3_step (stmt) == SQLITE_ROW)
+        {
+          value = reinterpret_cast<const char *> (sqlite3_column_text (stmt, 0));
+        }
+      sqlite3_finalize (stmt);
+    }
+  return value;
+}
+
+void
+SqliteDataOutputTestCase::DoRun (void)
+{
+  std::ostringstream prefix;
+  prefix << "sqlite-data-output-" << m_commitSize << "-" << m_journalMode << "-" << m_nWriters;
+  std::string prefixName = CreateTempDirFilename (prefix.str ());
+  uint32_t nRuns = 3;
+  if (m_nWriters == 0)
+    {
+      for (uint32_t run = 0; run < nRuns; run++)
+        {
+          OutputRun (prefixName, run);
+        }
+    }
+  else
+    {
+      // The writers output their runs at once, interleaving their
+      // transactions
+      nRuns = 5 * m_nWriters;
+      std::vector<pid_t> writers;
+      for (uint32_t w = 0; w < m_nWriters; w++)
+        {
+          pid_t pid = fork ();
+          NS_TEST_ASSERT_MSG_NE (pid, -1, "Cannot fork a writer");
+          if (pid == 0)
+            {
+              for (uint32_t run = w; run < nRuns; run += m_nWriters)
+                {
+                  OutputRun (prefixName, run);
+                }
+              _exit (0);
+            }
+          writers.push_back (pid);
+        }
+      for (std::vector<pid_t>::const_iterator pid = writers.begin (); pid != writers.end (); pid++)
+        {
+          int status;
+          NS_TEST_ASSERT_MSG_EQ (waitpid (*pid, &status, 0), *pid, "Lost a writer");
+          NS_TEST_EXPECT_MSG_EQ ((WIFEXITED (status) && WEXITSTATUS (status) == 0), true, "A writer failed");
+        }
+    }
+
+  sqlite3 *db;
+  NS_TEST_ASSERT_MSG_EQ (sqlite3_open ((prefixName + ".db").c_str (), &db), SQLITE_OK, "Cannot open the database");
+  std::string journalMode = m_journalMode == SqliteDataOutput::JOURNAL_WAL ? "wal" : "delete";
+  NS_TEST_EXPECT_MSG_EQ (Query (db, "PRAGMA journal_mode"), journalMode, "Wrong journal mode");
+  std::ostringstream runs, values;
+  runs << nRuns;
+  values << 50 * nRuns;
+  NS_TEST_EXPECT_MSG_EQ (Query (db, "select count(*) from Experiments"), runs.str (), "Wrong number of runs");
+  NS_TEST_EXPECT_MSG_EQ (Query (db, "select count(*) from Metadata"), runs.str (), "Wrong number of metadata");
+  NS_TEST_EXPECT_MSG_EQ (Query (db, "select count(*) from Singletons"), values.str (), "Wrong number of values");
+  NS_TEST_EXPECT_MSG_EQ (Query (db, "select count(distinct run) from Singletons"), runs.str (),
+                         "Wrong number of runs with values");
+  NS_TEST_EXPECT_MSG_EQ (Query (db, "select value from Singletons where run = 'run-2' and name = 'node[3]'"), "23",
+                         "Wrong value");
+  NS_TEST_EXPECT_MSG_EQ (Query (db, "select value from Metadata where run = 'run-1' and key = 'seed'"), "1",
+                         "Wrong metadata");
+  sqlite3_close (db);
+}
+
+/**
+ * \ingroup stats-tests
+ *
+ * \brief SqliteDataOutput TestSuite
+ */
+class SqliteDataOutputTestSuite : public TestSuite
+{
+public:
+  SqliteDataOutputTestSuite ();
+};
+
+SqliteDataOutputTestSuite::SqliteDataOutputTestSuite ()
+  : TestSuite ("sqlite-data-output", UNIT)
+{
+  AddTestCase (new SqliteDataOutputTestCase (0, SqliteDataOutput::JOURNAL_WAL, 0), TestCase::QUICK);
+  AddTestCase (new SqliteDataOutputTestCase (2, SqliteDataOutput::JOURNAL_WAL, 0), TestCase::QUICK);
+  AddTestCase (new SqliteDataOutputTestCase (1, SqliteDataOutput::JOURNAL_DELETE, 0), TestCase::QUICK);
+  AddTestCase (new SqliteDataOutputTestCase (10, SqliteDataOutput::JOURNAL_WAL, 4), TestCase::QUICK);
+  AddTestCase (new SqliteDataOutputTestCase (10, SqliteDataOutput::JOURNAL_DELETE, 3), TestCase::QUICK);
+}
+
+static SqliteDataOutputTestSuite g_sqliteDataOutputTestSuite; //!< Static variable for test initialization
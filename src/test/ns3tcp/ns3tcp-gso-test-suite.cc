@@ -0,0 +1,426 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/test.h"
+#include "ns3/config.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/pointer.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/point-to-point-helper.h"
+#include "ns3/point-to-point-net-device.h"
+#include "ns3/csma-helper.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-global-routing-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/bulk-send-helper.h"
+#include "ns3/packet-sink-helper.h"
+#include "ns3/packet-sink.h"
+#include "ns3/error-model.h"
+#include "ns3/gso-tag.h"
+#include "ns3/tcp-header.h"
+#include "ns3/tcp-l4-protocol.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/ipv4-queue-disc-item.h"
+#include "ns3/fifo-queue-disc.h"
+#include "ns3/queue.h"
+#include "ns3/node-container.h"
+#include "ns3/simulator.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("Ns3TcpGsoTest");
+
+// ===========================================================================
+// Tests of the TCP generic segmentation offload
+// ===========================================================================
+//
+// n0 ---- n1 ---- n2
+//   p2p     p2p or csma
+//
+// A bulk transfer from n0 to n2 with super-segments of up to 16 segments.
+// The second link may lose segments, or may not support super-segments,
+// in which case n1 segments them.
+//
+class Ns3TcpGsoTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor
+   * \param errorRate the segment error rate of the second link
+   * \param csma whether the second link is a CSMA link
+   */
+  Ns3TcpGsoTestCase (double errorRate, bool csma);
+  virtual ~Ns3TcpGsoTestCase () {}
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Count the super-segments transmitted by the first device
+   * \param p the packet
+   */
+  void FirstTx (Ptr<const Packet> p);
+  /**
+   * Check the packets transmitted on the second link
+   * \param p the packet
+   */
+  void SecondTx (Ptr<const Packet> p);
+
+  double m_errorRate;         //!< segment error rate of the second link
+  bool m_csma;                //!< whether the second link is a CSMA link
+  uint32_t m_superSegments;   //!< number of super-segments sent by n0
+  uint32_t m_maxSecondSize;   //!< largest packet sent on the second link
+};
+
+Ns3TcpGsoTestCase::Ns3TcpGsoTestCase (double errorRate, bool csma)
+  : TestCase (std::string ("Check a bulk transfer with TCP segmentation offload")
+              + (errorRate > 0 ? ", lossy link" : "") + (csma ? ", csma link" : "")),
+    m_errorRate (errorRate),
+    m_csma (csma),
+    m_superSegments (0),
+    m_maxSecondSize (0)
+{
+}
+
+void
+Ns3TcpGsoTestCase::FirstTx (Ptr<const Packet> p)
+{
+  GsoTag gso;
+  if (p->PeekPacketTag (gso))
+    {
+      m_superSegments++;
+    }
+}
+
+void
+Ns3TcpGsoTestCase::SecondTx (Ptr<const Packet> p)
+{
+  m_maxSecondSize = std::max (m_maxSecondSize, p->GetSize ());
+}
+
+void
+Ns3TcpGsoTestCase::DoRun (void)
+{
+  uint32_t maxBytes = 2000000;
+  uint16_t sinkPort = 50000;
+
+  Config::SetDefault ("ns3::TcpSocketBase::GsoMaxSegments", UintegerValue (16));
+
+  NodeContainer nodes;
+  nodes.Create (3);
+
+  PointToPointHelper pointToPoint;
+  pointToPoint.SetDeviceAttribute ("DataRate", StringValue ("100Mbps"));
+  pointToPoint.SetChannelAttribute ("Delay", StringValue ("2ms"));
+  NetDeviceContainer first = pointToPoint.Install (nodes.Get (0), nodes.Get (1));
+
+  NetDeviceContainer second;
+  if (m_csma)
+    {
+      CsmaHelper csma;
+      csma.SetChannelAttribute ("DataRate", StringValue ("10Mbps"));
+      csma.SetChannelAttribute ("Delay", StringValue ("2ms"));
+      second = csma.Install (NodeContainer (nodes.Get (1), nodes.Get (2)));
+    }
+  else
+    {
+      pointToPoint.SetDeviceAttribute ("DataRate", StringValue ("10Mbps"));
+      second = pointToPoint.Install (nodes.Get (1), nodes.Get (2));
+    }
+
+  if (m_errorRate > 0)
+    {
+      Ptr<RateErrorModel> em = CreateObject<RateErrorModel> ();
+      em->SetUnit (RateErrorModel::ERROR_UNIT_PACKET);
+      em->SetRate (m_errorRate);
+      second.Get (1)->SetAttribute ("ReceiveErrorModel", PointerValue (em));
+    }
+
+  InternetStackHelper internet;
+  internet.Install (nodes);
+
+  Ipv4AddressHelper address;
+  address.SetBase ("10.1.1.0", "255.255.255.0");
+  address.Assign (first);
+  address.SetBase ("10.1.2.0", "255.255.255.0");
+  Ipv4InterfaceContainer ifContainer = address.Assign (second);
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+
+  BulkSendHelper source ("ns3::TcpSocketFactory",
+                         InetSocketAddress (ifContainer.GetAddress (1), sinkPort));
+  source.SetAttribute ("MaxBytes", UintegerValue (maxBytes));
+  ApplicationContainer sourceApps = source.Install (nodes.Get (0));
+  sourceApps.Start (Seconds (0.0));
+
+  PacketSinkHelper sink ("ns3::TcpSocketFactory",
+                         InetSocketAddress (Ipv4Address::GetAny (), sinkPort));
+  ApplicationContainer sinkApps = sink.Install (nodes.Get (2));
+  sinkApps.Start (Seconds (0.0));
+
+  first.Get (0)->TraceConnectWithoutContext ("PhyTxBegin", MakeCallback (&Ns3TcpGsoTestCase::FirstTx, this));
+  second.Get (0)->TraceConnectWithoutContext ("PhyTxBegin", MakeCallback (&Ns3TcpGsoTestCase::SecondTx, this));
+
+  Simulator::Stop (Seconds (20));
+  Simulator::Run ();
+
+  Ptr<PacketSink> packetSink = DynamicCast<PacketSink> (sinkApps.Get (0));
+  NS_TEST_EXPECT_MSG_EQ (packetSink->GetTotalRx (), maxBytes, "All the bytes must be received");
+  NS_TEST_EXPECT_MSG_GT (m_superSegments, 0, "Super-segments must be sent");
+  if (m_csma)
+    {
+      NS_TEST_EXPECT_MSG_LT_OR_EQ (m_maxSecondSize, second.Get (0)->GetMtu () + 18,
+                                   "The router must segment the super-segments");
+    }
+  else
+    {
+      NS_TEST_EXPECT_MSG_GT (m_maxSecondSize, second.Get (0)->GetMtu (),
+                             "The router must forward the super-segments");
+    }
+
+  Simulator::Destroy ();
+  Config::SetDefault ("ns3::TcpSocketBase::GsoMaxSegments", UintegerValue (1));
+}
+
+// ===========================================================================
+// Tests of the per-segment error model and sniffer traces
+// ===========================================================================
+//
+// n0 ---- n1
+//    p2p
+//
+// A bulk transfer with super-segments of up to 16 segments.  The receive
+// error model of n1 drops the segments it is given by their arrival index,
+// so it must see each segment of a super-segment, and the sniffers (hence
+// the pcap traces) must see one frame per segment sent or received.
+//
+class Ns3TcpGsoSegmentTestCase : public TestCase
+{
+public:
+  Ns3TcpGsoSegmentTestCase ();
+  virtual ~Ns3TcpGsoSegmentTestCase () {}
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Count the frames sniffed by a device
+   * \param context the index of the node
+   * \param p the frame
+   */
+  void Sniffed (std::string context, Ptr<const Packet> p);
+
+  uint32_t m_frames[2];       //!< number of frames sniffed by each node
+  uint32_t m_maxFrameSize;    //!< largest frame sniffed
+  uint32_t m_taggedFrames;    //!< number of sniffed frames with a GsoTag
+};
+
+Ns3TcpGsoSegmentTestCase::Ns3TcpGsoSegmentTestCase ()
+  : TestCase ("Check the error model and the sniffers see each segment of a super-segment"),
+    m_maxFrameSize (0),
+    m_taggedFrames (0)
+{
+  m_frames[0] = m_frames[1] = 0;
+}
+
+void
+Ns3TcpGsoSegmentTestCase::Sniffed (std::string context, Ptr<const Packet> p)
+{
+  GsoTag gso;
+  m_frames[context == "1"]++;
+  m_maxFrameSize = std::max (m_maxFrameSize, p->GetSize ());
+  if (p->PeekPacketTag (gso))
+    {
+      m_taggedFrames++;
+    }
+}
+
+void
+Ns3TcpGsoSegmentTestCase::DoRun (void)
+{
+  uint32_t maxBytes = 500000;
+  uint16_t sinkPort = 50000;
+
+  Config::SetDefault ("ns3::TcpSocketBase::GsoMaxSegments", UintegerValue (16));
+
+  NodeContainer nodes;
+  nodes.Create (2);
+
+  PointToPointHelper pointToPoint;
+  pointToPoint.SetDeviceAttribute ("DataRate", StringValue ("10Mbps"));
+  pointToPoint.SetChannelAttribute ("Delay", StringValue ("2ms"));
+  NetDeviceContainer devices = pointToPoint.Install (nodes);
+
+  std::list<uint32_t> errors;
+  errors.push_back (20);
+  errors.push_back (21);
+  errors.push_back (45);
+  Ptr<ReceiveListErrorModel> em = CreateObject<ReceiveListErrorModel> ();
+  em->SetList (errors);
+  devices.Get (1)->SetAttribute ("ReceiveErrorModel", PointerValue (em));
+
+  InternetStackHelper internet;
+  internet.Install (nodes);
+
+  Ipv4AddressHelper address;
+  address.SetBase ("10.1.1.0", "255.255.255.0");
+  Ipv4InterfaceContainer ifContainer = address.Assign (devices);
+
+  BulkSendHelper source ("ns3::TcpSocketFactory",
+                         InetSocketAddress (ifContainer.GetAddress (1), sinkPort));
+  source.SetAttribute ("MaxBytes", UintegerValue (maxBytes));
+  ApplicationContainer sourceApps = source.Install (nodes.Get (0));
+  sourceApps.Start (Seconds (0.0));
+
+  PacketSinkHelper sink ("ns3::TcpSocketFactory",
+                         InetSocketAddress (Ipv4Address::GetAny (), sinkPort));
+  ApplicationContainer sinkApps = sink.Install (nodes.Get (1));
+  sinkApps.Start (Seconds (0.0));
+
+  devices.Get (0)->TraceConnect ("Sniffer", "0", MakeCallback (&Ns3TcpGsoSegmentTestCase::Sniffed, this));
+  devices.Get (1)->TraceConnect ("Sniffer", "1", MakeCallback (&Ns3TcpGsoSegmentTestCase::Sniffed, this));
+
+  Simulator::Stop (Seconds (20));
+  Simulator::Run ();
+
+  Ptr<PacketSink> packetSink = DynamicCast<PacketSink> (sinkApps.Get (0));
+  NS_TEST_EXPECT_MSG_EQ (packetSink->GetTotalRx (), maxBytes, "All the bytes must be received");
+  // n0 sniffs the data segments it sends and the acks, n1 the data segments
+  // not lost and the acks
+  NS_TEST_EXPECT_MSG_EQ (m_frames[0], m_frames[1] + errors.size (),
+                         "The error model must drop single segments, the sniffers must see the others");
+  NS_TEST_EXPECT_MSG_EQ (m_taggedFrames, 0, "The sniffers must not see super-segments");
+  NS_TEST_EXPECT_MSG_LT_OR_EQ (m_maxFrameSize, devices.Get (1)->GetMtu () + 2,
+                               "The sniffed frames must fit the MTU");
+
+  Simulator::Destroy ();
+  Config::SetDefault ("ns3::TcpSocketBase::GsoMaxSegments", UintegerValue (1));
+}
+
+// ===========================================================================
+//
+// A queue disc and the queue of a point-to-point device, limited to 6
+// packets, are given a super-segment of 4 segments, then one of 3: the
+// first one fits whole, only the last segment of the second one must be
+// dropped.
+//
+class Ns3TcpGsoAdmissionTestCase : public TestCase
+{
+public:
+  Ns3TcpGsoAdmissionTestCase ();
+  virtual ~Ns3TcpGsoAdmissionTestCase () {}
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Create a super-segment, starting with its TCP header
+   * \param nSegments the number of segments
+   * \param header [out] the IPv4 header of the super-segment
+   * \return the super-segment
+   */
+  static Ptr<Packet> CreateSuperSegment (uint32_t nSegments, Ipv4Header &header);
+};
+
+Ns3TcpGsoAdmissionTestCase::Ns3TcpGsoAdmissionTestCase ()
+  : TestCase ("Check the queues only drop the segments of a super-segment which do not fit")
+{
+}
+
+Ptr<Packet>
+Ns3TcpGsoAdmissionTestCase::CreateSuperSegment (uint32_t nSegments, Ipv4Header &header)
+{
+  Ptr<Packet> p = Create<Packet> (1000 * nSegments);
+  TcpHeader tcpHeader;
+  tcpHeader.SetSequenceNumber (SequenceNumber32 (1));
+  p->AddHeader (tcpHeader);
+  p->AddPacketTag (GsoTag (1000, 1000 * nSegments));
+  header.SetSource (Ipv4Address ("10.1.1.1"));
+  header.SetDestination (Ipv4Address ("10.1.1.2"));
+  header.SetProtocol (TcpL4Protocol::PROT_NUMBER);
+  header.SetPayloadSize (p->GetSize ());
+  return p;
+}
+
+void
+Ns3TcpGsoAdmissionTestCase::DoRun (void)
+{
+  NodeContainer nodes;
+  nodes.Create (2);
+
+  PointToPointHelper pointToPoint;
+  pointToPoint.SetDeviceAttribute ("DataRate", StringValue ("10Mbps"));
+  pointToPoint.SetChannelAttribute ("Delay", StringValue ("2ms"));
+  pointToPoint.SetQueue ("ns3::DropTailQueue", "MaxSize", StringValue ("6p"));
+  NetDeviceContainer devices = pointToPoint.Install (nodes);
+
+  // The IPv4 stack registers the segmenter of IPv4
+  InternetStackHelper internet;
+  internet.Install (nodes);
+
+  Ptr<FifoQueueDisc> qdisc = CreateObject<FifoQueueDisc> ();
+  qdisc->SetMaxSize (QueueSize ("6p"));
+  qdisc->Initialize ();
+  Ipv4Header header;
+  Ptr<Packet> p = CreateSuperSegment (4, header);
+  NS_TEST_EXPECT_MSG_EQ (qdisc->Enqueue (Create<Ipv4QueueDiscItem> (p, Address (), 0x0800, header)), true,
+                         "The first super-segment must fit");
+  p = CreateSuperSegment (3, header);
+  NS_TEST_EXPECT_MSG_EQ (qdisc->Enqueue (Create<Ipv4QueueDiscItem> (p, Address (), 0x0800, header)), true,
+                         "The segments of the second super-segment which fit must be enqueued");
+  NS_TEST_EXPECT_MSG_EQ (qdisc->GetNPackets (), 6, "The queue disc must be full");
+  NS_TEST_EXPECT_MSG_EQ (qdisc->GetNInternalQueues (), 1, "The queue disc must have one internal queue");
+  NS_TEST_EXPECT_MSG_EQ (qdisc->GetInternalQueue (0)->GetCurrentSize ().GetValue (), 6,
+                         "The segments must be enqueued separately");
+  NS_TEST_EXPECT_MSG_EQ (qdisc->GetStats ().nTotalDroppedPackets, 1, "Only one segment must be dropped");
+  qdisc->Dispose ();
+
+  // The first super-segment sent is transmitted at once, the next ones are
+  // queued
+  Ptr<PointToPointNetDevice> device = DynamicCast<PointToPointNetDevice> (devices.Get (0));
+  Ptr<Queue<Packet> > queue = device->GetQueue ();
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      p = CreateSuperSegment (4, header);
+      p->AddHeader (header);
+      device->Send (p, device->GetBroadcast (), 0x0800);
+    }
+  p = CreateSuperSegment (3, header);
+  p->AddHeader (header);
+  NS_TEST_EXPECT_MSG_EQ (device->Send (p, device->GetBroadcast (), 0x0800), true,
+                         "The segments of the last super-segment which fit must be enqueued");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 6, "The device queue must be full");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetTotalDroppedPackets (), 1, "Only one segment must be dropped");
+
+  Simulator::Destroy ();
+}
+
+class Ns3TcpGsoTestSuite : public TestSuite
+{
+public:
+  Ns3TcpGsoTestSuite ();
+};
+
+Ns3TcpGsoTestSuite::Ns3TcpGsoTestSuite ()
+  : TestSuite ("ns3-tcp-gso", SYSTEM)
+{
+  AddTestCase (new Ns3TcpGsoTestCase (0, false), TestCase::QUICK);
+  AddTestCase (new Ns3TcpGsoTestCase (0.01, false), TestCase::QUICK);
+  AddTestCase (new Ns3TcpGsoTestCase (0, true), TestCase::QUICK);
+  AddTestCase (new Ns3TcpGsoSegmentTestCase (), TestCase::QUICK);
+  AddTestCase (new Ns3TcpGsoAdmissionTestCase (), TestCase::QUICK);
+}
+
+static Ns3TcpGsoTestSuite ns3TcpGsoTestSuite;
@@ -92,6 +92,8 @@ FqCoDelFlow::GetStatus (void) const
 
 NS_OBJECT_ENSURE_REGISTERED (FqCoDelQueueDisc);
 
+const uint32_t FqCoDelQueueDisc::NO_FLOW;
+
 TypeId FqCoDelQueueDisc::GetTypeId (void)
 {
   static TypeId tid = TypeId ("ns3::FqCoDelQueueDisc")
@@ -177,8 +179,13 @@ FqCoDelQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
 
   uint32_t h = ret % m_flows;
 
+  if (m_flowsIndices.size () != m_flows)
+    {
+      m_flowsIndices.assign (m_flows, NO_FLOW);
+    }
+
   Ptr<FqCoDelFlow> flow;
-  if (m_flowsIndices.find (h) == m_flowsIndices.end ())
+  if (m_flowsIndices[h] == NO_FLOW)
     {
       NS_LOG_DEBUG ("Creating a new flow queue with index " << h);
       flow = m_flowFactory.Create<FqCoDelFlow> ();
@@ -25,7 +25,7 @@
 #include "ns3/queue-disc.h"
 #include "ns3/object-factory.h"
 #include <list>
-#include <map>
+#include <vector>
 
 namespace ns3 {
 
@@ -170,7 +170,9 @@ private:
   std::list<Ptr<FqCoDelFlow> > m_newFlows;    //!< The list of new flows
   std::list<Ptr<FqCoDelFlow> > m_oldFlows;    //!< The list of old flows
 
-  std::map<uint32_t, uint32_t> m_flowsIndices;    //!< Map with the index of class for each flow
+  std::vector<uint32_t> m_flowsIndices;    //!< Index of the class of each flow queue (or NO_FLOW)
+
+  static const uint32_t NO_FLOW = 0xffffffff;  //!< No class created yet for a flow queue
 
   ObjectFactory m_flowFactory;         //!< Factory to create a new flow
   ObjectFactory m_queueDiscFactory;    //!< Factory to create a new queue
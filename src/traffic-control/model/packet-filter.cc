@@ -61,4 +61,10 @@ PacketFilter::Classify (Ptr<QueueDiscItem> item) const
   return DoClassify (item);
 }
 
+bool
+PacketFilter::IsFlowBased (void) const
+{
+  return false;
+}
+
 } // namespace ns3
@@ -58,6 +58,19 @@ public:
    */
   int32_t Classify (Ptr<QueueDiscItem> item) const;
 
+  /**
+   * \brief Check whether the result of Classify only depends on the flow
+   *        an item belongs to.
+   *
+   * Queue discs whose filters are all flow based cache the classification
+   * results, keyed on the flow hash of the packets (see
+   * QueueDiscItem::GetFlowHash).
+   *
+   * \return true if all the items with the same flow hash are classified
+   * in the same way, false otherwise.
+   */
+  virtual bool IsFlowBased (void) const;
+
 private:
   /**
    * \brief Checks if the filter is able to classify a kind of items.
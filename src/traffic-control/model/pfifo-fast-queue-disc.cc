@@ -75,7 +75,7 @@ PfifoFastQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
 {
   NS_LOG_FUNCTION (this << item);
 
-  if (GetCurrentSize () >= GetMaxSize ())
+  if (GetCurrentSize () + item > GetMaxSize ())
     {
       NS_LOG_LOGIC ("Queue disc limit exceeded -- dropping packet");
       DropBeforeEnqueue (item, LIMIT_EXCEEDED_DROP);
@@ -29,6 +29,8 @@
 #include "queue-disc.h"
 #include <ns3/drop-tail-queue.h>
 #include "ns3/net-device-queue-interface.h"
+#include "ns3/gso-tag.h"
+#include <algorithm>
 
 namespace ns3 {
 
@@ -273,6 +275,21 @@ TypeId QueueDisc::GetTypeId (void)
                    MakeUintegerAccessor (&QueueDisc::SetQuota,
                                          &QueueDisc::GetQuota),
                    MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("MaxBatchSize",
+                   "The maximum number of packets handed to the device in a single "
+                   "transmit call. Values greater than 1 enable bulk dequeue on "
+                   "single-queue devices (see NetDevice::SendBatch).",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&QueueDisc::m_maxBatchSize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("ClassifierCacheSize",
+                   "The number of entries (rounded up to a power of two) of the cache "
+                   "of classification results, keyed on the flow hash of packets. The "
+                   "cache is only used if all the packet filters are flow based. "
+                   "Zero disables the cache.",
+                   UintegerValue (256),
+                   MakeUintegerAccessor (&QueueDisc::m_classifierCacheSize),
+                   MakeUintegerChecker<uint32_t> ())
     .AddAttribute ("InternalQueueList", "The list of internal queues.",
                    ObjectVectorValue (),
                    MakeObjectVectorAccessor (&QueueDisc::m_queues),
@@ -323,7 +340,8 @@ TypeId QueueDisc::GetTypeId (void)
 }
 
 QueueDisc::QueueDisc (QueueDiscSizePolicy policy)
-  :  m_nPackets (0),
+  :  m_flowBasedFilters (true),
+     m_nPackets (0),
      m_nBytes (0),
      m_sojourn (0),
      m_maxSize (QueueSize ("1p")),         // to avoid that setting the mode at construction time is ignored
@@ -383,10 +401,12 @@ QueueDisc::DoDispose (void)
   NS_LOG_FUNCTION (this);
   m_queues.clear ();
   m_filters.clear ();
+  m_classifierCache.clear ();
   m_classes.clear ();
   m_device = 0;
   m_devQueueIface = 0;
-  m_requeued = 0;
+  m_requeued.clear ();
+  m_batch.clear ();
   Object::DoDispose ();
 }
 
@@ -407,6 +427,16 @@ QueueDisc::DoInitialize (void)
   NS_UNUSED (ok); // suppress compiler warning
   InitializeParams ();
 
+  if (m_classifierCacheSize > 0)
+    {
+      uint32_t size = 1;
+      while (size < m_classifierCacheSize && size < (1u << 31))
+        {
+          size <<= 1;
+        }
+      m_classifierCache.assign (size, std::make_pair (0u, 0));
+    }
+
   // Check the configuration and initialize the parameters of the child queue discs
   for (std::vector<Ptr<QueueDiscClass> >::iterator cl = m_classes.begin ();
        cl != m_classes.end (); cl++)
@@ -428,9 +458,17 @@ QueueDisc::GetStats (void)
   // the total number of sent packets is only updated here to avoid to increase it
   // after a dequeue and then having to decrease it if the packet is dropped after
   // dequeue or requeued
-  m_stats.nTotalSentPackets = m_stats.nTotalDequeuedPackets - (m_requeued ? 1 : 0)
+  uint64_t requeuedBytes = 0;
+  uint32_t requeuedPackets = 0;
+  for (std::deque<Ptr<QueueDiscItem> >::const_iterator it = m_requeued.begin ();
+       it != m_requeued.end (); it++)
+    {
+      requeuedBytes += (*it)->GetSize ();
+      requeuedPackets += GetNWirePackets (*it);
+    }
+  m_stats.nTotalSentPackets = m_stats.nTotalDequeuedPackets - requeuedPackets
                               - m_stats.nTotalDroppedPacketsAfterDequeue;
-  m_stats.nTotalSentBytes = m_stats.nTotalDequeuedBytes - (m_requeued ? m_requeued->GetSize () : 0)
+  m_stats.nTotalSentBytes = m_stats.nTotalDequeuedBytes - requeuedBytes
                             - m_stats.nTotalDroppedBytesAfterDequeue;
 
   return m_stats;
@@ -601,6 +639,9 @@ QueueDisc::AddPacketFilter (Ptr<PacketFilter> filter)
 {
   NS_LOG_FUNCTION (this);
   m_filters.push_back (filter);
+  m_flowBasedFilters = m_flowBasedFilters && filter->IsFlowBased ();
+  // previously cached results may no longer be valid
+  std::fill (m_classifierCache.begin (), m_classifierCache.end (), std::make_pair (0u, 0));
 }
 
 Ptr<PacketFilter>
@@ -659,12 +700,32 @@ QueueDisc::Classify (Ptr<QueueDiscItem> item)
 {
   NS_LOG_FUNCTION (this << item);
 
+  std::pair<uint32_t, int32_t> *entry = 0;
+  if (m_flowBasedFilters && !m_classifierCache.empty () && !m_filters.empty ())
+    {
+      // a flow hash equal to 0 means that the flow is not known
+      uint32_t hash = item->GetFlowHash ();
+      if (hash != 0)
+        {
+          entry = &m_classifierCache[hash & (m_classifierCache.size () - 1)];
+          if (entry->first == hash)
+            {
+              return entry->second;
+            }
+          entry->first = hash;
+        }
+    }
+
   int32_t ret = PacketFilter::PF_NO_MATCH;
   for (std::vector<Ptr<PacketFilter> >::iterator f = m_filters.begin ();
        f != m_filters.end () && ret == PacketFilter::PF_NO_MATCH; f++)
     {
       ret = (*f)->Classify (item);
     }
+  if (entry)
+    {
+      entry->second = ret;
+    }
   return ret;
 }
 
@@ -677,9 +738,10 @@ QueueDisc::GetWakeMode (void) const
 void
 QueueDisc::PacketEnqueued (Ptr<const QueueDiscItem> item)
 {
-  m_nPackets++;
+  uint32_t nPackets = GetNWirePackets (item);
+  m_nPackets += nPackets;
   m_nBytes += item->GetSize ();
-  m_stats.nTotalEnqueuedPackets++;
+  m_stats.nTotalEnqueuedPackets += nPackets;
   m_stats.nTotalEnqueuedBytes += item->GetSize ();
 
   NS_LOG_LOGIC ("m_traceEnqueue (p)");
@@ -689,9 +751,10 @@ QueueDisc::PacketEnqueued (Ptr<const QueueDiscItem> item)
 void
 QueueDisc::PacketDequeued (Ptr<const QueueDiscItem> item)
 {
-  m_nPackets--;
+  uint32_t nPackets = GetNWirePackets (item);
+  m_nPackets -= nPackets;
   m_nBytes -= item->GetSize ();
-  m_stats.nTotalDequeuedPackets++;
+  m_stats.nTotalDequeuedPackets += nPackets;
   m_stats.nTotalDequeuedBytes += item->GetSize ();
 
   m_sojourn = Simulator::Now () - item->GetTimeStamp ();
@@ -705,20 +768,21 @@ QueueDisc::DropBeforeEnqueue (Ptr<const QueueDiscItem> item, const char* reason)
 {
   NS_LOG_FUNCTION (this << item << reason);
 
-  m_stats.nTotalDroppedPackets++;
+  uint32_t nPackets = GetNWirePackets (item);
+  m_stats.nTotalDroppedPackets += nPackets;
   m_stats.nTotalDroppedBytes += item->GetSize ();
-  m_stats.nTotalDroppedPacketsBeforeEnqueue++;
+  m_stats.nTotalDroppedPacketsBeforeEnqueue += nPackets;
   m_stats.nTotalDroppedBytesBeforeEnqueue += item->GetSize ();
 
   // update the number of packets dropped for the given reason
   std::map<std::string, uint32_t>::iterator itp = m_stats.nDroppedPacketsBeforeEnqueue.find (reason);
   if (itp != m_stats.nDroppedPacketsBeforeEnqueue.end ())
     {
-      itp->second++;
+      itp->second += nPackets;
     }
   else
     {
-      m_stats.nDroppedPacketsBeforeEnqueue[reason] = 1;
+      m_stats.nDroppedPacketsBeforeEnqueue[reason] = nPackets;
     }
   // update the amount of bytes dropped for the given reason
   std::map<std::string, uint64_t>::iterator itb = m_stats.nDroppedBytesBeforeEnqueue.find (reason);
@@ -744,20 +808,21 @@ QueueDisc::DropAfterDequeue (Ptr<const QueueDiscItem> item, const char* reason)
 {
   NS_LOG_FUNCTION (this << item << reason);
 
-  m_stats.nTotalDroppedPackets++;
+  uint32_t nPackets = GetNWirePackets (item);
+  m_stats.nTotalDroppedPackets += nPackets;
   m_stats.nTotalDroppedBytes += item->GetSize ();
-  m_stats.nTotalDroppedPacketsAfterDequeue++;
+  m_stats.nTotalDroppedPacketsAfterDequeue += nPackets;
   m_stats.nTotalDroppedBytesAfterDequeue += item->GetSize ();
 
   // update the number of packets dropped for the given reason
   std::map<std::string, uint32_t>::iterator itp = m_stats.nDroppedPacketsAfterDequeue.find (reason);
   if (itp != m_stats.nDroppedPacketsAfterDequeue.end ())
     {
-      itp->second++;
+      itp->second += nPackets;
     }
   else
     {
-      m_stats.nDroppedPacketsAfterDequeue[reason] = 1;
+      m_stats.nDroppedPacketsAfterDequeue[reason] = nPackets;
     }
   // update the amount of bytes dropped for the given reason
   std::map<std::string, uint64_t>::iterator itb = m_stats.nDroppedBytesAfterDequeue.find (reason);
@@ -790,18 +855,19 @@ QueueDisc::Mark (Ptr<QueueDiscItem> item, const char* reason)
       return false;
     }
 
-  m_stats.nTotalMarkedPackets++;
+  uint32_t nPackets = GetNWirePackets (item);
+  m_stats.nTotalMarkedPackets += nPackets;
   m_stats.nTotalMarkedBytes += item->GetSize ();
 
   // update the number of packets marked for the given reason
   std::map<std::string, uint32_t>::iterator itp = m_stats.nMarkedPackets.find (reason);
   if (itp != m_stats.nMarkedPackets.end ())
     {
-      itp->second++;
+      itp->second += nPackets;
     }
   else
     {
-      m_stats.nMarkedPackets[reason] = 1;
+      m_stats.nMarkedPackets[reason] = nPackets;
     }
   // update the amount of bytes marked for the given reason
   std::map<std::string, uint64_t>::iterator itb = m_stats.nMarkedBytes.find (reason);
@@ -826,7 +892,26 @@ QueueDisc::Enqueue (Ptr<QueueDiscItem> item)
 {
   NS_LOG_FUNCTION (this << item);
 
-  m_stats.nTotalReceivedPackets++;
+  GsoTag gso;
+  if (m_sizePolicy != QueueDiscSizePolicy::NO_LIMITS && item->GetPacket ()->PeekPacketTag (gso)
+      && GetCurrentSize () + item > GetMaxSize ())
+    {
+      // The super-segment does not fit whole: enqueue its segments, so that
+      // only those which do not fit are dropped
+      std::list<Ptr<QueueDiscItem> > segments = item->SegmentGso ();
+      if (!segments.empty ())
+        {
+          NS_LOG_LOGIC ("Enqueuing the " << segments.size () << " segments of a super-segment");
+          bool retval = false;
+          for (std::list<Ptr<QueueDiscItem> >::iterator it = segments.begin (); it != segments.end (); ++it)
+            {
+              retval = Enqueue (*it) || retval;
+            }
+          return retval;
+        }
+    }
+
+  m_stats.nTotalReceivedPackets += GetNWirePackets (item);
   m_stats.nTotalReceivedBytes += item->GetSize ();
 
   bool retval = DoEnqueue (item);
@@ -881,11 +966,16 @@ QueueDisc::PeekDequeued (void)
 {
   NS_LOG_FUNCTION (this);
 
-  if (!m_requeued)
+  if (m_requeued.empty ())
     {
-      m_requeued = Dequeue ();
+      Ptr<QueueDiscItem> item = Dequeue ();
+      if (!item)
+        {
+          return 0;
+        }
+      m_requeued.push_back (item);
     }
-  return m_requeued;
+  return m_requeued.front ();
 }
 
 Ptr<QueueDiscItem>
@@ -893,11 +983,12 @@ QueueDisc::DequeuePeeked (void)
 {
   NS_LOG_FUNCTION (this);
 
-  Ptr<QueueDiscItem> item = m_requeued;
+  Ptr<QueueDiscItem> item;
 
-  if (item)
+  if (!m_requeued.empty ())
     {
-      m_requeued = 0;
+      item = m_requeued.front ();
+      m_requeued.pop_front ();
     }
   else
     {
@@ -915,6 +1006,14 @@ QueueDisc::Run (void)
   if (RunBegin ())
     {
       uint32_t quota = m_quota;
+      if (m_maxBatchSize > 1 && m_devQueueIface->GetNTxQueues () == 1)
+        {
+          while (quota > 0 && BulkRestart (quota))
+            {
+            }
+          RunEnd ();
+          return;
+        }
       while (Restart ())
         {
           quota -= 1;
@@ -962,6 +1061,61 @@ QueueDisc::Restart (void)
   return Transmit (item);
 }
 
+bool
+QueueDisc::BulkRestart (uint32_t &quota)
+{
+  NS_LOG_FUNCTION (this << quota);
+  NS_ASSERT (m_batch.empty ());
+
+  // do not dequeue more packets than the device can take before stopping
+  // its queue, so that bulk dequeues do not end up in requeues
+  uint32_t limit = std::min (std::min (m_maxBatchSize, quota),
+                             std::max (m_devQueueIface->GetTxQueue (0)->GetRoom (), 1u));
+  Ptr<QueueDiscItem> item;
+  while (m_batch.size () < limit && (item = DequeuePacket ()) != 0)
+    {
+      m_batch.push_back (item);
+    }
+  if (m_batch.empty ())
+    {
+      NS_LOG_LOGIC ("No packet to send");
+      return false;
+    }
+
+  // a single queue device makes no use of the priority tag
+  SocketPriorityTag priorityTag;
+  for (std::vector<Ptr<QueueDiscItem> >::iterator it = m_batch.begin (); it != m_batch.end (); it++)
+    {
+      (*it)->GetPacket ()->RemovePacketTag (priorityTag);
+    }
+
+  // as in Transmit, the packets consumed by the device are never requeued,
+  // whatever happens to them in the device. The device stops consuming
+  // packets when its transmission queue is stopped: the remaining ones are
+  // requeued ahead of any packet still held from a previous run
+  uint32_t sent = m_device->SendBatch (m_batch);
+  NS_ASSERT (sent <= m_batch.size ());
+  if (sent < m_batch.size ())
+    {
+      std::deque<Ptr<QueueDiscItem> > held;
+      held.swap (m_requeued);
+      for (uint32_t i = sent; i < m_batch.size (); i++)
+        {
+          Requeue (m_batch[i]);
+        }
+      m_requeued.insert (m_requeued.end (), held.begin (), held.end ());
+    }
+  m_batch.clear ();
+  quota -= std::min (sent, quota);
+
+  if (sent == 0 || (GetNPackets () == 0 && m_requeued.empty ())
+      || m_devQueueIface->GetTxQueue (0)->IsStopped ())
+    {
+      return false;
+    }
+  return true;
+}
+
 Ptr<QueueDiscItem>
 QueueDisc::DequeuePacket ()
 {
@@ -970,15 +1124,15 @@ QueueDisc::DequeuePacket ()
   Ptr<QueueDiscItem> item;
 
   // First check if there is a requeued packet
-  if (m_requeued != 0)
+  if (!m_requeued.empty ())
     {
         // If the queue where the requeued packet is destined to is not stopped, return
         // the requeued packet; otherwise, return an empty packet.
         // If the device does not support flow control, the device queue is never stopped
-        if (!m_devQueueIface->GetTxQueue (m_requeued->GetTxQueueIndex ())->IsStopped ())
+        if (!m_devQueueIface->GetTxQueue (m_requeued.front ()->GetTxQueueIndex ())->IsStopped ())
           {
-            item = m_requeued;
-            m_requeued = 0;
+            item = m_requeued.front ();
+            m_requeued.pop_front ();
           }
     }
   else
@@ -1006,10 +1160,10 @@ void
 QueueDisc::Requeue (Ptr<QueueDiscItem> item)
 {
   NS_LOG_FUNCTION (this << item);
-  m_requeued = item;
+  m_requeued.push_back (item);
   /// \todo netif_schedule (q);
 
-  m_stats.nTotalRequeuedPackets++;
+  m_stats.nTotalRequeuedPackets += GetNWirePackets (item);
   m_stats.nTotalRequeuedBytes += item->GetSize ();
 
   NS_LOG_LOGIC ("m_traceRequeue (p)");
@@ -26,6 +26,7 @@
 #include "ns3/queue-item.h"
 #include "ns3/queue-size.h"
 #include <vector>
+#include <deque>
 #include <map>
 #include <functional>
 #include <string>
@@ -160,7 +161,11 @@ enum QueueDiscSizePolicy
  * - dropped = dropped before enqueue + dropped after dequeue
  * - received = dropped before enqueue + enqueued
  * - queued = enqueued - dequeued
- * - sent = dequeued - dropped after dequeue (- 1 if there is a requeued packet)
+ * - sent = dequeued - dropped after dequeue - requeued packets still held
+ *
+ * Like the packet limits, packet counters are in packets on the wire: a
+ * super-segment (see GsoTag) counts as its number of segments, as Linux
+ * does for the qdisc statistics.
  *
  * Separate counters are also kept for each possible reason to drop a packet.
  * When a packet is dropped by an internal queue, e.g., because the queue is full,
@@ -365,6 +370,11 @@ public:
    * Pass a packet to store to the queue discipline. This function only updates
    * the statistics and calls the (private) DoEnqueue function, which must be
    * implemented by derived classes.
+   *
+   * A super-segment (see GsoTag) which would exceed the maximum size of the
+   * queue disc is enqueued as its segments (see QueueDiscItem::SegmentGso),
+   * so that only the segments which do not fit are dropped.
+   *
    * \param item item to enqueue
    * \return True if the operation was successful; false otherwise
    */
@@ -397,7 +407,9 @@ public:
   /**
    * Modelled after the Linux function __qdisc_run (net/sched/sch_generic.c)
    * Dequeues multiple packets, until a quota is exceeded or sending a packet
-   * to the device failed.
+   * to the device failed. If MaxBatchSize is greater than 1 and the device
+   * has a single transmission queue, packets are handed to the device in
+   * bursts (see BulkRestart).
    */
   void Run (void);
 
@@ -464,7 +476,9 @@ public:
   /**
    * Classify a packet by calling the packet filters, one at a time, until either
    * a filter able to classify the packet is found or all the filters have been
-   * processed.
+   * processed. If all the filters are flow based (see PacketFilter::IsFlowBased),
+   * the result is cached, keyed on the flow hash of the packet, so that the
+   * filters are only run for the first packets of each flow.
    * \param item item to classify
    * \return -1 if no filter able to classify the packet has been found, the value
    * returned by first filter found to be able to classify the packet otherwise.
@@ -627,6 +641,17 @@ private:
    */
   bool Restart (void);
 
+  /**
+   * Bulk variant of Restart, modelled after the bulk dequeue of the Linux
+   * function dequeue_skb (net/sched/sch_generic.c).  Dequeue up to
+   * MaxBatchSize packets (and no more than the remaining quota) and send
+   * them to the device with a single call to NetDevice::SendBatch.  The
+   * packets the device does not accept are requeued.
+   * \param quota the remaining quota, decreased by the number of packets sent
+   * \return true if packets were sent and more can be sent.
+   */
+  bool BulkRestart (uint32_t &quota);
+
   /**
    * Modelled after the Linux function dequeue_skb (net/sched/sch_generic.c)
    * \return the requeued packet, if any, or the packet dequeued by the queue disc, otherwise.
@@ -667,6 +692,10 @@ private:
 
   std::vector<Ptr<InternalQueue> > m_queues;    //!< Internal queues
   std::vector<Ptr<PacketFilter> > m_filters;    //!< Packet filters
+  bool m_flowBasedFilters;                      //!< True if all the packet filters are flow based
+  uint32_t m_classifierCacheSize;               //!< Requested number of classifier cache entries
+  /// Classifier cache entries: flow hash and classification result
+  std::vector<std::pair<uint32_t, int32_t> > m_classifierCache;
   std::vector<Ptr<QueueDiscClass> > m_classes;  //!< Classes
 
   TracedValue<uint32_t> m_nPackets; //!< Number of packets in the queue
@@ -676,10 +705,12 @@ private:
 
   Stats m_stats;                    //!< The collected statistics
   uint32_t m_quota;                 //!< Maximum number of packets dequeued in a qdisc run
+  uint32_t m_maxBatchSize;          //!< Maximum number of packets sent to the device in a single call
+  std::vector<Ptr<QueueDiscItem> > m_batch;  //!< Packets being sent to the device
   Ptr<NetDevice> m_device;          //!< The NetDevice on which this queue discipline is installed
   Ptr<NetDeviceQueueInterface> m_devQueueIface;   //!< NetDevice queue interface
   bool m_running;                   //!< The queue disc is performing multiple dequeue operations
-  Ptr<QueueDiscItem> m_requeued;    //!< The last packet that failed to be transmitted
+  std::deque<Ptr<QueueDiscItem> > m_requeued;  //!< The packets that failed to be transmitted
   std::string m_childQueueDiscDropMsg;  //!< Reason why a packet was dropped by a child queue disc
   QueueDiscSizePolicy m_sizePolicy;     //!< The queue disc size policy
   bool m_prohibitChangeMode;            //!< True if changing mode is prohibited
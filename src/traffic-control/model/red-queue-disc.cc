@@ -392,6 +392,8 @@ RedQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
   NS_LOG_FUNCTION (this << item);
 
   uint32_t nQueued = GetInternalQueue (0)->GetCurrentSize ().GetValue ();
+  // A super-segment (see GsoTag) arrives as its number of segments
+  uint32_t nPackets = GetNWirePackets (item);
 
   // simulate number of packets arrival during idle period
   uint32_t m = 0;
@@ -414,12 +416,12 @@ RedQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
       m_idle = 0;
     }
 
-  m_qAvg = Estimator (nQueued, m + 1, m_qAvg, m_qW);
+  m_qAvg = Estimator (nQueued, m + nPackets, m_qAvg, m_qW);
 
   NS_LOG_DEBUG ("\t bytesInQueue  " << GetInternalQueue (0)->GetNBytes () << "\tQavg " << m_qAvg);
   NS_LOG_DEBUG ("\t packetsInQueue  " << GetInternalQueue (0)->GetNPackets () << "\tQavg " << m_qAvg);
 
-  m_count++;
+  m_count += nPackets;
   m_countBytes += item->GetSize ();
 
   uint32_t dropType = DTYPE_NONE;
@@ -439,7 +441,7 @@ RedQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
            * from above m_minTh with an empty queue to
            * above m_minTh with a nonempty queue.
            */
-          m_count = 1;
+          m_count = nPackets;
           m_countBytes = item->GetSize ();
           m_old = 1;
         }
@@ -706,6 +708,13 @@ RedQueueDisc::DropEarly (Ptr<QueueDiscItem> item, uint32_t qSize)
   double prob1 = CalculatePNew ();
   m_vProb = ModifyP (prob1, item->GetSize ());
 
+  uint32_t nPackets = GetNWirePackets (item);
+  if (GetMode () == QUEUE_DISC_MODE_PACKETS && nPackets > 1)
+    {
+      // A super-segment is dropped if any of its segments would have been
+      m_vProb = 1.0 - std::pow (1.0 - m_vProb, static_cast<double> (nPackets));
+    }
+
   // Drop probability is computed, pick random number and act
   if (m_cautious == 1)
     {
@@ -374,6 +374,149 @@ TcFlowControlTestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Traffic Control Bulk Transmit Test Case
+ *
+ * Packets accumulate in the queue disc while the device queue is stopped.
+ * When the device queue is woken up, the queue disc hands them to the
+ * device in bursts of at most MaxBatchSize packets, which must neither
+ * overflow the device queue nor cause requeues, and must not change the
+ * order in which packets are transmitted.
+ */
+class TcBulkTransmitTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor
+   *
+   * \param batchSize the maximum number of packets per transmit call
+   */
+  TcBulkTransmitTestCase (uint32_t batchSize);
+  virtual ~TcBulkTransmitTestCase ();
+private:
+  virtual void DoRun (void);
+  /**
+   * Send packets to the traffic control layer
+   * \param n the node
+   * \param nPackets the number of packets to send
+   */
+  void SendPackets (Ptr<Node> n, uint16_t nPackets);
+  /**
+   * Check the state of the device queue and of the queue disc
+   * \param dev the device
+   * \param inDevice the expected number of packets in the device queue
+   * \param inQueueDisc the expected number of packets in the queue disc
+   */
+  void CheckState (Ptr<NetDevice> dev, uint16_t inDevice, uint16_t inQueueDisc);
+  /**
+   * Receive callback of the receiving device
+   * \param dev the device
+   * \param p the received packet
+   * \param protocol the protocol number
+   * \param from the sender address
+   * \return true
+   */
+  bool Receive (Ptr<NetDevice> dev, Ptr<const Packet> p, uint16_t protocol, const Address &from);
+  uint32_t m_batchSize;             //!< Maximum number of packets per transmit call
+  std::vector<uint64_t> m_sent;     //!< UIDs of the sent packets
+  std::vector<uint64_t> m_received; //!< UIDs of the received packets
+};
+
+TcBulkTransmitTestCase::TcBulkTransmitTestCase (uint32_t batchSize)
+  : TestCase ("Test the bulk transmission of packets to the device"),
+    m_batchSize (batchSize)
+{
+}
+
+TcBulkTransmitTestCase::~TcBulkTransmitTestCase ()
+{
+}
+
+void
+TcBulkTransmitTestCase::SendPackets (Ptr<Node> n, uint16_t nPackets)
+{
+  Ptr<TrafficControlLayer> tc = n->GetObject<TrafficControlLayer> ();
+  for (uint16_t i = 0; i < nPackets; i++)
+    {
+      Ptr<Packet> p = Create<Packet> (1000);
+      m_sent.push_back (p->GetUid ());
+      tc->Send (n->GetDevice (0), Create<QueueDiscTestItem> (p));
+    }
+}
+
+void
+TcBulkTransmitTestCase::CheckState (Ptr<NetDevice> dev, uint16_t inDevice, uint16_t inQueueDisc)
+{
+  PointerValue ptr;
+  dev->GetAttributeFailSafe ("TxQueue", ptr);
+  Ptr<Queue<Packet> > queue = ptr.Get<Queue<Packet> > ();
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), inDevice, "Unexpected number of packets in the device queue");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetTotalDroppedPackets (), 0, "No packet must be dropped by the device queue");
+
+  Ptr<QueueDisc> qdisc = dev->GetNode ()->GetObject<TrafficControlLayer> ()->GetRootQueueDiscOnDevice (dev);
+  NS_TEST_EXPECT_MSG_EQ (qdisc->GetNPackets (), inQueueDisc, "Unexpected number of packets in the queue disc");
+  NS_TEST_EXPECT_MSG_EQ (qdisc->GetStats ().nTotalRequeuedPackets, 0, "No packet must be requeued");
+}
+
+bool
+TcBulkTransmitTestCase::Receive (Ptr<NetDevice> dev, Ptr<const Packet> p, uint16_t protocol, const Address &from)
+{
+  m_received.push_back (p->GetUid ());
+  return true;
+}
+
+void
+TcBulkTransmitTestCase::DoRun (void)
+{
+  NodeContainer n;
+  n.Create (2);
+
+  n.Get (0)->AggregateObject (CreateObject<TrafficControlLayer> ());
+  n.Get (1)->AggregateObject (CreateObject<TrafficControlLayer> ());
+
+  Ptr<Queue<Packet> > queue = CreateObjectWithAttributes<DropTailQueue<Packet> > ("MaxSize", StringValue ("5p"));
+
+  Ptr<SimpleNetDevice> txDev, rxDev;
+  txDev = CreateObjectWithAttributes<SimpleNetDevice> ("TxQueue", PointerValue (queue),
+                                                       "DataRate", DataRateValue (DataRate ("1Mb/s")));
+  rxDev = CreateObject<SimpleNetDevice> ();
+  n.Get (0)->AddDevice (txDev);
+  n.Get (1)->AddDevice (rxDev);
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  txDev->SetChannel (channel);
+  rxDev->SetChannel (channel);
+  rxDev->SetReceiveCallback (MakeCallback (&TcBulkTransmitTestCase::Receive, this));
+
+  txDev->SetMtu (2500);
+
+  TrafficControlHelper tch = TrafficControlHelper::Default ();
+  QueueDiscContainer qdiscs = tch.Install (txDev);
+  qdiscs.Get (0)->SetAttribute ("MaxBatchSize", UintegerValue (m_batchSize));
+
+  // stop the device queue and let 10 packets accumulate in the queue disc
+  Ptr<NetDeviceQueue> txq = txDev->GetObject<NetDeviceQueueInterface> ()->GetTxQueue (0);
+  Simulator::Schedule (Seconds (0), &NetDeviceQueue::Stop, txq);
+  Simulator::Schedule (Seconds (0), &TcBulkTransmitTestCase::SendPackets, this, n.Get (0), 10);
+  Simulator::Schedule (MilliSeconds (1), &TcBulkTransmitTestCase::CheckState, this, txDev, 0, 10);
+
+  // once woken up, the device takes one packet in transmission and five in
+  // its queue, whatever the size of the bursts
+  Simulator::Schedule (MilliSeconds (2), &NetDeviceQueue::Wake, txq);
+  Simulator::Schedule (MilliSeconds (3), &TcBulkTransmitTestCase::CheckState, this, txDev, 5, 4);
+
+  // The transmission of each packet takes 1000B/1Mbps = 8ms
+  Simulator::Schedule (MilliSeconds (100), &TcBulkTransmitTestCase::CheckState, this, txDev, 0, 0);
+
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_received.size (), 10, "All the packets must be received");
+  NS_TEST_EXPECT_MSG_EQ ((m_received == m_sent), true, "Packets must be received in order");
+}
+
 /**
  * \ingroup traffic-control-test
  * \ingroup tests
@@ -388,5 +531,7 @@ public:
   {
     AddTestCase (new TcFlowControlTestCase (QueueSizeUnit::PACKETS), TestCase::QUICK);
     AddTestCase (new TcFlowControlTestCase (QueueSizeUnit::BYTES), TestCase::QUICK);
+    AddTestCase (new TcBulkTransmitTestCase (1), TestCase::QUICK);
+    AddTestCase (new TcBulkTransmitTestCase (4), TestCase::QUICK);
   }
 } g_tcFlowControlTestSuite; ///< the test suite
@@ -0,0 +1,157 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// This program benchmarks the cost of a FlowMonitor: UDP packets of many
+// flows are sent along a chain of routers joined by point-to-point links,
+// with or without a monitor on all the nodes, and the program prints the
+// wall-clock time per packet and the packets counted by the monitor, which
+// must not depend on its sampling.
+// Sample usage:  ./waf --run 'bench-flow-monitor --flows=1000 --packets=200000 --sampling=Packets --rate=100'
+
+#include "ns3/command-line.h"
+#include "ns3/config.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/simulator.h"
+#include "ns3/node-container.h"
+#include "ns3/packet.h"
+#include "ns3/socket.h"
+#include "ns3/udp-socket-factory.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-global-routing-helper.h"
+#include "ns3/neighbor-cache-helper.h"
+#include "ns3/flow-monitor-helper.h"
+#include "ns3/flow-monitor.h"
+#include "ns3/ipv4.h"
+#include <iostream>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * Receive the packets of a socket
+ * \param socket the socket
+ */
+static void
+Receive (Ptr<Socket> socket)
+{
+  while (socket->Recv ())
+    {
+    }
+}
+
+/**
+ * Send a packet of each flow, in turn
+ * \param sockets the sending sockets, one per flow
+ * \param dest the destination
+ * \param n the number of packets left to send
+ */
+static void
+Send (const std::vector<Ptr<Socket> > *sockets, Ipv4Address dest, uint32_t n)
+{
+  (*sockets)[n % sockets->size ()]->SendTo (Create<Packet> (100), 0, InetSocketAddress (dest, 9));
+  if (n > 1)
+    {
+      Simulator::Schedule (MicroSeconds (1), &Send, sockets, dest, n - 1);
+    }
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t nRouters = 4;
+  uint32_t nFlows = 100;
+  uint32_t nPackets = 100000;
+  bool monitor = true;
+  std::string sampling = "None";
+  uint32_t rate = 100;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark the cost of a FlowMonitor");
+  cmd.AddValue ("routers", "number of routers of the chain", nRouters);
+  cmd.AddValue ("flows", "number of flows", nFlows);
+  cmd.AddValue ("packets", "number of packets sent", nPackets);
+  cmd.AddValue ("monitor", "monitor the flows", monitor);
+  cmd.AddValue ("sampling", "sampling of the delays: None, Packets or Flows", sampling);
+  cmd.AddValue ("rate", "one packet or flow sampled out of rate", rate);
+  cmd.Parse (argc, argv);
+
+  NodeContainer nodes;
+  nodes.Create (nRouters + 2);
+  InternetStackHelper internet;
+  internet.SetIpv6StackInstall (false);
+  internet.Install (nodes);
+  SimpleNetDeviceHelper p2p;
+  p2p.SetNetDevicePointToPointMode (true);
+  Ipv4AddressHelper address ("10.0.0.0", "255.255.255.252");
+  for (uint32_t i = 0; i + 1 < nodes.GetN (); i++)
+    {
+      address.Assign (p2p.Install (NodeContainer (nodes.Get (i), nodes.Get (i + 1))));
+      address.NewNetwork ();
+    }
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+  NeighborCacheHelper::PopulateNeighborCache ();
+
+  Ptr<Node> sink = nodes.Get (nodes.GetN () - 1);
+  Ptr<Socket> sinkSocket = Socket::CreateSocket (sink, UdpSocketFactory::GetTypeId ());
+  sinkSocket->Bind (InetSocketAddress (Ipv4Address::GetAny (), 9));
+  sinkSocket->SetRecvCallback (MakeCallback (&Receive));
+  std::vector<Ptr<Socket> > sockets;
+  for (uint32_t f = 0; f < nFlows; f++)
+    {
+      sockets.push_back (Socket::CreateSocket (nodes.Get (0), UdpSocketFactory::GetTypeId ()));
+    }
+
+  FlowMonitorHelper flowmon;
+  flowmon.SetMonitorAttribute ("SamplingMode", StringValue (sampling));
+  flowmon.SetMonitorAttribute ("SamplingRate", UintegerValue (rate));
+  Ptr<FlowMonitor> flowMonitor;
+  if (monitor)
+    {
+      flowMonitor = flowmon.InstallAll ();
+    }
+  Simulator::Schedule (Seconds (1), &Send, &sockets,
+                       sink->GetObject<Ipv4> ()->GetAddress (1, 0).GetLocal (), nPackets);
+
+  // The monitor checks for lost packets periodically, until stopped
+  Simulator::Stop (Seconds (2) + MicroSeconds (nPackets));
+
+  SystemWallClockMs time;
+  time.Start ();
+  Simulator::Run ();
+  int64_t ms = time.End ();
+  std::cout << nFlows << " flows, monitor " << (monitor ? "on" : "off") << ", sampling " << sampling << ": "
+            << ms * 1e6 / nPackets << " ns/packet (" << ms << " ms elapsed)" << std::endl;
+  if (monitor)
+    {
+      uint64_t txPackets = 0, rxPackets = 0, rxBytes = 0;
+      const FlowMonitor::FlowStatsContainer &stats = flowMonitor->GetFlowStats ();
+      for (FlowMonitor::FlowStatsContainerCI i = stats.begin (); i != stats.end (); i++)
+        {
+          txPackets += i->second.txPackets;
+          rxPackets += i->second.rxPackets;
+          rxBytes += i->second.rxBytes;
+        }
+      std::cout << stats.size () << " flows monitored, " << txPackets << " packets sent, "
+                << rxPackets << " packets received, " << rxBytes << " bytes received" << std::endl;
+    }
+
+  Simulator::Destroy ();
+  return 0;
+}
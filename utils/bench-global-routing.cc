@@ -0,0 +1,178 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// This program benchmarks the computation of the global routes on a grid
+// of routers joined by point-to-point links, and optionally by a LAN per
+// row: the initial computation, then the recomputation after a link goes
+// down and up again.  It prints a digest of all the routing tables, which
+// must not depend on the number of threads nor on incremental SPF.
+// Sample usage:  ./waf --run 'bench-global-routing --rows=30 --cols=30 --threads=4'
+
+#include "ns3/command-line.h"
+#include "ns3/config.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/simulator.h"
+#include "ns3/node-container.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/simple-channel.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-global-routing-helper.h"
+#include "ns3/ipv4-global-routing.h"
+#include "ns3/ipv4-routing-table-entry.h"
+#include "ns3/ipv4.h"
+#include <iostream>
+
+using namespace ns3;
+
+/**
+ * \param nodes the nodes
+ * \param nRoutes set to the number of routes of the nodes
+ * \return a digest of the global routing tables of the nodes, in order
+ */
+static uint64_t
+DigestRoutes (const NodeContainer &nodes, uint64_t &nRoutes)
+{
+  uint64_t digest = 14695981039346656037ull;
+  nRoutes = 0;
+  for (uint32_t n = 0; n < nodes.GetN (); n++)
+    {
+      Ptr<Ipv4GlobalRouting> routing =
+        DynamicCast<Ipv4GlobalRouting> (nodes.Get (n)->GetObject<Ipv4> ()->GetRoutingProtocol ());
+      for (uint32_t i = 0; i < routing->GetNRoutes (); i++)
+        {
+          Ipv4RoutingTableEntry *route = routing->GetRoute (i);
+          uint32_t fields[5] = { n, route->GetDest ().Get (), route->GetDestNetworkMask ().Get (),
+                                 route->GetGateway ().Get (), route->GetInterface () };
+          for (uint32_t f = 0; f < 5; f++)
+            {
+              digest = (digest ^ fields[f]) * 1099511628211ull;
+            }
+        }
+      nRoutes += routing->GetNRoutes ();
+    }
+  return digest;
+}
+
+/**
+ * Print the time taken and the routes computed
+ * \param name the name of the step
+ * \param ms the elapsed time
+ * \param nodes the nodes
+ */
+static void
+Report (const std::string &name, int64_t ms, const NodeContainer &nodes)
+{
+  uint64_t nRoutes;
+  uint64_t digest = DigestRoutes (nodes, nRoutes);
+  std::cout << name << ": " << ms << " ms, " << nRoutes << " routes, digest "
+            << std::hex << digest << std::dec << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t rows = 20;
+  uint32_t cols = 20;
+  bool lans = false;
+  uint32_t threads = 1;
+  bool incremental = false;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark the computation of the global routes on a grid of routers");
+  cmd.AddValue ("rows", "number of rows of the grid", rows);
+  cmd.AddValue ("cols", "number of columns of the grid", cols);
+  cmd.AddValue ("lans", "join the routers of each row by a LAN too", lans);
+  cmd.AddValue ("threads", "number of threads computing the routes", threads);
+  cmd.AddValue ("incremental", "update the SPF trees of the routers rather than calculating them again", incremental);
+  cmd.Parse (argc, argv);
+
+  Config::SetGlobal ("GlobalRoutingThreads", UintegerValue (threads));
+  Config::SetGlobal ("GlobalRoutingIncrementalSpf", BooleanValue (incremental));
+
+  NodeContainer nodes;
+  nodes.Create (rows * cols);
+  InternetStackHelper internet;
+  Ipv4GlobalRoutingHelper globalRouting;
+  internet.SetRoutingHelper (globalRouting);
+  internet.Install (nodes);
+
+  SimpleNetDeviceHelper p2p;
+  p2p.SetNetDevicePointToPointMode (true);
+  Ipv4AddressHelper address ("10.0.0.0", "255.255.255.252");
+  NetDeviceContainer firstLink;
+  for (uint32_t r = 0; r < rows; r++)
+    {
+      for (uint32_t c = 0; c < cols; c++)
+        {
+          uint32_t n = r * cols + c;
+          if (c + 1 < cols)
+            {
+              NetDeviceContainer link = p2p.Install (NodeContainer (nodes.Get (n), nodes.Get (n + 1)));
+              address.Assign (link);
+              address.NewNetwork ();
+              if (firstLink.GetN () == 0)
+                {
+                  firstLink = link;
+                }
+            }
+          if (r + 1 < rows)
+            {
+              address.Assign (p2p.Install (NodeContainer (nodes.Get (n), nodes.Get (n + cols))));
+              address.NewNetwork ();
+            }
+        }
+    }
+  if (lans)
+    {
+      SimpleNetDeviceHelper lan;
+      Ipv4AddressHelper lanAddress ("172.16.0.0", "255.255.255.0");
+      for (uint32_t r = 0; r < rows; r++)
+        {
+          NodeContainer row;
+          for (uint32_t c = 0; c < cols; c++)
+            {
+              row.Add (nodes.Get (r * cols + c));
+            }
+          lanAddress.Assign (lan.Install (row));
+          lanAddress.NewNetwork ();
+        }
+    }
+  std::cout << nodes.GetN () << " routers, " << threads << " threads"
+            << (incremental ? ", incremental SPF" : "") << std::endl;
+
+  SystemWallClockMs time;
+  time.Start ();
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+  Report ("Populate", time.End (), nodes);
+
+  // A link failure and its repair, as seen by a simulation responding to
+  // interface events
+  Ptr<Ipv4> ipv4 = firstLink.Get (0)->GetNode ()->GetObject<Ipv4> ();
+  uint32_t interface = ipv4->GetInterfaceForDevice (firstLink.Get (0));
+  ipv4->SetDown (interface);
+  time.Start ();
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+  Report ("Recompute after link down", time.End (), nodes);
+  ipv4->SetUp (interface);
+  time.Start ();
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+  Report ("Recompute after link up", time.End (), nodes);
+
+  Simulator::Destroy ();
+  return 0;
+}
@@ -0,0 +1,161 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// This program benchmarks the forwarding lookups of IPv4 routes: the scan
+// of a route list, as the routing protocols did, the Ipv4Fib lookup, and
+// the RouteOutput of Ipv4StaticRouting and Ipv4GlobalRouting, holding the
+// same routes.
+// Sample usage:  ./waf --run 'bench-ipv4-fib --routes=10000 --lookups=1000000'
+
+#include "ns3/command-line.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/simulator.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-static-routing-helper.h"
+#include "ns3/ipv4-global-routing.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/ipv4-fib.h"
+#include <iostream>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * Print the time taken per lookup
+ * \param name the name of the benchmark
+ * \param ms the elapsed time
+ * \param lookups the number of lookups
+ * \param check a result, printed so that the work is not optimized out
+ */
+static void
+Report (const std::string &name, int64_t ms, uint32_t lookups, uint64_t check)
+{
+  std::cout << name << ": " << ms * 1e6 / lookups << " ns/lookup (" << ms
+            << " ms elapsed, check " << check << ")" << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t nRoutes = 10000;
+  uint32_t lookups = 1000000;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark the forwarding lookups of IPv4 routes");
+  cmd.AddValue ("routes", "number of routes", nRoutes);
+  cmd.AddValue ("lookups", "number of lookups", lookups);
+  cmd.Parse (argc, argv);
+
+  // Prefixes of /16 to /24 in 10.0.0.0/8, as imported from a topology
+  Ptr<UniformRandomVariable> rand = CreateObject<UniformRandomVariable> ();
+  std::vector<Ipv4Fib::Prefix> prefixes;
+  for (uint32_t i = 0; i < nRoutes; i++)
+    {
+      uint32_t mask = ~0u << (32 - rand->GetInteger (16, 24));
+      uint32_t network = (10 << 24) | rand->GetInteger (0, 0xffffff);
+      prefixes.push_back (std::make_pair (Ipv4Address (network & mask), Ipv4Mask (mask)));
+    }
+  std::vector<Ipv4Address> dests (1024);
+  for (uint32_t i = 0; i < dests.size (); i++)
+    {
+      const Ipv4Fib::Prefix &prefix = prefixes[rand->GetInteger (0, nRoutes - 1)];
+      dests[i] = Ipv4Address (prefix.first.Get () | (rand->GetInteger (0, 0xffffffff) & ~prefix.second.Get ()));
+    }
+
+  SystemWallClockMs time;
+  uint64_t check = 0;
+  std::vector<uint32_t> routes;
+
+  time.Start ();
+  for (uint32_t i = 0; i < lookups; i++)
+    {
+      Ipv4Address dest = dests[i % dests.size ()];
+      routes.clear ();
+      for (uint32_t j = 0; j < prefixes.size (); j++)
+        {
+          if (prefixes[j].second.IsMatch (dest, prefixes[j].first))
+            {
+              routes.push_back (j);
+            }
+        }
+      check += routes.size ();
+    }
+  Report ("Route list scan", time.End (), lookups, check);
+
+  Ipv4Fib fib;
+  time.Start ();
+  fib.Build (prefixes);
+  std::cout << "Ipv4Fib build: " << time.End () << " ms, "
+            << fib.GetNNodes () << " nodes" << std::endl;
+  check = 0;
+  time.Start ();
+  for (uint32_t i = 0; i < lookups; i++)
+    {
+      fib.Lookup (dests[i % dests.size ()], routes);
+      check += routes.size ();
+    }
+  Report ("Ipv4Fib", time.End (), lookups, check);
+
+  // The routing protocols of a node with a single interface
+  Ptr<Node> node = CreateObject<Node> ();
+  InternetStackHelper internet;
+  internet.Install (node);
+  Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+  device->SetAddress (Mac48Address::Allocate ());
+  node->AddDevice (device);
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  uint32_t interface = ipv4->AddInterface (device);
+  ipv4->AddAddress (interface, Ipv4InterfaceAddress (Ipv4Address ("192.168.0.1"), Ipv4Mask ("/24")));
+  ipv4->SetUp (interface);
+  Ipv4StaticRoutingHelper helper;
+  Ptr<Ipv4StaticRouting> staticRouting = helper.GetStaticRouting (ipv4);
+  Ptr<Ipv4GlobalRouting> globalRouting = CreateObject<Ipv4GlobalRouting> ();
+  globalRouting->SetIpv4 (ipv4);
+  for (uint32_t i = 0; i < nRoutes; i++)
+    {
+      Ipv4Address gateway (Ipv4Address ("192.168.0.0").Get () + 2 + i % 250);
+      staticRouting->AddNetworkRouteTo (prefixes[i].first, prefixes[i].second, gateway, interface);
+      globalRouting->AddNetworkRouteTo (prefixes[i].first, prefixes[i].second, gateway, interface);
+    }
+
+  Ptr<Packet> packet = Create<Packet> ();
+  Ipv4Header header;
+  Socket::SocketErrno err;
+  check = 0;
+  time.Start ();
+  for (uint32_t i = 0; i < lookups; i++)
+    {
+      header.SetDestination (dests[i % dests.size ()]);
+      check += staticRouting->RouteOutput (packet, header, 0, err)->GetGateway ().Get ();
+    }
+  Report ("Ipv4StaticRouting::RouteOutput", time.End (), lookups, check);
+
+  check = 0;
+  time.Start ();
+  for (uint32_t i = 0; i < lookups; i++)
+    {
+      header.SetDestination (dests[i % dests.size ()]);
+      check += globalRouting->RouteOutput (packet, header, 0, err)->GetGateway ().Get ();
+    }
+  Report ("Ipv4GlobalRouting::RouteOutput", time.End (), lookups, check);
+
+  globalRouting->Dispose ();
+  Simulator::Destroy ();
+  return 0;
+}
@@ -0,0 +1,136 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// This program benchmarks the forwarding of IPv4 packets along a chain of
+// routers joined by point-to-point links, with global routing: UDP
+// packets are sent from the host at one end of the chain to the hosts at
+// the other end, and the program prints the wall-clock time per forwarded
+// packet and the number of packets delivered, which must not depend on
+// the route cache of the routers.
+// Sample usage:  ./waf --run 'bench-ipv4-forwarding --routers=16 --packets=100000 --cache=1'
+
+#include "ns3/command-line.h"
+#include "ns3/config.h"
+#include "ns3/boolean.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/simulator.h"
+#include "ns3/node-container.h"
+#include "ns3/packet.h"
+#include "ns3/socket.h"
+#include "ns3/udp-socket-factory.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-global-routing-helper.h"
+#include "ns3/ipv4.h"
+#include <iostream>
+#include <vector>
+
+using namespace ns3;
+
+static uint32_t g_received = 0; //!< Number of packets delivered
+
+/**
+ * Receive the packets of a socket
+ * \param socket the socket
+ */
+static void
+Receive (Ptr<Socket> socket)
+{
+  while (socket->Recv ())
+    {
+      g_received++;
+    }
+}
+
+/**
+ * Send a packet to each destination, in turn
+ * \param socket the sending socket
+ * \param dests the destinations
+ * \param n the number of packets left to send
+ */
+static void
+Send (Ptr<Socket> socket, const std::vector<Ipv4Address> *dests, uint32_t n)
+{
+  socket->SendTo (Create<Packet> (100), 0, InetSocketAddress ((*dests)[n % dests->size ()], 9));
+  if (n > 1)
+    {
+      Simulator::Schedule (MicroSeconds (1), &Send, socket, dests, n - 1);
+    }
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t nRouters = 8;
+  uint32_t nSinks = 4;
+  uint32_t nPackets = 50000;
+  bool cache = false;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark the forwarding of IPv4 packets along a chain of routers");
+  cmd.AddValue ("routers", "number of routers of the chain", nRouters);
+  cmd.AddValue ("sinks", "number of destination hosts", nSinks);
+  cmd.AddValue ("packets", "number of packets sent", nPackets);
+  cmd.AddValue ("cache", "cache the forwarding routes of the routers", cache);
+  cmd.Parse (argc, argv);
+
+  Config::SetDefault ("ns3::Ipv4L3Protocol::RouteCache", BooleanValue (cache));
+
+  NodeContainer source, routers, sinks;
+  source.Create (1);
+  routers.Create (nRouters);
+  sinks.Create (nSinks);
+  InternetStackHelper internet;
+  internet.SetIpv6StackInstall (false);
+  internet.InstallAll ();
+
+  SimpleNetDeviceHelper p2p;
+  p2p.SetNetDevicePointToPointMode (true);
+  Ipv4AddressHelper address ("10.0.0.0", "255.255.255.252");
+  address.Assign (p2p.Install (NodeContainer (source.Get (0), routers.Get (0))));
+  address.NewNetwork ();
+  for (uint32_t r = 0; r + 1 < nRouters; r++)
+    {
+      address.Assign (p2p.Install (NodeContainer (routers.Get (r), routers.Get (r + 1))));
+      address.NewNetwork ();
+    }
+  std::vector<Ipv4Address> dests;
+  for (uint32_t s = 0; s < nSinks; s++)
+    {
+      address.Assign (p2p.Install (NodeContainer (routers.Get (nRouters - 1), sinks.Get (s))));
+      address.NewNetwork ();
+      dests.push_back (sinks.Get (s)->GetObject<Ipv4> ()->GetAddress (1, 0).GetLocal ());
+      Ptr<Socket> sink = Socket::CreateSocket (sinks.Get (s), UdpSocketFactory::GetTypeId ());
+      sink->Bind (InetSocketAddress (Ipv4Address::GetAny (), 9));
+      sink->SetRecvCallback (MakeCallback (&Receive));
+    }
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+
+  Ptr<Socket> socket = Socket::CreateSocket (source.Get (0), UdpSocketFactory::GetTypeId ());
+  Simulator::Schedule (Seconds (1), &Send, socket, &dests, nPackets);
+
+  SystemWallClockMs time;
+  time.Start ();
+  Simulator::Run ();
+  int64_t ms = time.End ();
+  std::cout << nRouters << " routers, route cache " << (cache ? "on" : "off") << ": "
+            << ms * 1e6 / (static_cast<double> (nPackets) * nRouters) << " ns/forwarded packet ("
+            << ms << " ms elapsed, " << g_received << " packets delivered)" << std::endl;
+
+  Simulator::Destroy ();
+  return 0;
+}
@@ -0,0 +1,269 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// This program benchmarks nix-vector routing on a k-ary fat-tree of
+// point-to-point links: the first route between random pairs of hosts,
+// the following ones, and the forwarding of a packet along each route,
+// before and after the failure of a core link.  The routes are followed
+// hop by hop through RouteOutput and RouteInput, and the total number of
+// hops is printed, which must not depend on the implementation.  The
+// routes from all the hosts may be computed beforehand, in parallel.
+// Sample usage:  ./waf --run 'bench-nix-vector-routing --k=16 --pairs=20000 --precompute=1 --threads=4'
+
+#include "ns3/command-line.h"
+#include "ns3/config.h"
+#include "ns3/uinteger.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/simulator.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/node-container.h"
+#include "ns3/node-list.h"
+#include "ns3/packet.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-nix-vector-helper.h"
+#include "ns3/ipv4-nix-vector-routing.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/ipv4.h"
+#include <iostream>
+#include <vector>
+
+using namespace ns3;
+
+static Ptr<Ipv4Route> g_forwardRoute; //!< Route given to the unicast forward callback
+static bool g_delivered;              //!< Whether the local deliver callback was called
+
+/**
+ * Unicast forward callback
+ * \param route the route
+ * \param p the packet
+ * \param header the IP header
+ */
+static void
+Forward (Ptr<Ipv4Route> route, Ptr<const Packet> p, const Ipv4Header &header)
+{
+  g_forwardRoute = route;
+}
+
+/**
+ * Local deliver callback
+ * \param p the packet
+ * \param header the IP header
+ * \param iif the input interface
+ */
+static void
+Deliver (Ptr<const Packet> p, const Ipv4Header &header, uint32_t iif)
+{
+  g_delivered = true;
+}
+
+/**
+ * \param node a node
+ * \return the routing protocol of the node
+ */
+static Ptr<Ipv4RoutingProtocol>
+GetRouting (Ptr<Node> node)
+{
+  return node->GetObject<Ipv4> ()->GetRoutingProtocol ();
+}
+
+/**
+ * Send a packet from a host to another one, through the routing
+ * protocols of the nodes on the way
+ * \param source the source host
+ * \param dest the address of the destination host
+ * \return the number of hops of the packet, or 0 if not delivered
+ */
+static uint32_t
+Follow (Ptr<Node> source, Ipv4Address dest)
+{
+  Ptr<Packet> packet = Create<Packet> ();
+  Ipv4Header header;
+  header.SetDestination (dest);
+  Socket::SocketErrno err;
+  Ptr<Ipv4Route> route = GetRouting (source)->RouteOutput (packet, header, 0, err);
+  uint32_t hops = 0;
+  g_delivered = false;
+  while (route != 0 && hops < 64)
+    {
+      hops++;
+      Ptr<NetDevice> device = route->GetOutputDevice ();
+      Ptr<Channel> channel = device->GetChannel ();
+      Ptr<NetDevice> peer = channel->GetDevice (0) == device ? channel->GetDevice (1) : channel->GetDevice (0);
+      g_forwardRoute = 0;
+      GetRouting (peer->GetNode ())->RouteInput (packet, header, peer,
+                                                 MakeCallback (&Forward),
+                                                 Ipv4RoutingProtocol::MulticastForwardCallback (),
+                                                 MakeCallback (&Deliver),
+                                                 Ipv4RoutingProtocol::ErrorCallback ());
+      route = g_forwardRoute;
+    }
+  return g_delivered ? hops : 0;
+}
+
+/**
+ * Print the time taken per route
+ * \param name the name of the step
+ * \param ms the elapsed time
+ * \param routes the number of routes
+ * \param hops the total number of hops, or 0 if not counted
+ */
+static void
+Report (const std::string &name, int64_t ms, uint32_t routes, uint64_t hops)
+{
+  std::cout << name << ": " << ms * 1e3 / routes << " us/route (" << ms << " ms elapsed";
+  if (hops)
+    {
+      std::cout << ", " << hops << " hops";
+    }
+  std::cout << ")" << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t k = 8;
+  uint32_t nPairs = 10000;
+  bool precompute = false;
+  uint32_t threads = 1;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark nix-vector routing on a fat-tree");
+  cmd.AddValue ("k", "number of ports of the switches, even", k);
+  cmd.AddValue ("pairs", "number of pairs of hosts routed", nPairs);
+  cmd.AddValue ("precompute", "compute the routes to all the hosts beforehand", precompute);
+  cmd.AddValue ("threads", "number of threads computing the routes beforehand", threads);
+  cmd.Parse (argc, argv);
+
+  Config::SetGlobal ("NixVectorRoutingThreads", UintegerValue (threads));
+
+  // k pods of k/2 edge and k/2 aggregation switches, (k/2)^2 core
+  // switches and k/2 hosts per edge switch
+  uint32_t half = k / 2;
+  NodeContainer core, aggregation, edge, hosts;
+  core.Create (half * half);
+  aggregation.Create (k * half);
+  edge.Create (k * half);
+  hosts.Create (k * half * half);
+  Ipv4NixVectorHelper nixRouting;
+  InternetStackHelper internet;
+  internet.SetRoutingHelper (nixRouting);
+  internet.InstallAll ();
+
+  SimpleNetDeviceHelper p2p;
+  p2p.SetNetDevicePointToPointMode (true);
+  Ipv4AddressHelper address ("10.0.0.0", "255.255.255.252");
+  NetDeviceContainer coreLink;
+  for (uint32_t pod = 0; pod < k; pod++)
+    {
+      for (uint32_t e = 0; e < half; e++)
+        {
+          Ptr<Node> edgeSwitch = edge.Get (pod * half + e);
+          for (uint32_t h = 0; h < half; h++)
+            {
+              address.Assign (p2p.Install (NodeContainer (hosts.Get ((pod * half + e) * half + h), edgeSwitch)));
+              address.NewNetwork ();
+            }
+          for (uint32_t a = 0; a < half; a++)
+            {
+              address.Assign (p2p.Install (NodeContainer (edgeSwitch, aggregation.Get (pod * half + a))));
+              address.NewNetwork ();
+            }
+        }
+      for (uint32_t a = 0; a < half; a++)
+        {
+          for (uint32_t c = 0; c < half; c++)
+            {
+              NetDeviceContainer link = p2p.Install (NodeContainer (aggregation.Get (pod * half + a),
+                                                                    core.Get (a * half + c)));
+              address.Assign (link);
+              address.NewNetwork ();
+              if (coreLink.GetN () == 0)
+                {
+                  coreLink = link;
+                }
+            }
+        }
+    }
+  std::cout << NodeList::GetNNodes () << " nodes, " << hosts.GetN () << " hosts" << std::endl;
+
+  Ptr<UniformRandomVariable> rand = CreateObject<UniformRandomVariable> ();
+  std::vector<std::pair<Ptr<Node>, Ipv4Address> > pairs;
+  for (uint32_t i = 0; i < nPairs; i++)
+    {
+      Ptr<Node> source = hosts.Get (rand->GetInteger (0, hosts.GetN () - 1));
+      Ptr<Node> dest = hosts.Get (rand->GetInteger (0, hosts.GetN () - 1));
+      if (source != dest)
+        {
+          pairs.push_back (std::make_pair (source, dest->GetObject<Ipv4> ()->GetAddress (1, 0).GetLocal ()));
+        }
+    }
+
+  SystemWallClockMs time;
+  Ptr<Packet> packet = Create<Packet> ();
+  Ipv4Header header;
+  Socket::SocketErrno err;
+  if (precompute)
+    {
+      time.Start ();
+      Ipv4NixVectorRouting::ComputeRoutes (hosts);
+      std::cout << "Routes from all the hosts: " << time.End () << " ms, " << threads << " threads" << std::endl;
+    }
+  for (uint32_t round = 0; round < 2; round++)
+    {
+      time.Start ();
+      for (uint32_t i = 0; i < pairs.size (); i++)
+        {
+          header.SetDestination (pairs[i].second);
+          GetRouting (pairs[i].first)->RouteOutput (packet, header, 0, err);
+        }
+      Report (round == 0 ? "First routes" : "Following routes", time.End (), pairs.size (), 0);
+    }
+
+  uint64_t hops = 0;
+  time.Start ();
+  for (uint32_t i = 0; i < pairs.size (); i++)
+    {
+      hops += Follow (pairs[i].first, pairs[i].second);
+    }
+  Report ("Forwarding", time.End (), pairs.size (), hops);
+
+  // A core link failure and its repair
+  Ptr<Ipv4> ipv4 = coreLink.Get (0)->GetNode ()->GetObject<Ipv4> ();
+  uint32_t interface = ipv4->GetInterfaceForDevice (coreLink.Get (0));
+  for (uint32_t round = 0; round < 2; round++)
+    {
+      if (round == 0)
+        {
+          ipv4->SetDown (interface);
+        }
+      else
+        {
+          ipv4->SetUp (interface);
+        }
+      hops = 0;
+      time.Start ();
+      for (uint32_t i = 0; i < pairs.size (); i++)
+        {
+          hops += Follow (pairs[i].first, pairs[i].second);
+        }
+      Report (round == 0 ? "Forwarding after link down" : "Forwarding after link up",
+              time.End (), pairs.size (), hops);
+    }
+
+  Simulator::Destroy ();
+  return 0;
+}
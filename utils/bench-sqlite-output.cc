@@ -0,0 +1,134 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// This program benchmarks the output of the runs of a sweep to a single
+// SQLite database: the runs are split between forked worker processes,
+// each of which outputs its runs with a SqliteDataOutput, and the program
+// prints the wall-clock time per row and checks the rows of the database.
+// Sample usage:  ./waf --run 'bench-sqlite-output --runs=100 --values=1000 --workers=4 --commit=10000 --journal=WAL'
+
+#include "ns3/command-line.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/sqlite-data-output.h"
+#include "ns3/data-collector.h"
+#include "ns3/basic-data-calculators.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <unistd.h>
+#include <sys/wait.h>
+
+using namespace ns3;
+
+/**
+ * Output a run
+ * \param prefix the prefix of the database
+ * \param run the index of the run
+ * \param nValues the number of values of the run
+ * \param commitSize the number of rows per transaction
+ * \param journalMode the journal mode of the database
+ */
+static void
+OutputRun (std::string prefix, uint32_t run, uint32_t nValues, uint32_t commitSize, std::string journalMode)
+{
+  DataCollector data;
+  std::ostringstream runLabel;
+  runLabel << "run-" << run;
+  data.DescribeRun ("bench-sqlite-output", "strategy", "input", runLabel.str ());
+  for (uint32_t n = 0; n < nValues; n++)
+    {
+      Ptr<CounterCalculator<> > counter = CreateObject<CounterCalculator<> > ();
+      std::ostringstream context;
+      context << "node[" << n << "]";
+      counter->SetKey ("packets");
+      counter->SetContext (context.str ());
+      counter->Update (run + n);
+      data.AddDataCalculator (counter);
+    }
+  Ptr<SqliteDataOutput> output = CreateObject<SqliteDataOutput> ();
+  output->SetAttribute ("CommitSize", UintegerValue (commitSize));
+  output->SetAttribute ("JournalMode", StringValue (journalMode));
+  output->SetFilePrefix (prefix);
+  output->Output (data);
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t nRuns = 20;
+  uint32_t nValues = 1000;
+  uint32_t nWorkers = 1;
+  uint32_t commitSize = 10000;
+  std::string journalMode = "WAL";
+  std::string prefix = "bench-sqlite-output";
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark the output of the runs of a sweep to a SQLite database");
+  cmd.AddValue ("runs", "number of runs", nRuns);
+  cmd.AddValue ("values", "number of values per run", nValues);
+  cmd.AddValue ("workers", "number of worker processes", nWorkers);
+  cmd.AddValue ("commit", "number of rows per transaction, or 0 for one per run", commitSize);
+  cmd.AddValue ("journal", "journal mode of the database: Delete or WAL", journalMode);
+  cmd.AddValue ("prefix", "prefix of the database", prefix);
+  cmd.Parse (argc, argv);
+
+  std::string dbFile = prefix + ".db";
+  std::remove (dbFile.c_str ());
+  std::remove ((dbFile + "-wal").c_str ());
+  std::remove ((dbFile + "-shm").c_str ());
+
+  SystemWallClockMs time;
+  time.Start ();
+  std::vector<pid_t> workers;
+  for (uint32_t w = 0; w < nWorkers; w++)
+    {
+      pid_t pid = fork ();
+      if (pid == 0)
+        {
+          for (uint32_t run = w; run < nRuns; run += nWorkers)
+            {
+              OutputRun (prefix, run, nValues, commitSize, journalMode);
+            }
+          _exit (0);
+        }
+      workers.push_back (pid);
+    }
+  for (std::vector<pid_t>::const_iterator pid = workers.begin (); pid != workers.end (); pid++)
+    {
+      waitpid (*pid, 0, 0);
+    }
+  int64_t ms = time.End ();
+
+  uint64_t nRows = static_cast<uint64_t> (nRuns) * nValues;
+  std::cout << nWorkers << " workers, commit size " << commitSize << ", journal " << journalMode << ": "
+            << ms * 1e6 / nRows << " ns/row (" << ms << " ms elapsed)" << std::endl;
+
+  sqlite3 *db;
+  sqlite3_stmt *stmt;
+  sqlite3_open (dbFile.c_str (), &db);
+  sqlite3_prepare_v2 (db, "select count(*), count(distinct run) from Singletons", -1, &stmt, NULL);
+  if (sqlite3_step (stmt) == SQLITE_ROW)
+    {
+      std::cout << sqlite3_column_int64 (stmt, 0) << " rows of " << sqlite3_column_int64 (stmt, 1)
+                << " runs written, " << nRows << " expected" << std::endl;
+    }
+  sqlite3_finalize (stmt);
+  sqlite3_close (db);
+
+  return 0;
+}
@@ -0,0 +1,109 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// This program benchmarks the output of time series: the samples of a few
+// congestion-window-like series are written by a FileAggregator, as text,
+// and by a ColumnarAggregator, and the program prints the wall-clock time
+// per sample and the size of each file.
+// Sample usage:  ./waf --run 'bench-stats-output --samples=10000000 --series=10'
+
+#include "ns3/command-line.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/file-aggregator.h"
+#include "ns3/columnar-aggregator.h"
+#include "ns3/random-variable-stream.h"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \param fileName the name of a file
+ * \return the size of the file
+ */
+static uint64_t
+FileSize (const std::string &fileName)
+{
+  std::ifstream file (fileName.c_str (), std::ios::in | std::ios::binary | std::ios::ate);
+  return file.tellg ();
+}
+
+/**
+ * Write the samples of the series with an aggregator, and destroy it,
+ * which completes its file
+ * \param aggregator the aggregator, released
+ * \param contexts the contexts of the series
+ * \param nSamples the number of samples
+ * \return the time elapsed, in milliseconds
+ */
+template <typename A>
+static int64_t
+WriteSamples (Ptr<A> &aggregator, const std::vector<std::string> &contexts, uint32_t nSamples)
+{
+  // The same samples for each aggregator
+  Ptr<UniformRandomVariable> rand = CreateObject<UniformRandomVariable> ();
+  rand->SetStream (1);
+  std::vector<double> cwnd (contexts.size (), 536);
+  SystemWallClockMs time;
+  time.Start ();
+  for (uint32_t i = 0; i < nSamples; i++)
+    {
+      uint32_t s = i % contexts.size ();
+      // Additive increase, and an occasional halving
+      cwnd[s] = rand->GetValue () < 0.001 ? cwnd[s] / 2 : cwnd[s] + 536;
+      aggregator->Write2d (contexts[s], 1e-4 * (i / contexts.size ()), cwnd[s]);
+    }
+  aggregator = 0;
+  return time.End ();
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t nSamples = 1000000;
+  uint32_t nSeries = 10;
+  std::string prefix = "bench-stats-output";
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark the output of time series by the file and columnar aggregators");
+  cmd.AddValue ("samples", "number of samples written", nSamples);
+  cmd.AddValue ("series", "number of time series", nSeries);
+  cmd.AddValue ("prefix", "prefix of the files written", prefix);
+  cmd.Parse (argc, argv);
+
+  std::vector<std::string> contexts;
+  for (uint32_t s = 0; s < nSeries; s++)
+    {
+      std::ostringstream oss;
+      oss << "/NodeList/" << s << "/$ns3::TcpL4Protocol/SocketList/0/CongestionWindow";
+      contexts.push_back (oss.str ());
+    }
+
+  std::string textFile = prefix + ".txt";
+  Ptr<FileAggregator> text = CreateObject<FileAggregator> (textFile, FileAggregator::SPACE_SEPARATED);
+  int64_t textMs = WriteSamples (text, contexts, nSamples);
+  std::cout << "FileAggregator:     " << textMs * 1e6 / nSamples << " ns/sample, "
+            << FileSize (textFile) << " bytes (" << textMs << " ms elapsed)" << std::endl;
+
+  std::string columnarFile = prefix + ".col";
+  Ptr<ColumnarAggregator> columnar = CreateObject<ColumnarAggregator> (columnarFile);
+  int64_t columnarMs = WriteSamples (columnar, contexts, nSamples);
+  std::cout << "ColumnarAggregator: " << columnarMs * 1e6 / nSamples << " ns/sample, "
+            << FileSize (columnarFile) << " bytes (" << columnarMs << " ms elapsed)" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,503 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// This program benchmarks the simulation cost of the TCP stack.  Flows of
+// a given size cross the dumbbell of scratch/ai-multi-flow.cc (source,
+// router, sink, the router to sink link being the bottleneck), and the
+// program reports their completion times, the events processed per
+// wall-clock second, the simulated bytes delivered per wall-clock second,
+// the peak resident set size and the share of the wall-clock time spent
+// in each layer.
+//
+// The layer breakdown marks the wall-clock time at the trace sources on
+// the boundaries of the layers: the time between two marks is charged to
+// the layer of the first one, and the time spent in the scheduler is
+// measured around its operations.  The breakdown is indicative: the time
+// spent on the way back up the call stack is charged to the lowest layer
+// traced.  Run with --breakdown=false to time the stack alone.
+// Sample usage:  ./waf --run 'bench-tcp-fct --flows=20 --cc=ns3::TcpCubic'
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/map-scheduler.h"
+#include <sys/resource.h>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using namespace ns3;
+
+/// Layers of the time breakdown
+enum Layer
+{
+  LAYER_UNKNOWN,     //!< Start of an event, before any mark
+  LAYER_SCHEDULER,   //!< Simulator scheduler
+  LAYER_APPLICATION, //!< Applications
+  LAYER_TCP,         //!< TCP sockets
+  LAYER_IP,          //!< IPv4 and traffic control
+  LAYER_DEVICE,      //!< Devices, their queues and channels
+  LAYER_COUNT        //!< Number of layers
+};
+
+/// Names of the layers
+static const char *g_layerNames[LAYER_COUNT] = {
+  "event start", "scheduler", "application", "tcp", "ipv4/tc", "device"
+};
+
+/**
+ * Wall-clock profile of the simulation
+ */
+struct Profile
+{
+  typedef std::chrono::steady_clock Clock; //!< Clock of the marks
+
+  Profile ();
+
+  /**
+   * \brief Start the profile, from now
+   */
+  void Start (void);
+
+  /**
+   * \brief Charge the time since the last mark to the current layer
+   * \param layer the layer entered
+   */
+  void Mark (Layer layer);
+
+  bool m_enabled;                       //!< Whether the layers are timed
+  uint64_t m_events;                    //!< Events processed
+  Layer m_current;                      //!< Current layer
+  Clock::time_point m_last;             //!< Time of the last mark
+  Clock::duration m_time[LAYER_COUNT];  //!< Time spent in each layer
+};
+
+Profile::Profile ()
+  : m_enabled (true)
+{
+  Start ();
+}
+
+void
+Profile::Start (void)
+{
+  m_events = 0;
+  m_current = LAYER_UNKNOWN;
+  m_last = Clock::now ();
+  for (uint32_t i = 0; i < LAYER_COUNT; i++)
+    {
+      m_time[i] = Clock::duration::zero ();
+    }
+}
+
+void
+Profile::Mark (Layer layer)
+{
+  Clock::time_point now = Clock::now ();
+  m_time[m_current] += now - m_last;
+  m_last = now;
+  m_current = layer;
+}
+
+/// The profile of the simulation
+static Profile g_profile;
+
+/**
+ * A MapScheduler counting the events, and timing its operations
+ */
+class ProfilingScheduler : public MapScheduler
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  virtual void Insert (const Event &ev);
+  virtual Event RemoveNext (void);
+  virtual void Remove (const Event &ev);
+};
+
+TypeId
+ProfilingScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::ProfilingScheduler")
+    .SetParent<MapScheduler> ()
+    .AddConstructor<ProfilingScheduler> ()
+  ;
+  return tid;
+}
+
+void
+ProfilingScheduler::Insert (const Event &ev)
+{
+  if (!g_profile.m_enabled)
+    {
+      MapScheduler::Insert (ev);
+      return;
+    }
+  Layer current = g_profile.m_current;
+  g_profile.Mark (LAYER_SCHEDULER);
+  MapScheduler::Insert (ev);
+  g_profile.Mark (current);
+}
+
+Scheduler::Event
+ProfilingScheduler::RemoveNext (void)
+{
+  g_profile.m_events++;
+  if (!g_profile.m_enabled)
+    {
+      return MapScheduler::RemoveNext ();
+    }
+  // The previous event ends here
+  g_profile.Mark (LAYER_SCHEDULER);
+  Event ev = MapScheduler::RemoveNext ();
+  g_profile.Mark (LAYER_UNKNOWN);
+  return ev;
+}
+
+void
+ProfilingScheduler::Remove (const Event &ev)
+{
+  if (!g_profile.m_enabled)
+    {
+      MapScheduler::Remove (ev);
+      return;
+    }
+  Layer current = g_profile.m_current;
+  g_profile.Mark (LAYER_SCHEDULER);
+  MapScheduler::Remove (ev);
+  g_profile.Mark (current);
+}
+
+/**
+ * \brief Mark the entry in a layer, from a trace source
+ * \param layer the layer
+ */
+template <typename T1>
+static void
+Mark (Layer layer, T1)
+{
+  g_profile.Mark (layer);
+}
+
+/**
+ * \brief Mark the entry in a layer, from a trace source
+ * \param layer the layer
+ */
+template <typename T1, typename T2>
+static void
+Mark (Layer layer, T1, T2)
+{
+  g_profile.Mark (layer);
+}
+
+/**
+ * \brief Mark the entry in a layer, from a trace source
+ * \param layer the layer
+ */
+template <typename T1, typename T2, typename T3>
+static void
+Mark (Layer layer, T1, T2, T3)
+{
+  g_profile.Mark (layer);
+}
+
+/**
+ * A flow of the benchmark
+ */
+struct Flow
+{
+  Ptr<BulkSendApplication> m_source; //!< Sending application
+  Time m_start;                      //!< Start time
+  Time m_fct;                        //!< Completion time, or zero
+  uint64_t m_received;               //!< Bytes received
+};
+
+/// Number of flows not completed yet
+static uint32_t g_running;
+
+/**
+ * \brief Count the bytes received by a flow, and complete it
+ *
+ * The simulation stops when all the flows are completed.
+ *
+ * \param flow the flow
+ * \param size the size of the flow, or 0 for an unlimited flow
+ * \param p the packet received
+ * \param from the address of the sender
+ */
+static void
+SinkRx (Flow *flow, uint64_t size, Ptr<const Packet> p, const Address &from)
+{
+  flow->m_received += p->GetSize ();
+  if (size > 0 && flow->m_received >= size && flow->m_fct.IsZero ())
+    {
+      flow->m_fct = Simulator::Now () - flow->m_start;
+      if (--g_running == 0)
+        {
+          Simulator::Stop ();
+        }
+    }
+}
+
+/**
+ * \brief Install the congestion control on the sockets of the sources
+ * \param flows the flows
+ * \param cc the TypeId of the congestion control
+ */
+static void
+SetCongestionControl (std::vector<Flow> *flows, TypeId cc)
+{
+  ObjectFactory factory;
+  factory.SetTypeId (cc);
+  for (Flow &flow : *flows)
+    {
+      Ptr<TcpSocketBase> socket = DynamicCast<TcpSocketBase> (flow.m_source->GetSocket ());
+      if (socket != 0)
+        {
+          socket->SetCongestionControlAlgorithm (factory.Create<TcpCongestionOps> ());
+        }
+    }
+}
+
+/**
+ * \brief Connect the layer marks to the trace sources
+ *
+ * Called once the sockets exist, before any connection is forked: the
+ * forked sockets copy the trace sources of their listening socket.
+ */
+static void
+ConnectMarks (void)
+{
+  Config::ConnectWithoutContext ("/NodeList/*/$ns3::TcpL4Protocol/SocketList/*/Tx",
+                                 MakeBoundCallback (&Mark<Ptr<const Packet>, const TcpHeader &, Ptr<const TcpSocketBase> >,
+                                                    LAYER_TCP));
+  Config::ConnectWithoutContext ("/NodeList/*/$ns3::TcpL4Protocol/SocketList/*/Rx",
+                                 MakeBoundCallback (&Mark<Ptr<const Packet>, const TcpHeader &, Ptr<const TcpSocketBase> >,
+                                                    LAYER_TCP));
+  Config::ConnectWithoutContext ("/NodeList/*/ApplicationList/*/$ns3::PacketSink/Rx",
+                                 MakeBoundCallback (&Mark<Ptr<const Packet>, const Address &>,
+                                                    LAYER_APPLICATION));
+  Config::ConnectWithoutContext ("/NodeList/*/$ns3::Ipv4L3Protocol/SendOutgoing",
+                                 MakeBoundCallback (&Mark<const Ipv4Header &, Ptr<const Packet>, uint32_t>,
+                                                    LAYER_IP));
+  Config::ConnectWithoutContext ("/NodeList/*/$ns3::Ipv4L3Protocol/UnicastForward",
+                                 MakeBoundCallback (&Mark<const Ipv4Header &, Ptr<const Packet>, uint32_t>,
+                                                    LAYER_IP));
+  Config::ConnectWithoutContext ("/NodeList/*/$ns3::Ipv4L3Protocol/LocalDeliver",
+                                 MakeBoundCallback (&Mark<const Ipv4Header &, Ptr<const Packet>, uint32_t>,
+                                                    LAYER_IP));
+  Config::ConnectWithoutContext ("/NodeList/*/$ns3::Ipv4L3Protocol/Rx",
+                                 MakeBoundCallback (&Mark<Ptr<const Packet>, Ptr<Ipv4>, uint32_t>,
+                                                    LAYER_IP));
+  const char *deviceTraces[] = {"MacTx", "PhyTxBegin", "PhyRxEnd"};
+  for (const char *trace : deviceTraces)
+    {
+      Config::ConnectWithoutContext (std::string ("/NodeList/*/DeviceList/*/$ns3::PointToPointNetDevice/") + trace,
+                                     MakeBoundCallback (&Mark<Ptr<const Packet> >, LAYER_DEVICE));
+    }
+}
+
+/**
+ * \return the peak resident set size, in KiB
+ */
+static uint64_t
+GetPeakRss (void)
+{
+  struct rusage usage;
+  if (getrusage (RUSAGE_SELF, &usage) != 0)
+    {
+      return 0;
+    }
+#ifdef __APPLE__
+  return usage.ru_maxrss / 1024;
+#else
+  return usage.ru_maxrss;
+#endif
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t nFlows = 10;
+  uint64_t flowBytes = 10000000;
+  std::string cc = "default";
+  bool sack = true;
+  bool pacing = false;
+  bool ackPacing = false;
+  bool timerWheel = false;
+  uint32_t gsoSegments = 1;
+  double bwMbps = 100;
+  double delUs = 5000;
+  uint32_t queP = 1000;
+  uint32_t packetSize = 1380;
+  double durS = 60;
+  bool breakdown = true;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark the simulation cost of TCP flows across a dumbbell");
+  cmd.AddValue ("flows", "number of flows", nFlows);
+  cmd.AddValue ("flow_bytes", "bytes sent by each flow (0 for unlimited flows)", flowBytes);
+  cmd.AddValue ("cc", "congestion control TypeId, or default for the stack's choice", cc);
+  cmd.AddValue ("sack", "enable SACK", sack);
+  cmd.AddValue ("pacing", "enable pacing", pacing);
+  cmd.AddValue ("ack_pacing", "enable the ACK pacing of the unfairness mitigation", ackPacing);
+  cmd.AddValue ("timer_wheel", "hold the TCP timers in a timer wheel", timerWheel);
+  cmd.AddValue ("gso_segments", "maximum segments of a GSO super-segment", gsoSegments);
+  cmd.AddValue ("bandwidth_Mbps", "bottleneck bandwidth (Mbps)", bwMbps);
+  cmd.AddValue ("delay_us", "link delay (us); the RTT is 4x this value", delUs);
+  cmd.AddValue ("queue_capacity_p", "router queue size (packets)", queP);
+  cmd.AddValue ("packet_size", "segment size (bytes)", packetSize);
+  cmd.AddValue ("duration_s", "maximum simulated time (s), for unlimited or slow flows", durS);
+  cmd.AddValue ("breakdown", "time the layers", breakdown);
+  cmd.Parse (argc, argv);
+
+  g_profile.m_enabled = breakdown;
+  ObjectFactory scheduler;
+  scheduler.SetTypeId (ProfilingScheduler::GetTypeId ());
+  Simulator::SetScheduler (scheduler);
+
+  Config::SetDefault ("ns3::TcpSocket::SegmentSize", UintegerValue (packetSize));
+  Config::SetDefault ("ns3::TcpSocket::DelAckCount", UintegerValue (0));
+  Config::SetDefault ("ns3::TcpSocket::SndBufSize", UintegerValue (1000000));
+  Config::SetDefault ("ns3::TcpSocket::RcvBufSize", UintegerValue (1000000));
+  Config::SetDefault ("ns3::TcpSocketBase::Sack", BooleanValue (sack));
+  Config::SetDefault ("ns3::TcpSocketBase::GsoMaxSegments", UintegerValue (gsoSegments));
+  Config::SetDefault ("ns3::TcpSocketState::EnablePacing", BooleanValue (pacing));
+  Config::SetDefault ("ns3::TcpSocketBase::UnfairMitigationEnable", BooleanValue (ackPacing));
+  Config::SetDefault ("ns3::TcpL4Protocol::TimerWheel", BooleanValue (timerWheel));
+
+  NodeContainer nodes;  // 0: source, 1: router, 2: sink
+  nodes.Create (3);
+
+  std::ostringstream del;
+  del << delUs << "us";
+  std::ostringstream bw;
+  bw << bwMbps << "Mbps";
+  std::ostringstream que;
+  que << queP << "p";
+
+  PointToPointHelper p2p;
+  p2p.SetDeviceAttribute ("DataRate", StringValue ("10Gbps"));
+  p2p.SetChannelAttribute ("Delay", StringValue (del.str ()));
+  p2p.SetDeviceAttribute ("Mtu", UintegerValue (packetSize + 120));
+  NetDeviceContainer devices1 = p2p.Install (nodes.Get (0), nodes.Get (1));
+  p2p.SetDeviceAttribute ("DataRate", StringValue (bw.str ()));
+  p2p.SetQueue ("ns3::DropTailQueue", "MaxSize", QueueSizeValue (QueueSize (que.str ())));
+  NetDeviceContainer devices2 = p2p.Install (nodes.Get (1), nodes.Get (2));
+
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.1.1.0", "255.255.255.0");
+  ipv4.Assign (devices1);
+  ipv4.SetBase ("10.1.2.0", "255.255.255.0");
+  Ipv4InterfaceContainer i1i2 = ipv4.Assign (devices2);
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+
+  std::vector<Flow> flows (nFlows);
+  g_running = nFlows;
+  for (uint32_t i = 0; i < nFlows; i++)
+    {
+      uint16_t port = 101 + i;
+      BulkSendHelper source ("ns3::TcpSocketFactory", InetSocketAddress (i1i2.GetAddress (1), port));
+      source.SetAttribute ("MaxBytes", UintegerValue (flowBytes));
+      source.SetAttribute ("SendSize", UintegerValue (packetSize));
+      ApplicationContainer sourceApp = source.Install (nodes.Get (0));
+      sourceApp.Start (Seconds (0));
+      PacketSinkHelper sink ("ns3::TcpSocketFactory", InetSocketAddress (Ipv4Address::GetAny (), port));
+      ApplicationContainer sinkApp = sink.Install (nodes.Get (2));
+      sinkApp.Start (Seconds (0));
+      sinkApp.Get (0)->TraceConnectWithoutContext ("Rx", MakeBoundCallback (&SinkRx, &flows[i], flowBytes));
+      flows[i].m_source = DynamicCast<BulkSendApplication> (sourceApp.Get (0));
+      flows[i].m_start = Seconds (0);
+      flows[i].m_fct = Seconds (0);
+      flows[i].m_received = 0;
+    }
+  // The applications create their sockets at their start; no segment is
+  // received before the first RTT.
+  if (cc != "default")
+    {
+      Simulator::Schedule (NanoSeconds (1), &SetCongestionControl, &flows, TypeId::LookupByName (cc));
+    }
+  if (breakdown)
+    {
+      Simulator::Schedule (NanoSeconds (1), &ConnectMarks);
+    }
+  Simulator::Stop (Seconds (durS));
+
+  auto start = Profile::Clock::now ();
+  g_profile.Start ();
+  Simulator::Run ();
+  g_profile.Mark (LAYER_UNKNOWN);
+  double wallS = std::chrono::duration<double> (Profile::Clock::now () - start).count ();
+  Time simulated = Simulator::Now ();
+  Simulator::Destroy ();
+
+  uint64_t bytes = 0;
+  uint32_t completed = 0;
+  Time fctSum = Seconds (0);
+  Time fctMax = Seconds (0);
+  for (const Flow &flow : flows)
+    {
+      bytes += flow.m_received;
+      if (!flow.m_fct.IsZero ())
+        {
+          completed++;
+          fctSum += flow.m_fct;
+          fctMax = Max (fctMax, flow.m_fct);
+        }
+    }
+
+  std::cout << "flows: " << nFlows << ", completed: " << completed;
+  if (completed > 0)
+    {
+      std::cout << ", mean FCT: " << (fctSum / completed).GetSeconds ()
+                << " s, max FCT: " << fctMax.GetSeconds () << " s";
+    }
+  std::cout << std::endl
+            << "simulated: " << simulated.GetSeconds () << " s in "
+            << wallS << " s of wall-clock time" << std::endl
+            << "events: " << g_profile.m_events << " ("
+            << g_profile.m_events / wallS << " events/s)" << std::endl
+            << "delivered: " << bytes << " bytes ("
+            << bytes / wallS << " simulated bytes/s)" << std::endl
+            << "peak RSS: " << GetPeakRss () << " KiB" << std::endl;
+  if (breakdown)
+    {
+      double total = 0;
+      for (uint32_t i = 0; i < LAYER_COUNT; i++)
+        {
+          total += std::chrono::duration<double> (g_profile.m_time[i]).count ();
+        }
+      std::cout << "time per layer:" << std::endl;
+      for (uint32_t i = 0; i < LAYER_COUNT; i++)
+        {
+          double s = std::chrono::duration<double> (g_profile.m_time[i]).count ();
+          std::cout << "  " << std::setw (12) << std::left << g_layerNames[i]
+                    << std::setw (10) << std::right << std::fixed << std::setprecision (3) << s
+                    << " s " << std::setw (6) << std::setprecision (1)
+                    << (total > 0 ? 100 * s / total : 0) << " %" << std::endl;
+        }
+    }
+  return 0;
+}
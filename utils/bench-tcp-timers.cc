@@ -0,0 +1,127 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// This program benchmarks the rearming of the retransmission timers of
+// many connections: each ACK rearms the timer of its connection, as
+// simulator events and in a TcpTimerWheel.
+// Sample usage:  ./waf --run 'bench-tcp-timers --connections=10000 --acks=2000000'
+
+#include "ns3/command-line.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/simulator.h"
+#include "ns3/tcp-timer-wheel.h"
+#include <iostream>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * Connections whose ACKs rearm a timer
+ */
+class Connections
+{
+public:
+  /**
+   * \param n the number of connections
+   * \param wheel the timer wheel, or 0 for simulator events
+   */
+  Connections (uint32_t n, Ptr<TcpTimerWheel> wheel);
+
+  /**
+   * \brief Receive ACKs on all the connections, round-robin
+   * \param remaining the number of ACKs left
+   */
+  void Ack (uint32_t remaining);
+
+  /// Called on the expiry of a timer
+  void Expired (void);
+
+  uint32_t m_expired; //!< Number of expiries
+
+private:
+  std::vector<TcpTimer> m_timers; //!< Timers of the connections
+  uint32_t m_next;                //!< Next connection to receive an ACK
+};
+
+Connections::Connections (uint32_t n, Ptr<TcpTimerWheel> wheel)
+  : m_expired (0),
+    m_timers (n),
+    m_next (0)
+{
+  for (uint32_t i = 0; i < n; i++)
+    {
+      m_timers[i].SetWheel (wheel);
+      m_timers[i].SetFunction (MakeCallback (&Connections::Expired, this));
+    }
+}
+
+void
+Connections::Ack (uint32_t remaining)
+{
+  // a burst of ACKs every microsecond
+  for (uint32_t i = 0; i < 100 && remaining > 0; i++, remaining--)
+    {
+      m_timers[m_next].Schedule (MilliSeconds (200));
+      m_next = (m_next + 1) % m_timers.size ();
+    }
+  if (remaining > 0)
+    {
+      Simulator::Schedule (MicroSeconds (1), &Connections::Ack, this, remaining);
+    }
+}
+
+void
+Connections::Expired (void)
+{
+  m_expired++;
+}
+
+/**
+ * Run a benchmark
+ * \param name the name of the benchmark
+ * \param connections the number of connections
+ * \param acks the number of ACKs
+ * \param wheel the timer wheel, or 0 for simulator events
+ */
+static void
+Run (const std::string &name, uint32_t connections, uint32_t acks, Ptr<TcpTimerWheel> wheel)
+{
+  Connections c (connections, wheel);
+  SystemWallClockMs time;
+  time.Start ();
+  Simulator::ScheduleNow (&Connections::Ack, &c, acks);
+  Simulator::Run ();
+  int64_t ms = time.End ();
+  Simulator::Destroy ();
+  std::cout << name << ": " << ms * 1e6 / acks << " ns/ack (" << ms
+            << " ms elapsed, " << c.m_expired << " expiries)" << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t connections = 10000;
+  uint32_t acks = 2000000;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark the rearming of TCP retransmission timers");
+  cmd.AddValue ("connections", "number of connections", connections);
+  cmd.AddValue ("acks", "number of ACKs", acks);
+  cmd.Parse (argc, argv);
+
+  Run ("Simulator events", connections, acks, 0);
+  Run ("Timer wheel", connections, acks, CreateObject<TcpTimerWheel> ());
+  return 0;
+}
@@ -0,0 +1,128 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// This program benchmarks the SACK scoreboard of TcpTxBuffer in a high
+// bandwidth-delay product scenario: a full window of 'window' segments is
+// sent, one segment every 'loss-every' is lost, and the ACKs of the others
+// arrive one by one, each carrying the SACK block a receiver would report.
+// Lost segments are retransmitted as soon as NextSeg reports them.
+// Sample usage:  ./waf --run 'bench-tcp-tx-buffer --window=10000'
+
+#include "ns3/command-line.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/simulator.h"
+#include "ns3/packet.h"
+#include "ns3/tcp-tx-buffer.h"
+#include "ns3/tcp-congestion-ops.h"
+#include <iostream>
+#include <limits>
+#include <algorithm>
+
+using namespace ns3;
+
+/**
+ * Run one loss episode over a full window
+ * \param window number of segments in flight
+ * \param lossEvery one segment every lossEvery is lost
+ * \param segmentSize the segment size
+ * \return the number of retransmitted segments
+ */
+static uint32_t
+RunEpisode (uint32_t window, uint32_t lossEvery, uint32_t segmentSize)
+{
+  Ptr<TcpTxBuffer> txBuf = CreateObject<TcpTxBuffer> (1);
+  txBuf->SetMaxBufferSize (window * segmentSize);
+  txBuf->SetSegmentSize (segmentSize);
+  txBuf->SetDupAckThresh (3);
+  txBuf->Add (Create<Packet> (window * segmentSize));
+
+  for (uint32_t i = 0; i < window; i++)
+    {
+      txBuf->CopyFromSequence (segmentSize, SequenceNumber32 (1 + i * segmentSize));
+    }
+
+  uint32_t retransmitted = 0;
+  SequenceNumber32 runStart (1);
+  for (uint32_t i = 0; i < window; i++)
+    {
+      SequenceNumber32 segStart (1 + i * segmentSize);
+      if (i % lossEvery == 0)
+        {
+          runStart = segStart + segmentSize;
+          continue;
+        }
+
+      // the first block reports the contiguous run the segment belongs to
+      TcpOptionSack::SackList list;
+      list.push_back (TcpOptionSack::SackBlock (runStart, segStart + segmentSize));
+      txBuf->Update (list);
+      txBuf->BytesInFlight ();
+
+      // no rescue retransmissions (rule 3): the window limits them in TCP
+      SequenceNumber32 next;
+      while (txBuf->NextSeg (&next, false))
+        {
+          txBuf->CopyFromSequence (segmentSize, next);
+          retransmitted++;
+        }
+    }
+
+  txBuf->DiscardUpTo (SequenceNumber32 (1 + window * segmentSize));
+  return retransmitted;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t window = 10000;
+  uint32_t lossEvery = 100;
+  uint32_t segmentSize = 1448;
+  uint32_t minIterations = 3;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark the SACK scoreboard of TcpTxBuffer");
+  cmd.AddValue ("window", "number of segments in flight", window);
+  cmd.AddValue ("loss-every", "one segment every loss-every is lost", lossEvery);
+  cmd.AddValue ("segment-size", "segment size in bytes", segmentSize);
+  cmd.AddValue ("min-iterations", "number of iterations to minimize the time over", minIterations);
+  cmd.Parse (argc, argv);
+
+  if (window == 0 || lossEvery < 2 || segmentSize == 0)
+    {
+      std::cerr << "Error-- window and segment-size must be positive, "
+                << "loss-every at least 2" << std::endl;
+      exit (1);
+    }
+
+  std::cout << "Running bench-tcp-tx-buffer with window=" << window
+            << " loss-every=" << lossEvery << std::endl;
+
+  uint64_t minDelay = std::numeric_limits<uint64_t>::max ();
+  uint32_t retransmitted = 0;
+  for (uint32_t i = 0; i < minIterations; i++)
+    {
+      SystemWallClockMs time;
+      time.Start ();
+      retransmitted = RunEpisode (window, lossEvery, segmentSize);
+      minDelay = std::min (minDelay, static_cast<uint64_t> (time.End ()));
+    }
+  Simulator::Destroy ();
+
+  double acks = window - (window + lossEvery - 1) / lossEvery;
+  std::cout << acks * 1000 / std::max<uint64_t> (minDelay, 1) << " acks/s"
+            << " (" << minDelay << " ms elapsed, "
+            << retransmitted << " segments retransmitted)" << std::endl;
+  return 0;
+}